@@ -0,0 +1,855 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#include "MessageLog.h"
+#include "../Simulator/Source/SimMessageTables.h"
+#include <stdlib.h>
+#include <chrono>
+
+static const char kMagic[6] = { 'V', 'X', 'M', 'L', 'O', 'G' };
+static const uint8_t kVersion = 1;
+static const size_t kHeaderSize = 12;
+// Larger than any message, so a length above it means the log is not readable from there on
+static const uint64_t kMaxRecordLength = 16 * 1024 * 1024;
+
+enum RecordKind {
+    recordString = 1,
+    recordRequest = 2,
+    recordResponse = 3,
+    recordEvent = 4
+};
+
+static uint64_t NowMicroseconds()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static FILE *OpenFile(const char *path, const char *mode)
+{
+#ifdef _MSC_VER
+    FILE *file = NULL;
+    return fopen_s(&file, path, mode) == 0 ? file : NULL;
+#else
+    return fopen(path, mode);
+#endif
+}
+
+static void HashText(uint32_t &hash, const char *text)
+{
+    for (; *text; ++text) {
+        hash = (hash ^ (unsigned char)*text) * 16777619u;
+    }
+    hash = (hash ^ 0xff) * 16777619u;
+}
+
+static void HashInt(uint32_t &hash, int value)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%d", value);
+    HashText(hash, text);
+}
+
+// Of the types and fields the log is made of, in order
+static uint32_t TablesFingerprint()
+{
+    uint32_t hash = 2166136261u;
+#define MESSAGELOG_HASH_FIELD(Kind, field) HashText(hash, #Kind); HashText(hash, #field);
+#define MESSAGELOG_HASH_REQUEST(name) HashText(hash, #name); HashInt(hash, req_##name); VX_SIM_REQ_FIELDS_##name(MESSAGELOG_HASH_FIELD)
+#define MESSAGELOG_HASH_RESPONSE(name) HashText(hash, #name); HashInt(hash, resp_##name); VX_SIM_RESP_FIELDS_##name(MESSAGELOG_HASH_FIELD)
+#define MESSAGELOG_HASH_EVENT(name) HashText(hash, #name); HashInt(hash, evt_##name); VX_SIM_EVT_FIELDS_##name(MESSAGELOG_HASH_FIELD)
+    VX_SIM_REQUEST_TYPES(MESSAGELOG_HASH_REQUEST)
+    VX_SIM_RESPONSE_TYPES(MESSAGELOG_HASH_RESPONSE)
+    VX_SIM_EVENT_TYPES(MESSAGELOG_HASH_EVENT)
+#undef MESSAGELOG_HASH_EVENT
+#undef MESSAGELOG_HASH_RESPONSE
+#undef MESSAGELOG_HASH_REQUEST
+#undef MESSAGELOG_HASH_FIELD
+    return hash;
+}
+
+static uint32_t GetTablesFingerprint()
+{
+    static const uint32_t fingerprint = TablesFingerprint();
+    return fingerprint;
+}
+
+static void FreeString(const char *text)
+{
+    free((void *)text);
+}
+
+#define MESSAGELOG_FREE_String(field) FreeString(m->field);
+#define MESSAGELOG_FREE_Int(field)
+#define MESSAGELOG_FREE_Unsigned(field)
+#define MESSAGELOG_FREE_Double(field)
+#define MESSAGELOG_FREE_FIELD(Kind, field) MESSAGELOG_FREE_##Kind(field)
+
+static void DestroyRequest(vx_req_base_t *request)
+{
+    switch (request->type) {
+#define MESSAGELOG_DESTROY_REQUEST(name) \
+        case req_##name: { \
+            vx_req_##name##_t *m = (vx_req_##name##_t *)request; \
+            (void)m; \
+            VX_SIM_REQ_FIELDS_##name(MESSAGELOG_FREE_FIELD) \
+            break; \
+        }
+        VX_SIM_REQUEST_TYPES(MESSAGELOG_DESTROY_REQUEST)
+#undef MESSAGELOG_DESTROY_REQUEST
+        default:
+            break;
+    }
+    FreeString(request->cookie);
+    free(request);
+}
+
+static void DestroyResponse(vx_resp_base_t *response)
+{
+    switch (response->type) {
+#define MESSAGELOG_DESTROY_RESPONSE(name) \
+        case resp_##name: { \
+            vx_resp_##name##_t *m = (vx_resp_##name##_t *)response; \
+            (void)m; \
+            VX_SIM_RESP_FIELDS_##name(MESSAGELOG_FREE_FIELD) \
+            break; \
+        }
+        VX_SIM_RESPONSE_TYPES(MESSAGELOG_DESTROY_RESPONSE)
+#undef MESSAGELOG_DESTROY_RESPONSE
+        default:
+            break;
+    }
+    FreeString(response->status_string);
+    FreeString(response->extended_status_info);
+    if (response->request) {
+        DestroyRequest(response->request);
+    }
+    free(response);
+}
+
+static void DestroyEvent(vx_evt_base_t *event)
+{
+    switch (event->type) {
+#define MESSAGELOG_DESTROY_EVENT(name) \
+        case evt_##name: { \
+            vx_evt_##name##_t *m = (vx_evt_##name##_t *)event; \
+            (void)m; \
+            VX_SIM_EVT_FIELDS_##name(MESSAGELOG_FREE_FIELD) \
+            break; \
+        }
+        VX_SIM_EVENT_TYPES(MESSAGELOG_DESTROY_EVENT)
+#undef MESSAGELOG_DESTROY_EVENT
+        default:
+            break;
+    }
+    FreeString(event->extended_status_info);
+    free(event);
+}
+
+#undef MESSAGELOG_FREE_FIELD
+#undef MESSAGELOG_FREE_Double
+#undef MESSAGELOG_FREE_Unsigned
+#undef MESSAGELOG_FREE_Int
+#undef MESSAGELOG_FREE_String
+
+void MessageLogDestroyMessage(vx_message_base_t *message)
+{
+    if (message == NULL) {
+        return;
+    }
+    switch (message->type) {
+        case msg_request:
+            DestroyRequest((vx_req_base_t *)message);
+            break;
+        case msg_response:
+            DestroyResponse((vx_resp_base_t *)message);
+            break;
+        case msg_event:
+            DestroyEvent((vx_evt_base_t *)message);
+            break;
+        default:
+            free(message);
+            break;
+    }
+}
+
+static vx_message_base_t *NewMessage(size_t size, vx_message_type type)
+{
+    vx_message_base_t *message = (vx_message_base_t *)calloc(1, size);
+    if (message) {
+        message->type = type;
+        message->create_time_ms = NowMicroseconds() / 1000;
+    }
+    return message;
+}
+
+// The lists of messages are not recorded: empty them in a message read back, so that code
+// going through one by its count does not run into the NULL pointer
+static void ClearListCounts(vx_message_base_t *message)
+{
+    if (message->type == msg_response) {
+        vx_resp_base_t *response = (vx_resp_base_t *)message;
+        switch (response->type) {
+            case resp_account_channel_get_acl:
+                ((vx_resp_account_channel_get_acl_t *)response)->participants_size = 0;
+                break;
+            case resp_channel_get_banned_users:
+                ((vx_resp_channel_get_banned_users_t *)response)->banned_users_count = 0;
+                break;
+            case resp_account_list_buddies_and_groups:
+                ((vx_resp_account_list_buddies_and_groups_t *)response)->buddy_count = 0;
+                ((vx_resp_account_list_buddies_and_groups_t *)response)->group_count = 0;
+                break;
+            case resp_account_list_block_rules:
+                ((vx_resp_account_list_block_rules_t *)response)->rule_count = 0;
+                break;
+            case resp_account_list_auto_accept_rules:
+                ((vx_resp_account_list_auto_accept_rules_t *)response)->rule_count = 0;
+                break;
+            case resp_aux_connectivity_info:
+                ((vx_resp_aux_connectivity_info_t *)response)->count = 0;
+                break;
+            case resp_aux_get_render_devices:
+                ((vx_resp_aux_get_render_devices_t *)response)->count = 0;
+                break;
+            case resp_aux_get_capture_devices:
+                ((vx_resp_aux_get_capture_devices_t *)response)->count = 0;
+                break;
+            case resp_account_get_session_fonts:
+                ((vx_resp_account_get_session_fonts_t *)response)->session_font_count = 0;
+                break;
+            case resp_account_get_template_fonts:
+                ((vx_resp_account_get_template_fonts_t *)response)->template_font_count = 0;
+                break;
+            case resp_aux_diagnostic_state_dump:
+                ((vx_resp_aux_diagnostic_state_dump_t *)response)->state_connector_count = 0;
+                break;
+            default:
+                break;
+        }
+    } else if (message->type == msg_event) {
+        vx_evt_base_t *event = (vx_evt_base_t *)message;
+        switch (event->type) {
+            case evt_buddy_and_group_list_changed:
+                ((vx_evt_buddy_and_group_list_changed_t *)event)->buddy_count = 0;
+                ((vx_evt_buddy_and_group_list_changed_t *)event)->group_count = 0;
+                break;
+            case evt_participant_updated:
+                ((vx_evt_participant_updated_t *)event)->diagnostic_state_count = 0;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+MessageLogWriter::MessageLogWriter() :
+    m_open(false),
+    m_file(NULL),
+    m_lastMicroseconds(0),
+    m_records(0),
+    m_bytes(0)
+{
+}
+
+MessageLogWriter::~MessageLogWriter()
+{
+    Close();
+}
+
+bool MessageLogWriter::Open(const char *path, std::string &error)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file) {
+        error = "already recording";
+        return false;
+    }
+    FILE *file = OpenFile(path, "wb");
+    if (file == NULL) {
+        error = std::string("cannot create ") + path;
+        return false;
+    }
+    // Records are small: let the C library batch them into large writes
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    unsigned char header[kHeaderSize];
+    memcpy(header, kMagic, sizeof(kMagic));
+    header[6] = kVersion;
+    header[7] = 0;
+    uint32_t fingerprint = GetTablesFingerprint();
+    for (int i = 0; i < 4; ++i) {
+        header[8 + i] = (unsigned char)(fingerprint >> (8 * i));
+    }
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        fclose(file);
+        error = std::string("cannot write ") + path;
+        return false;
+    }
+    m_file = file;
+    m_strings.clear();
+    m_lastMicroseconds = NowMicroseconds();
+    m_records = 0;
+    m_bytes = sizeof(header);
+    m_open.store(true, std::memory_order_release);
+    return true;
+}
+
+void MessageLogWriter::Close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_open.store(false, std::memory_order_release);
+    if (m_file) {
+        fclose(m_file);
+        m_file = NULL;
+    }
+    m_strings.clear();
+}
+
+uint64_t MessageLogWriter::GetRecordCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_records;
+}
+
+uint64_t MessageLogWriter::GetByteCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+uint64_t MessageLogWriter::NextDelta()
+{
+    uint64_t now = NowMicroseconds();
+    uint64_t delta = now > m_lastMicroseconds ? now - m_lastMicroseconds : 0;
+    m_lastMicroseconds = now;
+    return delta;
+}
+
+void MessageLogWriter::PutVarint(uint64_t value)
+{
+    while (value >= 0x80) {
+        m_body += (char)(value | 0x80);
+        value >>= 7;
+    }
+    m_body += (char)value;
+}
+
+void MessageLogWriter::PutInt(long long value)
+{
+    PutVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void MessageLogWriter::PutUnsigned(unsigned long long value)
+{
+    PutVarint(value);
+}
+
+void MessageLogWriter::PutDouble(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; ++i) {
+        m_body += (char)(bits >> (8 * i));
+    }
+}
+
+void MessageLogWriter::PutString(const char *text)
+{
+    if (text == NULL) {
+        PutVarint(0);
+        return;
+    }
+    size_t length = strlen(text);
+    if (length <= (size_t)kMaxInternedLength) {
+        m_key.assign(text, length);
+        std::unordered_map<std::string, uint32_t>::const_iterator i = m_strings.find(m_key);
+        if (i != m_strings.end()) {
+            PutVarint((uint64_t)i->second + 2);
+            return;
+        }
+        if (m_strings.size() < kMaxInternedStrings) {
+            // The string record goes out ahead of the record being encoded, which uses it
+            uint32_t id = (uint32_t)m_strings.size();
+            m_strings.insert(std::make_pair(m_key, id));
+            std::string record;
+            record.reserve(length + 1);
+            record += (char)recordString;
+            record += m_key;
+            WriteRecord(record);
+            PutVarint((uint64_t)id + 2);
+            return;
+        }
+    }
+    PutVarint(1);
+    PutVarint(length);
+    m_body.append(text, length);
+}
+
+void MessageLogWriter::WriteRecord(const std::string &body)
+{
+    unsigned char prefix[10];
+    size_t prefixLength = 0;
+    uint64_t length = body.size();
+    while (length >= 0x80) {
+        prefix[prefixLength++] = (unsigned char)(length | 0x80);
+        length >>= 7;
+    }
+    prefix[prefixLength++] = (unsigned char)length;
+    fwrite(prefix, 1, prefixLength, m_file);
+    fwrite(body.data(), 1, body.size(), m_file);
+    m_bytes += prefixLength + body.size();
+    ++m_records;
+}
+
+#define MESSAGELOG_PUT_FIELD(Kind, field) Put##Kind(m->field);
+
+void MessageLogWriter::EncodeRequest(const vx_req_base_t *request)
+{
+    PutVarint((uint64_t)request->type);
+    PutString(request->cookie);
+    switch (request->type) {
+#define MESSAGELOG_PUT_REQUEST(name) \
+        case req_##name: { \
+            const vx_req_##name##_t *m = (const vx_req_##name##_t *)request; \
+            (void)m; \
+            VX_SIM_REQ_FIELDS_##name(MESSAGELOG_PUT_FIELD) \
+            break; \
+        }
+        VX_SIM_REQUEST_TYPES(MESSAGELOG_PUT_REQUEST)
+#undef MESSAGELOG_PUT_REQUEST
+        default:
+            break;
+    }
+}
+
+void MessageLogWriter::RecordRequest(const vx_req_base_t *request)
+{
+    if (!IsOpen() || request == NULL) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file == NULL) {
+        return;
+    }
+    m_body.clear();
+    m_body += (char)recordRequest;
+    PutVarint(NextDelta());
+    EncodeRequest(request);
+    WriteRecord(m_body);
+}
+
+void MessageLogWriter::RecordMessage(const vx_message_base_t *message)
+{
+    if (!IsOpen() || message == NULL) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file == NULL) {
+        return;
+    }
+    m_body.clear();
+    if (message->type == msg_response) {
+        const vx_resp_base_t *response = (const vx_resp_base_t *)message;
+        m_body += (char)recordResponse;
+        PutVarint(NextDelta());
+        PutVarint((uint64_t)response->type);
+        PutInt(response->return_code);
+        PutInt(response->status_code);
+        PutString(response->status_string);
+        PutString(response->extended_status_info);
+        m_body += (char)(response->request ? 1 : 0);
+        if (response->request) {
+            EncodeRequest(response->request);
+        }
+        switch (response->type) {
+#define MESSAGELOG_PUT_RESPONSE(name) \
+            case resp_##name: { \
+                const vx_resp_##name##_t *m = (const vx_resp_##name##_t *)response; \
+                (void)m; \
+                VX_SIM_RESP_FIELDS_##name(MESSAGELOG_PUT_FIELD) \
+                break; \
+            }
+            VX_SIM_RESPONSE_TYPES(MESSAGELOG_PUT_RESPONSE)
+#undef MESSAGELOG_PUT_RESPONSE
+            default:
+                break;
+        }
+    } else if (message->type == msg_event) {
+        const vx_evt_base_t *event = (const vx_evt_base_t *)message;
+        m_body += (char)recordEvent;
+        PutVarint(NextDelta());
+        PutVarint((uint64_t)event->type);
+        PutString(event->extended_status_info);
+        switch (event->type) {
+#define MESSAGELOG_PUT_EVENT(name) \
+            case evt_##name: { \
+                const vx_evt_##name##_t *m = (const vx_evt_##name##_t *)event; \
+                (void)m; \
+                VX_SIM_EVT_FIELDS_##name(MESSAGELOG_PUT_FIELD) \
+                break; \
+            }
+            VX_SIM_EVENT_TYPES(MESSAGELOG_PUT_EVENT)
+#undef MESSAGELOG_PUT_EVENT
+            default:
+                break;
+        }
+    } else {
+        return;
+    }
+    WriteRecord(m_body);
+}
+
+#undef MESSAGELOG_PUT_FIELD
+
+MessageLogReader::MessageLogReader() :
+    m_file(NULL),
+    m_position(0),
+    m_microseconds(0),
+    m_skipped(0)
+{
+}
+
+MessageLogReader::~MessageLogReader()
+{
+    Close();
+}
+
+bool MessageLogReader::Open(const char *path, std::string &error)
+{
+    Close();
+    FILE *file = OpenFile(path, "rb");
+    if (file == NULL) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    unsigned char header[kHeaderSize];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+        fclose(file);
+        error = std::string(path) + " is not a message log";
+        return false;
+    }
+    if (header[6] != kVersion) {
+        fclose(file);
+        error = std::string(path) + " is a message log of another version";
+        return false;
+    }
+    uint32_t fingerprint = 0;
+    for (int i = 0; i < 4; ++i) {
+        fingerprint |= (uint32_t)header[8 + i] << (8 * i);
+    }
+    if (fingerprint != GetTablesFingerprint()) {
+        fclose(file);
+        error = std::string(path) + " was recorded with other SDK headers";
+        return false;
+    }
+    m_file = file;
+    m_strings.clear();
+    m_microseconds = 0;
+    m_skipped = 0;
+    m_error.clear();
+    return true;
+}
+
+void MessageLogReader::Close()
+{
+    if (m_file) {
+        fclose(m_file);
+        m_file = NULL;
+    }
+    m_strings.clear();
+    m_record.clear();
+}
+
+bool MessageLogReader::ReadRecord()
+{
+    uint64_t length = 0;
+    for (int shift = 0;; shift += 7) {
+        int c = fgetc(m_file);
+        if (c == EOF) {
+            return false;
+        }
+        if (shift > 56) {
+            m_error = "bad record length";
+            return false;
+        }
+        length |= (uint64_t)(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            break;
+        }
+    }
+    if (length == 0 || length > kMaxRecordLength) {
+        m_error = "bad record length";
+        return false;
+    }
+    m_record.resize((size_t)length);
+    if (fread(&m_record[0], 1, (size_t)length, m_file) != length) {
+        return false;
+    }
+    m_position = 0;
+    return true;
+}
+
+bool MessageLogReader::GetByte(uint8_t &value)
+{
+    if (m_position >= m_record.size()) {
+        return false;
+    }
+    value = (uint8_t)m_record[m_position++];
+    return true;
+}
+
+bool MessageLogReader::GetVarint(uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift <= 63; shift += 7) {
+        uint8_t byte;
+        if (!GetByte(byte)) {
+            return false;
+        }
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MessageLogReader::GetFixed(void *data, size_t size)
+{
+    if (m_record.size() - m_position < size) {
+        return false;
+    }
+    memcpy(data, m_record.data() + m_position, size);
+    m_position += size;
+    return true;
+}
+
+bool MessageLogReader::GetString(char *&text)
+{
+    text = NULL;
+    uint64_t reference;
+    if (!GetVarint(reference)) {
+        return false;
+    }
+    if (reference == 0) {
+        return true;
+    }
+    const char *data;
+    size_t length;
+    if (reference == 1) {
+        uint64_t inlineLength;
+        if (!GetVarint(inlineLength) || m_record.size() - m_position < inlineLength) {
+            return false;
+        }
+        data = m_record.data() + m_position;
+        length = (size_t)inlineLength;
+        m_position += length;
+    } else {
+        if (reference - 2 >= m_strings.size()) {
+            return false;
+        }
+        const std::string &interned = m_strings[(size_t)(reference - 2)];
+        data = interned.data();
+        length = interned.size();
+    }
+    text = (char *)malloc(length + 1);
+    if (text == NULL) {
+        return false;
+    }
+    memcpy(text, data, length);
+    text[length] = 0;
+    return true;
+}
+
+#define MESSAGELOG_READ_FIELD(Kind, field) if (!Read##Kind(m->field)) { return false; }
+
+bool MessageLogReader::DecodeRequest(vx_req_base_t *&request)
+{
+    request = NULL;
+    uint64_t type;
+    if (!GetVarint(type)) {
+        return false;
+    }
+    switch ((vx_request_type)type) {
+#define MESSAGELOG_NEW_REQUEST(name) \
+        case req_##name: \
+            request = (vx_req_base_t *)NewMessage(sizeof(vx_req_##name##_t), msg_request); \
+            break;
+        VX_SIM_REQUEST_TYPES(MESSAGELOG_NEW_REQUEST)
+#undef MESSAGELOG_NEW_REQUEST
+        default:
+            return false;
+    }
+    if (request == NULL) {
+        return false;
+    }
+    request->type = (vx_request_type)type;
+    if (!ReadString(request->cookie)) {
+        return false;
+    }
+    switch (request->type) {
+#define MESSAGELOG_READ_REQUEST(name) \
+        case req_##name: { \
+            vx_req_##name##_t *m = (vx_req_##name##_t *)request; \
+            (void)m; \
+            VX_SIM_REQ_FIELDS_##name(MESSAGELOG_READ_FIELD) \
+            break; \
+        }
+        VX_SIM_REQUEST_TYPES(MESSAGELOG_READ_REQUEST)
+#undef MESSAGELOG_READ_REQUEST
+        default:
+            break;
+    }
+    return true;
+}
+
+bool MessageLogReader::DecodeResponse(vx_resp_base_t *&response)
+{
+    response = NULL;
+    uint64_t type;
+    if (!GetVarint(type)) {
+        return false;
+    }
+    switch ((vx_response_type)type) {
+#define MESSAGELOG_NEW_RESPONSE(name) \
+        case resp_##name: \
+            response = (vx_resp_base_t *)NewMessage(sizeof(vx_resp_##name##_t), msg_response); \
+            break;
+        VX_SIM_RESPONSE_TYPES(MESSAGELOG_NEW_RESPONSE)
+#undef MESSAGELOG_NEW_RESPONSE
+        default:
+            return false;
+    }
+    if (response == NULL) {
+        return false;
+    }
+    response->type = (vx_response_type)type;
+    uint8_t hasRequest;
+    if (!ReadInt(response->return_code) || !ReadInt(response->status_code) ||
+        !ReadString(response->status_string) || !ReadString(response->extended_status_info) ||
+        !GetByte(hasRequest))
+    {
+        return false;
+    }
+    if (hasRequest && !DecodeRequest(response->request)) {
+        return false;
+    }
+    switch (response->type) {
+#define MESSAGELOG_READ_RESPONSE(name) \
+        case resp_##name: { \
+            vx_resp_##name##_t *m = (vx_resp_##name##_t *)response; \
+            (void)m; \
+            VX_SIM_RESP_FIELDS_##name(MESSAGELOG_READ_FIELD) \
+            break; \
+        }
+        VX_SIM_RESPONSE_TYPES(MESSAGELOG_READ_RESPONSE)
+#undef MESSAGELOG_READ_RESPONSE
+        default:
+            break;
+    }
+    return true;
+}
+
+bool MessageLogReader::DecodeEvent(vx_evt_base_t *&event)
+{
+    event = NULL;
+    uint64_t type;
+    if (!GetVarint(type)) {
+        return false;
+    }
+    switch ((vx_event_type)type) {
+#define MESSAGELOG_NEW_EVENT(name) \
+        case evt_##name: \
+            event = (vx_evt_base_t *)NewMessage(sizeof(vx_evt_##name##_t), msg_event); \
+            break;
+        VX_SIM_EVENT_TYPES(MESSAGELOG_NEW_EVENT)
+#undef MESSAGELOG_NEW_EVENT
+        default:
+            return false;
+    }
+    if (event == NULL) {
+        return false;
+    }
+    event->type = (vx_event_type)type;
+    if (!ReadString(event->extended_status_info)) {
+        return false;
+    }
+    switch (event->type) {
+#define MESSAGELOG_READ_EVENT(name) \
+        case evt_##name: { \
+            vx_evt_##name##_t *m = (vx_evt_##name##_t *)event; \
+            (void)m; \
+            VX_SIM_EVT_FIELDS_##name(MESSAGELOG_READ_FIELD) \
+            break; \
+        }
+        VX_SIM_EVENT_TYPES(MESSAGELOG_READ_EVENT)
+#undef MESSAGELOG_READ_EVENT
+        default:
+            break;
+    }
+    return true;
+}
+
+#undef MESSAGELOG_READ_FIELD
+
+bool MessageLogReader::Next(Record &record)
+{
+    if (m_file == NULL || !m_error.empty()) {
+        return false;
+    }
+    while (ReadRecord()) {
+        uint8_t kind;
+        if (!GetByte(kind)) {
+            // An empty record
+            ++m_skipped;
+            continue;
+        }
+        if (kind == recordString) {
+            m_strings.push_back(m_record.substr(1));
+            continue;
+        }
+        uint64_t delta;
+        if (kind < recordRequest || kind > recordEvent || !GetVarint(delta)) {
+            ++m_skipped;
+            continue;
+        }
+        m_microseconds += delta;
+        vx_message_base_t *message = NULL;
+        bool decoded;
+        if (kind == recordRequest) {
+            vx_req_base_t *request;
+            decoded = DecodeRequest(request);
+            message = (vx_message_base_t *)request;
+        } else if (kind == recordResponse) {
+            vx_resp_base_t *response;
+            decoded = DecodeResponse(response);
+            message = (vx_message_base_t *)response;
+        } else {
+            vx_evt_base_t *event;
+            decoded = DecodeEvent(event);
+            message = (vx_message_base_t *)event;
+        }
+        if (!decoded) {
+            // A type this build does not know, or a record cut short
+            MessageLogDestroyMessage(message);
+            ++m_skipped;
+            continue;
+        }
+        ClearListCounts(message);
+        record.kind = kind == recordRequest ? Record::kindRequest : Record::kindMessage;
+        record.milliseconds = m_microseconds / 1000.0;
+        record.message = message;
+        return true;
+    }
+    return false;
+}
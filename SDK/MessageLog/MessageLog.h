@@ -0,0 +1,206 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+// Recording of the requests an application issues and the messages it gets from
+// vx_get_message(), and reading them back as messages to dispatch again, so that traffic
+// seen in production can be replayed offline through SimpleAPI or SDKSampleApp.
+//
+// The log is binary and compact, several times smaller and faster to write than the XML
+// of vx_request_to_xml() and vx_response_to_xml():
+//
+//  log       := "VXMLOG" version:u8 0:u8 fingerprint:u32 record*
+//  record    := length:varint kind:u8 body          length counts kind and body
+//  string    := kind 1, body is the text            the next string id, from 0
+//  request   := kind 2, delta:varint request
+//  response  := kind 3, delta:varint type:varint return_code:int status_code:int
+//               status_string:str extended_status_info:str has_request:u8 [request] fields
+//  event     := kind 4, delta:varint type:varint extended_status_info:str fields
+//  request   := type:varint cookie:str fields
+//  str       := varint, 0 for NULL, 1 followed by length:varint and the text, or the id
+//               of a string record plus 2
+//
+// delta is the microseconds of a steady clock since the previous request or message. The
+// fields are the string and number fields of the message struct, in the order of
+// SDK/Simulator/Source/SimMessageTables.h: int is a zigzag varint, unsigned a varint and
+// double 8 bytes, all little endian. Strings up to kMaxInternedLength bytes are written
+// once and referred to by id after that, which covers the handles, URIs and names most
+// messages are made of. Lists and other pointers in messages, fixed size arrays such as 3D
+// positions, and vcookie are not recorded: messages read back have empty lists. The
+// fingerprint is a hash of those tables: a log only reads back with the same SDK headers it
+// was recorded with.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Vxc.h"
+#include "VxcRequests.h"
+#include "VxcResponses.h"
+#include "VxcEvents.h"
+
+// Destroys a message read by MessageLogReader, and the request of a response. Messages
+// read back are not the SDK's: never pass them to vx_destroy_message().
+void MessageLogDestroyMessage(vx_message_base_t *message);
+
+// Appends requests and messages to a log. All its functions can be called from any thread.
+class MessageLogWriter {
+public:
+    enum {
+        kMaxInternedLength = 256,
+        kMaxInternedStrings = 1 << 16
+    };
+
+    MessageLogWriter();
+    ~MessageLogWriter();
+
+    // Creates the file, replacing it. Returns false with error set if it cannot.
+    bool Open(const char *path, std::string &error);
+    void Close();
+    bool IsOpen() const { return m_open.load(std::memory_order_acquire); }
+
+    // Records a request before it is issued, as vx_issue_request3() may destroy it.
+    void RecordRequest(const vx_req_base_t *request);
+    // Records a response or an event, as vx_get_message() returned it.
+    void RecordMessage(const vx_message_base_t *message);
+
+    uint64_t GetRecordCount() const;
+    uint64_t GetByteCount() const;
+
+private:
+    MessageLogWriter(const MessageLogWriter &); // disabled
+
+    // m_mutex must be held
+    uint64_t NextDelta();
+    void EncodeRequest(const vx_req_base_t *request);
+    void PutString(const char *text);
+    void PutVarint(uint64_t value);
+    void PutInt(long long value);
+    void PutUnsigned(unsigned long long value);
+    void PutDouble(double value);
+    void WriteRecord(const std::string &body);
+
+    mutable std::mutex m_mutex;
+    std::atomic<bool> m_open;
+    FILE *m_file;
+    std::string m_body;         // the record being encoded
+    std::string m_record;       // the length prefix
+    std::string m_key;
+    std::unordered_map<std::string, uint32_t> m_strings;
+    uint64_t m_lastMicroseconds;
+    uint64_t m_records;
+    uint64_t m_bytes;
+};
+
+// Reads a log back, one request or message at a time.
+class MessageLogReader {
+public:
+    struct Record {
+        enum Kind {
+            kindRequest,
+            kindMessage
+        };
+        Kind kind;
+        // Since the first record
+        double milliseconds;
+        // A request for kindRequest, else a response or event. The caller owns it and
+        // destroys it with MessageLogDestroyMessage().
+        vx_message_base_t *message;
+    };
+
+    MessageLogReader();
+    ~MessageLogReader();
+
+    bool Open(const char *path, std::string &error);
+    void Close();
+
+    // Reads the next request or message. Records of types this build does not know are
+    // skipped. Returns false at the end of the log, or with GetError() set if it is not
+    // readable from there on; a log cut short by a crash reads up to its last whole record.
+    bool Next(Record &record);
+
+    const std::string &GetError() const { return m_error; }
+    uint64_t GetSkippedCount() const { return m_skipped; }
+
+private:
+    MessageLogReader(const MessageLogReader &); // disabled
+
+    bool ReadRecord();
+    bool GetByte(uint8_t &value);
+    bool GetVarint(uint64_t &value);
+    bool GetString(char *&text);
+    bool GetFixed(void *data, size_t size);
+    bool DecodeRequest(vx_req_base_t *&request);
+    bool DecodeResponse(vx_resp_base_t *&response);
+    bool DecodeEvent(vx_evt_base_t *&event);
+
+    template <class T> bool ReadInt(T &field)
+    {
+        uint64_t value;
+        if (!GetVarint(value)) {
+            return false;
+        }
+        field = (T)(long long)((value >> 1) ^ (~(value & 1) + 1));
+        return true;
+    }
+
+    template <class T> bool ReadUnsigned(T &field)
+    {
+        uint64_t value;
+        if (!GetVarint(value)) {
+            return false;
+        }
+        field = (T)value;
+        return true;
+    }
+
+    template <class T> bool ReadDouble(T &field)
+    {
+        unsigned char bytes[8];
+        if (!GetFixed(bytes, sizeof(bytes))) {
+            return false;
+        }
+        uint64_t bits = 0;
+        for (int i = 7; i >= 0; --i) {
+            bits = (bits << 8) | bytes[i];
+        }
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        field = (T)value;
+        return true;
+    }
+
+    template <class T> bool ReadString(T &field)
+    {
+        char *text;
+        if (!GetString(text)) {
+            return false;
+        }
+        field = text;
+        return true;
+    }
+
+    FILE *m_file;
+    std::string m_record;
+    size_t m_position;
+    std::vector<std::string> m_strings;
+    uint64_t m_microseconds;
+    uint64_t m_skipped;
+    std::string m_error;
+};
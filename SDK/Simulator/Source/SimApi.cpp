@@ -0,0 +1,553 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+// The functions of Vxc.h besides the messages: initializing, issuing requests and getting
+// messages, memory, time, and the settings and helpers applications call.
+
+#include "SimBackend.h"
+#include "SimMemory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+static SimBackend s_backend;
+static std::mutex s_mutex;              // initializing and settings
+static vx_sim_config_t s_settings;
+static bool s_settingsSet = false;
+static std::mutex s_idMutex;
+static std::mt19937 s_idRandom;         // for random user ids and channel URIs
+static std::atomic<int> s_vivoxAecEnabled(1);
+static std::atomic<int> s_agcEnabled(1);
+static std::atomic<int> s_rtpInboundEnabled(1);
+static std::atomic<int> s_rtpOutboundEnabled(1);
+static std::atomic<int> s_crashDumpGeneration(0);
+
+extern "C" {
+// Not declared in the SDK headers, SDKSampleApp declares them itself
+VIVOXSDK_DLLEXPORT int vx_set_rtp_enabled(int inbound, int outbound);
+VIVOXSDK_DLLEXPORT int vx_get_rtp_enabled_inbound(void);
+VIVOXSDK_DLLEXPORT int vx_get_rtp_enabled_outbound(void);
+}
+
+// Settings
+
+int vx_sim_get_default_config(vx_sim_config_t *config)
+{
+    if (!config) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    memset(config, 0, sizeof(*config));
+    config->seed = 1;
+    config->response_latency_min_ms = 20;
+    config->response_latency_max_ms = 50;
+    config->request_failure_rate = 0;
+    config->initial_remote_participants = 2;
+    config->max_remote_participants = 8;
+    config->participant_joins_per_second = 1.0 / 60;
+    config->participant_stay_seconds = 120;
+    config->speaking_changes_per_second = 0.2;
+    config->audio_frame_ms = 20;
+    return 0;
+}
+
+static bool IsValid(const vx_sim_config_t &config)
+{
+    return config.response_latency_min_ms <= config.response_latency_max_ms &&
+        config.request_failure_rate >= 0 && config.request_failure_rate <= 1 &&
+        config.participant_joins_per_second >= 0 && config.participant_stay_seconds >= 0 &&
+        config.speaking_changes_per_second >= 0 && config.audio_frame_ms <= 1000;
+}
+
+int vx_sim_configure(const vx_sim_config_t *config)
+{
+    if (!config || !IsValid(*config)) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_settings = *config;
+    s_settingsSet = true;
+    return 0;
+}
+
+static void ReadEnvironment(const char *name, unsigned int &value)
+{
+    const char *text = getenv(name);
+    if (text && *text) {
+        value = (unsigned int)strtoul(text, NULL, 10);
+    }
+}
+
+static void ReadEnvironment(const char *name, double &value)
+{
+    const char *text = getenv(name);
+    if (text && *text) {
+        value = strtod(text, NULL);
+    }
+}
+
+static vx_sim_config_t GetSettings()
+{
+    vx_sim_config_t settings;
+    if (s_settingsSet) {
+        settings = s_settings;
+    } else {
+        vx_sim_get_default_config(&settings);
+    }
+    vx_sim_config_t fromEnvironment = settings;
+    ReadEnvironment("VX_SIM_SEED", fromEnvironment.seed);
+    ReadEnvironment("VX_SIM_RESPONSE_LATENCY_MIN_MS", fromEnvironment.response_latency_min_ms);
+    ReadEnvironment("VX_SIM_RESPONSE_LATENCY_MAX_MS", fromEnvironment.response_latency_max_ms);
+    ReadEnvironment("VX_SIM_REQUEST_FAILURE_RATE", fromEnvironment.request_failure_rate);
+    ReadEnvironment("VX_SIM_INITIAL_REMOTE_PARTICIPANTS", fromEnvironment.initial_remote_participants);
+    ReadEnvironment("VX_SIM_MAX_REMOTE_PARTICIPANTS", fromEnvironment.max_remote_participants);
+    ReadEnvironment("VX_SIM_PARTICIPANT_JOINS_PER_SECOND", fromEnvironment.participant_joins_per_second);
+    ReadEnvironment("VX_SIM_PARTICIPANT_STAY_SECONDS", fromEnvironment.participant_stay_seconds);
+    ReadEnvironment("VX_SIM_SPEAKING_CHANGES_PER_SECOND", fromEnvironment.speaking_changes_per_second);
+    ReadEnvironment("VX_SIM_AUDIO_FRAME_MS", fromEnvironment.audio_frame_ms);
+    if (IsValid(fromEnvironment)) {
+        settings = fromEnvironment;
+    } else {
+        fprintf(stderr, "vivoxsdk simulator: ignoring the VX_SIM_* environment variables, they are out of range\n");
+    }
+    return settings;
+}
+
+// Initializing
+
+int vx_get_default_config3(vx_sdk_config_t *config, size_t config_size)
+{
+    if (!config || config_size > sizeof(vx_sdk_config_t)) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    vx_sdk_config_t defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    defaults.num_codec_threads = 1;
+    defaults.num_voice_threads = 1;
+    defaults.num_web_threads = 1;
+    defaults.render_source_queue_depth_max = 8;
+    defaults.render_source_initial_buffer_count = 4;
+    defaults.upstream_jitter_frame_count = 1;
+    defaults.max_logins_per_user = 1;
+    defaults.initial_log_level = log_error;
+    defaults.default_codecs_mask = VIVOX_VANI_OPUS40;
+    defaults.mic_makeup_gain = 1.0f;
+    memcpy(config, &defaults, config_size);
+    return 0;
+}
+
+int vx_initialize3(vx_sdk_config_t *config, size_t config_size)
+{
+    vx_sdk_config_t full;
+    vx_get_default_config3(&full, sizeof(full));
+    if (config) {
+        if (config_size > sizeof(vx_sdk_config_t)) {
+            return VX_E_INVALID_ARGUMENT;
+        }
+        memcpy(&full, config, config_size);
+    }
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_backend.IsRunning()) {
+        return VX_E_ALREADY_INITIALIZED;
+    }
+    vx_sim_config_t settings = GetSettings();
+    SimMemory::SetAllocator(full.pf_malloc_func, full.pf_free_func);
+    {
+        std::lock_guard<std::mutex> idLock(s_idMutex);
+        s_idRandom.seed(settings.seed);
+    }
+    s_backend.Start(full, settings);
+    return 0;
+}
+
+int vx_initialize(void)
+{
+    return vx_initialize3(NULL, 0);
+}
+
+int vx_is_initialized(void)
+{
+    return s_backend.IsRunning() ? 1 : 0;
+}
+
+int vx_uninitialize(void)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_backend.IsRunning()) {
+        return VX_E_NOT_INITIALIZED;
+    }
+    s_backend.Stop();
+    return 0;
+}
+
+int vx_on_application_exit(void)
+{
+    return 0;
+}
+
+// Requests and messages
+
+int vx_issue_request3(vx_req_base_t *request, int *request_count)
+{
+    return s_backend.IssueRequest(request, request_count);
+}
+
+int vx_issue_request2(vx_req_base_t *request)
+{
+    return s_backend.IssueRequest(request, NULL);
+}
+
+int vx_issue_request(vx_req_base_t *request)
+{
+    if (!s_backend.IsRunning()) {
+        vx_initialize();
+    }
+    return s_backend.IssueRequest(request, NULL);
+}
+
+int vx_get_message(vx_message_base_t **message)
+{
+    return s_backend.GetMessage(message);
+}
+
+// Memory
+
+char *vx_strdup(const char *s)
+{
+    return SimMemory::Strdup(s);
+}
+
+int vx_free(char *s)
+{
+    return SimMemory::Free(s) ? 0 : VX_E_INVALID_ARGUMENT;
+}
+
+int vx_cookie_create(const char *value, VX_COOKIE *cookie)
+{
+    if (!cookie) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    *cookie = SimMemory::Strdup(value ? value : "");
+    return *cookie ? 0 : VX_E_FAILED;
+}
+
+int vx_cookie_free(VX_COOKIE *cookie)
+{
+    if (!cookie) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    SimMemory::Free(*cookie);
+    *cookie = NULL;
+    return 0;
+}
+
+void *vx_allocate(size_t nBytes)
+{
+    return SimMemory::Allocate(nBytes, SimMemory::kindData);
+}
+
+void *vx_calloc(size_t num, size_t bytesPerElement)
+{
+    if (bytesPerElement != 0 && num > (size_t)-1 / bytesPerElement) {
+        return NULL;
+    }
+    return SimMemory::Allocate(num * bytesPerElement, SimMemory::kindData);
+}
+
+void *vx_reallocate(void *p, size_t nBytes)
+{
+    return SimMemory::Reallocate(p, nBytes);
+}
+
+int vx_unallocate(void *p)
+{
+    return SimMemory::Free(p) ? 0 : VX_E_INVALID_ARGUMENT;
+}
+
+void *vx_allocate_aligned(size_t alignment, size_t size)
+{
+    return SimMemory::AllocateAligned(alignment, size);
+}
+
+int vx_unallocate_aligned(void *p)
+{
+    return SimMemory::Free(p) ? 0 : VX_E_INVALID_ARGUMENT;
+}
+
+// Time
+
+unsigned long long vx_get_time_ms(void)
+{
+    return SimTimeMilliseconds();
+}
+
+unsigned long long vx_get_time_milli_seconds(void)
+{
+    return SimTimeMilliseconds();
+}
+
+unsigned long long vx_get_time_micro_seconds(void)
+{
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+long long vx_sleep_milli_seconds(unsigned long long milli_seconds)
+{
+    unsigned long long start = SimTimeMilliseconds();
+    std::this_thread::sleep_for(std::chrono::milliseconds(milli_seconds));
+    return (long long)(SimTimeMilliseconds() - start);
+}
+
+// Versions, tokens and ids
+
+const char *vx_get_sdk_version_info(void)
+{
+    return "simulator";
+}
+
+const char *vx_get_sdk_version_info_ex(void)
+{
+    return "vivoxsdk simulator";
+}
+
+char *vx_debug_generate_token(const char *issuer, vx_time_t expiration, const char *vxa, unsigned long long serial, const char *subject, const char *from_uri, const char *to_uri, const unsigned char *key, size_t key_len)
+{
+    (void)key;
+    (void)key_len;
+    // Not a signed token, the simulator accepts any
+    std::string token = "sim.";
+    token += issuer ? issuer : "";
+    token += "." + std::to_string((long long)expiration) + ".";
+    token += vxa ? vxa : "";
+    token += "." + std::to_string(serial) + ".";
+    token += subject ? subject : "";
+    token += ".";
+    token += from_uri ? from_uri : "";
+    token += ".";
+    token += to_uri ? to_uri : "";
+    return SimMemory::Strdup(token.c_str());
+}
+
+int vx_is_access_token_well_formed(const char *access_token, char **error)
+{
+    if (error) {
+        *error = NULL;
+    }
+    return access_token && *access_token ? 1 : 0;
+}
+
+static std::string RandomSuffix()
+{
+    std::lock_guard<std::mutex> lock(s_idMutex);
+    char text[16];
+    snprintf(text, sizeof(text), "%08x", (unsigned int)s_idRandom());
+    return text;
+}
+
+char *vx_get_random_user_id_ex(const char *prefix, const char *issuer)
+{
+    std::string id = ".";
+    id += issuer ? issuer : "";
+    id += ".";
+    id += prefix ? prefix : "";
+    id += RandomSuffix() + ".";
+    return SimMemory::Strdup(id.c_str());
+}
+
+char *vx_get_random_user_id(const char *prefix)
+{
+    std::string id = prefix ? prefix : "";
+    id += RandomSuffix();
+    return SimMemory::Strdup(id.c_str());
+}
+
+char *vx_get_random_channel_uri_ex(const char *prefix, const char *realm, const char *issuer)
+{
+    std::string uri = "sip:confctl-g-";
+    uri += issuer ? issuer : "";
+    uri += ".";
+    uri += prefix ? prefix : "";
+    uri += RandomSuffix() + "@";
+    uri += realm ? realm : "vivox.com";
+    return SimMemory::Strdup(uri.c_str());
+}
+
+char *vx_get_random_channel_uri(const char *prefix, const char *realm)
+{
+    std::string uri = "sip:confctl-";
+    uri += prefix ? prefix : "";
+    uri += RandomSuffix() + "@";
+    uri += realm ? realm : "vivox.com";
+    return SimMemory::Strdup(uri.c_str());
+}
+
+// Audio and codec settings, kept but without effect
+
+unsigned int vx_get_available_codecs_mask(void)
+{
+    return VIVOX_VANI_PCMU | VIVOX_VANI_OPUS_MASK;
+}
+
+unsigned int vx_get_default_codecs_mask(void)
+{
+    return VIVOX_VANI_OPUS40;
+}
+
+int vx_set_vivox_aec_enabled(int enabled)
+{
+    s_vivoxAecEnabled = enabled ? 1 : 0;
+    return 0;
+}
+
+int vx_get_vivox_aec_enabled(int *enabled)
+{
+    if (!enabled) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    *enabled = s_vivoxAecEnabled;
+    return 0;
+}
+
+int vx_set_agc_enabled(int enabled)
+{
+    s_agcEnabled = enabled ? 1 : 0;
+    return 0;
+}
+
+int vx_get_agc_enabled(int *enabled)
+{
+    if (!enabled) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    *enabled = s_agcEnabled;
+    return 0;
+}
+
+int vx_set_rtp_enabled(int inbound, int outbound)
+{
+    s_rtpInboundEnabled = inbound ? 1 : 0;
+    s_rtpOutboundEnabled = outbound ? 1 : 0;
+    return 0;
+}
+
+int vx_get_rtp_enabled_inbound(void)
+{
+    return s_rtpInboundEnabled;
+}
+
+int vx_get_rtp_enabled_outbound(void)
+{
+    return s_rtpOutboundEnabled;
+}
+
+// Diagnostics
+
+int vx_crash_test(vx_crash_test_type_t crash_type)
+{
+    (void)crash_type;
+    return VX_E_NOT_IMPL;
+}
+
+int vx_get_system_stats(vx_system_stats_t *system_stats)
+{
+    if (!system_stats) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    memset(system_stats, 0, sizeof(*system_stats));
+    system_stats->ss_size = (int)sizeof(*system_stats);
+    return 0;
+}
+
+int vx_get_crash_dump_count(void)
+{
+    return 0;
+}
+
+int vx_set_crash_dump_generation_enabled(int value)
+{
+    s_crashDumpGeneration = value ? 1 : 0;
+    return 0;
+}
+
+int vx_get_crash_dump_generation(void)
+{
+    return s_crashDumpGeneration;
+}
+
+// Text-to-speech is not simulated
+
+vx_tts_status vx_tts_initialize(vx_tts_engine_type engine_type, vx_tts_manager_id *tts_manager_id)
+{
+    (void)engine_type;
+    if (tts_manager_id) {
+        *tts_manager_id = 0;
+    }
+    return tts_error_not_supported;
+}
+
+vx_tts_status vx_tts_shutdown(vx_tts_manager_id *tts_manager_id)
+{
+    (void)tts_manager_id;
+    return tts_error_not_supported;
+}
+
+vx_tts_status vx_tts_get_voices(vx_tts_manager_id tts_manager_id, int *num_voices, vx_tts_voice_t **voices)
+{
+    (void)tts_manager_id;
+    if (num_voices) {
+        *num_voices = 0;
+    }
+    if (voices) {
+        *voices = NULL;
+    }
+    return tts_error_not_supported;
+}
+
+vx_tts_status vx_tts_speak(vx_tts_manager_id tts_manager_id, vx_tts_voice_id voice_id, const char *input_text, vx_tts_destination tts_dest, vx_tts_utterance_id *utterance_id)
+{
+    (void)tts_manager_id;
+    (void)voice_id;
+    (void)input_text;
+    (void)tts_dest;
+    if (utterance_id) {
+        *utterance_id = 0;
+    }
+    return tts_error_not_supported;
+}
+
+vx_tts_status vx_tts_cancel_utterance(vx_tts_manager_id tts_manager_id, vx_tts_utterance_id utterance_id)
+{
+    (void)tts_manager_id;
+    (void)utterance_id;
+    return tts_error_not_supported;
+}
+
+vx_tts_status vx_tts_cancel_all_in_dest(vx_tts_manager_id tts_manager_id, vx_tts_destination tts_dest)
+{
+    (void)tts_manager_id;
+    (void)tts_dest;
+    return tts_error_not_supported;
+}
+
+vx_tts_status vx_tts_cancel_all(vx_tts_manager_id tts_manager_id)
+{
+    (void)tts_manager_id;
+    return tts_error_not_supported;
+}
@@ -0,0 +1,1158 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "SimBackend.h"
+#include <math.h>
+#include <string.h>
+
+static const int c_audioSampleRate = 48000;
+static const double c_voiceFrequency = 440.0;
+static const short c_voiceAmplitude = 3000;
+// Audio ticks late by more than this many frames are skipped rather than caught up
+static const uint64_t c_maxLateFrames = 5;
+
+static const char *NonEmpty(const char *s)
+{
+    return s && *s ? s : NULL;
+}
+
+// The realm of a URI, or of the account management server for a connector
+static std::string RealmOf(const std::string &uriOrServer)
+{
+    size_t at = uriOrServer.rfind('@');
+    if (at != std::string::npos) {
+        return uriOrServer.substr(at + 1);
+    }
+    size_t scheme = uriOrServer.find("://");
+    if (scheme != std::string::npos) {
+        std::string host = uriOrServer.substr(scheme + 3);
+        host = host.substr(0, host.find_first_of(":/"));
+        size_t www = host.find(".www.");
+        if (www != std::string::npos) {
+            host.erase(www, 4); // mt1s.www.vivox.com is realm mt1s.vivox.com
+        }
+        if (!host.empty()) {
+            return host;
+        }
+    }
+    return "vivox.com";
+}
+
+// FNV-1a, the same everywhere unlike std::hash
+static uint32_t Hash(const std::string &s)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < s.size(); ++i) {
+        hash = (hash ^ (unsigned char)s[i]) * 16777619u;
+    }
+    return hash;
+}
+
+SimBackend::SimBackend() :
+    m_nextSequence(0),
+    m_nextHandle(0),
+    m_nextId(0),
+    m_stopRequested(false),
+    m_running(false)
+{
+    memset(&m_config, 0, sizeof(m_config));
+    memset(&m_settings, 0, sizeof(m_settings));
+}
+
+SimBackend::~SimBackend()
+{
+    Stop();
+}
+
+void SimBackend::Start(const vx_sdk_config_t &config, const vx_sim_config_t &settings)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_config = config;
+    m_settings = settings;
+    m_start = std::chrono::steady_clock::now();
+    m_random.seed(settings.seed);
+    m_nextSequence = 0;
+    m_nextHandle = 0;
+    m_nextId = 0;
+    m_stopRequested = false;
+    m_running = true;
+    m_simulatorThread = std::thread(&SimBackend::SimulatorThread, this);
+    bool audioCallbacks = config.pf_on_audio_unit_after_capture_audio_read || config.pf_on_audio_unit_before_capture_audio_sent ||
+        config.pf_on_audio_unit_before_recv_audio_mixed || config.pf_on_audio_unit_before_recv_audio_rendered ||
+        config.pf_on_before_udp_frame_transmitted || config.pf_on_after_udp_frame_transmitted;
+    if (settings.audio_frame_ms != 0 && audioCallbacks) {
+        m_audioThread = std::thread(&SimBackend::AudioThread, this);
+    }
+}
+
+void SimBackend::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_stopRequested = true;
+    }
+    m_condition.notify_all();
+    m_audioCondition.notify_all();
+    m_simulatorThread.join();
+    if (m_audioThread.joinable()) {
+        m_audioThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto i = m_requests.begin(); i != m_requests.end(); ++i) {
+        SimFreeMessage(&(*i)->message);
+    }
+    m_requests.clear();
+    while (!m_timeline.empty()) {
+        m_timeline.pop();
+    }
+    m_connectors.clear();
+    m_accounts.clear();
+    m_sessionGroups.clear();
+    m_sessions.clear();
+    m_channels.clear();
+    {
+        std::lock_guard<std::mutex> messagesLock(m_messagesMutex);
+        for (auto i = m_messages.begin(); i != m_messages.end(); ++i) {
+            SimFreeMessage(*i);
+        }
+        m_messages.clear();
+    }
+    m_running = false;
+}
+
+bool SimBackend::IsRunning() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running && !m_stopRequested;
+}
+
+int SimBackend::IssueRequest(vx_req_base_t *request, int *outstanding)
+{
+    if (!request || !SimMemory::IsRegistered(request) || request->message.type != msg_request) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running || m_stopRequested) {
+        return VX_E_NOT_INITIALIZED;
+    }
+    if (m_requests.count(request) != 0) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    // Always three draws, so what one request draws does not depend on its type
+    double latency = LatencyMilliseconds();
+    double connect = LatencyMilliseconds();
+    bool fail = Uniform(m_random) < m_settings.request_failure_rate;
+    m_requests.insert(request);
+    if (outstanding) {
+        *outstanding = (int)m_requests.size();
+    }
+    Schedule(NowMilliseconds() + latency, [this, request, fail, connect] { Handle(request, fail, connect); });
+    return 0;
+}
+
+int SimBackend::GetMessage(vx_message_base_t **message)
+{
+    if (!message) {
+        return VX_GET_MESSAGE_FAILURE;
+    }
+    std::lock_guard<std::mutex> lock(m_messagesMutex);
+    if (m_messages.empty()) {
+        *message = NULL;
+        return VX_GET_MESSAGE_NO_MESSAGE;
+    }
+    *message = m_messages.front();
+    m_messages.pop_front();
+    return VX_GET_MESSAGE_AVAILABLE;
+}
+
+// Requests
+
+void SimBackend::Handle(vx_req_base_t *request, bool fail, double connectMilliseconds)
+{
+    m_requests.erase(request);
+    if (request->type == req_session_set_3d_position &&
+        ((vx_req_session_set_3d_position_t *)request)->req_disposition_type == req_disposition_no_reply_required) {
+        SimFreeMessage(&request->message);
+        return;
+    }
+    vx_resp_base_t *response = SimNewResponse(request);
+    if (!response) {
+        SimFreeMessage(&request->message);
+        return;
+    }
+    // Posted first, so it comes before the events of the request; filled in before it is published
+    Post(response);
+
+    int status = VX_E_FAILED;
+    if (!fail) {
+        switch (request->type) {
+            case req_connector_create:
+                status = HandleConnectorCreate((vx_req_connector_create_t *)request, (vx_resp_connector_create_t *)response);
+                break;
+            case req_connector_initiate_shutdown:
+                status = HandleConnectorShutdown((vx_req_connector_initiate_shutdown_t *)request);
+                break;
+            case req_account_login:
+            case req_account_anonymous_login:
+            case req_account_authtoken_login:
+                status = HandleLogin(request, response);
+                break;
+            case req_account_logout:
+                status = HandleLogout((vx_req_account_logout_t *)request);
+                break;
+            case req_sessiongroup_create:
+                status = HandleSessionGroupCreate((vx_req_sessiongroup_create_t *)request, (vx_resp_sessiongroup_create_t *)response);
+                break;
+            case req_sessiongroup_terminate:
+                status = HandleSessionGroupTerminate((vx_req_sessiongroup_terminate_t *)request);
+                break;
+            case req_sessiongroup_add_session:
+                status = HandleAddSession((vx_req_sessiongroup_add_session_t *)request, (vx_resp_sessiongroup_add_session_t *)response, connectMilliseconds);
+                break;
+            case req_sessiongroup_remove_session:
+                status = HandleRemoveSession((vx_req_sessiongroup_remove_session_t *)request);
+                break;
+            case req_session_send_message:
+                status = HandleSendMessage((vx_req_session_send_message_t *)request);
+                break;
+            case req_aux_get_capture_devices:
+            case req_aux_get_render_devices:
+                HandleGetDevices(response);
+                status = 0;
+                break;
+            default:
+                // Accepted and otherwise ignored
+                status = 0;
+                break;
+        }
+    }
+    if (status != 0) {
+        response->return_code = 1;
+        response->status_code = status;
+        response->status_string = SimStrdup(vx_get_error_string(status));
+    }
+}
+
+int SimBackend::HandleConnectorCreate(vx_req_connector_create_t *req, vx_resp_connector_create_t *resp)
+{
+    std::string handle = NonEmpty(req->connector_handle) ? req->connector_handle : NewHandle("connector");
+    if (m_connectors.count(handle) != 0) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    m_connectors.insert(handle);
+    resp->connector_handle = SimStrdup(handle.c_str());
+    resp->version_id = SimStrdup(vx_get_sdk_version_info());
+    resp->backend_type = backend_type_sip;
+    return 0;
+}
+
+int SimBackend::HandleConnectorShutdown(vx_req_connector_initiate_shutdown_t *req)
+{
+    std::string handle = req->connector_handle ? req->connector_handle : "";
+    if (m_connectors.count(handle) == 0) {
+        return VX_E_NO_EXIST;
+    }
+    std::vector<std::string> accounts;
+    for (auto i = m_accounts.begin(); i != m_accounts.end(); ++i) {
+        if (i->second.connector == handle) {
+            accounts.push_back(i->first);
+        }
+    }
+    for (size_t i = 0; i < accounts.size(); ++i) {
+        Logout(accounts[i]);
+    }
+    m_connectors.erase(handle);
+    return 0;
+}
+
+int SimBackend::HandleLogin(vx_req_base_t *request, vx_resp_base_t *response)
+{
+    const char *connector = NULL;
+    const char *handle = NULL;
+    std::string name;
+    std::string displayName;
+    const char *server = NULL;
+    switch (request->type) {
+        case req_account_login: {
+            vx_req_account_login_t *req = (vx_req_account_login_t *)request;
+            connector = req->connector_handle;
+            handle = req->account_handle;
+            name = req->acct_name ? req->acct_name : "";
+            server = req->acct_mgmt_server;
+            break;
+        }
+        case req_account_anonymous_login: {
+            vx_req_account_anonymous_login_t *req = (vx_req_account_anonymous_login_t *)request;
+            connector = req->connector_handle;
+            handle = req->account_handle;
+            name = req->acct_name ? req->acct_name : "";
+            displayName = req->displayname ? req->displayname : "";
+            server = req->acct_mgmt_server;
+            break;
+        }
+        default: {
+            vx_req_account_authtoken_login_t *req = (vx_req_account_authtoken_login_t *)request;
+            connector = req->connector_handle;
+            handle = req->account_handle;
+            server = req->acct_mgmt_server;
+            break;
+        }
+    }
+    if (!connector || m_connectors.count(connector) == 0) {
+        return VX_E_NO_EXIST;
+    }
+    std::string accountHandle = NonEmpty(handle) ? handle : NewHandle("account");
+    if (m_accounts.count(accountHandle) != 0) {
+        return VX_E_ALREADY_LOGGED_IN;
+    }
+    if (name.empty()) {
+        name = NewHandle("user");
+    }
+    Account &account = m_accounts[accountHandle];
+    account.connector = connector;
+    account.name = name;
+    account.displayName = displayName.empty() ? name : displayName;
+    account.uri = name.find("sip:") == 0 ? name : "sip:" + name + "@" + RealmOf(server ? server : "");
+    int accountId = (int)++m_nextId;
+
+    switch (response->type) {
+        case resp_account_login: {
+            vx_resp_account_login_t *resp = (vx_resp_account_login_t *)response;
+            resp->account_handle = SimStrdup(accountHandle.c_str());
+            resp->account_id = accountId;
+            resp->display_name = SimStrdup(account.displayName.c_str());
+            resp->uri = SimStrdup(account.uri.c_str());
+            resp->encoded_uri_with_tag = SimStrdup(account.uri.c_str());
+            break;
+        }
+        case resp_account_anonymous_login: {
+            vx_resp_account_anonymous_login_t *resp = (vx_resp_account_anonymous_login_t *)response;
+            resp->account_handle = SimStrdup(accountHandle.c_str());
+            resp->account_id = accountId;
+            resp->displayname = SimStrdup(account.displayName.c_str());
+            resp->uri = SimStrdup(account.uri.c_str());
+            resp->encoded_uri_with_tag = SimStrdup(account.uri.c_str());
+            break;
+        }
+        default: {
+            vx_resp_account_authtoken_login_t *resp = (vx_resp_account_authtoken_login_t *)response;
+            resp->account_handle = SimStrdup(accountHandle.c_str());
+            resp->account_id = accountId;
+            resp->user_name = SimStrdup(name.c_str());
+            resp->display_name = SimStrdup(account.displayName.c_str());
+            resp->uri = SimStrdup(account.uri.c_str());
+            resp->encoded_uri_with_tag = SimStrdup(account.uri.c_str());
+            break;
+        }
+    }
+
+    vx_evt_account_login_state_change_t *evt = SimNewEvent<vx_evt_account_login_state_change_t>(evt_account_login_state_change);
+    if (evt) {
+        evt->state = login_state_logged_in;
+        evt->account_handle = SimStrdup(accountHandle.c_str());
+        evt->status_string = SimStrdup("");
+        evt->cookie = request->cookie ? SimStrdup(request->cookie) : NULL;
+        evt->vcookie = request->vcookie;
+        Post(evt);
+    }
+    return 0;
+}
+
+int SimBackend::HandleLogout(vx_req_account_logout_t *req)
+{
+    if (!req->account_handle || m_accounts.count(req->account_handle) == 0) {
+        return VX_E_NO_EXIST;
+    }
+    Logout(req->account_handle);
+    return 0;
+}
+
+void SimBackend::Logout(const std::string &accountHandle)
+{
+    std::vector<std::string> sessionGroups;
+    for (auto i = m_sessionGroups.begin(); i != m_sessionGroups.end(); ++i) {
+        if (i->second.account == accountHandle) {
+            sessionGroups.push_back(i->first);
+        }
+    }
+    for (size_t i = 0; i < sessionGroups.size(); ++i) {
+        RemoveSessionGroup(sessionGroups[i]);
+    }
+    m_accounts.erase(accountHandle);
+
+    vx_evt_account_login_state_change_t *evt = SimNewEvent<vx_evt_account_login_state_change_t>(evt_account_login_state_change);
+    if (evt) {
+        evt->state = login_state_logged_out;
+        evt->account_handle = SimStrdup(accountHandle.c_str());
+        evt->status_string = SimStrdup("");
+        Post(evt);
+    }
+}
+
+int SimBackend::HandleSessionGroupCreate(vx_req_sessiongroup_create_t *req, vx_resp_sessiongroup_create_t *resp)
+{
+    if (!req->account_handle || m_accounts.count(req->account_handle) == 0) {
+        return VX_E_NO_EXIST;
+    }
+    std::string handle = NonEmpty(req->sessiongroup_handle) ? req->sessiongroup_handle : NewHandle("sessiongroup");
+    if (m_sessionGroups.count(handle) != 0) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    resp->sessiongroup_handle = SimStrdup(handle.c_str());
+    AddSessionGroup(handle, req->account_handle);
+    return 0;
+}
+
+int SimBackend::HandleSessionGroupTerminate(vx_req_sessiongroup_terminate_t *req)
+{
+    if (!req->sessiongroup_handle || m_sessionGroups.count(req->sessiongroup_handle) == 0) {
+        return VX_E_SESSIONGROUP_NOT_FOUND;
+    }
+    RemoveSessionGroup(req->sessiongroup_handle);
+    return 0;
+}
+
+void SimBackend::AddSessionGroup(const std::string &handle, const std::string &accountHandle)
+{
+    SessionGroup &sessionGroup = m_sessionGroups[handle];
+    sessionGroup.account = accountHandle;
+
+    vx_evt_sessiongroup_added_t *evt = SimNewEvent<vx_evt_sessiongroup_added_t>(evt_sessiongroup_added);
+    if (evt) {
+        evt->sessiongroup_handle = SimStrdup(handle.c_str());
+        evt->account_handle = SimStrdup(accountHandle.c_str());
+        evt->type = sessiongroup_type_normal;
+        Post(evt);
+    }
+}
+
+void SimBackend::RemoveSessionGroup(const std::string &handle)
+{
+    auto found = m_sessionGroups.find(handle);
+    if (found == m_sessionGroups.end()) {
+        return;
+    }
+    std::vector<std::string> sessions(found->second.sessions);
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        RemoveSession(sessions[i]);
+    }
+    m_sessionGroups.erase(handle);
+
+    vx_evt_sessiongroup_removed_t *evt = SimNewEvent<vx_evt_sessiongroup_removed_t>(evt_sessiongroup_removed);
+    if (evt) {
+        evt->sessiongroup_handle = SimStrdup(handle.c_str());
+        Post(evt);
+    }
+}
+
+int SimBackend::HandleAddSession(vx_req_sessiongroup_add_session_t *req, vx_resp_sessiongroup_add_session_t *resp, double connectMilliseconds)
+{
+    if (!NonEmpty(req->uri)) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    if (!req->connect_audio && !req->connect_text) {
+        return VX_E_SESSION_MUST_HAVE_MEDIA;
+    }
+    std::string sessionGroupHandle = NonEmpty(req->sessiongroup_handle) ? req->sessiongroup_handle : "";
+    auto sessionGroup = m_sessionGroups.find(sessionGroupHandle);
+    std::string accountHandle;
+    if (NonEmpty(req->account_handle)) {
+        accountHandle = req->account_handle;
+    } else if (sessionGroup != m_sessionGroups.end()) {
+        accountHandle = sessionGroup->second.account;
+    } else if (m_accounts.size() == 1) {
+        accountHandle = m_accounts.begin()->first;
+    }
+    auto account = m_accounts.find(accountHandle);
+    if (account == m_accounts.end()) {
+        return VX_E_NO_EXIST;
+    }
+    if (sessionGroup != m_sessionGroups.end() && sessionGroup->second.account != accountHandle) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    std::string handle = NonEmpty(req->session_handle) ? req->session_handle : NewHandle("session");
+    if (m_sessions.count(handle) != 0) {
+        return VX_E_INVALID_SESSION_STATE;
+    }
+
+    if (sessionGroup == m_sessionGroups.end()) {
+        if (sessionGroupHandle.empty()) {
+            sessionGroupHandle = NewHandle("sessiongroup");
+        }
+        AddSessionGroup(sessionGroupHandle, accountHandle);
+    }
+    std::string uri = req->uri;
+    Session &session = m_sessions[handle];
+    session.sessionGroup = sessionGroupHandle;
+    session.channel = uri;
+    session.participantUri = account->second.name.find("sip:") == 0 ? account->second.name : "sip:" + account->second.name + "@" + RealmOf(uri);
+    session.audio = req->connect_audio != 0;
+    session.text = req->connect_text != 0;
+    session.connected = false;
+    session.id = ++m_nextId;
+    m_sessionGroups[sessionGroupHandle].sessions.push_back(handle);
+    resp->session_handle = SimStrdup(handle.c_str());
+
+    vx_evt_session_added_t *added = SimNewEvent<vx_evt_session_added_t>(evt_session_added);
+    if (added) {
+        added->sessiongroup_handle = SimStrdup(sessionGroupHandle.c_str());
+        added->session_handle = SimStrdup(handle.c_str());
+        added->uri = SimStrdup(uri.c_str());
+        added->is_channel = 1;
+        added->channel_name = SimStrdup(uri.c_str());
+        Post(added);
+    }
+    if (session.audio) {
+        vx_evt_media_stream_updated_t *media = SimNewEvent<vx_evt_media_stream_updated_t>(evt_media_stream_updated);
+        if (media) {
+            media->sessiongroup_handle = SimStrdup(sessionGroupHandle.c_str());
+            media->session_handle = SimStrdup(handle.c_str());
+            media->state = session_media_connecting;
+            Post(media);
+        }
+    }
+    if (session.text) {
+        vx_evt_text_stream_updated_t *text = SimNewEvent<vx_evt_text_stream_updated_t>(evt_text_stream_updated);
+        if (text) {
+            text->sessiongroup_handle = SimStrdup(sessionGroupHandle.c_str());
+            text->session_handle = SimStrdup(handle.c_str());
+            text->enabled = 1;
+            text->state = session_text_connecting;
+            Post(text);
+        }
+    }
+    uint64_t id = session.id;
+    Schedule(NowMilliseconds() + connectMilliseconds, [this, handle, id] { ConnectSession(handle, id); });
+    return 0;
+}
+
+void SimBackend::ConnectSession(const std::string &handle, uint64_t id)
+{
+    auto found = m_sessions.find(handle);
+    if (found == m_sessions.end() || found->second.id != id) {
+        return; // removed while connecting
+    }
+    Session &session = found->second;
+    session.connected = true;
+    if (session.audio) {
+        vx_evt_media_stream_updated_t *media = SimNewEvent<vx_evt_media_stream_updated_t>(evt_media_stream_updated);
+        if (media) {
+            media->sessiongroup_handle = SimStrdup(session.sessionGroup.c_str());
+            media->session_handle = SimStrdup(handle.c_str());
+            media->state = session_media_connected;
+            Post(media);
+        }
+    }
+    if (session.text) {
+        vx_evt_text_stream_updated_t *text = SimNewEvent<vx_evt_text_stream_updated_t>(evt_text_stream_updated);
+        if (text) {
+            text->sessiongroup_handle = SimStrdup(session.sessionGroup.c_str());
+            text->session_handle = SimStrdup(handle.c_str());
+            text->enabled = 1;
+            text->state = session_text_connected;
+            Post(text);
+        }
+    }
+    std::string accountName = AccountNameOf(session);
+    PostParticipantAdded(handle, session.participantUri, accountName, true);
+
+    // The local users in the channel see each other
+    Channel &channel = JoinChannel(session.channel);
+    for (size_t i = 0; i < channel.sessions.size(); ++i) {
+        const Session &other = m_sessions[channel.sessions[i]];
+        PostParticipantAdded(handle, other.participantUri, AccountNameOf(other), false);
+        PostParticipantAdded(channel.sessions[i], session.participantUri, accountName, false);
+    }
+    for (size_t i = 0; i < channel.remotes.size(); ++i) {
+        PostParticipantAdded(handle, channel.remotes[i].uri, channel.remotes[i].accountName, false);
+        if (channel.remotes[i].speaking) {
+            PostParticipantUpdated(handle, channel.remotes[i].uri, true);
+        }
+    }
+    channel.sessions.push_back(handle);
+
+    if (session.audio && m_config.pf_on_audio_unit_started) {
+        std::string sessionGroup = session.sessionGroup;
+        std::string uri = session.channel;
+        Defer([this, sessionGroup, uri] { m_config.pf_on_audio_unit_started(m_config.callback_handle, sessionGroup.c_str(), uri.c_str()); });
+    }
+}
+
+int SimBackend::HandleRemoveSession(vx_req_sessiongroup_remove_session_t *req)
+{
+    auto found = req->session_handle ? m_sessions.find(req->session_handle) : m_sessions.end();
+    if (found == m_sessions.end()) {
+        return VX_E_NO_EXIST;
+    }
+    std::string sessionGroup = found->second.sessionGroup;
+    RemoveSession(req->session_handle);
+    if (m_sessionGroups[sessionGroup].sessions.empty()) {
+        RemoveSessionGroup(sessionGroup);
+    }
+    return 0;
+}
+
+void SimBackend::RemoveSession(const std::string &handle)
+{
+    auto found = m_sessions.find(handle);
+    if (found == m_sessions.end()) {
+        return;
+    }
+    Session session = found->second;
+    m_sessions.erase(found);
+    std::vector<std::string> &groupSessions = m_sessionGroups[session.sessionGroup].sessions;
+    for (auto i = groupSessions.begin(); i != groupSessions.end(); ++i) {
+        if (*i == handle) {
+            groupSessions.erase(i);
+            break;
+        }
+    }
+    if (session.connected) {
+        LeaveChannel(session.channel, handle, session.participantUri, AccountNameOf(session));
+    }
+
+    if (session.audio) {
+        vx_evt_media_stream_updated_t *media = SimNewEvent<vx_evt_media_stream_updated_t>(evt_media_stream_updated);
+        if (media) {
+            media->sessiongroup_handle = SimStrdup(session.sessionGroup.c_str());
+            media->session_handle = SimStrdup(handle.c_str());
+            media->state = session_media_disconnected;
+            Post(media);
+        }
+    }
+    if (session.text) {
+        vx_evt_text_stream_updated_t *text = SimNewEvent<vx_evt_text_stream_updated_t>(evt_text_stream_updated);
+        if (text) {
+            text->sessiongroup_handle = SimStrdup(session.sessionGroup.c_str());
+            text->session_handle = SimStrdup(handle.c_str());
+            text->state = session_text_disconnected;
+            Post(text);
+        }
+    }
+    vx_evt_session_removed_t *removed = SimNewEvent<vx_evt_session_removed_t>(evt_session_removed);
+    if (removed) {
+        removed->sessiongroup_handle = SimStrdup(session.sessionGroup.c_str());
+        removed->session_handle = SimStrdup(handle.c_str());
+        removed->uri = SimStrdup(session.channel.c_str());
+        Post(removed);
+    }
+
+    if (session.audio && session.connected && m_config.pf_on_audio_unit_stopped) {
+        std::string sessionGroup = session.sessionGroup;
+        std::string uri = session.channel;
+        Defer([this, sessionGroup, uri] { m_config.pf_on_audio_unit_stopped(m_config.callback_handle, sessionGroup.c_str(), uri.c_str()); });
+    }
+}
+
+int SimBackend::HandleSendMessage(vx_req_session_send_message_t *req)
+{
+    auto found = req->session_handle ? m_sessions.find(req->session_handle) : m_sessions.end();
+    if (found == m_sessions.end()) {
+        return VX_E_NO_EXIST;
+    }
+    const Session &sender = found->second;
+    if (!sender.text || !sender.connected) {
+        return VX_E_SESSION_DOES_NOT_HAVE_TEXT;
+    }
+    // Delivered to the other local sessions in the channel, the remote participants being simulated
+    const Channel &channel = m_channels[sender.channel];
+    for (size_t i = 0; i < channel.sessions.size(); ++i) {
+        const Session &receiver = m_sessions[channel.sessions[i]];
+        if (channel.sessions[i] == req->session_handle || !receiver.text) {
+            continue;
+        }
+        vx_evt_message_t *evt = SimNewEvent<vx_evt_message_t>(evt_message);
+        if (evt) {
+            evt->state = message_none;
+            evt->sessiongroup_handle = SimStrdup(receiver.sessionGroup.c_str());
+            evt->session_handle = SimStrdup(channel.sessions[i].c_str());
+            evt->participant_uri = SimStrdup(sender.participantUri.c_str());
+            evt->message_header = SimStrdup(req->message_header ? req->message_header : "text/plain");
+            evt->message_body = SimStrdup(req->message_body);
+            evt->encoded_uri_with_tag = SimStrdup(sender.participantUri.c_str());
+            evt->language = req->language ? SimStrdup(req->language) : NULL;
+            Post(evt);
+        }
+    }
+    return 0;
+}
+
+void SimBackend::HandleGetDevices(vx_resp_base_t *response)
+{
+    vx_device_t **list = (vx_device_t **)SimMemory::Allocate(sizeof(vx_device_t *), SimMemory::kindData);
+    vx_device_t *devices[3];
+    static const char *const names[3] = { "Simulated Device", "Default System Device", "Default Communication Device" };
+    static const vx_device_type_t types[3] = { vx_device_type_specific_device, vx_device_type_default_system, vx_device_type_default_communication };
+    for (int i = 0; i < 3; ++i) {
+        devices[i] = (vx_device_t *)SimMemory::Allocate(sizeof(vx_device_t), SimMemory::kindData);
+        if (devices[i]) {
+            devices[i]->device = SimStrdup(names[i]);
+            devices[i]->display_name = SimStrdup(names[i]);
+            devices[i]->device_type = types[i];
+        }
+    }
+    if (!list || !devices[0] || !devices[1] || !devices[2]) {
+        SimMemory::Free(list);
+        for (int i = 0; i < 3; ++i) {
+            if (devices[i]) {
+                SimMemory::Free(devices[i]->device);
+                SimMemory::Free(devices[i]->display_name);
+                SimMemory::Free(devices[i]);
+            }
+        }
+        return;
+    }
+    list[0] = devices[0];
+    if (response->type == resp_aux_get_capture_devices) {
+        vx_resp_aux_get_capture_devices_t *resp = (vx_resp_aux_get_capture_devices_t *)response;
+        resp->count = 1;
+        resp->capture_devices = list;
+        resp->current_capture_device = devices[0];
+        resp->effective_capture_device = devices[0];
+        resp->default_capture_device = devices[1];
+        resp->default_communication_capture_device = devices[2];
+    } else {
+        vx_resp_aux_get_render_devices_t *resp = (vx_resp_aux_get_render_devices_t *)response;
+        resp->count = 1;
+        resp->render_devices = list;
+        resp->current_render_device = devices[0];
+        resp->effective_render_device = devices[0];
+        resp->default_render_device = devices[1];
+        resp->default_communication_render_device = devices[2];
+    }
+}
+
+// Channels
+
+SimBackend::Channel &SimBackend::JoinChannel(const std::string &uri)
+{
+    auto found = m_channels.find(uri);
+    if (found != m_channels.end()) {
+        return found->second;
+    }
+    Channel &channel = m_channels[uri];
+    channel.realm = RealmOf(uri);
+    channel.id = ++m_nextId;
+    channel.nextRemote = 0;
+    std::seed_seq seed = { m_settings.seed, Hash(uri) };
+    channel.random.seed(seed);
+
+    double now = NowMilliseconds();
+    unsigned int initial = m_settings.initial_remote_participants < m_settings.max_remote_participants ? m_settings.initial_remote_participants : m_settings.max_remote_participants;
+    for (unsigned int i = 0; i < initial; ++i) {
+        AddRemote(uri, channel, now);
+    }
+    if (m_settings.participant_joins_per_second > 0) {
+        ScheduleRemoteJoin(uri, channel.id, now + ExponentialMilliseconds(channel.random, m_settings.participant_joins_per_second));
+    }
+    return channel;
+}
+
+void SimBackend::LeaveChannel(const std::string &uri, const std::string &sessionHandle, const std::string &participantUri, const std::string &accountName)
+{
+    auto found = m_channels.find(uri);
+    if (found == m_channels.end()) {
+        return;
+    }
+    Channel &channel = found->second;
+    for (auto i = channel.sessions.begin(); i != channel.sessions.end(); ++i) {
+        if (*i == sessionHandle) {
+            channel.sessions.erase(i);
+            break;
+        }
+    }
+    if (channel.sessions.empty()) {
+        m_channels.erase(found);
+        return;
+    }
+    for (size_t i = 0; i < channel.sessions.size(); ++i) {
+        PostParticipantRemoved(channel.sessions[i], participantUri, accountName, false);
+    }
+}
+
+std::string SimBackend::AccountNameOf(const Session &session) const
+{
+    auto sessionGroup = m_sessionGroups.find(session.sessionGroup);
+    if (sessionGroup == m_sessionGroups.end()) {
+        return std::string();
+    }
+    auto account = m_accounts.find(sessionGroup->second.account);
+    return account != m_accounts.end() ? account->second.name : std::string();
+}
+
+SimBackend::Channel *SimBackend::FindChannel(const std::string &uri, uint64_t channelId)
+{
+    auto found = m_channels.find(uri);
+    return found != m_channels.end() && found->second.id == channelId ? &found->second : NULL;
+}
+
+void SimBackend::AddRemote(const std::string &uri, Channel &channel, double nowMilliseconds)
+{
+    Remote remote;
+    remote.id = ++channel.nextRemote;
+    remote.accountName = "simuser" + std::to_string(remote.id);
+    remote.uri = "sip:" + remote.accountName + "@" + channel.realm;
+    remote.speaking = false;
+    channel.remotes.push_back(remote);
+    for (size_t i = 0; i < channel.sessions.size(); ++i) {
+        PostParticipantAdded(channel.sessions[i], remote.uri, remote.accountName, false);
+    }
+    if (m_settings.participant_stay_seconds > 0) {
+        ScheduleRemoteLeave(uri, channel.id, remote.id, nowMilliseconds + ExponentialMilliseconds(channel.random, 1.0 / m_settings.participant_stay_seconds));
+    }
+    if (m_settings.speaking_changes_per_second > 0) {
+        ScheduleSpeaking(uri, channel.id, remote.id, nowMilliseconds + ExponentialMilliseconds(channel.random, m_settings.speaking_changes_per_second));
+    }
+}
+
+void SimBackend::ScheduleRemoteJoin(const std::string &uri, uint64_t channelId, double dueMilliseconds)
+{
+    Schedule(dueMilliseconds, [this, uri, channelId, dueMilliseconds] {
+        Channel *channel = FindChannel(uri, channelId);
+        if (!channel) {
+            return;
+        }
+        if (channel->remotes.size() < m_settings.max_remote_participants) {
+            AddRemote(uri, *channel, dueMilliseconds);
+        }
+        ScheduleRemoteJoin(uri, channelId, dueMilliseconds + ExponentialMilliseconds(channel->random, m_settings.participant_joins_per_second));
+    });
+}
+
+void SimBackend::ScheduleRemoteLeave(const std::string &uri, uint64_t channelId, uint64_t remoteId, double dueMilliseconds)
+{
+    Schedule(dueMilliseconds, [this, uri, channelId, remoteId] {
+        Channel *channel = FindChannel(uri, channelId);
+        if (!channel) {
+            return;
+        }
+        for (auto i = channel->remotes.begin(); i != channel->remotes.end(); ++i) {
+            if (i->id == remoteId) {
+                for (size_t j = 0; j < channel->sessions.size(); ++j) {
+                    PostParticipantRemoved(channel->sessions[j], i->uri, i->accountName, false);
+                }
+                channel->remotes.erase(i);
+                break;
+            }
+        }
+    });
+}
+
+void SimBackend::ScheduleSpeaking(const std::string &uri, uint64_t channelId, uint64_t remoteId, double dueMilliseconds)
+{
+    Schedule(dueMilliseconds, [this, uri, channelId, remoteId, dueMilliseconds] {
+        Channel *channel = FindChannel(uri, channelId);
+        if (!channel) {
+            return;
+        }
+        for (auto i = channel->remotes.begin(); i != channel->remotes.end(); ++i) {
+            if (i->id == remoteId) {
+                i->speaking = !i->speaking;
+                for (size_t j = 0; j < channel->sessions.size(); ++j) {
+                    PostParticipantUpdated(channel->sessions[j], i->uri, i->speaking);
+                }
+                ScheduleSpeaking(uri, channelId, remoteId, dueMilliseconds + ExponentialMilliseconds(channel->random, m_settings.speaking_changes_per_second));
+                break;
+            }
+        }
+    });
+}
+
+void SimBackend::PostParticipantAdded(const std::string &sessionHandle, const std::string &uri, const std::string &accountName, bool isCurrentUser)
+{
+    const Session &session = m_sessions[sessionHandle];
+    vx_evt_participant_added_t *evt = SimNewEvent<vx_evt_participant_added_t>(evt_participant_added);
+    if (evt) {
+        evt->sessiongroup_handle = SimStrdup(session.sessionGroup.c_str());
+        evt->session_handle = SimStrdup(sessionHandle.c_str());
+        evt->participant_uri = SimStrdup(uri.c_str());
+        evt->account_name = SimStrdup(accountName.c_str());
+        evt->display_name = SimStrdup(accountName.c_str());
+        evt->displayname = SimStrdup(accountName.c_str());
+        evt->participant_type = participant_user;
+        evt->encoded_uri_with_tag = SimStrdup(uri.c_str());
+        evt->is_current_user = isCurrentUser ? 1 : 0;
+        Post(evt);
+    }
+}
+
+void SimBackend::PostParticipantRemoved(const std::string &sessionHandle, const std::string &uri, const std::string &accountName, bool isCurrentUser)
+{
+    const Session &session = m_sessions[sessionHandle];
+    vx_evt_participant_removed_t *evt = SimNewEvent<vx_evt_participant_removed_t>(evt_participant_removed);
+    if (evt) {
+        evt->sessiongroup_handle = SimStrdup(session.sessionGroup.c_str());
+        evt->session_handle = SimStrdup(sessionHandle.c_str());
+        evt->participant_uri = SimStrdup(uri.c_str());
+        evt->account_name = SimStrdup(accountName.c_str());
+        evt->reason = participant_left;
+        evt->encoded_uri_with_tag = SimStrdup(uri.c_str());
+        evt->is_current_user = isCurrentUser ? 1 : 0;
+        Post(evt);
+    }
+}
+
+void SimBackend::PostParticipantUpdated(const std::string &sessionHandle, const std::string &uri, bool speaking)
+{
+    const Session &session = m_sessions[sessionHandle];
+    vx_evt_participant_updated_t *evt = SimNewEvent<vx_evt_participant_updated_t>(evt_participant_updated);
+    if (evt) {
+        evt->sessiongroup_handle = SimStrdup(session.sessionGroup.c_str());
+        evt->session_handle = SimStrdup(sessionHandle.c_str());
+        evt->participant_uri = SimStrdup(uri.c_str());
+        evt->is_speaking = speaking ? 1 : 0;
+        evt->volume = 50;
+        evt->energy = speaking ? 0.5 : 0.0;
+        evt->active_media = 1; // audio
+        evt->type = participant_user;
+        evt->encoded_uri_with_tag = SimStrdup(uri.c_str());
+        Post(evt);
+    }
+}
+
+// The timeline
+
+void SimBackend::Post(void *message)
+{
+    m_outbox.push_back(message);
+}
+
+void SimBackend::Defer(const Action &callback)
+{
+    m_deferred.push_back(callback);
+}
+
+void SimBackend::Schedule(double dueMilliseconds, const Action &action)
+{
+    Timed timed;
+    timed.dueMilliseconds = dueMilliseconds;
+    timed.sequence = m_nextSequence++;
+    timed.action = action;
+    bool first = m_timeline.empty() || !(timed > m_timeline.top());
+    m_timeline.push(timed);
+    if (first) {
+        m_condition.notify_one();
+    }
+}
+
+std::string SimBackend::NewHandle(const char *prefix)
+{
+    return std::string("sim") + prefix + std::to_string(++m_nextHandle);
+}
+
+double SimBackend::Uniform(std::mt19937 &random)
+{
+    return (random() + 0.5) / 4294967296.0;
+}
+
+double SimBackend::ExponentialMilliseconds(std::mt19937 &random, double perSecond)
+{
+    return -log(Uniform(random)) / perSecond * 1000.0;
+}
+
+double SimBackend::LatencyMilliseconds()
+{
+    unsigned int range = m_settings.response_latency_max_ms - m_settings.response_latency_min_ms;
+    return m_settings.response_latency_min_ms + (double)(m_random() % ((uint64_t)range + 1));
+}
+
+void SimBackend::Publish(std::unique_lock<std::mutex> &lock)
+{
+    std::vector<void *> outbox;
+    std::vector<Action> deferred;
+    outbox.swap(m_outbox);
+    deferred.swap(m_deferred);
+    lock.unlock();
+    if (!outbox.empty()) {
+        std::lock_guard<std::mutex> messagesLock(m_messagesMutex);
+        for (size_t i = 0; i < outbox.size(); ++i) {
+            m_messages.push_back((vx_message_base_t *)outbox[i]);
+        }
+    }
+    if (m_config.pf_sdk_message_callback) {
+        for (size_t i = 0; i < outbox.size(); ++i) {
+            m_config.pf_sdk_message_callback(m_config.callback_handle);
+        }
+    }
+    for (size_t i = 0; i < deferred.size(); ++i) {
+        deferred[i]();
+    }
+    lock.lock();
+}
+
+void SimBackend::SimulatorThread()
+{
+    if (m_config.pf_on_thread_created) {
+        m_config.pf_on_thread_created(m_config.callback_handle, "simulator");
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopRequested) {
+        if (m_timeline.empty()) {
+            m_condition.wait(lock);
+            continue;
+        }
+        double due = m_timeline.top().dueMilliseconds;
+        if (NowMilliseconds() < due) {
+            m_condition.wait_until(lock, m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(due)));
+            continue;
+        }
+        Action action = m_timeline.top().action;
+        m_timeline.pop();
+        action();
+        Publish(lock);
+    }
+    lock.unlock();
+    if (m_config.pf_on_thread_exit) {
+        m_config.pf_on_thread_exit(m_config.callback_handle);
+    }
+}
+
+// The audio clock
+
+void SimBackend::AudioThread()
+{
+    if (m_config.pf_on_thread_created) {
+        m_config.pf_on_thread_created(m_config.callback_handle, "simulator audio");
+    }
+    const int frames = (int)(c_audioSampleRate / 1000 * m_settings.audio_frame_ms);
+    std::vector<short> capture(frames), rendered(frames), voice(frames);
+    std::vector<AudioTarget> targets;
+    uint64_t tick = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        std::chrono::steady_clock::time_point due = m_start + std::chrono::milliseconds(tick * m_settings.audio_frame_ms);
+        if (m_audioCondition.wait_until(lock, due, [this] { return m_stopRequested; })) {
+            break;
+        }
+        uint64_t behind = (uint64_t)(NowMilliseconds() / m_settings.audio_frame_ms);
+        if (behind > tick + c_maxLateFrames) {
+            tick = behind;
+        }
+
+        targets.clear();
+        for (auto i = m_sessions.begin(); i != m_sessions.end(); ++i) {
+            if (!i->second.connected || !i->second.audio) {
+                continue;
+            }
+            AudioTarget target;
+            target.sessionGroup = i->second.sessionGroup;
+            target.channel = i->second.channel;
+            target.ssrc = Hash(i->first);
+            auto channel = m_channels.find(i->second.channel);
+            if (channel != m_channels.end()) {
+                for (size_t j = 0; j < channel->second.remotes.size(); ++j) {
+                    if (channel->second.remotes[j].speaking) {
+                        target.speaking.push_back(channel->second.remotes[j].uri);
+                    }
+                }
+            }
+            targets.push_back(target);
+        }
+        lock.unlock();
+
+        for (int i = 0; i < frames; ++i) {
+            double t = (double)(tick * frames + i) / c_audioSampleRate;
+            voice[i] = (short)(c_voiceAmplitude * sin(2 * 3.14159265358979 * c_voiceFrequency * t));
+        }
+        for (size_t i = 0; i < targets.size(); ++i) {
+            AudioTick(targets[i], tick, &capture[0], &rendered[0], &voice[0], frames);
+        }
+
+        lock.lock();
+        ++tick;
+    }
+    lock.unlock();
+    if (m_config.pf_on_thread_exit) {
+        m_config.pf_on_thread_exit(m_config.callback_handle);
+    }
+}
+
+void SimBackend::AudioTick(const AudioTarget &target, uint64_t tick, short *capture, short *rendered, short *voice, int frames)
+{
+    const char *sessionGroup = target.sessionGroup.c_str();
+    const char *uri = target.channel.c_str();
+    void *handle = m_config.callback_handle;
+
+    // Capture is silence
+    memset(capture, 0, frames * sizeof(short));
+    if (m_config.pf_on_audio_unit_after_capture_audio_read) {
+        m_config.pf_on_audio_unit_after_capture_audio_read(handle, sessionGroup, uri, capture, frames, c_audioSampleRate, 1);
+    }
+    if (m_config.pf_on_audio_unit_before_capture_audio_sent) {
+        m_config.pf_on_audio_unit_before_capture_audio_sent(handle, sessionGroup, uri, capture, frames, c_audioSampleRate, 1, 0);
+    }
+
+    // Each remote participant speaking is the same tone, the mix their sum
+    std::vector<std::vector<short> > participantFrames(target.speaking.size(), std::vector<short>(voice, voice + frames));
+    std::vector<vx_before_recv_audio_mixed_participant_data_t> participants(target.speaking.size());
+    for (size_t i = 0; i < target.speaking.size(); ++i) {
+        participants[i].participant_uri = target.speaking[i].c_str();
+        participants[i].pcm_frames = &participantFrames[i][0];
+        participants[i].pcm_frame_count = frames;
+        participants[i].audio_frame_rate = c_audioSampleRate;
+        participants[i].channels_per_frame = 1;
+    }
+    if (m_config.pf_on_audio_unit_before_recv_audio_mixed) {
+        m_config.pf_on_audio_unit_before_recv_audio_mixed(handle, sessionGroup, uri, participants.empty() ? NULL : &participants[0], participants.size());
+    }
+    for (int i = 0; i < frames; ++i) {
+        int sample = 0;
+        for (size_t j = 0; j < participantFrames.size(); ++j) {
+            sample += participantFrames[j][i];
+        }
+        rendered[i] = (short)(sample > 32767 ? 32767 : sample < -32768 ? -32768 : sample);
+    }
+    if (m_config.pf_on_audio_unit_before_recv_audio_rendered) {
+        m_config.pf_on_audio_unit_before_recv_audio_rendered(handle, sessionGroup, uri, rendered, frames, c_audioSampleRate, 1, participants.empty() ? 1 : 0);
+    }
+
+    // One RTP packet sent per frame: the header, then an empty payload
+    if (m_config.pf_on_before_udp_frame_transmitted || m_config.pf_on_after_udp_frame_transmitted) {
+        unsigned char packet[12 + 60];
+        memset(packet, 0, sizeof(packet));
+        uint16_t sequence = (uint16_t)tick;
+        uint32_t timestamp = (uint32_t)(tick * frames);
+        packet[0] = 0x80;
+        packet[2] = (unsigned char)(sequence >> 8);
+        packet[3] = (unsigned char)sequence;
+        for (int i = 0; i < 4; ++i) {
+            packet[4 + i] = (unsigned char)(timestamp >> (24 - 8 * i));
+            packet[8 + i] = (unsigned char)(target.ssrc >> (24 - 8 * i));
+        }
+        void *header = NULL;
+        void *trailer = NULL;
+        int headerLength = 0;
+        int trailerLength = 0;
+        if (m_config.pf_on_before_udp_frame_transmitted) {
+            m_config.pf_on_before_udp_frame_transmitted(handle, vx_frame_type_rtp, packet, (int)sizeof(packet), &header, &headerLength, &trailer, &trailerLength);
+        }
+        if (m_config.pf_on_after_udp_frame_transmitted) {
+            m_config.pf_on_after_udp_frame_transmitted(handle, vx_frame_type_rtp, packet, (int)sizeof(packet), header, headerLength, trailer, trailerLength,
+                (int)sizeof(packet) + headerLength + trailerLength);
+        }
+    }
+}
+
+double SimBackend::NowMilliseconds() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+}
@@ -0,0 +1,193 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "SimMessages.h"
+#include "VxcSimulator.h"
+
+// The simulated SDK: connectors, accounts, session groups and sessions kept from the requests
+// issued, the channels the sessions are in with the simulated remote participants joining,
+// leaving and speaking in them, and an audio clock calling the audio callbacks.
+//
+// Everything happens on a timeline run by one simulator thread, in order of due time then
+// of scheduling. A request is handled when its response is due, which is drawn when it is
+// issued, so the random draws of the requests only depend on the order they are issued in.
+// Each channel draws from a generator of its own, seeded from the seed and its URI, with its
+// timers due at times computed from the times drawn rather than from when the one before
+// actually ran, so what happens in a channel is the same from one run to the next.
+class SimBackend
+{
+public:
+    SimBackend();
+    ~SimBackend();
+
+    void Start(const vx_sdk_config_t &config, const vx_sim_config_t &settings);
+    // Destroys the requests not handled and the messages not taken yet
+    void Stop();
+    bool IsRunning() const;
+
+    int IssueRequest(vx_req_base_t *request, int *outstanding);
+    int GetMessage(vx_message_base_t **message);
+
+private:
+    SimBackend(const SimBackend &); // disabled
+
+    typedef std::function<void()> Action;
+
+    struct Timed {
+        double dueMilliseconds;
+        uint64_t sequence;
+        Action action;
+        bool operator>(const Timed &other) const
+        {
+            return dueMilliseconds != other.dueMilliseconds ? dueMilliseconds > other.dueMilliseconds : sequence > other.sequence;
+        }
+    };
+
+    struct Account {
+        std::string connector;
+        std::string name;
+        std::string displayName;
+        std::string uri;
+    };
+
+    struct SessionGroup {
+        std::string account;
+        std::vector<std::string> sessions;
+    };
+
+    struct Session {
+        std::string sessionGroup;
+        std::string channel;        // its URI
+        std::string participantUri; // of the local user in the channel
+        bool audio;
+        bool text;
+        bool connected;
+        uint64_t id;                // tells a session apart from an earlier one of the same handle
+    };
+
+    struct Remote {
+        uint64_t id;
+        std::string uri;
+        std::string accountName;
+        bool speaking;
+    };
+
+    struct Channel {
+        std::string realm;
+        std::vector<std::string> sessions;  // the connected local ones, in order of joining
+        std::vector<Remote> remotes;
+        std::mt19937 random;
+        uint64_t id;
+        uint64_t nextRemote;
+    };
+
+    struct AudioTarget {
+        std::string sessionGroup;
+        std::string channel;
+        std::vector<std::string> speaking;  // the URIs of the remote participants speaking
+        uint32_t ssrc;
+    };
+
+    // The request handlers, m_mutex held
+    void Handle(vx_req_base_t *request, bool fail, double connectMilliseconds);
+    int HandleConnectorCreate(vx_req_connector_create_t *req, vx_resp_connector_create_t *resp);
+    int HandleConnectorShutdown(vx_req_connector_initiate_shutdown_t *req);
+    int HandleLogin(vx_req_base_t *request, vx_resp_base_t *response);
+    int HandleLogout(vx_req_account_logout_t *req);
+    int HandleSessionGroupCreate(vx_req_sessiongroup_create_t *req, vx_resp_sessiongroup_create_t *resp);
+    int HandleSessionGroupTerminate(vx_req_sessiongroup_terminate_t *req);
+    int HandleAddSession(vx_req_sessiongroup_add_session_t *req, vx_resp_sessiongroup_add_session_t *resp, double connectMilliseconds);
+    int HandleRemoveSession(vx_req_sessiongroup_remove_session_t *req);
+    int HandleSendMessage(vx_req_session_send_message_t *req);
+    void HandleGetDevices(vx_resp_base_t *response);
+
+    // m_mutex held
+    void Logout(const std::string &accountHandle);
+    void AddSessionGroup(const std::string &handle, const std::string &accountHandle);
+    void RemoveSessionGroup(const std::string &handle);
+    void ConnectSession(const std::string &handle, uint64_t id);
+    void RemoveSession(const std::string &handle);
+    Channel &JoinChannel(const std::string &uri);
+    void LeaveChannel(const std::string &uri, const std::string &sessionHandle, const std::string &participantUri, const std::string &accountName);
+    // The channel timers do nothing once the channel they were scheduled for is gone
+    void ScheduleRemoteJoin(const std::string &uri, uint64_t channelId, double dueMilliseconds);
+    void ScheduleRemoteLeave(const std::string &uri, uint64_t channelId, uint64_t remoteId, double dueMilliseconds);
+    void ScheduleSpeaking(const std::string &uri, uint64_t channelId, uint64_t remoteId, double dueMilliseconds);
+    Channel *FindChannel(const std::string &uri, uint64_t channelId);
+    std::string AccountNameOf(const Session &session) const;
+    void AddRemote(const std::string &uri, Channel &channel, double nowMilliseconds);
+    void PostParticipantAdded(const std::string &sessionHandle, const std::string &uri, const std::string &accountName, bool isCurrentUser);
+    void PostParticipantRemoved(const std::string &sessionHandle, const std::string &uri, const std::string &accountName, bool isCurrentUser);
+    void PostParticipantUpdated(const std::string &sessionHandle, const std::string &uri, bool speaking);
+    void Post(void *message);
+    void Defer(const Action &callback);
+    void Schedule(double dueMilliseconds, const Action &action);
+    std::string NewHandle(const char *prefix);
+    // Computed from the generator output, which unlike the standard distributions is the
+    // same with every standard library
+    static double Uniform(std::mt19937 &random);
+    static double ExponentialMilliseconds(std::mt19937 &random, double perSecond);
+    double LatencyMilliseconds();
+
+    // Publishes what the action just run posted, and makes its callbacks
+    void Publish(std::unique_lock<std::mutex> &lock);
+    void SimulatorThread();
+    void AudioThread();
+    void AudioTick(const AudioTarget &target, uint64_t tick, short *capture, short *rendered, short *voice, int frames);
+    double NowMilliseconds() const;
+
+    vx_sdk_config_t m_config;
+    vx_sim_config_t m_settings;
+    std::chrono::steady_clock::time_point m_start;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::priority_queue<Timed, std::vector<Timed>, std::greater<Timed> > m_timeline;
+    uint64_t m_nextSequence;
+    std::set<vx_req_base_t *> m_requests;   // issued, not handled yet
+    std::mt19937 m_random;
+    uint64_t m_nextHandle;
+    uint64_t m_nextId;
+    std::set<std::string> m_connectors;
+    std::map<std::string, Account> m_accounts;
+    std::map<std::string, SessionGroup> m_sessionGroups;
+    std::map<std::string, Session> m_sessions;
+    std::map<std::string, Channel> m_channels;
+    std::vector<void *> m_outbox;       // posted by the action running
+    std::vector<Action> m_deferred;     // callbacks of the action running, made without m_mutex
+    bool m_stopRequested;
+    bool m_running;
+    std::thread m_simulatorThread;
+    std::thread m_audioThread;
+
+    std::condition_variable m_audioCondition;
+
+    std::mutex m_messagesMutex;
+    std::deque<vx_message_base_t *> m_messages;
+};
@@ -0,0 +1,207 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "SimMemory.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace SimMemory
+{
+    struct Block {
+        size_t size;
+        Kind kind;
+        FreeFunction pfFree;
+    };
+
+    // Sharded by address, so threads creating and destroying messages at once seldom
+    // wait for each other
+    static const size_t c_nShards = 16;
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uintptr_t, Block> blocks;
+    };
+    static Shard s_shards[c_nShards];
+
+    static std::mutex s_allocatorMutex;
+    static MallocFunction s_pfMalloc = NULL;
+    static FreeFunction s_pfFree = NULL;
+
+    static Shard &ShardOf(uintptr_t address)
+    {
+        // Blocks are at least 8 aligned, the low bits tell nothing apart
+        return s_shards[(address >> 4) % c_nShards];
+    }
+
+    static void DefaultFree(void *memory)
+    {
+        free(memory);
+    }
+
+    static void AlignedFree(void *memory)
+    {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+    }
+
+    static void Register(void *p, size_t bytes, Kind kind, FreeFunction pfFree)
+    {
+        Block block;
+        block.size = bytes;
+        block.kind = kind;
+        block.pfFree = pfFree;
+        Shard &shard = ShardOf((uintptr_t)p);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.blocks[(uintptr_t)p] = block;
+    }
+
+    static bool Unregister(uintptr_t address, Block &block)
+    {
+        Shard &shard = ShardOf(address);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.blocks.find(address);
+        if (found == shard.blocks.end()) {
+            return false;
+        }
+        block = found->second;
+        shard.blocks.erase(found);
+        return true;
+    }
+
+    void SetAllocator(MallocFunction pfMalloc, FreeFunction pfFree)
+    {
+        std::lock_guard<std::mutex> lock(s_allocatorMutex);
+        if (pfMalloc && pfFree) {
+            s_pfMalloc = pfMalloc;
+            s_pfFree = pfFree;
+        } else {
+            s_pfMalloc = NULL;
+            s_pfFree = NULL;
+        }
+    }
+
+    void *Allocate(size_t bytes, Kind kind)
+    {
+        MallocFunction pfMalloc;
+        FreeFunction pfFree;
+        {
+            std::lock_guard<std::mutex> lock(s_allocatorMutex);
+            pfMalloc = s_pfMalloc;
+            pfFree = s_pfFree;
+        }
+        size_t size = bytes ? bytes : 1;
+        void *p = pfMalloc ? pfMalloc(size) : malloc(size);
+        if (!p) {
+            return NULL;
+        }
+        memset(p, 0, size);
+        Register(p, size, kind, pfFree ? pfFree : DefaultFree);
+        return p;
+    }
+
+    void *AllocateAligned(size_t alignment, size_t bytes)
+    {
+        size_t size = bytes ? bytes : 1;
+        void *p = NULL;
+#ifdef _WIN32
+        p = _aligned_malloc(size, alignment);
+#else
+        if (alignment < sizeof(void *)) {
+            alignment = sizeof(void *);
+        }
+        if (posix_memalign(&p, alignment, size) != 0) {
+            p = NULL;
+        }
+#endif
+        if (!p) {
+            return NULL;
+        }
+        memset(p, 0, size);
+        Register(p, size, kindData, AlignedFree);
+        return p;
+    }
+
+    void *Reallocate(void *p, size_t bytes)
+    {
+        if (!p) {
+            return Allocate(bytes, kindData);
+        }
+        Block block;
+        if (!Unregister((uintptr_t)p, block)) {
+            return NULL;
+        }
+        void *q = Allocate(bytes, block.kind);
+        if (!q) {
+            Register(p, block.size, block.kind, block.pfFree);
+            return NULL;
+        }
+        memcpy(q, p, block.size < bytes ? block.size : bytes);
+        block.pfFree(p);
+        return q;
+    }
+
+    char *Strdup(const char *s)
+    {
+        if (!s) {
+            return NULL;
+        }
+        size_t size = strlen(s) + 1;
+        char *p = (char *)Allocate(size, kindString);
+        if (p) {
+            memcpy(p, s, size);
+        }
+        return p;
+    }
+
+    bool Free(void *p)
+    {
+        Block block;
+        if (!p || !Unregister((uintptr_t)p, block)) {
+            return false;
+        }
+        block.pfFree(p);
+        return true;
+    }
+
+    bool IsRegistered(const void *p)
+    {
+        Shard &shard = ShardOf((uintptr_t)p);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.blocks.find((uintptr_t)p) != shard.blocks.end();
+    }
+
+    size_t GetSize(const void *p)
+    {
+        Shard &shard = ShardOf((uintptr_t)p);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.blocks.find((uintptr_t)p);
+        return found != shard.blocks.end() ? found->second.size : 0;
+    }
+
+    size_t GetBlockCount()
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < c_nShards; ++i) {
+            std::lock_guard<std::mutex> lock(s_shards[i].mutex);
+            count += s_shards[i].blocks.size();
+        }
+        return count;
+    }
+}
@@ -0,0 +1,51 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <stddef.h>
+
+// Every block the simulator hands out, whether to the application through vx_strdup(),
+// vx_allocate() and the *_create() functions or in its own responses and events, is
+// registered with the size and the free function it was allocated with, so that freeing
+// a pointer that is not one, or freeing a block twice, is refused rather than corrupting
+// the heap. Which blocks a message owns is up to SimFreeMessage(), see SimMessages.h.
+namespace SimMemory
+{
+    enum Kind {
+        kindString,
+        kindData,       // vx_allocate()
+        kindMessage
+    };
+
+    typedef void *(*MallocFunction)(size_t bytes);
+    typedef void (*FreeFunction)(void *memory);
+
+    // Sets the functions of vx_sdk_config_t, or NULL for malloc() and free(), used for the
+    // blocks allocated from then on
+    void SetAllocator(MallocFunction pfMalloc, FreeFunction pfFree);
+
+    // Zeroed; NULL if out of memory
+    void *Allocate(size_t bytes, Kind kind);
+    void *AllocateAligned(size_t alignment, size_t bytes);
+    void *Reallocate(void *p, size_t bytes);
+    char *Strdup(const char *s);
+
+    // Frees a registered block, and only that block. Returns false if p is not one.
+    bool Free(void *p);
+    bool IsRegistered(const void *p);
+    // The size a registered block was allocated with, 0 if p is not one
+    size_t GetSize(const void *p);
+    size_t GetBlockCount();
+}
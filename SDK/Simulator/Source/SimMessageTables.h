@@ -0,0 +1,1917 @@
+/* Generated by SDK/Simulator/tools/gen_tables.py from the headers in SDK/include, do not edit. */
+#pragma once
+
+// X(name) for each request type with a vx_req_name_create() function
+#define VX_SIM_REQUEST_TYPES(X) \
+    X(connector_create) \
+    X(connector_initiate_shutdown) \
+    X(account_login) \
+    X(account_logout) \
+    X(account_set_login_properties) \
+    X(sessiongroup_create) \
+    X(sessiongroup_terminate) \
+    X(sessiongroup_add_session) \
+    X(sessiongroup_remove_session) \
+    X(sessiongroup_set_focus) \
+    X(sessiongroup_unset_focus) \
+    X(sessiongroup_reset_focus) \
+    X(sessiongroup_set_tx_session) \
+    X(sessiongroup_set_tx_all_sessions) \
+    X(sessiongroup_set_tx_no_session) \
+    X(session_create) \
+    X(session_media_connect) \
+    X(session_media_disconnect) \
+    X(session_terminate) \
+    X(session_mute_local_speaker) \
+    X(session_set_local_speaker_volume) \
+    X(session_set_local_render_volume) \
+    X(session_channel_invite_user) \
+    X(session_set_participant_volume_for_me) \
+    X(session_set_participant_mute_for_me) \
+    X(session_set_3d_position) \
+    X(session_set_voice_font) \
+    X(account_channel_add_acl) \
+    X(account_channel_remove_acl) \
+    X(account_channel_get_acl) \
+    X(channel_mute_user) \
+    X(channel_ban_user) \
+    X(channel_get_banned_users) \
+    X(channel_kick_user) \
+    X(channel_mute_all_users) \
+    X(connector_mute_local_mic) \
+    X(connector_mute_local_speaker) \
+    X(connector_set_local_mic_volume) \
+    X(connector_set_local_speaker_volume) \
+    X(connector_get_local_audio_info) \
+    X(account_buddy_set) \
+    X(account_buddy_delete) \
+    X(account_list_buddies_and_groups) \
+    X(session_send_message) \
+    X(account_set_presence) \
+    X(account_send_subscription_reply) \
+    X(session_send_notification) \
+    X(account_create_block_rule) \
+    X(account_delete_block_rule) \
+    X(account_list_block_rules) \
+    X(account_create_auto_accept_rule) \
+    X(account_delete_auto_accept_rule) \
+    X(account_list_auto_accept_rules) \
+    X(account_update_account) \
+    X(account_get_account) \
+    X(account_send_sms) \
+    X(aux_connectivity_info) \
+    X(aux_get_render_devices) \
+    X(aux_get_capture_devices) \
+    X(aux_set_render_device) \
+    X(aux_set_capture_device) \
+    X(aux_get_mic_level) \
+    X(aux_get_speaker_level) \
+    X(aux_set_mic_level) \
+    X(aux_set_speaker_level) \
+    X(aux_render_audio_start) \
+    X(aux_render_audio_stop) \
+    X(aux_capture_audio_start) \
+    X(aux_capture_audio_stop) \
+    X(aux_global_monitor_keyboard_mouse) \
+    X(aux_set_idle_timeout) \
+    X(aux_create_account) \
+    X(aux_reactivate_account) \
+    X(aux_deactivate_account) \
+    X(account_post_crash_dump) \
+    X(aux_reset_password) \
+    X(sessiongroup_set_session_3d_position) \
+    X(account_get_session_fonts) \
+    X(account_get_template_fonts) \
+    X(aux_start_buffer_capture) \
+    X(aux_play_audio_buffer) \
+    X(session_text_connect) \
+    X(session_text_disconnect) \
+    X(channel_set_lock_mode) \
+    X(aux_render_audio_modify) \
+    X(session_send_dtmf) \
+    X(aux_set_vad_properties) \
+    X(aux_get_vad_properties) \
+    X(sessiongroup_control_audio_injection) \
+    X(account_channel_change_owner) \
+    X(account_send_user_app_data) \
+    X(aux_diagnostic_state_dump) \
+    X(account_web_call) \
+    X(account_anonymous_login) \
+    X(account_authtoken_login) \
+    X(sessiongroup_get_stats) \
+    X(account_send_message) \
+    X(aux_notify_application_state_change) \
+    X(account_control_communications) \
+    X(session_archive_query) \
+    X(account_archive_query) \
+    X(session_transcription_control) \
+    X(aux_get_derumbler_properties) \
+    X(aux_set_derumbler_properties) \
+
+// X(name) for each response type with a vx_resp_name_t
+#define VX_SIM_RESPONSE_TYPES(X) \
+    X(connector_create) \
+    X(connector_initiate_shutdown) \
+    X(account_login) \
+    X(account_logout) \
+    X(account_set_login_properties) \
+    X(sessiongroup_create) \
+    X(sessiongroup_terminate) \
+    X(sessiongroup_add_session) \
+    X(sessiongroup_remove_session) \
+    X(sessiongroup_set_focus) \
+    X(sessiongroup_unset_focus) \
+    X(sessiongroup_reset_focus) \
+    X(sessiongroup_set_tx_session) \
+    X(sessiongroup_set_tx_all_sessions) \
+    X(sessiongroup_set_tx_no_session) \
+    X(session_create) \
+    X(session_media_connect) \
+    X(session_media_disconnect) \
+    X(session_terminate) \
+    X(session_mute_local_speaker) \
+    X(session_set_local_speaker_volume) \
+    X(session_set_local_render_volume) \
+    X(session_channel_invite_user) \
+    X(session_set_participant_volume_for_me) \
+    X(session_set_participant_mute_for_me) \
+    X(session_set_3d_position) \
+    X(session_set_voice_font) \
+    X(account_channel_add_acl) \
+    X(account_channel_remove_acl) \
+    X(account_channel_get_acl) \
+    X(channel_mute_user) \
+    X(channel_ban_user) \
+    X(channel_get_banned_users) \
+    X(channel_kick_user) \
+    X(channel_mute_all_users) \
+    X(connector_mute_local_mic) \
+    X(connector_mute_local_speaker) \
+    X(connector_set_local_mic_volume) \
+    X(connector_set_local_speaker_volume) \
+    X(connector_get_local_audio_info) \
+    X(account_buddy_set) \
+    X(account_buddy_delete) \
+    X(account_list_buddies_and_groups) \
+    X(session_send_message) \
+    X(account_set_presence) \
+    X(account_send_subscription_reply) \
+    X(session_send_notification) \
+    X(account_create_block_rule) \
+    X(account_delete_block_rule) \
+    X(account_list_block_rules) \
+    X(account_create_auto_accept_rule) \
+    X(account_delete_auto_accept_rule) \
+    X(account_list_auto_accept_rules) \
+    X(account_update_account) \
+    X(account_get_account) \
+    X(account_send_sms) \
+    X(aux_connectivity_info) \
+    X(aux_get_render_devices) \
+    X(aux_get_capture_devices) \
+    X(aux_set_render_device) \
+    X(aux_set_capture_device) \
+    X(aux_get_mic_level) \
+    X(aux_get_speaker_level) \
+    X(aux_set_mic_level) \
+    X(aux_set_speaker_level) \
+    X(aux_render_audio_start) \
+    X(aux_render_audio_stop) \
+    X(aux_capture_audio_start) \
+    X(aux_capture_audio_stop) \
+    X(aux_global_monitor_keyboard_mouse) \
+    X(aux_set_idle_timeout) \
+    X(aux_create_account) \
+    X(aux_reactivate_account) \
+    X(aux_deactivate_account) \
+    X(account_post_crash_dump) \
+    X(aux_reset_password) \
+    X(sessiongroup_set_session_3d_position) \
+    X(account_get_session_fonts) \
+    X(account_get_template_fonts) \
+    X(aux_start_buffer_capture) \
+    X(aux_play_audio_buffer) \
+    X(session_text_connect) \
+    X(session_text_disconnect) \
+    X(channel_set_lock_mode) \
+    X(aux_render_audio_modify) \
+    X(session_send_dtmf) \
+    X(aux_set_vad_properties) \
+    X(aux_get_vad_properties) \
+    X(sessiongroup_control_audio_injection) \
+    X(account_channel_change_owner) \
+    X(account_send_user_app_data) \
+    X(aux_diagnostic_state_dump) \
+    X(account_web_call) \
+    X(account_anonymous_login) \
+    X(account_authtoken_login) \
+    X(sessiongroup_get_stats) \
+    X(account_send_message) \
+    X(aux_notify_application_state_change) \
+    X(account_control_communications) \
+    X(session_archive_query) \
+    X(account_archive_query) \
+    X(session_transcription_control) \
+    X(aux_get_derumbler_properties) \
+    X(aux_set_derumbler_properties) \
+
+// X(name) for each event type with a vx_evt_name_t
+#define VX_SIM_EVENT_TYPES(X) \
+    X(account_login_state_change) \
+    X(buddy_presence) \
+    X(subscription) \
+    X(session_notification) \
+    X(message) \
+    X(aux_audio_properties) \
+    X(buddy_changed) \
+    X(buddy_group_changed) \
+    X(buddy_and_group_list_changed) \
+    X(keyboard_mouse) \
+    X(idle_state_changed) \
+    X(media_stream_updated) \
+    X(text_stream_updated) \
+    X(sessiongroup_added) \
+    X(sessiongroup_removed) \
+    X(session_added) \
+    X(session_removed) \
+    X(participant_added) \
+    X(participant_removed) \
+    X(participant_updated) \
+    X(sessiongroup_playback_frame_played) \
+    X(session_updated) \
+    X(sessiongroup_updated) \
+    X(media_completion) \
+    X(server_app_data) \
+    X(user_app_data) \
+    X(network_message) \
+    X(voice_service_connection_state_changed) \
+    X(publication_state_changed) \
+    X(audio_device_hot_swap) \
+    X(user_to_user_message) \
+    X(session_archive_message) \
+    X(session_archive_query_end) \
+    X(account_archive_message) \
+    X(account_archive_query_end) \
+    X(account_send_message_failed) \
+    X(transcribed_message) \
+    X(tts_injection_started) \
+    X(tts_injection_ended) \
+    X(tts_injection_failed) \
+
+// X(VX_E_name) for each error code, the first name of each value
+#define VX_SIM_ERROR_CODES(X) \
+    X(VX_E_NO_MESSAGE_AVAILABLE) \
+    X(VX_E_SUCCESS) \
+    X(VX_E_INVALID_XML) \
+    X(VX_E_NO_EXIST) \
+    X(VX_E_MAX_CONNECTOR_LIMIT_EXCEEDED) \
+    X(VX_E_MAX_SESSION_LIMIT_EXCEEDED) \
+    X(VX_E_FAILED) \
+    X(VX_E_ALREADY_LOGGED_IN) \
+    X(VX_E_ALREADY_LOGGED_OUT) \
+    X(VX_E_NOT_LOGGED_IN) \
+    X(VX_E_INVALID_ARGUMENT) \
+    X(VX_E_INVALID_USERNAME_OR_PASSWORD) \
+    X(VX_E_INSUFFICIENT_PRIVILEGE) \
+    X(VX_E_NO_SUCH_SESSION) \
+    X(VX_E_NOT_INITIALIZED) \
+    X(VX_E_REQUESTCONTEXT_NOT_FOUND) \
+    X(VX_E_LOGIN_FAILED) \
+    X(VX_E_SESSION_MAX) \
+    X(VX_E_WRONG_CONNECTOR) \
+    X(VX_E_NOT_IMPL) \
+    X(VX_E_REQUEST_CANCELLED) \
+    X(VX_E_INVALID_SESSION_STATE) \
+    X(VX_E_SESSION_CREATE_PENDING) \
+    X(VX_E_SESSION_TERMINATE_PENDING) \
+    X(VX_E_SESSION_CHANNEL_TEXT_DENIED) \
+    X(VX_E_SESSION_TEXT_DENIED) \
+    X(VX_E_SESSION_MESSAGE_BUILD_FAILED) \
+    X(VX_E_SESSION_MSG_CONTENT_TYPE_FAILED) \
+    X(VX_E_SESSION_MEDIA_CONNECT_FAILED) \
+    X(VX_E_SESSION_DOES_NOT_HAVE_TEXT) \
+    X(VX_E_SESSION_DOES_NOT_HAVE_AUDIO) \
+    X(VX_E_SESSION_MUST_HAVE_MEDIA) \
+    X(VX_E_SESSION_IS_NOT_3D) \
+    X(VX_E_SESSIONGROUP_NOT_FOUND) \
+    X(VX_E_REQUEST_TYPE_NOT_SUPPORTED) \
+    X(VX_E_REQUEST_NOT_SUPPORTED) \
+    X(VX_E_MULTI_CHANNEL_DENIED) \
+    X(VX_E_MEDIA_DISCONNECT_NOT_ALLOWED) \
+    X(VX_E_PRELOGIN_INFO_NOT_RETURNED) \
+    X(VX_E_SUBSCRIPTION_NOT_FOUND) \
+    X(VX_E_INVALID_SUBSCRIPTION_RULE_TYPE) \
+    X(VX_E_INVALID_MASK) \
+    X(VX_E_INVALID_CONNECTOR_STATE) \
+    X(VX_E_BUFSIZE) \
+    X(VX_E_FILE_OPEN_FAILED) \
+    X(VX_E_FILE_CORRUPT) \
+    X(VX_E_FILE_WRITE_FAILED) \
+    X(VX_E_INVALID_FILE_OPERATION) \
+    X(VX_E_NO_MORE_FRAMES) \
+    X(VX_E_UNEXPECTED_END_OF_FILE) \
+    X(VX_E_FILE_WRITE_FAILED_REACHED_MAX_FILESIZE) \
+    X(VX_E_TERMINATESESSION_NOT_VALID) \
+    X(VX_E_MAX_PLAYBACK_SESSIONGROUPS_EXCEEDED) \
+    X(VX_E_TEXT_DISCONNECT_NOT_ALLOWED) \
+    X(VX_E_TEXT_CONNECT_NOT_ALLOWED) \
+    X(VX_E_SESSION_TEXT_DISABLED) \
+    X(VX_E_SESSIONGROUP_TRANSMIT_NOT_ALLOWED) \
+    X(VX_E_CALL_CREATION_FAILED) \
+    X(VX_E_RTP_TIMEOUT) \
+    X(VX_E_ACCOUNT_MISCONFIGURED) \
+    X(VX_E_MAXIMUM_NUMBER_OF_CALLS_EXCEEEDED) \
+    X(VX_E_NO_SESSION_PORTS_AVAILABLE) \
+    X(VX_E_INVALID_MEDIA_FORMAT) \
+    X(VX_E_INVALID_CODEC_TYPE) \
+    X(VX_E_RENDER_DEVICE_DOES_NOT_EXIST) \
+    X(VX_E_RENDER_CONTEXT_DOES_NOT_EXIST) \
+    X(VX_E_RENDER_SOURCE_DOES_NOT_EXIST) \
+    X(VX_E_RECORDING_ALREADY_ACTIVE) \
+    X(VX_E_RECORDING_LOOP_BUFFER_EMPTY) \
+    X(VX_E_STREAM_READ_FAILED) \
+    X(VX_E_INVALID_SDK_HANDLE) \
+    X(VX_E_FAILED_TO_CONNECT_TO_VOICE_SERVICE) \
+    X(VX_E_FAILED_TO_SEND_REQUEST_TO_VOICE_SERVICE) \
+    X(VX_E_MAX_LOGINS_PER_USER_EXCEEDED) \
+    X(VX_E_MAX_HTTP_DATA_RESPONSE_SIZE_EXCEEDED) \
+    X(VX_E_CHANNEL_URI_REQUIRED) \
+    X(VX_E_INVALID_CAPTURE_DEVICE_FOR_REQUESTED_OPERATION) \
+    X(VX_E_LOOP_MODE_RECORDING_NOT_ENABLED) \
+    X(VX_E_TEXT_DISABLED) \
+    X(VX_E_VOICE_FONT_NOT_FOUND) \
+    X(VX_E_CROSS_DOMAIN_LOGINS_DISABLED) \
+    X(VX_E_INVALID_AUTH_TOKEN) \
+    X(VX_E_INVALID_APP_TOKEN) \
+    X(VX_E_CAPACITY_EXCEEDED) \
+    X(VX_E_ALREADY_INITIALIZED) \
+    X(VX_E_NOT_UNINITIALIZED_YET) \
+    X(VX_E_NETWORK_ADDRESS_CHANGE) \
+    X(VX_E_NETWORK_DOWN) \
+    X(VX_E_POWER_STATE_CHANGE) \
+    X(VX_E_HANDLE_ALREADY_TAKEN) \
+    X(VX_E_HANDLE_IS_RESERVED) \
+    X(VX_E_XNETCONNECT_FAILED) \
+    X(VX_E_REQUEST_CANCELED) \
+    X(VX_E_CALL_TERMINATED_NO_RTP_RXED) \
+    X(VX_E_CALL_TERMINATED_NO_ANSWER_LOCAL) \
+    X(VX_E_CHANNEL_URI_TOO_LONG) \
+    X(VX_E_CALL_TERMINATED_BAN) \
+    X(VX_E_CALL_TERMINATED_KICK) \
+    X(VX_E_CALL_TERMINATED_BY_SERVER) \
+    X(VX_E_ALREADY_EXIST) \
+    X(VX_E_FEATURE_DISABLED) \
+    X(VX_E_SIZE_LIMIT_EXCEEDED) \
+    X(VX_E_RTP_SESSION_SOCKET_ERROR) \
+    X(VX_E_SIP_BACKEND_REQUIRED) \
+    X(VX_E_DEPRECATED) \
+    X(VX_E_NO_RENDER_DEVICES_FOUND) \
+    X(VX_E_NO_CAPTURE_DEVICES_FOUND) \
+    X(VX_E_INVALID_RENDER_DEVICE_SPECIFIER) \
+    X(VX_E_RENDER_DEVICE_IN_USE) \
+    X(VX_E_INVALID_CAPTURE_DEVICE_SPECIFIER) \
+    X(VX_E_CAPTURE_DEVICE_IN_USE) \
+    X(VX_E_UNABLE_TO_OPEN_CAPTURE_DEVICE) \
+    X(VX_E_FAILED_TO_CONNECT_TO_SERVER) \
+    X(VX_E_ACCESSTOKEN_ALREADY_USED) \
+    X(VX_E_ACCESSTOKEN_EXPIRED) \
+    X(VX_E_ACCESSTOKEN_INVALID_SIGNATURE) \
+    X(VX_E_ACCESSTOKEN_CLAIMS_MISMATCH) \
+    X(VX_E_ACCESSTOKEN_MALFORMED) \
+    X(VX_E_ACCESSTOKEN_INTERNAL_ERROR) \
+    X(VX_E_ACCESSTOKEN_SERVICE_UNAVAILABLE) \
+    X(VX_E_ACCESSTOKEN_ISSUER_MISMATCH) \
+
+// F(Kind, field) for the string and number fields of each message, Kind being String, Int,
+// Unsigned or Double
+#define VX_SIM_REQ_FIELDS_connector_create(F) \
+    F(String, client_name) \
+    F(String, acct_mgmt_server) \
+    F(Int, minimum_port) \
+    F(Int, maximum_port) \
+    F(Int, attempt_stun) \
+    F(Int, mode) \
+    F(String, log_folder) \
+    F(String, log_filename_prefix) \
+    F(String, log_filename_suffix) \
+    F(Int, log_level) \
+    F(Int, session_handle_type) \
+    F(String, application) \
+    F(Int, max_calls) \
+    F(Int, allow_cross_domain_logins) \
+    F(Int, default_codec) \
+    F(String, user_agent_id) \
+    F(String, media_probe_server) \
+    F(String, http_proxy_server_name) \
+    F(Int, http_proxy_server_port) \
+    F(Int, enable_duplicate_participant_uris) \
+    F(String, connector_handle) \
+    F(Unsigned, configured_codecs) \
+
+#define VX_SIM_REQ_FIELDS_connector_initiate_shutdown(F) \
+    F(String, connector_handle) \
+    F(String, client_name) \
+
+#define VX_SIM_REQ_FIELDS_account_login(F) \
+    F(String, connector_handle) \
+    F(String, acct_name) \
+    F(String, acct_password) \
+    F(Int, answer_mode) \
+    F(Int, enable_text) \
+    F(Int, participant_property_frequency) \
+    F(Int, enable_buddies_and_presence) \
+    F(Int, buddy_management_mode) \
+    F(Int, enable_client_ringback) \
+    F(Int, autopost_crash_dumps) \
+    F(String, acct_mgmt_server) \
+    F(String, application_token) \
+    F(String, application_override) \
+    F(String, client_ip_override) \
+    F(Int, enable_presence_persistence) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_account_logout(F) \
+    F(String, account_handle) \
+    F(String, logout_reason) \
+
+#define VX_SIM_REQ_FIELDS_account_set_login_properties(F) \
+    F(String, account_handle) \
+    F(Int, answer_mode) \
+    F(Int, participant_property_frequency) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_create(F) \
+    F(String, account_handle) \
+    F(Int, type) \
+    F(Int, loop_mode_duration_seconds) \
+    F(String, capture_device_id) \
+    F(String, render_device_id) \
+    F(String, alias_username) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_terminate(F) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_add_session(F) \
+    F(String, sessiongroup_handle) \
+    F(String, uri) \
+    F(String, name) \
+    F(String, password) \
+    F(Int, connect_audio) \
+    F(Int, password_hash_algorithm) \
+    F(Int, session_font_id) \
+    F(Int, connect_text) \
+    F(Int, jitter_compensation) \
+    F(String, session_handle) \
+    F(String, access_token) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_remove_session(F) \
+    F(String, session_handle) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_set_focus(F) \
+    F(String, session_handle) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_unset_focus(F) \
+    F(String, session_handle) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_reset_focus(F) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_set_tx_session(F) \
+    F(String, session_handle) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_set_tx_all_sessions(F) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_set_tx_no_session(F) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_session_create(F) \
+    F(String, account_handle) \
+    F(String, name) \
+    F(String, uri) \
+    F(String, password) \
+    F(Int, connect_audio) \
+    F(Int, join_audio) \
+    F(Int, join_text) \
+    F(Int, password_hash_algorithm) \
+    F(Int, connect_text) \
+    F(Int, session_font_id) \
+    F(Int, jitter_compensation) \
+    F(String, alias_username) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, access_token) \
+
+#define VX_SIM_REQ_FIELDS_session_media_connect(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(Int, session_font_id) \
+    F(Int, media) \
+    F(String, capture_device_id) \
+    F(String, render_device_id) \
+    F(Int, jitter_compensation) \
+    F(Int, loop_mode_duration_seconds) \
+
+#define VX_SIM_REQ_FIELDS_session_media_disconnect(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(Int, media) \
+    F(Int, termination_status) \
+
+#define VX_SIM_REQ_FIELDS_session_terminate(F) \
+    F(String, session_handle) \
+
+#define VX_SIM_REQ_FIELDS_session_mute_local_speaker(F) \
+    F(String, session_handle) \
+    F(Int, mute_level) \
+    F(Int, scope) \
+
+#define VX_SIM_REQ_FIELDS_session_set_local_speaker_volume(F) \
+    F(String, session_handle) \
+    F(Int, volume) \
+
+#define VX_SIM_REQ_FIELDS_session_set_local_render_volume(F) \
+    F(String, session_handle) \
+    F(Int, volume) \
+
+#define VX_SIM_REQ_FIELDS_session_channel_invite_user(F) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+
+#define VX_SIM_REQ_FIELDS_session_set_participant_volume_for_me(F) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+    F(Int, volume) \
+
+#define VX_SIM_REQ_FIELDS_session_set_participant_mute_for_me(F) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+    F(Int, mute) \
+    F(Int, scope) \
+
+#define VX_SIM_REQ_FIELDS_session_set_3d_position(F) \
+    F(String, session_handle) \
+    F(Int, type) \
+    F(Int, req_disposition_type) \
+
+#define VX_SIM_REQ_FIELDS_session_set_voice_font(F) \
+    F(String, session_handle) \
+    F(Int, session_font_id) \
+
+#define VX_SIM_REQ_FIELDS_account_channel_add_acl(F) \
+    F(String, account_handle) \
+    F(String, channel_uri) \
+    F(String, acl_uri) \
+
+#define VX_SIM_REQ_FIELDS_account_channel_remove_acl(F) \
+    F(String, account_handle) \
+    F(String, channel_uri) \
+    F(String, acl_uri) \
+
+#define VX_SIM_REQ_FIELDS_account_channel_get_acl(F) \
+    F(String, account_handle) \
+    F(String, channel_uri) \
+
+#define VX_SIM_REQ_FIELDS_channel_mute_user(F) \
+    F(String, account_handle) \
+    F(String, channel_name) \
+    F(String, channel_uri) \
+    F(String, participant_uri) \
+    F(Int, set_muted) \
+    F(Int, scope) \
+    F(String, access_token) \
+
+#define VX_SIM_REQ_FIELDS_channel_ban_user(F) \
+    F(String, account_handle) \
+    F(String, channel_name) \
+    F(String, channel_uri) \
+    F(String, participant_uri) \
+    F(Int, set_banned) \
+
+#define VX_SIM_REQ_FIELDS_channel_get_banned_users(F) \
+    F(String, account_handle) \
+    F(String, channel_uri) \
+
+#define VX_SIM_REQ_FIELDS_channel_kick_user(F) \
+    F(String, account_handle) \
+    F(String, channel_name) \
+    F(String, channel_uri) \
+    F(String, participant_uri) \
+    F(String, access_token) \
+
+#define VX_SIM_REQ_FIELDS_channel_mute_all_users(F) \
+    F(String, account_handle) \
+    F(String, channel_name) \
+    F(String, channel_uri) \
+    F(Int, set_muted) \
+    F(Int, scope) \
+    F(String, access_token) \
+
+#define VX_SIM_REQ_FIELDS_connector_mute_local_mic(F) \
+    F(String, connector_handle) \
+    F(Int, mute_level) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_connector_mute_local_speaker(F) \
+    F(String, connector_handle) \
+    F(Int, mute_level) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_connector_set_local_mic_volume(F) \
+    F(String, connector_handle) \
+    F(Int, volume) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_connector_set_local_speaker_volume(F) \
+    F(String, connector_handle) \
+    F(Int, volume) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_connector_get_local_audio_info(F) \
+    F(String, connector_handle) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_account_buddy_set(F) \
+    F(String, account_handle) \
+    F(String, buddy_uri) \
+    F(String, display_name) \
+    F(String, buddy_data) \
+    F(Int, group_id) \
+    F(String, message) \
+
+#define VX_SIM_REQ_FIELDS_account_buddy_delete(F) \
+    F(String, account_handle) \
+    F(String, buddy_uri) \
+
+#define VX_SIM_REQ_FIELDS_account_list_buddies_and_groups(F) \
+    F(String, account_handle) \
+    F(Int, refresh) \
+
+#define VX_SIM_REQ_FIELDS_session_send_message(F) \
+    F(String, session_handle) \
+    F(String, message_header) \
+    F(String, message_body) \
+    F(String, language) \
+    F(String, application_stanza_namespace) \
+    F(String, application_stanza_body) \
+
+#define VX_SIM_REQ_FIELDS_account_set_presence(F) \
+    F(String, account_handle) \
+    F(Int, presence) \
+    F(String, custom_message) \
+    F(String, alias_username) \
+
+#define VX_SIM_REQ_FIELDS_account_send_subscription_reply(F) \
+    F(String, account_handle) \
+    F(Int, rule_type) \
+    F(Int, auto_accept) \
+    F(String, buddy_uri) \
+    F(String, subscription_handle) \
+
+#define VX_SIM_REQ_FIELDS_session_send_notification(F) \
+    F(String, session_handle) \
+    F(Int, notification_type) \
+
+#define VX_SIM_REQ_FIELDS_account_create_block_rule(F) \
+    F(String, account_handle) \
+    F(String, block_mask) \
+    F(Int, presence_only) \
+
+#define VX_SIM_REQ_FIELDS_account_delete_block_rule(F) \
+    F(String, account_handle) \
+    F(String, block_mask) \
+
+#define VX_SIM_REQ_FIELDS_account_list_block_rules(F) \
+    F(String, account_handle) \
+    F(Int, refresh) \
+
+#define VX_SIM_REQ_FIELDS_account_create_auto_accept_rule(F) \
+    F(String, account_handle) \
+    F(String, auto_accept_mask) \
+    F(Int, auto_add_as_buddy) \
+    F(String, auto_accept_nickname) \
+
+#define VX_SIM_REQ_FIELDS_account_delete_auto_accept_rule(F) \
+    F(String, account_handle) \
+    F(String, auto_accept_mask) \
+
+#define VX_SIM_REQ_FIELDS_account_list_auto_accept_rules(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_account_update_account(F) \
+    F(String, account_handle) \
+    F(String, displayname) \
+
+#define VX_SIM_REQ_FIELDS_account_get_account(F) \
+    F(String, account_handle) \
+    F(String, uri) \
+
+#define VX_SIM_REQ_FIELDS_account_send_sms(F) \
+    F(String, account_handle) \
+    F(String, recipient_uri) \
+    F(String, content) \
+
+#define VX_SIM_REQ_FIELDS_aux_connectivity_info(F) \
+    F(String, well_known_ip) \
+    F(String, stun_server) \
+    F(String, echo_server) \
+    F(Int, echo_port) \
+    F(Int, timeout) \
+    F(String, acct_mgmt_server) \
+
+#define VX_SIM_REQ_FIELDS_aux_get_render_devices(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_get_capture_devices(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_set_render_device(F) \
+    F(String, render_device_specifier) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_set_capture_device(F) \
+    F(String, capture_device_specifier) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_get_mic_level(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_get_speaker_level(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_set_mic_level(F) \
+    F(Int, level) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_set_speaker_level(F) \
+    F(Int, level) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_render_audio_start(F) \
+    F(String, sound_file_path) \
+    F(Int, loop) \
+    F(String, path) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_render_audio_stop(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_capture_audio_start(F) \
+    F(Int, duration) \
+    F(Int, loop_to_render_device) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_capture_audio_stop(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_global_monitor_keyboard_mouse(F) \
+    F(String, name) \
+    F(Int, code_count) \
+
+#define VX_SIM_REQ_FIELDS_aux_set_idle_timeout(F) \
+    F(Int, seconds) \
+
+#define VX_SIM_REQ_FIELDS_aux_create_account(F) \
+    F(String, user_name) \
+    F(String, password) \
+    F(String, email) \
+    F(String, number) \
+    F(String, displayname) \
+    F(String, firstname) \
+    F(String, lastname) \
+    F(String, phone) \
+    F(String, lang) \
+    F(String, age) \
+    F(String, gender) \
+    F(String, timezone) \
+    F(String, ext_profile) \
+    F(String, ext_id) \
+
+#define VX_SIM_REQ_FIELDS_aux_reactivate_account(F) \
+    F(String, user_name) \
+
+#define VX_SIM_REQ_FIELDS_aux_deactivate_account(F) \
+    F(String, user_name) \
+
+#define VX_SIM_REQ_FIELDS_account_post_crash_dump(F) \
+    F(String, account_handle) \
+    F(String, crash_dump) \
+
+#define VX_SIM_REQ_FIELDS_aux_reset_password(F) \
+    F(String, user_uri) \
+    F(String, user_email) \
+    F(String, server_url) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_set_session_3d_position(F) \
+    F(String, session_handle) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_REQ_FIELDS_account_get_session_fonts(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_account_get_template_fonts(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_start_buffer_capture(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_play_audio_buffer(F) \
+    F(String, account_handle) \
+    F(Int, template_font_id) \
+    F(String, font_delta) \
+
+#define VX_SIM_REQ_FIELDS_session_text_connect(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+
+#define VX_SIM_REQ_FIELDS_session_text_disconnect(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+
+#define VX_SIM_REQ_FIELDS_channel_set_lock_mode(F) \
+    F(String, account_handle) \
+    F(String, channel_uri) \
+    F(Int, lock_mode) \
+
+#define VX_SIM_REQ_FIELDS_aux_render_audio_modify(F) \
+    F(String, font_str) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_session_send_dtmf(F) \
+    F(String, session_handle) \
+    F(Int, dtmf_type) \
+
+#define VX_SIM_REQ_FIELDS_aux_set_vad_properties(F) \
+    F(Int, vad_hangover) \
+    F(Int, vad_sensitivity) \
+    F(Int, vad_noise_floor) \
+    F(Int, vad_auto) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_get_vad_properties(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_control_audio_injection(F) \
+    F(Int, audio_injection_control_type) \
+    F(String, sessiongroup_handle) \
+    F(String, filename) \
+
+#define VX_SIM_REQ_FIELDS_account_channel_change_owner(F) \
+    F(String, account_handle) \
+    F(String, channel_uri) \
+    F(String, new_owner_uri) \
+
+#define VX_SIM_REQ_FIELDS_account_send_user_app_data(F) \
+    F(String, account_handle) \
+    F(String, to_uri) \
+    F(String, content_type) \
+    F(String, content) \
+
+#define VX_SIM_REQ_FIELDS_aux_diagnostic_state_dump(F) \
+    F(Int, level) \
+
+#define VX_SIM_REQ_FIELDS_account_web_call(F) \
+    F(String, account_handle) \
+    F(String, relative_path) \
+    F(Int, parameter_count) \
+
+#define VX_SIM_REQ_FIELDS_account_anonymous_login(F) \
+    F(String, connector_handle) \
+    F(String, displayname) \
+    F(Int, participant_property_frequency) \
+    F(Int, enable_buddies_and_presence) \
+    F(Int, buddy_management_mode) \
+    F(Int, autopost_crash_dumps) \
+    F(String, acct_mgmt_server) \
+    F(String, application_token) \
+    F(String, application_override) \
+    F(String, client_ip_override) \
+    F(Int, enable_presence_persistence) \
+    F(String, account_handle) \
+    F(String, acct_name) \
+    F(String, access_token) \
+    F(String, languages) \
+
+#define VX_SIM_REQ_FIELDS_account_authtoken_login(F) \
+    F(String, connector_handle) \
+    F(String, authtoken) \
+    F(Int, enable_text) \
+    F(Int, participant_property_frequency) \
+    F(Int, enable_buddies_and_presence) \
+    F(Int, buddy_management_mode) \
+    F(Int, autopost_crash_dumps) \
+    F(String, acct_mgmt_server) \
+    F(String, application_token) \
+    F(String, application_override) \
+    F(Int, answer_mode) \
+    F(String, client_ip_override) \
+    F(Int, enable_presence_persistence) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_sessiongroup_get_stats(F) \
+    F(String, sessiongroup_handle) \
+    F(Int, reset_stats) \
+
+#define VX_SIM_REQ_FIELDS_account_send_message(F) \
+    F(String, account_handle) \
+    F(String, user_uri) \
+    F(String, message_header) \
+    F(String, message_body) \
+    F(String, alias_username) \
+    F(String, language) \
+    F(String, application_stanza_namespace) \
+    F(String, application_stanza_body) \
+
+#define VX_SIM_REQ_FIELDS_aux_notify_application_state_change(F) \
+    F(Int, notification_type) \
+
+#define VX_SIM_REQ_FIELDS_account_control_communications(F) \
+    F(String, account_handle) \
+    F(Int, operation) \
+    F(String, user_uris) \
+    F(Int, scope) \
+
+#define VX_SIM_REQ_FIELDS_session_archive_query(F) \
+    F(String, session_handle) \
+    F(String, time_start) \
+    F(String, time_end) \
+    F(String, search_text) \
+    F(String, participant_uri) \
+    F(Unsigned, max) \
+    F(String, before_id) \
+    F(String, after_id) \
+    F(Int, first_message_index) \
+    F(String, application_stanza_namespace) \
+    F(String, application_stanza_body) \
+
+#define VX_SIM_REQ_FIELDS_account_archive_query(F) \
+    F(String, account_handle) \
+    F(String, time_start) \
+    F(String, time_end) \
+    F(String, search_text) \
+    F(String, channel_uri) \
+    F(String, participant_uri) \
+    F(Unsigned, max) \
+    F(String, before_id) \
+    F(String, after_id) \
+    F(Int, first_message_index) \
+    F(String, application_stanza_namespace) \
+    F(String, application_stanza_body) \
+
+#define VX_SIM_REQ_FIELDS_session_transcription_control(F) \
+    F(String, session_handle) \
+    F(Int, enable) \
+    F(String, access_token) \
+
+#define VX_SIM_REQ_FIELDS_aux_get_derumbler_properties(F) \
+    F(String, account_handle) \
+
+#define VX_SIM_REQ_FIELDS_aux_set_derumbler_properties(F) \
+    F(Int, enabled) \
+    F(Int, stopband_corner_frequency) \
+    F(String, account_handle) \
+
+#define VX_SIM_RESP_FIELDS_connector_create(F) \
+    F(String, connector_handle) \
+    F(String, version_id) \
+    F(Int, backend_type) \
+
+#define VX_SIM_RESP_FIELDS_connector_initiate_shutdown(F) \
+    F(String, client_name) \
+
+#define VX_SIM_RESP_FIELDS_account_login(F) \
+    F(String, account_handle) \
+    F(Int, account_id) \
+    F(String, display_name) \
+    F(String, uri) \
+    F(Int, num_aliases) \
+    F(String, buddy_list_uri) \
+    F(String, encoded_uri_with_tag) \
+
+#define VX_SIM_RESP_FIELDS_account_logout(F) \
+
+#define VX_SIM_RESP_FIELDS_account_set_login_properties(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_create(F) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_terminate(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_add_session(F) \
+    F(String, session_handle) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_remove_session(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_set_focus(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_unset_focus(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_reset_focus(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_set_tx_session(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_set_tx_all_sessions(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_set_tx_no_session(F) \
+
+#define VX_SIM_RESP_FIELDS_session_create(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+
+#define VX_SIM_RESP_FIELDS_session_media_connect(F) \
+
+#define VX_SIM_RESP_FIELDS_session_media_disconnect(F) \
+
+#define VX_SIM_RESP_FIELDS_session_terminate(F) \
+
+#define VX_SIM_RESP_FIELDS_session_mute_local_speaker(F) \
+
+#define VX_SIM_RESP_FIELDS_session_set_local_speaker_volume(F) \
+
+#define VX_SIM_RESP_FIELDS_session_set_local_render_volume(F) \
+
+#define VX_SIM_RESP_FIELDS_session_channel_invite_user(F) \
+
+#define VX_SIM_RESP_FIELDS_session_set_participant_volume_for_me(F) \
+
+#define VX_SIM_RESP_FIELDS_session_set_participant_mute_for_me(F) \
+
+#define VX_SIM_RESP_FIELDS_session_set_3d_position(F) \
+
+#define VX_SIM_RESP_FIELDS_session_set_voice_font(F) \
+
+#define VX_SIM_RESP_FIELDS_account_channel_add_acl(F) \
+
+#define VX_SIM_RESP_FIELDS_account_channel_remove_acl(F) \
+
+#define VX_SIM_RESP_FIELDS_account_channel_get_acl(F) \
+    F(Int, participants_size) \
+
+#define VX_SIM_RESP_FIELDS_channel_mute_user(F) \
+
+#define VX_SIM_RESP_FIELDS_channel_ban_user(F) \
+
+#define VX_SIM_RESP_FIELDS_channel_get_banned_users(F) \
+    F(Int, banned_users_count) \
+
+#define VX_SIM_RESP_FIELDS_channel_kick_user(F) \
+
+#define VX_SIM_RESP_FIELDS_channel_mute_all_users(F) \
+
+#define VX_SIM_RESP_FIELDS_connector_mute_local_mic(F) \
+
+#define VX_SIM_RESP_FIELDS_connector_mute_local_speaker(F) \
+
+#define VX_SIM_RESP_FIELDS_connector_set_local_mic_volume(F) \
+
+#define VX_SIM_RESP_FIELDS_connector_set_local_speaker_volume(F) \
+
+#define VX_SIM_RESP_FIELDS_connector_get_local_audio_info(F) \
+    F(Int, speaker_volume) \
+    F(Int, is_speaker_muted) \
+    F(Int, mic_volume) \
+    F(Int, is_mic_muted) \
+
+#define VX_SIM_RESP_FIELDS_account_buddy_set(F) \
+    F(Int, account_id) \
+
+#define VX_SIM_RESP_FIELDS_account_buddy_delete(F) \
+
+#define VX_SIM_RESP_FIELDS_account_list_buddies_and_groups(F) \
+    F(Int, buddy_count) \
+    F(Int, group_count) \
+
+#define VX_SIM_RESP_FIELDS_session_send_message(F) \
+
+#define VX_SIM_RESP_FIELDS_account_set_presence(F) \
+
+#define VX_SIM_RESP_FIELDS_account_send_subscription_reply(F) \
+
+#define VX_SIM_RESP_FIELDS_session_send_notification(F) \
+
+#define VX_SIM_RESP_FIELDS_account_create_block_rule(F) \
+
+#define VX_SIM_RESP_FIELDS_account_delete_block_rule(F) \
+
+#define VX_SIM_RESP_FIELDS_account_list_block_rules(F) \
+    F(Int, rule_count) \
+
+#define VX_SIM_RESP_FIELDS_account_create_auto_accept_rule(F) \
+
+#define VX_SIM_RESP_FIELDS_account_delete_auto_accept_rule(F) \
+
+#define VX_SIM_RESP_FIELDS_account_list_auto_accept_rules(F) \
+    F(Int, rule_count) \
+
+#define VX_SIM_RESP_FIELDS_account_update_account(F) \
+
+#define VX_SIM_RESP_FIELDS_account_get_account(F) \
+
+#define VX_SIM_RESP_FIELDS_account_send_sms(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_connectivity_info(F) \
+    F(Int, count) \
+    F(String, well_known_ip) \
+    F(String, stun_server) \
+    F(String, echo_server) \
+    F(Int, echo_port) \
+    F(Int, timeout) \
+    F(Int, first_sip_port) \
+    F(Int, second_sip_port) \
+    F(Int, rtp_port) \
+    F(Int, rtcp_port) \
+
+#define VX_SIM_RESP_FIELDS_aux_get_render_devices(F) \
+    F(Int, count) \
+
+#define VX_SIM_RESP_FIELDS_aux_get_capture_devices(F) \
+    F(Int, count) \
+
+#define VX_SIM_RESP_FIELDS_aux_set_render_device(F) \
+    F(String, open_render_device_guid) \
+
+#define VX_SIM_RESP_FIELDS_aux_set_capture_device(F) \
+    F(String, open_capture_device_guid) \
+
+#define VX_SIM_RESP_FIELDS_aux_get_mic_level(F) \
+    F(Int, level) \
+
+#define VX_SIM_RESP_FIELDS_aux_get_speaker_level(F) \
+    F(Int, level) \
+
+#define VX_SIM_RESP_FIELDS_aux_set_mic_level(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_set_speaker_level(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_render_audio_start(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_render_audio_stop(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_capture_audio_start(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_capture_audio_stop(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_global_monitor_keyboard_mouse(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_set_idle_timeout(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_create_account(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_reactivate_account(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_deactivate_account(F) \
+
+#define VX_SIM_RESP_FIELDS_account_post_crash_dump(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_reset_password(F) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_set_session_3d_position(F) \
+
+#define VX_SIM_RESP_FIELDS_account_get_session_fonts(F) \
+    F(Int, session_font_count) \
+
+#define VX_SIM_RESP_FIELDS_account_get_template_fonts(F) \
+    F(Int, template_font_count) \
+
+#define VX_SIM_RESP_FIELDS_aux_start_buffer_capture(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_play_audio_buffer(F) \
+
+#define VX_SIM_RESP_FIELDS_session_text_connect(F) \
+
+#define VX_SIM_RESP_FIELDS_session_text_disconnect(F) \
+
+#define VX_SIM_RESP_FIELDS_channel_set_lock_mode(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_render_audio_modify(F) \
+
+#define VX_SIM_RESP_FIELDS_session_send_dtmf(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_set_vad_properties(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_get_vad_properties(F) \
+    F(Int, vad_hangover) \
+    F(Int, vad_sensitivity) \
+    F(Int, vad_noise_floor) \
+    F(Int, vad_auto) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_control_audio_injection(F) \
+
+#define VX_SIM_RESP_FIELDS_account_channel_change_owner(F) \
+
+#define VX_SIM_RESP_FIELDS_account_send_user_app_data(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_diagnostic_state_dump(F) \
+    F(Int, state_connector_count) \
+
+#define VX_SIM_RESP_FIELDS_account_web_call(F) \
+    F(String, content_type) \
+    F(Int, content_length) \
+    F(String, content) \
+
+#define VX_SIM_RESP_FIELDS_account_anonymous_login(F) \
+    F(String, account_handle) \
+    F(Int, account_id) \
+    F(String, displayname) \
+    F(String, uri) \
+    F(String, encoded_uri_with_tag) \
+
+#define VX_SIM_RESP_FIELDS_account_authtoken_login(F) \
+    F(String, account_handle) \
+    F(Int, account_id) \
+    F(String, user_name) \
+    F(String, display_name) \
+    F(String, uri) \
+    F(Int, num_aliases) \
+    F(String, buddy_list_uri) \
+    F(String, encoded_uri_with_tag) \
+
+#define VX_SIM_RESP_FIELDS_sessiongroup_get_stats(F) \
+    F(Int, insufficient_bandwidth) \
+    F(Int, min_bars) \
+    F(Int, max_bars) \
+    F(Int, current_bars) \
+    F(Int, pk_loss) \
+    F(Int, incoming_received) \
+    F(Int, incoming_expected) \
+    F(Int, incoming_packetloss) \
+    F(Int, incoming_out_of_time) \
+    F(Int, incoming_discarded) \
+    F(Int, outgoing_sent) \
+    F(Int, render_device_underruns) \
+    F(Int, render_device_overruns) \
+    F(Int, render_device_errors) \
+    F(String, call_id) \
+    F(Int, plc_on) \
+    F(Int, plc_synthetic_frames) \
+    F(String, codec_name) \
+    F(Int, codec_mode) \
+    F(Double, min_latency) \
+    F(Double, max_latency) \
+    F(Int, latency_measurement_count) \
+    F(Double, latency_sum) \
+    F(Double, last_latency_measured) \
+    F(Int, latency_packets_lost) \
+    F(Double, r_factor) \
+    F(Int, latency_packets_sent) \
+    F(Int, latency_packets_dropped) \
+    F(Int, latency_packets_malformed) \
+    F(Int, latency_packets_negative_latency) \
+    F(Double, sample_interval_begin) \
+    F(Double, sample_interval_end) \
+    F(Int, current_opus_bit_rate) \
+    F(Int, current_opus_complexity) \
+    F(Int, current_opus_vbr_mode) \
+    F(Int, current_opus_bandwidth) \
+    F(Int, current_opus_max_packet_size) \
+    F(Int, signal_secure) \
+
+#define VX_SIM_RESP_FIELDS_account_send_message(F) \
+    F(String, request_id) \
+
+#define VX_SIM_RESP_FIELDS_aux_notify_application_state_change(F) \
+
+#define VX_SIM_RESP_FIELDS_account_control_communications(F) \
+    F(String, blocked_uris) \
+
+#define VX_SIM_RESP_FIELDS_session_archive_query(F) \
+    F(String, query_id) \
+
+#define VX_SIM_RESP_FIELDS_account_archive_query(F) \
+    F(String, query_id) \
+
+#define VX_SIM_RESP_FIELDS_session_transcription_control(F) \
+
+#define VX_SIM_RESP_FIELDS_aux_get_derumbler_properties(F) \
+    F(Int, enabled) \
+    F(Int, stopband_corner_frequency) \
+
+#define VX_SIM_RESP_FIELDS_aux_set_derumbler_properties(F) \
+
+#define VX_SIM_EVT_FIELDS_account_login_state_change(F) \
+    F(Int, state) \
+    F(String, account_handle) \
+    F(Int, status_code) \
+    F(String, status_string) \
+    F(String, cookie) \
+
+#define VX_SIM_EVT_FIELDS_buddy_presence(F) \
+    F(Int, state) \
+    F(String, account_handle) \
+    F(String, buddy_uri) \
+    F(Int, presence) \
+    F(String, custom_message) \
+    F(String, displayname) \
+    F(String, application) \
+    F(String, contact) \
+    F(String, priority) \
+    F(String, id) \
+    F(String, encoded_uri_with_tag) \
+
+#define VX_SIM_EVT_FIELDS_subscription(F) \
+    F(String, account_handle) \
+    F(String, buddy_uri) \
+    F(String, subscription_handle) \
+    F(Int, subscription_type) \
+    F(String, displayname) \
+    F(String, application) \
+    F(String, message) \
+
+#define VX_SIM_EVT_FIELDS_session_notification(F) \
+    F(Int, state) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+    F(Int, notification_type) \
+    F(String, encoded_uri_with_tag) \
+    F(Int, is_current_user) \
+
+#define VX_SIM_EVT_FIELDS_message(F) \
+    F(Int, state) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+    F(String, message_header) \
+    F(String, message_body) \
+    F(String, participant_displayname) \
+    F(String, application) \
+    F(String, alias_username) \
+    F(String, encoded_uri_with_tag) \
+    F(Int, is_current_user) \
+    F(String, language) \
+    F(String, application_stanza_namespace) \
+    F(String, application_stanza_body) \
+
+#define VX_SIM_EVT_FIELDS_aux_audio_properties(F) \
+    F(Int, state) \
+    F(Int, mic_is_active) \
+    F(Int, mic_volume) \
+    F(Double, mic_energy) \
+    F(Int, speaker_volume) \
+    F(Double, speaker_energy) \
+    F(Int, speaker_is_active) \
+    F(Double, fast_energy_meter) \
+    F(Double, noise_floor_meter) \
+    F(Double, speech_threshold_meter) \
+
+#define VX_SIM_EVT_FIELDS_buddy_changed(F) \
+    F(String, account_handle) \
+    F(Int, change_type) \
+    F(String, buddy_uri) \
+    F(String, display_name) \
+    F(String, buddy_data) \
+    F(Int, group_id) \
+    F(Int, account_id) \
+
+#define VX_SIM_EVT_FIELDS_buddy_group_changed(F) \
+    F(String, account_handle) \
+    F(Int, change_type) \
+    F(Int, group_id) \
+    F(String, group_name) \
+    F(String, group_data) \
+
+#define VX_SIM_EVT_FIELDS_buddy_and_group_list_changed(F) \
+    F(String, account_handle) \
+    F(Int, buddy_count) \
+    F(Int, group_count) \
+
+#define VX_SIM_EVT_FIELDS_keyboard_mouse(F) \
+    F(String, name) \
+    F(Int, is_down) \
+
+#define VX_SIM_EVT_FIELDS_idle_state_changed(F) \
+    F(Int, is_idle) \
+
+#define VX_SIM_EVT_FIELDS_media_stream_updated(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(Int, status_code) \
+    F(String, status_string) \
+    F(Int, state) \
+    F(Int, incoming) \
+    F(String, durable_media_id) \
+    F(String, media_probe_server) \
+
+#define VX_SIM_EVT_FIELDS_text_stream_updated(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(Int, enabled) \
+    F(Int, state) \
+    F(Int, incoming) \
+    F(Int, status_code) \
+    F(String, status_string) \
+
+#define VX_SIM_EVT_FIELDS_sessiongroup_added(F) \
+    F(String, sessiongroup_handle) \
+    F(String, account_handle) \
+    F(Int, type) \
+    F(String, alias_username) \
+
+#define VX_SIM_EVT_FIELDS_sessiongroup_removed(F) \
+    F(String, sessiongroup_handle) \
+
+#define VX_SIM_EVT_FIELDS_session_added(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, uri) \
+    F(Int, is_channel) \
+    F(Int, incoming) \
+    F(String, channel_name) \
+    F(String, displayname) \
+    F(String, application) \
+    F(String, alias_username) \
+
+#define VX_SIM_EVT_FIELDS_session_removed(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, uri) \
+
+#define VX_SIM_EVT_FIELDS_participant_added(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+    F(String, account_name) \
+    F(String, display_name) \
+    F(Int, participant_type) \
+    F(String, application) \
+    F(Int, is_anonymous_login) \
+    F(String, displayname) \
+    F(String, alias_username) \
+    F(String, encoded_uri_with_tag) \
+    F(Int, is_current_user) \
+
+#define VX_SIM_EVT_FIELDS_participant_removed(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+    F(String, account_name) \
+    F(Int, reason) \
+    F(String, alias_username) \
+    F(String, encoded_uri_with_tag) \
+    F(Int, is_current_user) \
+
+#define VX_SIM_EVT_FIELDS_participant_updated(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+    F(Int, is_moderator_muted) \
+    F(Int, is_speaking) \
+    F(Int, volume) \
+    F(Double, energy) \
+    F(Int, active_media) \
+    F(Int, is_muted_for_me) \
+    F(Int, is_text_muted_for_me) \
+    F(Int, is_moderator_text_muted) \
+    F(Int, type) \
+    F(Int, diagnostic_state_count) \
+    F(String, alias_username) \
+    F(String, encoded_uri_with_tag) \
+    F(Int, is_current_user) \
+    F(Int, has_unavailable_capture_device) \
+    F(Int, has_unavailable_render_device) \
+
+#define VX_SIM_EVT_FIELDS_sessiongroup_playback_frame_played(F) \
+    F(String, sessiongroup_handle) \
+    F(Int, first_frame) \
+    F(Int, current_frame) \
+    F(Int, total_frames) \
+
+#define VX_SIM_EVT_FIELDS_session_updated(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, uri) \
+    F(Int, is_muted) \
+    F(Int, volume) \
+    F(Int, transmit_enabled) \
+    F(Int, is_focused) \
+    F(Int, session_font_id) \
+    F(Int, is_text_muted) \
+    F(Int, is_ad_playing) \
+
+#define VX_SIM_EVT_FIELDS_sessiongroup_updated(F) \
+    F(String, sessiongroup_handle) \
+    F(Int, in_delayed_playback) \
+    F(Double, current_playback_speed) \
+    F(Int, current_playback_mode) \
+    F(Int, playback_paused) \
+    F(Int, loop_buffer_capacity) \
+    F(Int, first_loop_frame) \
+    F(Int, total_loop_frames_captured) \
+    F(Int, last_loop_frame_played) \
+    F(String, current_recording_filename) \
+    F(Int, total_recorded_frames) \
+    F(Int, first_frame_timestamp_us) \
+
+#define VX_SIM_EVT_FIELDS_media_completion(F) \
+    F(String, sessiongroup_handle) \
+    F(Int, completion_type) \
+
+#define VX_SIM_EVT_FIELDS_server_app_data(F) \
+    F(String, account_handle) \
+    F(String, content_type) \
+    F(String, content) \
+
+#define VX_SIM_EVT_FIELDS_user_app_data(F) \
+    F(String, account_handle) \
+    F(String, from_uri) \
+    F(String, content_type) \
+    F(String, content) \
+
+#define VX_SIM_EVT_FIELDS_network_message(F) \
+    F(String, account_handle) \
+    F(Int, network_message_type) \
+    F(String, content_type) \
+    F(String, content) \
+    F(String, sender_uri) \
+    F(String, sender_display_name) \
+    F(String, sender_alias_username) \
+    F(String, receiver_alias_username) \
+
+#define VX_SIM_EVT_FIELDS_voice_service_connection_state_changed(F) \
+    F(Int, connected) \
+    F(String, platform) \
+    F(String, version) \
+    F(String, data_directory) \
+    F(Int, network_test_run) \
+    F(Int, network_test_completed) \
+    F(Int, network_test_state) \
+    F(Int, network_is_down) \
+
+#define VX_SIM_EVT_FIELDS_publication_state_changed(F) \
+    F(String, account_handle) \
+    F(String, alias_username) \
+    F(Int, state) \
+    F(Int, presence) \
+    F(String, custom_message) \
+    F(Int, status_code) \
+    F(String, status_string) \
+
+#define VX_SIM_EVT_FIELDS_audio_device_hot_swap(F) \
+    F(Int, event_type) \
+    F(String, account_handle) \
+
+#define VX_SIM_EVT_FIELDS_user_to_user_message(F) \
+    F(String, account_handle) \
+    F(String, from_uri) \
+    F(String, encoded_uri_with_tag) \
+    F(String, message_body) \
+    F(String, language) \
+    F(String, application_stanza_namespace) \
+    F(String, application_stanza_body) \
+    F(String, from_displayname) \
+
+#define VX_SIM_EVT_FIELDS_session_archive_message(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, query_id) \
+    F(String, time_stamp) \
+    F(String, participant_uri) \
+    F(String, message_body) \
+    F(String, message_id) \
+    F(String, encoded_uri_with_tag) \
+    F(Int, is_current_user) \
+    F(String, language) \
+
+#define VX_SIM_EVT_FIELDS_session_archive_query_end(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, query_id) \
+    F(Int, return_code) \
+    F(Int, status_code) \
+    F(String, first_id) \
+    F(String, last_id) \
+    F(Unsigned, first_index) \
+    F(Unsigned, count) \
+
+#define VX_SIM_EVT_FIELDS_account_archive_message(F) \
+    F(String, account_handle) \
+    F(String, query_id) \
+    F(String, time_stamp) \
+    F(String, channel_uri) \
+    F(String, participant_uri) \
+    F(Int, is_inbound) \
+    F(String, message_body) \
+    F(String, message_id) \
+    F(String, encoded_uri_with_tag) \
+    F(String, language) \
+
+#define VX_SIM_EVT_FIELDS_account_archive_query_end(F) \
+    F(String, account_handle) \
+    F(String, query_id) \
+    F(Int, return_code) \
+    F(Int, status_code) \
+    F(String, first_id) \
+    F(String, last_id) \
+    F(Unsigned, first_index) \
+    F(Unsigned, count) \
+
+#define VX_SIM_EVT_FIELDS_account_send_message_failed(F) \
+    F(String, account_handle) \
+    F(String, request_id) \
+    F(Int, status_code) \
+
+#define VX_SIM_EVT_FIELDS_transcribed_message(F) \
+    F(String, sessiongroup_handle) \
+    F(String, session_handle) \
+    F(String, participant_uri) \
+    F(String, text) \
+    F(String, language) \
+    F(Int, is_current_user) \
+    F(String, participant_displayname) \
+
+#define VX_SIM_EVT_FIELDS_tts_injection_started(F) \
+    F(Unsigned, num_consumers) \
+    F(Double, utterance_duration) \
+    F(Int, tts_destination) \
+
+#define VX_SIM_EVT_FIELDS_tts_injection_ended(F) \
+    F(Unsigned, num_consumers) \
+    F(Int, tts_destination) \
+
+#define VX_SIM_EVT_FIELDS_tts_injection_failed(F) \
+    F(Int, status) \
+    F(Int, tts_destination) \
+
+// P(name, Kind, type, field) for the pointers each request owns besides its strings, Kind being
+// Data, StringArray, Struct or StructArray
+#define VX_SIM_REQ_OWNED(P) \
+    P(account_anonymous_login, StringArray, char, initial_buddy_uris) \
+    P(account_anonymous_login, StringArray, char, initial_blocked_uris) \
+    P(account_anonymous_login, StringArray, char, initial_blocked_uris_presence_only) \
+    P(account_anonymous_login, StringArray, char, initial_allowed_uris) \
+
+// P(name, Kind, type, field) for the pointers each response owns besides its strings and request
+#define VX_SIM_RESP_OWNED(P) \
+    P(account_channel_get_acl, StructArray, vx_participant, participants) \
+    P(channel_get_banned_users, StructArray, vx_participant, banned_users) \
+    P(account_list_buddies_and_groups, StructArray, vx_buddy, buddies) \
+    P(account_list_buddies_and_groups, StructArray, vx_group, groups) \
+    P(account_list_block_rules, StructArray, vx_block_rule, block_rules) \
+    P(account_list_auto_accept_rules, StructArray, vx_auto_accept_rule, auto_accept_rules) \
+    P(account_get_account, Struct, vx_account, account) \
+    P(aux_connectivity_info, StructArray, vx_connectivity_test_result, test_results) \
+    P(aux_get_render_devices, StructArray, vx_device, render_devices) \
+    P(aux_get_render_devices, Struct, vx_device, current_render_device) \
+    P(aux_get_render_devices, Struct, vx_device, effective_render_device) \
+    P(aux_get_render_devices, Struct, vx_device, default_render_device) \
+    P(aux_get_render_devices, Struct, vx_device, default_communication_render_device) \
+    P(aux_get_capture_devices, StructArray, vx_device, capture_devices) \
+    P(aux_get_capture_devices, Struct, vx_device, current_capture_device) \
+    P(aux_get_capture_devices, Struct, vx_device, effective_capture_device) \
+    P(aux_get_capture_devices, Struct, vx_device, default_capture_device) \
+    P(aux_get_capture_devices, Struct, vx_device, default_communication_capture_device) \
+    P(account_get_session_fonts, StructArray, vx_voice_font, session_fonts) \
+    P(account_get_template_fonts, StructArray, vx_voice_font, template_fonts) \
+    P(aux_diagnostic_state_dump, StructArray, vx_state_connector, state_connectors) \
+    P(aux_diagnostic_state_dump, Struct, vx_device, current_render_device) \
+    P(aux_diagnostic_state_dump, Struct, vx_device, effective_render_device) \
+    P(aux_diagnostic_state_dump, Struct, vx_device, current_capture_device) \
+    P(aux_diagnostic_state_dump, Struct, vx_device, effective_capture_device) \
+
+// P(name, Kind, type, field) for the pointers each event owns besides its strings
+#define VX_SIM_EVT_OWNED(P) \
+    P(buddy_and_group_list_changed, StructArray, vx_buddy, buddies) \
+    P(buddy_and_group_list_changed, StructArray, vx_group, groups) \
+    P(media_stream_updated, Struct, vx_call_stats, call_stats) \
+    P(participant_updated, Data, vx_participant_diagnostic_state_t, diagnostic_states) \
+    P(audio_device_hot_swap, Struct, vx_device, relevant_device) \
+
+// X(type) for each struct messages point to, and F(Kind, field) for its string and number fields. The
+// strings are owned by the struct; its pointers to other structs are not followed.
+#define VX_SIM_OWNED_STRUCTS(X) \
+    X(vx_account) \
+    X(vx_auto_accept_rule) \
+    X(vx_block_rule) \
+    X(vx_buddy) \
+    X(vx_call_stats) \
+    X(vx_connectivity_test_result) \
+    X(vx_device) \
+    X(vx_group) \
+    X(vx_participant) \
+    X(vx_state_connector) \
+    X(vx_voice_font) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_account(F) \
+    F(String, uri) \
+    F(String, firstname) \
+    F(String, lastname) \
+    F(String, username) \
+    F(String, displayname) \
+    F(String, email) \
+    F(String, phone) \
+    F(String, carrier) \
+    F(String, created_date) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_auto_accept_rule(F) \
+    F(String, auto_accept_mask) \
+    F(Int, auto_add_as_buddy) \
+    F(String, auto_accept_nickname) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_block_rule(F) \
+    F(String, block_mask) \
+    F(Int, presence_only) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_buddy(F) \
+    F(String, buddy_uri) \
+    F(String, display_name) \
+    F(Int, parent_group_id) \
+    F(String, buddy_data) \
+    F(Int, account_id) \
+    F(String, account_name) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_call_stats(F) \
+    F(Int, insufficient_bandwidth) \
+    F(Int, min_bars) \
+    F(Int, max_bars) \
+    F(Int, current_bars) \
+    F(Int, pk_loss) \
+    F(Int, incoming_received) \
+    F(Int, incoming_expected) \
+    F(Int, incoming_packetloss) \
+    F(Int, incoming_out_of_time) \
+    F(Int, incoming_discarded) \
+    F(Int, outgoing_sent) \
+    F(Int, render_device_underruns) \
+    F(Int, render_device_overruns) \
+    F(Int, render_device_errors) \
+    F(String, call_id) \
+    F(Int, plc_on) \
+    F(Int, plc_synthetic_frames) \
+    F(String, codec_name) \
+    F(Int, codec_mode) \
+    F(Double, min_latency) \
+    F(Double, max_latency) \
+    F(Int, latency_measurement_count) \
+    F(Double, latency_sum) \
+    F(Double, last_latency_measured) \
+    F(Int, latency_packets_lost) \
+    F(Double, r_factor) \
+    F(Int, latency_packets_sent) \
+    F(Int, latency_packets_dropped) \
+    F(Int, latency_packets_malformed) \
+    F(Int, latency_packets_negative_latency) \
+    F(Double, sample_interval_begin) \
+    F(Double, sample_interval_end) \
+    F(Int, current_opus_bit_rate) \
+    F(Int, current_opus_complexity) \
+    F(Int, current_opus_vbr_mode) \
+    F(Int, current_opus_bandwidth) \
+    F(Int, current_opus_max_packet_size) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_connectivity_test_result(F) \
+    F(Int, test_type) \
+    F(Int, test_error_code) \
+    F(String, test_additional_info) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_device(F) \
+    F(String, device) \
+    F(String, display_name) \
+    F(Int, device_type) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_group(F) \
+    F(Int, group_id) \
+    F(String, group_name) \
+    F(String, group_data) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_participant(F) \
+    F(String, uri) \
+    F(String, first_name) \
+    F(String, last_name) \
+    F(String, display_name) \
+    F(String, username) \
+    F(Int, is_moderator) \
+    F(Int, is_moderator_muted) \
+    F(Int, is_moderator_text_muted) \
+    F(Int, is_muted_for_me) \
+    F(Int, is_owner) \
+    F(Int, account_id) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_state_connector(F) \
+    F(String, connector_handle) \
+    F(Int, state_accounts_count) \
+    F(Int, mic_vol) \
+    F(Int, mic_mute) \
+    F(Int, speaker_vol) \
+    F(Int, speaker_mute) \
+
+#define VX_SIM_STRUCT_FIELDS_vx_voice_font(F) \
+    F(Int, id) \
+    F(Int, parent_id) \
+    F(Int, type) \
+    F(String, name) \
+    F(String, description) \
+    F(String, expiration_date) \
+    F(Int, expired) \
+    F(String, font_delta) \
+    F(String, font_rules) \
+    F(Int, status) \
+
+// X(enumerator) for vx_login_state_change_state
+#define VX_SIM_ENUM_VX_LOGIN_STATE_CHANGE_STATE(X) \
+    X(login_state_logged_out) \
+    X(login_state_logged_in) \
+    X(login_state_logging_in) \
+    X(login_state_logging_out) \
+    X(login_state_resetting) \
+    X(login_state_error) \
+
+// X(enumerator) for vx_buddy_presence_state
+#define VX_SIM_ENUM_VX_BUDDY_PRESENCE_STATE(X) \
+    X(buddy_presence_unknown) \
+    X(buddy_presence_pending) \
+    X(buddy_presence_online) \
+    X(buddy_presence_busy) \
+    X(buddy_presence_brb) \
+    X(buddy_presence_away) \
+    X(buddy_presence_onthephone) \
+    X(buddy_presence_outtolunch) \
+    X(buddy_presence_custom) \
+    X(buddy_presence_online_slc) \
+    X(buddy_presence_chat) \
+    X(buddy_presence_extended_away) \
+
+// X(enumerator) for vx_notification_type
+#define VX_SIM_ENUM_VX_NOTIFICATION_TYPE(X) \
+    X(notification_not_typing) \
+    X(notification_typing) \
+    X(notification_hand_lowered) \
+    X(notification_hand_raised) \
+
+// X(enumerator) for vx_session_media_state
+#define VX_SIM_ENUM_VX_SESSION_MEDIA_STATE(X) \
+    X(session_media_disconnected) \
+    X(session_media_connected) \
+    X(session_media_ringing) \
+    X(session_media_connecting) \
+    X(session_media_disconnecting) \
+
+// X(enumerator) for vx_session_text_state
+#define VX_SIM_ENUM_VX_SESSION_TEXT_STATE(X) \
+    X(session_text_disconnected) \
+    X(session_text_connected) \
+    X(session_text_connecting) \
+    X(session_text_disconnecting) \
+
+// X(enumerator) for vx_media_completion_type
+#define VX_SIM_ENUM_VX_MEDIA_COMPLETION_TYPE(X) \
+    X(media_completion_type_none) \
+    X(aux_buffer_audio_capture) \
+    X(aux_buffer_audio_render) \
+    X(sessiongroup_audio_injection) \
+
+// X(enumerator) for vx_participant_removed_reason
+#define VX_SIM_ENUM_VX_PARTICIPANT_REMOVED_REASON(X) \
+    X(participant_left) \
+    X(participant_timeout) \
+    X(participant_kicked) \
+    X(participant_banned) \
+
+// X(enumerator) for vx_tts_destination
+#define VX_SIM_ENUM_VX_TTS_DESTINATION(X) \
+    X(tts_dest_remote_transmission) \
+    X(tts_dest_local_playback) \
+    X(tts_dest_remote_transmission_with_local_playback) \
+    X(tts_dest_queued_remote_transmission) \
+    X(tts_dest_queued_local_playback) \
+    X(tts_dest_queued_remote_transmission_with_local_playback) \
+    X(tts_dest_screen_reader) \
+
+// X(enumerator) for vx_tts_status
+#define VX_SIM_ENUM_VX_TTS_STATUS(X) \
+    X(tts_status_success) \
+    X(tts_error_invalid_engine_type) \
+    X(tts_error_engine_allocation_failed) \
+    X(tts_error_not_supported) \
+    X(tts_error_max_characters_exceeded) \
+    X(tts_error_utterance_below_min_duration) \
+    X(tts_status_input_text_was_enqueued) \
+    X(tts_error_sdk_not_initialized) \
+    X(tts_error_destination_queue_is_full) \
+    X(tts_status_enqueue_not_necessary) \
+    X(tts_error_utterance_not_found) \
+    X(tts_error_manager_not_found) \
+    X(tts_error_invalid_argument) \
+    X(tts_error_internal) \
+
+// X(enumerator) for vx_audio_device_hot_swap_event_type_t
+#define VX_SIM_ENUM_VX_AUDIO_DEVICE_HOT_SWAP_EVENT_TYPE(X) \
+    X(vx_audio_device_hot_swap_event_type_disabled_due_to_platform_constraints) \
+    X(vx_audio_device_hot_swap_event_type_active_render_device_changed) \
+    X(vx_audio_device_hot_swap_event_type_active_capture_device_changed) \
+    X(vx_audio_device_hot_swap_event_type_audio_device_added) \
+    X(vx_audio_device_hot_swap_event_type_audio_device_removed) \
+
+// X(enumerator) for vx_log_level
+#define VX_SIM_ENUM_VX_LOG_LEVEL(X) \
+    X(log_none) \
+    X(log_error) \
+    X(log_warning) \
+    X(log_info) \
+    X(log_debug) \
+    X(log_trace) \
+    X(log_all) \
+
@@ -0,0 +1,527 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+// The message functions of Vxc.h, VxcRequests.h, VxcResponses.h and VxcEvents.h: creating
+// and destroying messages, their XML and the names of types and states.
+
+#include "SimMessages.h"
+#include "SimMessageTables.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+unsigned long long SimTimeMilliseconds()
+{
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+vx_message_base_t *SimNewMessage(size_t size, vx_message_type messageType, int type)
+{
+    vx_message_base_t *message = (vx_message_base_t *)SimMemory::Allocate(size, SimMemory::kindMessage);
+    if (!message) {
+        return NULL;
+    }
+    message->type = messageType;
+    message->create_time_ms = SimTimeMilliseconds();
+    switch (messageType) {
+        case msg_request:
+            ((vx_req_base_t *)message)->type = (vx_request_type)type;
+            break;
+        case msg_response:
+            ((vx_resp_base_t *)message)->type = (vx_response_type)type;
+            break;
+        case msg_event:
+            ((vx_evt_base_t *)message)->type = (vx_event_type)type;
+            break;
+        default:
+            break;
+    }
+    return message;
+}
+
+vx_resp_base_t *SimNewResponse(vx_req_base_t *request)
+{
+    vx_resp_base_t *response = NULL;
+    switch (request->type) {
+#define SIM_NEW_RESPONSE(name) \
+        case req_##name: \
+            response = (vx_resp_base_t *)SimNewMessage(sizeof(vx_resp_##name##_t), msg_response, resp_##name); \
+            break;
+        VX_SIM_REQUEST_TYPES(SIM_NEW_RESPONSE)
+#undef SIM_NEW_RESPONSE
+        default:
+            break;
+    }
+    if (response) {
+        response->request = request;
+    }
+    return response;
+}
+
+// Creating messages
+
+#define SIM_REQUEST_CREATE(name) \
+    int vx_req_##name##_create(vx_req_##name##_t **req) \
+    { \
+        if (!req) { \
+            return VX_E_INVALID_ARGUMENT; \
+        } \
+        *req = (vx_req_##name##_t *)SimNewMessage(sizeof(vx_req_##name##_t), msg_request, req_##name); \
+        return *req ? 0 : VX_E_FAILED; \
+    }
+VX_SIM_REQUEST_TYPES(SIM_REQUEST_CREATE)
+#undef SIM_REQUEST_CREATE
+
+// Destroying messages
+//
+// Everything a message owns is collected before anything is freed, so that a struct pointed
+// to twice, such as a device both in the list and current, is looked into and freed once.
+
+typedef std::vector<void *> SimOwnedBlocks;
+
+static void CollectString(const char *value, SimOwnedBlocks &blocks)
+{
+    if (value) {
+        blocks.push_back((void *)value);
+    }
+}
+
+template <class T> static void CollectInt(const T &, SimOwnedBlocks &) {}
+template <class T> static void CollectUnsigned(const T &, SimOwnedBlocks &) {}
+template <class T> static void CollectDouble(const T &, SimOwnedBlocks &) {}
+
+#define SIM_COLLECT_FIELD(Kind, field) Collect##Kind(m->field, blocks);
+
+#define SIM_COLLECT_STRUCT(type) \
+    static void CollectStruct(type##_t *m, SimOwnedBlocks &blocks) \
+    { \
+        if (m) { \
+            blocks.push_back(m); \
+            VX_SIM_STRUCT_FIELDS_##type(SIM_COLLECT_FIELD) \
+        } \
+    }
+VX_SIM_OWNED_STRUCTS(SIM_COLLECT_STRUCT)
+#undef SIM_COLLECT_STRUCT
+
+// The elements up to the first NULL; those of an array the simulator did not allocate are not looked at
+template <class T>
+static void CollectStructArray(T **array, SimOwnedBlocks &blocks)
+{
+    if (array) {
+        blocks.push_back(array);
+        size_t count = SimMemory::GetSize(array) / sizeof(T *);
+        for (size_t i = 0; i < count && array[i]; ++i) {
+            CollectStruct(array[i], blocks);
+        }
+    }
+}
+
+template <class T>
+static void CollectData(T *data, SimOwnedBlocks &blocks)
+{
+    if (data) {
+        blocks.push_back(data);
+    }
+}
+
+static void CollectStringArray(char **array, SimOwnedBlocks &blocks)
+{
+    if (array) {
+        blocks.push_back(array);
+        size_t count = SimMemory::GetSize(array) / sizeof(char *);
+        for (size_t i = 0; i < count && array[i]; ++i) {
+            blocks.push_back(array[i]);
+        }
+    }
+}
+
+#define SIM_COLLECT_OWNED(prefix, name, Kind, structType, field) \
+    if (message->type == prefix##name) { \
+        Collect##Kind(((vx_##prefix##name##_t *)message)->field, blocks); \
+    }
+#define SIM_COLLECT_REQ_OWNED(name, Kind, structType, field) SIM_COLLECT_OWNED(req_, name, Kind, structType, field)
+#define SIM_COLLECT_RESP_OWNED(name, Kind, structType, field) SIM_COLLECT_OWNED(resp_, name, Kind, structType, field)
+#define SIM_COLLECT_EVT_OWNED(name, Kind, structType, field) SIM_COLLECT_OWNED(evt_, name, Kind, structType, field)
+
+static void CollectRequest(vx_req_base_t *message, SimOwnedBlocks &blocks)
+{
+    blocks.push_back(message);
+    CollectString(message->cookie, blocks);
+    switch (message->type) {
+#define SIM_COLLECT_REQUEST(name) \
+        case req_##name: { \
+            const vx_req_##name##_t *m = (const vx_req_##name##_t *)message; \
+            (void)m; \
+            VX_SIM_REQ_FIELDS_##name(SIM_COLLECT_FIELD) \
+            break; \
+        }
+        VX_SIM_REQUEST_TYPES(SIM_COLLECT_REQUEST)
+#undef SIM_COLLECT_REQUEST
+        default:
+            break;
+    }
+    VX_SIM_REQ_OWNED(SIM_COLLECT_REQ_OWNED)
+}
+
+static void CollectResponse(vx_resp_base_t *message, SimOwnedBlocks &blocks)
+{
+    blocks.push_back(message);
+    CollectString(message->status_string, blocks);
+    CollectString(message->extended_status_info, blocks);
+    switch (message->type) {
+#define SIM_COLLECT_RESPONSE(name) \
+        case resp_##name: { \
+            const vx_resp_##name##_t *m = (const vx_resp_##name##_t *)message; \
+            (void)m; \
+            VX_SIM_RESP_FIELDS_##name(SIM_COLLECT_FIELD) \
+            break; \
+        }
+        VX_SIM_RESPONSE_TYPES(SIM_COLLECT_RESPONSE)
+#undef SIM_COLLECT_RESPONSE
+        default:
+            break;
+    }
+    VX_SIM_RESP_OWNED(SIM_COLLECT_RESP_OWNED)
+    if (message->request && SimMemory::IsRegistered(message->request)) {
+        CollectRequest(message->request, blocks);
+    }
+}
+
+static void CollectEvent(vx_evt_base_t *message, SimOwnedBlocks &blocks)
+{
+    blocks.push_back(message);
+    CollectString(message->extended_status_info, blocks);
+    switch (message->type) {
+#define SIM_COLLECT_EVENT(name) \
+        case evt_##name: { \
+            const vx_evt_##name##_t *m = (const vx_evt_##name##_t *)message; \
+            (void)m; \
+            VX_SIM_EVT_FIELDS_##name(SIM_COLLECT_FIELD) \
+            break; \
+        }
+        VX_SIM_EVENT_TYPES(SIM_COLLECT_EVENT)
+#undef SIM_COLLECT_EVENT
+        default:
+            break;
+    }
+    VX_SIM_EVT_OWNED(SIM_COLLECT_EVT_OWNED)
+}
+
+#undef SIM_COLLECT_EVT_OWNED
+#undef SIM_COLLECT_RESP_OWNED
+#undef SIM_COLLECT_REQ_OWNED
+#undef SIM_COLLECT_OWNED
+#undef SIM_COLLECT_FIELD
+
+bool SimFreeMessage(vx_message_base_t *message)
+{
+    if (!message || !SimMemory::IsRegistered(message)) {
+        return false;
+    }
+    SimOwnedBlocks blocks;
+    switch (message->type) {
+        case msg_request:
+            CollectRequest((vx_req_base_t *)message, blocks);
+            break;
+        case msg_response:
+            CollectResponse((vx_resp_base_t *)message, blocks);
+            break;
+        case msg_event:
+            CollectEvent((vx_evt_base_t *)message, blocks);
+            break;
+        default:
+            blocks.push_back(message);
+            break;
+    }
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    // A pointer that is not a registered block, e.g. a string literal the application put in a field, is skipped
+    for (SimOwnedBlocks::const_iterator i = blocks.begin(); i != blocks.end(); ++i) {
+        SimMemory::Free(*i);
+    }
+    return true;
+}
+
+int destroy_req(vx_req_base_t *pCmd)
+{
+    return SimFreeMessage((vx_message_base_t *)pCmd) ? 0 : VX_E_INVALID_ARGUMENT;
+}
+
+int destroy_resp(vx_resp_base_t *pCmd)
+{
+    return SimFreeMessage((vx_message_base_t *)pCmd) ? 0 : VX_E_INVALID_ARGUMENT;
+}
+
+int destroy_evt(vx_evt_base_t *pCmd)
+{
+    return SimFreeMessage((vx_message_base_t *)pCmd) ? 0 : VX_E_INVALID_ARGUMENT;
+}
+
+int vx_destroy_message(vx_message_base_t *message)
+{
+    return SimFreeMessage(message) ? 0 : VX_E_INVALID_ARGUMENT;
+}
+
+// XML
+//
+// Not the schema of the SDK: each string and number field of the struct is an element named
+// after the field, which is enough for logs and for matching text in a message.
+
+static void AppendEscaped(std::string &xml, const char *value)
+{
+    for (const char *p = value; *p; ++p) {
+        switch (*p) {
+            case '<': xml += "&lt;"; break;
+            case '>': xml += "&gt;"; break;
+            case '&': xml += "&amp;"; break;
+            case '"': xml += "&quot;"; break;
+            default: xml += *p; break;
+        }
+    }
+}
+
+static void AppendString(std::string &xml, const char *name, const char *value)
+{
+    if (!value) {
+        return;
+    }
+    xml += '<';
+    xml += name;
+    xml += '>';
+    AppendEscaped(xml, value);
+    xml += "</";
+    xml += name;
+    xml += '>';
+}
+
+static void AppendNumber(std::string &xml, const char *name, const char *value)
+{
+    xml += '<';
+    xml += name;
+    xml += '>';
+    xml += value;
+    xml += "</";
+    xml += name;
+    xml += '>';
+}
+
+static void AppendInt(std::string &xml, const char *name, long long value)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%lld", value);
+    AppendNumber(xml, name, text);
+}
+
+static void AppendUnsigned(std::string &xml, const char *name, unsigned long long value)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%llu", value);
+    AppendNumber(xml, name, text);
+}
+
+static void AppendDouble(std::string &xml, const char *name, double value)
+{
+    char text[40];
+    snprintf(text, sizeof(text), "%.6g", value);
+    AppendNumber(xml, name, text);
+}
+
+#define SIM_APPEND_FIELD(Kind, field) Append##Kind(xml, #field, m->field);
+
+static void AppendRequest(std::string &xml, const vx_req_base_t *request)
+{
+    xml += "<Request type=\"";
+    xml += vx_get_request_type_string(request->type);
+    xml += "\" requestId=\"";
+    AppendEscaped(xml, request->cookie ? request->cookie : "");
+    xml += "\">";
+    switch (request->type) {
+#define SIM_REQUEST_XML(name) \
+        case req_##name: { \
+            const vx_req_##name##_t *m = (const vx_req_##name##_t *)request; \
+            (void)m; \
+            VX_SIM_REQ_FIELDS_##name(SIM_APPEND_FIELD) \
+            break; \
+        }
+        VX_SIM_REQUEST_TYPES(SIM_REQUEST_XML)
+#undef SIM_REQUEST_XML
+        default:
+            break;
+    }
+    xml += "</Request>";
+}
+
+static void AppendResponse(std::string &xml, const vx_resp_base_t *response)
+{
+    xml += "<Response type=\"";
+    xml += vx_get_response_type_string(response->type);
+    xml += "\" requestId=\"";
+    AppendEscaped(xml, response->request && response->request->cookie ? response->request->cookie : "");
+    xml += "\">";
+    AppendInt(xml, "ReturnCode", response->return_code);
+    AppendInt(xml, "StatusCode", response->status_code);
+    AppendString(xml, "StatusString", response->status_string);
+    xml += "<Results>";
+    switch (response->type) {
+#define SIM_RESPONSE_XML(name) \
+        case resp_##name: { \
+            const vx_resp_##name##_t *m = (const vx_resp_##name##_t *)response; \
+            (void)m; \
+            VX_SIM_RESP_FIELDS_##name(SIM_APPEND_FIELD) \
+            break; \
+        }
+        VX_SIM_RESPONSE_TYPES(SIM_RESPONSE_XML)
+#undef SIM_RESPONSE_XML
+        default:
+            break;
+    }
+    xml += "</Results>";
+    if (response->request) {
+        xml += "<InputXml>";
+        AppendRequest(xml, response->request);
+        xml += "</InputXml>";
+    }
+    xml += "</Response>";
+}
+
+static void AppendEvent(std::string &xml, const vx_evt_base_t *event)
+{
+    xml += "<Event type=\"";
+    xml += vx_get_event_type_string(event->type);
+    xml += "\">";
+    switch (event->type) {
+#define SIM_EVENT_XML(name) \
+        case evt_##name: { \
+            const vx_evt_##name##_t *m = (const vx_evt_##name##_t *)event; \
+            (void)m; \
+            VX_SIM_EVT_FIELDS_##name(SIM_APPEND_FIELD) \
+            break; \
+        }
+        VX_SIM_EVENT_TYPES(SIM_EVENT_XML)
+#undef SIM_EVENT_XML
+        default:
+            break;
+    }
+    xml += "</Event>";
+}
+
+#undef SIM_APPEND_FIELD
+
+static int ToXml(const std::string &text, char **xml)
+{
+    *xml = SimMemory::Strdup(text.c_str());
+    return *xml ? 0 : VX_E_FAILED;
+}
+
+int vx_request_to_xml(void *request, char **xml)
+{
+    if (!request || !xml) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    std::string text;
+    AppendRequest(text, (const vx_req_base_t *)request);
+    return ToXml(text, xml);
+}
+
+int vx_response_to_xml(void *response, char **xml)
+{
+    if (!response || !xml) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    std::string text;
+    AppendResponse(text, (const vx_resp_base_t *)response);
+    return ToXml(text, xml);
+}
+
+int vx_event_to_xml(void *event, char **xml)
+{
+    if (!event || !xml) {
+        return VX_E_INVALID_ARGUMENT;
+    }
+    std::string text;
+    AppendEvent(text, (const vx_evt_base_t *)event);
+    return ToXml(text, xml);
+}
+
+// Names
+
+#define SIM_CASE_NAME(name) case name: return #name;
+#define SIM_CASE_PREFIXED(prefix, name) case prefix##name: return #prefix #name;
+#define SIM_CASE_REQUEST(name) SIM_CASE_PREFIXED(req_, name)
+#define SIM_CASE_RESPONSE(name) SIM_CASE_PREFIXED(resp_, name)
+#define SIM_CASE_EVENT(name) SIM_CASE_PREFIXED(evt_, name)
+
+const char *vx_get_request_type_string(vx_request_type t)
+{
+    switch (t) {
+        VX_SIM_REQUEST_TYPES(SIM_CASE_REQUEST)
+        default: return "req_unknown";
+    }
+}
+
+const char *vx_get_response_type_string(vx_response_type t)
+{
+    switch (t) {
+        VX_SIM_RESPONSE_TYPES(SIM_CASE_RESPONSE)
+        default: return "resp_unknown";
+    }
+}
+
+const char *vx_get_event_type_string(vx_event_type t)
+{
+    switch (t) {
+        VX_SIM_EVENT_TYPES(SIM_CASE_EVENT)
+        default: return "evt_unknown";
+    }
+}
+
+const char *vx_get_error_string(int errorCode)
+{
+    switch (errorCode) {
+        VX_SIM_ERROR_CODES(SIM_CASE_NAME)
+        default: return "VX_E_UNKNOWN";
+    }
+}
+
+#define SIM_STATE_STRING(function, type, table) \
+    const char *function(type t) \
+    { \
+        switch (t) { \
+            table(SIM_CASE_NAME) \
+            default: return "unknown"; \
+        } \
+    }
+
+SIM_STATE_STRING(vx_get_login_state_string, vx_login_state_change_state, VX_SIM_ENUM_VX_LOGIN_STATE_CHANGE_STATE)
+SIM_STATE_STRING(vx_get_presence_state_string, vx_buddy_presence_state, VX_SIM_ENUM_VX_BUDDY_PRESENCE_STATE)
+SIM_STATE_STRING(vx_get_notification_type_string, vx_notification_type, VX_SIM_ENUM_VX_NOTIFICATION_TYPE)
+SIM_STATE_STRING(vx_get_session_media_state_string, vx_session_media_state, VX_SIM_ENUM_VX_SESSION_MEDIA_STATE)
+SIM_STATE_STRING(vx_get_session_text_state_string, vx_session_text_state, VX_SIM_ENUM_VX_SESSION_TEXT_STATE)
+SIM_STATE_STRING(vx_get_media_completion_type_string, vx_media_completion_type, VX_SIM_ENUM_VX_MEDIA_COMPLETION_TYPE)
+SIM_STATE_STRING(vx_get_participant_removed_reason_string, vx_participant_removed_reason, VX_SIM_ENUM_VX_PARTICIPANT_REMOVED_REASON)
+SIM_STATE_STRING(vx_get_audio_device_hot_swap_type_string, vx_audio_device_hot_swap_event_type_t, VX_SIM_ENUM_VX_AUDIO_DEVICE_HOT_SWAP_EVENT_TYPE)
+SIM_STATE_STRING(vx_get_tts_dest_string, vx_tts_destination, VX_SIM_ENUM_VX_TTS_DESTINATION)
+SIM_STATE_STRING(vx_get_tts_status_string, vx_tts_status, VX_SIM_ENUM_VX_TTS_STATUS)
+SIM_STATE_STRING(vx_get_log_level_string, vx_log_level, VX_SIM_ENUM_VX_LOG_LEVEL)
+
+#undef SIM_STATE_STRING
+#undef SIM_CASE_EVENT
+#undef SIM_CASE_RESPONSE
+#undef SIM_CASE_REQUEST
+#undef SIM_CASE_PREFIXED
+#undef SIM_CASE_NAME
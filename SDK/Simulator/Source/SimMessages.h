@@ -0,0 +1,49 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "Vxc.h"
+#include "VxcErrors.h"
+#include "VxcRequests.h"
+#include "VxcResponses.h"
+#include "VxcEvents.h"
+#include "SimMemory.h"
+
+// Milliseconds of the steady clock, what vx_get_time_ms() returns
+unsigned long long SimTimeMilliseconds();
+
+// A zeroed message of the struct size with its types set, NULL if out of memory
+vx_message_base_t *SimNewMessage(size_t size, vx_message_type messageType, int type);
+
+// The response to a request, which then owns the request. NULL for a request type
+// without a response, or out of memory.
+vx_resp_base_t *SimNewResponse(vx_req_base_t *request);
+
+// Frees a message with what it owns: its strings and the arrays and structs listed in
+// SimMessageTables.h, and the request of a response. What the application put in vcookie,
+// or anywhere else, is left alone. Returns false if message is not a registered block.
+bool SimFreeMessage(vx_message_base_t *message);
+
+template <class T>
+T *SimNewEvent(vx_event_type type)
+{
+    return (T *)SimNewMessage(sizeof(T), msg_event, type);
+}
+
+// A copy of a string for a message, which frees it with the message
+inline char *SimStrdup(const char *s)
+{
+    return SimMemory::Strdup(s ? s : "");
+}
@@ -0,0 +1,96 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "Vxc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * How the simulated SDK behaves. The simulator is a stand-in for vivoxsdk built from
+ * SDK/Simulator, implementing the request, response and event surface of Vxc.h without
+ * any network or audio device, so that applications can run headless.
+ *
+ * With the same seed, the same requests issued in the same order get the same responses
+ * and events, each the same time after its request, and the remote participants of each
+ * channel do the same.
+ */
+typedef struct vx_sim_config {
+    /**
+     * Seeds every random choice of the simulator.
+     */
+    unsigned int seed;
+
+    /**
+     * Each response comes this long after its request, picked evenly in the range.
+     * Media connecting after a join takes another such delay.
+     */
+    unsigned int response_latency_min_ms;
+    unsigned int response_latency_max_ms;
+
+    /**
+     * The share of requests, from 0 to 1, that fail with VX_E_FAILED.
+     */
+    double request_failure_rate;
+
+    /**
+     * Simulated remote participants in a channel when the first local session joins it,
+     * and at most in a channel.
+     */
+    unsigned int initial_remote_participants;
+    unsigned int max_remote_participants;
+
+    /**
+     * Remote participants joining each channel per second, and how long they stay on
+     * average. 0 seconds keeps them until the channel is left.
+     */
+    double participant_joins_per_second;
+    double participant_stay_seconds;
+
+    /**
+     * How often each remote participant starts or stops speaking, per second.
+     */
+    double speaking_changes_per_second;
+
+    /**
+     * The audio clock: the pf_on_audio_unit_* and UDP frame callbacks of vx_sdk_config_t are
+     * called every this many milliseconds for each connected session group. 0 turns them off.
+     */
+    unsigned int audio_frame_ms;
+} vx_sim_config_t;
+
+/**
+ * Gets the defaults: seed 1, 20 to 50 ms responses, no failures, 2 to 8 remote
+ * participants joining once a minute and staying 2 minutes, speaking changes every
+ * 5 seconds, and a 20 ms audio clock.
+ */
+VIVOXSDK_DLLEXPORT int vx_sim_get_default_config(vx_sim_config_t *config);
+
+/**
+ * Sets how the simulator behaves from the next vx_initialize3() on.
+ *
+ * Applications unaware of the simulator can set it with environment variables read by
+ * vx_initialize3(), named after the fields: VX_SIM_SEED, VX_SIM_RESPONSE_LATENCY_MIN_MS and
+ * so on. They take precedence over this call.
+ *
+ * @return 0, or VX_E_INVALID_ARGUMENT for a config out of range.
+ */
+VIVOXSDK_DLLEXPORT int vx_sim_configure(const vx_sim_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
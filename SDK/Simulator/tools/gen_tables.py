@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+# Copyright (c) 2013-2018 by Mercer Road Corp
+#
+# Permission to use, copy, modify or distribute this software in binary or source form
+# for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+# ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+# BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+# DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+# PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+# ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+# SOFTWARE.
+
+"""Writes SimMessageTables.h, the message types and enum names the simulator needs, from the SDK headers.
+
+Run it again when the headers in SDK/include change:
+    gen_tables.py > ../Source/SimMessageTables.h
+"""
+
+import os
+import re
+import sys
+
+INCLUDE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "include")
+
+# Enums whose names the vx_get_*_string() functions return
+STRING_ENUMS = [
+    ("Vxc.h", "vx_login_state_change_state"),
+    ("Vxc.h", "vx_buddy_presence_state"),
+    ("Vxc.h", "vx_notification_type"),
+    ("Vxc.h", "vx_session_media_state"),
+    ("Vxc.h", "vx_session_text_state"),
+    ("Vxc.h", "vx_media_completion_type"),
+    ("Vxc.h", "vx_participant_removed_reason"),
+    ("Vxc.h", "vx_tts_destination"),
+    ("Vxc.h", "vx_tts_status"),
+    ("VxcEvents.h", "vx_audio_device_hot_swap_event_type_t"),
+    ("VxcTypes.h", "vx_log_level"),
+]
+
+
+def read(name):
+    with open(os.path.join(INCLUDE, name)) as f:
+        return f.read()
+
+
+def enumerators(text, name):
+    """The enumerators of a typedef'd enum, one per value, leaving out aliases of other enumerators"""
+    end = text.index("} " + name + ";")
+    start = text.rindex("typedef enum", 0, end)
+    body = text[text.index("{", start) + 1:end]
+    body = re.sub(r"/\*.*?\*/", "", body, flags=re.S)
+    body = re.sub(r"//.*", "", body)
+    names = []
+    values = set()
+    value = -1
+    for item in body.split(","):
+        item = item.strip()
+        if not item:
+            continue
+        enumerator, _, expression = item.partition("=")
+        expression = expression.strip()
+        if re.search(r"[A-Za-z_]", expression):
+            continue
+        value = int(expression, 0) if expression else value + 1
+        if value in values:
+            continue
+        values.add(value)
+        names.append(enumerator.strip())
+    return names
+
+
+def scalar_types(texts):
+    """Typedef'd enums and integer types, which the XML writes as numbers"""
+    names = {"int", "long", "long long", "short", "vx_time_t"}
+    for text in texts:
+        for match in re.finditer(r"typedef enum\s*\w*\s*\{[^}]*\}\s*(\w+);", text):
+            names.add(match.group(1))
+        for match in re.finditer(r"typedef (?:int|long long|short|__time64_t) (\w+);", text):
+            names.add(match.group(1))
+    return names
+
+
+def fields(text, struct, scalars):
+    """F(Kind, name) for the fields of a message struct the XML writes"""
+    end = text.index("} %s_t;" % struct)
+    start = text.rindex("typedef struct", 0, end)
+    body = text[text.index("{", start) + 1:end]
+    body = re.sub(r"/\*.*?\*/", "", body, flags=re.S)
+    body = re.sub(r"//.*", "", body)
+    out = []
+    for declaration in body.split(";"):
+        declaration = " ".join(declaration.split())
+        match = re.match(r"^(const )?([\w ]+?) ?(\**) ?(\w+)(\[\w+\])?$", declaration)
+        if not match or "," in declaration:
+            continue
+        base, pointers, name, array = match.group(2), match.group(3), match.group(4), match.group(5)
+        if base in ("char", "VX_HANDLE", "VX_COOKIE") and len(pointers) + (1 if array else 0) + (1 if base != "char" else 0) == 1:
+            kind = "String"
+        elif pointers or array:
+            continue
+        elif base in scalars:
+            kind = "Int"
+        elif base in ("unsigned int", "unsigned", "unsigned long long", "unsigned short", "VX_SDK_HANDLE", "size_t"):
+            kind = "Unsigned"
+        elif base in ("double", "float"):
+            kind = "Double"
+        else:
+            continue
+        out.append("F(%s, %s)" % (kind, name))
+    return out
+
+
+def owned_pointers(text, struct, structs, scalars):
+    """P(Kind, type, field) for the pointer fields other than strings a message struct owns: arrays of strings or
+    numbers, and structs of the types in structs or arrays of them. void pointers, such as vcookie, belong to the
+    application."""
+    end = text.index("} %s_t;" % struct)
+    start = text.rindex("typedef struct", 0, end)
+    body = text[text.index("{", start) + 1:end]
+    body = re.sub(r"/\*.*?\*/", "", body, flags=re.S)
+    body = re.sub(r"//.*", "", body)
+    out = []
+    for declaration in body.split(";"):
+        declaration = " ".join(declaration.split())
+        match = re.match(r"^(const )?([\w ]+?) ?(\**) ?(\w+)$", declaration)
+        if not match:
+            continue
+        base, pointers, name = match.group(2), match.group(3), match.group(4)
+        if base == "char" and pointers == "**":
+            out.append("P(StringArray, char, %s)" % name)
+        elif base in scalars and pointers == "*":
+            out.append("P(Data, %s, %s)" % (base, name))
+        elif base.endswith("_t") and base[:-2] in structs and pointers == "*":
+            out.append("P(Struct, %s, %s)" % (base[:-2], name))
+        elif base.endswith("_t") and base[:-2] in structs and pointers == "**":
+            out.append("P(StructArray, %s, %s)" % (base[:-2], name))
+    return out
+
+
+def plain_structs(headers):
+    """The header of each typedef'd struct other than the messages, e.g. vx_device for vx_device_t"""
+    structs = {}
+    for text in headers:
+        for match in re.finditer(r"\}\s*(vx_\w+)_t;", text):
+            name = match.group(1)
+            typedef = text.rindex("typedef", 0, match.start())
+            if not name.startswith(("vx_req_", "vx_resp_", "vx_evt_")) and text.startswith("typedef struct", typedef):
+                structs[name] = text
+    return structs
+
+
+def lines(macro, items, parameter="X"):
+    out = ["#define %s(%s) \\" % (macro, parameter)]
+    out += ["    %s \\" % item if item.startswith(parameter + "(") else "    X(%s) \\" % item for item in items]
+    out.append("")
+    return out
+
+
+def main():
+    vxc = read("Vxc.h")
+    requests = read("VxcRequests.h")
+    responses = read("VxcResponses.h")
+    events = read("VxcEvents.h")
+    errors = read("VxcErrors.h")
+
+    creates = set(re.findall(r"int vx_req_(\w+)_create\(vx_req_\w+_t \*\*req\)", requests))
+    response_structs = set(re.findall(r"\}\s*vx_resp_(\w+)_t;", responses))
+    event_structs = set(re.findall(r"\}\s*vx_evt_(\w+)_t;", events))
+
+    request_types = [e[4:] for e in enumerators(vxc, "vx_request_type") if e[4:] in creates]
+    response_types = [e[5:] for e in enumerators(vxc, "vx_response_type") if e[5:] in response_structs]
+    event_types = [e[4:] for e in enumerators(vxc, "vx_event_type") if e[4:] in event_structs]
+
+    seen = set()
+    error_codes = []
+    for name, value in re.findall(r"#define (VX_E_\w+)\s+(-?\d+)", errors):
+        if value not in seen:
+            seen.add(value)
+            error_codes.append(name)
+
+    out = [
+        "/* Generated by SDK/Simulator/tools/gen_tables.py from the headers in SDK/include, do not edit. */",
+        "#pragma once",
+        "",
+        "// X(name) for each request type with a vx_req_name_create() function",
+    ]
+    out += lines("VX_SIM_REQUEST_TYPES", request_types)
+    out.append("// X(name) for each response type with a vx_resp_name_t")
+    out += lines("VX_SIM_RESPONSE_TYPES", response_types)
+    out.append("// X(name) for each event type with a vx_evt_name_t")
+    out += lines("VX_SIM_EVENT_TYPES", event_types)
+    out.append("// X(VX_E_name) for each error code, the first name of each value")
+    out += lines("VX_SIM_ERROR_CODES", error_codes)
+    scalars = scalar_types([vxc, requests, responses, events, read("VxcTypes.h")])
+    out.append("// F(Kind, field) for the string and number fields of each message, Kind being String, Int,")
+    out.append("// Unsigned or Double")
+    for name in request_types:
+        out += lines("VX_SIM_REQ_FIELDS_" + name, fields(requests, "vx_req_" + name, scalars), "F")
+    for name in response_types:
+        out += lines("VX_SIM_RESP_FIELDS_" + name, fields(responses, "vx_resp_" + name, scalars), "F")
+    for name in event_types:
+        out += lines("VX_SIM_EVT_FIELDS_" + name, fields(events, "vx_evt_" + name, scalars), "F")
+    # Which of the pointers in a message it owns, for destroying it: the strings of its F(String, field) and these
+    structs = plain_structs([vxc, requests, responses, events])
+    referenced = set()
+    for macro, text, prefix, types, comment in [
+            ("VX_SIM_REQ_OWNED", requests, "vx_req_", request_types, "request owns besides its strings, Kind being"),
+            ("VX_SIM_RESP_OWNED", responses, "vx_resp_", response_types, "response owns besides its strings and request"),
+            ("VX_SIM_EVT_OWNED", events, "vx_evt_", event_types, "event owns besides its strings")]:
+        owned = []
+        for name in types:
+            for item in owned_pointers(text, prefix + name, structs, scalars):
+                owned.append("P(%s, %s" % (name, item[2:]))
+                if item.startswith(("P(Struct,", "P(StructArray,")):
+                    referenced.add(item[2:-1].split(", ")[1])
+        out.append("// P(name, Kind, type, field) for the pointers each " + comment)
+        if macro == "VX_SIM_REQ_OWNED":
+            out.append("// Data, StringArray, Struct or StructArray")
+        out += lines(macro, owned, "P")
+    out.append("// X(type) for each struct messages point to, and F(Kind, field) for its string and number fields. The")
+    out.append("// strings are owned by the struct; its pointers to other structs are not followed.")
+    out += lines("VX_SIM_OWNED_STRUCTS", sorted(referenced))
+    for struct in sorted(referenced):
+        out += lines("VX_SIM_STRUCT_FIELDS_" + struct, fields(structs[struct], struct, scalars), "F")
+    for header, enum in STRING_ENUMS:
+        macro = "VX_SIM_ENUM_" + enum.upper()
+        if macro.endswith("_T"):
+            macro = macro[:-2]
+        out.append("// X(enumerator) for %s" % enum)
+        out += lines(macro, enumerators(read(header), enum))
+    sys.stdout.write("\n".join(out) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
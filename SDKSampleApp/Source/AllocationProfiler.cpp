@@ -0,0 +1,178 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#include "AllocationProfiler.h"
+
+#include <math.h>
+#include <string.h>
+#include <thread>
+
+// Per thread, shared by all profiler instances. Plain data so that it can be used
+// from allocations made while the thread is being torn down.
+struct ThreadSampler {
+    int64_t bytesUntilSample;
+    uint64_t random;
+    bool started;
+};
+static thread_local ThreadSampler t_sampler;
+
+// Exponentially distributed, with the given mean
+static int64_t NextSampleDistance(ThreadSampler &sampler, size_t mean)
+{
+    // xorshift64*
+    sampler.random ^= sampler.random >> 12;
+    sampler.random ^= sampler.random << 25;
+    sampler.random ^= sampler.random >> 27;
+    uint64_t r = sampler.random * 0x2545F4914F6CDD1Dull;
+    double u = (double)((r >> 11) + 1) / 9007199254740992.0;    // (0, 1]
+    return (int64_t)(-log(u) * (double)mean) + 1;
+}
+
+AllocationProfiler::AllocationProfiler(size_t samplingInterval) :
+    m_samplingInterval(samplingInterval),
+    m_table(new Site[c_nMaxSites]),
+    m_sites(0),
+    m_samples(0),
+    m_droppedSamples(0)
+{
+    for (size_t i = 0; i < c_nMaxSites; ++i) {
+        Site &site = m_table[i];
+        site.m_hash.store(0, std::memory_order_relaxed);
+        site.m_ready.store(0, std::memory_order_relaxed);
+        site.m_nFrames = 0;
+        site.m_liveBytes.store(0, std::memory_order_relaxed);
+        site.m_liveObjects.store(0, std::memory_order_relaxed);
+        site.m_totalBytes.store(0, std::memory_order_relaxed);
+        site.m_totalObjects.store(0, std::memory_order_relaxed);
+    }
+}
+
+AllocationProfiler::~AllocationProfiler()
+{
+    delete[] m_table;
+}
+
+bool AllocationProfiler::ShouldSample(size_t bytes, float &weight)
+{
+    size_t interval = GetSamplingInterval();
+    if (interval == 0) {
+        return false;
+    }
+    ThreadSampler &sampler = t_sampler;
+    if (!sampler.started) {
+        sampler.random = ((uint64_t)(uintptr_t)&sampler * 0x9E3779B97F4A7C15ull) | 1;
+        sampler.bytesUntilSample = NextSampleDistance(sampler, interval);
+        sampler.started = true;
+    }
+    sampler.bytesUntilSample -= (int64_t)bytes;
+    if (sampler.bytesUntilSample > 0) {
+        return false;
+    }
+    sampler.bytesUntilSample = NextSampleDistance(sampler, interval);
+    // Probability of a block of this size being sampled is 1 - exp(-bytes / interval)
+    double n = bytes ? (double)bytes : 1.0;
+    weight = (float)(n / -expm1(-n / (double)interval));
+    return true;
+}
+
+uint32_t AllocationProfiler::HashFrames(void *const *frames, size_t count)
+{
+    // FNV-1a over the return addresses
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < count; ++i) {
+        h ^= (uint64_t)(uintptr_t)frames[i];
+        h *= 1099511628211ull;
+    }
+    uint32_t result = (uint32_t)(h ^ (h >> 32));
+    return result ? result : 1;
+}
+
+uint32_t AllocationProfiler::RecordAllocation(void *const *frames, size_t count, size_t bytes, float weight)
+{
+    if (count > c_nMaxFrames) {
+        count = c_nMaxFrames;
+    }
+    m_samples.fetch_add(1, std::memory_order_relaxed);
+    uint32_t hash = HashFrames(frames, count);
+    for (size_t probe = 0; probe < c_nMaxProbes; ++probe) {
+        size_t index = (hash + probe) & (c_nMaxSites - 1);
+        Site &site = m_table[index];
+        uint32_t h = site.m_hash.load(std::memory_order_acquire);
+        if (h == 0) {
+            if (site.m_hash.compare_exchange_strong(h, hash, std::memory_order_acq_rel)) {
+                site.m_nFrames = (uint32_t)count;
+                memcpy(site.m_frames, frames, count * sizeof(void *));
+                site.m_ready.store(1, std::memory_order_release);
+                m_sites.fetch_add(1, std::memory_order_relaxed);
+            }
+            // else h now holds the hash of the site that took the entry
+        }
+        if (h != 0 && h != hash) {
+            continue;
+        }
+        while (site.m_ready.load(std::memory_order_acquire) == 0) {
+            std::this_thread::yield();
+        }
+        if (site.m_nFrames != count || memcmp(site.m_frames, frames, count * sizeof(void *)) != 0) {
+            continue;
+        }
+        int64_t estimatedBytes = llround(weight);
+        int64_t estimatedObjects = llround(weight / (bytes ? (double)bytes : 1.0));
+        site.m_liveBytes.fetch_add(estimatedBytes, std::memory_order_relaxed);
+        site.m_liveObjects.fetch_add(estimatedObjects, std::memory_order_relaxed);
+        site.m_totalBytes.fetch_add(estimatedBytes, std::memory_order_relaxed);
+        site.m_totalObjects.fetch_add(estimatedObjects, std::memory_order_relaxed);
+        return (uint32_t)index + 1;
+    }
+    m_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+void AllocationProfiler::RecordFree(uint32_t site, size_t bytes, float weight)
+{
+    if (site == 0 || site > c_nMaxSites) {
+        return;
+    }
+    Site &entry = m_table[site - 1];
+    entry.m_liveBytes.fetch_sub(llround(weight), std::memory_order_relaxed);
+    entry.m_liveObjects.fetch_sub(llround(weight / (bytes ? (double)bytes : 1.0)), std::memory_order_relaxed);
+}
+
+void AllocationProfiler::GetSites(std::vector<SiteSnapshot> &sites) const
+{
+    sites.clear();
+    for (size_t i = 0; i < c_nMaxSites; ++i) {
+        const Site &site = m_table[i];
+        if (site.m_ready.load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        SiteSnapshot snapshot;
+        snapshot.frames.assign(site.m_frames, site.m_frames + site.m_nFrames);
+        snapshot.liveBytes = site.m_liveBytes.load(std::memory_order_relaxed);
+        snapshot.liveObjects = site.m_liveObjects.load(std::memory_order_relaxed);
+        snapshot.totalBytes = site.m_totalBytes.load(std::memory_order_relaxed);
+        snapshot.totalObjects = site.m_totalObjects.load(std::memory_order_relaxed);
+        sites.push_back(snapshot);
+    }
+}
+
+void AllocationProfiler::ResetTotals()
+{
+    for (size_t i = 0; i < c_nMaxSites; ++i) {
+        m_table[i].m_totalBytes.store(0, std::memory_order_relaxed);
+        m_table[i].m_totalObjects.store(0, std::memory_order_relaxed);
+    }
+    m_samples.store(0, std::memory_order_relaxed);
+    m_droppedSamples.store(0, std::memory_order_relaxed);
+}
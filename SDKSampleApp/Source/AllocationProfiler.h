@@ -0,0 +1,91 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocation site profile kept by the sampling mode of ParanoidAllocator.
+//
+// Allocations are sampled by bytes rather than by count: every thread counts down a
+// distance drawn from an exponential distribution whose mean is the sampling interval,
+// and the allocation that crosses it is sampled (Poisson sampling). A sample of n bytes
+// is weighted by the inverse of its probability, n / (1 - exp(-n / interval)), so the
+// per-site sums estimate the real totals whatever the size mix.
+//
+// Sites are keyed by their stack and kept in a fixed size open addressing table that
+// entries are never removed from, with atomic counters, so recording a sample or a free
+// takes no lock. When the table is full new sites are dropped and counted.
+class AllocationProfiler
+{
+public:
+    static const size_t c_nMaxFrames = 32;
+    static const size_t c_nMaxSites = 8192;     // power of 2
+
+    explicit AllocationProfiler(size_t samplingInterval);
+    ~AllocationProfiler();
+
+    // Mean number of bytes between two samples; 0 turns sampling off
+    void SetSamplingInterval(size_t bytes) { m_samplingInterval.store(bytes, std::memory_order_relaxed); }
+    size_t GetSamplingInterval() const { return m_samplingInterval.load(std::memory_order_relaxed); }
+
+    // Called for every allocation. Returns true if this one is sampled, with its weight in bytes.
+    bool ShouldSample(size_t bytes, float &weight);
+    // Returns the site to pass to RecordFree(), or 0 if the table is full
+    uint32_t RecordAllocation(void *const *frames, size_t count, size_t bytes, float weight);
+    // bytes and weight must be the values passed to RecordAllocation()
+    void RecordFree(uint32_t site, size_t bytes, float weight);
+
+    struct SiteSnapshot {
+        std::vector<void *> frames;     // innermost first
+        int64_t liveBytes;
+        int64_t liveObjects;
+        int64_t totalBytes;
+        int64_t totalObjects;
+    };
+    void GetSites(std::vector<SiteSnapshot> &sites) const;
+    // Clears the cumulative counters; live ones are left alone since their blocks still exist
+    void ResetTotals();
+
+    uint64_t GetSampleCount() const { return m_samples.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedSampleCount() const { return m_droppedSamples.load(std::memory_order_relaxed); }
+    size_t GetSiteCount() const { return m_sites.load(std::memory_order_relaxed); }
+
+private:
+    AllocationProfiler(const AllocationProfiler &); // disabled
+
+    static const size_t c_nMaxProbes = 64;
+
+    struct Site {
+        std::atomic<uint32_t> m_hash;   // 0 while the entry is free
+        std::atomic<uint32_t> m_ready;  // set once m_frames is written
+        uint32_t m_nFrames;
+        void *m_frames[c_nMaxFrames];
+        std::atomic<int64_t> m_liveBytes;
+        std::atomic<int64_t> m_liveObjects;
+        std::atomic<int64_t> m_totalBytes;
+        std::atomic<int64_t> m_totalObjects;
+    };
+
+    static uint32_t HashFrames(void *const *frames, size_t count);
+
+    std::atomic<size_t> m_samplingInterval;
+    Site *m_table;
+    std::atomic<size_t> m_sites;
+    std::atomic<uint64_t> m_samples;
+    std::atomic<uint64_t> m_droppedSamples;
+};
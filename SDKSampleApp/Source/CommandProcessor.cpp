@@ -19,15 +19,21 @@
 #define PRINT_SSG_HANDLE_ERROR() __PRINT_SSG_HANDLE_ERROR(2)
 
 
+#ifdef _WIN32
 #define snprintf _snprintf
 #define sscanf sscanf_s
+#else
+#include <sys/resource.h>
+#endif
 
 #include <thread>
+#include <atomic>
 #include <cctype>
+#include <fstream>
 
 bool SDKSampleApp::CheckHasConnectorHandle()
 {
-    if (m_connectorHandle.empty()) {
+    if (GetConnectorHandle().empty()) {
         SDKSampleApp::con_print("error: You must have a connector handle to perform this action.\n");
         return false;
     }
@@ -36,7 +42,7 @@ bool SDKSampleApp::CheckHasConnectorHandle()
 
 bool SDKSampleApp::CheckDisconnected()
 {
-    if (!m_connectorHandle.empty()) {
+    if (!GetConnectorHandle().empty()) {
         SDKSampleApp::con_print("error: You must be disconnected to perform this action.\n");
         return false;
     }
@@ -55,7 +61,12 @@ std::string SDKSampleApp::CheckAndGetDefaultAccountHandle()
 
 bool SDKSampleApp::CheckHasSessionHandle()
 {
-    if (m_SSGHandles.empty()) {
+    bool empty;
+    {
+        lock_guard<mutex> lock(m_sessionStateMutex);
+        empty = m_SSGHandles.empty();
+    }
+    if (empty) {
         PRINT_SESSION_HANDLE_ERROR();
         return false;
     }
@@ -64,7 +75,12 @@ bool SDKSampleApp::CheckHasSessionHandle()
 
 bool SDKSampleApp::CheckHasSessionGroupHandle()
 {
-    if (m_SSGHandles.empty()) {
+    bool empty;
+    {
+        lock_guard<mutex> lock(m_sessionStateMutex);
+        empty = m_SSGHandles.empty();
+    }
+    if (empty) {
         PRINT_GROUP_HANDLE_ERROR();
         return false;
     }
@@ -73,7 +89,12 @@ bool SDKSampleApp::CheckHasSessionGroupHandle()
 
 bool SDKSampleApp::CheckHasSessionOrSessionGroupHandle()
 {
-    if (m_SSGHandles.empty()) {
+    bool empty;
+    {
+        lock_guard<mutex> lock(m_sessionStateMutex);
+        empty = m_SSGHandles.empty();
+    }
+    if (empty) {
         PRINT_SSG_HANDLE_ERROR();
         return false;
     }
@@ -353,6 +374,24 @@ void SDKSampleApp::DeclareCommands()
     D("    -u user                URI of the participant.");
     D("    -on|-off               Turn on and off audio effect.");
     DECLARE_COMMAND(participanteffect, "-u user [-on|-off]", "Add an audio effect to a participant, on the render side.");
+    // spatialize
+    D("Default Behavior: Prints the client side spatializer state.");
+    D("");
+    D("Arguments:");
+    D("    -on|-off               Enable or disable client side spatialization of participant streams.");
+    D("    -u user                URI of the participant to position.");
+    D("    -p x y z               Position of the participant given by '-u'.");
+    D("    -remove                Stop spatializing the participant given by '-u'.");
+    D("    -min distance          Distance up to which a participant is heard at full volume. Default is 8.");
+    D("    -max distance          Distance beyond which a participant is silent. Default is 60.");
+    D("    -rolloff factor        Attenuation rolloff between '-min' and '-max'. Default is 1.");
+    D("");
+    D("Additional Notes:");
+    D("    Spatialization is applied locally to each participant's stream before mixing, using the");
+    D("    listener position of the most recently moved session (see 'move' and 'dance'), so it");
+    D("    works in non-positional channels. Mono streams are attenuated only, stereo streams are");
+    D("    also panned.");
+    DECLARE_COMMAND(spatialize, "[-on|-off] [-u user [-p x y z|-remove]] [-min distance] [-max distance] [-rolloff factor]", "Position participants on the render side without server round trips.");
     // focus
     D("State: Requires session handle for '-set' and sessiongroup handle for '-reset'.");
     D("");
@@ -587,11 +626,17 @@ void SDKSampleApp::DeclareCommands()
     D("                                       Defaults to 10 degrees per second (full circle in 36 seconds).");
     D("    -o oscillation_period_in_seconds   The distance oscillation period in seconds. Defaults to 9 seconds.");
     D("    -c x0 y0 z0             Rotate around the specified point. Defaults to origin: (0, 0, 0).");
+    D("    -to x1 y1 z1            Instead of rotating, move back and forth on the line from the '-c' point");
+    D("                            to this point.");
+    D("    -speed units_per_second Speed used with '-to'. Defaults to 1.");
+    D("    -eps epsilon            Skip an update if the position moved less than epsilon since the last one");
+    D("                            sent. Applies to all dancing sessions. Use 0 to always send. Defaults to 0.001.");
     D("");
     D("Additional Notes:");
     D("    See 'move' command notes for details and requirements on moving in 3D channels.");
-    D("    The 'dance' command starts a separate thread which updates the user's position in the 3D positional");
-    D("    channel with vx_req_session_set_3d_position_t request. It moves the user in X-Z plane around the specified");
+    D("    All dancing sessions are driven by one shared scheduler timer which updates the user's position in the 3D");
+    D("    positional channel with vx_req_session_set_3d_position_t request. Updates of sessions due on the same");
+    D("    scheduler tick are issued together. It moves the user in X-Z plane around the specified");
     D("    point (rotation center) with the specified constant angular velocity (possibly 0). The distance from the");
     D("    rotation center (rotation radius) oscillates between the specified minimum and maximum values with");
     D("    the specified period.");
@@ -604,7 +649,218 @@ void SDKSampleApp::DeclareCommands()
     D("         dance -rmin 0 -rmax 10 -a 0 -o 20");
     D("    To notice a change in your audio experience while moving within the sample application, you will need more");
     D("    than one player in the channel.");
-    DECLARE_COMMAND(dance, "[-sh session_handle] [-stop] [-ms update_milliseconds] [[-r distatance]|[-rmin min_distance -rmax max_distance]] [-a angualr_velocity_in_deg_per_sec] [-o oscillation_period_in_seconds] [-c x0 y0 z0]", "Starts/stops moving the user's position in 3D channel"); // "(3D channels only) Starts/stops rotating the user's position around the specified location with the specified angualr velocity and oscillation parameters"
+    DECLARE_COMMAND(dance, "[-sh session_handle] [-stop] [-ms update_milliseconds] [[-r distatance]|[-rmin min_distance -rmax max_distance]] [-a angualr_velocity_in_deg_per_sec] [-o oscillation_period_in_seconds] [-c x0 y0 z0] [-to x1 y1 z1 [-speed units_per_second]] [-eps epsilon]", "Starts/stops moving the user's position in 3D channel"); // "(3D channels only) Starts/stops rotating the user's position around the specified location with the specified angualr velocity and oscillation parameters"
+    // dancebench
+    D("Default Behavior: Dances 100 simulated sessions for 10 seconds and prints update rate and CPU use.");
+    D("");
+    D("Arguments:");
+    D("    -n sessions             Number of simulated sessions. Defaults to 100.");
+    D("    -s seconds              Duration of the run. Defaults to 10.");
+    D("    -ms update_milliseconds Update interval of every session. Defaults to 100.");
+    D("    -eps epsilon            Suppression epsilon for the run. Defaults to the current 'dance' setting.");
+    D("    -threads                Run the thread per session model for comparison.");
+    D("    -timers                 Run every session as a periodic timer of a vxplatform::TimerQueue instead.");
+    D("    -workers n              Worker threads running the timers with -timers. Defaults to 2.");
+    D("");
+    D("Additional Notes:");
+    D("    No requests are sent: every update builds and destroys a vx_req_session_set_3d_position_t request.");
+    D("    CPU use is the process time consumed during the run, so keep the rest of the application idle.");
+    D("    The console is blocked while the benchmark runs.");
+    DECLARE_COMMAND(dancebench, "[-n sessions] [-s seconds] [-ms update_milliseconds] [-eps epsilon] [-threads | -timers [-workers n]]", "Benchmark positional update scheduling.");
+    // allocbench
+    D("Default Behavior: Runs the same allocation workload on 8 threads against a strict, a sharded and a sampling");
+    D("                  ParanoidAllocator and prints the throughput and CPU use of each.");
+    D("");
+    D("Arguments:");
+    D("    -t threads              Number of allocating threads. Defaults to 8.");
+    D("    -n operations           Allocations, reallocations or frees per thread. Defaults to 200000.");
+    D("    -max bytes              Largest block allocated. Three quarters of the blocks are 256 bytes or less.");
+    D("                            Defaults to 8192.");
+    D("    -live blocks            Blocks each thread keeps allocated at most. Defaults to 512.");
+    D("    -strict|-sharded|-sampling");
+    D("                            Run only one mode.");
+    D("");
+    D("Additional Notes:");
+    D("    Each run uses its own allocator instance: the one serving the SDK, selected with the --paranoid command line");
+    D("    option, is not touched. Each thread frees its own blocks. The console is blocked while the benchmark runs.");
+    DECLARE_COMMAND(allocbench, "[-t threads] [-n operations] [-max bytes] [-live blocks] [-strict|-sharded|-sampling]", "Benchmark the ParanoidAllocator modes.");
+    // allocprofile
+    D("Default Behavior: Prints the call sites holding the most memory, from the allocation site profile the SDK");
+    D("                  allocator keeps in sampling mode.");
+    D("State: Requires the application to be started with --paranoid=sampling.");
+    D("");
+    D("Arguments:");
+    D("    file                    Writes the whole profile to this file instead, as folded stacks: one line per call");
+    D("                            site with its frames from the outermost one separated by ';', a space and the value.");
+    D("                            flamegraph.pl, speedscope and 'pprof -raw' conversions read this format.");
+    D("    -live                   Values are what is still allocated. This is the default.");
+    D("    -total                  Values are everything allocated since the start or the last -reset.");
+    D("    -objects                Values are block counts rather than bytes.");
+    D("    -reset                  Clears the -total values after writing them.");
+    D("    -interval bytes         Sets the mean number of bytes allocated between two samples. Defaults to 524288.");
+    D("                            0 stops sampling.");
+    D("");
+    D("Additional Notes:");
+    D("    Values are estimates: about one byte in every interval is sampled, and each sample is scaled up by the");
+    D("    inverse of its probability. Frames are symbolized when the profile is written.");
+    DECLARE_COMMAND(allocprofile, "[-live|-total] [-objects] [-reset] [-interval bytes] [file]", "Report the SDK allocation site profile.");
+    // heapscan
+    D("Default Behavior: Prints the progress of the background heap scanner of the SDK allocator.");
+    D("");
+    D("Arguments:");
+    D("    -budget percent         Starts the scanner, or changes its budget: the share of time it may spend checking");
+    D("                            blocks with the allocator locked. The --heapscan command line option does the same.");
+    D("    -stop                   Stops the scanner.");
+    D("");
+    D("Additional Notes:");
+    D("    The scanner checks the guards of every allocated block, and in strict mode the filler of every quarantined");
+    D("    block, a slice at a time. The first damaged block found is reported with the stack recorded when it was");
+    D("    allocated, and stops the scanner. A cycle is a complete pass over the heap.");
+    DECLARE_COMMAND(heapscan, "[-budget percent] [-stop]", "Control the background heap scanner.");
+    // udpframebench
+    D("Default Behavior: Frames 200000 packets per thread on 4 threads with a 16 byte header and a 16 byte trailer, first");
+    D("                  the way the UDP frame test callbacks used to, allocating and filling both for every packet,");
+    D("                  then with the current callbacks, and prints the packets per second of each.");
+    D("");
+    D("Arguments:");
+    D("    -n packets              Packets framed by each thread. Defaults to 200000.");
+    D("    -t threads              Number of sending threads. Defaults to 4.");
+    D("    -header bytes           Header length. Defaults to 16.");
+    D("    -trailer bytes          Trailer length. Defaults to 16.");
+    D("    -seq                    Put a sequence number in the header, so each packet takes its own header from the");
+    D("                            buffer pool. Requires a header of 4 bytes or more.");
+    D("");
+    D("Additional Notes:");
+    D("    The callbacks are called directly, nothing is sent. The VX_TEST_UDP_HEADER, VX_TEST_UDP_TRAILER and");
+    D("    VX_TEST_UDP_HEADER_SEQUENCE environment variables set what the SDK actually uses; they are read once, when");
+    D("    the SDK is initialized, and are not changed by this command.");
+    DECLARE_COMMAND(udpframebench, "[-n packets] [-t threads] [-header bytes] [-trailer bytes] [-seq]", "Benchmark the UDP frame test callbacks.");
+    // udpstats
+    D("Default Behavior: Prints, for each type of UDP packet the SDK sent (RTP, RTCP, SIP message and SIP keepalive),");
+    D("                  the packets and bytes sent, the send errors, the rates during the last complete second and");
+    D("                  the highest ones seen, and the average payload size.");
+    D("");
+    D("Arguments:");
+    D("    -histogram              Also prints how many payloads fell in each size range.");
+    D("    -reset                  Clears the counters after printing them.");
+    D("");
+    D("Additional Notes:");
+    D("    Packets are counted by the UDP frame callbacks, after they are sent. Bytes exclude the IP and UDP headers");
+    D("    but include the test header and trailer set with VX_TEST_UDP_HEADER and VX_TEST_UDP_TRAILER.");
+    D("    Compare the RTP rates across codec masks to see the voice bandwidth each one uses.");
+    DECLARE_COMMAND(udpstats, "[-histogram] [-reset]", "Show UDP packet rates and sizes per packet type.");
+    // udpcapture
+    D("Default Behavior: Prints the state of the capture of the UDP packets the SDK sends.");
+    D("");
+    D("Arguments:");
+    D("    -start file             Starts writing the packets to this pcap file.");
+    D("    -stop                   Stops the capture, once the packets already captured are written.");
+    D("    -snap bytes             Most bytes kept of each packet, including 28 bytes of IPv4 and UDP headers.");
+    D("                            Defaults to 65535.");
+    D("    -rotate megabytes       Starts a new file, file.1.pcap, file.2.pcap and so on, when this size is reached.");
+    D("    -files count            With -rotate, the number of files kept: the oldest one is overwritten.");
+    D("    -sample n               Captures one packet in every n. Defaults to 1.");
+    D("    -ring slots             Packets that can wait for the writer thread. Defaults to 1024.");
+    D("");
+    D("Additional Notes:");
+    D("    The SDK does not say where a packet is sent, so all of them go from 10.0.0.1 to 10.0.0.2: SIP on port");
+    D("    5060, RTP on port 6000 and RTCP on port 6001. In Wireshark, enable the rtp_udp heuristic or use Decode As");
+    D("    to see RTP and RTCP. Sending never waits for the file: packets that find the ring full are dropped and");
+    D("    counted.");
+    DECLARE_COMMAND(udpcapture, "[-start file [-snap bytes] [-rotate megabytes] [-files count] [-sample n] [-ring slots]] [-stop]", "Capture the UDP packets the SDK sends to a pcap file.");
+    // msgbus
+    D("Default Behavior: Lists the observers of the SDK responses and events, with the messages each one received,");
+    D("                  dropped and has waiting.");
+    D("");
+    D("Additional Notes:");
+    D("    Each observer receives only the response and event types it subscribed to. Synchronous observers are");
+    D("    called on the SDK listener thread. Asynchronous ones have their own queue and thread, and drop messages");
+    D("    when their queue is full rather than hold up the listener.");
+    DECLARE_COMMAND(msgbus, "", "List the SDK message observers.");
+    // listenerstats
+    D("Default Behavior: Shows how long the SDK responses and events waited before the listener thread was done with");
+    D("                  them, from the SDK signalling that messages are available.");
+    D("");
+    D("Optional Parameters:");
+    D("    -reset                  Starts counting again after printing.");
+    D("");
+    D("Additional Notes:");
+    D("    Percentiles are rounded up to a power of 2 microseconds. The listener thread does not wait for commands, so");
+    D("    these should stay low while a long command runs. What the listener prints is written by a console printer");
+    D("    thread, whose queue is shown too.");
+    DECLARE_COMMAND(listenerstats, "[-reset]", "Show the latency of the SDK message listener.");
+    // loadgen
+    D("Default Behavior: Shows the progress of the load generator: the requests of each kind issued, succeeded, failed");
+    D("                  and still waiting, their rate and their latency from being issued to their response.");
+    D("State: -start requires a connector handle (via 'connect' command).");
+    D("");
+    D("Optional Parameters:");
+    D("    -start                   Logs in virtual accounts and has them join channels, move, mute and send messages.");
+    D("    -accounts n              The number of accounts. Default is 10.");
+    D("    -channels m              The number of channels the accounts are spread over. Default is 2.");
+    D("    -ramp per_second         Logins, and joins, issued per second until every account is in. Default is 5.");
+    D("    -churn per_second        Joined accounts leaving, to join again, per second. Default is 0.");
+    D("    -s seconds               How long to run before leaving and logging out. Default is 60.");
+    D("    -phase start_seconds moves mutes messages");
+    D("                             From start_seconds on, issue that many of each per second over the joined");
+    D("                             accounts. May be repeated, in order. Default is 10 moves, 1 mute and 1 message.");
+    D("    -seed n                  Seeds the choice of accounts and positions. Default is 1.");
+    D("    -u prefix                Accounts are named .prefix-0. to .prefix-(n-1).; default: loadgen.");
+    D("    -wait                    Returns when the run is over, then shows the results.");
+    D("    -stop                    Leaves and logs out now.");
+    D("");
+    D("Additional Notes:");
+    D("    The load generator issues its requests without logging them; turn off response logging ('log -responses no')");
+    D("    to keep the console quiet too. Ops/s counts the successful requests over the time run so far.");
+    DECLARE_COMMAND(loadgen, "[-start [-accounts n] [-channels m] [-ramp per_second] [-churn per_second] [-s seconds] [-phase start_seconds moves mutes messages]... [-seed n] [-u prefix] [-wait]] [-stop]", "Run virtual accounts against the SDK and report request rates and latencies.");
+    // scenario
+    D("Default Behavior: Shows the progress of the scenario: each track's state, the line it is at, its commands, waits");
+    D("                  and timeouts, and how much later than due the commands ran.");
+    D("");
+    D("Optional Parameters:");
+    D("    -run file                Runs the scenario in file.");
+    D("    -set name=value          Sets a variable of the scenario, over its own 'set' line. May be repeated.");
+    D("    -stop                    Stops the scenario after the command it is running.");
+    D("");
+    D("Additional Notes:");
+    D("    A scenario is a script whose commands run on a timeline, in concurrent tracks:");
+    D("        # comment");
+    D("        set name value              a variable, used as $name or ${name}");
+    D("        track name                  the lines up to its 'end' run concurrently with the other tracks;");
+    D("                                    $track is the name. Lines outside tracks make up the track 'main'.");
+    D("          at seconds                waits until that time after the scenario started");
+    D("          after seconds             waits that long after the previous step was due");
+    D("          wait type [seconds] [text]");
+    D("                                    waits for a response or event (participant_added, resp_account_logout)");
+    D("                                    received since the previous command of the track, optionally with text");
+    D("                                    in its XML. Default timeout 30 seconds, after which the track fails.");
+    D("          repeat count [variable]   runs the lines up to its 'end' count times, with the iteration in $variable");
+    D("          end");
+    D("          anything else             a command");
+    D("        end");
+    D("    Times are seconds, or milliseconds with an ms suffix, e.g. 'after 250ms'. Steps are due when the scenario");
+    D("    says, not when the previous step happened to run, so timing errors do not add up. 'sleep' and 'file' are");
+    D("    not available. The scenario waits for the application lock like the console, so do not start it with");
+    D("    anything that keeps the lock until the scenario is done.");
+    DECLARE_COMMAND(scenario, "[-run file [-set name=value]...] [-stop]", "Run a script of timed, concurrent and event driven commands.");
+    // msglog
+    D("Default Behavior: Shows the message log being recorded, and the progress of the replay: the messages handed");
+    D("                  to the application, the time spent handling them and the resulting messages per second.");
+    D("");
+    D("Optional Parameters:");
+    D("    -record file             Records every request issued and every response and event received to file,");
+    D("                             replacing it, until -stop.");
+    D("    -replay file             Plays the responses and events of file back through the message observers and");
+    D("                             the handling of the listener thread, at the pace they were received.");
+    D("    -fast                    With -replay, as fast as they are handled instead.");
+    D("    -wait                    With -replay, returns when the replay is over, then shows the results.");
+    D("    -stop                    Stops recording and replaying.");
+    D("");
+    D("Additional Notes:");
+    D("    The log is binary, with the string and number fields of each message, not its lists. Requests are not issued");
+    D("    again, so a replay is best run without being connected: the handles and sessions it brings are tracked as");
+    D("    if they were live. Turn off response and event logging to measure the handling rather than the console.");
+    DECLARE_COMMAND(msglog, "[-record file] [-replay file [-fast] [-wait]] [-stop]", "Record the SDK messages to a file, or replay one.");
     // muteall
     D("Default Behavior: Mute all current participants in a channel except yourself.");
     D("State: Requires an account handle (via 'login' command).");
@@ -1202,20 +1458,96 @@ void SDKSampleApp::participanteffect(const vector<string> &cmd)
 
     string participant_uri = GetUserUri(user);
 
-    if (isOn) {
-        m_participantsEffectTimes[participant_uri] = 0;
-    } else {
-        auto iter = m_participantsEffectTimes.find(participant_uri);
-        if (iter == m_participantsEffectTimes.end()) {
-            con_print("\r * Error: Participant effect isn't activated: cannot switch off.\n");
-            return;
-        }
+    {
+        lock_guard<mutex> lock(m_participantsEffectMutex);
+        if (isOn) {
+            m_participantsEffectTimes[participant_uri] = 0;
+        } else {
+            auto iter = m_participantsEffectTimes.find(participant_uri);
+            if (iter == m_participantsEffectTimes.end()) {
+                con_print("\r * Error: Participant effect isn't activated: cannot switch off.\n");
+                return;
+            }
 
-        m_participantsEffectTimes.erase(participant_uri);
+            m_participantsEffectTimes.erase(iter);
+        }
+        m_hasParticipantEffects.store(!m_participantsEffectTimes.empty(), memory_order_release);
     }
 
     con_print("\r * Setting Audio Effect for User %s to %d\n", participant_uri.c_str(), isOn);
 }
+void SDKSampleApp::spatialize(const vector<string> &cmd)
+{
+    string user;
+    int enable = -1;
+    bool hasPosition = false;
+    bool remove = false;
+    double x = 0.0, y = 0.0, z = 0.0;
+    float minDistance, maxDistance, rolloff;
+    bool distanceModelChanged = false;
+    bool error = false;
+
+    m_spatializer.GetDistanceModel(minDistance, maxDistance, rolloff);
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-on" || *i == "-off") {
+            enable = (*i == "-on") ? 1 : 0;
+        } else if (*i == "-u") {
+            if (!nextArg(user, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-p") {
+            if (!nextArg(x, cmd, i, error) || !nextArg(y, cmd, i, error) || !nextArg(z, cmd, i, error)) {
+                break;
+            }
+            hasPosition = true;
+        } else if (*i == "-remove") {
+            remove = true;
+        } else if (*i == "-min" || *i == "-max" || *i == "-rolloff") {
+            double value;
+            string option = *i;
+            if (!nextArg(value, cmd, i, error)) {
+                break;
+            }
+            if (option == "-min") {
+                minDistance = (float)value;
+            } else if (option == "-max") {
+                maxDistance = (float)value;
+            } else {
+                rolloff = (float)value;
+            }
+            distanceModelChanged = true;
+        } else {
+            error = true;
+            break;
+        }
+    }
+
+    if (error || (hasPosition && remove) || (user.empty() && (hasPosition || remove)) || (!user.empty() && !hasPosition && !remove)) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    if (distanceModelChanged) {
+        m_spatializer.SetDistanceModel(minDistance, maxDistance, rolloff);
+    }
+    if (!user.empty()) {
+        string participant_uri = GetUserUri(user);
+        if (remove) {
+            m_spatializer.RemoveSource(participant_uri.c_str());
+        } else if (!m_spatializer.SetSourcePosition(participant_uri.c_str(), { (float)x, (float)y, (float)z })) {
+            con_print("\r * Error: cannot spatialize %s: too many participants or URI too long.\n", participant_uri.c_str());
+            return;
+        }
+    }
+    if (enable >= 0) {
+        m_spatializer.SetEnabled(enable == 1);
+    }
+
+    m_spatializer.GetDistanceModel(minDistance, maxDistance, rolloff);
+    con_print("\r * Client side spatializer %s: %zu participant(s), min %.2f, max %.2f, rolloff %.2f\n",
+            m_spatializer.IsEnabled() ? "on" : "off", m_spatializer.GetSourceCount(), minDistance, maxDistance, rolloff);
+}
+
 void SDKSampleApp::crash(const vector<string> &cmd)
 {
     if (!vx_get_crash_dump_generation()) {
@@ -1324,34 +1656,35 @@ void SDKSampleApp::state(const vector<string> &cmd)
     con_print("\r * \tToken Signing Key: '%s'\n", m_accessTokenKey.c_str());
     con_print("\r * \tMulti-tenancy mode: %s\n", m_isMultitenant ? "ON" : "OFF");
 
+    // Printed from a copy, so the listener thread is not held up and the sections agree
+    StateSnapshot snapshot;
+    GetStateSnapshot(snapshot);
+
     con_print("\r * \n");
     con_print("\r * Vivox Service Connections:\n");
-    if (m_connectorHandle.empty()) {
+    if (snapshot.connectorHandle.empty()) {
         con_print("\r * \t<none>\n");
     } else {
-        con_print("\r * \tConnector Handle: '%s'\n", m_connectorHandle.c_str());
+        con_print("\r * \tConnector Handle: '%s'\n", snapshot.connectorHandle.c_str());
     }
 
-    {
-        lock_guard<mutex> lock(m_accountHandleUserNameMutex);
-        con_print("\r * \n");
-        con_print("\r * Signed in User:\n");
-        if (m_accountHandles.empty()) {
-            con_print("\r * \t<none>\n");
-        } else {
-            for (auto &it : m_accountHandles) {
-                con_print("\r * \tUsername: '%s'\n", m_accountHandleUserNames[it].c_str());
-                con_print("\r * \tAccount Handle: '%s'\n", it.c_str());
-            }
+    con_print("\r * \n");
+    con_print("\r * Signed in User:\n");
+    if (snapshot.accounts.empty()) {
+        con_print("\r * \t<none>\n");
+    } else {
+        for (auto &it : snapshot.accounts) {
+            con_print("\r * \tUsername: '%s'\n", it.second.c_str());
+            con_print("\r * \tAccount Handle: '%s'\n", it.first.c_str());
         }
     }
 
     con_print("\r * \n");
     con_print("\r * Active Session Groups and their sessions:\n");
-    if (m_SSGHandles.empty()) {
+    if (snapshot.ssgHandles.empty()) {
         con_print("\r * \t<none>\n");
     } else {
-        vector<SSGPair> sortedHandles = m_SSGHandles;
+        vector<SSGPair> sortedHandles = snapshot.ssgHandles;
         sort(sortedHandles.begin(), sortedHandles.end());
         string previousSessionGroup;
         for (vector<SSGPair>::const_iterator itr = sortedHandles.begin(); itr != sortedHandles.end(); ++itr) {
@@ -1360,19 +1693,21 @@ void SDKSampleApp::state(const vector<string> &cmd)
                 con_print("\r * \tSession Group Handle: '%s'\n", itr->first.c_str());
             }
             con_print("\r * \t\tSession Handle: '%s'\n", itr->second.c_str());
-            auto session = m_sessions.find(itr->second);
-            if (session != m_sessions.end()) {
-                con_print("\r * \t\tChannel URI: '%s'\n", session->second->GetUri().c_str());
-                session->second->PrintParticipants("\r * \t\t\t%s\n");
+            auto session = snapshot.sessions.find(itr->second);
+            if (session != snapshot.sessions.end()) {
+                con_print("\r * \t\tChannel URI: '%s'\n", session->second.GetUri().c_str());
+                session->second.PrintParticipants("\r * \t\t\t%s\n");
             }
         }
     }
 
+    string defaultSessionGroup = snapshot.ssgHandles.empty() ? string() : snapshot.ssgHandles.front().first;
+    string defaultSession = snapshot.ssgHandles.empty() ? string() : snapshot.ssgHandles.front().second;
     con_print("\r * \n");
     con_print("\r * If the -sh or -gh options are ommited from commands that take them, the most\n");
     con_print("\r * recently added session group and session handle will be used. These are:\n");
-    con_print("\r * \tDefault Session Group: %s\n", DefaultSessionGroupHandle().empty() ? "<none>" : string("'" + DefaultSessionGroupHandle() + "'").c_str());
-    con_print("\r * \tDefault Session: %s\n", DefaultSessionHandle().empty() ? "<none>" : string("'" + DefaultSessionHandle() + "'").c_str());
+    con_print("\r * \tDefault Session Group: %s\n", defaultSessionGroup.empty() ? "<none>" : string("'" + defaultSessionGroup + "'").c_str());
+    con_print("\r * \tDefault Session: %s\n", defaultSession.empty() ? "<none>" : string("'" + defaultSession + "'").c_str());
 }
 
 void SDKSampleApp::sstats(const vector<string> &cmd)
@@ -1556,8 +1891,9 @@ void SDKSampleApp::login(const vector<string> &cmd)
         con_print("\r * username must start and end with a '.'\n");
         return;
     }
-    con_print("\r * Logging %s in with connector handle %s and account handle %s and display name %s\n", username.c_str(), m_connectorHandle.c_str(), accountHandle.empty() ? "<AUTOGENERATE>" : accountHandle.c_str(), displayName.empty() ? "<EMPTY>" : displayName.c_str());
-    account_anonymous_login(username, m_connectorHandle, accountHandle, displayName, frequency, langs, autoAcceptBuddies);
+    string connectorHandle = GetConnectorHandle();
+    con_print("\r * Logging %s in with connector handle %s and account handle %s and display name %s\n", username.c_str(), connectorHandle.c_str(), accountHandle.empty() ? "<AUTOGENERATE>" : accountHandle.c_str(), displayName.empty() ? "<EMPTY>" : displayName.c_str());
+    account_anonymous_login(username, connectorHandle, accountHandle, displayName, frequency, langs, autoAcceptBuddies);
 }
 
 void SDKSampleApp::addsession(const vector<string> &cmd)
@@ -1583,30 +1919,1146 @@ void SDKSampleApp::addsession(const vector<string> &cmd)
     sessionGroupHandle = DefaultSessionGroupHandle();
 
     for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
-        if (*i == "-c") {
-            if (!nextArg(channel, cmd, i, error)) {
+        if (*i == "-c") {
+            if (!nextArg(channel, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-gh") {
+            if (!nextArg(sessionGroupHandle, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-sh") {
+            if (!nextArg(sessionHandle, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-joinmuted") {
+            joinmuted = true;
+        } else if (*i == "-audio") {
+            if (!nextArg(audio, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-text") {
+            if (!nextArg(text, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-ah") {
+            if (!nextArg(accountHandle, cmd, i, error)) {
+                break;
+            }
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (sessionHandle.empty()) {
+        sessionHandle = channel;
+    }
+    if (sessionGroupHandle.empty()) {
+        sessionGroupHandle = "sg_" + sessionHandle;
+    }
+    if (error || channel.empty() || sessionGroupHandle.empty() || sessionHandle.empty()) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+    con_print(
+            "\r * Adding channel %s (muted=%s) (audio=%s) (text=%s) to session group %s with handle %s\n",
+            channel.c_str(),
+            joinmuted ? "yes" : "no",
+            audio ? "yes" : "no",
+            text ? "yes" : "no",
+            sessionGroupHandle.c_str(),
+            sessionHandle.c_str());
+
+    // note: we will add this pair to m_SSGHandles when handling a successful resp_sessiongroup_add_session
+    sessiongroup_add_session(accountHandle, sessionGroupHandle, sessionHandle, channel, joinmuted, audio, text);
+}
+
+void SDKSampleApp::removesession(const vector<string> &cmd)
+{
+    string sessionHandle;
+    string sessionGroupHandle;
+    bool error = false;
+
+    if (!CheckHasSessionHandle()) {
+        return;
+    }
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-sh") {
+            if (!nextArg(sessionHandle, cmd, i, error)) {
+                break;
+            }
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (sessionHandle.empty()) {
+        sessionGroupHandle = DefaultSessionGroupHandle();
+        sessionHandle = DefaultSessionHandle();
+    } else {
+        sessionGroupHandle = FindSessionGroupHandleBySessionHandle(sessionHandle);
+        if (sessionGroupHandle.empty()) {
+            con_print("error: The object referred to by the parameter 'session_handle' does not exist.\n");
+            return;
+        }
+    }
+    if (error || sessionHandle.empty()) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+    con_print("\r * Removing session %s from session group %s\n", sessionHandle.c_str(), sessionGroupHandle.c_str());
+    // note: we will remove this pair from m_SSGHandles when handling a successful resp_sessiongroup_remove_session
+    sessiongroup_remove_session(sessionGroupHandle, sessionHandle);
+}
+
+static string FormatCoordinate(double x)
+{
+    if (x < 0.001 && x > -0.001 && x != 0) {
+        return "approximately 0";
+    } else {
+        stringstream ss;
+        ss << x;
+        return ss.str();
+    }
+}
+
+void SDKSampleApp::move(const vector<string> &cmd)
+{
+    string scmd;
+    double delta = 0;
+    string sessionHandle;
+    bool error = false;
+
+    if (!CheckHasSessionHandle()) {
+        return;
+    }
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-origin") {
+            scmd = *i;
+        } else if (*i == "-forward" || *i == "-back" || *i == "-left" || *i == "-right" || *i == "-up" || *i == "-down" || *i == "-turnleft" || *i == "-turnright") {
+            scmd = *i;
+            if (!nextArg(delta, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-sh") {
+            if (!nextArg(sessionHandle, cmd, i, error)) {
+                break;
+            }
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (sessionHandle.empty()) {
+        sessionHandle = DefaultSessionHandle();
+    }
+    if (error || sessionHandle.empty() || (!scmd.empty() && scmd != "-origin" && delta == 0)) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    if (scmd == "-origin") {
+        con_print("\r * Moving Listener Position to the origin\n");
+        req_move_origin(sessionHandle);
+    } else if (scmd == "-forward") {
+        con_print("\r * Moving Listener Position Forward by %f\n", delta);
+        req_move_forward(sessionHandle, delta);
+    } else if (scmd == "-back") {
+        con_print("\r * Moving Listener Position Back by %f\n", delta);
+        req_move_back(sessionHandle, delta);
+    } else if (scmd == "-left") {
+        con_print("\r * Moving Listener Position Left by %f\n", delta);
+        req_move_left(sessionHandle, delta);
+    } else if (scmd == "-right") {
+        con_print("\r * Moving Listener Position Right by %f\n", delta);
+        req_move_right(sessionHandle, delta);
+    } else if (scmd == "-up") {
+        con_print("\r * Moving Listener Position Up by %f\n", delta);
+        req_move_up(sessionHandle, delta);
+    } else if (scmd == "-down") {
+        con_print("\r * Moving Listener Position Down by %f\n", delta);
+        req_move_down(sessionHandle, delta);
+    } else if (scmd == "-turnleft") {
+        con_print("\r * Turning Listener Left (Anti-Clockwise) by %f\n", delta);
+        req_turn_left(sessionHandle, delta);
+    } else if (scmd == "-turnright") {
+        con_print("\r * Turning Listener Right (Clockwise) by %f\n", delta);
+        req_turn_right(sessionHandle, delta);
+    } else {
+        SampleAppPosition position;
+        double headingDegrees;
+        GetListenerPosition(sessionHandle, position);
+        GetListenerHeadingDegrees(sessionHandle, headingDegrees);
+        con_print("\r * Position: {%s, %s, %s}\n", FormatCoordinate(position.x).c_str(), FormatCoordinate(position.y).c_str(), FormatCoordinate(position.z).c_str());
+        con_print("\r * Heading Degrees: %s\n", FormatCoordinate(headingDegrees).c_str());
+    }
+}
+
+void SDKSampleApp::dance(const vector<string> &cmd)
+{
+    string scmd;
+    string sessionHandle;
+    bool error = false;
+    bool stop = false;
+    double x0 = 0;
+    double y0 = 0;
+    double z0 = 0;
+    double rmin = 1;
+    double rmax = 10;
+    double angularVelocityDegPerSec = 10; // 36 seconds for a full circle
+    double oscillationPeriodSeconds = 9; // rmin -> rmax -> rmin in 9 seconds
+    int updateMilliseconds = 100;
+    bool line = false;
+    double x1 = 0;
+    double y1 = 0;
+    double z1 = 0;
+    double speed = 1;
+    double epsilon = -1;
+
+
+    if (!CheckHasSessionHandle()) {
+        return;
+    }
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-sh") {
+            if (!nextArg(sessionHandle, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-to") {
+            if (
+                !nextArg(x1, cmd, i, error) ||
+                !nextArg(y1, cmd, i, error) ||
+                !nextArg(z1, cmd, i, error))
+            {
+                break;
+            }
+            line = true;
+        } else if (*i == "-speed") {
+            if (!nextArg(speed, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-eps") {
+            if (!nextArg(epsilon, cmd, i, error)) {
+                break;
+            }
+            if (epsilon < 0) {
+                con_print("error: %s: -eps argument must not be negative\n", cmd[0].c_str());
+                error = true;
+                break;
+            }
+        } else if (*i == "-stop") {
+            stop = true;
+        } else if (*i == "-c") {
+            if (
+                !nextArg(x0, cmd, i, error) ||
+                !nextArg(y0, cmd, i, error) ||
+                !nextArg(z0, cmd, i, error))
+            {
+                break;
+            }
+        } else if (*i == "-r") {
+            if (!nextArg(rmin, cmd, i, error)) {
+                break;
+            }
+            rmax = rmin;
+        } else if (*i == "-rmin") {
+            if (!nextArg(rmin, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-rmax") {
+            if (!nextArg(rmax, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-a") {
+            if (!nextArg(angularVelocityDegPerSec, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-o") {
+            if (!nextArg(oscillationPeriodSeconds, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-ms") {
+            if (!nextArg(updateMilliseconds, cmd, i, error)) {
+                break;
+            }
+            if (updateMilliseconds <= 0) {
+                con_print("error: %s: -ms argument must be a positive integer\n", cmd[0].c_str());
+                error = true;
+                break;
+            }
+        } else {
+            error = true;
+            break;
+        }
+    }
+
+    if (sessionHandle.empty()) {
+        sessionHandle = DefaultSessionHandle();
+    }
+    if (error || sessionHandle.empty()) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    // Find the referenced session
+    if (!IsSessionKnown(sessionHandle)) {
+        con_print("error: session with handle '%s' not found\n", sessionHandle.c_str());
+        return;
+    }
+
+    if (epsilon >= 0) {
+        m_positionScheduler.SetEpsilon(epsilon);
+    }
+
+    // Start dancing
+    if (stop) {
+        if (!m_positionScheduler.Cancel(sessionHandle)) {
+            con_print("\r * Session '%s' is not dancing\n", sessionHandle.c_str());
+        }
+        return;
+    }
+
+    std::shared_ptr<PositionScheduler::Trajectory> trajectory;
+    PositionScheduler::Position center = { x0, y0, z0 };
+    if (line) {
+        PositionScheduler::Position to = { x1, y1, z1 };
+        trajectory = std::make_shared<PositionScheduler::LineTrajectory>(center, to, speed);
+    } else {
+        trajectory = std::make_shared<PositionScheduler::OrbitTrajectory>(center, rmin, rmax, angularVelocityDegPerSec, oscillationPeriodSeconds);
+    }
+    m_positionScheduler.Schedule(sessionHandle, trajectory, (unsigned int)updateMilliseconds);
+}
+
+// Total CPU time of the process, in milliseconds
+static double ProcessCpuMilliseconds()
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return (double)(kernel.QuadPart + user.QuadPart) / 10000.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#endif
+}
+
+// Builds the request an update would issue, without issuing it
+static void DanceBenchBuildRequest(const string &sessionHandle, const PositionScheduler::Position &position)
+{
+    vx_req_session_set_3d_position *req;
+    vx_req_session_set_3d_position_create(&req);
+    safe_replace_string(&req->session_handle, sessionHandle.c_str());
+    req->req_disposition_type = req_disposition_no_reply_required;
+    req->listener_position[0] = req->speaker_position[0] = position.x;
+    req->listener_position[1] = req->speaker_position[1] = position.y;
+    req->listener_position[2] = req->speaker_position[2] = position.z;
+    destroy_req(&req->base);
+}
+
+// The thread per session model 'dance' used before PositionScheduler, kept for comparison
+struct DanceBenchThread {
+    string sessionHandle;
+    std::shared_ptr<PositionScheduler::Trajectory> trajectory;
+    int updateMilliseconds;
+    vxplatform::os_event_handle stopEvent;
+    vxplatform::os_thread_handle thread;
+    std::atomic<long long> *sent;
+    std::atomic<long long> *wakeups;
+};
+
+static vxplatform::os_error_t DanceBenchThreadProc(void *arg)
+{
+    DanceBenchThread *pThis = reinterpret_cast<DanceBenchThread *>(arg);
+    double t0 = get_millisecond_tick_counter();
+    do {
+        double t = get_millisecond_tick_counter() - t0;
+        PositionScheduler::Position position;
+        pThis->trajectory->Evaluate(t, position);
+        DanceBenchBuildRequest(pThis->sessionHandle, position);
+        (*pThis->sent)++;
+        (*pThis->wakeups)++;
+
+        t = get_millisecond_tick_counter() - t0;
+        double tEnd = (floor(t / pThis->updateMilliseconds) + 1) * pThis->updateMilliseconds;
+        int delay = (int)(tEnd - t);
+        if (delay <= 0) {
+            delay = pThis->updateMilliseconds;
+        }
+        if (0 == wait_event(pThis->stopEvent, delay)) {
+            break;
+        }
+    } while (true);
+    return 0;
+}
+
+// A session of the timer queue model: the same work as a thread per session, on shared threads
+struct DanceBenchTimer {
+    string sessionHandle;
+    std::shared_ptr<PositionScheduler::Trajectory> trajectory;
+    double t0;
+    std::atomic<long long> *sent;
+    std::atomic<long long> *wakeups;
+};
+
+static void DanceBenchTimerProc(void *arg)
+{
+    DanceBenchTimer *pThis = reinterpret_cast<DanceBenchTimer *>(arg);
+    PositionScheduler::Position position;
+    pThis->trajectory->Evaluate(get_millisecond_tick_counter() - pThis->t0, position);
+    DanceBenchBuildRequest(pThis->sessionHandle, position);
+    (*pThis->sent)++;
+    (*pThis->wakeups)++;
+}
+
+void SDKSampleApp::dancebench(const vector<string> &cmd)
+{
+    int sessions = 100;
+    int seconds = 10;
+    int updateMilliseconds = 100;
+    double epsilon = m_positionScheduler.GetEpsilon();
+    bool threads = false;
+    bool timers = false;
+    int workers = 2;
+    bool error = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-n") {
+            if (!nextArg(sessions, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-s") {
+            if (!nextArg(seconds, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-ms") {
+            if (!nextArg(updateMilliseconds, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-eps") {
+            if (!nextArg(epsilon, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-threads") {
+            threads = true;
+        } else if (*i == "-timers") {
+            timers = true;
+        } else if (*i == "-workers") {
+            if (!nextArg(workers, cmd, i, error)) {
+                break;
+            }
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (error || sessions <= 0 || seconds <= 0 || updateMilliseconds <= 0 || epsilon < 0 || (threads && timers) || workers <= 0) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    // Same defaults as 'dance', with the centers spread so the sessions do not move in lockstep
+    vector<std::shared_ptr<PositionScheduler::Trajectory> > trajectories;
+    for (int n = 0; n < sessions; ++n) {
+        PositionScheduler::Position center = { (double)(n % 10) * 20, 0, (double)(n / 10) * 20 };
+        trajectories.push_back(std::make_shared<PositionScheduler::OrbitTrajectory>(center, 1, 10, 10, 9));
+    }
+
+    std::atomic<long long> sent(0);
+    std::atomic<long long> wakeups(0);
+    long long suppressed = 0;
+    double cpu0 = ProcessCpuMilliseconds();
+    double t0 = get_millisecond_tick_counter();
+    if (threads) {
+        vector<DanceBenchThread> dancers((size_t)sessions);
+        for (int n = 0; n < sessions; ++n) {
+            DanceBenchThread &dancer = dancers[n];
+            dancer.sessionHandle = "bench" + to_string(n);
+            dancer.trajectory = trajectories[n];
+            dancer.updateMilliseconds = updateMilliseconds;
+            dancer.sent = &sent;
+            dancer.wakeups = &wakeups;
+            create_event(&dancer.stopEvent);
+            create_thread(&DanceBenchThreadProc, &dancer, &dancer.thread);
+        }
+        thread_sleep((unsigned long long)seconds * 1000);
+        for (int n = 0; n < sessions; ++n) {
+            set_event(dancers[n].stopEvent);
+        }
+        for (int n = 0; n < sessions; ++n) {
+            join_thread(dancers[n].thread);
+            delete_event(dancers[n].stopEvent);
+        }
+    } else if (timers) {
+        vector<DanceBenchTimer> dancers((size_t)sessions);
+        WorkerPool pool((size_t)workers, "DanceBench");
+        TimerQueue queue(&pool);
+        for (int n = 0; n < sessions; ++n) {
+            DanceBenchTimer &dancer = dancers[n];
+            dancer.sessionHandle = "bench" + to_string(n);
+            dancer.trajectory = trajectories[n];
+            dancer.t0 = t0;
+            dancer.sent = &sent;
+            dancer.wakeups = &wakeups;
+            queue.Schedule(0, (unsigned long long)updateMilliseconds, &DanceBenchTimerProc, &dancer);
+        }
+        thread_sleep((unsigned long long)seconds * 1000);
+        // The queue goes first, then the pool runs what was already posted
+    } else {
+        // Without a pool, on the one thread of the queue
+        TimerQueue queue(NULL);
+        PositionScheduler scheduler(&queue);
+        scheduler.SetEpsilon(epsilon);
+        scheduler.SetSink([&sent](const std::vector<PositionScheduler::Update> &updates) {
+            for (auto i = updates.begin(); i != updates.end(); ++i) {
+                DanceBenchBuildRequest(i->sessionHandle, i->position);
+            }
+            sent += (long long)updates.size();
+        });
+        for (int n = 0; n < sessions; ++n) {
+            scheduler.Schedule("bench" + to_string(n), trajectories[n], (unsigned int)updateMilliseconds);
+        }
+        thread_sleep((unsigned long long)seconds * 1000);
+        scheduler.Stop();
+        PositionScheduler::Stats stats;
+        scheduler.GetStats(stats);
+        wakeups = (long long)stats.wakeups;
+        suppressed = (long long)stats.suppressed;
+    }
+    double elapsed = (get_millisecond_tick_counter() - t0) / 1000.0;
+    double cpu = (ProcessCpuMilliseconds() - cpu0) / 1000.0;
+
+    const char *mode = threads ? "thread per session" : timers ? "timer queue" : "shared scheduler";
+    int threadCount = threads ? sessions : timers ? workers + 1 : 1;
+    con_print("\r * dancebench (%s): %d sessions, %d ms interval, %.2f s\n", mode, sessions, updateMilliseconds, elapsed);
+    con_print("\r   requests/s: %.1f (expected %.1f), suppressed: %lld\n", sent / elapsed, sessions * 1000.0 / updateMilliseconds, suppressed);
+    con_print("\r   wakeups/s: %.1f, threads: %d\n", wakeups / elapsed, threadCount);
+    con_print("\r   cpu: %.3f s (%.2f%% of one core)\n", cpu, 100.0 * cpu / elapsed);
+}
+
+struct AllocBenchThread {
+    ParanoidAllocator *allocator;
+    int operations;
+    int maxBytes;
+    int liveBlocks;
+    unsigned int seed;
+    vxplatform::os_thread_handle thread;
+};
+
+static vxplatform::os_error_t AllocBenchThreadProc(void *arg)
+{
+    AllocBenchThread *pThis = reinterpret_cast<AllocBenchThread *>(arg);
+    vector<void *> live((size_t)pThis->liveBlocks, (void *)NULL);
+    unsigned int seed = pThis->seed;
+    int smallBytes = pThis->maxBytes < 256 ? pThis->maxBytes : 256;
+    for (int n = 0; n < pThis->operations; ++n) {
+        seed = seed * 1103515245 + 12345;
+        unsigned int r = seed >> 8;
+        void *&slot = live[r % live.size()];
+        size_t bytes = 1 + (size_t)((r >> 10) % (unsigned int)((r & 3) ? smallBytes : pThis->maxBytes));
+        if (slot == NULL) {
+            slot = pThis->allocator->paranoidAlloc(bytes);
+            ((char *)slot)[0] = ((char *)slot)[bytes - 1] = 1;
+        } else if ((r & 0x1c) == 0) {
+            slot = pThis->allocator->paranoidRealloc(slot, bytes);
+        } else {
+            pThis->allocator->paranoidFree(slot);
+            slot = NULL;
+        }
+    }
+    for (vector<void *>::const_iterator i = live.begin(); i != live.end(); ++i) {
+        if (*i) {
+            pThis->allocator->paranoidFree(*i);
+        }
+    }
+    return 0;
+}
+
+static int AllocBenchSilentOutput(const char *, ...)
+{
+    return 0;
+}
+
+// Runs the workload against a new allocator in the given mode, returns the elapsed seconds
+static double AllocBenchRun(ParanoidAllocator::Mode mode, int threads, int operations, int maxBytes, int liveBlocks, double &cpu, ParanoidAllocator::Stats &stats)
+{
+    std::unique_ptr<ParanoidAllocator> allocator(new ParanoidAllocator(mode));
+    allocator->SetOutputFunction(&AllocBenchSilentOutput);
+    vector<AllocBenchThread> workers((size_t)threads);
+    double cpu0 = ProcessCpuMilliseconds();
+    double t0 = get_millisecond_tick_counter();
+    for (int n = 0; n < threads; ++n) {
+        AllocBenchThread &worker = workers[n];
+        worker.allocator = allocator.get();
+        worker.operations = operations;
+        worker.maxBytes = maxBytes;
+        worker.liveBlocks = liveBlocks;
+        worker.seed = 7919 * (unsigned int)(n + 1);
+        create_thread(&AllocBenchThreadProc, &worker, &worker.thread);
+    }
+    for (int n = 0; n < threads; ++n) {
+        join_thread(workers[n].thread);
+    }
+    double elapsed = (get_millisecond_tick_counter() - t0) / 1000.0;
+    cpu = (ProcessCpuMilliseconds() - cpu0) / 1000.0;
+    allocator->GetStats(stats);
+    return elapsed;
+}
+
+void SDKSampleApp::allocbench(const vector<string> &cmd)
+{
+    int threads = 8;
+    int operations = 200000;
+    int maxBytes = 8192;
+    int liveBlocks = 512;
+    int only = -1;
+    bool error = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-t") {
+            if (!nextArg(threads, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-n") {
+            if (!nextArg(operations, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-max") {
+            if (!nextArg(maxBytes, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-live") {
+            if (!nextArg(liveBlocks, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-strict") {
+            only = ParanoidAllocator::modeStrict;
+        } else if (*i == "-sharded") {
+            only = ParanoidAllocator::modeSharded;
+        } else if (*i == "-sampling") {
+            only = ParanoidAllocator::modeSampling;
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (error || threads <= 0 || operations <= 0 || maxBytes <= 0 || liveBlocks <= 0) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    con_print("\r * allocbench: %d threads, %d operations each, blocks up to %d bytes, %d live blocks per thread\n", threads, operations, maxBytes, liveBlocks);
+    double strictRate = 0;
+    const ParanoidAllocator::Mode modes[] = { ParanoidAllocator::modeStrict, ParanoidAllocator::modeSharded, ParanoidAllocator::modeSampling };
+    for (size_t pass = 0; pass < sizeof(modes) / sizeof(modes[0]); ++pass) {
+        ParanoidAllocator::Mode mode = modes[pass];
+        if (only >= 0 && mode != only) {
+            continue;
+        }
+        double cpu;
+        ParanoidAllocator::Stats stats;
+        double elapsed = AllocBenchRun(mode, threads, operations, maxBytes, liveBlocks, cpu, stats);
+        double rate = (double)threads * operations / elapsed;
+        con_print("\r   %-8s: %.3f s, %.0f operations/s, cpu %.3f s, peak %ld bytes", ParanoidAllocator::GetModeName(mode), elapsed, rate, cpu, stats.m_lPeakAllocated);
+        if (mode == ParanoidAllocator::modeStrict) {
+            strictRate = rate;
+            con_print("\n");
+        } else if (strictRate > 0) {
+            con_print(", %.1fx strict\n", rate / strictRate);
+        } else {
+            con_print("\n");
+        }
+    }
+}
+
+void SDKSampleApp::allocprofile(const vector<string> &cmd)
+{
+    bool live = true;
+    bool objects = false;
+    bool reset = false;
+    int interval = 0;
+    bool setInterval = false;
+    string file;
+    bool error = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-live") {
+            live = true;
+        } else if (*i == "-total") {
+            live = false;
+        } else if (*i == "-objects") {
+            objects = true;
+        } else if (*i == "-reset") {
+            reset = true;
+        } else if (*i == "-interval") {
+            if (!nextArg(interval, cmd, i, error)) {
+                break;
+            }
+            setInterval = true;
+        } else if (file.empty() && !i->empty() && i->at(0) != '-') {
+            file = *i;
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (error || interval < 0) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    ParanoidAllocator &allocator = ParanoidAllocator::GetInstance();
+    if (allocator.GetMode() != ParanoidAllocator::modeSampling) {
+        con_print("\r * allocprofile: the SDK allocator is in %s mode, start the application with --paranoid=sampling\n", ParanoidAllocator::GetModeName(allocator.GetMode()));
+        return;
+    }
+    if (!ParanoidAllocator::HasProfileStacks()) {
+        con_print("\r * allocprofile: stack traces are not available on this platform, call sites are reported as [unknown]\n");
+    }
+    if (setInterval) {
+        allocator.SetProfileSamplingInterval((size_t)interval);
+        con_print("\r * allocprofile: sampling one byte in %d\n", interval);
+    }
+    if (!file.empty()) {
+        ParanoidAllocator::ProfileValue value = live ?
+            (objects ? ParanoidAllocator::profileLiveObjects : ParanoidAllocator::profileLiveBytes) :
+            (objects ? ParanoidAllocator::profileTotalObjects : ParanoidAllocator::profileTotalBytes);
+        size_t sites;
+        if (allocator.WriteProfile(file.c_str(), value, sites)) {
+            con_print("\r * allocprofile: %u call site(s) written to %s\n", (unsigned int)sites, file.c_str());
+        } else {
+            con_print("\r * allocprofile: unable to write %s\n", file.c_str());
+        }
+    } else if (!setInterval && !reset) {
+        allocator.Dump();
+    }
+    if (reset) {
+        allocator.ResetProfile();
+        con_print("\r * allocprofile: cumulative values cleared\n");
+    }
+}
+
+void SDKSampleApp::heapscan(const vector<string> &cmd)
+{
+    int budget = -1;
+    bool error = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-budget") {
+            if (!nextArg(budget, cmd, i, error)) {
+                break;
+            }
+            if (budget < 0 || budget > 100) {
+                error = true;
+                break;
+            }
+        } else if (*i == "-stop") {
+            budget = 0;
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (error) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    ParanoidAllocator &allocator = ParanoidAllocator::GetInstance();
+    if (budget >= 0) {
+        allocator.SetScanBudget((unsigned int)budget);
+    }
+    ParanoidAllocator::ScanStats stats;
+    allocator.GetScanStats(stats);
+    con_print("\r * heapscan: %s, budget %u%%, %s mode\n", allocator.GetScanBudget() ? "running" : "stopped", allocator.GetScanBudget(), ParanoidAllocator::GetModeName(allocator.GetMode()));
+    con_print("\r   cycles: %llu, last cycle %.3f s\n", (unsigned long long)stats.m_nCycles, stats.m_dLastCycleSeconds);
+    con_print("\r   checked: %llu blocks, %llu bytes\n", (unsigned long long)stats.m_nBlocksChecked, (unsigned long long)stats.m_nBytesChecked);
+    if (stats.m_bCorruptionFound) {
+        con_print("\r   corruption found, see the report above\n");
+    }
+}
+
+struct UdpFrameBenchThread {
+    bool legacy;
+    int packets;
+    long hdrSize;
+    long trlSize;
+    vx_test_udp_frames *frames;
+    vxplatform::os_thread_handle thread;
+};
+
+static vxplatform::os_error_t UdpFrameBenchThreadProc(void *arg)
+{
+    UdpFrameBenchThread *pThis = reinterpret_cast<UdpFrameBenchThread *>(arg);
+    char payload[160];
+    memset(payload, 0, sizeof(payload));
+    for (int n = 0; n < pThis->packets; ++n) {
+        void *header = NULL;
+        void *trailer = NULL;
+        int headerLen = 0;
+        int trailerLen = 0;
+        if (pThis->legacy) {
+            // What the callbacks did before the buffers were shared and pooled
+            if (pThis->hdrSize) {
+                char *hdr = new char[pThis->hdrSize];
+                for (long i = 0; i < pThis->hdrSize; i++) {
+                    hdr[i] = (char)(i % 256);
+                }
+                header = hdr;
+                headerLen = (int)pThis->hdrSize;
+            }
+            if (pThis->trlSize) {
+                char *trl = new char[pThis->trlSize];
+                for (long i = 0; i < pThis->trlSize; i++) {
+                    trl[i] = (char)(255 - (i % 256));
+                }
+                trailer = trl;
+                trailerLen = (int)pThis->trlSize;
+            }
+            ((volatile char *)payload)[0] = (char)(headerLen + trailerLen);
+            delete[] (char *)header;
+            delete[] (char *)trailer;
+        } else {
+            vx_test_udp_frame_before(pThis->frames, &header, &headerLen, &trailer, &trailerLen);
+            ((volatile char *)payload)[0] = (char)(headerLen + trailerLen);
+            vx_test_udp_frame_after(pThis->frames, header);
+        }
+    }
+    return 0;
+}
+
+// Returns the elapsed seconds
+static double UdpFrameBenchRun(bool legacy, int threads, int packets, long hdrSize, long trlSize, vx_test_udp_frames *frames, double &cpu)
+{
+    vector<UdpFrameBenchThread> workers((size_t)threads);
+    double cpu0 = ProcessCpuMilliseconds();
+    double t0 = get_millisecond_tick_counter();
+    for (int n = 0; n < threads; ++n) {
+        UdpFrameBenchThread &worker = workers[n];
+        worker.legacy = legacy;
+        worker.packets = packets;
+        worker.hdrSize = hdrSize;
+        worker.trlSize = trlSize;
+        worker.frames = frames;
+        create_thread(&UdpFrameBenchThreadProc, &worker, &worker.thread);
+    }
+    for (int n = 0; n < threads; ++n) {
+        join_thread(workers[n].thread);
+    }
+    cpu = (ProcessCpuMilliseconds() - cpu0) / 1000.0;
+    return (get_millisecond_tick_counter() - t0) / 1000.0;
+}
+
+void SDKSampleApp::udpframebench(const vector<string> &cmd)
+{
+    int packets = 200000;
+    int threads = 4;
+    int hdrSize = 16;
+    int trlSize = 16;
+    bool sequence = false;
+    bool error = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-n") {
+            if (!nextArg(packets, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-t") {
+            if (!nextArg(threads, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-header") {
+            if (!nextArg(hdrSize, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-trailer") {
+            if (!nextArg(trlSize, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-seq") {
+            sequence = true;
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (error || packets <= 0 || threads <= 0 || hdrSize < 0 || trlSize < 0 || (sequence && hdrSize < 4)) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    // A buffer set of its own, the one serving the SDK callbacks is not touched
+    vx_test_udp_frames *frames = vx_test_create_udp_frames(hdrSize, trlSize, sequence);
+    con_print("\r * udpframebench: %d threads, %d packets each, %d byte header%s, %d byte trailer\n", threads, packets, hdrSize, sequence ? " with sequence number" : "", trlSize);
+    double legacyRate = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        bool legacy = pass == 0;
+        double cpu;
+        double elapsed = UdpFrameBenchRun(legacy, threads, packets, hdrSize, trlSize, frames, cpu);
+        double rate = (double)threads * packets / (elapsed > 0 ? elapsed : 0.001);
+        con_print("\r   %-8s: %.3f s, %.0f packets/s, cpu %.3f s", legacy ? "per packet" : "pooled", elapsed, rate, cpu);
+        if (legacy) {
+            legacyRate = rate;
+            con_print("\n");
+        } else {
+            con_print(", %.1fx per packet, %u pool misses\n", rate / legacyRate, vx_test_get_udp_pool_misses(frames));
+        }
+    }
+    vx_test_destroy_udp_frames(frames);
+}
+
+void SDKSampleApp::udpstats(const vector<string> &cmd)
+{
+    bool histogram = false;
+    bool reset = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-histogram") {
+            histogram = true;
+        } else if (*i == "-reset") {
+            reset = true;
+        } else {
+            PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+            return;
+        }
+    }
+
+    UdpFrameTelemetry &telemetry = UdpFrameTelemetry::GetInstance();
+    con_print("\r * udpstats:\n");
+    con_print("\r   %-9s %10s %12s %7s %8s %10s %8s %10s %8s\n", "type", "packets", "bytes", "errors", "pkt/s", "kbit/s", "peak/s", "peak kbit", "payload");
+    for (int type = 0; type < UdpFrameTelemetry::c_nFrameTypes; ++type) {
+        UdpFrameTelemetry::TypeStats stats;
+        telemetry.GetStats((vx_udp_frame_type)type, stats);
+        con_print("\r   %-9s %10llu %12llu %7llu %8llu %10.1f %8llu %10.1f %8.1f\n",
+            UdpFrameTelemetry::GetTypeName((vx_udp_frame_type)type),
+            (unsigned long long)stats.packets,
+            (unsigned long long)stats.bytes,
+            (unsigned long long)stats.errors,
+            (unsigned long long)stats.packetsPerSecond,
+            stats.bytesPerSecond * 8 / 1000.0,
+            (unsigned long long)stats.peakPacketsPerSecond,
+            stats.peakBytesPerSecond * 8 / 1000.0,
+            stats.packets ? (double)stats.payloadBytes / stats.packets : 0.0);
+        if (histogram && stats.packets) {
+            for (int bucket = 0; bucket < UdpFrameTelemetry::c_nSizeBuckets; ++bucket) {
+                if (stats.sizeHistogram[bucket] == 0) {
+                    continue;
+                }
+                int limit = UdpFrameTelemetry::GetSizeBucketLimit(bucket);
+                int low = bucket ? UdpFrameTelemetry::GetSizeBucketLimit(bucket - 1) + 1 : 0;
+                if (limit) {
+                    con_print("\r             %5d-%-5d bytes: %llu\n", low, limit, (unsigned long long)stats.sizeHistogram[bucket]);
+                } else {
+                    con_print("\r             %5d+      bytes: %llu\n", low, (unsigned long long)stats.sizeHistogram[bucket]);
+                }
+            }
+        }
+    }
+    if (reset) {
+        telemetry.Reset();
+        con_print("\r   counters cleared\n");
+    }
+}
+
+void SDKSampleApp::udpcapture(const vector<string> &cmd)
+{
+    UdpFrameCapture::Settings settings;
+    bool start = false;
+    bool stop = false;
+    unsigned int rotateMegabytes = 0;
+    bool error = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-start") {
+            if (!nextArg(settings.path, cmd, i, error)) {
+                break;
+            }
+            start = true;
+        } else if (*i == "-stop") {
+            stop = true;
+        } else if (*i == "-snap") {
+            if (!nextArg(settings.snapLength, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-rotate") {
+            if (!nextArg(rotateMegabytes, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-files") {
+            if (!nextArg(settings.rotateFiles, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-sample") {
+            if (!nextArg(settings.sampleEvery, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-ring") {
+            if (!nextArg(settings.ringSlots, cmd, i, error)) {
+                break;
+            }
+        } else {
+            error = true;
+            break;
+        }
+    }
+    if (error || (start && stop) || settings.sampleEvery == 0 || settings.ringSlots == 0) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+    settings.rotateBytes = (uint64_t)rotateMegabytes * 1024 * 1024;
+
+    UdpFrameCapture &capture = UdpFrameCapture::GetInstance();
+    if (stop) {
+        capture.Stop();
+    } else if (start) {
+        string message;
+        if (!capture.Start(settings, message)) {
+            con_print("\r * udpcapture: %s\n", message.c_str());
+            return;
+        }
+    }
+    UdpFrameCapture::Stats stats;
+    capture.GetStats(stats);
+    con_print("\r * udpcapture: %s%s%s\n", capture.IsRunning() ? "capturing to " : "stopped", capture.IsRunning() ? stats.currentFile.c_str() : "", stats.files > 1 ? " (rotated)" : "");
+    con_print("\r   packets: %llu captured, %llu dropped, %llu left out by sampling\n", (unsigned long long)stats.captured, (unsigned long long)stats.dropped, (unsigned long long)stats.skipped);
+    con_print("\r   written: %llu bytes in %u file(s)\n", (unsigned long long)stats.bytesWritten, stats.files);
+}
+
+void SDKSampleApp::msgbus(const vector<string> &cmd)
+{
+    if (cmd.size() > 1) {
+        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+        return;
+    }
+
+    vector<SDKMessageBus::SubscriberStats> stats;
+    m_messageBus.GetStats(stats);
+    con_print("\r * msgbus: %u observer(s)\n", (unsigned int)stats.size());
+    for (vector<SDKMessageBus::SubscriberStats>::const_iterator i = stats.begin(); i != stats.end(); ++i) {
+        if (i->delivery == SDKMessageBus::deliverSync) {
+            con_print("\r   %u %s: synchronous, %llu delivered\n", i->id, i->name.c_str(), (unsigned long long)i->delivered);
+        } else {
+            con_print("\r   %u %s: asynchronous, %llu delivered, %llu dropped, %u queued (peak %u of %u)\n", i->id, i->name.c_str(),
+                (unsigned long long)i->delivered, (unsigned long long)i->dropped, (unsigned int)i->queued, (unsigned int)i->peakQueued, (unsigned int)i->maxQueued);
+        }
+    }
+}
+
+void SDKSampleApp::listenerstats(const vector<string> &cmd)
+{
+    bool reset = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-reset") {
+            reset = true;
+        } else {
+            PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+            return;
+        }
+    }
+
+    con_print("\r * listenerstats: %llu message(s), mean %.3f ms, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+        (unsigned long long)m_messageLatency.GetCount(),
+        m_messageLatency.GetMean() / 1000.0,
+        m_messageLatency.GetPercentile(0.50) / 1000.0,
+        m_messageLatency.GetPercentile(0.90) / 1000.0,
+        m_messageLatency.GetPercentile(0.99) / 1000.0,
+        m_messageLatency.GetMax() / 1000.0);
+    ConsolePrinter::Stats console;
+    m_consolePrinter.GetStats(console);
+    con_print("\r * listenerstats: console printer %llu printed, %u queued (peak %u), %llu dropped\n",
+        (unsigned long long)console.printed, (unsigned int)console.queued, (unsigned int)console.peakQueued, (unsigned long long)console.dropped);
+    if (reset) {
+        m_messageLatency.Reset();
+    }
+}
+
+void SDKSampleApp::PrintLoadReport()
+{
+    LoadGenerator::Report report;
+    m_loadGenerator.GetReport(report);
+    con_print("\r * loadgen: %s, %.1f s, %u logged in, %u joined\n", report.running ? "running" : "stopped", report.elapsedSeconds, report.loggedIn, report.joined);
+    con_print("\r * loadgen: %-8s %8s %8s %8s %8s %8s %8s %7s %9s %9s %9s %9s %9s\n",
+        "op", "issued", "ok", "failed", "refused", "pending", "ops/s", "error%", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+    for (int op = 0; op < LoadGenerator::c_nOperations; ++op) {
+        const LoadGenerator::OperationStats &stats = report.operations[op];
+        uint64_t errors = stats.failed + stats.notIssued;
+        con_print("\r * loadgen: %-8s %8llu %8llu %8llu %8llu %8llu %8.1f %7.2f %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+            LoadGenerator::GetOperationName((LoadGenerator::Operation)op),
+            (unsigned long long)stats.issued,
+            (unsigned long long)stats.succeeded,
+            (unsigned long long)stats.failed,
+            (unsigned long long)stats.notIssued,
+            (unsigned long long)stats.pending,
+            report.elapsedSeconds > 0 ? stats.succeeded / report.elapsedSeconds : 0.0,
+            stats.issued ? 100.0 * errors / stats.issued : 0.0,
+            stats.meanMilliseconds,
+            stats.p50Milliseconds,
+            stats.p90Milliseconds,
+            stats.p99Milliseconds,
+            stats.maxMilliseconds);
+    }
+}
+
+void SDKSampleApp::loadgen(const vector<string> &cmd)
+{
+    LoadGenerator::Settings settings;
+    bool start = false;
+    bool stop = false;
+    bool wait = false;
+    bool error = false;
+
+    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
+        if (*i == "-start") {
+            start = true;
+        } else if (*i == "-stop") {
+            stop = true;
+        } else if (*i == "-wait") {
+            wait = true;
+        } else if (*i == "-accounts") {
+            if (!nextArg(settings.accounts, cmd, i, error)) {
                 break;
             }
-        } else if (*i == "-gh") {
-            if (!nextArg(sessionGroupHandle, cmd, i, error)) {
+        } else if (*i == "-channels") {
+            if (!nextArg(settings.channels, cmd, i, error)) {
                 break;
             }
-        } else if (*i == "-sh") {
-            if (!nextArg(sessionHandle, cmd, i, error)) {
+        } else if (*i == "-ramp") {
+            if (!nextArg(settings.rampPerSecond, cmd, i, error)) {
                 break;
             }
-        } else if (*i == "-joinmuted") {
-            joinmuted = true;
-        } else if (*i == "-audio") {
-            if (!nextArg(audio, cmd, i, error)) {
+        } else if (*i == "-churn") {
+            if (!nextArg(settings.churnPerSecond, cmd, i, error)) {
                 break;
             }
-        } else if (*i == "-text") {
-            if (!nextArg(text, cmd, i, error)) {
+        } else if (*i == "-s") {
+            if (!nextArg(settings.seconds, cmd, i, error)) {
                 break;
             }
-        } else if (*i == "-ah") {
-            if (!nextArg(accountHandle, cmd, i, error)) {
+        } else if (*i == "-phase") {
+            LoadGenerator::Phase phase;
+            if (!nextArg(phase.startSeconds, cmd, i, error) ||
+                !nextArg(phase.movesPerSecond, cmd, i, error) ||
+                !nextArg(phase.mutesPerSecond, cmd, i, error) ||
+                !nextArg(phase.messagesPerSecond, cmd, i, error)) {
+                break;
+            }
+            settings.schedule.push_back(phase);
+        } else if (*i == "-seed") {
+            if (!nextArg(settings.seed, cmd, i, error)) {
+                break;
+            }
+        } else if (*i == "-u") {
+            if (!nextArg(settings.userPrefix, cmd, i, error)) {
                 break;
             }
         } else {
@@ -1614,240 +3066,220 @@ void SDKSampleApp::addsession(const vector<string> &cmd)
             break;
         }
     }
-    if (sessionHandle.empty()) {
-        sessionHandle = channel;
-    }
-    if (sessionGroupHandle.empty()) {
-        sessionGroupHandle = "sg_" + sessionHandle;
-    }
-    if (error || channel.empty() || sessionGroupHandle.empty() || sessionHandle.empty()) {
+    if (error || (start && stop) || (wait && !start)) {
         PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
         return;
     }
-    con_print(
-            "\r * Adding channel %s (muted=%s) (audio=%s) (text=%s) to session group %s with handle %s\n",
-            channel.c_str(),
-            joinmuted ? "yes" : "no",
-            audio ? "yes" : "no",
-            text ? "yes" : "no",
-            sessionGroupHandle.c_str(),
-            sessionHandle.c_str());
-
-    // note: we will add this pair to m_SSGHandles when handling a successful resp_sessiongroup_add_session
-    sessiongroup_add_session(accountHandle, sessionGroupHandle, sessionHandle, channel, joinmuted, audio, text);
-}
-
-void SDKSampleApp::removesession(const vector<string> &cmd)
-{
-    string sessionHandle;
-    string sessionGroupHandle;
-    bool error = false;
 
-    if (!CheckHasSessionHandle()) {
+    if (stop) {
+        m_loadGenerator.Stop();
+        con_print("\r * loadgen: stopping\n");
         return;
     }
-    for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
-        if (*i == "-sh") {
-            if (!nextArg(sessionHandle, cmd, i, error)) {
-                break;
-            }
-        } else {
-            error = true;
-            break;
-        }
+    if (!start) {
+        PrintLoadReport();
+        return;
     }
-    if (sessionHandle.empty()) {
-        sessionGroupHandle = DefaultSessionGroupHandle();
-        sessionHandle = DefaultSessionHandle();
-    } else {
-        sessionGroupHandle = FindSessionGroupHandleBySessionHandle(sessionHandle);
-        if (sessionGroupHandle.empty()) {
-            con_print("error: The object referred to by the parameter 'session_handle' does not exist.\n");
-            return;
-        }
+    if (!CheckHasConnectorHandle()) {
+        return;
     }
-    if (error || sessionHandle.empty()) {
-        PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
+    string startError;
+    if (!m_loadGenerator.Start(&m_loadTarget, settings, startError)) {
+        con_print("\r * loadgen: %s\n", startError.c_str());
         return;
     }
-    con_print("\r * Removing session %s from session group %s\n", sessionHandle.c_str(), sessionGroupHandle.c_str());
-    // note: we will remove this pair from m_SSGHandles when handling a successful resp_sessiongroup_remove_session
-    sessiongroup_remove_session(sessionGroupHandle, sessionHandle);
+    con_print("\r * loadgen: started %u account(s) over %u channel(s) for %.1f s\n", settings.accounts, settings.channels, settings.seconds);
+    if (wait) {
+        // The drain is bounded by the load generator itself; this only guards against a stuck SDK
+        unsigned int timeoutMilliseconds = (unsigned int)((settings.seconds + settings.drainSeconds) * 1000) + 10000;
+        if (!m_loadGenerator.Wait(timeoutMilliseconds)) {
+            con_print("\r * loadgen: still running after %u ms\n", timeoutMilliseconds);
+        }
+        PrintLoadReport();
+    }
 }
 
-static string FormatCoordinate(double x)
+void SDKSampleApp::PrintScenarioReport()
 {
-    if (x < 0.001 && x > -0.001 && x != 0) {
-        return "approximately 0";
-    } else {
-        stringstream ss;
-        ss << x;
-        return ss.str();
+    ScenarioEngine::Report report;
+    m_scenarioEngine.GetReport(report);
+    if (report.tracks.empty()) {
+        con_print("\r * scenario: none run\n");
+        return;
+    }
+    con_print("\r * scenario: %s %s, %.1f s, %llu command(s) late by mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+        report.name.c_str(),
+        report.running ? "running" : "stopped",
+        report.elapsedSeconds,
+        (unsigned long long)report.commands,
+        report.meanLateMilliseconds,
+        report.p50LateMilliseconds,
+        report.p99LateMilliseconds,
+        report.maxLateMilliseconds);
+    for (size_t i = 0; i < report.tracks.size(); ++i) {
+        const ScenarioEngine::TrackReport &track = report.tracks[i];
+        con_print("\r * scenario: track %s %s at line %d, %llu command(s), %llu wait(s), %llu timeout(s)\n",
+            track.name.c_str(),
+            track.state,
+            track.line,
+            (unsigned long long)track.commands,
+            (unsigned long long)track.waits,
+            (unsigned long long)track.timeouts);
     }
 }
 
-void SDKSampleApp::move(const vector<string> &cmd)
+void SDKSampleApp::scenario(const vector<string> &cmd)
 {
-    string scmd;
-    double delta = 0;
-    string sessionHandle;
+    string file;
+    ScenarioEngine::Variables variables;
+    bool stop = false;
     bool error = false;
 
-    if (!CheckHasSessionHandle()) {
-        return;
-    }
     for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
-        if (*i == "-origin") {
-            scmd = *i;
-        } else if (*i == "-forward" || *i == "-back" || *i == "-left" || *i == "-right" || *i == "-up" || *i == "-down" || *i == "-turnleft" || *i == "-turnright") {
-            scmd = *i;
-            if (!nextArg(delta, cmd, i, error)) {
+        if (*i == "-run") {
+            if (!nextArg(file, cmd, i, error)) {
                 break;
             }
-        } else if (*i == "-sh") {
-            if (!nextArg(sessionHandle, cmd, i, error)) {
+        } else if (*i == "-set") {
+            string assignment;
+            if (!nextArg(assignment, cmd, i, error)) {
+                break;
+            }
+            size_t equals = assignment.find('=');
+            if (equals == string::npos || equals == 0) {
+                error = true;
                 break;
             }
+            variables[assignment.substr(0, equals)] = assignment.substr(equals + 1);
+        } else if (*i == "-stop") {
+            stop = true;
         } else {
             error = true;
             break;
         }
     }
-    if (sessionHandle.empty()) {
-        sessionHandle = DefaultSessionHandle();
-    }
-    if (error || sessionHandle.empty() || (!scmd.empty() && scmd != "-origin" && delta == 0)) {
+    if (error || (stop && !file.empty()) || (file.empty() && !variables.empty())) {
         PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
         return;
     }
 
-    if (scmd == "-origin") {
-        con_print("\r * Moving Listener Position to the origin\n");
-        req_move_origin(sessionHandle);
-    } else if (scmd == "-forward") {
-        con_print("\r * Moving Listener Position Forward by %f\n", delta);
-        req_move_forward(sessionHandle, delta);
-    } else if (scmd == "-back") {
-        con_print("\r * Moving Listener Position Back by %f\n", delta);
-        req_move_back(sessionHandle, delta);
-    } else if (scmd == "-left") {
-        con_print("\r * Moving Listener Position Left by %f\n", delta);
-        req_move_left(sessionHandle, delta);
-    } else if (scmd == "-right") {
-        con_print("\r * Moving Listener Position Right by %f\n", delta);
-        req_move_right(sessionHandle, delta);
-    } else if (scmd == "-up") {
-        con_print("\r * Moving Listener Position Up by %f\n", delta);
-        req_move_up(sessionHandle, delta);
-    } else if (scmd == "-down") {
-        con_print("\r * Moving Listener Position Down by %f\n", delta);
-        req_move_down(sessionHandle, delta);
-    } else if (scmd == "-turnleft") {
-        con_print("\r * Turning Listener Left (Anti-Clockwise) by %f\n", delta);
-        req_turn_left(sessionHandle, delta);
-    } else if (scmd == "-turnright") {
-        con_print("\r * Turning Listener Right (Clockwise) by %f\n", delta);
-        req_turn_right(sessionHandle, delta);
-    } else {
-        SampleAppPosition position;
-        double headingDegrees;
-        GetListenerPosition(sessionHandle, position);
-        GetListenerHeadingDegrees(sessionHandle, headingDegrees);
-        con_print("\r * Position: {%s, %s, %s}\n", FormatCoordinate(position.x).c_str(), FormatCoordinate(position.y).c_str(), FormatCoordinate(position.z).c_str());
-        con_print("\r * Heading Degrees: %s\n", FormatCoordinate(headingDegrees).c_str());
+    if (stop) {
+        m_scenarioEngine.Stop();
+        con_print("\r * scenario: stopping\n");
+        return;
+    }
+    if (file.empty()) {
+        PrintScenarioReport();
+        return;
+    }
+    std::ifstream in(file.c_str());
+    if (!in.is_open()) {
+        con_print("\r * scenario: cannot open %s\n", file.c_str());
+        return;
+    }
+    string startError;
+    if (!m_scenarioEngine.Start(&m_scenarioHost, in, file, variables, startError)) {
+        con_print("\r * scenario: %s\n", startError.c_str());
+        return;
     }
+    con_print("\r * scenario: started %s\n", file.c_str());
 }
 
-void SDKSampleApp::dance(const vector<string> &cmd)
+void SDKSampleApp::PrintReplayReport()
 {
-    string scmd;
-    string sessionHandle;
-    bool error = false;
-    bool stop = false;
-    double x0 = 0;
-    double y0 = 0;
-    double z0 = 0;
-    double rmin = 1;
-    double rmax = 10;
-    double angularVelocityDegPerSec = 10; // 36 seconds for a full circle
-    double oscillationPeriodSeconds = 9; // rmin -> rmax -> rmin in 9 seconds
-    int updateMilliseconds = 100;
-
-
-    if (!CheckHasSessionHandle()) {
+    if (m_messageLog.IsOpen()) {
+        con_print("\r * msglog: recording, %llu record(s), %llu byte(s)\n",
+            (unsigned long long)m_messageLog.GetRecordCount(), (unsigned long long)m_messageLog.GetByteCount());
+    }
+    MessageReplayer::Report report;
+    m_messageReplayer.GetReport(report);
+    if (report.path.empty()) {
+        if (!m_messageLog.IsOpen()) {
+            con_print("\r * msglog: not recording, nothing replayed\n");
+        }
         return;
     }
+    con_print("\r * msglog: replay of %s %s, %.1f s, %llu message(s), %llu request(s) not issued, %llu skipped\n",
+        report.path.c_str(),
+        report.running ? "running" : "stopped",
+        report.elapsedSeconds,
+        (unsigned long long)report.messages,
+        (unsigned long long)report.requests,
+        (unsigned long long)report.skipped);
+    con_print("\r * msglog: handled in %.3f s, %.0f messages/s\n", report.dispatchSeconds, report.messagesPerSecond);
+    if (report.recordedSpeed) {
+        con_print("\r * msglog: handed over late by mean %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            report.meanLateMilliseconds, report.p99LateMilliseconds, report.maxLateMilliseconds);
+    }
+    if (!report.error.empty()) {
+        con_print("\r * msglog: %s: %s\n", report.path.c_str(), report.error.c_str());
+    }
+}
+
+void SDKSampleApp::msglog(const vector<string> &cmd)
+{
+    string recordFile;
+    string replayFile;
+    bool fast = false;
+    bool wait = false;
+    bool stop = false;
+    bool error = false;
+
     for (vector<string>::const_iterator i = cmd.begin() + 1; i != cmd.end(); ++i) {
-        if (*i == "-sh") {
-            if (!nextArg(sessionHandle, cmd, i, error)) {
-                break;
-            }
-        } else if (*i == "-stop") {
-            stop = true;
-        } else if (*i == "-c") {
-            if (
-                !nextArg(x0, cmd, i, error) ||
-                !nextArg(y0, cmd, i, error) ||
-                !nextArg(z0, cmd, i, error))
-            {
-                break;
-            }
-        } else if (*i == "-r") {
-            if (!nextArg(rmin, cmd, i, error)) {
-                break;
-            }
-            rmax = rmin;
-        } else if (*i == "-rmin") {
-            if (!nextArg(rmin, cmd, i, error)) {
-                break;
-            }
-        } else if (*i == "-rmax") {
-            if (!nextArg(rmax, cmd, i, error)) {
-                break;
-            }
-        } else if (*i == "-a") {
-            if (!nextArg(angularVelocityDegPerSec, cmd, i, error)) {
-                break;
-            }
-        } else if (*i == "-o") {
-            if (!nextArg(oscillationPeriodSeconds, cmd, i, error)) {
-                break;
-            }
-        } else if (*i == "-ms") {
-            if (!nextArg(updateMilliseconds, cmd, i, error)) {
+        if (*i == "-record") {
+            if (!nextArg(recordFile, cmd, i, error)) {
                 break;
             }
-            if (updateMilliseconds <= 0) {
-                con_print("error: %s: -ms argument must be a positive integer\n", cmd[0].c_str());
-                error = true;
+        } else if (*i == "-replay") {
+            if (!nextArg(replayFile, cmd, i, error)) {
                 break;
             }
+        } else if (*i == "-fast") {
+            fast = true;
+        } else if (*i == "-wait") {
+            wait = true;
+        } else if (*i == "-stop") {
+            stop = true;
         } else {
             error = true;
             break;
         }
     }
-
-    if (sessionHandle.empty()) {
-        sessionHandle = DefaultSessionHandle();
-    }
-    if (error || sessionHandle.empty()) {
+    if (error || (stop && (!recordFile.empty() || !replayFile.empty())) || ((fast || wait) && replayFile.empty())) {
         PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
         return;
     }
 
-    // Find the referenced session
-    auto session_it = m_sessions.find(sessionHandle);
-    if (session_it == m_sessions.end()) {
-        con_print("error: session with handle '%s' not found\n", sessionHandle.c_str());
+    if (stop) {
+        m_messageLog.Close();
+        m_messageReplayer.Stop();
+        con_print("\r * msglog: stopped\n");
         return;
     }
-
-    // Start dancing
-    if (stop) {
-        session_it->second->DanceStop();
-    } else {
-        session_it->second->DanceStart(sessionHandle, x0, y0, z0, rmin, rmax, angularVelocityDegPerSec, oscillationPeriodSeconds, updateMilliseconds);
+    if (recordFile.empty() && replayFile.empty()) {
+        PrintReplayReport();
+        return;
+    }
+    string startError;
+    if (!recordFile.empty()) {
+        if (!m_messageLog.Open(recordFile.c_str(), startError)) {
+            con_print("\r * msglog: %s\n", startError.c_str());
+            return;
+        }
+        con_print("\r * msglog: recording to %s\n", recordFile.c_str());
+    }
+    if (!replayFile.empty()) {
+        if (!m_messageReplayer.Start(&m_replayTarget, replayFile, !fast, startError)) {
+            con_print("\r * msglog: %s\n", startError.c_str());
+            return;
+        }
+        con_print("\r * msglog: replaying %s\n", replayFile.c_str());
+        if (wait) {
+            // At recorded speed, as long as the recording took
+            while (!m_messageReplayer.Wait(1000)) {
+            }
+            PrintReplayReport();
+        }
     }
 }
 
@@ -2399,10 +3831,7 @@ void SDKSampleApp::muteall(const vector<string> &cmd)
         if (sessionHandle.empty()) {
             sessionHandle = DefaultSessionHandle();
         }
-        auto i = m_sessions.find(sessionHandle);
-        if (i != m_sessions.end()) {
-            channel = i->second->GetUri();
-        }
+        channel = GetSessionUri(sessionHandle);
     }
 
     if (error || channel.empty()) {
@@ -2464,7 +3893,7 @@ void SDKSampleApp::audioinfo(const vector<string> &cmd)
             break;
         }
     }
-    connector_get_local_audio_info(accountHandle, m_connectorHandle);
+    connector_get_local_audio_info(accountHandle, GetConnectorHandle());
 }
 
 void SDKSampleApp::volumelocal(const vector<string> &cmd)
@@ -2904,11 +4333,16 @@ void SDKSampleApp::shutdown(const vector<string> &cmd)
         PrintUsage(cmd.at(0), m_commands.find(cmd.at(0))->second.GetUsage());
         return;
     }
-    con_print("\r * Shutting down connector handle %s\n", m_connectorHandle.c_str());
-    connector_initiate_shutdown(m_connectorHandle);
+    string connectorHandle = GetConnectorHandle();
+    con_print("\r * Shutting down connector handle %s\n", connectorHandle.c_str());
+    connector_initiate_shutdown(connectorHandle);
 
-    lock_guard<mutex> lock(m_accountHandleUserNameMutex);
+    lock_guard<mutex> stateLock(m_sessionStateMutex);
+    lock_guard<mutex> accountLock(m_accountHandleUserNameMutex);
     m_SSGHandles.clear();
+    for (auto i = m_sessions.begin(); i != m_sessions.end(); ++i) {
+        delete i->second;
+    }
     m_sessions.clear();
     m_accountHandles.clear();
     m_accountHandleUserNames.clear();
@@ -3043,8 +4477,7 @@ void SDKSampleApp::mutesession(const vector<string> &cmd)
         sessionHandle = DefaultSessionHandle();
     }
 
-    auto i = m_sessions.find(sessionHandle);
-    if (i == m_sessions.end()) {
+    if (!IsSessionKnown(sessionHandle)) {
         con_print("\r * Error: on such session\n");
         return;
     }
@@ -3381,11 +4814,7 @@ void SDKSampleApp::transcription(const std::vector<std::string> &cmd)
         return;
     }
 
-    string channel;
-    auto i = m_sessions.find(sessionHandle);
-    if (i != m_sessions.end()) {
-        channel = i->second->GetUri();
-    }
+    string channel = GetSessionUri(sessionHandle);
     if (channel.empty()) {
         con_print("Wrong session handle\n");
         return;
@@ -3397,11 +4826,14 @@ void SDKSampleApp::transcription(const std::vector<std::string> &cmd)
 
 void SDKSampleApp::SetListenerPosition(const std::string session_handle, SampleAppPosition &position)
 {
+    lock_guard<recursive_mutex> lock(m_listenerPositionMutex);
     m_listenerPositions[session_handle] = position;
+    UpdateSpatializerListener(session_handle);
 }
 
 void SDKSampleApp::GetListenerPosition(const std::string session_handle, SampleAppPosition &position)
 {
+    lock_guard<recursive_mutex> lock(m_listenerPositionMutex);
     if (m_listenerPositions.find(session_handle) == m_listenerPositions.end()) {
         m_listenerPositions[session_handle] = { 0.0, 0.0, 0.0 };
     }
@@ -3411,11 +4843,28 @@ void SDKSampleApp::GetListenerPosition(const std::string session_handle, SampleA
 
 void SDKSampleApp::SetListenerOrientation(const std::string session_handle, SampleAppOrientation &orientation)
 {
+    lock_guard<recursive_mutex> lock(m_listenerPositionMutex);
     m_listenerOrientations[session_handle] = orientation;
+    UpdateSpatializerListener(session_handle);
+}
+
+// The client side spatializer renders relative to the most recently moved session's listener
+void SDKSampleApp::UpdateSpatializerListener(const std::string session_handle)
+{
+    lock_guard<recursive_mutex> lock(m_listenerPositionMutex);
+    SampleAppPosition position;
+    SampleAppOrientation orientation;
+    GetListenerPosition(session_handle, position);
+    GetListenerOrientation(session_handle, orientation);
+    m_spatializer.SetListener(
+            { (float)position.x, (float)position.y, (float)position.z },
+            { (float)orientation.at_x, (float)orientation.at_y, (float)orientation.at_z },
+            { (float)orientation.up_x, (float)orientation.up_y, (float)orientation.up_z });
 }
 
 void SDKSampleApp::GetListenerOrientation(const std::string session_handle, SampleAppOrientation &orientation)
 {
+    lock_guard<recursive_mutex> lock(m_listenerPositionMutex);
     if (m_listenerOrientations.find(session_handle) == m_listenerOrientations.end()) {
         double headingDegrees;
         GetListenerHeadingDegrees(session_handle, headingDegrees);
@@ -3430,6 +4879,7 @@ void SDKSampleApp::GetListenerOrientation(const std::string session_handle, Samp
 
 void SDKSampleApp::GetListenerHeadingDegrees(const std::string session_handle, double &headingDegrees)
 {
+    lock_guard<recursive_mutex> lock(m_listenerPositionMutex);
     if (m_listenerHeadingDegrees.find(session_handle) == m_listenerHeadingDegrees.end()) {
         m_listenerHeadingDegrees[session_handle] = 0.0;
     }
@@ -3439,6 +4889,7 @@ void SDKSampleApp::GetListenerHeadingDegrees(const std::string session_handle, d
 
 void SDKSampleApp::SetListenerHeadingDegrees(const std::string session_handle, double headingDegrees)
 {
+    lock_guard<recursive_mutex> lock(m_listenerPositionMutex);
     m_listenerHeadingDegrees[session_handle] = headingDegrees;
 }
 
@@ -3461,10 +4912,15 @@ void SDKSampleApp::Set3DPositionRequestFields(vx_req_session_set_3d_position *re
     req->speaker_position[2] = position.z;
 }
 
+#ifdef _WIN32
+#define RTP_API __declspec(dllimport)
+#else
+#define RTP_API
+#endif
 extern "C" {
-__declspec(dllimport) int vx_set_rtp_enabled(int inbound, int outbound);
-__declspec(dllimport) int vx_get_rtp_enabled_inbound(void);
-__declspec(dllimport) int vx_get_rtp_enabled_outbound(void);
+RTP_API int vx_set_rtp_enabled(int inbound, int outbound);
+RTP_API int vx_get_rtp_enabled_inbound(void);
+RTP_API int vx_get_rtp_enabled_outbound(void);
 }
 
 void SDKSampleApp::rtp(const vector<string> &cmd)
@@ -3586,6 +5042,7 @@ vx_tts_status SDKSampleApp::InitializeTTSManagerIfNeeded()
             con_print("%s\n", vx_get_tts_status_string(statusCode));
             return statusCode;
         }
+        lock_guard<mutex> lock(m_sessionStateMutex);
         m_ttsManagerId = new vx_tts_manager_id;
         *m_ttsManagerId = tempId;
     }
@@ -3767,6 +5224,7 @@ void SDKSampleApp::ttsshutdown(const std::vector<std::string> & /*cmd*/)
         vx_tts_status statusCode = vx_tts_shutdown(m_ttsManagerId);
         con_print("%s\n", vx_get_tts_status_string(statusCode));
         if (statusCode == tts_status_success) {
+            lock_guard<mutex> lock(m_sessionStateMutex);
             delete m_ttsManagerId;
             m_ttsManagerId = NULL;
         }
@@ -3808,6 +5266,7 @@ void SDKSampleApp::ttsvoice(const std::vector<std::string> &cmd)
         }
 
         vx_tts_voice_id voiceID = (vx_tts_voice_id)std::stoul(voiceIDString);
+        lock_guard<mutex> lock(m_sessionStateMutex);
         m_ttsVoiceID = voiceID;
     }
 }
@@ -3855,11 +5314,7 @@ void SDKSampleApp::ttsspeaktextchannel(const std::vector<std::string> &cmd)
         return;
     }
 
-    string channel;
-    auto i = m_sessions.find(sessionHandle);
-    if (i != m_sessions.end()) {
-        channel = i->second->GetUri();
-    }
+    string channel = GetSessionUri(sessionHandle);
     if (channel.empty()) {
         con_print("Wrong session handle\n");
         return;
@@ -3870,6 +5325,7 @@ void SDKSampleApp::ttsspeaktextchannel(const std::vector<std::string> &cmd)
         return;
     }
 
+    lock_guard<mutex> lock(m_sessionStateMutex);
     if (on == 1) {
         con_print("\r * Enabling text-to-speech for channel (%s)\n", sessionHandle.c_str());
         m_ttsSessionHandles.insert(sessionHandle);
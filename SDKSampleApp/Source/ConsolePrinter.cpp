@@ -0,0 +1,132 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "ConsolePrinter.h"
+#include <stdio.h>
+
+ConsolePrinter::ConsolePrinter() :
+    m_maxQueued(0),
+    m_running(false),
+    m_peakQueued(0),
+    m_stopRequested(false),
+    m_droppedUnreported(0),
+    m_printed(0),
+    m_dropped(0)
+{
+}
+
+ConsolePrinter::~ConsolePrinter()
+{
+    Stop();
+}
+
+void ConsolePrinter::Start(const Writer &writer, size_t maxQueued)
+{
+    if (IsRunning()) {
+        return;
+    }
+    m_writer = writer;
+    m_maxQueued = maxQueued ? maxQueued : 1;
+    m_stopRequested = false;
+    m_thread = std::thread(&ConsolePrinter::PrinterThread, this);
+    m_running.store(true, std::memory_order_release);
+}
+
+void ConsolePrinter::Stop()
+{
+    if (!IsRunning()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+    m_running.store(false, std::memory_order_release);
+}
+
+bool ConsolePrinter::Print(std::string &&text)
+{
+    Entry entry;
+    entry.text.swap(text);
+    return Enqueue(std::move(entry));
+}
+
+bool ConsolePrinter::Print(Formatter &&formatter)
+{
+    Entry entry;
+    entry.formatter = std::move(formatter);
+    return Enqueue(std::move(entry));
+}
+
+bool ConsolePrinter::Enqueue(Entry &&entry)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopRequested || m_queue.size() >= m_maxQueued) {
+            m_droppedUnreported++;
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_queue.push_back(std::move(entry));
+        if (m_queue.size() > m_peakQueued) {
+            m_peakQueued = m_queue.size();
+        }
+    }
+    m_condition.notify_one();
+    return true;
+}
+
+void ConsolePrinter::PrinterThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_condition.wait(lock, [this] { return m_stopRequested || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            break; // stop requested and everything printed
+        }
+        Entry entry(std::move(m_queue.front()));
+        m_queue.pop_front();
+        uint64_t dropped = m_droppedUnreported;
+        m_droppedUnreported = 0;
+        lock.unlock();
+
+        if (dropped != 0) {
+            char notice[80];
+            snprintf(notice, sizeof(notice), "\r * (%llu console message(s) dropped)\n", (unsigned long long)dropped);
+            m_writer(notice);
+        }
+        if (entry.formatter) {
+            entry.formatter(entry.text);
+            entry.formatter = nullptr; // releases what it holds before taking the lock again
+        }
+        if (!entry.text.empty()) {
+            m_writer(entry.text);
+        }
+        m_printed.fetch_add(1, std::memory_order_relaxed);
+
+        lock.lock();
+    }
+}
+
+void ConsolePrinter::GetStats(Stats &stats) const
+{
+    stats.printed = m_printed.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.queued = m_queue.size();
+    stats.peakQueued = m_peakQueued;
+}
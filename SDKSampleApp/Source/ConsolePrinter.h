@@ -0,0 +1,83 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdint.h>
+
+// Writes console output on a thread of its own, in the order it was queued.
+//
+// Text can be queued already formatted, or as a formatter the printer thread calls to
+// produce it, so expensive formatting (the XML of an SDK message) is not done by the
+// thread queueing it. A formatter owns whatever it needs, such as a reference to the
+// message. When the queue is full, output is dropped and the printer says how much.
+class ConsolePrinter
+{
+public:
+    typedef std::function<void(const std::string &text)> Writer;
+    typedef std::function<void(std::string &text)> Formatter;
+
+    ConsolePrinter();
+    ~ConsolePrinter();
+
+    void Start(const Writer &writer, size_t maxQueued = 65536);
+    // Prints what is queued, then stops the thread
+    void Stop();
+    bool IsRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    // Both return false, and count the output as dropped, when it was not queued
+    bool Print(std::string &&text);
+    bool Print(Formatter &&formatter);
+
+    struct Stats {
+        uint64_t printed;
+        uint64_t dropped;
+        size_t queued;
+        size_t peakQueued;
+    };
+    void GetStats(Stats &stats) const;
+
+private:
+    ConsolePrinter(const ConsolePrinter &); // disabled
+
+    struct Entry {
+        std::string text;
+        Formatter formatter;
+    };
+
+    bool Enqueue(Entry &&entry);
+    void PrinterThread();
+
+    Writer m_writer;
+    size_t m_maxQueued;
+    std::atomic<bool> m_running;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<Entry> m_queue;
+    size_t m_peakQueued;
+    bool m_stopRequested;
+    uint64_t m_droppedUnreported;   // dropped since the printer last said so
+    std::thread m_thread;
+
+    std::atomic<uint64_t> m_printed;
+    std::atomic<uint64_t> m_dropped;
+};
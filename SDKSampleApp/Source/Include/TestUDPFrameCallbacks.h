@@ -15,128 +15,32 @@
 */
 
 #include "VxcTypes.h"
+
 /**
  * This function sets two test callbacks into vx_sdk_config_t structure.
+ * The VX_TEST_UDP_* environment variables are read here, once. The callbacks also feed
+ * UdpFrameTelemetry and UdpFrameCapture, so they are set even if no header or trailer is requested.
  */
-extern void vx_test_set_udp_frame_callbacks(vx_sdk_config_t *config);
-
-#include <stdlib.h>
-
+void vx_test_set_udp_frame_callbacks(vx_sdk_config_t *config);
 
-// --------------------- UDP CALLBACKS TEST ------------------------------------------------
 /**
- * This callback will be called before rtp/rtcp/sip packet transmitted.
- * VX_TEST_UDP_HEADER environment variable defines the length in bytes of the header that will be added to the packet.
- * VX_TEST_UDP_TRAILER environment variable defines the length in bytes of the trailer that will be added to the packet.
- * The server should cut out this data.
- * Server must have the same header/trailer length settings as the client.
+ * Header and trailer settings and buffers. The callbacks set by vx_test_set_udp_frame_callbacks()
+ * have their own; udpframebench creates others to drive them the same way without touching those.
  */
-static void test_on_before_udp_frame_transmitted(
-        void *callback_handle, // the handle passed in the vx_sdk_config_t structure
-        vx_udp_frame_type frame_type,
-        void *payload_data, // the data to be transmitted to the network
-        int payload_data_len, // the len of that data
-        void **header_out, // callback set - pointer to header data (NULL if no header)
-        int *header_len_out, // callback set - length of the header data (0 if no header)
-        void **trailer_out, // callback set - pointer to trailer data (NULL if no trailer)
-        int *trailer_len_out // callback set - length of the trailer data (0 if no trailer)
-        )
-{
-    (void)callback_handle;
-    (void)frame_type;
-    (void)payload_data;
-    (void)payload_data_len;
-
-    static long hdrSize = -1;
-    static long trlSize = 0;
-
-    /**
-     * Check the VX_TEST_UDP_HEADER and VX_TEST_UDP_TRAILER variabels only one time.
-     */
-    if (hdrSize < 0) {
-        hdrSize = 0;
-
-        char *pVX_TEST_UDP_HEADER = getenv("VX_TEST_UDP_HEADER");
-        char *pVX_TEST_UDP_TRAILER = getenv("VX_TEST_UDP_TRAILER");
-        if (pVX_TEST_UDP_HEADER) {
-            hdrSize = strtol(pVX_TEST_UDP_HEADER, NULL, 10);
-        }
-
-        if (pVX_TEST_UDP_TRAILER) {
-            trlSize = strtol(pVX_TEST_UDP_TRAILER, NULL, 10);
-        }
-    }
-
-    if (0 == hdrSize && 0 == trlSize) {
-        return;
-    }
-
-    char *hdr = new char[hdrSize];
-    char *trl = new char[trlSize];
-    char *tmp = NULL;
-
-    /**
-     * Fill the header with increasing integer values, trailer with decreasing values.
-     * So, you can use Wireshark to see how packets are looks like with the header and trailer.
-     */
-    tmp = hdr;
-    for (long i = 0; i < hdrSize; i++, tmp++) {
-        *tmp = i % 256;
-    }
-    tmp = trl;
-    for (long i = 0; i < trlSize; i++, tmp++) {
-        *tmp = 255 - (i % 256);
-    }
-
-    *header_out = hdr;
-    *trailer_out = trl;
+typedef struct vx_test_udp_frames vx_test_udp_frames;
 
-    *header_len_out = (int)hdrSize;
-    *trailer_len_out = (int)trlSize;
-}
+vx_test_udp_frames *vx_test_create_udp_frames(long hdrSize, long trlSize, bool hdrSequence);
+void vx_test_destroy_udp_frames(vx_test_udp_frames *frames);
 
 /**
- * This callback will be called after rtp/rtcp/sip packet transmitted.
- * Just clean up an allocated memory here.
+ * What the callbacks do before and after a packet is transmitted, with the given buffers.
  */
-static void test_on_after_udp_frame_transmitted(
-        void *callback_handle, // the handle passed in the vx_sdk_config_t structure
-        vx_udp_frame_type frame_type,
-        void *payload_data, // the data to be transmitted to the network
-        int payload_data_len, // the len of that data
-        void *header,     // the header data passed in pf_on_before_udp_frame_transmitted
-        int header_len,   // length of the header data
-        void *trailer,    // the trailer data passed in pf_on_before_udp_frame_transmitted
-        int trailer_len,  // length of the trailer data
-        int sent_bytes    // the total number of bytes transmitted - < 0 indicates error
-        )
-{
-    (void)callback_handle;
-    (void)frame_type;
-    (void)payload_data;
-    (void)payload_data_len;
-    (void)header_len;
-    (void)trailer_len;
-    (void)sent_bytes;
-    if (NULL != header) {
-        delete[] (char *)header;
-    }
-    if (NULL != trailer) {
-        delete[] (char *)trailer;
-    }
-}
+void vx_test_udp_frame_before(vx_test_udp_frames *frames, void **header_out, int *header_len_out, void **trailer_out, int *trailer_len_out);
+void vx_test_udp_frame_after(vx_test_udp_frames *frames, void *header);
 
 /**
- * This function sets up the vx_sdk_config_t structure with test callbacks.
+ * The number of per packet headers taken from the heap because every pooled buffer was in flight.
  */
-void vx_test_set_udp_frame_callbacks(vx_sdk_config_t *config)
-{
-    if (NULL == config) {
-        return;
-    }
+unsigned int vx_test_get_udp_pool_misses(const vx_test_udp_frames *frames);
 
-    config->pf_on_before_udp_frame_transmitted = test_on_before_udp_frame_transmitted;
-    config->pf_on_after_udp_frame_transmitted = test_on_after_udp_frame_transmitted;
-}
-// -----------------------------------------------------------------------------------------
 #define VX_HAS_UDP_CALLBACKS
@@ -64,6 +64,8 @@ VXPLATFORM_DLLEXPORT os_error_t set_event(os_event_handle handle);
 VXPLATFORM_DLLEXPORT os_error_t wait_event(os_event_handle handle, int timeout = -1);
 VXPLATFORM_DLLEXPORT os_error_t delete_event(os_event_handle handle);
 VXPLATFORM_DLLEXPORT double get_millisecond_tick_counter();
+// A monotonic clock from an arbitrary origin, for measuring intervals
+VXPLATFORM_DLLEXPORT unsigned long long get_nanosecond_tick_counter();
 
 class thread_handle_t
 {
@@ -181,6 +183,54 @@ private:
 
     Locker(const Lock &);
 };
+
+typedef void (*work_function_t)(void *);
+
+// A fixed number of threads running the work posted to them, in the order it was posted.
+class VXPLATFORM_DLLEXPORT WorkerPool
+{
+public:
+    WorkerPool(size_t threadCount, const std::string &name);
+    // Runs the work already posted, then joins the threads
+    ~WorkerPool();
+
+    // Returns false once the pool is being destroyed
+    bool Post(work_function_t pf, void *pArg);
+    size_t GetThreadCount() const;
+    size_t GetQueueLength() const;
+
+private:
+    void *m_pImpl;
+
+    WorkerPool(const WorkerPool &);
+};
+
+typedef unsigned long long timer_id_t;
+
+// Timers on a hierarchical timing wheel, all served by one thread that sleeps until the next
+// one is due. Scheduling and cancelling take constant time however many timers there are.
+// The callbacks run on a WorkerPool, or on the thread of the queue when it has none, where
+// they must be short. Destroy the queue before its pool.
+class VXPLATFORM_DLLEXPORT TimerQueue
+{
+public:
+    // Times are rounded up to whole resolutionMs ticks
+    TimerQueue(WorkerPool *pPool, unsigned int resolutionMs = 1);
+    ~TimerQueue();
+
+    // Calls pf(pArg) delayMs from now, then every periodMs if it is not 0, at a fixed rate:
+    // periods missed altogether are skipped. Returns 0 if the queue is being destroyed.
+    timer_id_t Schedule(unsigned long long delayMs, unsigned long long periodMs, work_function_t pf, void *pArg);
+    // Returns false if the timer is unknown or has fired for the last time. A callback
+    // already handed to the pool can still run once after.
+    bool Cancel(timer_id_t id);
+    size_t GetTimerCount() const;
+
+private:
+    void *m_pImpl;
+
+    TimerQueue(const TimerQueue &);
+};
 }
 
 #endif
@@ -15,6 +15,13 @@
 
 #pragma once
 
+#ifdef _WIN32
 #ifndef strcasecmp
 #define strcasecmp stricmp
 #endif
+#else
+#include <strings.h>
+#ifndef stricmp
+#define stricmp strcasecmp
+#endif
+#endif
@@ -0,0 +1,122 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Latencies in microseconds counted in buckets of 16 linear steps per power of 2, so a
+// percentile is known within 1/16 of its value, and within 1 us below 16 us. Recording is a
+// few relaxed atomic updates and takes no lock.
+class LatencyHistogram
+{
+public:
+    static const int c_nSubBucketBits = 4;
+    static const int c_nSubBuckets = 1 << c_nSubBucketBits;
+    static const int c_nMaxOctave = 39;    // values from 2^40 us, about 12 days, go to the last bucket
+    static const int c_nBuckets = c_nSubBuckets + (c_nMaxOctave - c_nSubBucketBits + 1) * c_nSubBuckets;
+
+    LatencyHistogram() { Reset(); }
+
+    void Record(uint64_t microseconds)
+    {
+        m_buckets[BucketOf(microseconds)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(microseconds, std::memory_order_relaxed);
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (microseconds > max && !m_max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Not atomic as a whole: latencies recorded meanwhile may be partly counted
+    void Reset()
+    {
+        for (int i = 0; i < c_nBuckets; ++i) {
+            m_buckets[i] = 0;
+        }
+        m_count = 0;
+        m_sum = 0;
+        m_max = 0;
+    }
+
+    uint64_t GetCount() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t GetMax() const { return m_max.load(std::memory_order_relaxed); }
+    double GetMean() const
+    {
+        uint64_t count = GetCount();
+        return count ? (double)m_sum.load(std::memory_order_relaxed) / count : 0.0;
+    }
+
+    // The latency below which the given fraction (0 to 1) of them are, interpolated linearly
+    // within its bucket
+    uint64_t GetPercentile(double fraction) const
+    {
+        uint64_t count = GetCount();
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(fraction * count);
+        uint64_t seen = 0;
+        for (int i = 0; i < c_nBuckets; ++i) {
+            uint64_t inBucket = m_buckets[i].load(std::memory_order_relaxed);
+            if (seen + inBucket > rank) {
+                uint64_t lower, width;
+                GetBucketRange(i, lower, width);
+                uint64_t value = lower + (uint64_t)((double)width * ((double)(rank - seen) + 0.5) / (double)inBucket);
+                uint64_t max = GetMax();
+                return value < max ? value : max;
+            }
+            seen += inBucket;
+        }
+        return GetMax();
+    }
+
+private:
+    LatencyHistogram(const LatencyHistogram &); // disabled
+
+    static int BucketOf(uint64_t value)
+    {
+        if (value < (uint64_t)c_nSubBuckets) {
+            return (int)value;
+        }
+        int octave = c_nSubBucketBits;
+        while (octave < c_nMaxOctave && (value >> (octave + 1)) != 0) {
+            ++octave;
+        }
+        if ((value >> (octave + 1)) != 0) {
+            return c_nBuckets - 1;
+        }
+        int shift = octave - c_nSubBucketBits;
+        return c_nSubBuckets + shift * c_nSubBuckets + (int)((value >> shift) - c_nSubBuckets);
+    }
+
+    static void GetBucketRange(int bucket, uint64_t &lower, uint64_t &width)
+    {
+        if (bucket < c_nSubBuckets) {
+            lower = (uint64_t)bucket;
+            width = 1;
+            return;
+        }
+        int shift = (bucket - c_nSubBuckets) / c_nSubBuckets;
+        int sub = (bucket - c_nSubBuckets) % c_nSubBuckets;
+        lower = (uint64_t)(c_nSubBuckets + sub) << shift;
+        width = (uint64_t)1 << shift;
+    }
+
+    std::atomic<uint64_t> m_buckets[c_nBuckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+};
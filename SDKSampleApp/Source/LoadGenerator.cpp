@@ -0,0 +1,425 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "LoadGenerator.h"
+#include "VxcResponses.h"
+#include <chrono>
+#include <sstream>
+
+// How often the driver thread wakes up to issue what the rates allow
+static const unsigned int c_tickMilliseconds = 10;
+
+LoadGenerator::LoadGenerator() :
+    m_target(NULL),
+    m_startMilliseconds(0),
+    m_endMilliseconds(0),
+    m_messageSerial(0),
+    m_stopRequested(false),
+    m_running(false)
+{
+    for (int op = 0; op < c_nOperations; ++op) {
+        m_counters[op] = Counters();
+    }
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    Stop();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+const char *LoadGenerator::GetOperationName(Operation op)
+{
+    switch (op) {
+        case opLogin:
+            return "login";
+        case opJoin:
+            return "join";
+        case opMove:
+            return "move";
+        case opMute:
+            return "mute";
+        case opMessage:
+            return "message";
+        case opLeave:
+            return "leave";
+        case opLogout:
+            return "logout";
+        default:
+            return "?";
+    }
+}
+
+SDKMessageInterest LoadGenerator::GetMessageInterest()
+{
+    return SDKMessageInterest()
+        .Add(resp_account_anonymous_login)
+        .Add(resp_account_logout)
+        .Add(resp_sessiongroup_add_session)
+        .Add(resp_sessiongroup_remove_session)
+        .Add(resp_session_set_3d_position)
+        .Add(resp_connector_mute_local_mic)
+        .Add(resp_session_send_message);
+}
+
+double LoadGenerator::NowMilliseconds() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int LoadGenerator::Bucket::Take(double perSecond, double seconds)
+{
+    tokens += perSecond * seconds;
+    if (tokens > perSecond + 1) {
+        tokens = perSecond + 1; // at most a second's worth of catching up
+    }
+    int whole = (int)tokens;
+    tokens -= whole;
+    return whole;
+}
+
+bool LoadGenerator::Start(ILoadGeneratorTarget *target, const Settings &settings, std::string &error)
+{
+    if (target == NULL || settings.accounts == 0 || settings.channels == 0 || settings.rampPerSecond <= 0 || settings.churnPerSecond < 0 || settings.seconds <= 0 || settings.drainSeconds < 0) {
+        error = "invalid settings";
+        return false;
+    }
+    for (size_t i = 0; i < settings.schedule.size(); ++i) {
+        const Phase &phase = settings.schedule[i];
+        if (phase.movesPerSecond < 0 || phase.mutesPerSecond < 0 || phase.messagesPerSecond < 0 || (i > 0 && phase.startSeconds < settings.schedule[i - 1].startSeconds)) {
+            error = "invalid rate schedule";
+            return false;
+        }
+    }
+    if (IsRunning()) {
+        error = "a load generator run is in progress";
+        return false;
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_target = target;
+    m_settings = settings;
+    if (m_settings.schedule.empty()) {
+        Phase phase = { 0, 10, 1, 1 };
+        m_settings.schedule.push_back(phase);
+    }
+    m_channelUris.clear();
+    for (unsigned int i = 0; i < settings.channels; ++i) {
+        m_channelUris.push_back(target->LoadChannelUri(i));
+    }
+    m_accounts.assign(settings.accounts, Account());
+    for (unsigned int i = 0; i < settings.accounts; ++i) {
+        Account &account = m_accounts[i];
+        std::stringstream ss;
+        ss << settings.userPrefix << "-" << i;
+        account.userName = "." + ss.str() + ".";
+        account.accountHandle = ss.str();
+        account.sessionHandle = ss.str() + "-session";
+        account.sessionGroupHandle = "sg_" + account.sessionHandle;
+        account.channel = i % settings.channels;
+        account.state = accountIdle;
+        account.muted = false;
+    }
+    m_pending.clear();
+    m_random.seed(settings.seed);
+    m_messageSerial = 0;
+    for (int op = 0; op < c_nOperations; ++op) {
+        m_counters[op] = Counters();
+        m_latency[op].Reset();
+    }
+    m_startMilliseconds = NowMilliseconds();
+    m_endMilliseconds = 0;
+    m_stopRequested = false;
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&LoadGenerator::DriverThread, this);
+    return true;
+}
+
+void LoadGenerator::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_condition.notify_all();
+}
+
+bool LoadGenerator::Wait(unsigned int timeoutMilliseconds)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_condition.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), [this] { return !IsRunning(); });
+}
+
+const LoadGenerator::Phase &LoadGenerator::CurrentPhase(double elapsedSeconds) const
+{
+    size_t i = 0;
+    while (i + 1 < m_settings.schedule.size() && m_settings.schedule[i + 1].startSeconds <= elapsedSeconds) {
+        ++i;
+    }
+    return m_settings.schedule[i];
+}
+
+// Returns m_accounts.size() if no account is in that state
+size_t LoadGenerator::PickAccount(AccountState state)
+{
+    size_t n = m_accounts.size();
+    size_t start = std::uniform_int_distribution<size_t>(0, n - 1)(m_random);
+    for (size_t i = 0; i < n; ++i) {
+        size_t index = (start + i) % n;
+        if (m_accounts[index].state == state) {
+            return index;
+        }
+    }
+    return n;
+}
+
+unsigned int LoadGenerator::CountAccounts(AccountState state) const
+{
+    unsigned int count = 0;
+    for (size_t i = 0; i < m_accounts.size(); ++i) {
+        if (m_accounts[i].state == state) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void LoadGenerator::Issue(Operation op, size_t index)
+{
+    Account &account = m_accounts[index];
+    AccountState previous = account.state;
+    std::string cookie;
+    switch (op) {
+        case opLogin:
+            account.state = accountLoggingIn;
+            cookie = m_target->LoadLogin(account.userName, account.accountHandle);
+            break;
+        case opJoin:
+            account.state = accountJoining;
+            cookie = m_target->LoadJoin(account.userName, account.accountHandle, account.sessionGroupHandle, account.sessionHandle, m_channelUris[account.channel]);
+            break;
+        case opMove:
+        {
+            std::uniform_real_distribution<double> coordinate(-50, 50);
+            double x = coordinate(m_random);
+            double z = coordinate(m_random);
+            cookie = m_target->LoadMove(account.sessionHandle, x, 0, z);
+            break;
+        }
+        case opMute:
+            account.muted = !account.muted;
+            cookie = m_target->LoadMute(account.accountHandle, account.muted);
+            break;
+        case opMessage:
+        {
+            std::stringstream ss;
+            ss << "load generator message " << ++m_messageSerial;
+            cookie = m_target->LoadMessage(account.sessionHandle, ss.str());
+            break;
+        }
+        case opLeave:
+            account.state = accountLeaving;
+            cookie = m_target->LoadLeave(account.sessionGroupHandle, account.sessionHandle);
+            break;
+        case opLogout:
+            account.state = accountLoggingOut;
+            cookie = m_target->LoadLogout(account.accountHandle);
+            break;
+        default:
+            return;
+    }
+    m_counters[op].issued++;
+    if (cookie.empty()) {
+        m_counters[op].notIssued++;
+        account.state = (op == opLogin || op == opLogout) ? accountDone : previous;
+        return;
+    }
+    Pending pending = { op, index, NowMilliseconds() };
+    m_pending[cookie] = pending;
+}
+
+void LoadGenerator::Complete(const std::string &cookie, bool succeeded)
+{
+    std::map<std::string, Pending>::iterator i = m_pending.find(cookie);
+    if (i == m_pending.end()) {
+        return; // not one of ours
+    }
+    Pending pending = i->second;
+    m_pending.erase(i);
+
+    double elapsed = NowMilliseconds() - pending.issuedMilliseconds;
+    m_latency[pending.op].Record(elapsed > 0 ? (uint64_t)(elapsed * 1000) : 0);
+    if (succeeded) {
+        m_counters[pending.op].succeeded++;
+    } else {
+        m_counters[pending.op].failed++;
+    }
+
+    Account &account = m_accounts[pending.account];
+    switch (pending.op) {
+        case opLogin:
+            account.state = succeeded ? accountLoggedIn : accountDone;
+            break;
+        case opJoin:
+            account.state = succeeded ? accountJoined : accountLoggedIn;
+            break;
+        case opLeave:
+            account.state = accountLoggedIn;
+            break;
+        case opLogout:
+            account.state = accountDone;
+            break;
+        default:
+            break;
+    }
+}
+
+void LoadGenerator::OnVivoxSDKMessage(vx_message_base_t *msg)
+{
+    if (msg->type != msg_response) {
+        return;
+    }
+    vx_resp_base_t *resp = reinterpret_cast<vx_resp_base_t *>(msg);
+    if (resp->request == NULL || resp->request->cookie == NULL) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Complete(resp->request->cookie, resp->return_code == 0);
+}
+
+void LoadGenerator::DriverThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Bucket logins, joins, churn, moves, mutes, messages;
+    size_t nextLogin = 0;
+    double last = m_startMilliseconds;
+
+    while (!m_stopRequested) {
+        double now = NowMilliseconds();
+        double elapsedSeconds = (now - m_startMilliseconds) / 1000;
+        double seconds = (now - last) / 1000;
+        last = now;
+        if (elapsedSeconds >= m_settings.seconds) {
+            break;
+        }
+
+        for (int n = logins.Take(m_settings.rampPerSecond, seconds); n > 0 && nextLogin < m_accounts.size(); --n) {
+            Issue(opLogin, nextLogin++);
+        }
+        // Joins follow the ramp too, which also paces the retries after a failed join
+        for (int n = joins.Take(m_settings.rampPerSecond, seconds); n > 0; --n) {
+            size_t index = PickAccount(accountLoggedIn);
+            if (index == m_accounts.size()) {
+                break;
+            }
+            Issue(opJoin, index);
+        }
+        for (int n = churn.Take(m_settings.churnPerSecond, seconds); n > 0; --n) {
+            size_t index = PickAccount(accountJoined);
+            if (index == m_accounts.size()) {
+                break;
+            }
+            Issue(opLeave, index);
+        }
+
+        const Phase &phase = CurrentPhase(elapsedSeconds);
+        struct {
+            Operation op;
+            int count;
+        } work[] = {
+            { opMove, moves.Take(phase.movesPerSecond, seconds) },
+            { opMute, mutes.Take(phase.mutesPerSecond, seconds) },
+            { opMessage, messages.Take(phase.messagesPerSecond, seconds) },
+        };
+        for (size_t w = 0; w < sizeof(work) / sizeof(work[0]); ++w) {
+            for (int n = work[w].count; n > 0; --n) {
+                size_t index = PickAccount(accountJoined);
+                if (index == m_accounts.size()) {
+                    break;
+                }
+                Issue(work[w].op, index);
+            }
+        }
+
+        m_condition.wait_for(lock, std::chrono::milliseconds(c_tickMilliseconds), [this] { return m_stopRequested; });
+    }
+
+    // Leave and log out everything, joins and logins still in flight included once they complete
+    double deadline = NowMilliseconds() + m_settings.drainSeconds * 1000;
+    for (;;) {
+        bool busy = !m_pending.empty();
+        for (size_t i = 0; i < m_accounts.size(); ++i) {
+            switch (m_accounts[i].state) {
+                case accountIdle:
+                    m_accounts[i].state = accountDone;
+                    break;
+                case accountJoined:
+                    Issue(opLeave, i);
+                    busy = true;
+                    break;
+                case accountLoggedIn:
+                    Issue(opLogout, i);
+                    busy = true;
+                    break;
+                case accountDone:
+                    break;
+                default:
+                    busy = true;
+                    break;
+            }
+        }
+        if (!busy || NowMilliseconds() >= deadline) {
+            break;
+        }
+        m_condition.wait_for(lock, std::chrono::milliseconds(c_tickMilliseconds));
+    }
+
+    m_endMilliseconds = NowMilliseconds();
+    m_running.store(false, std::memory_order_release);
+    m_condition.notify_all();
+}
+
+void LoadGenerator::GetReport(Report &report) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    report.running = IsRunning();
+    double end = report.running ? NowMilliseconds() : m_endMilliseconds;
+    report.elapsedSeconds = m_startMilliseconds != 0 ? (end - m_startMilliseconds) / 1000 : 0;
+    report.joined = CountAccounts(accountJoined);
+    report.loggedIn = report.joined + CountAccounts(accountLoggedIn) + CountAccounts(accountJoining) + CountAccounts(accountLeaving);
+
+    uint64_t pending[c_nOperations] = {};
+    for (std::map<std::string, Pending>::const_iterator i = m_pending.begin(); i != m_pending.end(); ++i) {
+        pending[i->second.op]++;
+    }
+    for (int op = 0; op < c_nOperations; ++op) {
+        OperationStats &stats = report.operations[op];
+        stats.issued = m_counters[op].issued;
+        stats.succeeded = m_counters[op].succeeded;
+        stats.failed = m_counters[op].failed;
+        stats.notIssued = m_counters[op].notIssued;
+        stats.pending = pending[op];
+        stats.meanMilliseconds = m_latency[op].GetMean() / 1000;
+        stats.p50Milliseconds = m_latency[op].GetPercentile(0.50) / 1000.0;
+        stats.p90Milliseconds = m_latency[op].GetPercentile(0.90) / 1000.0;
+        stats.p99Milliseconds = m_latency[op].GetPercentile(0.99) / 1000.0;
+        stats.maxMilliseconds = m_latency[op].GetMax() / 1000.0;
+    }
+}
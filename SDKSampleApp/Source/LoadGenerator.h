@@ -0,0 +1,195 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "SDKMessageObserver.h"
+#include "LatencyHistogram.h"
+
+// Issues the requests of the load generator. Each call issues one request and returns its
+// cookie, or an empty string if the request could not be issued.
+class ILoadGeneratorTarget
+{
+public:
+    virtual ~ILoadGeneratorTarget() {}
+    virtual std::string LoadLogin(const std::string &userName, const std::string &accountHandle) = 0;
+    virtual std::string LoadLogout(const std::string &accountHandle) = 0;
+    virtual std::string LoadJoin(const std::string &userName, const std::string &accountHandle, const std::string &sessionGroupHandle, const std::string &sessionHandle, const std::string &channelUri) = 0;
+    virtual std::string LoadLeave(const std::string &sessionGroupHandle, const std::string &sessionHandle) = 0;
+    virtual std::string LoadMove(const std::string &sessionHandle, double x, double y, double z) = 0;
+    virtual std::string LoadMute(const std::string &accountHandle, bool muted) = 0;
+    virtual std::string LoadMessage(const std::string &sessionHandle, const std::string &text) = 0;
+    virtual std::string LoadChannelUri(unsigned int index) = 0;
+};
+
+// Drives virtual accounts against the SDK: logs them in at the ramp rate, has each join
+// one of the channels, makes some leave and join again at the churn rate, and spreads
+// positional moves, mic mutes and text messages over the joined ones at the rates of the
+// schedule. Then it leaves and logs out everything it started.
+//
+// Every request is timed from being issued to its response, which the load generator
+// gets as an observer of the SDK messages, so it must be subscribed to GetMessageInterest().
+class LoadGenerator : public ISDKMessageObserver
+{
+public:
+    enum Operation {
+        opLogin,
+        opJoin,
+        opMove,
+        opMute,
+        opMessage,
+        opLeave,
+        opLogout,
+        c_nOperations
+    };
+    static const char *GetOperationName(Operation op);
+
+    // Rates, per second over all joined accounts, from a time on
+    struct Phase {
+        double startSeconds;
+        double movesPerSecond;
+        double mutesPerSecond;
+        double messagesPerSecond;
+    };
+
+    struct Settings {
+        Settings() : accounts(10), channels(2), rampPerSecond(5), churnPerSecond(0), seconds(60), drainSeconds(10), seed(1), userPrefix("loadgen") {}
+        unsigned int accounts;
+        unsigned int channels;
+        double rampPerSecond;       // logins issued per second until every account is in
+        double churnPerSecond;      // joined accounts leaving (and joining again) per second
+        double seconds;             // from the first login to starting to leave
+        double drainSeconds;        // most time waited for the last responses
+        unsigned int seed;
+        std::string userPrefix;
+        std::vector<Phase> schedule; // sorted by startSeconds; empty for 10 moves, 1 mute and 1 message per second
+    };
+
+    LoadGenerator();
+    ~LoadGenerator();
+
+    static SDKMessageInterest GetMessageInterest();
+
+    // Returns false with error set if the settings are not valid or a run is in progress
+    bool Start(ILoadGeneratorTarget *target, const Settings &settings, std::string &error);
+    // Ends the run early: leaves and logs out right away
+    void Stop();
+    // Waits for the run to end, returns false on timeout
+    bool Wait(unsigned int timeoutMilliseconds);
+    bool IsRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    struct OperationStats {
+        uint64_t issued;
+        uint64_t succeeded;
+        uint64_t failed;            // error response
+        uint64_t notIssued;         // the SDK refused the request
+        uint64_t pending;
+        double meanMilliseconds;
+        double p50Milliseconds;
+        double p90Milliseconds;
+        double p99Milliseconds;
+        double maxMilliseconds;
+    };
+    struct Report {
+        bool running;
+        double elapsedSeconds;
+        unsigned int loggedIn;
+        unsigned int joined;
+        OperationStats operations[c_nOperations];
+    };
+    void GetReport(Report &report) const;
+
+    // ISDKMessageObserver
+    void OnVivoxSDKMessage(vx_message_base_t *msg);
+
+private:
+    LoadGenerator(const LoadGenerator &); // disabled
+
+    enum AccountState {
+        accountIdle,
+        accountLoggingIn,
+        accountLoggedIn,
+        accountJoining,
+        accountJoined,
+        accountLeaving,
+        accountLoggingOut,
+        accountDone
+    };
+
+    struct Account {
+        std::string userName;
+        std::string accountHandle;
+        std::string sessionGroupHandle;
+        std::string sessionHandle;
+        unsigned int channel;
+        AccountState state;
+        bool muted;
+    };
+
+    struct Pending {
+        Operation op;
+        size_t account;
+        double issuedMilliseconds;
+    };
+
+    // Rate limiter issuing whole operations out of a fractional rate
+    struct Bucket {
+        Bucket() : tokens(0) {}
+        int Take(double perSecond, double seconds);
+        double tokens;
+    };
+
+    void DriverThread();
+    // m_mutex must be held
+    void Issue(Operation op, size_t account);
+    void Complete(const std::string &cookie, bool succeeded);
+    const Phase &CurrentPhase(double elapsedSeconds) const;
+    size_t PickAccount(AccountState state);
+    unsigned int CountAccounts(AccountState state) const;
+    double NowMilliseconds() const;
+
+    ILoadGeneratorTarget *m_target;
+    Settings m_settings;
+    std::vector<std::string> m_channelUris;
+    std::vector<Account> m_accounts;
+    std::map<std::string, Pending> m_pending;   // by cookie
+    std::mt19937 m_random;
+    double m_startMilliseconds;
+    double m_endMilliseconds;
+    uint64_t m_messageSerial;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopRequested;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+
+    struct Counters {
+        uint64_t issued;
+        uint64_t succeeded;
+        uint64_t failed;
+        uint64_t notIssued;
+    };
+    Counters m_counters[c_nOperations];
+    LatencyHistogram m_latency[c_nOperations];
+};
@@ -0,0 +1,152 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "MessageReplayer.h"
+#include <chrono>
+
+MessageReplayer::MessageReplayer() :
+    m_target(NULL),
+    m_recordedSpeed(false),
+    m_startMilliseconds(0),
+    m_stopRequested(false),
+    m_endMilliseconds(0),
+    m_running(false),
+    m_messages(0),
+    m_requests(0),
+    m_skipped(0),
+    m_dispatchNanoseconds(0)
+{
+}
+
+MessageReplayer::~MessageReplayer()
+{
+    Stop();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+double MessageReplayer::NowMilliseconds() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool MessageReplayer::Start(IMessageReplayTarget *target, const std::string &path, bool recordedSpeed, std::string &error)
+{
+    if (IsRunning()) {
+        error = "replaying " + m_path;
+        return false;
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (!m_reader.Open(path.c_str(), error)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_target = target;
+    m_path = path;
+    m_recordedSpeed = recordedSpeed;
+    m_stopRequested = false;
+    m_error.clear();
+    m_messages = 0;
+    m_requests = 0;
+    m_skipped = 0;
+    m_dispatchNanoseconds = 0;
+    m_lateness.Reset();
+    m_startMilliseconds = NowMilliseconds();
+    m_endMilliseconds = 0;
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&MessageReplayer::ReplayThread, this);
+    return true;
+}
+
+void MessageReplayer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_condition.notify_all();
+}
+
+bool MessageReplayer::Wait(unsigned int timeoutMilliseconds)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_condition.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), [this] { return !IsRunning(); });
+}
+
+void MessageReplayer::ReplayThread()
+{
+    MessageLogReader::Record record;
+    while (m_reader.Next(record)) {
+        if (record.kind == MessageLogReader::Record::kindRequest) {
+            MessageLogDestroyMessage(record.message);
+            m_requests.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (m_recordedSpeed) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            std::chrono::steady_clock::time_point until(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(m_startMilliseconds + record.milliseconds)));
+            m_condition.wait_until(lock, until, [this] { return m_stopRequested; });
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopRequested) {
+                MessageLogDestroyMessage(record.message);
+                break;
+            }
+        }
+        std::chrono::steady_clock::time_point dispatched = std::chrono::steady_clock::now();
+        if (m_recordedSpeed) {
+            double late = NowMilliseconds() - m_startMilliseconds - record.milliseconds;
+            m_lateness.Record(late > 0 ? (uint64_t)(late * 1000) : 0);
+        }
+        m_target->ReplayMessage(record.message);
+        m_dispatchNanoseconds.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - dispatched).count(), std::memory_order_relaxed);
+        m_messages.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_skipped = m_reader.GetSkippedCount();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = m_reader.GetError();
+        m_reader.Close();
+        m_endMilliseconds = NowMilliseconds();
+        m_running.store(false, std::memory_order_release);
+    }
+    m_condition.notify_all();
+}
+
+void MessageReplayer::GetReport(Report &report) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    report.path = m_path;
+    report.running = IsRunning();
+    report.recordedSpeed = m_recordedSpeed;
+    double end = report.running ? NowMilliseconds() : m_endMilliseconds;
+    report.elapsedSeconds = m_startMilliseconds > 0 ? (end - m_startMilliseconds) / 1000 : 0;
+    report.messages = m_messages.load(std::memory_order_relaxed);
+    report.requests = m_requests.load(std::memory_order_relaxed);
+    report.skipped = m_skipped.load(std::memory_order_relaxed);
+    report.dispatchSeconds = m_dispatchNanoseconds.load(std::memory_order_relaxed) / 1e9;
+    report.messagesPerSecond = report.dispatchSeconds > 0 ? report.messages / report.dispatchSeconds : 0;
+    report.meanLateMilliseconds = m_lateness.GetMean() / 1000;
+    report.p99LateMilliseconds = m_lateness.GetPercentile(0.99) / 1000.0;
+    report.maxLateMilliseconds = m_lateness.GetMax() / 1000.0;
+    report.error = m_error;
+}
@@ -0,0 +1,97 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdint.h>
+#include "MessageLog.h"
+#include "LatencyHistogram.h"
+
+// Handles the messages of a replay, on the replayer's thread
+class IMessageReplayTarget
+{
+public:
+    virtual ~IMessageReplayTarget() {}
+    // Takes the message, which is to be destroyed with MessageLogDestroyMessage()
+    virtual void ReplayMessage(vx_message_base_t *msg) = 0;
+};
+
+// Plays the responses and events of a message log back to a target from a thread of its
+// own, each at the time it was received relative to the first one, or as fast as the
+// target takes them. The requests of the log are only counted.
+//
+// At recorded speed the messages are due at absolute times from the start, so a message
+// handled late does not delay the ones after it; GetReport() shows how late they were. As
+// fast as possible, the dispatch time over the messages is the throughput of the target.
+class MessageReplayer
+{
+public:
+    MessageReplayer();
+    ~MessageReplayer();
+
+    // Opens the log and starts playing it. Returns false with error set if it cannot.
+    bool Start(IMessageReplayTarget *target, const std::string &path, bool recordedSpeed, std::string &error);
+    void Stop();
+    // Waits for the end of the log, returns false on timeout
+    bool Wait(unsigned int timeoutMilliseconds);
+    bool IsRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    struct Report {
+        std::string path;
+        bool running;
+        bool recordedSpeed;
+        double elapsedSeconds;
+        uint64_t messages;
+        uint64_t requests;
+        uint64_t skipped;           // of types this build does not know
+        double dispatchSeconds;     // in the target
+        double messagesPerSecond;   // over dispatchSeconds
+        // How much later than recorded the messages were handed to the target, at recorded speed
+        double meanLateMilliseconds;
+        double p99LateMilliseconds;
+        double maxLateMilliseconds;
+        std::string error;
+    };
+    void GetReport(Report &report) const;
+
+private:
+    MessageReplayer(const MessageReplayer &); // disabled
+
+    void ReplayThread();
+    double NowMilliseconds() const;
+
+    IMessageReplayTarget *m_target;
+    MessageLogReader m_reader;      // used by the replay thread only, while it runs
+    std::string m_path;
+    bool m_recordedSpeed;
+    double m_startMilliseconds;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopRequested;
+    double m_endMilliseconds;
+    std::string m_error;
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_messages;
+    std::atomic<uint64_t> m_requests;
+    std::atomic<uint64_t> m_skipped;
+    std::atomic<uint64_t> m_dispatchNanoseconds;
+    std::thread m_thread;
+    LatencyHistogram m_lateness;    // in microseconds
+};
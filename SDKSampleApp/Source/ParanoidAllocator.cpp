@@ -28,6 +28,10 @@
 #           pragma warning(pop)
 #       define TRACE_MAX_STACK_FRAMES 1024
 #       define TRACE_MAX_FUNCTION_NAME_LENGTH 1024
+#elif PARANOID_ALLOCATOR_EXECINFO
+#       include <execinfo.h>
+#       include <dlfcn.h>
+#       include <cxxabi.h>
 #endif
 
 #define __STDC_FORMAT_MACROS 1
@@ -249,6 +253,8 @@ public:
 
 // Uncomment to always use this allocator
 #define USE_PARANOID_ALLOCATOR 1
+// Checks every block on every free, under the allocator lock. SetScanBudget() does the same
+// checks in the background at a bounded cost.
 // #define PARANOID_ALLOCATOR_DO_CHECK_ALL 1
 
 // Uncomment if you want to always have assert() on leak
@@ -266,6 +272,13 @@ ParanoidAllocator::Stats::Stats()
     m_lCallocs = 0;
     m_lCurrentlyAllocated = 0;
     m_lPeakAllocated = 0;
+    m_lHidden = 0;
+    m_lQuarantinedBlocks = 0;
+    m_lQuarantinedBytes = 0;
+    m_lQuarantineMaxBlocks = 0;
+    m_lQuarantineMaxBytes = 0;
+    m_lQuarantineReleasedBlocks = 0;
+    m_lQuarantineReleasedBytes = 0;
 }
 
 ParanoidAllocator::Stats::Stats(const ParanoidAllocator::Stats &stats)
@@ -284,6 +297,13 @@ ParanoidAllocator::Stats &ParanoidAllocator::Stats::operator=(const ParanoidAllo
     m_lCallocs = stats.m_lCallocs;
     m_lCurrentlyAllocated = stats.m_lCurrentlyAllocated;
     m_lPeakAllocated = stats.m_lPeakAllocated;
+    m_lHidden = stats.m_lHidden;
+    m_lQuarantinedBlocks = stats.m_lQuarantinedBlocks;
+    m_lQuarantinedBytes = stats.m_lQuarantinedBytes;
+    m_lQuarantineMaxBlocks = stats.m_lQuarantineMaxBlocks;
+    m_lQuarantineMaxBytes = stats.m_lQuarantineMaxBytes;
+    m_lQuarantineReleasedBlocks = stats.m_lQuarantineReleasedBlocks;
+    m_lQuarantineReleasedBytes = stats.m_lQuarantineReleasedBytes;
     return *this;
 }
 
@@ -299,6 +319,14 @@ ParanoidAllocator::Stats ParanoidAllocator::Stats::operator-(const ParanoidAlloc
     result.m_lCallocs = m_lCallocs - stats.m_lCallocs;
     result.m_lCurrentlyAllocated = m_lCurrentlyAllocated - stats.m_lCurrentlyAllocated;
     result.m_lPeakAllocated = m_lPeakAllocated - stats.m_lPeakAllocated;
+    result.m_lHidden = m_lHidden - stats.m_lHidden;
+    // the quarantine size and limits are levels, not counters
+    result.m_lQuarantinedBlocks = m_lQuarantinedBlocks;
+    result.m_lQuarantinedBytes = m_lQuarantinedBytes;
+    result.m_lQuarantineMaxBlocks = m_lQuarantineMaxBlocks;
+    result.m_lQuarantineMaxBytes = m_lQuarantineMaxBytes;
+    result.m_lQuarantineReleasedBlocks = m_lQuarantineReleasedBlocks - stats.m_lQuarantineReleasedBlocks;
+    result.m_lQuarantineReleasedBytes = m_lQuarantineReleasedBytes - stats.m_lQuarantineReleasedBytes;
 
     // m_mapAllocsBySize
     // m_mapAllocsBySize - stats.m_mapAllocsBySize
@@ -331,32 +359,91 @@ std::string ParanoidAllocator::Stats::toString()
     ss << "m_lCallocs = " << m_lCallocs << "\n";
     ss << "m_lCurrentlyAllocated = " << m_lCurrentlyAllocated << "\n";
     ss << "m_lPeakAllocated = " << m_lPeakAllocated << "\n";
+    ss << "m_lQuarantinedBlocks = " << m_lQuarantinedBlocks << " (max " << m_lQuarantineMaxBlocks << ")\n";
+    ss << "m_lQuarantinedBytes = " << m_lQuarantinedBytes << " (max " << m_lQuarantineMaxBytes << ")\n";
+    ss << "m_lQuarantineReleasedBlocks = " << m_lQuarantineReleasedBlocks << "\n";
+    ss << "m_lQuarantineReleasedBytes = " << m_lQuarantineReleasedBytes << "\n";
     return ss.str();
 }
 
 
+ParanoidAllocator::Shard::Shard() :
+    m_buckets(c_nShardMinBuckets, (PAShardHeader *)NULL),
+    m_nBlocks(0),
+    m_lAllocs(0),
+    m_lFrees(0),
+    m_lAlignedAllocs(0),
+    m_lAlignedFrees(0),
+    m_lReallocs(0),
+    m_lCallocs(0),
+    m_lHidden(0)
+{
+    memset(m_freeLists, 0, sizeof(m_freeLists));
+    memset(m_lAllocsBySizeClass, 0, sizeof(m_lAllocsBySizeClass));
+}
+
 ParanoidAllocator::ParanoidAllocator() :
+    m_mode(modeStrict),
+    m_bModeFixed(false),
+    m_nQuarantineMaxBytes(64 * 1024 * 1024),
+    m_nQuarantineMaxBlocks(256 * 1024),
+    m_shards(NULL),
+    m_lShardedCurrentlyAllocated(0),
+    m_lShardedPeakAllocated(0),
+    m_stackSamplingInterval(256),
+    m_sampling(NULL),
+    m_nProfileSamplingInterval(512 * 1024),
+    m_bScanStop(false),
+    m_nScanBudgetPercent(0),
+    m_pStdOut(&printf),
+    m_pStdErr(&printStdErr),
+    m_pSymHelpers(new SymHelpers())
+{
+    ResetScanCursor();
+    memset(&m_scanStats, 0, sizeof(m_scanStats));
+}
+
+ParanoidAllocator::ParanoidAllocator(Mode mode) :
+    m_mode(modeStrict),
+    m_bModeFixed(false),
+    m_nQuarantineMaxBytes(64 * 1024 * 1024),
+    m_nQuarantineMaxBlocks(256 * 1024),
+    m_shards(NULL),
+    m_lShardedCurrentlyAllocated(0),
+    m_lShardedPeakAllocated(0),
+    m_stackSamplingInterval(256),
+    m_sampling(NULL),
+    m_nProfileSamplingInterval(512 * 1024),
+    m_bScanStop(false),
+    m_nScanBudgetPercent(0),
     m_pStdOut(&printf),
     m_pStdErr(&printStdErr),
     m_pSymHelpers(new SymHelpers())
 {
+    ResetScanCursor();
+    memset(&m_scanStats, 0, sizeof(m_scanStats));
+    SetMode(mode);
 }
 
 ParanoidAllocator::~ParanoidAllocator()
 {
+    StopScanner();
+    if (m_mode == modeSharded) {
+        ShardedDestroy(true);
+        delete m_pSymHelpers;
+        return;
+    }
+    if (m_mode == modeSampling) {
+        SamplingDestroy(true);
+        delete m_pSymHelpers;
+        return;
+    }
+
     std::list<void *> blocks;
     std::list<void *> blocks_aligned;
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        for (BlockListMap::const_iterator it = m_mapFreeBlockListsBySize.begin(); it != m_mapFreeBlockListsBySize.end(); it++) {
-            BlockList *pBlockList = it->second;
-            while (!pBlockList->empty()) {
-                free(pBlockList->front());
-                pBlockList->pop_front();
-            }
-            delete pBlockList;
-        }
-        m_mapFreeBlockListsBySize.clear();
+        ReleaseQuarantinedBlocks(0, 0);
 
         if (!m_mapAllocatedBlocks.empty()) {
             int hidden = 0;
@@ -414,6 +501,76 @@ ParanoidAllocator::~ParanoidAllocator()
     delete m_pSymHelpers;
 }
 
+bool ParanoidAllocator::SetMode(Mode mode)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (mode == m_mode) {
+        return true;
+    }
+    if (m_bModeFixed) {
+        return false;
+    }
+    if (!m_mapAllocatedBlocks.empty() || !m_mapAllocatedAlignedBlocks.empty()) {
+        return false;
+    }
+    if (m_shards) {
+        for (size_t i = 0; i < c_nShards; i++) {
+            if (m_shards[i].m_nBlocks != 0) {
+                return false;
+            }
+        }
+        ShardedDestroy(false);
+    }
+    if (m_sampling) {
+        if (m_sampling->m_lBlocks != 0) {
+            return false;
+        }
+        SamplingDestroy(false);
+    }
+    if (mode != modeStrict) {
+        ReleaseQuarantinedBlocks(0, 0);
+    }
+    if (mode == modeSharded) {
+        m_shards = new Shard[c_nShards];
+    } else if (mode == modeSampling) {
+        m_sampling = new Sampling(m_nProfileSamplingInterval);
+    }
+    m_mode.store(mode, std::memory_order_release);
+    ResetScanCursor();
+    return true;
+}
+
+const char *ParanoidAllocator::GetModeName(Mode mode)
+{
+    switch (mode) {
+        case modeStrict:
+            return "strict";
+        case modeSharded:
+            return "sharded";
+        case modeSampling:
+            return "sampling";
+        default:
+            return "unknown";
+    }
+}
+
+bool ParanoidAllocator::ParseMode(const char *name, Mode &mode)
+{
+    if (name == NULL) {
+        return false;
+    }
+    if (0 == strcmp(name, "strict")) {
+        mode = modeStrict;
+    } else if (0 == strcmp(name, "sharded")) {
+        mode = modeSharded;
+    } else if (0 == strcmp(name, "sampling")) {
+        mode = modeSampling;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 ParanoidAllocator::OutputFunction ParanoidAllocator::SetOutputFunction(OutputFunction pfOutput)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -422,20 +579,38 @@ ParanoidAllocator::OutputFunction ParanoidAllocator::SetOutputFunction(OutputFun
     return pfTmp;
 }
 
-ParanoidAllocator::BlockList *ParanoidAllocator::GetBlockList(size_t bytes, bool bCreate)
+void ParanoidAllocator::SetQuarantineLimits(size_t maxBytes, size_t maxBlocks)
 {
-    BlockList *pBlockList = NULL;
-    BlockListMap::const_iterator it = m_mapFreeBlockListsBySize.find(bytes);
-    if (it == m_mapFreeBlockListsBySize.end()) {
-        if (bCreate) {
-            pBlockList = new BlockList;
-            m_mapFreeBlockListsBySize[bytes] = pBlockList;
-        }
-    } else {
-        pBlockList = it->second;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nQuarantineMaxBytes = maxBytes;
+    m_nQuarantineMaxBlocks = maxBlocks;
+    if (maxBytes || maxBlocks) {
+        ReleaseQuarantinedBlocks(maxBytes ? maxBytes : (size_t)-1, maxBlocks ? maxBlocks : (size_t)-1);
+    }
+}
+
+void ParanoidAllocator::GetQuarantineLimits(size_t &maxBytes, size_t &maxBlocks)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    maxBytes = m_nQuarantineMaxBytes;
+    maxBlocks = m_nQuarantineMaxBlocks;
+}
+
+// Releases the oldest quarantined blocks until the quarantine is within the limits; 0, 0 empties it
+void ParanoidAllocator::ReleaseQuarantinedBlocks(size_t maxBytes, size_t maxBlocks)
+{
+    while (!m_quarantine.empty() && ((size_t)m_stats.m_lQuarantinedBytes > maxBytes || m_quarantine.size() > maxBlocks)) {
+        QuarantinedBlock &block = m_quarantine.front();
+        // Last chance to catch a write after free
+        CheckFreeBlockIntegrity(block.p, block.size);
+        long blockBytes = static_cast<long>(PABlockSizeFromUser(block.size));
+        m_stats.m_lQuarantinedBlocks--;
+        m_stats.m_lQuarantinedBytes -= blockBytes;
+        m_stats.m_lQuarantineReleasedBlocks++;
+        m_stats.m_lQuarantineReleasedBytes += blockBytes;
+        free(block.p);
+        m_quarantine.pop_front();
     }
-    assert(pBlockList || !bCreate);
-    return pBlockList;
 }
 
 #   define update_allocated_by_allocators(x)
@@ -451,24 +626,10 @@ ParanoidAllocator::BlockList *ParanoidAllocator::GetBlockList(size_t bytes, bool
 void *ParanoidAllocator::paranoidAllocImpl(ParanoidAllocator::BlockSizeMap &map, size_t bytes, bool bUpdateStats)
 {
     assert(bytes != 0);
-    unsigned char *p = NULL;
-    // Find list of free blocks of this size
-    BlockList *pBlockList = GetBlockList(bytes, false);
-    if (pBlockList && !pBlockList->empty()) {
-        p = (unsigned char *)pBlockList->front();
-        pBlockList->pop_front();
-        assert(p != NULL);
-        // Check that free block is really intact
-        for (size_t n = 0; n < PABlockSizeFromUser(bytes); n++) {
-            assert(p[n] == c_byteFiller);
-        }
-    }
-    if (!p) {
-        // Allocate a new block
-        p = (unsigned char *)malloc(PABlockSizeFromUser(bytes));
-        if (p == NULL) {
-            return p;
-        }
+    // Always a new block: freed ones stay in the quarantine until they are released to the system
+    unsigned char *p = (unsigned char *)malloc(PABlockSizeFromUser(bytes));
+    if (p == NULL) {
+        return p;
     }
     assert(p);
     // update stats
@@ -504,6 +665,25 @@ void *ParanoidAllocator::paranoidAllocImpl(ParanoidAllocator::BlockSizeMap &map,
 
 void ParanoidAllocator::HideUnfreedBlocks()
 {
+    if (m_mode == modeSampling) {
+        m_sampling->m_lHidden = m_sampling->m_lBlocks.load();
+        return;
+    }
+    if (m_mode == modeSharded) {
+        for (size_t i = 0; i < c_nShards; i++) {
+            Shard &shard = m_shards[i];
+            std::lock_guard<std::mutex> lock(shard.m_mutex);
+            for (size_t b = 0; b < shard.m_buckets.size(); b++) {
+                for (PAShardHeader *header = shard.m_buckets[b]; header; header = header->next) {
+                    if (!(header->flags & hdrFlag_Hidden)) {
+                        header->flags |= hdrFlag_Hidden;
+                        shard.m_lHidden++;
+                    }
+                }
+            }
+        }
+        return;
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     { // BlockSizeMap m_mapAllocatedBlocks;
         BlockSizeMap::iterator i = m_mapAllocatedBlocks.begin();
@@ -542,11 +722,21 @@ void ParanoidAllocator::DumpStack(void *place, size_t size)
     size -= sizeof(int);
 
     *frames = (int)m_pSymHelpers->CaptureStackBackTrace(0, (int)(size / sizeof(void *)), dump, NULL);
+#else
+    (void)place;
+    (void)size;
 #endif
 }
 
 void *ParanoidAllocator::paranoidAlloc(size_t bytes)
 {
+    Mode mode = AllocationMode();
+    if (mode == modeSharded) {
+        return shardedAlloc(bytes, false, true);
+    }
+    if (mode == modeSampling) {
+        return samplingAlloc(bytes, 0, false, true);
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     return paranoidAllocImpl(m_mapAllocatedBlocks, bytes, true);
 }
@@ -569,15 +759,10 @@ void ParanoidAllocator::CheckAllMemBlockIntegrity()
         }
     }
 
-    { // BlockListMap m_mapFreeBlockListsBySize;
-        BlockListMap::iterator i = m_mapFreeBlockListsBySize.begin();
-        for (; i != m_mapFreeBlockListsBySize.end(); i++) {
-            BlockList *lst = i->second;
-            BlockList::iterator j = lst->begin();
-            for (; j != lst->end(); j++) {
-                unsigned char *p = (unsigned char *)*j;
-                CheckMemBlockIntegrity(p, i->first);
-            }
+    { // Quarantine m_quarantine;
+        Quarantine::iterator i = m_quarantine.begin();
+        for (; i != m_quarantine.end(); i++) {
+            CheckFreeBlockIntegrity(i->p, i->size);
         }
     }
 }
@@ -603,6 +788,16 @@ void ParanoidAllocator::CheckMemBlockIntegrity(void *pMem, size_t blockSize)
     }
 }
 
+void ParanoidAllocator::CheckFreeBlockIntegrity(void *pMem, size_t bytes)
+{
+    unsigned char *p = (unsigned char *)pMem;
+    // Entire freed block is "no man's land", header included
+    for (size_t n = 0; n < PABlockSizeFromUser(bytes); n++) {
+        assert(p[n] == c_byteFiller);
+    }
+    (void)p; // unused variable in release
+}
+
 void ParanoidAllocator::paranoidFreeImpl(ParanoidAllocator::BlockSizeMap &map, void *pUserBlock, bool bUpdateStats)
 {
 #ifdef PARANOID_ALLOCATOR_DO_CHECK_ALL
@@ -637,21 +832,39 @@ void ParanoidAllocator::paranoidFreeImpl(ParanoidAllocator::BlockSizeMap &map, v
     update_allocated_by_allocators(-(int)bytes);
     // Remove the block from allocated blocks map
     map.erase(it);
-    // Add the block to the free list
-    BlockList *pList = GetBlockList(bytes, true);
-    pList->push_back(p);
     // Entire block is "no man's land" now
     memset(p, c_byteFiller, PABlockSizeFromUser(bytes));
+    // Quarantine the block, releasing the oldest ones if that goes over the limits
+    QuarantinedBlock block = { p, bytes };
+    m_quarantine.push_back(block);
+    m_stats.m_lQuarantinedBlocks++;
+    m_stats.m_lQuarantinedBytes += static_cast<long>(PABlockSizeFromUser(bytes));
+    ReleaseQuarantinedBlocks(m_nQuarantineMaxBytes ? m_nQuarantineMaxBytes : (size_t)-1, m_nQuarantineMaxBlocks ? m_nQuarantineMaxBlocks : (size_t)-1);
 }
 
 void ParanoidAllocator::paranoidFree(void *pUserBlock)
 {
+    if (m_mode == modeSharded) {
+        shardedFree(pUserBlock, false, true);
+        return;
+    }
+    if (m_mode == modeSampling) {
+        samplingFree(pUserBlock, false, true);
+        return;
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     paranoidFreeImpl(m_mapAllocatedBlocks, pUserBlock, true);
 }
 
 void *ParanoidAllocator::paranoidRealloc(void *pUserBlock, size_t bytes)
 {
+    Mode mode = AllocationMode();
+    if (mode == modeSharded) {
+        return shardedRealloc(pUserBlock, bytes);
+    }
+    if (mode == modeSampling) {
+        return samplingRealloc(pUserBlock, bytes);
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     bool bUpdateAllocStats = (pUserBlock == NULL);
     void *pNewUserBlock = paranoidAllocImpl(m_mapAllocatedBlocks, bytes, bUpdateAllocStats);
@@ -680,12 +893,40 @@ void *ParanoidAllocator::paranoidRealloc(void *pUserBlock, size_t bytes)
 
 void ParanoidAllocator::paranoidFreeAligned(void *p)
 {
+    if (m_mode == modeSharded) {
+        shardedFree(p, true, true);
+        return;
+    }
+    if (m_mode == modeSampling) {
+        samplingFree(p, true, true);
+        return;
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     paranoidFreeImpl(m_mapAllocatedAlignedBlocks, p, true);
 }
 
 void *ParanoidAllocator::paranoidCalloc(size_t count, size_t size)
 {
+    Mode mode = AllocationMode();
+    if (mode == modeSharded) {
+        void *p = shardedAlloc(size * count, false, false);
+        if (p) {
+            memset(p, 0, size * count);
+            size_t index;
+            Shard &shard = CurrentThreadShard(index);
+            std::lock_guard<std::mutex> lock(shard.m_mutex);
+            ++shard.m_lCallocs;
+        }
+        return p;
+    }
+    if (mode == modeSampling) {
+        void *p = samplingAlloc(size * count, 0, false, false);
+        if (p) {
+            memset(p, 0, size * count);
+            ++m_sampling->m_lCallocs;
+        }
+        return p;
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     void *p = paranoidAllocImpl(m_mapAllocatedBlocks, size * count, false);
     memset(p, 0, size * count);
@@ -696,7 +937,13 @@ void *ParanoidAllocator::paranoidCalloc(size_t count, size_t size)
 
 void *ParanoidAllocator::paranoidMemalign(size_t alignment, size_t bytes)
 {
-    (void)alignment;
+    Mode mode = AllocationMode();
+    if (mode == modeSharded) {
+        return shardedAlloc(bytes, true, true);
+    }
+    if (mode == modeSampling) {
+        return samplingAlloc(bytes, alignment, true, true);
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     // Ignore alignment for now
     return paranoidAllocImpl(m_mapAllocatedAlignedBlocks, bytes, true);
@@ -740,10 +987,13 @@ void ParanoidAllocator::AdHocSelfTest()
     assert(statsDiff.m_lCurrentlyAllocated == 0);
     // can fail if something was free before AdHocSelfTest() is called
     // assert(statsDiff.m_lPeakAllocated == 40);
-    assert(statsDiff.m_mapAllocsBySize.size() == 4);
-    for (size_t n = 10; n <= 40; n += 10) {
-        assert(statsDiff.m_mapAllocsBySize.find(n) != statsDiff.m_mapAllocsBySize.end());
-        assert(1 == statsDiff.m_mapAllocsBySize[n]);
+    if (m_mode == modeStrict) {
+        // sharded mode counts by size class
+        assert(statsDiff.m_mapAllocsBySize.size() == 4);
+        for (size_t n = 10; n <= 40; n += 10) {
+            assert(statsDiff.m_mapAllocsBySize.find(n) != statsDiff.m_mapAllocsBySize.end());
+            assert(1 == statsDiff.m_mapAllocsBySize[n]);
+        }
     }
 
     // Leave only one test of interest uncommented
@@ -791,12 +1041,30 @@ void ParanoidAllocator::AdHocSelfTest()
 
 void ParanoidAllocator::GetStats(ParanoidAllocator::Stats &stats)
 {
+    if (m_mode == modeSharded) {
+        ShardedGetStats(stats);
+        return;
+    }
+    if (m_mode == modeSampling) {
+        SamplingGetStats(stats);
+        return;
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     stats = m_stats;
+    stats.m_lQuarantineMaxBlocks = static_cast<long>(m_nQuarantineMaxBlocks);
+    stats.m_lQuarantineMaxBytes = static_cast<long>(m_nQuarantineMaxBytes);
 }
 
 void ParanoidAllocator::Dump()
 {
+    if (m_mode == modeSharded) {
+        ShardedDump("allocated");
+        return;
+    }
+    if (m_mode == modeSampling) {
+        SamplingDump("allocated");
+        return;
+    }
     if (!m_mapAllocatedBlocks.empty()) {
         m_pStdOut("%u block(s) allocated:\n", m_mapAllocatedBlocks.size());
         int hidden = 0;
@@ -905,6 +1173,903 @@ void ParanoidAllocator::PrintCurrentStack(const char *pszMessage)
 #endif
 }
 
+// Sharded mode
+
+ParanoidAllocator::Shard &ParanoidAllocator::CurrentThreadShard(size_t &index)
+{
+    static std::atomic<unsigned int> s_nextShard(0);
+    static thread_local int t_shard = -1;
+    if (t_shard < 0) {
+        t_shard = (int)(s_nextShard++ % c_nShards);
+    }
+    index = (size_t)t_shard;
+    return m_shards[index];
+}
+
+bool ParanoidAllocator::ShouldSampleStack()
+{
+    static thread_local unsigned int t_allocsSinceSample = 0;
+    unsigned int interval = m_stackSamplingInterval;
+    if (c_nStackTraceSize == 0 || interval == 0) {
+        return false;
+    }
+    if (++t_allocsSinceSample < interval) {
+        return false;
+    }
+    t_allocsSinceSample = 0;
+    return true;
+}
+
+size_t ParanoidAllocator::ShardBucket(const Shard &shard, const void *pUser) const
+{
+    uint64_t h = (uint64_t)(uintptr_t)pUser * 0x9E3779B97F4A7C15ull;
+    return (size_t)(h >> 32) & (shard.m_buckets.size() - 1);
+}
+
+void ParanoidAllocator::ShardedHashInsert(Shard &shard, PAShardHeader *header)
+{
+    if (shard.m_nBlocks >= 2 * shard.m_buckets.size()) {
+        // Grow, keeping the chains short
+        std::vector<PAShardHeader *> buckets(2 * shard.m_buckets.size(), (PAShardHeader *)NULL);
+        shard.m_buckets.swap(buckets);
+        for (size_t b = 0; b < buckets.size(); b++) {
+            PAShardHeader *next;
+            for (PAShardHeader *h = buckets[b]; h; h = next) {
+                next = h->next;
+                size_t bucket = ShardBucket(shard, UserBlockFromShard(h));
+                h->next = shard.m_buckets[bucket];
+                shard.m_buckets[bucket] = h;
+            }
+        }
+    }
+    size_t bucket = ShardBucket(shard, UserBlockFromShard(header));
+    header->next = shard.m_buckets[bucket];
+    shard.m_buckets[bucket] = header;
+    ++shard.m_nBlocks;
+}
+
+bool ParanoidAllocator::ShardedHashRemove(Shard &shard, PAShardHeader *header)
+{
+    PAShardHeader **pp = &shard.m_buckets[ShardBucket(shard, UserBlockFromShard(header))];
+    for (; *pp; pp = &(*pp)->next) {
+        if (*pp == header) {
+            *pp = header->next;
+            header->next = NULL;
+            --shard.m_nBlocks;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ParanoidAllocator::CheckShardBlockIntegrity(PAShardHeader *header, uint32_t magic)
+{
+    unsigned char *p = (unsigned char *)header;
+    assert(header->magic == magic);
+    (void)magic; // unused variable in release
+    for (size_t n = sizeof(PAShardHeader); n < c_nShardHeaderSize + c_nNoMansLand; n++) {
+        assert(p[n] == c_byteFiller);
+    }
+    unsigned char *pUser = (unsigned char *)UserBlockFromShard(header);
+    size_t end = ShardBlockCapacity(header) + c_nNoMansLand;
+    for (size_t n = header->size; n < end; n++) {
+        assert(pUser[n] == c_byteFiller);
+    }
+    if (magic == c_uiShardFreeMagic) {
+        size_t poisoned = header->size < c_nShardPoisonBytes ? header->size : c_nShardPoisonBytes;
+        for (size_t n = 0; n < poisoned; n++) {
+            assert(pUser[n] == c_byteFiller);
+        }
+    }
+    (void)pUser; // unused variable in release
+    (void)end;
+}
+
+void ParanoidAllocator::ShardedAddCurrentlyAllocated(long bytes)
+{
+    long current = m_lShardedCurrentlyAllocated.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    long peak = m_lShardedPeakAllocated.load(std::memory_order_relaxed);
+    while (current > peak && !m_lShardedPeakAllocated.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+}
+
+void *ParanoidAllocator::shardedAlloc(size_t bytes, bool bAligned, bool bUpdateStats)
+{
+    assert(bytes != 0);
+    size_t sizeClass = ShardSizeClass(bytes);
+    size_t capacity = sizeClass ? sizeClass * c_nShardClassGranularity : bytes;
+    void *stack = NULL;
+    if (ShouldSampleStack()) {
+        stack = malloc(c_nStackTraceSize);
+        DumpStack(stack, c_nStackTraceSize);
+    }
+
+    size_t index;
+    Shard &shard = CurrentThreadShard(index);
+    PAShardHeader *header = NULL;
+    {
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        if (sizeClass) {
+            header = shard.m_freeLists[sizeClass];
+            if (header) {
+                shard.m_freeLists[sizeClass] = header->next;
+            }
+        }
+        if (header) {
+            // Check that free block is really intact, then restore the guard below the old size
+            CheckShardBlockIntegrity(header, c_uiShardFreeMagic);
+            if (bytes < header->size) {
+                memset((unsigned char *)UserBlockFromShard(header) + bytes, c_byteFiller, header->size - bytes);
+            }
+        } else {
+            header = (PAShardHeader *)malloc(ShardBlockSizeFromCapacity(capacity));
+            if (header == NULL) {
+                free(stack);
+                return NULL;
+            }
+            memset(header, c_byteFiller, c_nShardHeaderSize + c_nNoMansLand);
+            memset((unsigned char *)UserBlockFromShard(header) + bytes, c_byteFiller, capacity - bytes + c_nNoMansLand);
+        }
+        header->magic = c_uiShardMagic;
+        header->shard = (uint8_t)index;
+        header->flags = bAligned ? hdrFlag_Aligned : 0;
+        header->sizeClass = (uint16_t)sizeClass;
+        header->size = bytes;
+        header->stack = stack;
+        ShardedHashInsert(shard, header);
+        if (bUpdateStats) {
+            if (bAligned) {
+                ++shard.m_lAlignedAllocs;
+            } else {
+                ++shard.m_lAllocs;
+            }
+        }
+        ++shard.m_lAllocsBySizeClass[sizeClass];
+    }
+    ShardedAddCurrentlyAllocated(static_cast<long>(bytes));
+    return UserBlockFromShard(header);
+}
+
+void ParanoidAllocator::shardedFree(void *pUserBlock, bool bAligned, bool bUpdateStats)
+{
+    PAShardHeader *header = pUserBlock ? ShardFromUserBlock(pUserBlock) : NULL;
+    if (header == NULL || header->magic != c_uiShardMagic || header->shard >= c_nShards) {
+        PrintCurrentStack("free called for memory which wasn't allocated:");
+        assert(header != NULL && header->magic == c_uiShardMagic); // passing the pointer which was never allocated, or freeing it twice?
+        return;
+    }
+    Shard &shard = m_shards[header->shard];
+    void *stack = NULL;
+    size_t bytes = 0;
+    bool bFound;
+    bool bKindMatches = true;
+    {
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        bFound = ShardedHashRemove(shard, header);
+        if (bFound) {
+            bKindMatches = ((header->flags & hdrFlag_Aligned) != 0) == bAligned;
+            if (!bKindMatches) {
+                ShardedHashInsert(shard, header);
+            }
+        }
+        if (bFound && bKindMatches) {
+            CheckShardBlockIntegrity(header, c_uiShardMagic);
+            if (header->flags & hdrFlag_Hidden) {
+                --shard.m_lHidden;
+            }
+            if (bUpdateStats) {
+                if (bAligned) {
+                    ++shard.m_lAlignedFrees;
+                } else {
+                    ++shard.m_lFrees;
+                }
+            }
+            bytes = header->size;
+            stack = header->stack;
+            header->stack = NULL;
+            header->magic = c_uiShardFreeMagic;
+            header->flags = 0;
+            if (header->sizeClass) {
+                // Only the head of the block is "no man's land" now, the rest past size already is
+                memset(pUserBlock, c_byteFiller, bytes < c_nShardPoisonBytes ? bytes : c_nShardPoisonBytes);
+                header->next = shard.m_freeLists[header->sizeClass];
+                shard.m_freeLists[header->sizeClass] = header;
+                header = NULL;
+            }
+        }
+    }
+    if (!bFound || !bKindMatches) {
+        PrintCurrentStack("free called for memory which wasn't allocated:");
+        assert(bFound && bKindMatches); // trying to free normal block as aligned, or vise versa? Or freeing it twice?
+        return;
+    }
+    free(stack);
+    // Blocks too large to be pooled go back to the system
+    free(header);
+    ShardedAddCurrentlyAllocated(-static_cast<long>(bytes));
+}
+
+void *ParanoidAllocator::shardedRealloc(void *pUserBlock, size_t bytes)
+{
+    void *pNewUserBlock = shardedAlloc(bytes, false, pUserBlock == NULL);
+    if (!pNewUserBlock) {
+        return NULL;
+    }
+    if (pUserBlock) {
+        PAShardHeader *header = ShardFromUserBlock(pUserBlock);
+        assert(header->magic == c_uiShardMagic);
+        size_t oldSize = header->size;
+        memcpy(pNewUserBlock, pUserBlock, (bytes > oldSize) ? oldSize : bytes);
+        shardedFree(pUserBlock, false, false);
+    }
+    // update stats
+    size_t index;
+    Shard &shard = CurrentThreadShard(index);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    ++shard.m_lReallocs;
+    return pNewUserBlock;
+}
+
+void ParanoidAllocator::ShardedGetStats(Stats &stats)
+{
+    stats = Stats();
+    stats.m_lHidden = 0;
+    for (size_t i = 0; i < c_nShards; i++) {
+        Shard &shard = m_shards[i];
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        stats.m_lAllocs += shard.m_lAllocs;
+        stats.m_lFrees += shard.m_lFrees;
+        stats.m_lAlignedAllocs += shard.m_lAlignedAllocs;
+        stats.m_lAlignedFrees += shard.m_lAlignedFrees;
+        stats.m_lReallocs += shard.m_lReallocs;
+        stats.m_lCallocs += shard.m_lCallocs;
+        stats.m_lHidden += shard.m_lHidden;
+        for (size_t c = 0; c <= c_nShardSizeClasses; c++) {
+            if (shard.m_lAllocsBySizeClass[c]) {
+                stats.m_mapAllocsBySize[c * c_nShardClassGranularity] += shard.m_lAllocsBySizeClass[c];
+            }
+        }
+    }
+    stats.m_lCurrentlyAllocated = m_lShardedCurrentlyAllocated.load();
+    stats.m_lPeakAllocated = m_lShardedPeakAllocated.load();
+}
+
+void ParanoidAllocator::ShardedCollectBlocks(std::vector<PAShardHeader *> &blocks)
+{
+    for (size_t i = 0; i < c_nShards; i++) {
+        Shard &shard = m_shards[i];
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        for (size_t b = 0; b < shard.m_buckets.size(); b++) {
+            for (PAShardHeader *header = shard.m_buckets[b]; header; header = header->next) {
+                blocks.push_back(header);
+            }
+        }
+    }
+}
+
+void ParanoidAllocator::ShardedDump(const char *pszTitle)
+{
+    std::vector<PAShardHeader *> blocks;
+    ShardedCollectBlocks(blocks);
+    if (blocks.empty()) {
+        return;
+    }
+    m_pStdOut("%u block(s) %s:\n", blocks.size(), pszTitle);
+    int hidden = 0;
+    for (std::vector<PAShardHeader *>::const_iterator it = blocks.begin(); it != blocks.end(); it++) {
+        PAShardHeader *header = *it;
+        if (!(header->flags & hdrFlag_Hidden)) {
+            m_pStdOut("  " PRIADDR " (%u bytes%s)\n", (uintptr_t)UserBlockFromShard(header), header->size, (header->flags & hdrFlag_Aligned) ? ", aligned" : "");
+            if (header->stack) {
+                PrintStack(header->stack, c_nStackTraceSize);
+            }
+        } else {
+            hidden++;
+        }
+    }
+    m_pStdOut("  %d block(s) shown and there is %d hidden block(s) (stacks are only kept for sampled allocations)\n", (int)blocks.size() - hidden, hidden);
+}
+
+void ParanoidAllocator::ShardedDestroy(bool bReportLeaks)
+{
+    std::vector<PAShardHeader *> blocks;
+    ShardedCollectBlocks(blocks);
+    if (bReportLeaks) {
+        ShardedDump("are still allocated");
+        if (blocks.empty()) {
+            m_pStdOut("ParanoidAllocator::~ParanoidAllocator - clean exit (sharded, peak mem use %ld bytes)\n", m_lShardedPeakAllocated.load());
+        } else {
+            m_pStdOut("ParanoidAllocator::~ParanoidAllocator - error!\n");
+        }
+#ifdef DMN_ASSERT_ON_LEAK
+        assert(blocks.empty());
+#endif
+    }
+    for (std::vector<PAShardHeader *>::const_iterator it = blocks.begin(); it != blocks.end(); it++) {
+        shardedFree(UserBlockFromShard(*it), ((*it)->flags & hdrFlag_Aligned) != 0, true);
+    }
+    for (size_t i = 0; i < c_nShards; i++) {
+        Shard &shard = m_shards[i];
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        for (size_t c = 0; c <= c_nShardSizeClasses; c++) {
+            while (shard.m_freeLists[c]) {
+                PAShardHeader *header = shard.m_freeLists[c];
+                shard.m_freeLists[c] = header->next;
+                free(header);
+            }
+        }
+    }
+    delete[] m_shards;
+    m_shards = NULL;
+}
+
+// Sampling mode
+
+ParanoidAllocator::Sampling::Sampling(size_t samplingInterval) :
+    m_profiler(samplingInterval),
+    m_lAllocs(0),
+    m_lFrees(0),
+    m_lAlignedAllocs(0),
+    m_lAlignedFrees(0),
+    m_lReallocs(0),
+    m_lCallocs(0),
+    m_lBlocks(0),
+    m_lHidden(0),
+    m_lCurrentlyAllocated(0),
+    m_lPeakAllocated(0)
+{
+}
+
+void ParanoidAllocator::SetProfileSamplingInterval(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nProfileSamplingInterval = bytes;
+    if (m_sampling) {
+        m_sampling->m_profiler.SetSamplingInterval(bytes);
+    }
+}
+
+size_t ParanoidAllocator::GetProfileSamplingInterval()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nProfileSamplingInterval;
+}
+
+void ParanoidAllocator::SamplingAddCurrentlyAllocated(long bytes)
+{
+    long current = (m_sampling->m_lCurrentlyAllocated += bytes);
+    long peak = m_sampling->m_lPeakAllocated.load(std::memory_order_relaxed);
+    while (current > peak && !m_sampling->m_lPeakAllocated.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+}
+
+// Decides whether the block is sampled and records its call site if it is
+void ParanoidAllocator::SamplingRecord(PASampleHeader *header)
+{
+    header->site = 0;
+    header->weight = 0;
+    if (!m_sampling->m_profiler.ShouldSample((size_t)header->size, header->weight)) {
+        return;
+    }
+    void *frames[AllocationProfiler::c_nMaxFrames];
+    size_t count = 0;
+#if PARANOID_ALLOCATOR_BACKTRACE
+    count = m_pSymHelpers->CaptureStackBackTrace(c_nProfilerSkipFrames, AllocationProfiler::c_nMaxFrames, frames, NULL);
+#elif PARANOID_ALLOCATOR_EXECINFO
+    // backtrace() has no frames to skip, and SamplingRecord() is one more
+    void *all[AllocationProfiler::c_nMaxFrames + c_nProfilerSkipFrames + 1];
+    int captured = backtrace(all, (int)(sizeof(all) / sizeof(all[0])));
+    if (captured > (int)c_nProfilerSkipFrames + 1) {
+        count = (size_t)captured - (c_nProfilerSkipFrames + 1);
+        memcpy(frames, all + c_nProfilerSkipFrames + 1, count * sizeof(void *));
+    }
+#endif
+    header->site = m_sampling->m_profiler.RecordAllocation(frames, count, (size_t)header->size, header->weight);
+}
+
+void *ParanoidAllocator::samplingAlloc(size_t bytes, size_t alignment, bool bAligned, bool bUpdateStats)
+{
+    if (alignment <= sizeof(PASampleHeader)) {
+        alignment = 0;
+    }
+    unsigned char *p = (unsigned char *)malloc(sizeof(PASampleHeader) + bytes + (alignment ? alignment - 1 : 0));
+    if (p == NULL) {
+        return NULL;
+    }
+    unsigned char *pUser = p + sizeof(PASampleHeader);
+    if (alignment) {
+        pUser = (unsigned char *)(((uintptr_t)pUser + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+    PASampleHeader *header = SampleHeaderFromUserBlock(pUser);
+    header->magic = c_uiSampleMagic;
+    header->offset = (uint32_t)(pUser - p);
+    header->size = bytes;
+    header->flags = bAligned ? hdrFlag_Aligned : 0;
+    header->reserved = 0;
+    SamplingRecord(header);
+    if (bUpdateStats) {
+        if (bAligned) {
+            ++m_sampling->m_lAlignedAllocs;
+        } else {
+            ++m_sampling->m_lAllocs;
+        }
+    }
+    ++m_sampling->m_lBlocks;
+    SamplingAddCurrentlyAllocated(static_cast<long>(bytes));
+    return pUser;
+}
+
+void ParanoidAllocator::samplingFree(void *pUserBlock, bool bAligned, bool bUpdateStats)
+{
+    if (pUserBlock == NULL) {
+        return;
+    }
+    PASampleHeader *header = SampleHeaderFromUserBlock(pUserBlock);
+    if (header->magic != c_uiSampleMagic) {
+        PrintCurrentStack("free called for memory which wasn't allocated:");
+        assert(header->magic == c_uiSampleMagic);
+        return;
+    }
+    // trying to free normal block as aligned, or vise versa?
+    assert(((header->flags & hdrFlag_Aligned) != 0) == bAligned);
+    m_sampling->m_profiler.RecordFree(header->site, (size_t)header->size, header->weight);
+    if (bUpdateStats) {
+        if (bAligned) {
+            ++m_sampling->m_lAlignedFrees;
+        } else {
+            ++m_sampling->m_lFrees;
+        }
+    }
+    --m_sampling->m_lBlocks;
+    SamplingAddCurrentlyAllocated(-static_cast<long>(header->size));
+    header->magic = 0;
+    free(((unsigned char *)pUserBlock) - header->offset);
+}
+
+void *ParanoidAllocator::samplingRealloc(void *pUserBlock, size_t bytes)
+{
+    ++m_sampling->m_lReallocs;
+    if (pUserBlock == NULL) {
+        return samplingAlloc(bytes, 0, false, true);
+    }
+    PASampleHeader *header = SampleHeaderFromUserBlock(pUserBlock);
+    assert(header->magic == c_uiSampleMagic);
+    assert(header->offset == sizeof(PASampleHeader));
+    size_t oldSize = (size_t)header->size;
+    uint32_t oldSite = header->site;
+    float oldWeight = header->weight;
+    header = (PASampleHeader *)realloc(header, sizeof(PASampleHeader) + bytes);
+    if (header == NULL) {
+        return NULL;
+    }
+    // Profiled as the free of the old block and the allocation of a new one
+    m_sampling->m_profiler.RecordFree(oldSite, oldSize, oldWeight);
+    header->size = bytes;
+    SamplingRecord(header);
+    SamplingAddCurrentlyAllocated(static_cast<long>(bytes) - static_cast<long>(oldSize));
+    return header + 1;
+}
+
+void ParanoidAllocator::SamplingGetStats(Stats &stats)
+{
+    stats = Stats();
+    stats.m_lAllocs = m_sampling->m_lAllocs;
+    stats.m_lFrees = m_sampling->m_lFrees;
+    stats.m_lAlignedAllocs = m_sampling->m_lAlignedAllocs;
+    stats.m_lAlignedFrees = m_sampling->m_lAlignedFrees;
+    stats.m_lReallocs = m_sampling->m_lReallocs;
+    stats.m_lCallocs = m_sampling->m_lCallocs;
+    stats.m_lHidden = m_sampling->m_lHidden;
+    stats.m_lCurrentlyAllocated = m_sampling->m_lCurrentlyAllocated;
+    stats.m_lPeakAllocated = m_sampling->m_lPeakAllocated;
+}
+
+std::string ParanoidAllocator::FrameName(void *address)
+{
+#if PARANOID_ALLOCATOR_BACKTRACE
+    char buffer[sizeof(SYMBOL_INFO) + (TRACE_MAX_FUNCTION_NAME_LENGTH - 1) * sizeof(TCHAR)];
+    SYMBOL_INFO *symbol = reinterpret_cast<SYMBOL_INFO *>(buffer);
+    symbol->MaxNameLen = TRACE_MAX_FUNCTION_NAME_LENGTH;
+    symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+    DWORD64 symbolDisplacement = 0;
+    if (m_pSymHelpers->SymFromAddr(GetCurrentProcess(), (DWORD64)address, &symbolDisplacement, symbol)) {
+        std::string name = symbol->Name;
+        // ';' separates the frames of a folded stack
+        for (size_t i = 0; i < name.size(); i++) {
+            if (name[i] == ';') {
+                name[i] = ':';
+            }
+        }
+        return name;
+    }
+#elif PARANOID_ALLOCATOR_EXECINFO
+    Dl_info info;
+    if (dladdr(address, &info) && info.dli_sname != NULL) {
+        int status = -1;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+        std::string name = status == 0 ? demangled : info.dli_sname;
+        free(demangled);
+        for (size_t i = 0; i < name.size(); i++) {
+            if (name[i] == ';') {
+                name[i] = ':';
+            }
+        }
+        return name;
+    }
+#endif
+    char name[32];
+    snprintf(name, sizeof(name), PRIADDR, (uintptr_t)address);
+    return name;
+}
+
+bool ParanoidAllocator::WriteProfile(const char *fileName, ProfileValue value, size_t &sites)
+{
+    sites = 0;
+    if (m_mode != modeSampling) {
+        return false;
+    }
+    std::vector<AllocationProfiler::SiteSnapshot> snapshots;
+    m_sampling->m_profiler.GetSites(snapshots);
+    FILE *fp = fopen(fileName, "w");
+    if (fp == NULL) {
+        return false;
+    }
+    // Symbolizing is slow, and most frames are shared by many sites
+    std::map<void *, std::string> names;
+    for (std::vector<AllocationProfiler::SiteSnapshot>::const_iterator it = snapshots.begin(); it != snapshots.end(); it++) {
+        int64_t n;
+        switch (value) {
+            case profileLiveObjects:
+                n = it->liveObjects;
+                break;
+            case profileTotalBytes:
+                n = it->totalBytes;
+                break;
+            case profileTotalObjects:
+                n = it->totalObjects;
+                break;
+            default:
+                n = it->liveBytes;
+                break;
+        }
+        if (n <= 0) {
+            continue;
+        }
+        std::string line;
+        for (size_t f = it->frames.size(); f-- > 0;) {
+            std::map<void *, std::string>::iterator name = names.find(it->frames[f]);
+            if (name == names.end()) {
+                name = names.insert(std::make_pair(it->frames[f], FrameName(it->frames[f]))).first;
+            }
+            if (!line.empty()) {
+                line += ';';
+            }
+            line += name->second;
+        }
+        fprintf(fp, "%s %lld\n", line.empty() ? "[unknown]" : line.c_str(), (long long)n);
+        sites++;
+    }
+    return fclose(fp) == 0;
+}
+
+void ParanoidAllocator::ResetProfile()
+{
+    if (m_mode == modeSampling) {
+        m_sampling->m_profiler.ResetTotals();
+    }
+}
+
+void ParanoidAllocator::SamplingDump(const char *pszTitle)
+{
+    long blocks = m_sampling->m_lBlocks;
+    long hidden = m_sampling->m_lHidden;
+    m_pStdOut("%ld block(s) %s, %ld bytes, and there is %ld hidden block(s) (blocks are not tracked in sampling mode)\n", blocks, pszTitle, m_sampling->m_lCurrentlyAllocated.load(), hidden);
+    const AllocationProfiler &profiler = m_sampling->m_profiler;
+    m_pStdOut("  profile: %llu sample(s) in %u site(s), %llu dropped, one sample every %u bytes on average\n",
+            (unsigned long long)profiler.GetSampleCount(), (unsigned int)profiler.GetSiteCount(),
+            (unsigned long long)profiler.GetDroppedSampleCount(), (unsigned int)profiler.GetSamplingInterval());
+
+    // The sites holding the most memory, with their innermost frames
+    std::vector<AllocationProfiler::SiteSnapshot> sites;
+    profiler.GetSites(sites);
+    std::multimap<int64_t, const AllocationProfiler::SiteSnapshot *> byLiveBytes;
+    for (std::vector<AllocationProfiler::SiteSnapshot>::const_iterator it = sites.begin(); it != sites.end(); it++) {
+        if (it->liveBytes > 0) {
+            byLiveBytes.insert(std::make_pair(it->liveBytes, &*it));
+        }
+    }
+    int shown = 0;
+    for (std::multimap<int64_t, const AllocationProfiler::SiteSnapshot *>::const_reverse_iterator it = byLiveBytes.rbegin(); it != byLiveBytes.rend() && shown < 10; it++, shown++) {
+        const AllocationProfiler::SiteSnapshot &site = *it->second;
+        std::string frames;
+        for (size_t f = 0; f < site.frames.size() && f < 4; f++) {
+            frames += f ? " < " : "";
+            frames += FrameName(site.frames[f]);
+        }
+        m_pStdOut("  ~%lld bytes in ~%lld block(s): %s\n", (long long)site.liveBytes, (long long)site.liveObjects, frames.empty() ? "[unknown]" : frames.c_str());
+    }
+}
+
+void ParanoidAllocator::SamplingDestroy(bool bReportLeaks)
+{
+    if (bReportLeaks) {
+        SamplingDump("are still allocated");
+        if (m_sampling->m_lBlocks == 0) {
+            m_pStdOut("ParanoidAllocator::~ParanoidAllocator - clean exit (sampling, peak mem use %ld bytes)\n", m_sampling->m_lPeakAllocated.load());
+        } else {
+            m_pStdOut("ParanoidAllocator::~ParanoidAllocator - error!\n");
+        }
+#ifdef DMN_ASSERT_ON_LEAK
+        assert(m_sampling->m_lBlocks == 0);
+#endif
+    }
+    // Blocks still allocated are not known, so they can't be freed here
+    delete m_sampling;
+    m_sampling = NULL;
+}
+
+// Heap scanner
+
+// Returns which part of an allocated block is damaged, or NULL
+const char *ParanoidAllocator::FindMemBlockCorruption(unsigned char *p, size_t bytes)
+{
+    PAHeader *header = (PAHeader *)p;
+    if (header->magic != c_uiMagic || header->size != bytes) {
+        return "header";
+    }
+    for (size_t n = sizeof(PAHeader); n < c_nNoMansLand; n++) {
+        if (p[n] != c_byteFiller) {
+            return "no man's land before the stack";
+        }
+    }
+    for (size_t n = 0; n < c_nNoMansLand; n++) {
+        if (p[c_nNoMansLand + c_nStackTraceSize + n] != c_byteFiller) {
+            return "no man's land before the block (underflow)";
+        }
+    }
+    for (size_t n = 0; n < c_nNoMansLand; n++) {
+        if (p[c_nNoMansLand + c_nStackTraceSize + c_nNoMansLand + bytes + n] != c_byteFiller) {
+            return "no man's land after the block (overflow)";
+        }
+    }
+    return NULL;
+}
+
+const char *ParanoidAllocator::FindShardBlockCorruption(PAShardHeader *header)
+{
+    unsigned char *p = (unsigned char *)header;
+    if (header->magic != c_uiShardMagic) {
+        return "header";
+    }
+    for (size_t n = sizeof(PAShardHeader); n < c_nShardHeaderSize + c_nNoMansLand; n++) {
+        if (p[n] != c_byteFiller) {
+            return "no man's land before the block (underflow)";
+        }
+    }
+    unsigned char *pUser = (unsigned char *)UserBlockFromShard(header);
+    size_t end = ShardBlockCapacity(header) + c_nNoMansLand;
+    for (size_t n = header->size; n < end; n++) {
+        if (pUser[n] != c_byteFiller) {
+            return "no man's land after the block (overflow)";
+        }
+    }
+    return NULL;
+}
+
+bool ParanoidAllocator::IsFreeBlockIntact(unsigned char *p, size_t bytes)
+{
+    size_t blockSize = PABlockSizeFromUser(bytes);
+    for (size_t n = 0; n < blockSize; n++) {
+        if (p[n] != c_byteFiller) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ParanoidAllocator::SetScanBudget(unsigned int budgetPercent)
+{
+    if (budgetPercent > 100) {
+        budgetPercent = 100;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_scanMutex);
+        m_nScanBudgetPercent = budgetPercent;
+    }
+    if (budgetPercent) {
+        StartScanner();
+    } else {
+        StopScanner();
+    }
+}
+
+unsigned int ParanoidAllocator::GetScanBudget()
+{
+    std::lock_guard<std::mutex> lock(m_scanMutex);
+    return m_nScanBudgetPercent;
+}
+
+void ParanoidAllocator::GetScanStats(ScanStats &stats)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats = m_scanStats;
+}
+
+void ParanoidAllocator::StartScanner()
+{
+    std::lock_guard<std::mutex> lock(m_scanMutex);
+    if (m_scanThread.joinable()) {
+        m_scanCondition.notify_all();
+        return;
+    }
+    m_bScanStop = false;
+    m_scanThread = std::thread(&ParanoidAllocator::ScannerThread, this);
+}
+
+void ParanoidAllocator::StopScanner()
+{
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(m_scanMutex);
+        m_bScanStop = true;
+        m_scanCondition.notify_all();
+        thread.swap(m_scanThread);
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void ParanoidAllocator::ScannerThread()
+{
+    std::unique_lock<std::mutex> lock(m_scanMutex);
+    while (!m_bScanStop) {
+        unsigned int budget = m_nScanBudgetPercent;
+        if (budget == 0) {
+            m_scanCondition.wait(lock);
+            continue;
+        }
+        lock.unlock();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t blocks = ScanSlice();
+        std::chrono::steady_clock::duration busy = std::chrono::steady_clock::now() - start;
+        lock.lock();
+        // Stay idle long enough for the time spent scanning to be the budgeted share
+        std::chrono::steady_clock::duration idle = blocks ?
+            busy * (100 - budget) / budget :
+            std::chrono::steady_clock::duration(std::chrono::milliseconds(100));
+        m_scanCondition.wait_for(lock, idle, [this, budget]() {
+            return m_bScanStop || m_nScanBudgetPercent != budget;
+        });
+    }
+}
+
+void ParanoidAllocator::ResetScanCursor()
+{
+    m_scanPhase = 0;
+    m_pScanCursor = NULL;
+    m_lScanQuarantineCursor = 0;
+    m_lScanQuarantineEnd = 0;
+    m_nScanShard = 0;
+    m_nScanBucket = 0;
+    m_scanCycleStart = std::chrono::steady_clock::now();
+}
+
+// Checks the next blocks, up to the slice limits. Returns the number of blocks checked.
+size_t ParanoidAllocator::ScanSlice()
+{
+    // Also keeps SetMode() from changing the heap under the scan in sharded mode
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_scanStats.m_bCorruptionFound) {
+        return 0;
+    }
+    size_t blocks = 0;
+    size_t bytes = 0;
+    bool bCycleDone = true;
+    if (m_mode == modeStrict) {
+        bCycleDone = ScanStrictSlice(blocks, bytes);
+    } else if (m_mode == modeSharded) {
+        bCycleDone = ScanShardedSlice(blocks, bytes);
+    }
+    m_scanStats.m_nBlocksChecked += blocks;
+    m_scanStats.m_nBytesChecked += bytes;
+    if (bCycleDone) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        m_scanStats.m_nCycles++;
+        m_scanStats.m_dLastCycleSeconds = std::chrono::duration<double>(now - m_scanCycleStart).count();
+        ResetScanCursor();
+    }
+    return blocks;
+}
+
+// Returns true once the end of the heap is reached. Have m_mutex locked before calling it.
+bool ParanoidAllocator::ScanStrictSlice(size_t &blocks, size_t &bytes)
+{
+    while (blocks < c_nScanSliceBlocks && bytes < c_nScanSliceBytes) {
+        if (m_scanPhase < 2) {
+            BlockSizeMap &map = m_scanPhase == 0 ? m_mapAllocatedBlocks : m_mapAllocatedAlignedBlocks;
+            // The cursor is a key rather than an iterator, so that blocks can come and go between slices
+            BlockSizeMap::const_iterator it = m_pScanCursor ? map.upper_bound(m_pScanCursor) : map.begin();
+            if (it == map.end()) {
+                m_scanPhase++;
+                m_pScanCursor = NULL;
+                m_lScanQuarantineEnd = m_stats.m_lQuarantineReleasedBlocks + (long)m_quarantine.size();
+                continue;
+            }
+            m_pScanCursor = it->first;
+            unsigned char *p = PABlockFromUser(it->first);
+            blocks++;
+            bytes += 3 * c_nNoMansLand;
+            const char *pszDamage = FindMemBlockCorruption(p, it->second);
+            if (pszDamage) {
+                ReportCorruption(pszDamage, it->first, it->second, p + c_nNoMansLand);
+                return false;
+            }
+        } else {
+            // Releasing blocks pops the front of the quarantine, so count from the first block ever quarantined
+            long index = m_lScanQuarantineCursor - m_stats.m_lQuarantineReleasedBlocks;
+            if (index < 0) {
+                index = 0;
+            }
+            if ((size_t)index >= m_quarantine.size() || m_stats.m_lQuarantineReleasedBlocks + index >= m_lScanQuarantineEnd) {
+                return true;
+            }
+            const QuarantinedBlock &block = m_quarantine[(size_t)index];
+            m_lScanQuarantineCursor = m_stats.m_lQuarantineReleasedBlocks + index + 1;
+            blocks++;
+            bytes += PABlockSizeFromUser(block.size);
+            if (!IsFreeBlockIntact((unsigned char *)block.p, block.size)) {
+                ReportCorruption("freed block (write after free)", UserBlockFromPA((unsigned char *)block.p), block.size, NULL);
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+// Returns true once the end of the heap is reached. Have m_mutex locked before calling it.
+bool ParanoidAllocator::ScanShardedSlice(size_t &blocks, size_t &bytes)
+{
+    while (blocks < c_nScanSliceBlocks && bytes < c_nScanSliceBytes) {
+        if (m_nScanShard >= c_nShards) {
+            return true;
+        }
+        Shard &shard = m_shards[m_nScanShard];
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        // Growing the table only moves blocks to higher buckets, so none is skipped
+        while (m_nScanBucket < shard.m_buckets.size() && blocks < c_nScanSliceBlocks && bytes < c_nScanSliceBytes) {
+            for (PAShardHeader *header = shard.m_buckets[m_nScanBucket]; header; header = header->next) {
+                blocks++;
+                bytes += c_nShardHeaderSize + c_nNoMansLand + ShardBlockCapacity(header) - header->size + c_nNoMansLand;
+                const char *pszDamage = FindShardBlockCorruption(header);
+                if (pszDamage) {
+                    ReportCorruption(pszDamage, UserBlockFromShard(header), header->size, header->stack);
+                    return false;
+                }
+            }
+            m_nScanBucket++;
+        }
+        if (m_nScanBucket >= shard.m_buckets.size()) {
+            m_nScanShard++;
+            m_nScanBucket = 0;
+        }
+    }
+    return false;
+}
+
+void ParanoidAllocator::ReportCorruption(const char *pszDamage, void *pUser, size_t size, void *stack)
+{
+    m_scanStats.m_bCorruptionFound = true;
+    m_pStdErr("ParanoidAllocator: heap scan found a damaged %s in block " PRIADDR " (%u bytes)\n", pszDamage, (uintptr_t)pUser, (unsigned int)size);
+    if (stack) {
+        m_pStdErr("Stack recorded when the block was allocated:\n");
+        PrintStack(stack, c_nStackTraceSize);
+    } else {
+        m_pStdErr("No stack was recorded for the block\n");
+    }
+    assert(!"heap corruption");
+}
+
 void *ParanoidAllocator::s_malloc(size_t size)
 {
     return ParanoidAllocator::GetInstance().paranoidAlloc(size);
@@ -964,6 +2129,18 @@ void ParanoidAllocator::ConfigureHooksIfRequired(vx_sdk_config_t &config)
 
 bool ParanoidAllocator::AreThereAllocatedBlocks()
 {
+    if (m_mode == modeSharded) {
+        long count = 0;
+        for (size_t i = 0; i < c_nShards; i++) {
+            Shard &shard = m_shards[i];
+            std::lock_guard<std::mutex> lock(shard.m_mutex);
+            count += (long)shard.m_nBlocks - shard.m_lHidden;
+        }
+        return count ? true : false;
+    }
+    if (m_mode == modeSampling) {
+        return m_sampling->m_lBlocks > m_sampling->m_lHidden;
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     size_t count = m_mapAllocatedBlocks.size();
     count += m_mapAllocatedAlignedBlocks.size();
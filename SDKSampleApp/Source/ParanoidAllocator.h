@@ -14,15 +14,39 @@
  */
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <map>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 #include <stdint.h>
 #include "VxcTypes.h"
+#include "AllocationProfiler.h"
 
 
+// Stack traces of allocations use DbgHelp, so are only collected on Windows
+#ifndef PARANOID_ALLOCATOR_BACKTRACE
+#ifdef _WIN32
 #define PARANOID_ALLOCATOR_BACKTRACE 1
+#else
+#define PARANOID_ALLOCATOR_BACKTRACE 0
+#endif
+#endif
+
+// Elsewhere the sampling profiler takes them with the backtrace() of <execinfo.h>, and names the
+// frames found in the dynamic symbol table: link with -rdynamic for those of the application
+#ifndef PARANOID_ALLOCATOR_EXECINFO
+#if !PARANOID_ALLOCATOR_BACKTRACE && (defined(__GLIBC__) || defined(__APPLE__))
+#define PARANOID_ALLOCATOR_EXECINFO 1
+#else
+#define PARANOID_ALLOCATOR_EXECINFO 0
+#endif
+#endif
 
 
 
@@ -31,7 +55,8 @@ class ParanoidAllocator
 {
 private:
     enum {
-        hdrFlag_Hidden = 0x00000001
+        hdrFlag_Hidden = 0x00000001,
+        hdrFlag_Aligned = 0x00000002
     };
 
     typedef struct PAHeader {
@@ -40,10 +65,96 @@ private:
         size_t size;
     } PAHeader;
 
+    // Header of a block allocated in sharded mode, followed by a whole no man's land before the user block
+    typedef struct PAShardHeader {
+        uint32_t magic;
+        uint8_t shard;
+        uint8_t flags;
+        uint16_t sizeClass;             // 0 for blocks too large to be pooled
+        size_t size;
+        struct PAShardHeader *next;     // hash chain while allocated, free list while free
+        void *stack;                    // captured stack of a sampled allocation, or NULL
+    } PAShardHeader;
+
+    // Header of a block allocated in sampling mode, right before the user block
+    typedef struct PASampleHeader {
+        uint32_t magic;
+        uint32_t site;                  // profiler site of a sampled block, 0 otherwise
+        uint32_t offset;                // from the system block to the user block
+        float weight;                   // bytes the sample stands for
+        uint64_t size;
+        uint32_t flags;
+        uint32_t reserved;
+    } PASampleHeader;
+
 public:
+    enum Mode {
+        // One lock, every block tracked in a map, stack captured on every allocation,
+        // entire freed blocks filled and checked on reuse
+        modeStrict = 0,
+        // Blocks spread over per-thread shards with their own locks and intrusive hash
+        // tables, stack captured on sampled allocations only, and only the head of freed
+        // blocks filled. Guards are checked the same way as in strict mode.
+        modeSharded = 1,
+        // No checks: system blocks with a small header, and the stack captured for about one
+        // allocated byte in every profile sampling interval to build an allocation site profile.
+        // Cheap enough to leave on in production.
+        modeSampling = 2
+    };
+
+    // Standalone instance, e.g. for benchmarks. The SDK hooks use GetInstance().
+    explicit ParanoidAllocator(Mode mode);
     ~ParanoidAllocator();
     static ParanoidAllocator &GetInstance() { return s_Instance; }
 
+    // The mode is set once: fails after the first allocation, which fixes the current mode
+    bool SetMode(Mode mode);
+    Mode GetMode() const { return m_mode.load(std::memory_order_acquire); }
+    static const char *GetModeName(Mode mode);
+    static bool ParseMode(const char *name, Mode &mode);
+    // Sharded mode captures the stack of one allocation in every interval per thread; 0 turns capture off
+    void SetStackSamplingInterval(unsigned int interval) { m_stackSamplingInterval = interval; }
+    unsigned int GetStackSamplingInterval() const { return m_stackSamplingInterval; }
+    // Strict mode keeps freed blocks in a FIFO quarantine, filled and checked again when the oldest
+    // ones are released to the system to stay under these limits. 0 means no limit.
+    void SetQuarantineLimits(size_t maxBytes, size_t maxBlocks);
+    void GetQuarantineLimits(size_t &maxBytes, size_t &maxBlocks);
+
+    // Sampling mode profile, see AllocationProfiler.h
+    enum ProfileValue {
+        profileLiveBytes,
+        profileLiveObjects,
+        profileTotalBytes,
+        profileTotalObjects
+    };
+    // Mean bytes allocated between two samples, 512 KB by default; 0 turns sampling off
+    void SetProfileSamplingInterval(size_t bytes);
+    size_t GetProfileSamplingInterval();
+    // Writes the profile as folded stacks, one line per call site: its frames from the outermost
+    // one separated by ';', a space and the value. Fails outside sampling mode.
+    bool WriteProfile(const char *fileName, ProfileValue value, size_t &sites);
+    // Clears the cumulative values of the profile
+    void ResetProfile();
+    // False where no stack is taken: every call site of the profile is then "[unknown]"
+    static bool HasProfileStacks() { return PARANOID_ALLOCATOR_BACKTRACE || PARANOID_ALLOCATOR_EXECINFO; }
+
+    // Background heap scanner. Checks the guards of the allocated blocks and, in strict mode, the
+    // filler of the quarantined ones, a bounded slice at a time, so that a corruption is found
+    // without waiting for the block to be freed. The first one found is reported with the stack
+    // recorded for the block, and stops the scanner. budgetPercent is the share of time the
+    // scanner may spend holding the allocator locks; 0 stops it. Nothing is checked in sampling mode.
+    void SetScanBudget(unsigned int budgetPercent);
+    unsigned int GetScanBudget();
+
+    typedef struct ScanStats {
+        uint64_t m_nCycles;             // complete passes over the heap
+        uint64_t m_nBlocksChecked;
+        uint64_t m_nBytesChecked;
+        double m_dLastCycleSeconds;
+        bool m_bCorruptionFound;
+    } ScanStats;
+    void GetScanStats(ScanStats &stats);
+
     void *paranoidAlloc(size_t size);
     void  paranoidFree(void *p);
     void *paranoidRealloc(void *p, size_t size);
@@ -79,6 +190,8 @@ public:
         Stats operator-(const Stats &stats);
         std::string toString();
 
+        // Keyed by the requested size in strict mode, by the size class in sharded mode,
+        // where allocations larger than the largest class are counted under 0, empty in sampling mode
         std::map<size_t, long> m_mapAllocsBySize;
         long m_lAllocs;
         long m_lFrees;
@@ -89,6 +202,13 @@ public:
         long m_lCurrentlyAllocated;
         long m_lPeakAllocated;
         long m_lHidden;
+        // Quarantine of freed blocks, strict mode only. Bytes include guards and stack areas.
+        long m_lQuarantinedBlocks;
+        long m_lQuarantinedBytes;
+        long m_lQuarantineMaxBlocks;
+        long m_lQuarantineMaxBytes;
+        long m_lQuarantineReleasedBlocks;
+        long m_lQuarantineReleasedBytes;
     };
 
     void GetStats(Stats &stats);
@@ -98,15 +218,23 @@ private:
     static ParanoidAllocator s_Instance;
 
     typedef std::map<void *, size_t> BlockSizeMap;
-    typedef std::list<void *> BlockList;
-    typedef std::map<size_t, BlockList *> BlockListMap;
+    typedef struct QuarantinedBlock {
+        void *p;
+        size_t size;
+    } QuarantinedBlock;
+    typedef std::deque<QuarantinedBlock> Quarantine;
 
     std::mutex m_mutex;
+    // Read without a lock by every call; only SetMode() writes it, before m_bModeFixed is set
+    std::atomic<Mode> m_mode;
+    std::atomic<bool> m_bModeFixed;
     BlockSizeMap m_mapAllocatedBlocks;
     BlockSizeMap m_mapAllocatedAlignedBlocks;
     BlockSizeMap m_mapHiddenAllocatedBlocks;
     BlockSizeMap m_mapHiddenAllocatedAlignedBlocks;
-    BlockListMap m_mapFreeBlockListsBySize;
+    Quarantine m_quarantine;
+    size_t m_nQuarantineMaxBytes;
+    size_t m_nQuarantineMaxBlocks;
 
     Stats m_stats;
 
@@ -119,10 +247,23 @@ private:
     static const size_t c_nStackTraceSize = 0;
 #endif
 
+    // Called by every allocation: fixes the mode on the first one
+    Mode AllocationMode()
+    {
+        if (!m_bModeFixed.load(std::memory_order_relaxed)) {
+            m_bModeFixed.store(true, std::memory_order_seq_cst);
+        }
+        return m_mode.load(std::memory_order_acquire);
+    }
+
     // Unprotected functions. Have m_mutex locked before calling them
-    BlockList *GetBlockList(size_t size, bool bCreate);
+    void  ReleaseQuarantinedBlocks(size_t maxBytes, size_t maxBlocks);
     void  CheckAllMemBlockIntegrity();
     void  CheckMemBlockIntegrity(void *p, size_t blockSize = 0);
+    void  CheckFreeBlockIntegrity(void *p, size_t bytes);
+    const char *FindMemBlockCorruption(unsigned char *p, size_t bytes);
+    const char *FindShardBlockCorruption(PAShardHeader *header);
+    bool  IsFreeBlockIntact(unsigned char *p, size_t bytes);
     void *paranoidAllocImpl(BlockSizeMap &map, size_t bytes, bool bUpdateStats);
     void  paranoidFreeImpl(BlockSizeMap &map, void *p, bool bUpdateStats);
     void  DumpStack(void *place, size_t size);
@@ -142,6 +283,139 @@ private:
         return ((unsigned char *)p) - c_nNoMansLand - c_nStackTraceSize - c_nNoMansLand;
     }
 
+    // Sharded mode
+    static const size_t c_nShards = 16;
+    static const size_t c_nShardClassGranularity = 16;
+    static const size_t c_nShardSizeClasses = 256;  // pooled up to 4096 bytes
+    static const size_t c_nShardPoisonBytes = 64;
+    static const size_t c_nShardMinBuckets = 256;
+    static const uint32_t c_uiShardMagic = 0xBFBFB5B5;
+    static const uint32_t c_uiShardFreeMagic = 0xBFBFF5F5;
+    // The header rounded up to keep the user block aligned; the padding is filled like no man's land
+    static const size_t c_nShardHeaderSize = (sizeof(PAShardHeader) + c_nShardClassGranularity - 1) / c_nShardClassGranularity * c_nShardClassGranularity;
+
+    struct Shard {
+        Shard();
+        std::mutex m_mutex;
+        std::vector<PAShardHeader *> m_buckets;
+        size_t m_nBlocks;
+        PAShardHeader *m_freeLists[c_nShardSizeClasses + 1];
+        long m_lAllocs;
+        long m_lFrees;
+        long m_lAlignedAllocs;
+        long m_lAlignedFrees;
+        long m_lReallocs;
+        long m_lCallocs;
+        long m_lHidden;
+        long m_lAllocsBySizeClass[c_nShardSizeClasses + 1];
+    };
+
+    Shard *m_shards;
+    std::atomic<long> m_lShardedCurrentlyAllocated;
+    std::atomic<long> m_lShardedPeakAllocated;
+    unsigned int m_stackSamplingInterval;
+
+    static size_t ShardSizeClass(size_t bytes)
+    {
+        return bytes <= c_nShardSizeClasses * c_nShardClassGranularity ? (bytes + c_nShardClassGranularity - 1) / c_nShardClassGranularity : 0;
+    }
+    static size_t ShardBlockCapacity(const PAShardHeader *header)
+    {
+        return header->sizeClass ? header->sizeClass * c_nShardClassGranularity : header->size;
+    }
+    static size_t ShardBlockSizeFromCapacity(size_t capacity)
+    {
+        return c_nShardHeaderSize + capacity + 2 * c_nNoMansLand;
+    }
+    static void *UserBlockFromShard(PAShardHeader *header)
+    {
+        return ((unsigned char *)header) + c_nShardHeaderSize + c_nNoMansLand;
+    }
+    static PAShardHeader *ShardFromUserBlock(void *p)
+    {
+        return (PAShardHeader *)(((unsigned char *)p) - c_nShardHeaderSize - c_nNoMansLand);
+    }
+
+    Shard &CurrentThreadShard(size_t &index);
+    bool ShouldSampleStack();
+    size_t ShardBucket(const Shard &shard, const void *pUser) const;
+    void ShardedHashInsert(Shard &shard, PAShardHeader *header);
+    bool ShardedHashRemove(Shard &shard, PAShardHeader *header);
+    void *shardedAlloc(size_t bytes, bool bAligned, bool bUpdateStats);
+    void  shardedFree(void *p, bool bAligned, bool bUpdateStats);
+    void *shardedRealloc(void *p, size_t bytes);
+    void  CheckShardBlockIntegrity(PAShardHeader *header, uint32_t magic);
+    void  ShardedAddCurrentlyAllocated(long bytes);
+    void  ShardedGetStats(Stats &stats);
+    void  ShardedCollectBlocks(std::vector<PAShardHeader *> &blocks);
+    void  ShardedDump(const char *pszTitle);
+    void  ShardedDestroy(bool bReportLeaks);
+
+    // Sampling mode
+    static const uint32_t c_uiSampleMagic = 0xBFBF5A5A;
+    static const size_t c_nProfilerSkipFrames = 3;     // samplingAlloc(), paranoidAlloc() and s_malloc()
+
+    struct Sampling {
+        explicit Sampling(size_t samplingInterval);
+        AllocationProfiler m_profiler;
+        std::atomic<long> m_lAllocs;
+        std::atomic<long> m_lFrees;
+        std::atomic<long> m_lAlignedAllocs;
+        std::atomic<long> m_lAlignedFrees;
+        std::atomic<long> m_lReallocs;
+        std::atomic<long> m_lCallocs;
+        std::atomic<long> m_lBlocks;
+        std::atomic<long> m_lHidden;    // blocks are not tracked: the count when last hidden
+        std::atomic<long> m_lCurrentlyAllocated;
+        std::atomic<long> m_lPeakAllocated;
+    };
+
+    Sampling *m_sampling;
+    size_t m_nProfileSamplingInterval;
+
+    static PASampleHeader *SampleHeaderFromUserBlock(void *p)
+    {
+        return ((PASampleHeader *)p) - 1;
+    }
+
+    void *samplingAlloc(size_t bytes, size_t alignment, bool bAligned, bool bUpdateStats);
+    void  samplingFree(void *p, bool bAligned, bool bUpdateStats);
+    void *samplingRealloc(void *p, size_t bytes);
+    void  SamplingRecord(PASampleHeader *header);
+    void  SamplingAddCurrentlyAllocated(long bytes);
+    void  SamplingGetStats(Stats &stats);
+    void  SamplingDump(const char *pszTitle);
+    void  SamplingDestroy(bool bReportLeaks);
+    std::string FrameName(void *address);
+
+    // Heap scanner
+    static const size_t c_nScanSliceBlocks = 256;
+    static const size_t c_nScanSliceBytes = 256 * 1024;
+
+    void  StartScanner();
+    void  StopScanner();
+    void  ScannerThread();
+    size_t ScanSlice();
+    bool  ScanStrictSlice(size_t &blocks, size_t &bytes);
+    bool  ScanShardedSlice(size_t &blocks, size_t &bytes);
+    void  ResetScanCursor();
+    void  ReportCorruption(const char *pszDamage, void *pUser, size_t size, void *stack);
+
+    // m_scanMutex protects the thread and its settings, m_mutex the cursor and the stats
+    std::mutex m_scanMutex;
+    std::condition_variable m_scanCondition;
+    std::thread m_scanThread;
+    bool m_bScanStop;
+    unsigned int m_nScanBudgetPercent;
+    int m_scanPhase;                    // strict mode: allocated, aligned, quarantined blocks
+    void *m_pScanCursor;                // last block checked in the current map
+    long m_lScanQuarantineCursor;       // in blocks ever quarantined, see m_lQuarantineReleasedBlocks
+    long m_lScanQuarantineEnd;          // blocks quarantined after the phase started wait for the next cycle
+    size_t m_nScanShard;
+    size_t m_nScanBucket;
+    std::chrono::steady_clock::time_point m_scanCycleStart;
+    ScanStats m_scanStats;
+
     OutputFunction m_pStdOut, m_pStdErr;
 
     SymHelpers *m_pSymHelpers;
@@ -0,0 +1,391 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "PositionScheduler.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+using namespace vxplatform;
+
+PositionScheduler::OrbitTrajectory::OrbitTrajectory(const Position &center, double rmin, double rmax, double angularVelocityDegPerSec, double oscillationPeriodSeconds) :
+    m_center(center),
+    m_r0((rmax + rmin) / 2),
+    m_amp((rmax - rmin) / 2),
+    m_angularVelocityDegPerSec(angularVelocityDegPerSec),
+    m_oscillationPeriodSeconds(oscillationPeriodSeconds)
+{
+}
+
+void PositionScheduler::OrbitTrajectory::Evaluate(double t, Position &position) const
+{
+    double anglePhi = 2 * M_PI * m_angularVelocityDegPerSec / 360 * t / 1000;
+    double cosOmega = cos(2 * M_PI * t / 1000 / m_oscillationPeriodSeconds);
+
+    position.x = m_center.x + (m_r0 - m_amp * cosOmega) * sin(anglePhi);
+    position.y = m_center.y;
+    position.z = m_center.z - (m_r0 - m_amp * cosOmega) * cos(anglePhi);
+}
+
+PositionScheduler::LineTrajectory::LineTrajectory(const Position &from, const Position &to, double speed) :
+    m_from(from),
+    m_to(to),
+    m_speed(speed)
+{
+    double dx = to.x - from.x;
+    double dy = to.y - from.y;
+    double dz = to.z - from.z;
+    m_length = sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+void PositionScheduler::LineTrajectory::Evaluate(double t, Position &position) const
+{
+    if (m_length <= 0 || m_speed <= 0) {
+        position = m_from;
+        return;
+    }
+    double d = fmod(m_speed * t / 1000, 2 * m_length);
+    if (d > m_length) {
+        d = 2 * m_length - d;
+    }
+    double k = d / m_length;
+    position.x = m_from.x + (m_to.x - m_from.x) * k;
+    position.y = m_from.y + (m_to.y - m_from.y) * k;
+    position.z = m_from.z + (m_to.z - m_from.z) * k;
+}
+
+PositionScheduler::PositionScheduler(TimerQueue *pTimerQueue, unsigned int tickMilliseconds) :
+    m_tickMilliseconds(tickMilliseconds > 0 ? tickMilliseconds : 1),
+    m_pTimerQueue(pTimerQueue)
+{
+    m_baseMilliseconds = get_millisecond_tick_counter();
+    m_currentTick = 0;
+    m_epsilon = 0.001;
+    memset(m_wheel, 0, sizeof(m_wheel));
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_timer = 0;
+    m_timerDueMilliseconds = 0;
+    m_inTimer = false;
+    m_stopping = false;
+    create_event(&m_idleEvent);
+}
+
+PositionScheduler::~PositionScheduler()
+{
+    Stop();
+    CancelAll();
+    delete_event(m_idleEvent);
+}
+
+void PositionScheduler::SetSink(const Sink &sink)
+{
+    Locker locker(&m_lock);
+    m_sink = sink;
+}
+
+void PositionScheduler::SetEpsilon(double epsilon)
+{
+    Locker locker(&m_lock);
+    m_epsilon = epsilon < 0 ? 0 : epsilon;
+}
+
+double PositionScheduler::GetEpsilon() const
+{
+    Locker locker(&m_lock);
+    return m_epsilon;
+}
+
+uint64_t PositionScheduler::TickAt(double milliseconds) const
+{
+    if (milliseconds <= m_baseMilliseconds) {
+        return 0;
+    }
+    return (uint64_t)((milliseconds - m_baseMilliseconds) / m_tickMilliseconds);
+}
+
+void PositionScheduler::Link(Entry *entry)
+{
+    Entry *&head = m_wheel[entry->dueTick % c_nWheelSlots];
+    entry->prev = NULL;
+    entry->next = head;
+    if (head) {
+        head->prev = entry;
+    }
+    head = entry;
+}
+
+void PositionScheduler::Unlink(Entry *entry)
+{
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        m_wheel[entry->dueTick % c_nWheelSlots] = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+void PositionScheduler::Schedule(const std::string &sessionHandle, const std::shared_ptr<Trajectory> &trajectory, unsigned int periodMilliseconds)
+{
+    if (!trajectory) {
+        Cancel(sessionHandle);
+        return;
+    }
+
+    Locker locker(&m_lock);
+    Entry *entry;
+    std::map<std::string, Entry *>::iterator it = m_entries.find(sessionHandle);
+    if (it != m_entries.end()) {
+        entry = it->second;
+        Unlink(entry);
+    } else {
+        entry = new Entry();
+        entry->sessionHandle = sessionHandle;
+        m_entries[sessionHandle] = entry;
+    }
+
+    double now = get_millisecond_tick_counter();
+    uint64_t nowTick = TickAt(now);
+    entry->trajectory = trajectory;
+    entry->startMilliseconds = now;
+    entry->periodTicks = (periodMilliseconds + m_tickMilliseconds - 1) / m_tickMilliseconds;
+    if (entry->periodTicks == 0) {
+        entry->periodTicks = 1;
+    }
+    // First update goes out on the next tick the thread runs
+    entry->dueTick = nowTick > m_currentTick ? nowTick : m_currentTick;
+    entry->hasLastSent = false;
+    Link(entry);
+
+    Arm();
+}
+
+bool PositionScheduler::Cancel(const std::string &sessionHandle)
+{
+    Locker locker(&m_lock);
+    std::map<std::string, Entry *>::iterator it = m_entries.find(sessionHandle);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    Unlink(it->second);
+    delete it->second;
+    m_entries.erase(it);
+    return true;
+}
+
+void PositionScheduler::CancelAll()
+{
+    Locker locker(&m_lock);
+    for (std::map<std::string, Entry *>::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+        delete it->second;
+    }
+    m_entries.clear();
+    memset(m_wheel, 0, sizeof(m_wheel));
+}
+
+bool PositionScheduler::IsScheduled(const std::string &sessionHandle) const
+{
+    Locker locker(&m_lock);
+    return m_entries.find(sessionHandle) != m_entries.end();
+}
+
+size_t PositionScheduler::GetScheduledCount() const
+{
+    Locker locker(&m_lock);
+    return m_entries.size();
+}
+
+void PositionScheduler::GetStats(Stats &stats) const
+{
+    Locker locker(&m_lock);
+    stats = m_stats;
+}
+
+void PositionScheduler::ResetStats()
+{
+    Locker locker(&m_lock);
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+// m_lock must be held. Arms the timer for the next tick a session is due, unless it is armed
+// for earlier already or OnTimer() is under way, which arms it again when done.
+void PositionScheduler::Arm()
+{
+    if (m_stopping || m_inTimer) {
+        return;
+    }
+    double now = get_millisecond_tick_counter();
+    int delay = MillisecondsToNextDue(now);
+    if (delay < 0) {
+        return;
+    }
+    if (m_timer != 0) {
+        if (m_timerDueMilliseconds <= now + delay) {
+            return;
+        }
+        if (!m_pTimerQueue->Cancel(m_timer)) {
+            // It fired already, and its OnTimer() sees the new session
+            return;
+        }
+    }
+    m_timer = m_pTimerQueue->Schedule((unsigned long long)delay, 0, &PositionScheduler::OnTimer, this);
+    m_timerDueMilliseconds = now + delay;
+}
+
+void PositionScheduler::Stop()
+{
+    m_lock.Take();
+    m_stopping = true;
+    if (m_timer != 0 && m_pTimerQueue->Cancel(m_timer)) {
+        m_timer = 0;
+    }
+    // A timer that fired already still calls OnTimer()
+    while (m_timer != 0 || m_inTimer) {
+        m_lock.Release();
+        wait_event(m_idleEvent);
+        m_lock.Take();
+    }
+    m_stopping = false;
+    m_lock.Release();
+}
+
+// static
+void PositionScheduler::OnTimer(void *arg)
+{
+    PositionScheduler *pThis = reinterpret_cast<PositionScheduler *>(arg);
+    pThis->OnTimer();
+}
+
+// m_lock must be held. Evaluates every entry of the tick's slot that is due, at most once per wakeup.
+void PositionScheduler::RunTick(uint64_t tick, double now, std::vector<Update> &updates)
+{
+    Entry *due = NULL;
+    for (Entry *entry = m_wheel[tick % c_nWheelSlots]; entry != NULL;) {
+        Entry *next = entry->next;
+        if (entry->dueTick <= tick) {
+            Unlink(entry);
+            entry->next = due;
+            due = entry;
+        }
+        entry = next;
+    }
+
+    uint64_t nowTick = TickAt(now);
+    while (due != NULL) {
+        Entry *entry = due;
+        due = entry->next;
+
+        Position position;
+        entry->trajectory->Evaluate(now - entry->startMilliseconds, position);
+        m_stats.evaluated++;
+
+        double dx = position.x - entry->lastSent.x;
+        double dy = position.y - entry->lastSent.y;
+        double dz = position.z - entry->lastSent.z;
+        if (entry->hasLastSent && dx * dx + dy * dy + dz * dz < m_epsilon * m_epsilon) {
+            m_stats.suppressed++;
+        } else {
+            Update update;
+            update.sessionHandle = entry->sessionHandle;
+            update.position = position;
+            updates.push_back(update);
+            entry->lastSent = position;
+            entry->hasLastSent = true;
+            m_stats.sent++;
+        }
+
+        // Keep the phase; if we fell behind, skip the missed updates instead of bursting them
+        entry->dueTick += entry->periodTicks;
+        if (entry->dueTick <= nowTick) {
+            entry->dueTick = nowTick + entry->periodTicks;
+        }
+        Link(entry);
+    }
+}
+
+// m_lock must be held. Returns -1 when nothing is scheduled.
+int PositionScheduler::MillisecondsToNextDue(double now) const
+{
+    if (m_entries.empty()) {
+        return -1;
+    }
+    uint64_t nextTick = m_currentTick + c_nWheelSlots;
+    for (uint64_t k = 0; k < c_nWheelSlots; ++k) {
+        uint64_t tick = m_currentTick + k;
+        for (const Entry *entry = m_wheel[tick % c_nWheelSlots]; entry != NULL; entry = entry->next) {
+            if (entry->dueTick <= tick) {
+                nextTick = tick;
+                break;
+            }
+        }
+        if (nextTick != m_currentTick + c_nWheelSlots) {
+            break;
+        }
+    }
+    double delay = m_baseMilliseconds + (double)nextTick * m_tickMilliseconds - now;
+    if (delay <= 0) {
+        return 0;
+    }
+    return (int)ceil(delay);
+}
+
+void PositionScheduler::OnTimer()
+{
+    std::vector<Update> updates;
+    m_lock.Take();
+    m_timer = 0;
+    if (!m_stopping) {
+        m_inTimer = true;
+        double now = get_millisecond_tick_counter();
+        uint64_t nowTick = TickAt(now);
+        m_stats.wakeups++;
+
+        if (nowTick >= m_currentTick) {
+            // One revolution visits every slot, which is enough to catch up after a long stall
+            if (nowTick - m_currentTick >= c_nWheelSlots) {
+                m_currentTick = nowTick - c_nWheelSlots + 1;
+            }
+            for (; m_currentTick <= nowTick; ++m_currentTick) {
+                RunTick(m_currentTick, now, updates);
+                m_stats.ticks++;
+            }
+        }
+
+        if (!updates.empty() && m_sink) {
+            // All updates due in this wakeup go out as one batch
+            Sink sink = m_sink;
+            m_stats.batches++;
+            m_lock.Release();
+            sink(updates);
+            m_lock.Take();
+        }
+        m_inTimer = false;
+    }
+    if (m_stopping) {
+        // Under the lock: Stop() may return, and the scheduler go, as soon as it is released
+        set_event(m_idleEvent);
+    } else {
+        Arm();
+    }
+    m_lock.Release();
+}
@@ -0,0 +1,159 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "vxplatform/vxcplatform.h"
+
+// Drives the positional updates of every session from one timer of a vxplatform::TimerQueue,
+// replacing a thread per dancing session. Sessions are kept in a hashed timer wheel with a
+// fixed tick; all sessions due on the same tick are evaluated together and handed to the sink
+// as one batch. The timer is armed for the next tick a session is due, so an idle scheduler
+// costs nothing. An update is suppressed when the position moved less than the epsilon since
+// the last one sent for that session.
+//
+// The sink is called on a thread of the queue without any scheduler lock held, so it may take
+// application locks. Its calls never overlap. Schedule() and Cancel() never wait for the sink.
+class PositionScheduler
+{
+public:
+    struct Position {
+        double x, y, z;
+    };
+
+    class Trajectory
+    {
+    public:
+        virtual ~Trajectory() {}
+        // t is the time in milliseconds since the session was scheduled
+        virtual void Evaluate(double t, Position &position) const = 0;
+    };
+
+    // Rotation around a center with the radius oscillating between rmin and rmax.
+    // This is the movement the 'dance' command has always used.
+    class OrbitTrajectory : public Trajectory
+    {
+    public:
+        OrbitTrajectory(const Position &center, double rmin, double rmax, double angularVelocityDegPerSec, double oscillationPeriodSeconds);
+        void Evaluate(double t, Position &position) const override;
+
+    private:
+        Position m_center;
+        double m_r0;
+        double m_amp;
+        double m_angularVelocityDegPerSec;
+        double m_oscillationPeriodSeconds;
+    };
+
+    // Back and forth between two points at a constant speed in units per second.
+    class LineTrajectory : public Trajectory
+    {
+    public:
+        LineTrajectory(const Position &from, const Position &to, double speed);
+        void Evaluate(double t, Position &position) const override;
+
+    private:
+        Position m_from;
+        Position m_to;
+        double m_length;
+        double m_speed;
+    };
+
+    struct Update {
+        std::string sessionHandle;
+        Position position;
+    };
+    typedef std::function<void (const std::vector<Update> &updates)> Sink;
+
+    struct Stats {
+        uint64_t wakeups;
+        uint64_t ticks;
+        uint64_t evaluated;
+        uint64_t sent;
+        uint64_t suppressed;
+        uint64_t batches;
+    };
+
+    // The queue must outlive the scheduler
+    explicit PositionScheduler(vxplatform::TimerQueue *pTimerQueue, unsigned int tickMilliseconds = 10);
+    ~PositionScheduler();
+
+    void SetSink(const Sink &sink);
+    void SetEpsilon(double epsilon);
+    double GetEpsilon() const;
+
+    // (Re)schedules a session, replacing its previous trajectory if any
+    void Schedule(const std::string &sessionHandle, const std::shared_ptr<Trajectory> &trajectory, unsigned int periodMilliseconds);
+    bool Cancel(const std::string &sessionHandle);
+    void CancelAll();
+    bool IsScheduled(const std::string &sessionHandle) const;
+    size_t GetScheduledCount() const;
+
+    void GetStats(Stats &stats) const;
+    void ResetStats();
+
+    // Cancels the timer and waits for a sink call under way. The timer is armed again by the
+    // next Schedule() call. Must not be called from the sink or while holding a lock the sink takes.
+    void Stop();
+
+private:
+    PositionScheduler(const PositionScheduler &); // disabled
+
+    struct Entry {
+        std::string sessionHandle;
+        std::shared_ptr<Trajectory> trajectory;
+        double startMilliseconds;
+        uint64_t dueTick;
+        uint64_t periodTicks;
+        bool hasLastSent;
+        Position lastSent;
+        Entry *prev;
+        Entry *next;
+    };
+
+    static const size_t c_nWheelSlots = 256;
+
+    static void OnTimer(void *arg);
+    void OnTimer();
+    void Arm();
+    uint64_t TickAt(double milliseconds) const;
+    void Link(Entry *entry);
+    void Unlink(Entry *entry);
+    void RunTick(uint64_t tick, double now, std::vector<Update> &updates);
+    int MillisecondsToNextDue(double now) const;
+
+    const unsigned int m_tickMilliseconds;
+    double m_baseMilliseconds;
+    uint64_t m_currentTick;
+    double m_epsilon;
+
+    mutable vxplatform::Lock m_lock;
+    Entry *m_wheel[c_nWheelSlots];
+    std::map<std::string, Entry *> m_entries;
+    Sink m_sink;
+    Stats m_stats;
+
+    vxplatform::TimerQueue *m_pTimerQueue;
+    vxplatform::timer_id_t m_timer;     // armed or fired, until OnTimer() runs; 0 if none
+    double m_timerDueMilliseconds;
+    bool m_inTimer;
+    bool m_stopping;
+    vxplatform::os_event_handle m_idleEvent;     // set by OnTimer() when done while stopping
+};
@@ -49,6 +49,27 @@ SDKBrowser::SDKSessionGroup *SDKBrowser::InternalAddSessionGroup(SDKLogin *pLogi
     return pSessionGroup;
 }
 
+SDKMessageInterest SDKBrowser::GetMessageInterest()
+{
+    SDKMessageInterest interest;
+    interest.Add(resp_connector_create)
+        .Add(resp_account_anonymous_login)
+        .Add(resp_account_logout)
+        .Add(resp_connector_initiate_shutdown)
+        .Add(resp_sessiongroup_add_session)
+        .Add(evt_account_login_state_change)
+        .Add(evt_sessiongroup_added)
+        .Add(evt_sessiongroup_removed)
+        .Add(evt_session_added)
+        .Add(evt_session_removed)
+        .Add(evt_participant_added)
+        .Add(evt_participant_removed)
+        .Add(evt_participant_updated)
+        .Add(evt_media_stream_updated)
+        .Add(evt_text_stream_updated);
+    return interest;
+}
+
 void SDKBrowser::OnVivoxSDKMessage(vx_message_base_t *msg)
 {
     if (msg->type == msg_response) {
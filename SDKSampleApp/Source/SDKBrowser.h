@@ -30,6 +30,8 @@ public:
 
 public:
     virtual void OnVivoxSDKMessage(vx_message_base_t *msg);
+    // The responses and events OnVivoxSDKMessage() handles
+    static SDKMessageInterest GetMessageInterest();
 
     // Overrides
     class SDKConnector;
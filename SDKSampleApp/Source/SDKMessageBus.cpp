@@ -0,0 +1,218 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "SDKMessageBus.h"
+
+static thread_local bool t_publishing = false;
+
+SDKMessageBus::SDKMessageBus() :
+    m_nextId(1),
+    m_routes(std::make_shared<Routes>()),
+    m_publishing(0)
+{
+}
+
+SDKMessageBus::~SDKMessageBus()
+{
+    RoutesPtr routes = GetRoutes();
+    std::vector<SubscriberPtr> subscribers = routes->all;
+    for (std::vector<SubscriberPtr>::const_iterator i = subscribers.begin(); i != subscribers.end(); ++i) {
+        Unsubscribe((*i)->id);
+    }
+}
+
+SDKMessageBus::RoutesPtr SDKMessageBus::GetRoutes() const
+{
+    return std::atomic_load(&m_routes);
+}
+
+void SDKMessageBus::Rebuild(const std::vector<SubscriberPtr> &subscribers)
+{
+    std::shared_ptr<Routes> routes = std::make_shared<Routes>();
+    routes->all = subscribers;
+    for (std::vector<SubscriberPtr>::const_iterator i = subscribers.begin(); i != subscribers.end(); ++i) {
+        for (int type = 0; type < resp_max; ++type) {
+            if ((*i)->interest.Has((vx_response_type)type)) {
+                routes->responses[type].push_back(*i);
+            }
+        }
+        for (int type = 0; type < evt_max; ++type) {
+            if ((*i)->interest.Has((vx_event_type)type)) {
+                routes->events[type].push_back(*i);
+            }
+        }
+    }
+    std::atomic_store(&m_routes, RoutesPtr(routes));
+}
+
+SDKMessageBus::SubscriptionId SDKMessageBus::Subscribe(ISDKMessageObserver *observer, const SDKMessageInterest &interest, Delivery delivery, size_t maxQueued, const std::string &name)
+{
+    SubscriberPtr subscriber = std::make_shared<Subscriber>();
+    subscriber->observer = observer;
+    subscriber->interest = interest;
+    subscriber->delivery = delivery;
+    subscriber->name = name;
+    subscriber->maxQueued = maxQueued ? maxQueued : 1;
+    subscriber->delivered = 0;
+    subscriber->dropped = 0;
+    subscriber->peakQueued = 0;
+    subscriber->stopRequested = false;
+
+    std::lock_guard<std::mutex> lock(m_subscribeMutex);
+    subscriber->id = m_nextId++;
+    if (delivery == deliverAsync) {
+        subscriber->thread = std::thread(&SDKMessageBus::DeliveryThread, subscriber.get());
+    }
+    std::vector<SubscriberPtr> subscribers = GetRoutes()->all;
+    subscribers.push_back(subscriber);
+    Rebuild(subscribers);
+    return subscriber->id;
+}
+
+bool SDKMessageBus::Unsubscribe(SubscriptionId id)
+{
+    SubscriberPtr subscriber;
+    {
+        std::lock_guard<std::mutex> lock(m_subscribeMutex);
+        std::vector<SubscriberPtr> subscribers = GetRoutes()->all;
+        for (std::vector<SubscriberPtr>::iterator i = subscribers.begin(); i != subscribers.end(); ++i) {
+            if ((*i)->id == id) {
+                subscriber = *i;
+                subscribers.erase(i);
+                break;
+            }
+        }
+        if (!subscriber) {
+            return false;
+        }
+        Rebuild(subscribers);
+    }
+
+    // A Publish() that loaded the old routes may still be delivering to it
+    if (!t_publishing) {
+        while (m_publishing.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+    }
+    if (subscriber->delivery == deliverAsync) {
+        {
+            std::lock_guard<std::mutex> lock(subscriber->mutex);
+            subscriber->stopRequested = true;
+            subscriber->dropped += subscriber->queue.size();
+            subscriber->queue.clear();
+        }
+        subscriber->condition.notify_one();
+        subscriber->thread.join();
+    }
+    return true;
+}
+
+const std::vector<SDKMessageBus::SubscriberPtr> *SDKMessageBus::Route(const Routes &routes, const vx_message_base_t *msg) const
+{
+    if (msg->type == msg_response) {
+        vx_response_type type = reinterpret_cast<const vx_resp_base_t *>(msg)->type;
+        if (type >= 0 && type < resp_max) {
+            return &routes.responses[type];
+        }
+    } else if (msg->type == msg_event) {
+        vx_event_type type = reinterpret_cast<const vx_evt_base_t *>(msg)->type;
+        if (type >= 0 && type < evt_max) {
+            return &routes.events[type];
+        }
+    }
+    return NULL;
+}
+
+void SDKMessageBus::Deliver(Subscriber &subscriber, const MessagePtr &msg)
+{
+    subscriber.observer->OnVivoxSDKMessage(msg.get());
+    subscriber.delivered.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SDKMessageBus::Publish(const MessagePtr &msg)
+{
+    m_publishing.fetch_add(1, std::memory_order_seq_cst);
+    bool wasPublishing = t_publishing;
+    t_publishing = true;
+    RoutesPtr routes = GetRoutes();
+    const std::vector<SubscriberPtr> *route = Route(*routes, msg.get());
+    if (route != NULL) {
+        for (std::vector<SubscriberPtr>::const_iterator i = route->begin(); i != route->end(); ++i) {
+            Subscriber &subscriber = **i;
+            if (subscriber.delivery == deliverSync) {
+                Deliver(subscriber, msg);
+                continue;
+            }
+            bool queued = false;
+            {
+                std::lock_guard<std::mutex> lock(subscriber.mutex);
+                if (!subscriber.stopRequested && subscriber.queue.size() < subscriber.maxQueued) {
+                    subscriber.queue.push_back(msg);
+                    if (subscriber.queue.size() > subscriber.peakQueued) {
+                        subscriber.peakQueued = subscriber.queue.size();
+                    }
+                    queued = true;
+                }
+            }
+            if (queued) {
+                subscriber.condition.notify_one();
+            } else {
+                subscriber.dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    t_publishing = wasPublishing;
+    m_publishing.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void SDKMessageBus::DeliveryThread(Subscriber *subscriber)
+{
+    std::unique_lock<std::mutex> lock(subscriber->mutex);
+    for (;;) {
+        subscriber->condition.wait(lock, [subscriber] { return subscriber->stopRequested || !subscriber->queue.empty(); });
+        if (subscriber->stopRequested) {
+            break;
+        }
+        MessagePtr msg;
+        msg.swap(subscriber->queue.front());
+        subscriber->queue.pop_front();
+        lock.unlock();
+        Deliver(*subscriber, msg);
+        msg.reset(); // the last reference destroys the message, do it without the lock
+        lock.lock();
+    }
+}
+
+void SDKMessageBus::GetStats(std::vector<SubscriberStats> &stats) const
+{
+    RoutesPtr routes = GetRoutes();
+    stats.clear();
+    for (std::vector<SubscriberPtr>::const_iterator i = routes->all.begin(); i != routes->all.end(); ++i) {
+        Subscriber &subscriber = **i;
+        SubscriberStats s;
+        s.id = subscriber.id;
+        s.name = subscriber.name;
+        s.delivery = subscriber.delivery;
+        s.delivered = subscriber.delivered.load(std::memory_order_relaxed);
+        s.dropped = subscriber.dropped.load(std::memory_order_relaxed);
+        s.maxQueued = subscriber.maxQueued;
+        {
+            std::lock_guard<std::mutex> lock(subscriber.mutex);
+            s.queued = subscriber.queue.size();
+            s.peakQueued = subscriber.peakQueued;
+        }
+        stats.push_back(s);
+    }
+}
@@ -0,0 +1,116 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "SDKMessageObserver.h"
+
+// Hands the responses and events the SDK delivers to any number of observers, each one
+// receiving only the types in its SDKMessageInterest.
+//
+// The routes, one list of subscribers per response and event type, are rebuilt on
+// Subscribe() and Unsubscribe() and replaced as a whole, so Publish() only looks up the
+// list for the type of the message and takes no lock shared with the subscribers.
+//
+// A synchronous subscriber is called on the publishing thread (the SDK listener thread,
+// which does not hold the application lock), as the single message observer used to be. An
+// asynchronous one has its own queue and thread, so a slow consumer does not hold up the
+// listener: the message is kept alive until it is delivered, and when the queue is full
+// newer messages are dropped and counted.
+class SDKMessageBus
+{
+public:
+    typedef std::shared_ptr<vx_message_base_t> MessagePtr;
+    typedef unsigned int SubscriptionId;
+
+    enum Delivery {
+        deliverSync,
+        deliverAsync
+    };
+
+    SDKMessageBus();
+    ~SDKMessageBus();
+
+    // Returns the id to pass to Unsubscribe(), never 0
+    SubscriptionId Subscribe(ISDKMessageObserver *observer, const SDKMessageInterest &interest, Delivery delivery = deliverSync, size_t maxQueued = 4096, const std::string &name = std::string());
+    // Once it returns the observer is not called anymore, except when called from a synchronous
+    // observer, where the message being published may still reach it. Messages still queued for
+    // an asynchronous subscriber are dropped. Must not be called from an asynchronous observer.
+    bool Unsubscribe(SubscriptionId id);
+
+    void Publish(const MessagePtr &msg);
+
+    struct SubscriberStats {
+        SubscriptionId id;
+        std::string name;
+        Delivery delivery;
+        uint64_t delivered;
+        uint64_t dropped;
+        size_t queued;
+        size_t maxQueued;
+        size_t peakQueued;
+    };
+    void GetStats(std::vector<SubscriberStats> &stats) const;
+
+private:
+    SDKMessageBus(const SDKMessageBus &); // disabled
+
+    struct Subscriber {
+        SubscriptionId id;
+        ISDKMessageObserver *observer;
+        SDKMessageInterest interest;
+        Delivery delivery;
+        std::string name;
+        size_t maxQueued;
+
+        std::atomic<uint64_t> delivered;
+        std::atomic<uint64_t> dropped;
+
+        // Asynchronous delivery
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<MessagePtr> queue;
+        size_t peakQueued;
+        bool stopRequested;
+        std::thread thread;
+    };
+    typedef std::shared_ptr<Subscriber> SubscriberPtr;
+
+    struct Routes {
+        std::vector<SubscriberPtr> responses[resp_max];
+        std::vector<SubscriberPtr> events[evt_max];
+        std::vector<SubscriberPtr> all;
+    };
+    typedef std::shared_ptr<const Routes> RoutesPtr;
+
+    static void DeliveryThread(Subscriber *subscriber);
+    static void Deliver(Subscriber &subscriber, const MessagePtr &msg);
+    const std::vector<SubscriberPtr> *Route(const Routes &routes, const vx_message_base_t *msg) const;
+    void Rebuild(const std::vector<SubscriberPtr> &subscribers);
+    RoutesPtr GetRoutes() const;
+
+    std::mutex m_subscribeMutex;        // Subscribe() and Unsubscribe()
+    SubscriptionId m_nextId;
+    RoutesPtr m_routes;                 // accessed with std::atomic_load and std::atomic_store
+    std::atomic<int> m_publishing;      // Publish() calls in progress
+};
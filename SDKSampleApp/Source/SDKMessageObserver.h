@@ -14,9 +14,56 @@
  * SOFTWARE.
  */
 #include "Vxc.h"
+#include <bitset>
 
 class ISDKMessageObserver
 {
 public:
     virtual void OnVivoxSDKMessage(vx_message_base_t *msg) = 0;
 };
+
+// The responses and events an observer wants to receive from SDKMessageBus
+class SDKMessageInterest
+{
+public:
+    SDKMessageInterest() {}
+
+    static SDKMessageInterest All()
+    {
+        SDKMessageInterest interest;
+        interest.m_responses.set();
+        interest.m_events.set();
+        return interest;
+    }
+
+    SDKMessageInterest &Add(vx_response_type type)
+    {
+        if (type >= 0 && type < resp_max) {
+            m_responses.set(type);
+        }
+        return *this;
+    }
+    SDKMessageInterest &Add(vx_event_type type)
+    {
+        if (type >= 0 && type < evt_max) {
+            m_events.set(type);
+        }
+        return *this;
+    }
+
+    bool Has(vx_response_type type) const { return type >= 0 && type < resp_max && m_responses.test(type); }
+    bool Has(vx_event_type type) const { return type >= 0 && type < evt_max && m_events.test(type); }
+    bool Has(const vx_message_base_t *msg) const
+    {
+        if (msg->type == msg_response) {
+            return Has(reinterpret_cast<const vx_resp_base_t *>(msg)->type);
+        } else if (msg->type == msg_event) {
+            return Has(reinterpret_cast<const vx_evt_base_t *>(msg)->type);
+        }
+        return false;
+    }
+
+private:
+    std::bitset<resp_max> m_responses;
+    std::bitset<evt_max> m_events;
+};
@@ -13,6 +13,10 @@
  * SOFTWARE.
  */
 #include "SDKSampleApp.h"
+#include "ParanoidAllocator.h"
+#include "TestUDPFrameCallbacks.h"
+#include "UdpFrameTelemetry.h"
+#include "UdpFrameCapture.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -29,7 +33,9 @@
 #include "VxcErrors.h"
 #include "VxcResponses.h"
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 #define SDK_SAMPLE_APP_PI 3.1415926535897932384626433832795
 
@@ -74,6 +80,7 @@ SDKSampleApp *SDKSampleApp::s_pInstance;
 
 std::string GetSocketErrorString()
 {
+#ifdef _WIN32
     wchar_t wideBuffer[4096];
     char buffer[4096];
     int error = WSAGetLastError();
@@ -83,6 +90,9 @@ std::string GetSocketErrorString()
         snprintf(buffer, sizeof(buffer), "error %d", error);
     }
     return std::string(buffer);
+#else
+    return std::string(strerror(errno));
+#endif
 }
 
 std::string SDKSampleApp::getVersionAndCopyrightText()
@@ -98,14 +108,20 @@ vxplatform::os_event_handle *SDKSampleApp::ListenerEventLink()
     return &listenerEvent;
 }
 
-SDKSampleApp::SDKSampleApp(printf_wrapper_ptr printf_wrapper_proc, pf_exit_callback_t cbExit)
+SDKSampleApp::SDKSampleApp(printf_wrapper_ptr printf_wrapper_proc, pf_exit_callback_t cbExit) :
+    m_loadTarget(this),
+    m_scenarioHost(this),
+    m_replayTarget(this),
+    m_workerPool(2, "SampleApp"),
+    m_timerQueue(&m_workerPool),
+    m_positionScheduler(&m_timerQueue)
 {
     assert(NULL == s_pInstance);
     s_pInstance = this;
-    m_pMessageObserver = NULL;
     _printf_wrapper = printf_wrapper_proc;
     m_cbExit = cbExit;
     m_started = false;
+    m_hasParticipantEffects = false;
     m_listenerThreadTerminatedEvent = NULL;
     m_messageAvailableEvent = NULL;
     m_lock = new vxplatform::Lock();
@@ -130,10 +146,18 @@ SDKSampleApp::SDKSampleApp(printf_wrapper_ptr printf_wrapper_proc, pf_exit_callb
     m_vadNoiseFloor = 576;
     m_vadAuto = 0;
 
+    m_messagesSignalledNanoseconds = 0;
+
+    m_positionScheduler.SetSink([this](const std::vector<PositionScheduler::Update> &updates) { OnScheduledPositions(updates); });
+    m_messageBus.Subscribe(&m_loadGenerator, LoadGenerator::GetMessageInterest(), SDKMessageBus::deliverSync, 0, "load generator");
+    m_messageBus.Subscribe(&m_scenarioEngine, ScenarioEngine::GetMessageInterest(), SDKMessageBus::deliverSync, 0, "scenario engine");
+
     DeclareCommands();
 
+#ifdef _WIN32
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
     m_tcpConsoleClientSocket = INVALID_SOCKET;
     m_tcpConsoleServerSocket = INVALID_SOCKET;
     m_terminateConsoleThread = false;
@@ -145,6 +169,9 @@ SDKSampleApp::SDKSampleApp(printf_wrapper_ptr printf_wrapper_proc, pf_exit_callb
 // static
 SDKSampleApp::printf_wrapper_ptr SDKSampleApp::_printf_wrapper = NULL;
 
+// Set on the listener thread, whose output goes through the console printer
+static thread_local bool t_useConsolePrinter = false;
+
 // static
 int SDKSampleApp::con_print(const char *format, ...)
 {
@@ -154,6 +181,22 @@ int SDKSampleApp::con_print(const char *format, ...)
     int size = vsnprintf(NULL, 0, format, vl) + 1;
     va_end(vl);
 
+    SDKSampleApp *pApp = SDKSampleApp::GetApp();
+    if (t_useConsolePrinter && pApp != NULL && pApp->m_consolePrinter.IsRunning())
+    {
+        std::string s(static_cast<size_t>(size), '\0');
+        va_start(vl, format);
+        int length = vsnprintf(&s[0], s.size(), format, vl);
+        va_end(vl);
+        if (0 > length)
+        {
+            return length;
+        }
+        s.resize(length);
+        pApp->m_consolePrinter.Print(std::move(s));
+        return length;
+    }
+
     va_start(vl, format);
     int retcode = 0;
     if (_printf_wrapper != NULL)
@@ -168,6 +211,7 @@ int SDKSampleApp::con_print(const char *format, ...)
         {
             return retcode;
         }
+#ifdef _WIN32
         size = MultiByteToWideChar(CP_UTF8, 0, str.data(), -1, NULL, 0);
 
         std::vector<wchar_t> tmp(size);
@@ -179,6 +223,10 @@ int SDKSampleApp::con_print(const char *format, ...)
         }
         tmp.resize(size);
         std::wcout << tmp.data() << std::flush;
+#else
+        fputs(str.data(), stdout);
+        fflush(stdout);
+#endif
     }
     va_end(vl);
 
@@ -224,6 +272,7 @@ void SDKSampleApp::Start()
         m_started = true;
         create_event(&m_listenerThreadTerminatedEvent);
         create_event(&m_messageAvailableEvent);
+        m_consolePrinter.Start([](const string &text) { con_print("%s", text.c_str()); });
         create_thread(&SDKSampleApp::ListenerThread, this, &m_listenerThread, &m_listenerThreadId);
         create_thread(&SDKSampleApp::TcpConsoleThreadProcStatic, this, &m_tcpConsoleThread, &m_tcpConsoleThreadId);
     }
@@ -231,11 +280,25 @@ void SDKSampleApp::Start()
 
 void SDKSampleApp::Stop()
 {
-    for (auto i = m_sessions.begin(); i != m_sessions.end(); ++i)
-    {
-        delete i->second;
+    // While the listener still delivers the responses to its leaves and logouts
+    m_loadGenerator.Stop();
+    m_loadGenerator.Wait(15000);
+    // A command it runs may be under way
+    m_scenarioEngine.Stop();
+    m_scenarioEngine.Wait(15000);
+    m_messageReplayer.Stop();
+    m_messageReplayer.Wait(15000);
+    m_messageLog.Close();
+    m_positionScheduler.Stop();
+    m_positionScheduler.CancelAll();
+    {
+        lock_guard<mutex> lock(m_sessionStateMutex);
+        for (auto i = m_sessions.begin(); i != m_sessions.end(); ++i)
+        {
+            delete i->second;
+        }
+        m_sessions.clear();
     }
-    m_sessions.clear();
 
     if (m_started)
     {
@@ -250,8 +313,11 @@ void SDKSampleApp::Stop()
         delete_event(m_listenerThreadTerminatedEvent);
         m_listenerThreadTerminatedEvent = NULL;
         TerminateListenerThread();
+        m_consolePrinter.Stop();
         TerminateTcpConsoleThread();
+#ifdef _WIN32
         WSACleanup();
+#endif
     }
 }
 
@@ -274,6 +340,9 @@ SDKSampleApp::~SDKSampleApp()
 
 void SDKSampleApp::Wakeup()
 {
+    // Only the first notification of a batch counts, the listener clears it when it wakes up
+    unsigned long long expected = 0;
+    m_messagesSignalledNanoseconds.compare_exchange_strong(expected, get_nanosecond_tick_counter());
     set_event(m_messageAvailableEvent);
 }
 
@@ -294,13 +363,27 @@ os_error_t SDKSampleApp::ListenerThread(void *arg)
     return 0;
 }
 
-void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
+void SDKSampleApp::PrintLazily(ConsolePrinter::Formatter &&formatter)
 {
-    if (m_pMessageObserver)
+    if (t_useConsolePrinter && m_consolePrinter.IsRunning())
     {
-        m_pMessageObserver->OnVivoxSDKMessage(msg);
+        m_consolePrinter.Print(std::move(formatter));
+        return;
     }
+    string text;
+    formatter(text);
+    con_print("%s", text.c_str());
+}
 
+//
+// The logging of a message is left to the console printer: the formatter holds a reference
+// to the message, so it is destroyed once both this and the printer are done with it. The
+// verbosity flags are read here, so what is filtered out is never formatted.
+//
+void SDKSampleApp::HandleMessage(const SDKMessageBus::MessagePtr &owner)
+{
+    vx_message_base_t *msg = owner.get();
+    bool logXml = m_logXml;
     if (msg->type == msg_response)
     {
         vx_resp_base_t *resp = reinterpret_cast<vx_resp_base_t *>(msg);
@@ -308,15 +391,18 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
         {
             if (m_logResponses)
             {
-                con_print(
-                    "\r * Response %s returned '%s'(%d)\n",
-                    vx_get_response_type_string(resp->type),
-                    vx_get_error_string(resp->status_code),
-                    resp->status_code);
-                if (m_logXml)
-                {
-                    con_print("\r * %s\n", Xml(resp).c_str());
-                }
+                PrintLazily([this, owner, logXml](string &text) {
+                    vx_resp_base_t *loggedResp = reinterpret_cast<vx_resp_base_t *>(owner.get());
+                    text = string_format(
+                        "\r * Response %s returned '%s'(%d)\n",
+                        vx_get_response_type_string(loggedResp->type),
+                        vx_get_error_string(loggedResp->status_code),
+                        loggedResp->status_code);
+                    if (logXml)
+                    {
+                        text += "\r * " + Xml(loggedResp) + "\n";
+                    }
+                });
             }
             con_print("[SDKSampleApp]: ");
         }
@@ -324,11 +410,14 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
         {
             if (m_logResponses)
             {
-                con_print("\r * Request %s with cookie=%s completed.\n", vx_get_request_type_string(resp->request->type), resp->request->cookie);
-                if (m_logXml)
-                {
-                    con_print("\r * %s\n", Xml(resp).c_str());
-                }
+                PrintLazily([this, owner, logXml](string &text) {
+                    vx_resp_base_t *loggedResp = reinterpret_cast<vx_resp_base_t *>(owner.get());
+                    text = string_format("\r * Request %s with cookie=%s completed.\n", vx_get_request_type_string(loggedResp->request->type), loggedResp->request->cookie);
+                    if (logXml)
+                    {
+                        text += "\r * " + Xml(loggedResp) + "\n";
+                    }
+                });
                 con_print("\n%s\n", "Cummunication Termination!");
                 vxplatform::set_event(listenerEvent);
 
@@ -339,6 +428,7 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
             case resp_connector_create:
             {
                 vx_resp_connector_create_t *tresp = (vx_resp_connector_create_t *)resp;
+                lock_guard<mutex> lock(m_sessionStateMutex);
                 m_connectorHandle = tresp->connector_handle;
                 break;
             }
@@ -365,6 +455,7 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
             {
                 vx_resp_sessiongroup_add_session *tresp = reinterpret_cast<vx_resp_sessiongroup_add_session *>(resp);
                 vx_req_sessiongroup_add_session *req = reinterpret_cast<vx_req_sessiongroup_add_session *>(resp->request);
+                lock_guard<mutex> lock(m_sessionStateMutex);
                 m_sessions.insert(make_pair(tresp->session_handle, new Session(req->uri, tresp->session_handle, req->sessiongroup_handle, req->account_handle)));
                 break;
             }
@@ -704,11 +795,14 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
         vx_evt_base_t *evt = reinterpret_cast<vx_evt_base_t *>(msg);
         if (m_logEvents)
         {
-            con_print("\r * Event %s received\n", vx_get_event_type_string(evt->type));
-            if (m_logXml)
-            {
-                con_print("\r * %s\n", Xml(evt).c_str());
-            }
+            PrintLazily([this, owner, logXml](string &text) {
+                vx_evt_base_t *loggedEvt = reinterpret_cast<vx_evt_base_t *>(owner.get());
+                text = string_format("\r * Event %s received\n", vx_get_event_type_string(loggedEvt->type));
+                if (logXml)
+                {
+                    text += "\r * " + Xml(loggedEvt) + "\n";
+                }
+            });
         }
         switch (evt->type)
         {
@@ -772,24 +866,33 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
 
 #ifndef SAMPLEAPP_DISABLE_TTS
             // Optional: Check if (!tevt->is_current_user) in order to speak only other users' messages!
-            if (m_ttsManagerId != NULL)
+            string sessionHandle = string(tevt->session_handle);
+            bool speak = false;
+            vx_tts_manager_id ttsManagerId;
+            vx_tts_voice_id ttsVoiceID;
             {
-                string sessionHandle = string(tevt->session_handle);
-                if (m_ttsSessionHandles.count(sessionHandle))
+                lock_guard<mutex> lock(m_sessionStateMutex);
+                if (m_ttsManagerId != NULL && m_ttsSessionHandles.count(sessionHandle))
                 {
-                    string username;
-                    if (tevt->participant_displayname != NULL)
-                    {
-                        username = string(tevt->participant_displayname);
-                    }
-                    else
-                    {
-                        username = string("Anonymous");
-                    }
-                    string text = username + " says " + string(tevt->message_body);
-                    vx_tts_utterance_id utteranceID;
-                    vx_tts_speak(*m_ttsManagerId, m_ttsVoiceID, text.c_str(), tts_dest_queued_local_playback, &utteranceID);
+                    speak = true;
+                    ttsManagerId = *m_ttsManagerId;
+                    ttsVoiceID = m_ttsVoiceID;
+                }
+            }
+            if (speak)
+            {
+                string username;
+                if (tevt->participant_displayname != NULL)
+                {
+                    username = string(tevt->participant_displayname);
+                }
+                else
+                {
+                    username = string("Anonymous");
                 }
+                string text = username + " says " + string(tevt->message_body);
+                vx_tts_utterance_id utteranceID;
+                vx_tts_speak(ttsManagerId, ttsVoiceID, text.c_str(), tts_dest_queued_local_playback, &utteranceID);
             }
 #endif
             break;
@@ -837,6 +940,7 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
         {
             vx_evt_session_added *evt_s_added = (vx_evt_session_added *)evt;
             con_print("\r * %s: %s [%s]\n", vx_get_event_type_string(evt->type), evt_s_added->session_handle, evt_s_added->sessiongroup_handle);
+            lock_guard<mutex> lock(m_sessionStateMutex);
             m_SSGHandles.insert(m_SSGHandles.begin(), SSGPair(evt_s_added->sessiongroup_handle, evt_s_added->session_handle));
             // DOOMan: don't know the channel URI here, therefore can't add anything to m_sessions, will add in resp_sessiongroup_add_session handler
             break;
@@ -845,18 +949,27 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
         {
             vx_evt_session_removed *evt_sr = (vx_evt_session_removed *)evt;
             con_print("\r * %s: %s [%s]\n", vx_get_event_type_string(evt->type), evt_sr->session_handle, evt_sr->sessiongroup_handle);
-            auto itr = std::find_if(m_SSGHandles.begin(), m_SSGHandles.end(), [&](const SSGPair &element)
-                                    { return element.second == evt_sr->session_handle; });
-            if (itr != m_SSGHandles.end())
+            Session *session = NULL;
             {
-                m_SSGHandles.erase(itr);
-            }
+                lock_guard<mutex> lock(m_sessionStateMutex);
+                auto itr = std::find_if(m_SSGHandles.begin(), m_SSGHandles.end(), [&](const SSGPair &element)
+                                        { return element.second == evt_sr->session_handle; });
+                if (itr != m_SSGHandles.end())
+                {
+                    m_SSGHandles.erase(itr);
+                }
 
-            auto i = m_sessions.find(evt_sr->session_handle);
-            if (i != m_sessions.end())
+                auto i = m_sessions.find(evt_sr->session_handle);
+                if (i != m_sessions.end())
+                {
+                    session = i->second;
+                    m_sessions.erase(i);
+                }
+            }
+            if (session != NULL)
             {
-                delete i->second;
-                m_sessions.erase(i);
+                m_positionScheduler.Cancel(evt_sr->session_handle);
+                delete session;
             }
 
             break;
@@ -865,6 +978,7 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
         {
             vx_evt_participant_added *tevt = (vx_evt_participant_added *)evt;
             con_print("\r * %s: %s %s displayname=\"%s\"\n", vx_get_event_type_string(evt->type), tevt->session_handle, tevt->participant_uri, tevt->displayname ? tevt->displayname : "");
+            lock_guard<mutex> lock(m_sessionStateMutex);
             auto itr = m_sessions.find(tevt->session_handle);
             if (itr != m_sessions.end())
             {
@@ -876,6 +990,7 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
         {
             vx_evt_participant_removed *tevt = (vx_evt_participant_removed *)evt;
             con_print("\r * %s: %s %s\n", vx_get_event_type_string(evt->type), tevt->session_handle, tevt->participant_uri);
+            lock_guard<mutex> lock(m_sessionStateMutex);
             auto itr = m_sessions.find(tevt->session_handle);
             if (itr != m_sessions.end())
             {
@@ -942,6 +1057,7 @@ void SDKSampleApp::HandleMessage(vx_message_base_t *msg)
                     tevt->is_muted_for_me ? "true" : "false",
                     optionalPrintouts.str().c_str());
             }
+            lock_guard<mutex> lock(m_sessionStateMutex);
             auto itr = m_sessions.find(tevt->session_handle);
             if (itr != m_sessions.end())
             {
@@ -1173,11 +1289,18 @@ void SDKSampleApp::TerminateTcpConsoleThread()
         vxplatform::Locker lock(&m_tcpConsoleThreadLock);
         if (INVALID_SOCKET != m_tcpConsoleServerSocket)
         {
+#ifndef _WIN32
+            // Closing a socket does not wake a thread blocked in accept() or recv() on it here
+            ::shutdown(m_tcpConsoleServerSocket, SHUT_RDWR);
+#endif
             closesocket(m_tcpConsoleServerSocket);
             m_tcpConsoleServerSocket = INVALID_SOCKET;
         }
         if (INVALID_SOCKET != m_tcpConsoleClientSocket)
         {
+#ifndef _WIN32
+            ::shutdown(m_tcpConsoleClientSocket, SHUT_RDWR);
+#endif
             closesocket(m_tcpConsoleClientSocket);
             m_tcpConsoleClientSocket = INVALID_SOCKET;
         }
@@ -1434,7 +1557,11 @@ os_error_t SDKSampleApp::TcpConsoleThreadProc()
                 }
                 else {
                 */
-                if (!ProcessCommand(cmd))
+                // Commands from the console and the TCP client run one at a time
+                Lock();
+                bool keepRunning = ProcessCommand(cmd);
+                Unlock();
+                if (!keepRunning)
                 {
                     vxplatform::Locker lock(&m_tcpConsoleThreadLock);
                     if (m_terminateConsoleThread)
@@ -1476,11 +1603,18 @@ os_error_t SDKSampleApp::TcpConsoleThreadProc()
 // Type of the message, and then type of the Event or Response is discovered, and the
 // appropriate call is made to process that message type.
 //
+// This does not take the application lock, so a long running command does not hold up the
+// messages: the state both sides use has locks of its own, see m_sessionStateMutex. The
+// latency recorded for each message runs from the SDK signalling the batch it came in.
+// What it prints is written by m_consolePrinter, see con_print().
+//
 void SDKSampleApp::ListenerThread()
 {
+    t_useConsolePrinter = true;
     for (; m_started;)
     {
         wait_event(m_messageAvailableEvent, -1);
+        unsigned long long signalled = m_messagesSignalledNanoseconds.exchange(0);
         for (;;)
         {
             vx_message_base_t *msg = NULL;
@@ -1489,10 +1623,16 @@ void SDKSampleApp::ListenerThread()
             {
                 break;
             }
-            Lock();
-            HandleMessage(msg);
-            Unlock();
-            vx_destroy_message(msg);
+            m_messageLog.RecordMessage(msg);
+            // Asynchronous observers may keep the message after this, the last one destroys it
+            SDKMessageBus::MessagePtr owner(msg, &vx_destroy_message);
+            m_messageBus.Publish(owner);
+            HandleMessage(owner);
+            if (signalled != 0)
+            {
+                unsigned long long now = get_nanosecond_tick_counter();
+                m_messageLatency.Record(now > signalled ? (uint64_t)((now - signalled) / 1000) : 0);
+            }
         }
     }
     set_event(m_listenerThreadTerminatedEvent); //응답 수신 THREAD 종료
@@ -1520,6 +1660,7 @@ string SDKSampleApp::IssueRequest(vx_req_base_t *req, bool bSilent)
             con_print("\r * %s\n", Xml(req).c_str());
         }
     }
+    m_messageLog.RecordRequest(req);
     int error = vx_issue_request3(req, &request_count);
     if (error)
     {
@@ -1531,7 +1672,8 @@ string SDKSampleApp::IssueRequest(vx_req_base_t *req, bool bSilent)
 
 unsigned long long SDKSampleApp::GetNextSerialNumber()
 {
-    static unsigned long long serial = 1;
+    // Also called by the load generator thread
+    static std::atomic<unsigned long long> serial(1);
     return serial++;
 }
 
@@ -1578,16 +1720,19 @@ string SDKSampleApp::GetUserUri(const string &nameOrUri)
 
 string SDKSampleApp::DefaultSessionGroupHandle()
 {
+    lock_guard<mutex> lock(m_sessionStateMutex);
     return m_SSGHandles.empty() ? string() : m_SSGHandles.front().first;
 }
 
 string SDKSampleApp::DefaultSessionHandle()
 {
+    lock_guard<mutex> lock(m_sessionStateMutex);
     return m_SSGHandles.empty() ? string() : m_SSGHandles.front().second;
 }
 
 bool SDKSampleApp::CheckExistsSessionGroupHandle(string sessionGroupHandle)
 {
+    lock_guard<mutex> lock(m_sessionStateMutex);
     vector<SSGPair>::const_iterator itr = std::find_if(m_SSGHandles.begin(), m_SSGHandles.end(), [&](const SSGPair &element)
                                                        { return element.first == sessionGroupHandle; });
     return itr != m_SSGHandles.end();
@@ -1595,6 +1740,7 @@ bool SDKSampleApp::CheckExistsSessionGroupHandle(string sessionGroupHandle)
 
 string SDKSampleApp::FindSessionGroupHandleBySessionHandle(string sessionHandle)
 {
+    lock_guard<mutex> lock(m_sessionStateMutex);
     vector<SSGPair>::const_iterator itr = std::find_if(m_SSGHandles.begin(), m_SSGHandles.end(), [&](const SSGPair &element)
                                                        { return element.second == sessionHandle; });
     if (itr == m_SSGHandles.end())
@@ -1607,6 +1753,44 @@ string SDKSampleApp::FindSessionGroupHandleBySessionHandle(string sessionHandle)
     }
 }
 
+string SDKSampleApp::GetConnectorHandle() const
+{
+    lock_guard<mutex> lock(m_sessionStateMutex);
+    return m_connectorHandle;
+}
+
+bool SDKSampleApp::IsSessionKnown(const string &sessionHandle) const
+{
+    lock_guard<mutex> lock(m_sessionStateMutex);
+    return m_sessions.find(sessionHandle) != m_sessions.end();
+}
+
+string SDKSampleApp::GetSessionUri(const string &sessionHandle) const
+{
+    lock_guard<mutex> lock(m_sessionStateMutex);
+    auto i = m_sessions.find(sessionHandle);
+    return i != m_sessions.end() ? i->second->GetUri() : string();
+}
+
+void SDKSampleApp::GetStateSnapshot(StateSnapshot &snapshot) const
+{
+    lock_guard<mutex> stateLock(m_sessionStateMutex);
+    lock_guard<mutex> accountLock(m_accountHandleUserNameMutex);
+    snapshot.connectorHandle = m_connectorHandle;
+    snapshot.accounts.clear();
+    for (auto i = m_accountHandles.begin(); i != m_accountHandles.end(); ++i)
+    {
+        auto userName = m_accountHandleUserNames.find(*i);
+        snapshot.accounts.push_back(make_pair(*i, userName != m_accountHandleUserNames.end() ? userName->second : string()));
+    }
+    snapshot.ssgHandles = m_SSGHandles;
+    snapshot.sessions.clear();
+    for (auto i = m_sessions.begin(); i != m_sessions.end(); ++i)
+    {
+        snapshot.sessions.insert(make_pair(i->first, *i->second));
+    }
+}
+
 void SDKSampleApp::connector_create(const string &server, const string &handle, unsigned int configured_codecs)
 {
     vx_req_connector_create_t *req;
@@ -1987,6 +2171,119 @@ void SDKSampleApp::session_send_message(const string &sessionHandle, const strin
     IssueRequest(&req->base);
 }
 
+string SDKSampleApp::LoadTarget::LoadLogin(const string &userName, const string &accountHandle)
+{
+    vx_req_account_anonymous_login_t *req;
+    vx_req_account_anonymous_login_create(&req);
+    safe_replace_string(&req->access_token, m_app->DebugGetAccessToken("login", string(), userName, string()).c_str());
+    safe_replace_string(&req->account_handle, accountHandle.c_str());
+    safe_replace_string(&req->connector_handle, m_app->GetConnectorHandle().c_str());
+    safe_replace_string(&req->acct_name, userName.c_str());
+    safe_replace_string(&req->displayname, userName.c_str());
+    return m_app->IssueRequest(&req->base, true);
+}
+
+string SDKSampleApp::LoadTarget::LoadLogout(const string &accountHandle)
+{
+    vx_req_account_logout_t *req;
+    vx_req_account_logout_create(&req);
+    safe_replace_string(&req->account_handle, accountHandle.c_str());
+    return m_app->IssueRequest(&req->base, true);
+}
+
+string SDKSampleApp::LoadTarget::LoadJoin(const string &userName, const string &accountHandle, const string &sessionGroupHandle, const string &sessionHandle, const string &channelUri)
+{
+    // By user name, not GetUserUriForAccountHandle(): the login response may still be on its way to HandleMessage()
+    vx_req_sessiongroup_add_session_t *req;
+    vx_req_sessiongroup_add_session_create(&req);
+    safe_replace_string(&req->access_token, m_app->DebugGetAccessToken("join", string(), userName, channelUri).c_str());
+    safe_replace_string(&req->account_handle, accountHandle.c_str());
+    req->connect_audio = 1;
+    req->connect_text = 1;
+    safe_replace_string(&req->sessiongroup_handle, sessionGroupHandle.c_str());
+    safe_replace_string(&req->session_handle, sessionHandle.c_str());
+    safe_replace_string(&req->uri, channelUri.c_str());
+    return m_app->IssueRequest(&req->base, true);
+}
+
+string SDKSampleApp::LoadTarget::LoadLeave(const string &sessionGroupHandle, const string &sessionHandle)
+{
+    vx_req_sessiongroup_remove_session_t *req;
+    vx_req_sessiongroup_remove_session_create(&req);
+    safe_replace_string(&req->session_handle, sessionHandle.c_str());
+    safe_replace_string(&req->sessiongroup_handle, sessionGroupHandle.c_str());
+    return m_app->IssueRequest(&req->base, true);
+}
+
+string SDKSampleApp::LoadTarget::LoadMove(const string &sessionHandle, double x, double y, double z)
+{
+    SampleAppPosition position = {x, y, z};
+    SampleAppOrientation orientation = {0.0, 0.0, -1.0, 0.0, 1.0, 0.0};
+    vx_req_session_set_3d_position *req;
+    vx_req_session_set_3d_position_create(&req);
+    safe_replace_string(&req->session_handle, sessionHandle.c_str());
+    m_app->Set3DPositionRequestFields(req, position, orientation);
+    return m_app->IssueRequest(&req->base, true);
+}
+
+string SDKSampleApp::LoadTarget::LoadMute(const string &accountHandle, bool muted)
+{
+    vx_req_connector_mute_local_mic_t *req;
+    vx_req_connector_mute_local_mic_create(&req);
+    req->mute_level = muted ? 1 : 0;
+    safe_replace_string(&req->account_handle, accountHandle.c_str());
+    return m_app->IssueRequest(&req->base, true);
+}
+
+string SDKSampleApp::LoadTarget::LoadMessage(const string &sessionHandle, const string &text)
+{
+    vx_req_session_send_message_t *req;
+    vx_req_session_send_message_create(&req);
+    safe_replace_string(&req->session_handle, sessionHandle.c_str());
+    safe_replace_string(&req->message_body, text.c_str());
+    return m_app->IssueRequest(&req->base, true);
+}
+
+string SDKSampleApp::LoadTarget::LoadChannelUri(unsigned int index)
+{
+    (void)index;
+    char *tmp = vx_get_random_channel_uri_ex("confctl-g-", m_app->m_realm.c_str(), m_app->m_isMultitenant ? m_app->m_accessTokenIssuer.c_str() : NULL);
+    string uri = tmp;
+    vx_free(tmp);
+    return uri;
+}
+
+void SDKSampleApp::ScenarioHost::RunScenarioCommand(const string &line)
+{
+    con_print("\r * scenario: %s\n", line.c_str());
+    m_app->Lock();
+    m_app->ProcessCommand(splitCmdLine(line));
+    m_app->Unlock();
+}
+
+string SDKSampleApp::ScenarioHost::DescribeScenarioMessage(vx_message_base_t *msg)
+{
+    if (msg->type == msg_response)
+    {
+        return m_app->Xml(reinterpret_cast<vx_resp_base_t *>(msg));
+    }
+    return m_app->Xml(reinterpret_cast<vx_evt_base_t *>(msg));
+}
+
+void SDKSampleApp::ScenarioHost::PrintScenario(const string &text)
+{
+    con_print("%s", text.c_str());
+}
+
+void SDKSampleApp::ReplayTarget::ReplayMessage(vx_message_base_t *msg)
+{
+    // Printed like the listener thread's messages
+    t_useConsolePrinter = true;
+    SDKMessageBus::MessagePtr owner(msg, &MessageLogDestroyMessage);
+    m_app->m_messageBus.Publish(owner);
+    m_app->HandleMessage(owner);
+}
+
 void SDKSampleApp::account_send_message(const string &accountHandle, const string &message, const string &user, const string &customMetadataNS, const string &customMetadata)
 {
     vx_req_account_send_message_t *req;
@@ -2374,10 +2671,13 @@ void SDKSampleApp::session_transcription_control(const string &sessionHandle, co
     req->enable = enable ? 1 : 0;
 
     string accountHandle;
-    auto it = m_sessions.find(sessionHandle);
-    if (it != m_sessions.end())
     {
-        accountHandle = it->second->GetAccountHandle();
+        lock_guard<mutex> lock(m_sessionStateMutex);
+        auto it = m_sessions.find(sessionHandle);
+        if (it != m_sessions.end())
+        {
+            accountHandle = it->second->GetAccountHandle();
+        }
     }
     safe_replace_string(&req->access_token, DebugGetAccessToken("trxn", string(), GetUserUriForAccountHandle(accountHandle), channel).c_str());
     IssueRequest(&req->base);
@@ -2600,172 +2900,30 @@ void SDKSampleApp::req_turn_right(const string &sessionHandle, double delta)
     IssueRequest(&req->base);
 }
 
-SDKSampleApp::Session::Dancer::Dancer()
-{
-    m_x0 = 0;
-    m_y0 = 0;
-    m_z0 = 0;
-    m_rmin = 0;
-    m_rmax = 0;
-    m_angularVelocityDegPerSec = 0;
-    m_oscillationPeriodSeconds = 0;
-    m_updateMilliseconds = 0;
-    m_dancerThread = NULL;
-    m_dancerThreadTerminatedEvent = NULL;
-    m_lock = new vxplatform::Lock();
-    m_threadRunning = false;
-    m_dancerThreadStartedEvent = NULL;
-    m_dancerThreadTerminatedEvent = NULL;
-    m_dancerThreadStopEvent = NULL;
-}
-
-SDKSampleApp::Session::Dancer::~Dancer()
-{
-    Stop();
-    delete m_lock;
-    m_lock = NULL;
-}
-
-void SDKSampleApp::Session::Dancer::Start(
-    const string &sessionHandle,
-    double x0,
-    double y0,
-    double z0,
-    double rmin,
-    double rmax,
-    double angularVelocityDegPerSec,
-    double oscillationPeriodSeconds,
-    int updateMilliseconds)
+// Called on a thread of m_workerPool with every session due on the same tick
+void SDKSampleApp::OnScheduledPositions(const std::vector<PositionScheduler::Update> &updates)
 {
-    Stop();
-    m_sessionHandle = sessionHandle;
-    m_x0 = x0;
-    m_y0 = y0;
-    m_z0 = z0;
-    m_rmin = rmin;
-    m_rmax = rmax;
-    m_angularVelocityDegPerSec = angularVelocityDegPerSec;
-    m_oscillationPeriodSeconds = oscillationPeriodSeconds;
-    m_updateMilliseconds = updateMilliseconds;
-
-    // FIXME: add error handling
-    // ...
-    assert(NULL == m_dancerThreadStartedEvent);
-    assert(NULL == m_dancerThreadTerminatedEvent);
-    assert(NULL == m_dancerThreadStopEvent);
-
-    m_threadRunning = true;
-    create_event(&m_dancerThreadStartedEvent);
-    create_event(&m_dancerThreadTerminatedEvent);
-    create_event(&m_dancerThreadStopEvent);
-    create_thread(&SDKSampleApp::Session::Dancer::DancerThread, this, &m_dancerThread);
-    wait_event(m_dancerThreadStartedEvent);
-}
-
-void SDKSampleApp::Session::Dancer::Stop()
-{
-    if (m_threadRunning)
-    {
-        set_event(m_dancerThreadStopEvent);
-        wait_event(m_dancerThreadTerminatedEvent);
-        assert(!m_threadRunning);
-    }
-    if (m_dancerThread)
-    {
-        delete_thread(m_dancerThread);
-        m_dancerThread = NULL;
-    }
-    if (m_dancerThreadStartedEvent)
-    {
-        delete_event(m_dancerThreadStartedEvent);
-        m_dancerThreadStartedEvent = NULL;
-    }
-    if (m_dancerThreadTerminatedEvent)
-    {
-        delete_event(m_dancerThreadTerminatedEvent);
-        m_dancerThreadTerminatedEvent = NULL;
-    }
-    if (m_dancerThreadStopEvent)
+    for (auto i = updates.begin(); i != updates.end(); ++i)
     {
-        delete_event(m_dancerThreadStopEvent);
-        m_dancerThreadStopEvent = NULL;
-    }
-}
-
-// static
-double SDKSampleApp::Session::Dancer::GetMilliseconds()
-{
-    return get_millisecond_tick_counter();
-}
-
-// static
-vxplatform::os_error_t SDKSampleApp::Session::Dancer::DancerThread(void *arg)
-{
-    Dancer *pThis = reinterpret_cast<SDKSampleApp::Session::Dancer *>(arg);
-    pThis->DancerThread();
-    return 0;
-}
-
-void SDKSampleApp::Session::Dancer::DancerThread()
-{
-    set_event(m_dancerThreadStartedEvent);
-
-    double amp = (m_rmax - m_rmin) / 2;
-    double r0 = (m_rmax + m_rmin) / 2;
-    double t0 = GetMilliseconds();
-    double t = 0;
-
-    // SDKSampleApp::GetApp()->req_move_origin(m_sessionHandle);
+        if (!IsSessionKnown(i->sessionHandle))
+        {
+            // the session went away while the batch was being evaluated
+            m_positionScheduler.Cancel(i->sessionHandle);
+            continue;
+        }
 
-    do
-    {
-        t = GetMilliseconds() - t0;
-        // Set 3D position
-        SampleAppPosition listenerPosition;
+        SampleAppPosition listenerPosition = { i->position.x, i->position.y, i->position.z };
         SampleAppOrientation listenerOrientation;
-
-        SDKSampleApp::GetApp()->GetListenerOrientation(m_sessionHandle, listenerOrientation);
-
-        double anglePhi = 2 * SDK_SAMPLE_APP_PI * m_angularVelocityDegPerSec / 360 * t / 1000;
-        double cosOmega = cos(2 * SDK_SAMPLE_APP_PI * t / 1000 / m_oscillationPeriodSeconds);
-
-        listenerPosition.x = m_x0 + (r0 - amp * cosOmega) * sin(anglePhi);
-        listenerPosition.y = m_y0;
-        listenerPosition.z = m_z0 - (r0 - amp * cosOmega) * cos(anglePhi);
+        GetListenerOrientation(i->sessionHandle, listenerOrientation);
 
         vx_req_session_set_3d_position *req;
         vx_req_session_set_3d_position_create(&req);
-        safe_replace_string(&req->session_handle, m_sessionHandle.c_str());
+        safe_replace_string(&req->session_handle, i->sessionHandle.c_str());
         req->req_disposition_type = req_disposition_no_reply_required;
-        SDKSampleApp::GetApp()->Set3DPositionRequestFields(req, listenerPosition, listenerOrientation);
-        SDKSampleApp::GetApp()->SetListenerPosition(m_sessionHandle, listenerPosition);
-        SDKSampleApp::GetApp()->IssueRequest(&req->base, true);
-
-        t = GetMilliseconds() - t0;
-        double tEnd = (floor(t / m_updateMilliseconds) + 1) * m_updateMilliseconds;
-        int delay = (int)(t - tEnd);
-        if (delay <= 0)
-        {
-            delay = m_updateMilliseconds;
-        }
-        if (0 == wait_event(m_dancerThreadStopEvent, delay))
-        {
-            // Need to stop dancing
-            break;
-        }
-    } while (true);
-
-    m_threadRunning = false;
-    set_event(m_dancerThreadTerminatedEvent);
-}
-
-ISDKMessageObserver *SDKSampleApp::SetMessageObserver(ISDKMessageObserver *pObserver)
-{
-    Lock();
-    ISDKMessageObserver *pOldObserver = m_pMessageObserver;
-    m_pMessageObserver = pObserver;
-    Unlock();
-    return pOldObserver;
+        Set3DPositionRequestFields(req, listenerPosition, listenerOrientation);
+        SetListenerPosition(i->sessionHandle, listenerPosition);
+        IssueRequest(&req->base, true);
+    }
 }
 
 void SDKSampleApp::sProcessTremoloEffect(short *pcm_frames, int pcm_frame_count, int audio_frame_rate, int channels_per_frame, int *time)
@@ -2801,7 +2959,14 @@ void SDKSampleApp::OnBeforeReceivedAudioMixed(const char *session_group_handle,
     for (unsigned int i = 0; i < num_participants; i++)
     {
         auto &data = participants_data[i];
+        m_spatializer.Process(data.participant_uri, data.pcm_frames, data.pcm_frame_count, data.channels_per_frame);
+
+        if (!m_hasParticipantEffects.load(memory_order_acquire))
+        {
+            continue;
+        }
         string participant_uri = data.participant_uri;
+        lock_guard<mutex> lock(m_participantsEffectMutex);
         auto iter = m_participantsEffectTimes.find(participant_uri);
         if (iter == m_participantsEffectTimes.end())
         {
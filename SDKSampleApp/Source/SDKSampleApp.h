@@ -20,6 +20,7 @@
 #include <memory>
 #include <map>
 #include <list>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <set>
@@ -36,16 +37,36 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-#include "SDKMessageObserver.h"
+#include "SDKMessageBus.h"
+#include "Spatializer.h"
+#include "PositionScheduler.h"
+#include "LatencyHistogram.h"
+#include "ConsolePrinter.h"
+#include "LoadGenerator.h"
+#include "ScenarioEngine.h"
+#include "MessageReplayer.h"
 
 // End developers shouldn't set this value. This is only to be used by the SDKSampleApp.
 // Please contact your Vivox representative for more information.
 #define THIS_APP_UNIQUE_3_LETTERS_USER_AGENT_ID_STRING "VSA"
 
+#ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #undef socket_t
 #define socket_t SOCKET
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+#define socket_t int
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define closesocket close
+#endif
 
 #define socketclose close
 #define GetHostName gethostname
@@ -168,6 +189,7 @@ public:
     // sample application only methods for command processing
     void connect(const vector<string> &cmd);
     void participanteffect(const vector<string> &cmd);
+    void spatialize(const vector<string> &cmd);
     void capturedevice(const vector<string> &cmd);
     void crash(const vector<string> &cmd);
     void renderdevice(const vector<string> &cmd);
@@ -176,6 +198,18 @@ public:
     void removesession(const vector<string> &cmd);
     void move(const vector<string> &cmd);
     void dance(const vector<string> &cmd);
+    void dancebench(const vector<string> &cmd);
+    void allocbench(const vector<string> &cmd);
+    void allocprofile(const vector<string> &cmd);
+    void heapscan(const vector<string> &cmd);
+    void udpframebench(const vector<string> &cmd);
+    void udpstats(const vector<string> &cmd);
+    void udpcapture(const vector<string> &cmd);
+    void msgbus(const vector<string> &cmd);
+    void listenerstats(const vector<string> &cmd);
+    void loadgen(const vector<string> &cmd);
+    void scenario(const vector<string> &cmd);
+    void msglog(const vector<string> &cmd);
     void focus(const vector<string> &cmd);
     void inject(const vector<string> &cmd);
     void transmit(const vector<string> &cmd);
@@ -231,15 +265,26 @@ public:
 
     static std::vector<std::string> splitCmdLine(const std::string &s);
 
-    ISDKMessageObserver *SetMessageObserver(ISDKMessageObserver *pObserver);
+    // Observers of the SDK responses and events, see SDKMessageBus
+    SDKMessageBus &GetMessageBus() { return m_messageBus; }
+
+    // Whether a connector handle was received, for running without a console
+    bool IsConnected() const { return !GetConnectorHandle().empty(); }
+    ScenarioEngine &GetScenarioEngine() { return m_scenarioEngine; }
 
+    // Written by the participanteffect command, read on the audio thread; guarded by
+    // m_participantsEffectMutex. m_hasParticipantEffects lets the audio thread skip the lock
+    // while no effect is on.
     map<string, int> m_participantsEffectTimes;
+    mutex m_participantsEffectMutex;
+    atomic<bool> m_hasParticipantEffects;
     static void sProcessTremoloEffect(short *pcm_frames, int pcm_frame_count, int audio_frame_rate, int channels_per_frame, int *time);
+    Spatializer m_spatializer;
 
     // callbacks
     void OnBeforeReceivedAudioMixed(const char *session_group_handle, const char *initial_target_uri, vx_before_recv_audio_mixed_participant_data_t *participants_data, size_t num_participants);
 
-    vxplatform::os_event_handle *SDKSampleApp::ListenerEventLink();
+    vxplatform::os_event_handle *ListenerEventLink();
 
 private:
     static SDKSampleApp *s_pInstance;
@@ -376,12 +421,15 @@ private:
     void GetListenerHeadingDegrees(const std::string session_handle, double &heading);
     void SetListenerHeadingDegrees(const std::string session_handle, double heading);
     void Set3DPositionRequestFields(vx_req_session_set_3d_position *req, SampleAppPosition &position, SampleAppOrientation &orientation);
+    void UpdateSpatializerListener(const std::string session_handle);
 
 private:
     vxplatform::Lock *m_lock;
     static vxplatform::os_error_t ListenerThread(void *arg); // For catching Reponses and Events
     void ListenerThread();
-    void HandleMessage(vx_message_base_t *msg);
+    void HandleMessage(const SDKMessageBus::MessagePtr &owner);
+    // Calls the formatter now, or on the console printer thread when called on the listener thread
+    void PrintLazily(ConsolePrinter::Formatter &&formatter);
     unsigned long long GetNextSerialNumber();
     void SetRenderDeviceIndexByAccountHandle(const std::string &accountHandle, int deviceIndex);
     void SetCaptureDeviceIndexByAccountHandle(const std::string &accountHandle, int deviceIndex);
@@ -392,9 +440,16 @@ private:
     vxplatform::os_thread_handle m_listenerThread;
     vxplatform::os_thread_id m_listenerThreadId;
     bool m_started;
-    int m_requestId;
+    std::atomic<int> m_requestId;
 
     // local state management
+    //
+    // The listener thread does not take the application lock, which only keeps commands from running
+    // concurrently. State it shares with the commands has a lock of its own, held briefly and never
+    // while taking another one except in this order: m_sessionStateMutex, m_accountHandleUserNameMutex.
+    // m_sessionStateMutex guards m_connectorHandle, m_SSGHandles, m_sessions, m_ttsSessionHandles and
+    // the writes to m_ttsManagerId and m_ttsVoiceID.
+    mutable mutex m_sessionStateMutex;
     string m_connectorHandle;
     string m_realm;
     string m_server;
@@ -419,19 +474,20 @@ private:
     void InternalLoggedOut(string accountHandle);
 
     // controls sample application log messages
-    bool m_logRequests;
-    bool m_logResponses;
-    bool m_logEvents;
-    bool m_logXml;
-    bool m_logParticipantUpdate;
+    std::atomic<bool> m_logRequests;
+    std::atomic<bool> m_logResponses;
+    std::atomic<bool> m_logEvents;
+    std::atomic<bool> m_logXml;
+    std::atomic<bool> m_logParticipantUpdate;
 
     // vad properties
-    int m_vadHangover;
-    int m_vadSensitivity;
-    int m_vadNoiseFloor;
-    int m_vadAuto;
+    std::atomic<int> m_vadHangover;
+    std::atomic<int> m_vadSensitivity;
+    std::atomic<int> m_vadNoiseFloor;
+    std::atomic<int> m_vadAuto;
 
-    // positional info
+    // positional info, guarded by m_listenerPositionMutex; the getters call each other
+    mutable std::recursive_mutex m_listenerPositionMutex;
     std::map<std::string, double> m_listenerHeadingDegrees; // Listener's heading in degrees (North (Negative Z axis) is 0 deg, East (Positive X axis) is +90 deg etc)
     std::map<std::string, SampleAppPosition> m_listenerPositions;
     std::map<std::string, SampleAppOrientation> m_listenerOrientations;
@@ -448,8 +504,8 @@ private:
     // Exit wrapper
     pf_exit_callback_t m_cbExit;
 
-    // Message observer
-    ISDKMessageObserver *m_pMessageObserver;
+    // Message observers
+    SDKMessageBus m_messageBus;
 
     // sample application only to manage commands
 
@@ -631,21 +687,6 @@ private:
                 itr->second.PrintParticipant(format);
             }
         }
-        bool IsDancing() const { return m_dancer.IsStarted(); }
-        void DanceStart(
-            const string &sessionHandle,
-            double x0,
-            double y0,
-            double z0,
-            double rmin,
-            double rmax,
-            double angularVelocityDegPerSec,
-            double oscillationPeriodSeconds,
-            int updateMilliseconds)
-        {
-            m_dancer.Start(sessionHandle, x0, y0, z0, rmin, rmax, angularVelocityDegPerSec, oscillationPeriodSeconds, updateMilliseconds);
-        }
-        void DanceStop() { m_dancer.Stop(); }
 
     private:
         string m_uri;
@@ -653,60 +694,92 @@ private:
         string m_sessionGroupHandle;
         string m_accountHandle;
         ParticipantMap m_participants;
+    };
 
-        class Dancer
-        {
-        public:
-            Dancer();
-            virtual ~Dancer();
-
-        private:
-            Dancer(const Dancer &) {} // disabled
-
-        public:
-            void Start(
-                const string &sessionHandle,
-                double x0,
-                double y0,
-                double z0,
-                double rmin,
-                double rmax,
-                double angularVelocityDegPerSec,
-                double oscillationPeriodSeconds,
-                int updateMilliseconds);
-            void Stop();
-            bool IsStarted() const
-            {
-                return m_threadRunning;
-            }
+    map<string, Session *> m_sessions;
 
-        private:
-            string m_sessionHandle;
-            double m_x0;
-            double m_y0;
-            double m_z0;
-            double m_rmin;
-            double m_rmax;
-            double m_angularVelocityDegPerSec;
-            double m_oscillationPeriodSeconds;
-            int m_updateMilliseconds;
-
-            static double GetMilliseconds();
-
-            vxplatform::Lock *m_lock;
-            volatile bool m_threadRunning;
-            vxplatform::os_thread_handle m_dancerThread;
-            static vxplatform::os_error_t DancerThread(void *arg); // For updating user's position
-            void DancerThread();
-            vxplatform::os_event_handle m_dancerThreadStartedEvent;
-            vxplatform::os_event_handle m_dancerThreadTerminatedEvent;
-            vxplatform::os_event_handle m_dancerThreadStopEvent;
-        };
-
-        Dancer m_dancer;
+    // A consistent copy of the session state, for commands that only read it
+    struct StateSnapshot {
+        string connectorHandle;
+        vector<pair<string, string> > accounts; // account handle, user name
+        vector<SSGPair> ssgHandles;
+        map<string, Session> sessions;
     };
+    void GetStateSnapshot(StateSnapshot &snapshot) const;
+    string GetConnectorHandle() const;
+    bool IsSessionKnown(const string &sessionHandle) const;
+    string GetSessionUri(const string &sessionHandle) const; // empty if the session is not known
 
-    map<string, Session *> m_sessions;
+    // Time from the SDK signalling messages to the listener thread having handled them, on the
+    // monotonic nanosecond clock
+    std::atomic<unsigned long long> m_messagesSignalledNanoseconds;
+    LatencyHistogram m_messageLatency;
+
+    // Writes what the listener thread prints, so it does not wait for the console
+    ConsolePrinter m_consolePrinter;
+
+    // Issues the requests of 'loadgen', quietly and with the handles the load generator chose
+    class LoadTarget : public ILoadGeneratorTarget
+    {
+    public:
+        explicit LoadTarget(SDKSampleApp *app) : m_app(app) {}
+        std::string LoadLogin(const std::string &userName, const std::string &accountHandle);
+        std::string LoadLogout(const std::string &accountHandle);
+        std::string LoadJoin(const std::string &userName, const std::string &accountHandle, const std::string &sessionGroupHandle, const std::string &sessionHandle, const std::string &channelUri);
+        std::string LoadLeave(const std::string &sessionGroupHandle, const std::string &sessionHandle);
+        std::string LoadMove(const std::string &sessionHandle, double x, double y, double z);
+        std::string LoadMute(const std::string &accountHandle, bool muted);
+        std::string LoadMessage(const std::string &sessionHandle, const std::string &text);
+        std::string LoadChannelUri(unsigned int index);
+
+    private:
+        SDKSampleApp *m_app;
+    };
+    LoadTarget m_loadTarget;
+    LoadGenerator m_loadGenerator;
+    void PrintLoadReport();
+
+    // Runs the commands of 'scenario' as if typed at the console
+    class ScenarioHost : public IScenarioHost
+    {
+    public:
+        explicit ScenarioHost(SDKSampleApp *app) : m_app(app) {}
+        void RunScenarioCommand(const std::string &line);
+        std::string DescribeScenarioMessage(vx_message_base_t *msg);
+        void PrintScenario(const std::string &text);
+
+    private:
+        SDKSampleApp *m_app;
+    };
+    ScenarioHost m_scenarioHost;
+    ScenarioEngine m_scenarioEngine;
+    void PrintScenarioReport();
+
+    // Requests issued and messages received, while 'msglog -record' is on
+    MessageLogWriter m_messageLog;
+
+    // Hands the messages of 'msglog -replay' to the observers and HandleMessage(), as the
+    // listener thread does
+    class ReplayTarget : public IMessageReplayTarget
+    {
+    public:
+        explicit ReplayTarget(SDKSampleApp *app) : m_app(app) {}
+        void ReplayMessage(vx_message_base_t *msg);
+
+    private:
+        SDKSampleApp *m_app;
+    };
+    ReplayTarget m_replayTarget;
+    MessageReplayer m_messageReplayer;
+    void PrintReplayReport();
+
+    // The threads the periodic work of the application shares
+    vxplatform::WorkerPool m_workerPool;
+    vxplatform::TimerQueue m_timerQueue;
+
+    // drives 'dance' for all sessions from one timer
+    PositionScheduler m_positionScheduler;
+    void OnScheduledPositions(const std::vector<PositionScheduler::Update> &updates);
 
     void TerminateListenerThread();
 
@@ -0,0 +1,608 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "ScenarioEngine.h"
+#include "VxcErrors.h"
+#include "VxcEvents.h"
+#include "VxcResponses.h"
+#include <chrono>
+#include <sstream>
+#include <stdlib.h>
+
+// Messages kept for waits that have not looked at them yet
+static const size_t c_maxMessages = 4096;
+static const double c_defaultWaitMilliseconds = 30000;
+
+static std::string Trim(const std::string &s)
+{
+    size_t first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    size_t last = s.find_last_not_of(" \t\r\n");
+    return s.substr(first, last - first + 1);
+}
+
+// Splits off the first word of 'rest'
+static std::string NextWord(std::string &rest)
+{
+    rest = Trim(rest);
+    size_t end = rest.find_first_of(" \t");
+    std::string word = rest.substr(0, end);
+    rest = end == std::string::npos ? std::string() : Trim(rest.substr(end));
+    return word;
+}
+
+static bool IsNameCharacter(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+ScenarioEngine::ScenarioEngine() :
+    m_host(NULL),
+    m_hasFilters(false),
+    m_startMilliseconds(0),
+    m_endMilliseconds(0),
+    m_nextSerial(0),
+    m_stopRequested(false),
+    m_running(false)
+{
+}
+
+ScenarioEngine::~ScenarioEngine()
+{
+    Stop();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+double ScenarioEngine::NowMilliseconds() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool ScenarioEngine::ParseSeconds(const std::string &value, double &milliseconds)
+{
+    const char *begin = value.c_str();
+    char *end = NULL;
+    double number = strtod(begin, &end);
+    if (end == begin || number < 0) {
+        return false;
+    }
+    std::string unit(end);
+    if (unit == "ms") {
+        milliseconds = number;
+    } else if (unit.empty() || unit == "s") {
+        milliseconds = number * 1000;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string ScenarioEngine::StripTypePrefix(const std::string &type, bool &response)
+{
+    response = false;
+    if (type.compare(0, 5, "resp_") == 0) {
+        response = true;
+        return type.substr(5);
+    }
+    if (type.compare(0, 4, "evt_") == 0) {
+        return type.substr(4);
+    }
+    return type;
+}
+
+bool ScenarioEngine::IsKnownType(const std::string &type, bool response)
+{
+    bool ignored;
+    if (response) {
+        for (int t = 0; t < resp_max; ++t) {
+            const char *name = vx_get_response_type_string((vx_response_type)t);
+            if (name != NULL && StripTypePrefix(name, ignored) == type) {
+                return true;
+            }
+        }
+    } else {
+        for (int t = 0; t < evt_max; ++t) {
+            const char *name = vx_get_event_type_string((vx_event_type)t);
+            if (name != NULL && StripTypePrefix(name, ignored) == type) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::string ScenarioEngine::Substitute(const std::string &text, const Track *track, bool &ok) const
+{
+    std::string result;
+    ok = true;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '$' || i + 1 == text.size()) {
+            result += text[i];
+            continue;
+        }
+        if (text[i + 1] == '$') {
+            result += '$';
+            ++i;
+            continue;
+        }
+        std::string name;
+        size_t end;
+        if (text[i + 1] == '{') {
+            end = text.find('}', i + 2);
+            if (end == std::string::npos) {
+                ok = false;
+                return text;
+            }
+            name = text.substr(i + 2, end - i - 2);
+        } else {
+            end = i + 1;
+            while (end < text.size() && IsNameCharacter(text[end])) {
+                ++end;
+            }
+            if (end == i + 1) {
+                result += '$';
+                continue;
+            }
+            name = text.substr(i + 1, end - i - 1);
+            --end;
+        }
+
+        bool found = false;
+        if (track != NULL) {
+            for (size_t f = track->frames.size(); f-- > 0 && !found;) {
+                const Frame &frame = track->frames[f];
+                if (frame.repeat != NULL && frame.repeat->variable == name) {
+                    std::stringstream ss;
+                    ss << frame.iteration;
+                    result += ss.str();
+                    found = true;
+                }
+            }
+            if (!found && name == "track") {
+                result += track->name;
+                found = true;
+            }
+        }
+        if (!found) {
+            Variables::const_iterator variable = m_variables.find(name);
+            if (variable == m_variables.end()) {
+                ok = false;
+                return name; // for the error message
+            }
+            result += variable->second;
+        }
+        i = end;
+    }
+    return result;
+}
+
+bool ScenarioEngine::Parse(std::istream &in, const std::string &name, const Variables &variables, std::string &error)
+{
+    m_variables = variables;
+    m_tracks.clear();
+    m_hasFilters = false;
+
+    // The blocks open at the current line, innermost last: a track, then its repeats
+    std::vector<std::vector<Step> *> blocks;
+    int mainTrack = -1;
+    int lineNumber = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::stringstream where;
+        where << name << ":" << lineNumber << ": ";
+        line = Trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::string rest = line;
+        std::string keyword = NextWord(rest);
+
+        if (keyword == "set") {
+            std::string variable = NextWord(rest);
+            if (variable.empty()) {
+                error = where.str() + "set needs a variable name";
+                return false;
+            }
+            if (variables.find(variable) == variables.end()) {
+                m_variables[variable] = rest;
+            }
+            continue;
+        }
+        if (keyword == "track") {
+            if (!blocks.empty()) {
+                error = where.str() + "track inside a track or repeat";
+                return false;
+            }
+            if (rest.empty() || rest == "main") {
+                error = where.str() + "track needs a name other than main";
+                return false;
+            }
+            for (size_t t = 0; t < m_tracks.size(); ++t) {
+                if (m_tracks[t].name == rest) {
+                    error = where.str() + "there is already a track named " + rest;
+                    return false;
+                }
+            }
+            m_tracks.push_back(Track());
+            m_tracks.back().name = rest;
+            blocks.push_back(&m_tracks.back().steps);
+            continue;
+        }
+        if (keyword == "end") {
+            if (blocks.empty()) {
+                error = where.str() + "end without track or repeat";
+                return false;
+            }
+            blocks.pop_back();
+            continue;
+        }
+
+        if (blocks.empty()) {
+            if (mainTrack < 0) {
+                mainTrack = (int)m_tracks.size();
+                m_tracks.push_back(Track());
+                m_tracks.back().name = "main";
+            }
+            // Lines of main may come between tracks: reopen it for this one
+            blocks.push_back(&m_tracks[mainTrack].steps);
+        }
+        Step step;
+        step.line = lineNumber;
+        step.response = false;
+        step.milliseconds = 0;
+        step.count = 0;
+        bool ok = true;
+
+        if (keyword == "at" || keyword == "after") {
+            std::string value = Substitute(NextWord(rest), NULL, ok);
+            if (!ok || !rest.empty() || !ParseSeconds(value, step.milliseconds)) {
+                error = where.str() + keyword + " needs a time, such as 1.5 or 200ms";
+                return false;
+            }
+            step.kind = keyword == "at" ? Step::stepAt : Step::stepAfter;
+        } else if (keyword == "wait") {
+            step.kind = Step::stepWait;
+            std::string type = NextWord(rest);
+            step.type = StripTypePrefix(type, step.response);
+            if (type.empty() || !IsKnownType(step.type, step.response)) {
+                error = where.str() + "unknown response or event type '" + type + "'";
+                return false;
+            }
+            step.milliseconds = c_defaultWaitMilliseconds;
+            std::string timeout = rest;
+            std::string value = Substitute(NextWord(timeout), NULL, ok);
+            if (ok && !value.empty() && ParseSeconds(value, step.milliseconds)) {
+                rest = timeout;
+            }
+            step.text = rest;
+            if (!step.text.empty()) {
+                m_hasFilters = true;
+            }
+        } else if (keyword == "repeat") {
+            step.kind = Step::stepRepeat;
+            std::string value = Substitute(NextWord(rest), NULL, ok);
+            char *end = NULL;
+            long count = strtol(value.c_str(), &end, 10);
+            if (!ok || value.empty() || *end != '\0' || count < 0) {
+                error = where.str() + "repeat needs a count";
+                return false;
+            }
+            step.count = (unsigned int)count;
+            step.variable = NextWord(rest);
+            if (!rest.empty()) {
+                error = where.str() + "repeat takes a count and a variable name";
+                return false;
+            }
+        } else if (keyword == "sleep" || keyword == "sleepms" || keyword == "file" || keyword == "pause") {
+            error = where.str() + keyword + " is not available in scenarios, use at, after or wait";
+            return false;
+        } else {
+            step.kind = Step::stepCommand;
+            step.text = line;
+        }
+
+        std::vector<Step> *block = blocks.back();
+        if (mainTrack >= 0 && block == &m_tracks[mainTrack].steps && blocks.size() == 1) {
+            blocks.pop_back();
+        }
+        block->push_back(step);
+        if (step.kind == Step::stepRepeat) {
+            blocks.push_back(&block->back().body);
+        }
+    }
+
+    if (!blocks.empty()) {
+        std::stringstream where;
+        where << name << ":" << lineNumber << ": ";
+        error = where.str() + "missing end";
+        return false;
+    }
+    if (m_tracks.empty()) {
+        error = name + ": nothing to run";
+        return false;
+    }
+    return true;
+}
+
+bool ScenarioEngine::Start(IScenarioHost *host, std::istream &in, const std::string &name, const Variables &variables, std::string &error)
+{
+    if (IsRunning()) {
+        error = "scenario " + m_name + " is running";
+        return false;
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!Parse(in, name, variables, error)) {
+        m_tracks.clear();
+        return false;
+    }
+    m_host = host;
+    m_name = name;
+    for (size_t t = 0; t < m_tracks.size(); ++t) {
+        Track &track = m_tracks[t];
+        Frame frame = { NULL, &track.steps, 0, 0 };
+        track.frames.assign(1, frame);
+        track.state = trackReady;
+        track.dueMilliseconds = 0;
+        track.deadlineMilliseconds = 0;
+        track.waiting = NULL;
+        track.eventMark = 0;
+        track.line = 0;
+        track.commands = 0;
+        track.waits = 0;
+        track.timeouts = 0;
+    }
+    m_messages.clear();
+    m_nextSerial = 0;
+    m_lateness.Reset();
+    m_startMilliseconds = NowMilliseconds();
+    m_endMilliseconds = 0;
+    m_stopRequested = false;
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&ScenarioEngine::EngineThread, this);
+    return true;
+}
+
+void ScenarioEngine::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_condition.notify_all();
+}
+
+bool ScenarioEngine::Wait(unsigned int timeoutMilliseconds)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_condition.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), [this] { return !IsRunning(); });
+}
+
+// Returns the next command, time or wait step of the track, or NULL when it is done
+const ScenarioEngine::Step *ScenarioEngine::NextStep(Track &track)
+{
+    while (!track.frames.empty()) {
+        Frame &frame = track.frames.back();
+        if (frame.next == frame.steps->size()) {
+            if (frame.repeat != NULL && ++frame.iteration < frame.repeat->count) {
+                frame.next = 0;
+            } else {
+                track.frames.pop_back();
+            }
+            continue;
+        }
+        const Step &step = (*frame.steps)[frame.next++];
+        if (step.kind == Step::stepRepeat) {
+            if (step.count > 0) {
+                Frame repeat = { &step, &step.body, 0, 0 };
+                track.frames.push_back(repeat);
+            }
+            continue;
+        }
+        return &step;
+    }
+    return NULL;
+}
+
+bool ScenarioEngine::MatchWait(Track &track)
+{
+    const Step &step = *track.waiting;
+    for (std::deque<Message>::const_iterator i = m_messages.begin(); i != m_messages.end(); ++i) {
+        if (i->serial < track.eventMark || i->response != step.response || i->type != step.type) {
+            continue;
+        }
+        if (!track.waitText.empty() && i->text.find(track.waitText) == std::string::npos) {
+            continue;
+        }
+        track.dueMilliseconds = i->receivedMilliseconds;
+        track.eventMark = i->serial + 1;
+        track.waiting = NULL;
+        track.state = trackReady;
+        return true;
+    }
+    return false;
+}
+
+void ScenarioEngine::EngineThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopRequested) {
+        double now = NowMilliseconds() - m_startMilliseconds;
+        double wakeup = -1;
+        Track *next = NULL;
+
+        for (size_t t = 0; t < m_tracks.size(); ++t) {
+            Track &track = m_tracks[t];
+            if (track.state == trackWaiting && !MatchWait(track)) {
+                if (now >= track.deadlineMilliseconds) {
+                    track.timeouts++;
+                    track.state = trackFailed;
+                    std::stringstream ss;
+                    ss << "\r * scenario: " << m_name << ":" << track.line << ": track " << track.name << " timed out waiting for " << (track.waiting->response ? "resp_" : "evt_") << track.waiting->type << "\n";
+                    m_host->PrintScenario(ss.str());
+                } else if (wakeup < 0 || track.deadlineMilliseconds < wakeup) {
+                    wakeup = track.deadlineMilliseconds;
+                }
+                continue;
+            }
+            // Earliest due first, the first track on a tie
+            if (track.state == trackReady && (next == NULL || track.dueMilliseconds < next->dueMilliseconds)) {
+                next = &track;
+            }
+        }
+        if (next == NULL && wakeup < 0) {
+            break; // every track is done or failed
+        }
+        if (next == NULL || next->dueMilliseconds > now) {
+            if (next != NULL && (wakeup < 0 || next->dueMilliseconds < wakeup)) {
+                wakeup = next->dueMilliseconds;
+            }
+            // Wakes up for the absolute due time, so oversleeping once is not carried over
+            std::chrono::steady_clock::time_point until(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(m_startMilliseconds + wakeup)));
+            m_condition.wait_until(lock, until);
+            continue;
+        }
+
+        const Step *step = NextStep(*next);
+        if (step == NULL) {
+            next->state = trackDone;
+            continue;
+        }
+        next->line = step->line;
+        switch (step->kind) {
+            case Step::stepAt:
+                next->dueMilliseconds = step->milliseconds;
+                break;
+            case Step::stepAfter:
+                next->dueMilliseconds += step->milliseconds;
+                break;
+            case Step::stepWait:
+            {
+                bool ok;
+                next->waitText = Substitute(step->text, next, ok);
+                if (!ok) {
+                    next->state = trackFailed;
+                    m_host->PrintScenario("\r * scenario: " + m_name + ": unknown variable $" + next->waitText + "\n");
+                    break;
+                }
+                next->waits++;
+                next->waiting = step;
+                next->deadlineMilliseconds = (next->dueMilliseconds > now ? next->dueMilliseconds : now) + step->milliseconds;
+                next->state = trackWaiting;
+                break;
+            }
+            case Step::stepCommand:
+            {
+                bool ok;
+                std::string command = Substitute(step->text, next, ok);
+                if (!ok) {
+                    next->state = trackFailed;
+                    m_host->PrintScenario("\r * scenario: " + m_name + ": unknown variable $" + command + "\n");
+                    break;
+                }
+                m_lateness.Record((uint64_t)((now - next->dueMilliseconds) * 1000));
+                next->commands++;
+                // Waits after this command look at what was received from now on
+                next->eventMark = m_nextSerial;
+                lock.unlock();
+                m_host->RunScenarioCommand(command);
+                lock.lock();
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    for (size_t t = 0; t < m_tracks.size(); ++t) {
+        if (m_tracks[t].state == trackReady || m_tracks[t].state == trackWaiting) {
+            m_tracks[t].state = trackStopped;
+        }
+    }
+    m_endMilliseconds = NowMilliseconds();
+    m_running.store(false, std::memory_order_release);
+    m_condition.notify_all();
+}
+
+void ScenarioEngine::OnVivoxSDKMessage(vx_message_base_t *msg)
+{
+    if (!IsRunning()) {
+        return;
+    }
+    Message message;
+    bool ignored;
+    if (msg->type == msg_response) {
+        const char *name = vx_get_response_type_string(reinterpret_cast<vx_resp_base_t *>(msg)->type);
+        message.response = true;
+        message.type = StripTypePrefix(name != NULL ? name : "", ignored);
+    } else if (msg->type == msg_event) {
+        const char *name = vx_get_event_type_string(reinterpret_cast<vx_evt_base_t *>(msg)->type);
+        message.response = false;
+        message.type = StripTypePrefix(name != NULL ? name : "", ignored);
+    } else {
+        return;
+    }
+    if (m_hasFilters) {
+        message.text = m_host->DescribeScenarioMessage(msg);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        message.serial = m_nextSerial++;
+        message.receivedMilliseconds = NowMilliseconds() - m_startMilliseconds;
+        m_messages.push_back(message);
+        if (m_messages.size() > c_maxMessages) {
+            m_messages.pop_front();
+        }
+    }
+    m_condition.notify_all();
+}
+
+void ScenarioEngine::GetReport(Report &report) const
+{
+    static const char *stateNames[] = { "running", "waiting", "done", "failed", "stopped" };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    report.name = m_name;
+    report.running = IsRunning();
+    double end = report.running ? NowMilliseconds() : m_endMilliseconds;
+    report.elapsedSeconds = m_startMilliseconds != 0 ? (end - m_startMilliseconds) / 1000 : 0;
+    report.tracks.clear();
+    for (size_t t = 0; t < m_tracks.size(); ++t) {
+        const Track &track = m_tracks[t];
+        TrackReport trackReport;
+        trackReport.name = track.name;
+        trackReport.state = stateNames[track.state];
+        trackReport.line = track.line;
+        trackReport.commands = track.commands;
+        trackReport.waits = track.waits;
+        trackReport.timeouts = track.timeouts;
+        report.tracks.push_back(trackReport);
+    }
+    report.commands = m_lateness.GetCount();
+    report.meanLateMilliseconds = m_lateness.GetMean() / 1000;
+    report.p50LateMilliseconds = m_lateness.GetPercentile(0.50) / 1000.0;
+    report.p99LateMilliseconds = m_lateness.GetPercentile(0.99) / 1000.0;
+    report.maxLateMilliseconds = m_lateness.GetMax() / 1000.0;
+}
@@ -0,0 +1,202 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "SDKMessageObserver.h"
+#include "LatencyHistogram.h"
+
+// Runs the commands of a scenario for the engine
+class IScenarioHost
+{
+public:
+    virtual ~IScenarioHost() {}
+    // Runs a console command line
+    virtual void RunScenarioCommand(const std::string &line) = 0;
+    // The text 'wait' filters are matched against; only asked for when the scenario has filters
+    virtual std::string DescribeScenarioMessage(vx_message_base_t *msg) = 0;
+    virtual void PrintScenario(const std::string &text) = 0;
+};
+
+// Runs scenario scripts on a timeline instead of one command after the other.
+//
+//  # comment
+//  set name value              a variable, used as $name or ${name}
+//  track name                  lines up to its 'end' run concurrently with the other tracks,
+//                              such as one per virtual user; $track is the name
+//    at seconds                waits until that time after the scenario started
+//    after seconds             waits that long after the previous step was due
+//    wait type [seconds] [text]
+//                              waits for a response or event received since the previous
+//                              command: participant_added, evt_participant_added or
+//                              resp_account_logout, optionally with text in its XML, for
+//                              at most 30 seconds by default; the track fails on timeout
+//    repeat count [variable]   runs the lines up to its 'end' count times, with the
+//                              iteration, from 0, in $variable
+//    end
+//    anything else             a console command, run when the previous step is done
+//  end
+//
+// Lines outside any track make up a track of their own, named main. Times are seconds, or
+// milliseconds with an ms suffix.
+//
+// Each step is due at a time computed from the scenario, not from when the step before it
+// actually ran, so a late command does not delay the ones after it, and nothing accumulates
+// over a long run. The only exception is 'wait', after which the track goes on from when the
+// message was received. All tracks are run by one thread, in order of due time then of
+// track, so two runs of a scenario issue the same commands in the same order and their
+// timing differs only by how late each step ran, which GetReport() shows.
+class ScenarioEngine : public ISDKMessageObserver
+{
+public:
+    typedef std::map<std::string, std::string> Variables;
+
+    ScenarioEngine();
+    ~ScenarioEngine();
+
+    static SDKMessageInterest GetMessageInterest() { return SDKMessageInterest::All(); }
+
+    // Parses the scenario, then runs it. 'variables' take precedence over the 'set' lines.
+    // Returns false with error set, as name:line: message for a bad scenario.
+    bool Start(IScenarioHost *host, std::istream &in, const std::string &name, const Variables &variables, std::string &error);
+    void Stop();
+    // Waits for every track to be done, returns false on timeout
+    bool Wait(unsigned int timeoutMilliseconds);
+    bool IsRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    struct TrackReport {
+        std::string name;
+        const char *state;
+        int line;                   // of the step it is at
+        uint64_t commands;
+        uint64_t waits;
+        uint64_t timeouts;
+    };
+    struct Report {
+        std::string name;
+        bool running;
+        double elapsedSeconds;
+        std::vector<TrackReport> tracks;
+        // How much later than due the commands ran
+        uint64_t commands;
+        double meanLateMilliseconds;
+        double p50LateMilliseconds;
+        double p99LateMilliseconds;
+        double maxLateMilliseconds;
+    };
+    void GetReport(Report &report) const;
+
+    // ISDKMessageObserver
+    void OnVivoxSDKMessage(vx_message_base_t *msg);
+
+private:
+    ScenarioEngine(const ScenarioEngine &); // disabled
+
+    struct Step {
+        enum Kind {
+            stepCommand,
+            stepAt,
+            stepAfter,
+            stepWait,
+            stepRepeat
+        };
+        Kind kind;
+        int line;
+        std::string text;           // the command, or the text a wait looks for
+        bool response;              // wait: for a response rather than an event
+        std::string type;           // wait: without its evt_ or resp_ prefix
+        double milliseconds;        // at, after, wait timeout
+        unsigned int count;         // repeat
+        std::string variable;       // repeat
+        std::vector<Step> body;     // repeat
+    };
+
+    enum TrackState {
+        trackReady,
+        trackWaiting,
+        trackDone,
+        trackFailed,
+        trackStopped
+    };
+
+    struct Frame {
+        const Step *repeat;         // NULL for the track itself
+        const std::vector<Step> *steps;
+        size_t next;
+        unsigned int iteration;
+    };
+
+    struct Track {
+        std::string name;
+        std::vector<Step> steps;
+        std::vector<Frame> frames;
+        TrackState state;
+        double dueMilliseconds;
+        double deadlineMilliseconds; // of the wait
+        const Step *waiting;
+        std::string waitText;
+        uint64_t eventMark;         // serial of the first message a wait looks at
+        int line;
+        uint64_t commands;
+        uint64_t waits;
+        uint64_t timeouts;
+    };
+
+    struct Message {
+        uint64_t serial;
+        bool response;
+        std::string type;
+        std::string text;
+        double receivedMilliseconds;
+    };
+
+    bool Parse(std::istream &in, const std::string &name, const Variables &variables, std::string &error);
+    static bool ParseSeconds(const std::string &value, double &milliseconds);
+    static std::string StripTypePrefix(const std::string &type, bool &response);
+    static bool IsKnownType(const std::string &type, bool response);
+    // Without a track, only the scenario variables are known
+    std::string Substitute(const std::string &text, const Track *track, bool &ok) const;
+    void EngineThread();
+    // m_mutex must be held
+    const Step *NextStep(Track &track);
+    bool MatchWait(Track &track);
+    double NowMilliseconds() const;
+
+    IScenarioHost *m_host;
+    std::string m_name;
+    Variables m_variables;
+    std::vector<Track> m_tracks;
+    bool m_hasFilters;
+    double m_startMilliseconds;
+    double m_endMilliseconds;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<Message> m_messages;   // the most recent ones
+    uint64_t m_nextSerial;
+    bool m_stopRequested;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    LatencyHistogram m_lateness;    // of the commands, in microseconds
+};
@@ -0,0 +1,430 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "Spatializer.h"
+
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#   define SPATIALIZER_USE_SSE2 1
+#   include <emmintrin.h>
+#else
+#   define SPATIALIZER_USE_SSE2 0
+#endif
+
+#define IS_POWER_OF_2(x) ((x) != 0 && ((x) & ((x) - 1)) == 0)
+static_assert(IS_POWER_OF_2(Spatializer::c_nMaxSources), "c_nMaxSources must be a power of 2");
+
+static const float c_fQuarterPi = 0.785398163397448f;
+
+Spatializer::Spatializer()
+{
+    m_enabled.store(false);
+    m_minDistance.store(8.0f);
+    m_maxDistance.store(60.0f);
+    m_rolloff.store(1.0f);
+    m_sourceCount.store(0);
+
+    // Listener at the origin facing -Z with +Y up, same as the SDK default orientation
+    static const float defaultPose[9] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f };
+    m_listener.m_seq.store(0);
+    for (size_t i = 0; i < 9; ++i) {
+        m_listener.m_value[i].store(defaultPose[i]);
+    }
+
+    for (size_t i = 0; i < c_nMaxSources; ++i) {
+        Slot &slot = m_slots[i];
+        slot.m_state.store(slotEmpty);
+        slot.m_identity.store(0);
+        slot.m_hash.store(0);
+        slot.m_uri[0].store('\0');
+        slot.m_seq.store(0);
+        slot.m_x.store(0.0f);
+        slot.m_y.store(0.0f);
+        slot.m_z.store(0.0f);
+        slot.m_lastGainLeft = 1.0f;
+        slot.m_lastGainRight = 1.0f;
+        slot.m_hasLastGain = false;
+    }
+}
+
+void Spatializer::SetDistanceModel(float minDistance, float maxDistance, float rolloff)
+{
+    if (minDistance < 0.001f) {
+        minDistance = 0.001f;
+    }
+    if (maxDistance < minDistance) {
+        maxDistance = minDistance;
+    }
+    if (rolloff < 0.0f) {
+        rolloff = 0.0f;
+    }
+    m_minDistance.store(minDistance, std::memory_order_relaxed);
+    m_maxDistance.store(maxDistance, std::memory_order_relaxed);
+    m_rolloff.store(rolloff, std::memory_order_relaxed);
+}
+
+void Spatializer::GetDistanceModel(float &minDistance, float &maxDistance, float &rolloff) const
+{
+    minDistance = m_minDistance.load(std::memory_order_relaxed);
+    maxDistance = m_maxDistance.load(std::memory_order_relaxed);
+    rolloff = m_rolloff.load(std::memory_order_relaxed);
+}
+
+void Spatializer::SetListener(const Vector3 &position, const Vector3 &at, const Vector3 &up)
+{
+    const float pose[9] = { position.x, position.y, position.z, at.x, at.y, at.z, up.x, up.y, up.z };
+    uint32_t seq = m_listener.m_seq.load(std::memory_order_relaxed);
+    m_listener.m_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < 9; ++i) {
+        m_listener.m_value[i].store(pose[i], std::memory_order_relaxed);
+    }
+    m_listener.m_seq.store(seq + 2, std::memory_order_release);
+}
+
+void Spatializer::ReadListener(float pose[9]) const
+{
+    uint32_t before, after;
+    do {
+        before = m_listener.m_seq.load(std::memory_order_acquire);
+        for (size_t i = 0; i < 9; ++i) {
+            pose[i] = m_listener.m_value[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_listener.m_seq.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+}
+
+uint32_t Spatializer::HashUri(const char *uri)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)uri; *p; ++p) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool Spatializer::UriEquals(const Slot &slot, const char *uri)
+{
+    for (size_t i = 0; i < c_nMaxUriLength; ++i) {
+        char c = slot.m_uri[i].load(std::memory_order_relaxed);
+        if (c != uri[i]) {
+            return false;
+        }
+        if (c == '\0') {
+            return true;
+        }
+    }
+    return false;
+}
+
+Spatializer::Slot *Spatializer::FindSlot(const char *uri, uint32_t hash, uint32_t *identity) const
+{
+    const size_t mask = c_nMaxSources - 1;
+    for (size_t probe = 0; probe < c_nMaxSources; ++probe) {
+        const Slot &slot = m_slots[(hash + probe) & mask];
+        uint32_t before, after;
+        bool match;
+        do {
+            before = slot.m_identity.load(std::memory_order_acquire);
+            if (slot.m_state.load(std::memory_order_acquire) == slotEmpty) {
+                return NULL;
+            }
+            // A slot being rebound is not the one of a participant that is already known
+            match = (before & 1) == 0 && slot.m_hash.load(std::memory_order_relaxed) == hash && UriEquals(slot, uri);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot.m_identity.load(std::memory_order_relaxed);
+        } while (before != after);
+        if (match) {
+            if (identity) {
+                *identity = before;
+            }
+            return const_cast<Slot *>(&slot);
+        }
+    }
+    return NULL;
+}
+
+void Spatializer::WritePosition(Slot &slot, const Vector3 &position)
+{
+    uint32_t seq = slot.m_seq.load(std::memory_order_relaxed);
+    slot.m_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.m_x.store(position.x, std::memory_order_relaxed);
+    slot.m_y.store(position.y, std::memory_order_relaxed);
+    slot.m_z.store(position.z, std::memory_order_relaxed);
+    slot.m_seq.store(seq + 2, std::memory_order_release);
+}
+
+void Spatializer::BindSlot(Slot &slot, const char *uri, uint32_t hash, const Vector3 &position)
+{
+    uint32_t identity = slot.m_identity.load(std::memory_order_relaxed);
+    slot.m_identity.store(identity + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.m_hash.store(hash, std::memory_order_relaxed);
+    size_t length = strlen(uri);
+    for (size_t i = 0; i <= length; ++i) {
+        slot.m_uri[i].store(uri[i], std::memory_order_relaxed);
+    }
+    slot.m_identity.store(identity + 2, std::memory_order_release);
+    WritePosition(slot, position);
+}
+
+bool Spatializer::SetSourcePosition(const char *participantUri, const Vector3 &position)
+{
+    if (participantUri == NULL || strlen(participantUri) >= c_nMaxUriLength) {
+        return false;
+    }
+    uint32_t hash = HashUri(participantUri);
+    Slot *slot = FindSlot(participantUri, hash);
+    if (slot != NULL && slot->m_state.load(std::memory_order_acquire) == slotLive) {
+        WritePosition(*slot, position);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_insertMutex);
+    slot = FindSlot(participantUri, hash);
+    if (slot == NULL) {
+        // Not in the table: take the first slot of its probe sequence that is not live
+        const size_t mask = c_nMaxSources - 1;
+        for (size_t probe = 0; probe < c_nMaxSources && slot == NULL; ++probe) {
+            Slot &candidate = m_slots[(hash + probe) & mask];
+            if (candidate.m_state.load(std::memory_order_relaxed) != slotLive) {
+                BindSlot(candidate, participantUri, hash, position);
+                slot = &candidate;
+            }
+        }
+        if (slot == NULL) {
+            return false;
+        }
+    } else {
+        WritePosition(*slot, position);
+    }
+    if (slot->m_state.load(std::memory_order_relaxed) != slotLive) {
+        slot->m_hasLastGain.store(false, std::memory_order_relaxed);
+        slot->m_state.store(slotLive, std::memory_order_release);
+        m_sourceCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool Spatializer::GetSourcePosition(const char *participantUri, Vector3 &position) const
+{
+    if (participantUri == NULL) {
+        return false;
+    }
+    uint32_t identity;
+    const Slot *slot = FindSlot(participantUri, HashUri(participantUri), &identity);
+    if (slot == NULL || slot->m_state.load(std::memory_order_acquire) != slotLive) {
+        return false;
+    }
+    uint32_t before, after;
+    do {
+        before = slot->m_seq.load(std::memory_order_acquire);
+        position.x = slot->m_x.load(std::memory_order_relaxed);
+        position.y = slot->m_y.load(std::memory_order_relaxed);
+        position.z = slot->m_z.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = slot->m_seq.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    // Rebound to another participant meanwhile
+    return slot->m_identity.load(std::memory_order_relaxed) == identity;
+}
+
+void Spatializer::RemoveSource(const char *participantUri)
+{
+    if (participantUri == NULL) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_insertMutex);
+    Slot *slot = FindSlot(participantUri, HashUri(participantUri));
+    if (slot == NULL) {
+        return;
+    }
+    uint32_t expected = slotLive;
+    if (slot->m_state.compare_exchange_strong(expected, slotRemoved, std::memory_order_acq_rel)) {
+        m_sourceCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+size_t Spatializer::GetSourceCount() const
+{
+    return m_sourceCount.load(std::memory_order_relaxed);
+}
+
+void Spatializer::ComputeGains(const Vector3 &source, const float listener[9], float &gainLeft, float &gainRight, float &gainDistance) const
+{
+    float dx = source.x - listener[0];
+    float dy = source.y - listener[1];
+    float dz = source.z - listener[2];
+    float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+
+    float minDistance = m_minDistance.load(std::memory_order_relaxed);
+    float maxDistance = m_maxDistance.load(std::memory_order_relaxed);
+    float rolloff = m_rolloff.load(std::memory_order_relaxed);
+    if (distance >= maxDistance) {
+        gainDistance = 0.0f;
+    } else if (distance <= minDistance) {
+        gainDistance = 1.0f;
+    } else {
+        gainDistance = minDistance / (minDistance + rolloff * (distance - minDistance));
+    }
+
+    // right = at x up
+    float rx = listener[4] * listener[8] - listener[5] * listener[7];
+    float ry = listener[5] * listener[6] - listener[3] * listener[8];
+    float rz = listener[3] * listener[7] - listener[4] * listener[6];
+    float rlen = sqrtf(rx * rx + ry * ry + rz * rz);
+    float pan = 0.0f;
+    if (distance > 1e-4f && rlen > 1e-4f) {
+        pan = (dx * rx + dy * ry + dz * rz) / (distance * rlen);
+        if (pan < -1.0f) {
+            pan = -1.0f;
+        } else if (pan > 1.0f) {
+            pan = 1.0f;
+        }
+    }
+
+    // Constant power pan law: L^2 + R^2 == 1 for every azimuth
+    float theta = (pan + 1.0f) * c_fQuarterPi;
+    gainLeft = gainDistance * cosf(theta);
+    gainRight = gainDistance * sinf(theta);
+}
+
+void Spatializer::Process(const char *participantUri, short *pcm_frames, int pcm_frame_count, int channels_per_frame)
+{
+    if (!IsEnabled() || participantUri == NULL || pcm_frames == NULL || pcm_frame_count <= 0 || channels_per_frame <= 0) {
+        return;
+    }
+    uint32_t identity;
+    Slot *slot = FindSlot(participantUri, HashUri(participantUri), &identity);
+    if (slot == NULL || slot->m_state.load(std::memory_order_acquire) != slotLive) {
+        return;
+    }
+
+    Vector3 source;
+    uint32_t before, after;
+    do {
+        before = slot->m_seq.load(std::memory_order_acquire);
+        source.x = slot->m_x.load(std::memory_order_relaxed);
+        source.y = slot->m_y.load(std::memory_order_relaxed);
+        source.z = slot->m_z.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = slot->m_seq.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    if (slot->m_identity.load(std::memory_order_relaxed) != identity) {
+        return;     // rebound to another participant meanwhile
+    }
+
+    float listener[9];
+    ReadListener(listener);
+
+    float gainLeft, gainRight, gainDistance;
+    ComputeGains(source, listener, gainLeft, gainRight, gainDistance);
+
+    // Mono and multichannel streams can only be attenuated
+    if (channels_per_frame != 2) {
+        gainLeft = gainDistance;
+        gainRight = gainDistance;
+    }
+    if (!slot->m_hasLastGain.load(std::memory_order_relaxed)) {
+        slot->m_lastGainLeft = gainLeft;
+        slot->m_lastGainRight = gainRight;
+        slot->m_hasLastGain.store(true, std::memory_order_relaxed);
+    }
+
+    // Ramp from the previous frame's gains to avoid zipper noise when sources move
+    float dl = (gainLeft - slot->m_lastGainLeft) / (float)pcm_frame_count;
+    float dr = (gainRight - slot->m_lastGainRight) / (float)pcm_frame_count;
+    if (channels_per_frame > 2) {
+        ApplyFrameGains(pcm_frames, (size_t)pcm_frame_count, (size_t)channels_per_frame, slot->m_lastGainLeft, dl);
+    } else {
+        float gain0[4], step[4];
+        if (channels_per_frame == 2) {
+            float l = slot->m_lastGainLeft;
+            float r = slot->m_lastGainRight;
+            gain0[0] = l;
+            gain0[1] = r;
+            gain0[2] = l + dl;
+            gain0[3] = r + dr;
+            step[0] = step[2] = 2.0f * dl;
+            step[1] = step[3] = 2.0f * dr;
+        } else {
+            float g = slot->m_lastGainLeft;
+            for (size_t lane = 0; lane < 4; ++lane) {
+                gain0[lane] = g + (float)lane * dl;
+                step[lane] = 4.0f * dl;
+            }
+        }
+        ApplyGains(pcm_frames, (size_t)pcm_frame_count * (size_t)channels_per_frame, gain0, step);
+    }
+
+    slot->m_lastGainLeft = gainLeft;
+    slot->m_lastGainRight = gainRight;
+}
+
+void Spatializer::ApplyGains(short *samples, size_t count, const float gain0[4], const float step[4])
+{
+    size_t i = 0;
+#if SPATIALIZER_USE_SSE2
+    // 8 samples per iteration: widen to 32 bit, scale in float, narrow with signed saturation
+    __m128 gainLo = _mm_loadu_ps(gain0);
+    __m128 stepLo = _mm_loadu_ps(step);
+    __m128 gainHi = _mm_add_ps(gainLo, stepLo);
+    __m128 step2 = _mm_add_ps(stepLo, stepLo);
+    for (; i + 8 <= count; i += 8) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(samples + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+        __m128 flo = _mm_mul_ps(_mm_cvtepi32_ps(lo), gainLo);
+        __m128 fhi = _mm_mul_ps(_mm_cvtepi32_ps(hi), gainHi);
+        __m128i out = _mm_packs_epi32(_mm_cvtps_epi32(flo), _mm_cvtps_epi32(fhi));
+        _mm_storeu_si128((__m128i *)(samples + i), out);
+        gainLo = _mm_add_ps(gainLo, step2);
+        gainHi = _mm_add_ps(gainHi, step2);
+    }
+#endif
+    for (; i < count; ++i) {
+        size_t lane = i & 3;
+        float value = (float)samples[i] * (gain0[lane] + (float)(i >> 2) * step[lane]);
+        if (value > 32767.0f) {
+            value = 32767.0f;
+        } else if (value < -32768.0f) {
+            value = -32768.0f;
+        }
+        samples[i] = (short)lrintf(value);
+    }
+}
+
+void Spatializer::ApplyFrameGains(short *samples, size_t frames, size_t channels, float gain, float step)
+{
+    for (size_t frame = 0; frame < frames; ++frame) {
+        float g = gain + (float)frame * step;
+        short *sample = samples + frame * channels;
+        for (size_t c = 0; c < channels; ++c) {
+            float value = (float)sample[c] * g;
+            if (value > 32767.0f) {
+                value = 32767.0f;
+            } else if (value < -32768.0f) {
+                value = -32768.0f;
+            }
+            sample[c] = (short)lrintf(value);
+        }
+    }
+}
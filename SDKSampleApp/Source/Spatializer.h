@@ -0,0 +1,112 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+// Client side positional rendering of the per-participant streams delivered to
+// pf_on_audio_unit_before_recv_audio_mixed. Applies distance attenuation and
+// constant-power stereo panning, so a non-positional channel can be heard
+// positionally without any 3D position requests going to the server.
+//
+// Threading model:
+//  - Process() runs on the SDK audio thread and never blocks.
+//  - SetListener() and SetSourcePosition() for a participant with a position are
+//    wait-free (per-slot sequence locks). The first position for a participant,
+//    and RemoveSource(), take m_insertMutex, which the audio thread never touches.
+//  - Position updates and the removal of one participant are expected to come
+//    from one thread.
+class Spatializer
+{
+public:
+    struct Vector3 {
+        float x, y, z;
+    };
+
+    Spatializer();
+
+    void SetEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_release); }
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_acquire); }
+
+    // Inverse distance clamped model: full volume up to minDistance, silent past maxDistance.
+    void SetDistanceModel(float minDistance, float maxDistance, float rolloff);
+    void GetDistanceModel(float &minDistance, float &maxDistance, float &rolloff) const;
+
+    void SetListener(const Vector3 &position, const Vector3 &at, const Vector3 &up);
+    // Returns false if the participant table is full.
+    bool SetSourcePosition(const char *participantUri, const Vector3 &position);
+    bool GetSourcePosition(const char *participantUri, Vector3 &position) const;
+    void RemoveSource(const char *participantUri);
+    size_t GetSourceCount() const;
+
+    // Audio thread. Leaves the stream untouched if the participant has no position.
+    void Process(const char *participantUri, short *pcm_frames, int pcm_frame_count, int channels_per_frame);
+
+    // Scales interleaved samples; the gain of sample i is gain0[i % 4] + (i / 4) * step[i % 4].
+    static void ApplyGains(short *samples, size_t count, const float gain0[4], const float step[4]);
+    // Scales every channel of frame f by gain + f * step, for any number of channels.
+    static void ApplyFrameGains(short *samples, size_t frames, size_t channels, float gain, float step);
+
+    static const size_t c_nMaxSources = 256;
+    static const size_t c_nMaxUriLength = 256;
+
+private:
+    enum {
+        slotEmpty = 0,
+        slotLive = 1,
+        slotRemoved = 2
+    };
+
+    // A removed slot is bound to another URI when a new participant needs one, under
+    // m_insertMutex. m_identity is the sequence lock of m_hash and m_uri, odd while they
+    // change, so lock free readers can tell they compared or read a slot that was rebound.
+    struct Slot {
+        std::atomic<uint32_t> m_state;
+        std::atomic<uint32_t> m_identity;
+        std::atomic<uint32_t> m_hash;
+        std::atomic<char> m_uri[c_nMaxUriLength];
+        std::atomic<uint32_t> m_seq;
+        std::atomic<float> m_x, m_y, m_z;
+        // Used by the audio thread to ramp gains across a frame; m_hasLastGain is cleared
+        // when the slot goes live, so a new or returning participant starts from its gain
+        float m_lastGainLeft, m_lastGainRight;
+        std::atomic<bool> m_hasLastGain;
+    };
+
+    struct ListenerPose {
+        std::atomic<uint32_t> m_seq;
+        std::atomic<float> m_value[9];
+    };
+
+    static uint32_t HashUri(const char *uri);
+    static bool UriEquals(const Slot &slot, const char *uri);
+    // identity, if given, receives the m_identity the slot was found with
+    Slot *FindSlot(const char *uri, uint32_t hash, uint32_t *identity = NULL) const;
+    // m_insertMutex must be held
+    void BindSlot(Slot &slot, const char *uri, uint32_t hash, const Vector3 &position);
+    static void WritePosition(Slot &slot, const Vector3 &position);
+    void ReadListener(float pose[9]) const;
+    void ComputeGains(const Vector3 &source, const float listener[9], float &gainLeft, float &gainRight, float &gainDistance) const;
+
+    std::atomic<bool> m_enabled;
+    std::atomic<float> m_minDistance, m_maxDistance, m_rolloff;
+    std::atomic<size_t> m_sourceCount;
+    ListenerPose m_listener;
+    Slot m_slots[c_nMaxSources];
+    std::mutex m_insertMutex;
+};
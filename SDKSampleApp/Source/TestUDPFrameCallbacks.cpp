@@ -0,0 +1,256 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TestUDPFrameCallbacks.h"
+#include "UdpFrameTelemetry.h"
+#include "UdpFrameCapture.h"
+
+
+// --------------------- UDP CALLBACKS TEST ------------------------------------------------
+/**
+ * Header and trailer settings and buffers, shared by all the packets.
+ *
+ * The header is filled with increasing byte values and the trailer with decreasing ones, so
+ * you can use Wireshark to see how packets look with them. Both are built once and handed
+ * to the SDK read-only, unless the header carries a sequence number: each packet then gets
+ * its own copy of the header from a pool of buffers taken and returned without locks. The
+ * pool falls back to the heap when all of its buffers are in flight.
+ */
+struct vx_test_udp_frames {
+    long hdrSize;
+    long trlSize;
+    bool hdrSequence;           // the header starts with a 32 bit big endian packet counter
+    bool telemetry;             // packets are counted by UdpFrameTelemetry
+    char *hdr;                  // constant header
+    char *trl;                  // constant trailer
+    char *pool;                 // c_nVxTestUdpPoolBuffers headers
+    std::atomic<bool> *poolBusy;
+    std::atomic<unsigned int> sequence;
+    std::atomic<unsigned int> poolMisses;
+};
+
+static const size_t c_nVxTestUdpPoolBuffers = 64;
+
+// The buffers of the callbacks given to the SDK
+static vx_test_udp_frames *s_pVxTestUdpFrames = NULL;
+
+/**
+ * Builds the header and trailer.
+ */
+vx_test_udp_frames *vx_test_create_udp_frames(long hdrSize, long trlSize, bool hdrSequence)
+{
+    vx_test_udp_frames *frames = new vx_test_udp_frames;
+    frames->hdr = NULL;
+    frames->trl = NULL;
+    frames->pool = NULL;
+    frames->poolBusy = NULL;
+    frames->telemetry = false;
+
+    frames->hdrSize = hdrSize > 0 ? hdrSize : 0;
+    frames->trlSize = trlSize > 0 ? trlSize : 0;
+    frames->hdrSequence = hdrSequence && frames->hdrSize >= 4;
+    frames->sequence = 0;
+    frames->poolMisses = 0;
+    if (frames->hdrSize) {
+        frames->hdr = new char[frames->hdrSize];
+        for (long i = 0; i < frames->hdrSize; i++) {
+            frames->hdr[i] = (char)(i % 256);
+        }
+    }
+    if (frames->trlSize) {
+        frames->trl = new char[frames->trlSize];
+        for (long i = 0; i < frames->trlSize; i++) {
+            frames->trl[i] = (char)(255 - (i % 256));
+        }
+    }
+    if (frames->hdrSequence) {
+        frames->pool = new char[c_nVxTestUdpPoolBuffers * frames->hdrSize];
+        frames->poolBusy = new std::atomic<bool>[c_nVxTestUdpPoolBuffers];
+        for (size_t i = 0; i < c_nVxTestUdpPoolBuffers; i++) {
+            memcpy(frames->pool + i * frames->hdrSize, frames->hdr, frames->hdrSize);
+            frames->poolBusy[i] = false;
+        }
+    }
+    return frames;
+}
+
+/**
+ * Must not be called while packets are in flight.
+ */
+void vx_test_destroy_udp_frames(vx_test_udp_frames *frames)
+{
+    if (NULL == frames) {
+        return;
+    }
+    delete[] frames->hdr;
+    delete[] frames->trl;
+    delete[] frames->pool;
+    delete[] frames->poolBusy;
+    delete frames;
+}
+
+unsigned int vx_test_get_udp_pool_misses(const vx_test_udp_frames *frames)
+{
+    return frames ? frames->poolMisses.load() : 0;
+}
+
+static char *vx_test_acquire_udp_header(vx_test_udp_frames &frames)
+{
+    // Start where the last packet of this thread found a buffer: it is usually free again
+    static thread_local size_t t_hint = 0;
+    for (size_t n = 0; n < c_nVxTestUdpPoolBuffers; n++) {
+        size_t i = (t_hint + n) % c_nVxTestUdpPoolBuffers;
+        if (!frames.poolBusy[i].load(std::memory_order_relaxed) && !frames.poolBusy[i].exchange(true, std::memory_order_acquire)) {
+            t_hint = i;
+            return frames.pool + i * frames.hdrSize;
+        }
+    }
+    frames.poolMisses++;
+    char *hdr = new char[frames.hdrSize];
+    memcpy(hdr, frames.hdr, frames.hdrSize);
+    return hdr;
+}
+
+static void vx_test_release_udp_header(vx_test_udp_frames &frames, char *hdr)
+{
+    if (hdr >= frames.pool && hdr < frames.pool + c_nVxTestUdpPoolBuffers * frames.hdrSize) {
+        frames.poolBusy[(hdr - frames.pool) / frames.hdrSize].store(false, std::memory_order_release);
+    } else {
+        delete[] hdr;
+    }
+}
+
+void vx_test_udp_frame_before(vx_test_udp_frames *frames, void **header_out, int *header_len_out, void **trailer_out, int *trailer_len_out)
+{
+    char *hdr = frames->hdr;
+    if (frames->hdrSequence) {
+        hdr = vx_test_acquire_udp_header(*frames);
+        unsigned int sequence = frames->sequence++;
+        hdr[0] = (char)(sequence >> 24);
+        hdr[1] = (char)(sequence >> 16);
+        hdr[2] = (char)(sequence >> 8);
+        hdr[3] = (char)sequence;
+    }
+
+    *header_out = hdr;
+    *trailer_out = frames->trl;
+
+    *header_len_out = (int)frames->hdrSize;
+    *trailer_len_out = (int)frames->trlSize;
+}
+
+void vx_test_udp_frame_after(vx_test_udp_frames *frames, void *header)
+{
+    // A per-packet header goes back to the pool; the constant one is left alone
+    if (NULL != header && header != frames->hdr) {
+        vx_test_release_udp_header(*frames, (char *)header);
+    }
+}
+
+/**
+ * This callback will be called before rtp/rtcp/sip packet transmitted.
+ * VX_TEST_UDP_HEADER environment variable defines the length in bytes of the header that will be added to the packet.
+ * VX_TEST_UDP_TRAILER environment variable defines the length in bytes of the trailer that will be added to the packet.
+ * VX_TEST_UDP_HEADER_SEQUENCE environment variable, if set to a non zero value, puts a packet counter in the
+ * first 4 bytes of the header, most significant byte first.
+ * The server should cut out this data.
+ * Server must have the same header/trailer length settings as the client.
+ */
+static void test_on_before_udp_frame_transmitted(
+        void *callback_handle, // the handle passed in the vx_sdk_config_t structure
+        vx_udp_frame_type frame_type,
+        void *payload_data, // the data to be transmitted to the network
+        int payload_data_len, // the len of that data
+        void **header_out, // callback set - pointer to header data (NULL if no header)
+        int *header_len_out, // callback set - length of the header data (0 if no header)
+        void **trailer_out, // callback set - pointer to trailer data (NULL if no trailer)
+        int *trailer_len_out // callback set - length of the trailer data (0 if no trailer)
+        )
+{
+    (void)callback_handle;
+    (void)frame_type;
+    (void)payload_data;
+    (void)payload_data_len;
+
+    vx_test_udp_frame_before(s_pVxTestUdpFrames, header_out, header_len_out, trailer_out, trailer_len_out);
+}
+
+/**
+ * This callback will be called after rtp/rtcp/sip packet transmitted.
+ * Counts the packet, captures it if a capture is running, and gives a per-packet header back to the pool.
+ */
+static void test_on_after_udp_frame_transmitted(
+        void *callback_handle, // the handle passed in the vx_sdk_config_t structure
+        vx_udp_frame_type frame_type,
+        void *payload_data, // the data to be transmitted to the network
+        int payload_data_len, // the len of that data
+        void *header,     // the header data passed in pf_on_before_udp_frame_transmitted
+        int header_len,   // length of the header data
+        void *trailer,    // the trailer data passed in pf_on_before_udp_frame_transmitted
+        int trailer_len,  // length of the trailer data
+        int sent_bytes    // the total number of bytes transmitted - < 0 indicates error
+        )
+{
+    (void)callback_handle;
+    (void)header_len;
+    (void)trailer;
+    (void)trailer_len;
+    if (s_pVxTestUdpFrames->telemetry) {
+        UdpFrameTelemetry::GetInstance().Record(frame_type, payload_data_len, sent_bytes);
+        UdpFrameCapture::GetInstance().Capture(frame_type, payload_data, payload_data_len);
+    }
+    vx_test_udp_frame_after(s_pVxTestUdpFrames, header);
+}
+
+/**
+ * This function sets up the vx_sdk_config_t structure with test callbacks.
+ */
+void vx_test_set_udp_frame_callbacks(vx_sdk_config_t *config)
+{
+    if (NULL == config) {
+        return;
+    }
+
+    /**
+     * Check the VX_TEST_UDP_HEADER, VX_TEST_UDP_TRAILER and VX_TEST_UDP_HEADER_SEQUENCE variables only one time.
+     */
+    if (NULL == s_pVxTestUdpFrames) {
+        long hdrSize = 0;
+        long trlSize = 0;
+        bool hdrSequence = false;
+        char *pVX_TEST_UDP_HEADER = getenv("VX_TEST_UDP_HEADER");
+        char *pVX_TEST_UDP_TRAILER = getenv("VX_TEST_UDP_TRAILER");
+        char *pVX_TEST_UDP_HEADER_SEQUENCE = getenv("VX_TEST_UDP_HEADER_SEQUENCE");
+        if (pVX_TEST_UDP_HEADER) {
+            hdrSize = strtol(pVX_TEST_UDP_HEADER, NULL, 10);
+        }
+        if (pVX_TEST_UDP_TRAILER) {
+            trlSize = strtol(pVX_TEST_UDP_TRAILER, NULL, 10);
+        }
+        if (pVX_TEST_UDP_HEADER_SEQUENCE) {
+            hdrSequence = 0 != strtol(pVX_TEST_UDP_HEADER_SEQUENCE, NULL, 10);
+        }
+        s_pVxTestUdpFrames = vx_test_create_udp_frames(hdrSize, trlSize, hdrSequence);
+        s_pVxTestUdpFrames->telemetry = true;
+    }
+
+    config->pf_on_before_udp_frame_transmitted = test_on_before_udp_frame_transmitted;
+    config->pf_on_after_udp_frame_transmitted = test_on_after_udp_frame_transmitted;
+}
+// -----------------------------------------------------------------------------------------
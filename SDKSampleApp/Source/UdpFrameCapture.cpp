@@ -0,0 +1,336 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <string.h>
+
+#include "UdpFrameCapture.h"
+
+UdpFrameCapture UdpFrameCapture::s_Instance;
+
+static const uint32_t c_nPcapMagic = 0xa1b2c3d4;    // microsecond timestamps
+static const uint32_t c_nLinkTypeRaw = 101;         // IPv4 or IPv6, no link layer header
+static const uint16_t c_nSipPort = 5060;
+static const uint16_t c_nRtpPort = 6000;
+static const uint16_t c_nRtcpPort = 6001;
+
+UdpFrameCapture::UdpFrameCapture() :
+    m_slots(NULL),
+    m_data(NULL),
+    m_mask(0),
+    m_enqueuePosition(0),
+    m_dequeuePosition(0),
+    m_running(false),
+    m_producers(0),
+    m_stopRequested(false),
+    m_frames(0),
+    m_dropped(0),
+    m_skipped(0),
+    m_captured(0),
+    m_bytesWritten(0),
+    m_files(0),
+    m_file(NULL),
+    m_fileBytes(0),
+    m_fileIndex(0),
+    m_ipId(0)
+{
+}
+
+UdpFrameCapture::~UdpFrameCapture()
+{
+    Stop();
+}
+
+std::string UdpFrameCapture::FileName(unsigned int index) const
+{
+    if (index == 0) {
+        return m_settings.path;
+    }
+    // capture.pcap, capture.1.pcap, capture.2.pcap...
+    std::string path = m_settings.path;
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        dot = path.size();
+    }
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%u", index);
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+bool UdpFrameCapture::OpenFile(unsigned int index, std::string &error)
+{
+    std::string name = FileName(index);
+    m_file = fopen(name.c_str(), "wb");
+    if (m_file == NULL) {
+        error = "unable to create " + name;
+        return false;
+    }
+    uint32_t header[6];
+    header[0] = c_nPcapMagic;
+    header[1] = 2 | (4 << 16);   // version 2.4
+    header[2] = 0;               // GMT offset
+    header[3] = 0;               // timestamp accuracy
+    header[4] = m_settings.snapLength;
+    header[5] = c_nLinkTypeRaw;
+    fwrite(header, sizeof(header), 1, m_file);
+    m_fileBytes = sizeof(header);
+    m_fileIndex = index;
+    m_bytesWritten += sizeof(header);
+    m_files++;
+    std::lock_guard<std::mutex> lock(m_fileNameMutex);
+    m_currentFile = name;
+    return true;
+}
+
+void UdpFrameCapture::CloseFile()
+{
+    if (m_file) {
+        fclose(m_file);
+        m_file = NULL;
+    }
+}
+
+bool UdpFrameCapture::Start(const Settings &settings, std::string &error)
+{
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (m_running) {
+        error = "a capture is already running";
+        return false;
+    }
+    m_settings = settings;
+    if (m_settings.snapLength < c_nHeaderBytes + 1) {
+        m_settings.snapLength = c_nHeaderBytes + 1;
+    } else if (m_settings.snapLength > 65535) {
+        m_settings.snapLength = 65535;
+    }
+    if (m_settings.sampleEvery == 0) {
+        m_settings.sampleEvery = 1;
+    }
+    uint64_t slots = 2;
+    while (slots < m_settings.ringSlots) {
+        slots <<= 1;
+    }
+    if (!OpenFile(0, error)) {
+        return false;
+    }
+
+    // No producer can be in Capture() here: m_running is false and Stop() waited for them
+    delete[] m_slots;
+    delete[] m_data;
+    size_t slotBytes = m_settings.snapLength - c_nHeaderBytes;
+    m_slots = new Slot[(size_t)slots];
+    m_data = new unsigned char[(size_t)slots * slotBytes];
+    m_mask = slots - 1;
+    for (uint64_t i = 0; i < slots; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        m_slots[i].data = m_data + i * slotBytes;
+    }
+    m_enqueuePosition.store(0, std::memory_order_relaxed);
+    m_dequeuePosition = 0;
+    m_frames = 0;
+    m_dropped = 0;
+    m_skipped = 0;
+    m_captured = 0;
+    m_bytesWritten = m_fileBytes;
+    m_files = 1;
+    m_stopRequested = false;
+    m_writerThread = std::thread(&UdpFrameCapture::WriterThread, this);
+    m_running.store(true, std::memory_order_seq_cst);
+    return true;
+}
+
+void UdpFrameCapture::Stop()
+{
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (!m_running) {
+        return;
+    }
+    m_running.store(false, std::memory_order_seq_cst);
+    while (m_producers.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+    m_stopRequested = true;
+    m_writerThread.join();
+    CloseFile();
+}
+
+void UdpFrameCapture::Capture(vx_udp_frame_type type, const void *payload, int payloadBytes)
+{
+    if (!m_running.load(std::memory_order_relaxed) || payload == NULL || payloadBytes < 0) {
+        return;
+    }
+    m_producers.fetch_add(1, std::memory_order_seq_cst);
+    if (!m_running.load(std::memory_order_seq_cst)) {
+        m_producers.fetch_sub(1, std::memory_order_seq_cst);
+        return;
+    }
+
+    if (m_frames.fetch_add(1, std::memory_order_relaxed) % m_settings.sampleEvery != 0) {
+        m_skipped.fetch_add(1, std::memory_order_relaxed);
+        m_producers.fetch_sub(1, std::memory_order_seq_cst);
+        return;
+    }
+
+    // Bounded multi-producer queue: a slot is free for the position equal to its sequence
+    Slot *slot = NULL;
+    uint64_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot &candidate = m_slots[position & m_mask];
+        uint64_t sequence = candidate.sequence.load(std::memory_order_acquire);
+        int64_t difference = (int64_t)(sequence - position);
+        if (difference == 0) {
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot = &candidate;
+                break;
+            }
+        } else if (difference < 0) {
+            break; // full
+        } else {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    if (slot == NULL) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_producers.fetch_sub(1, std::memory_order_seq_cst);
+        return;
+    }
+
+    std::chrono::microseconds now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+    uint32_t capacity = m_settings.snapLength - c_nHeaderBytes;
+    slot->seconds = (uint32_t)(now.count() / 1000000);
+    slot->microseconds = (uint32_t)(now.count() % 1000000);
+    slot->originalBytes = (uint32_t)payloadBytes;
+    slot->capturedBytes = (uint32_t)payloadBytes < capacity ? (uint32_t)payloadBytes : capacity;
+    switch (type) {
+        case vx_frame_type_rtp:
+            slot->port = c_nRtpPort;
+            break;
+        case vx_frame_type_rtcp:
+            slot->port = c_nRtcpPort;
+            break;
+        default:
+            slot->port = c_nSipPort;
+            break;
+    }
+    memcpy(slot->data, payload, slot->capturedBytes);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    m_producers.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+static void PutBigEndian16(unsigned char *p, uint16_t value)
+{
+    p[0] = (unsigned char)(value >> 8);
+    p[1] = (unsigned char)value;
+}
+
+void UdpFrameCapture::WriteRecord(const Slot &slot)
+{
+    uint32_t originalLength = c_nHeaderBytes + slot.originalBytes;
+    uint32_t capturedLength = c_nHeaderBytes + slot.capturedBytes;
+    if (m_settings.rotateBytes && m_fileBytes > 24 && m_fileBytes + 16 + capturedLength > m_settings.rotateBytes) {
+        CloseFile();
+        unsigned int index = m_fileIndex + 1;
+        if (m_settings.rotateFiles && index >= m_settings.rotateFiles) {
+            index = 0;
+        }
+        std::string error;
+        if (!OpenFile(index, error)) {
+            return; // the rest of the capture is lost
+        }
+    }
+    if (m_file == NULL) {
+        return;
+    }
+
+    uint32_t record[4];
+    record[0] = slot.seconds;
+    record[1] = slot.microseconds;
+    record[2] = capturedLength;
+    record[3] = originalLength;
+
+    // 10.0.0.1 sending to 10.0.0.2
+    unsigned char headers[c_nHeaderBytes];
+    memset(headers, 0, sizeof(headers));
+    headers[0] = 0x45;
+    PutBigEndian16(headers + 2, (uint16_t)(originalLength > 65535 ? 65535 : originalLength));
+    PutBigEndian16(headers + 4, m_ipId++);
+    headers[8] = 64;    // TTL
+    headers[9] = 17;    // UDP
+    headers[12] = 10;
+    headers[15] = 1;
+    headers[16] = 10;
+    headers[19] = 2;
+    uint32_t checksum = 0;
+    for (int i = 0; i < 20; i += 2) {
+        checksum += (headers[i] << 8) | headers[i + 1];
+    }
+    while (checksum >> 16) {
+        checksum = (checksum & 0xffff) + (checksum >> 16);
+    }
+    PutBigEndian16(headers + 10, (uint16_t)~checksum);
+    PutBigEndian16(headers + 20, slot.port);
+    PutBigEndian16(headers + 22, slot.port);
+    PutBigEndian16(headers + 24, (uint16_t)(8 + slot.originalBytes > 65535 ? 65535 : 8 + slot.originalBytes));
+    // UDP checksum left at 0, which means none over IPv4
+
+    fwrite(record, sizeof(record), 1, m_file);
+    fwrite(headers, sizeof(headers), 1, m_file);
+    fwrite(slot.data, 1, slot.capturedBytes, m_file);
+    uint64_t written = sizeof(record) + capturedLength;
+    m_fileBytes += written;
+    m_bytesWritten += written;
+    m_captured++;
+}
+
+void UdpFrameCapture::WriterThread()
+{
+    for (;;) {
+        bool stopping = m_stopRequested.load(std::memory_order_acquire);
+        bool wrote = false;
+        for (;;) {
+            Slot &slot = m_slots[m_dequeuePosition & m_mask];
+            if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1) {
+                break; // empty, or the producer is still copying
+            }
+            WriteRecord(slot);
+            slot.sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+            ++m_dequeuePosition;
+            wrote = true;
+        }
+        if (stopping) {
+            // Stop() waited for the producers before asking, so the ring was complete
+            break;
+        }
+        if (wrote && m_file) {
+            fflush(m_file);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (m_file) {
+        fflush(m_file);
+    }
+}
+
+void UdpFrameCapture::GetStats(Stats &stats) const
+{
+    stats.captured = m_captured.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.skipped = m_skipped.load(std::memory_order_relaxed);
+    stats.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+    stats.files = m_files.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_fileNameMutex);
+    stats.currentFile = m_currentFile;
+}
@@ -0,0 +1,123 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdint.h>
+#include <stdio.h>
+#include "VxcTypes.h"
+
+// Capture of the UDP payloads the SDK sends, fed by the UDP frame callbacks, to a pcap
+// file Wireshark can open without being installed on the machine running the SDK.
+//
+// Capture() copies the payload into a slot of a bounded ring shared by the sending
+// threads and returns; it takes no lock and never waits. When the ring is full the frame
+// is dropped and counted. A writer thread empties the ring and does all the file I/O.
+//
+// The SDK does not tell the callbacks where a frame goes, so each record gets made up
+// IPv4 and UDP headers (LINKTYPE_RAW): SIP frames use port 5060, which Wireshark
+// dissects as SIP, RTP port 6000 and RTCP port 6001. Enable the rtp_udp heuristic
+// or use Decode As to see the RTP and RTCP ones. The test header and trailer, if any,
+// are not part of the capture.
+class UdpFrameCapture
+{
+public:
+    static UdpFrameCapture &GetInstance() { return s_Instance; }
+
+    UdpFrameCapture();
+    ~UdpFrameCapture();
+
+    struct Settings {
+        Settings() : snapLength(65535), rotateBytes(0), rotateFiles(0), sampleEvery(1), ringSlots(1024) {}
+        std::string path;
+        unsigned int snapLength;    // most bytes kept of each packet, synthesized headers included
+        uint64_t rotateBytes;       // starts a new file past this size, 0 for a single file
+        unsigned int rotateFiles;   // files kept when rotating, the oldest is overwritten; 0 for no limit
+        unsigned int sampleEvery;   // captures one frame in this many
+        unsigned int ringSlots;     // rounded up to a power of 2
+    };
+
+    // Returns false with error set if the first file cannot be created or a capture is running
+    bool Start(const Settings &settings, std::string &error);
+    // Writes what is left in the ring and closes the file
+    void Stop();
+    bool IsRunning() const { return m_running.load(std::memory_order_relaxed); }
+
+    // Called on the sending threads
+    void Capture(vx_udp_frame_type type, const void *payload, int payloadBytes);
+
+    struct Stats {
+        uint64_t captured;          // written to a file
+        uint64_t dropped;           // the ring was full
+        uint64_t skipped;           // left out by sampling
+        uint64_t bytesWritten;
+        unsigned int files;
+        std::string currentFile;
+    };
+    void GetStats(Stats &stats) const;
+
+private:
+    UdpFrameCapture(const UdpFrameCapture &); // disabled
+
+    static const unsigned int c_nHeaderBytes = 28; // IPv4 and UDP
+
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        uint32_t seconds;
+        uint32_t microseconds;
+        uint32_t originalBytes;     // payload
+        uint32_t capturedBytes;
+        uint16_t port;
+        unsigned char *data;
+    };
+
+    void WriterThread();
+    bool OpenFile(unsigned int index, std::string &error);
+    void CloseFile();
+    void WriteRecord(const Slot &slot);
+    std::string FileName(unsigned int index) const;
+
+    Settings m_settings;
+    Slot *m_slots;
+    unsigned char *m_data;
+    uint64_t m_mask;
+    std::atomic<uint64_t> m_enqueuePosition;
+    uint64_t m_dequeuePosition;
+
+    std::atomic<bool> m_running;
+    std::atomic<int> m_producers;       // Capture() calls in progress
+    std::atomic<bool> m_stopRequested;
+    std::thread m_writerThread;
+    std::mutex m_controlMutex;          // Start() and Stop()
+
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_skipped;
+    std::atomic<uint64_t> m_captured;
+    std::atomic<uint64_t> m_bytesWritten;
+    std::atomic<unsigned int> m_files;
+
+    FILE *m_file;
+    uint64_t m_fileBytes;
+    unsigned int m_fileIndex;
+    uint16_t m_ipId;
+    mutable std::mutex m_fileNameMutex;
+    std::string m_currentFile;
+
+    static UdpFrameCapture s_Instance;
+};
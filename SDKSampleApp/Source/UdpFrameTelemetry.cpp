@@ -0,0 +1,178 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "UdpFrameTelemetry.h"
+#include "vxplatform/vxcplatform.h"
+
+using namespace vxplatform;
+
+UdpFrameTelemetry UdpFrameTelemetry::s_Instance;
+
+UdpFrameTelemetry::UdpFrameTelemetry()
+{
+    m_startMilliseconds = get_millisecond_tick_counter();
+    for (int type = 0; type < c_nFrameTypes; ++type) {
+        TypeCounters &counters = m_counters[type];
+        for (int i = 0; i < c_nWindows; ++i) {
+            counters.windows[i].second = -1;
+            counters.windows[i].packets = 0;
+            counters.windows[i].bytes = 0;
+        }
+    }
+    Reset();
+}
+
+int UdpFrameTelemetry::SizeBucket(int payloadBytes)
+{
+    int bucket = 0;
+    while (bucket < c_nSizeBuckets - 1 && payloadBytes > GetSizeBucketLimit(bucket)) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+int UdpFrameTelemetry::GetSizeBucketLimit(int bucket)
+{
+    // 32, 64, ... 2048, then everything larger
+    return bucket < c_nSizeBuckets - 1 ? 32 << bucket : 0;
+}
+
+const char *UdpFrameTelemetry::GetTypeName(vx_udp_frame_type type)
+{
+    switch (type) {
+        case vx_frame_type_rtp:
+            return "rtp";
+        case vx_frame_type_rtcp:
+            return "rtcp";
+        case vx_frame_type_sip_message:
+            return "sip";
+        case vx_frame_type_sip_keepalive:
+            return "keepalive";
+        default:
+            return "unknown";
+    }
+}
+
+int64_t UdpFrameTelemetry::CurrentSecond() const
+{
+    return (int64_t)((get_millisecond_tick_counter() - m_startMilliseconds) / 1000);
+}
+
+void UdpFrameTelemetry::AtomicMax(std::atomic<uint64_t> &value, uint64_t candidate)
+{
+    uint64_t current = value.load(std::memory_order_relaxed);
+    while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+    }
+}
+
+// Called by the first packet of a second, before it is counted
+void UdpFrameTelemetry::OpenWindow(TypeCounters &counters, int64_t second)
+{
+    int64_t last = counters.lastSecond.load(std::memory_order_relaxed);
+    if (last >= second || !counters.lastSecond.compare_exchange_strong(last, second, std::memory_order_relaxed)) {
+        return; // another thread got there first
+    }
+    Window &window = counters.windows[second & (c_nWindows - 1)];
+    uint64_t packets = counters.packets.load(std::memory_order_relaxed);
+    uint64_t bytes = counters.bytes.load(std::memory_order_relaxed);
+    window.second.store(-1, std::memory_order_relaxed);
+    window.packets.store(packets, std::memory_order_relaxed);
+    window.bytes.store(bytes, std::memory_order_relaxed);
+    window.second.store(second, std::memory_order_release);
+
+    // The previous second is complete if it had a window of its own
+    const Window &previous = counters.windows[(second - 1) & (c_nWindows - 1)];
+    if (last == second - 1 && previous.second.load(std::memory_order_acquire) == second - 1) {
+        AtomicMax(counters.peakPackets, packets - previous.packets.load(std::memory_order_relaxed));
+        AtomicMax(counters.peakBytes, bytes - previous.bytes.load(std::memory_order_relaxed));
+    }
+}
+
+void UdpFrameTelemetry::Record(vx_udp_frame_type type, int payloadBytes, int sentBytes)
+{
+    if ((int)type < 0 || (int)type >= c_nFrameTypes) {
+        return;
+    }
+    TypeCounters &counters = m_counters[type];
+    int64_t second = CurrentSecond();
+    if (second > counters.lastSecond.load(std::memory_order_relaxed)) {
+        OpenWindow(counters, second);
+    }
+    if (sentBytes < 0) {
+        counters.errors.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    counters.packets.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add((uint64_t)sentBytes, std::memory_order_relaxed);
+    counters.payloadBytes.fetch_add((uint64_t)(payloadBytes > 0 ? payloadBytes : 0), std::memory_order_relaxed);
+    counters.sizeHistogram[SizeBucket(payloadBytes)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void UdpFrameTelemetry::GetStats(vx_udp_frame_type type, TypeStats &stats) const
+{
+    memset(&stats, 0, sizeof(stats));
+    if ((int)type < 0 || (int)type >= c_nFrameTypes) {
+        return;
+    }
+    const TypeCounters &counters = m_counters[type];
+    stats.packets = counters.packets.load(std::memory_order_relaxed);
+    stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+    stats.payloadBytes = counters.payloadBytes.load(std::memory_order_relaxed);
+    stats.errors = counters.errors.load(std::memory_order_relaxed);
+    for (int i = 0; i < c_nSizeBuckets; ++i) {
+        stats.sizeHistogram[i] = counters.sizeHistogram[i].load(std::memory_order_relaxed);
+    }
+    stats.peakPacketsPerSecond = counters.peakPackets.load(std::memory_order_relaxed);
+    stats.peakBytesPerSecond = counters.peakBytes.load(std::memory_order_relaxed);
+
+    // A second without a window had no packet: its totals are those of the next window,
+    // or the current ones if there is none yet
+    int64_t second = CurrentSecond();
+    const Window &current = counters.windows[second & (c_nWindows - 1)];
+    const Window &previous = counters.windows[(second - 1) & (c_nWindows - 1)];
+    uint64_t endPackets = stats.packets;
+    uint64_t endBytes = stats.bytes;
+    if (current.second.load(std::memory_order_acquire) == second) {
+        endPackets = current.packets.load(std::memory_order_relaxed);
+        endBytes = current.bytes.load(std::memory_order_relaxed);
+    }
+    if (previous.second.load(std::memory_order_acquire) == second - 1) {
+        stats.packetsPerSecond = endPackets - previous.packets.load(std::memory_order_relaxed);
+        stats.bytesPerSecond = endBytes - previous.bytes.load(std::memory_order_relaxed);
+    }
+}
+
+// Not atomic as a whole: packets sent meanwhile may be partly counted
+void UdpFrameTelemetry::Reset()
+{
+    for (int type = 0; type < c_nFrameTypes; ++type) {
+        TypeCounters &counters = m_counters[type];
+        counters.lastSecond = -1;
+        for (int i = 0; i < c_nWindows; ++i) {
+            counters.windows[i].second = -1;
+        }
+        counters.packets = 0;
+        counters.bytes = 0;
+        counters.payloadBytes = 0;
+        counters.errors = 0;
+        for (int i = 0; i < c_nSizeBuckets; ++i) {
+            counters.sizeHistogram[i] = 0;
+        }
+        counters.peakPackets = 0;
+        counters.peakBytes = 0;
+    }
+}
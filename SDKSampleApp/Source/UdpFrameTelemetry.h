@@ -0,0 +1,93 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "VxcTypes.h"
+
+// Counters of the UDP packets the SDK sends, fed by the UDP frame callbacks, per
+// vx_udp_frame_type: packets, bytes on the wire, a histogram of the payload sizes and the
+// packets the SDK failed to send.
+//
+// Every counter is an atomic updated without a lock, so recording costs a few atomic
+// additions on the sending thread. Rates are measured over whole seconds: the first
+// packet of each second stores the totals reached so far in a small ring of windows, and
+// the rate of the last complete second is the difference between two of them.
+class UdpFrameTelemetry
+{
+public:
+    static const int c_nFrameTypes = vx_frame_type_sip_keepalive + 1;
+    static const int c_nSizeBuckets = 8;
+
+    static UdpFrameTelemetry &GetInstance() { return s_Instance; }
+
+    UdpFrameTelemetry();
+
+    // payloadBytes excludes the header and trailer, sentBytes is what the send returned (< 0 on error)
+    void Record(vx_udp_frame_type type, int payloadBytes, int sentBytes);
+
+    struct TypeStats {
+        uint64_t packets;
+        uint64_t bytes;             // sent, headers and trailers included
+        uint64_t payloadBytes;
+        uint64_t errors;
+        uint64_t sizeHistogram[c_nSizeBuckets];
+        uint64_t packetsPerSecond;  // during the last complete second
+        uint64_t bytesPerSecond;
+        uint64_t peakPacketsPerSecond;
+        uint64_t peakBytesPerSecond;
+    };
+    void GetStats(vx_udp_frame_type type, TypeStats &stats) const;
+    void Reset();
+
+    static const char *GetTypeName(vx_udp_frame_type type);
+    // Largest payload counted in a bucket, 0 for the last one which has no limit
+    static int GetSizeBucketLimit(int bucket);
+
+private:
+    UdpFrameTelemetry(const UdpFrameTelemetry &); // disabled
+
+    static const int c_nWindows = 4;    // power of 2
+
+    struct Window {
+        std::atomic<int64_t> second;    // -1 while unused
+        std::atomic<uint64_t> packets;  // totals when the second started
+        std::atomic<uint64_t> bytes;
+    };
+
+    struct TypeCounters {
+        std::atomic<uint64_t> packets;
+        std::atomic<uint64_t> bytes;
+        std::atomic<uint64_t> payloadBytes;
+        std::atomic<uint64_t> errors;
+        std::atomic<uint64_t> sizeHistogram[c_nSizeBuckets];
+        std::atomic<int64_t> lastSecond;
+        Window windows[c_nWindows];
+        std::atomic<uint64_t> peakPackets;
+        std::atomic<uint64_t> peakBytes;
+    };
+
+    static int SizeBucket(int payloadBytes);
+    int64_t CurrentSecond() const;
+    void OpenWindow(TypeCounters &counters, int64_t second);
+    static void AtomicMax(std::atomic<uint64_t> &value, uint64_t candidate);
+
+    double m_startMilliseconds;
+    TypeCounters m_counters[c_nFrameTypes];
+
+    static UdpFrameTelemetry s_Instance;
+};
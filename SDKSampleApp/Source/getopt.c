@@ -247,7 +247,7 @@ getopt_internal(
             match_chars = (possible_arg - argv[optind]) - optwhere;
         }
         for (optindex = 0; longopts[optindex].name != NULL; optindex++) {
-            if (memcmp(
+            if (strncmp(
                     argv[optind] + optwhere,
                     longopts[optindex].name,
                     match_chars) == 0)
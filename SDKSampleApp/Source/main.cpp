@@ -26,7 +26,11 @@
 #include <stdio.h>
 
 #include <codecvt>
+#ifdef _WIN32
 #define VIVOX_USE_SDK_BROWSER 1
+#else
+#define VIVOX_USE_SDK_BROWSER 0
+#endif
 
 #include "SDKSampleApp.h"
 #include "getopt.h"
@@ -34,10 +38,15 @@
 #include "vxplatform/vxcplatform.h"
 #include <VxcRequests.h>
 
-#include <windows.h>
 #include "TestUDPFrameCallbacks.h"
+#ifdef _WIN32
+#include <windows.h>
 #include <io.h>    // for _setmode
 #include <fcntl.h> // for _O_U16TEXT
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 #include <string.h>
 #include <stdarg.h>
@@ -50,8 +59,10 @@
 
 #include "ParanoidAllocator.h"
 
+#ifdef _WIN32
 #define snprintf _snprintf
 #define sscanf sscanf_s
+#endif
 
 using namespace std;
 
@@ -63,7 +74,26 @@ using namespace std;
 
 static void GenericSleepMilliSeconds(int ms)
 {
+#ifdef _WIN32
     Sleep((DWORD)ms);
+#else
+    usleep((useconds_t)ms * 1000);
+#endif
+}
+
+// Reads a line of the console as UTF-8, returns false at the end of the input
+static bool ReadConsoleLine(std::string &line)
+{
+#ifdef _WIN32
+    std::wstring wideLine;
+    std::getline(std::wcin, wideLine);
+    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converterX;
+    line = converterX.to_bytes(wideLine);
+    return !std::wcin.eof();
+#else
+    std::getline(std::cin, line);
+    return !std::cin.eof();
+#endif
 }
 
 // for running on systems without pty drivers.
@@ -162,6 +192,8 @@ void OnLog(void *callback_handle, vx_log_level level, const char *source, const
         struct tm *ptm = nullptr;
 #if defined(__STDC_LIB_EXT1__)
         ptm = gmtime_s(&currentTime, &tmCurrent);
+#elif !defined(_WIN32)
+        ptm = gmtime_r(&currentTime, &tmCurrent);
 #else
         // return errno_t = 0 indicates success
         ptm = gmtime_s(&tmCurrent, &currentTime) ? nullptr : &tmCurrent;
@@ -228,6 +260,12 @@ int usage()
 #endif
     SDKSampleApp::con_print("  -p, --affinity=MASK   processor affinity mask (platform specific)\n");
     SDKSampleApp::con_print("  -a, --pooledalloc     use SDK internal pooled alloc instead of ParanoidAllocator\n");
+    SDKSampleApp::con_print("  -P, --paranoid=MODE   ParanoidAllocator mode: strict (default), sharded, lower overhead for load tests,\n");
+    SDKSampleApp::con_print("                        or sampling, no checks but an allocation site profile (see 'allocprofile')\n");
+    SDKSampleApp::con_print("  -H, --heapscan=PCT    check the ParanoidAllocator heap in the background, using up to PCT percent of the time\n");
+    SDKSampleApp::con_print("  -S, --scenario=FILE   run the scenario in FILE (see 'help scenario'), print its report and exit\n");
+    SDKSampleApp::con_print("  -L, --loadgen=OPTIONS connect, run 'loadgen -start OPTIONS' to the end, print its report and exit\n");
+    SDKSampleApp::con_print("                        e.g. --loadgen=\"-accounts 50 -ramp 10 -s 120\"\n");
     SDKSampleApp::con_print("\n");
     SDKSampleApp::con_print("Options for server, realm, issuer, and key are required but may be given in any order.\n");
 
@@ -404,8 +442,49 @@ static vx_sdk_config_t MakeConfig(const SDKSampleApp &app, unsigned int default_
     return config;
 }
 
+static void RunCommand(SDKSampleApp &app, const std::string &line)
+{
+    app.con_print("%s\n", line.c_str());
+    app.Lock();
+    app.ProcessCommand(SDKSampleApp::splitCmdLine(line));
+    app.Unlock();
+}
+
+static void RunLoadGenerator(SDKSampleApp &app, const std::string &options)
+{
+    RunCommand(app, "log -requests no -responses no");
+    RunCommand(app, "connect");
+    for (int waited = 0; !app.IsConnected(); waited += 100)
+    {
+        if (waited >= 30000)
+        {
+            app.con_print("Error: not connected after 30 seconds, not starting the load generator\n");
+            return;
+        }
+        GenericSleepMilliSeconds(100);
+    }
+    RunCommand(app, "loadgen -start -wait " + options);
+}
+
+static void RunScenario(SDKSampleApp &app, const std::string &file)
+{
+    // Not through splitCmdLine(), which would take the backslashes of a path for escapes
+    std::vector<std::string> cmd;
+    cmd.push_back("scenario");
+    cmd.push_back("-run");
+    cmd.push_back(file);
+    app.Lock();
+    app.ProcessCommand(cmd);
+    app.Unlock();
+    while (!app.GetScenarioEngine().Wait(1000))
+    {
+    }
+    RunCommand(app, "scenario");
+}
+
 int main_proc(int argc, char *argv[], string cmdList[])
 {
+#ifdef _WIN32
     UINT consoleOutputCP = GetConsoleOutputCP();
     if (consoleOutputCP != CP_UTF8)
     {
@@ -418,6 +497,10 @@ int main_proc(int argc, char *argv[], string cmdList[])
     }
     _setmode(_fileno(stdin), _O_U16TEXT);
     _setmode(_fileno(stdout), _O_U16TEXT);
+#else
+    // A telnet console client going away must not end the process
+    signal(SIGPIPE, SIG_IGN);
+#endif
 
     ParanoidAllocator::GetInstance().SetOutputFunction(&SDKSampleApp::con_print);
 
@@ -436,6 +519,9 @@ int main_proc(int argc, char *argv[], string cmdList[])
     unsigned short tcp_control_port = 0;
     long long processor_affinity_mask = 0;
     bool useParanoidAllocator = true;
+    unsigned int heapScanBudget = 0;
+    std::string loadgen_options;
+    std::string scenario_file;
 
     app.con_print("%s", SDKSampleApp::getVersionAndCopyrightText().c_str());
 
@@ -464,6 +550,10 @@ int main_proc(int argc, char *argv[], string cmdList[])
 #endif
             {"affinity", REQUIRED_ARG, 0, 'p'},
             {"pooledalloc", NO_ARG, 0, 'a'},
+            {"paranoid", REQUIRED_ARG, 0, 'P'},
+            {"heapscan", REQUIRED_ARG, 0, 'H'},
+            {"loadgen", REQUIRED_ARG, 0, 'L'},
+            {"scenario", REQUIRED_ARG, 0, 'S'},
             {0, 0, 0, 0}
         };
         /* getopt_long stores the option index here. */
@@ -476,7 +566,7 @@ int main_proc(int argc, char *argv[], string cmdList[])
 #if VIVOX_USE_SDK_BROWSER
             "b"
 #endif
-            "p:a",
+            "p:aP:H:L:S:",
             long_options,
             &option_index);
 
@@ -605,6 +695,42 @@ int main_proc(int argc, char *argv[], string cmdList[])
             useParanoidAllocator = false;
             break;
         }
+        case 'P':
+        {
+            ParanoidAllocator::Mode mode;
+            if (!ParanoidAllocator::ParseMode(optarg, mode))
+            {
+                app.con_print("Error: strict, sharded or sampling expected for --paranoid option, got %s\n", optarg);
+                return 1;
+            }
+            if (!ParanoidAllocator::GetInstance().SetMode(mode))
+            {
+                app.con_print("Error: cannot switch the allocator to %s mode, it is already in use\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'H':
+        {
+            unsigned int budget;
+            if (1 != sscanf(optarg, "%u", &budget) || budget > 100)
+            {
+                app.con_print("Error: percentage expected for --heapscan option, got %s\n", optarg);
+                return 1;
+            }
+            heapScanBudget = budget;
+            break;
+        }
+        case 'L':
+        {
+            loadgen_options = optarg;
+            break;
+        }
+        case 'S':
+        {
+            scenario_file = optarg;
+            break;
+        }
         case 'h':
         default:
         {
@@ -658,6 +784,7 @@ int main_proc(int argc, char *argv[], string cmdList[])
     if (useParanoidAllocator)
     {
         ParanoidAllocator::ConfigureHooksIfRequired(config);
+        ParanoidAllocator::GetInstance().SetScanBudget(heapScanBudget);
     }
 
     std::string codecsInfo = GetCodecsInfoString(config.default_codecs_mask);
@@ -673,10 +800,11 @@ int main_proc(int argc, char *argv[], string cmdList[])
 
 #if VIVOX_USE_SDK_BROWSER
     SDKBrowserWin *pBrowser = NULL;
+    SDKMessageBus::SubscriptionId browserSubscription = 0;
     if (show_sdk_browser)
     {
         pBrowser = new SDKBrowserWin;
-        app.SetMessageObserver(pBrowser);
+        browserSubscription = app.GetMessageBus().Subscribe(pBrowser, SDKBrowser::GetMessageInterest(), SDKMessageBus::deliverSync, 0, "sdk browser");
     }
 #endif
 
@@ -716,11 +844,24 @@ int main_proc(int argc, char *argv[], string cmdList[])
         }
     }
 
+    if (!scenario_file.empty())
+    {
+        RunScenario(app, scenario_file);
+        g_exit = true;
+    }
+    if (!loadgen_options.empty())
+    {
+        // Load run without a console: skip the input loop entirely
+        RunLoadGenerator(app, loadgen_options);
+        g_exit = true;
+    }
+
     // Begin main input loop
     const char *prompt = "[SDKSampleApp]: ";
     setbuf(stdout, NULL);
 
     int cmdIdx = 0;
+    bool inputEnded = false;
 
     while (!g_exit)
     {
@@ -741,20 +882,18 @@ int main_proc(int argc, char *argv[], string cmdList[])
             vxplatform::wait_event(*(app.ListenerEventLink()));
             if (cmdIdx < 3) {
                 tmpLine = cmdList[cmdIdx];
-                app.con_print("%s", tmpLine);
+                app.con_print("%s", tmpLine.c_str());
                 cmdIdx++;
             }
             else {
-                std::wstring line;
-                std::getline(std::wcin, line);
-                std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converterX;
-                tmpLine = converterX.to_bytes(line);
+                inputEnded = !ReadConsoleLine(tmpLine);
             }
 
             vxplatform::delete_event(*(app.ListenerEventLink()));
+            *(app.ListenerEventLink()) = NULL;
 
             tmpLine = handleSpecialCharacters(tmpLine);
-            if (std::wcin.eof())
+            if (inputEnded)
             {
                 break;
             }
@@ -846,8 +985,8 @@ int main_proc(int argc, char *argv[], string cmdList[])
         else if (cmd[0] == "pause")
         {
             // wait for a return
-            std::wstring line;
-            std::getline(std::wcin, line);
+            std::string line;
+            ReadConsoleLine(line);
 
             continue;
         }
@@ -862,9 +1001,9 @@ int main_proc(int argc, char *argv[], string cmdList[])
     }
 
 #if VIVOX_USE_SDK_BROWSER
-    app.SetMessageObserver(NULL);
     if (pBrowser)
     {
+        app.GetMessageBus().Unsubscribe(browserSubscription);
         delete pBrowser;
         pBrowser = NULL;
     }
@@ -884,6 +1023,7 @@ int main_proc(int argc, char *argv[], string cmdList[])
 
     app.con_print("Shutdown complete.\n");
 
+#ifdef _WIN32
     if (consoleOutputCP != CP_UTF8)
     {
         SetConsoleOutputCP(consoleOutputCP);
@@ -892,6 +1032,7 @@ int main_proc(int argc, char *argv[], string cmdList[])
     {
         SetConsoleCP(consoleCP);
     }
+#endif
 
     return 0;
 }
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+# Copyright (c) 2013-2018 by Mercer Road Corp
+#
+# Permission to use, copy, modify or distribute this software in binary or source form
+# for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+# ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+# BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+# DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+# PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+# ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+# SOFTWARE.
+
+"""Measures how long SDK messages wait for the SDKSampleApp listener thread while commands run.
+
+Connects to the TCP console of a running SDKSampleApp (see its --tcpport option) and runs
+rounds of two phases:
+
+  idle  a burst of commands that each issue a request, then nothing until the responses are in
+  busy  the same burst, then a slow command, so the responses arrive while it holds the
+        application lock
+
+After each round the app's 'listenerstats -reset' reports the latency of the messages handled,
+measured from the SDK signalling them. The listener does not wait for commands, so the busy
+numbers should stay close to the idle ones rather than grow to the length of the slow command.
+
+Example, with the app connected and logged in:
+    listener_stress.py --rounds 5 --burst 50 --slow "allocbench -n 2000000"
+"""
+
+import argparse
+import re
+import socket
+import sys
+import time
+
+PROMPT = b"[SDKSampleApp]: \x00"  # the console sends the terminating NUL, con_print does not
+STATS = re.compile(
+    r"listenerstats: (\d+) message\(s\), mean ([\d.]+) ms, p50 ([\d.]+) ms, p90 ([\d.]+) ms, "
+    r"p99 ([\d.]+) ms, max ([\d.]+) ms")
+
+
+class Console:
+    def __init__(self, host, port, timeout):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.pending = b""
+        self.read_prompt()
+
+    def read_prompt(self):
+        while PROMPT not in self.pending:
+            data = self.sock.recv(65536)
+            if not data:
+                raise ConnectionError("the SDKSampleApp console closed the connection")
+            self.pending += data
+        output, _, self.pending = self.pending.partition(PROMPT)
+        return output.decode("utf-8", "replace")
+
+    def run(self, command):
+        self.sock.sendall(command.encode("utf-8") + b"\n")
+        return self.read_prompt()
+
+    def close(self):
+        self.sock.close()
+
+
+def listener_stats(console, reset=True):
+    output = console.run("listenerstats -reset" if reset else "listenerstats")
+    match = STATS.search(output)
+    if not match:
+        raise RuntimeError("unexpected listenerstats output: %r" % output)
+    count = int(match.group(1))
+    return count, [float(v) for v in match.groups()[1:]]
+
+
+def run_phase(console, args, busy):
+    for _ in range(args.burst):
+        console.run(args.load)
+    started = time.time()
+    if busy:
+        console.run(args.slow)
+    command_seconds = time.time() - started
+    time.sleep(args.settle)
+    count, values = listener_stats(console)
+    return count, values, command_seconds
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=9876)
+    parser.add_argument("--setup", action="append", default=[], metavar="COMMAND",
+                        help="command to run first, may be repeated, e.g. --setup connect --setup \"login -u .user.\"")
+    parser.add_argument("--quiet", action="store_true", help="turn off request and response logging first")
+    parser.add_argument("--rounds", type=int, default=5)
+    parser.add_argument("--burst", type=int, default=50, help="load commands sent each phase")
+    parser.add_argument("--load", default="renderdevice -get", help="command issuing a request, run --burst times")
+    parser.add_argument("--slow", default="allocbench -n 2000000", help="command that runs while the responses arrive")
+    parser.add_argument("--settle", type=float, default=1.0, help="seconds to wait for the responses")
+    parser.add_argument("--timeout", type=float, default=120.0)
+    args = parser.parse_args()
+
+    console = Console(args.host, args.port, args.timeout)
+    try:
+        for command in args.setup:
+            sys.stdout.write(console.run(command))
+        if args.quiet:
+            console.run("log -requests no -responses no")
+        listener_stats(console)
+
+        print("%-5s %5s %8s %10s %10s %10s %10s %10s %10s" %
+              ("phase", "round", "messages", "command s", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms"))
+        worst = {"idle": 0.0, "busy": 0.0}
+        for round_index in range(1, args.rounds + 1):
+            for phase in ("idle", "busy"):
+                count, values, command_seconds = run_phase(console, args, phase == "busy")
+                mean, p50, p90, p99, maximum = values
+                worst[phase] = max(worst[phase], p99)
+                print("%-5s %5d %8d %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f" %
+                      (phase, round_index, count, command_seconds, mean, p50, p90, p99, maximum))
+        print("worst p99: idle %.3f ms, busy %.3f ms" % (worst["idle"], worst["busy"]))
+    finally:
+        console.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
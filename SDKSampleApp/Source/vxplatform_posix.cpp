@@ -0,0 +1,353 @@
+/* (c) Copyright 2007-2018 Mercer Road Corp. All rights reserved.
+ * Mercer Road Corp. hereby grants you ("User"), under its copyright rights, the right to distribute,
+ * reproduce and/or prepare derivative works of this software source (or binary) code ("Software")
+ * solely to the extent expressly authorized in writing by Mercer Road Corp.  If you do not have a written
+ * license from Mercer Road Corp., you have no right to use the Software except for internal testing and review.
+ *
+ * No other rights are granted and no other use is authorized. The availability of the Software does not provide
+ * any license by implication, estoppel, or otherwise under any patent rights or other rights owned or
+ * controlled by Mercer Road or others covering any use of the Software herein.
+ *
+ * USER AGREES THAT MERCER ROAD ASSUMES NO LIABILITY FOR ANY DAMAGES, WHETHER DIRECT OR OTHERWISE,
+ * WHICH THE USER MAY SUFFER DUE TO USER'S USE OF THE SOFTWARE.  MERCER ROAD PROVIDES THE SOFTWARE "AS IS,"
+ * MAKES NO EXPRESS OR IMPLIED REPRESENTATIONS OR WARRANTIES OF ANY TYPE, AND EXPRESSLY DISCLAIMS THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT.
+ * USER ACKNOWLEDGES THAT IT ASSUMES TOTAL RESPONSIBILITY AND RISK FOR USER'S USE OF THE SOFTWARE.
+ *
+ * Except for any written authorization, license or agreement from or with Mercer Road Corp.
+ * the foregoing terms and conditions shall constitute the entire agreement between User and Mercer Road Corp.
+ * with respect to the subject matter hereof and shall not be modified or superceded
+ * without the express written authorization of Mercer Road Corp.
+ *
+ * Any copies or derivative works must include this and all other proprietary notices contained on or in the Software as received by the User.
+ */
+
+// The Linux implementation of vxplatform. Events are a futex word each, and the tick
+// counters read CLOCK_MONOTONIC.
+
+#include "vxplatform/vxcplatform.h"
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include <atomic>
+#include <string>
+#include <mutex>
+
+namespace vxplatform {
+static std::string string_vformat(const char *fmt, va_list ap)
+{
+    std::string result;
+    char tmp = '\0';
+    int size = 0;
+    va_list ap2;
+    va_copy(ap2, ap);
+    size = vsnprintf(&tmp, 0, fmt, ap2);
+    va_end(ap2);
+
+    if (size < 0) {
+        return result;
+    }
+
+    char *dest = new char[size + 1];
+
+    if (NULL == dest) {
+        return result;
+    }
+
+    size = vsnprintf(dest, size + 1, fmt, ap);
+
+    if (size >= 0) {
+        dest[size] = '\0';
+        result.assign(dest, size);
+    }
+
+    delete[] dest;
+    dest = NULL;
+    return result;
+}
+
+/* static */
+std::string string_format(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    std::string s = string_vformat(fmt, ap);
+    va_end(ap);
+    return s;
+}
+
+static long futex(std::atomic<int> *word, int op, int value, const struct timespec *timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<int *>(word), op | FUTEX_PRIVATE_FLAG, value, timeout, NULL, 0);
+}
+
+// An auto reset event, as CreateEvent(NULL, FALSE, FALSE, NULL) makes on Windows: set_event()
+// releases one waiter, or the next one to wait if there is none. The waiters count spares
+// set_event() the system call when nobody is waiting.
+class FutexEvent
+{
+public:
+    FutexEvent() :
+        m_signalled(0),
+        m_waiters(0)
+    {
+    }
+
+    void Set()
+    {
+        if (m_signalled.exchange(1) == 0 && m_waiters.load() > 0) {
+            futex(&m_signalled, FUTEX_WAKE, 1, NULL);
+        }
+    }
+
+    // Returns false on timeout
+    bool Wait(int timeout)
+    {
+        unsigned long long deadline = timeout < 0 ? 0 : get_nanosecond_tick_counter() + (unsigned long long)timeout * 1000000;
+        for (;;) {
+            int expected = 1;
+            if (m_signalled.compare_exchange_strong(expected, 0)) {
+                return true;
+            }
+            struct timespec remaining;
+            struct timespec *pRemaining = NULL;
+            if (timeout >= 0) {
+                unsigned long long now = get_nanosecond_tick_counter();
+                if (now >= deadline) {
+                    return false;
+                }
+                remaining.tv_sec = (time_t)((deadline - now) / 1000000000);
+                remaining.tv_nsec = (long)((deadline - now) % 1000000000);
+                pRemaining = &remaining;
+            }
+            // Sleeps only while the event is still clear, so a Set() in between is not lost
+            m_waiters.fetch_add(1);
+            futex(&m_signalled, FUTEX_WAIT, 0, pRemaining);
+            m_waiters.fetch_sub(1);
+        }
+    }
+
+private:
+    std::atomic<int> m_signalled;
+    std::atomic<int> m_waiters;
+};
+
+// Shared by the thread and its handle, and freed by whichever lets go of it last
+class PosixThread
+{
+public:
+    PosixThread(thread_start_function_t pf, void *pArg) :
+        m_func(pf),
+        m_pArg(pArg),
+        m_finished(0),
+        m_joined(false),
+        m_refs(2)
+    {
+    }
+
+    void Release()
+    {
+        if (m_refs.fetch_sub(1) == 1) {
+            delete this;
+        }
+    }
+
+    static void *OnThreadStart(void *pArg)
+    {
+        PosixThread *pThis = reinterpret_cast<PosixThread *>(pArg);
+        pThis->m_func(pThis->m_pArg);
+        pThis->m_finished.store(1);
+        futex(&pThis->m_finished, FUTEX_WAKE, INT_MAX, NULL);
+        pThis->Release();
+        return NULL;
+    }
+
+    // Returns false on timeout
+    bool WaitFinished(int timeout)
+    {
+        unsigned long long deadline = timeout < 0 ? 0 : get_nanosecond_tick_counter() + (unsigned long long)timeout * 1000000;
+        while (m_finished.load() == 0) {
+            struct timespec remaining;
+            struct timespec *pRemaining = NULL;
+            if (timeout >= 0) {
+                unsigned long long now = get_nanosecond_tick_counter();
+                if (now >= deadline) {
+                    return false;
+                }
+                remaining.tv_sec = (time_t)((deadline - now) / 1000000000);
+                remaining.tv_nsec = (long)((deadline - now) % 1000000000);
+                pRemaining = &remaining;
+            }
+            futex(&m_finished, FUTEX_WAIT, 0, pRemaining);
+        }
+        return true;
+    }
+
+    pthread_t m_thread;
+    thread_start_function_t m_func;
+    void *m_pArg;
+    std::atomic<int> m_finished;
+    bool m_joined;
+
+private:
+    std::atomic<int> m_refs;
+};
+
+os_error_t create_thread(thread_start_function_t pf, void *pArg, os_thread_handle *phThread, os_thread_id *pTid, size_t stacksize, int priority)
+{
+    // MUSTDO: Implement priority
+    (void)priority;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (stacksize != 0) {
+        pthread_attr_setstacksize(&attr, stacksize < (size_t)PTHREAD_STACK_MIN ? (size_t)PTHREAD_STACK_MIN : stacksize);
+    }
+    PosixThread *pThread = new PosixThread(pf, pArg);
+    int err = pthread_create(&pThread->m_thread, &attr, &PosixThread::OnThreadStart, pThread);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        delete pThread;
+        return (os_error_t)err;
+    }
+    *phThread = (os_thread_handle)pThread;
+    *pTid = (os_thread_id)pThread->m_thread;
+    return 0;
+}
+
+os_error_t create_thread(thread_start_function_t pf, void *pArg, os_thread_handle *phThread)
+{
+    os_thread_id tid;
+    return create_thread(pf, pArg, phThread, &tid, 0, 0);
+}
+
+os_error_t create_thread(thread_start_function_t pf, void *pArg, os_thread_handle *phThread, size_t stacksize, int priority)
+{
+    os_thread_id tid;
+    return create_thread(pf, pArg, phThread, &tid, stacksize, priority);
+}
+
+// Lets go of the handle; a thread still running goes on detached
+os_error_t delete_thread(os_thread_handle handle)
+{
+    PosixThread *pThread = reinterpret_cast<PosixThread *>(handle);
+    if (!pThread->m_joined) {
+        pthread_detach(pThread->m_thread);
+    }
+    pThread->Release();
+    return 0;
+}
+
+os_error_t close_thread_handle(os_thread_handle handle)
+{
+    return delete_thread(handle);
+}
+
+os_error_t join_thread(os_thread_handle handle, int timeout)
+{
+    PosixThread *pThread = reinterpret_cast<PosixThread *>(handle);
+    if (!pThread->WaitFinished(timeout)) {
+        // The handle stays valid, as on Windows
+        return OS_E_TIMEOUT;
+    }
+    pthread_join(pThread->m_thread, NULL);
+    pThread->m_joined = true;
+    return delete_thread(handle);
+}
+
+void thread_sleep(unsigned long long ms)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000);
+    ts.tv_nsec = (long)(ms % 1000) * 1000000;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+void set_thread_name(const std::string &threadName)
+{
+    // Linux thread names are 15 characters at most, too few for the "Vivox: " prefix of Windows
+    pthread_setname_np(pthread_self(), threadName.substr(0, 15).c_str());
+}
+
+os_thread_id get_current_thread_id()
+{
+    return (os_thread_id)pthread_self();
+}
+
+os_error_t create_event(os_event_handle *pHandle)
+{
+    *pHandle = (os_event_handle) new FutexEvent;
+    return 0;
+}
+
+os_error_t set_event(os_event_handle handle)
+{
+    if (!handle) {
+        return EINVAL;
+    }
+    reinterpret_cast<FutexEvent *>(handle)->Set();
+    return 0;
+}
+
+os_error_t wait_event(os_event_handle handle, int timeout)
+{
+    if (!reinterpret_cast<FutexEvent *>(handle)->Wait(timeout)) {
+        return OS_E_TIMEOUT;
+    }
+    return 0;
+}
+
+os_error_t delete_event(os_event_handle handle)
+{
+    delete reinterpret_cast<FutexEvent *>(handle);
+    return 0;
+}
+
+double get_millisecond_tick_counter()
+{
+    return (double)(get_nanosecond_tick_counter() / 1000000);
+}
+
+unsigned long long get_nanosecond_tick_counter()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+Lock::Lock()
+{
+    m_pImpl = new std::mutex;
+}
+Lock::~Lock(void)
+{
+    delete (std::mutex *)m_pImpl;
+}
+void Lock::Take()
+{
+    ((std::mutex *)m_pImpl)->lock();
+}
+void Lock::Release()
+{
+    ((std::mutex *)m_pImpl)->unlock();
+}
+
+Locker::Locker(Lock *pLock)
+{
+    m_pLock = pLock;
+    m_pLock->Take();
+}
+Locker::~Locker(void)
+{
+    m_pLock->Release();
+    m_pLock = NULL;
+}
+}
@@ -269,6 +269,20 @@ double get_millisecond_tick_counter()
     return (double)(ul.QuadPart / 10000);
 }
 
+unsigned long long get_nanosecond_tick_counter()
+{
+    static LARGE_INTEGER frequency = { 0 };
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Split so the multiplication does not overflow
+    unsigned long long seconds = (unsigned long long)(counter.QuadPart / frequency.QuadPart);
+    unsigned long long remainder = (unsigned long long)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000000ULL + remainder * 1000000000ULL / (unsigned long long)frequency.QuadPart;
+}
+
 Lock::Lock()
 {
     m_pImpl = new std::mutex;
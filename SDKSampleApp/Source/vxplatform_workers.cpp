@@ -0,0 +1,460 @@
+/* Copyright (c) 2013-2018 by Mercer Road Corp
+ *
+ * Permission to use, copy, modify or distribute this software in binary or source form
+ * for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+ * ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+// WorkerPool and TimerQueue, on top of the threads and events of the platform
+// implementation, so they are the same on every platform.
+
+#include "vxplatform/vxcplatform.h"
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vxplatform {
+namespace {
+typedef std::pair<work_function_t, void *> WorkItem;
+
+class WorkerPoolImpl
+{
+public:
+    WorkerPoolImpl(size_t threadCount, const std::string &name) :
+        m_name(name),
+        m_stopping(false)
+    {
+        create_event(&m_wakeEvent);
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            os_thread_handle thread;
+            if (create_thread(&WorkerPoolImpl::WorkerThread, this, &thread) == 0) {
+                m_threads.push_back(thread);
+            }
+        }
+    }
+
+    ~WorkerPoolImpl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        // Each worker passes the wakeup on as it leaves
+        set_event(m_wakeEvent);
+        for (size_t i = 0; i < m_threads.size(); ++i) {
+            join_thread(m_threads[i]);
+        }
+        delete_event(m_wakeEvent);
+    }
+
+    bool Post(work_function_t pf, void *pArg)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                return false;
+            }
+            m_queue.push_back(WorkItem(pf, pArg));
+        }
+        set_event(m_wakeEvent);
+        return true;
+    }
+
+    size_t GetThreadCount() const
+    {
+        return m_threads.size();
+    }
+
+    size_t GetQueueLength() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+private:
+    static os_error_t WorkerThread(void *pArg)
+    {
+        reinterpret_cast<WorkerPoolImpl *>(pArg)->Run();
+        return 0;
+    }
+
+    // The wake event is auto reset: posts that come together wake one worker, so whoever
+    // takes work and leaves more behind wakes the next.
+    void Run()
+    {
+        set_thread_name(m_name);
+        for (;;) {
+            WorkItem item;
+            bool more;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_queue.empty()) {
+                    if (m_stopping) {
+                        break;
+                    }
+                    more = false;
+                    item.first = NULL;
+                } else {
+                    item = m_queue.front();
+                    m_queue.pop_front();
+                    more = !m_queue.empty();
+                }
+            }
+            if (item.first == NULL) {
+                wait_event(m_wakeEvent);
+                continue;
+            }
+            if (more) {
+                set_event(m_wakeEvent);
+            }
+            item.first(item.second);
+        }
+        set_event(m_wakeEvent);
+    }
+
+    std::string m_name;
+    std::vector<os_thread_handle> m_threads;
+    os_event_handle m_wakeEvent;
+    mutable std::mutex m_mutex;
+    std::deque<WorkItem> m_queue;
+    bool m_stopping;
+};
+
+// A hierarchical timing wheel of kLevels wheels of kSlots slots. Level 0 holds the timers due
+// within kSlots ticks, a slot a tick; each level above covers kSlots times the span of the
+// one below. When the current tick reaches the start of a slot of a higher level, its timers
+// move down, so each timer moves at most kLevels - 1 times. A bit per slot tells which are
+// occupied, which is what finding the next tick to wake up for looks at.
+class TimerQueueImpl
+{
+public:
+    TimerQueueImpl(WorkerPool *pPool, unsigned int resolutionMs) :
+        m_pPool(pPool),
+        m_resolutionNs((resolutionMs == 0 ? 1 : resolutionMs) * 1000000ULL),
+        m_startNs(get_nanosecond_tick_counter()),
+        m_currentTick(0),
+        m_nextId(1),
+        m_stopping(false)
+    {
+        for (int level = 0; level < kLevels; ++level) {
+            m_occupied[level] = 0;
+            for (int slot = 0; slot < kSlots; ++slot) {
+                m_slots[level][slot] = NULL;
+            }
+        }
+        create_event(&m_wakeEvent);
+        create_thread(&TimerQueueImpl::TimerThread, this, &m_thread);
+    }
+
+    ~TimerQueueImpl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        set_event(m_wakeEvent);
+        join_thread(m_thread);
+        delete_event(m_wakeEvent);
+        for (std::unordered_map<timer_id_t, Timer *>::const_iterator i = m_timers.begin(); i != m_timers.end(); ++i) {
+            delete i->second;
+        }
+    }
+
+    timer_id_t Schedule(unsigned long long delayMs, unsigned long long periodMs, work_function_t pf, void *pArg)
+    {
+        unsigned long long resolutionMs = m_resolutionNs / 1000000;
+        Timer *t = new Timer;
+        t->pf = pf;
+        t->pArg = pArg;
+        t->periodTicks = periodMs == 0 ? 0 : (periodMs + resolutionMs - 1) / resolutionMs;
+        timer_id_t id;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                delete t;
+                return 0;
+            }
+            id = t->id = m_nextId++;
+            // Counted from the clock rather than from the wheel, which lags while the thread sleeps
+            t->expires = ClockTick() + (delayMs + resolutionMs - 1) / resolutionMs;
+            if (t->expires <= m_currentTick) {
+                t->expires = m_currentTick + 1;
+            }
+            Insert(t);
+            m_timers[t->id] = t;
+        }
+        // The timer may have fired and gone by now
+        set_event(m_wakeEvent);
+        return id;
+    }
+
+    bool Cancel(timer_id_t id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unordered_map<timer_id_t, Timer *>::iterator i = m_timers.find(id);
+        if (i == m_timers.end()) {
+            return false;
+        }
+        Unlink(i->second);
+        delete i->second;
+        m_timers.erase(i);
+        return true;
+    }
+
+    size_t GetTimerCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_timers.size();
+    }
+
+private:
+    enum {
+        kLevels = 4,
+        kSlotBits = 6,
+        kSlots = 1 << kSlotBits
+    };
+
+    struct Timer {
+        timer_id_t id;
+        uint64_t expires;       // tick
+        uint64_t periodTicks;
+        work_function_t pf;
+        void *pArg;
+        int level;
+        int slot;
+        Timer *prev;
+        Timer *next;
+    };
+
+    uint64_t ClockTick() const
+    {
+        return (get_nanosecond_tick_counter() - m_startNs) / m_resolutionNs;
+    }
+
+    // m_mutex must be held by these
+    void Insert(Timer *t)
+    {
+        uint64_t delta = t->expires - m_currentTick;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (1ULL << (kSlotBits * (level + 1)))) {
+            ++level;
+        }
+        // Timers beyond the top wheel wait in its last slot, and go round again from there
+        uint64_t expires = t->expires;
+        uint64_t span = 1ULL << (kSlotBits * kLevels);
+        if (delta >= span) {
+            expires = m_currentTick + span - 1;
+        }
+        t->level = level;
+        t->slot = (int)((expires >> (kSlotBits * level)) & (kSlots - 1));
+        t->prev = NULL;
+        t->next = m_slots[level][t->slot];
+        if (t->next != NULL) {
+            t->next->prev = t;
+        }
+        m_slots[level][t->slot] = t;
+        m_occupied[level] |= 1ULL << t->slot;
+    }
+
+    void Unlink(Timer *t)
+    {
+        if (t->prev != NULL) {
+            t->prev->next = t->next;
+        } else {
+            m_slots[t->level][t->slot] = t->next;
+        }
+        if (t->next != NULL) {
+            t->next->prev = t->prev;
+        }
+        if (m_slots[t->level][t->slot] == NULL) {
+            m_occupied[t->level] &= ~(1ULL << t->slot);
+        }
+    }
+
+    Timer *TakeSlot(int level, int slot)
+    {
+        Timer *t = m_slots[level][slot];
+        m_slots[level][slot] = NULL;
+        m_occupied[level] &= ~(1ULL << slot);
+        return t;
+    }
+
+    // The next tick after the current one with timers due, or with an occupied slot of a
+    // higher level to move down; UINT64_MAX without timers.
+    uint64_t NextEventTick() const
+    {
+        uint64_t next = UINT64_MAX;
+        for (int level = 0; level < kLevels; ++level) {
+            uint64_t occupied = m_occupied[level];
+            if (occupied == 0) {
+                continue;
+            }
+            int shift = kSlotBits * level;
+            uint64_t index = m_currentTick >> shift;
+            // The slots from the one after the current, in order
+            int first = (int)((index + 1) & (kSlots - 1));
+            uint64_t rotated = first == 0 ? occupied : (occupied >> first) | (occupied << (kSlots - first));
+            uint64_t distance = 1;
+            while ((rotated & 1) == 0) {
+                rotated >>= 1;
+                ++distance;
+            }
+            uint64_t tick = (index + distance) << shift;
+            if (tick < next) {
+                next = tick;
+            }
+        }
+        return next;
+    }
+
+    // Moves the wheel up to target, collecting the callbacks due
+    void Advance(uint64_t target, std::vector<WorkItem> &due)
+    {
+        while (m_currentTick < target) {
+            uint64_t next = NextEventTick();
+            if (next > target) {
+                m_currentTick = target;
+                break;
+            }
+            m_currentTick = next;
+            for (int level = 1; level < kLevels; ++level) {
+                int shift = kSlotBits * level;
+                if ((m_currentTick & ((1ULL << shift) - 1)) != 0) {
+                    break;
+                }
+                Timer *t = TakeSlot(level, (int)((m_currentTick >> shift) & (kSlots - 1)));
+                while (t != NULL) {
+                    Timer *next = t->next;
+                    Insert(t);
+                    t = next;
+                }
+            }
+            Timer *t = TakeSlot(0, (int)(m_currentTick & (kSlots - 1)));
+            while (t != NULL) {
+                Timer *next = t->next;
+                due.push_back(WorkItem(t->pf, t->pArg));
+                if (t->periodTicks != 0) {
+                    t->expires += t->periodTicks;
+                    if (t->expires <= m_currentTick) {
+                        t->expires += ((m_currentTick - t->expires) / t->periodTicks + 1) * t->periodTicks;
+                    }
+                    Insert(t);
+                } else {
+                    m_timers.erase(t->id);
+                    delete t;
+                }
+                t = next;
+            }
+        }
+    }
+
+    static os_error_t TimerThread(void *pArg)
+    {
+        reinterpret_cast<TimerQueueImpl *>(pArg)->Run();
+        return 0;
+    }
+
+    void Run()
+    {
+        set_thread_name("TimerQueue");
+        std::vector<WorkItem> due;
+        for (;;) {
+            int timeout = -1;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stopping) {
+                    break;
+                }
+                Advance(ClockTick(), due);
+                uint64_t next = NextEventTick();
+                if (next != UINT64_MAX) {
+                    uint64_t nowNs = get_nanosecond_tick_counter() - m_startNs;
+                    uint64_t dueNs = next * m_resolutionNs;
+                    // Rounded up, as waking early only to sleep again costs a wakeup
+                    timeout = dueNs <= nowNs ? 0 : (int)((dueNs - nowNs + 999999) / 1000000);
+                }
+            }
+            for (size_t i = 0; i < due.size(); ++i) {
+                if (m_pPool == NULL || !m_pPool->Post(due[i].first, due[i].second)) {
+                    due[i].first(due[i].second);
+                }
+            }
+            due.clear();
+            if (timeout != 0) {
+                wait_event(m_wakeEvent, timeout);
+            }
+        }
+    }
+
+    WorkerPool *m_pPool;
+    const uint64_t m_resolutionNs;
+    const uint64_t m_startNs;
+    os_thread_handle m_thread;
+    os_event_handle m_wakeEvent;
+
+    mutable std::mutex m_mutex;
+    uint64_t m_currentTick;
+    timer_id_t m_nextId;
+    bool m_stopping;
+    Timer *m_slots[kLevels][kSlots];
+    uint64_t m_occupied[kLevels];
+    std::unordered_map<timer_id_t, Timer *> m_timers;
+};
+}
+
+WorkerPool::WorkerPool(size_t threadCount, const std::string &name)
+{
+    m_pImpl = new WorkerPoolImpl(threadCount, name);
+}
+WorkerPool::~WorkerPool()
+{
+    delete (WorkerPoolImpl *)m_pImpl;
+}
+bool WorkerPool::Post(work_function_t pf, void *pArg)
+{
+    return ((WorkerPoolImpl *)m_pImpl)->Post(pf, pArg);
+}
+size_t WorkerPool::GetThreadCount() const
+{
+    return ((WorkerPoolImpl *)m_pImpl)->GetThreadCount();
+}
+size_t WorkerPool::GetQueueLength() const
+{
+    return ((WorkerPoolImpl *)m_pImpl)->GetQueueLength();
+}
+
+TimerQueue::TimerQueue(WorkerPool *pPool, unsigned int resolutionMs)
+{
+    m_pImpl = new TimerQueueImpl(pPool, resolutionMs);
+}
+TimerQueue::~TimerQueue()
+{
+    delete (TimerQueueImpl *)m_pImpl;
+}
+timer_id_t TimerQueue::Schedule(unsigned long long delayMs, unsigned long long periodMs, work_function_t pf, void *pArg)
+{
+    return ((TimerQueueImpl *)m_pImpl)->Schedule(delayMs, periodMs, pf, pArg);
+}
+bool TimerQueue::Cancel(timer_id_t id)
+{
+    return ((TimerQueueImpl *)m_pImpl)->Cancel(id);
+}
+size_t TimerQueue::GetTimerCount() const
+{
+    return ((TimerQueueImpl *)m_pImpl)->GetTimerCount();
+}
+}
@@ -0,0 +1,853 @@
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+
+//
+// Microbenchmarks of the SimpleAPI primitives every event goes through: Uri and AccountName,
+// split() of blocked user lists, GetNextRequestId(), the participants of a Channel, with and
+// without roster batching, the channel scan of MultiChannelSessionGroup::NextState(), the routing of events to logins and
+// the ClientConnection getters a game reads every frame.
+//
+//  benchmark [-list] [-filter text] [-seconds s] [-logins n] [-threads n] [-work ns] [-messages]
+//            [-json file] [-baseline file [-threshold percent]]
+//
+// Each benchmark runs samples until it has at least 5 and -seconds (default 1) went by, and
+// reports the median nanoseconds per operation. -json writes the results; -baseline reads
+// such a file back and exits with 1 if any benchmark got slower by more than -threshold
+// percent (default 10). Compare runs of the same build configuration on the same machine.
+//
+// It links the vivoxsdk simulator of SDK/Simulator rather than vivoxsdk, so it runs headless.
+// The event routing benchmark logs in -logins accounts (default 32), joins each to a channel
+// of its own, and replays participant events to them with ClientConnection::ReplayMessageLog().
+// It runs on the UI thread, then again with login executors on -threads worker threads (default
+// the number of cores). -work busy waits that many nanoseconds in each participant callback, for
+// the application's own handling of the event, which executors spread over the cores as well.
+// -messages prints the messages of each type it replayed and the time their handlers took.
+// The getters benchmark reads the state of the channel of each of those logins.
+//
+
+// The primitives are file static: this is the one translation unit of vivoxclientsdk.cpp in
+// this project.
+#include "vivoxclientapi/vivoxclientsdk.cpp"
+#include "vivoxclientapi/debugclientapieventhandler.h"
+#include "VxcSimulator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace VivoxClientApi;
+
+static volatile size_t s_sink;
+
+struct Sample {
+    unsigned long long operations;
+    double seconds;
+};
+
+typedef bool (*BenchmarkFunction)(Sample &sample);
+
+struct Benchmark {
+    std::string name;
+    BenchmarkFunction run;
+};
+
+struct Result {
+    std::string name;
+    double nsPerOp;         // median of the samples
+    double minNsPerOp;
+    double maxNsPerOp;
+    unsigned long long operations;
+    size_t samples;
+};
+
+class Stopwatch
+{
+public:
+    Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+    double Seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count(); }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+///
+/// Receives the callbacks of the benchmarks: counts them without formatting anything, and
+/// runs what the SDK posts to the UI thread when Pump() is called.
+///
+class BenchmarkEventHandler :
+    public DebugClientApiEventHandler
+{
+public:
+    BenchmarkEventHandler()
+    {
+        m_connected = false;
+        m_logins = 0;
+        m_asserts = 0;
+        m_callbacks = 0;
+        m_workNanoseconds = 0;
+    }
+
+    void Reset()
+    {
+        m_connected = false;
+        m_logins = 0;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sessions.clear();
+        // Left by the connection torn down last, which they point to
+        m_calls.clear();
+    }
+
+    size_t GetSessionCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_sessions.size();
+    }
+
+    void Pump()
+    {
+        for (;;) {
+            std::pair<void (*)(void *), void *> call;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_calls.empty()) {
+                    return;
+                }
+                call = m_calls.front();
+                m_calls.pop_front();
+            }
+            call.first(call.second);
+        }
+    }
+
+    virtual void InvokeOnUIThread(void (*pf_func)(void *arg0), void *arg0)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_calls.push_back(std::make_pair(pf_func, arg0));
+    }
+
+    virtual void WriteStatus(const char * /*msg*/) const {}
+    virtual void onLogStatementEmitted(LogLevel /*level*/, long long /*nativeMillisecondsSinceEpoch*/, long /*threadId*/, const char * /*logMessage*/) {}
+    virtual void onAssert(const char *filename, int line, const char *message)
+    {
+        if (m_asserts++ == 0) {
+            fprintf(stderr, "assert %s:%d %s\n", filename, line, message);
+        }
+    }
+
+    // With login executors these come from their threads
+    virtual void onConnectCompleted(const Uri & /*server*/) { m_connected = true; }
+    virtual void onLoginCompleted(const AccountName & /*accountName*/) { ++m_logins; }
+    virtual void onChannelJoinedEx(const AccountName & /*accountName*/, const Uri & /*channelUri*/, const char *sessionGroupHandle, const char *sessionHandle)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sessions.push_back(std::make_pair(std::string(sessionGroupHandle), std::string(sessionHandle)));
+    }
+    virtual void onParticipantAdded(const AccountName &, const Uri &, const Uri &, bool) { Work(); }
+    virtual void onParticipantLeft(const AccountName &, const Uri &, const Uri &, bool, ParticipantLeftReason) { Work(); }
+    virtual void onParticipantUpdated(const AccountName &, const Uri &, const Uri &, bool, bool, double, bool) { Work(); }
+    virtual void onRosterChanged(const AccountName &, const Uri &, const std::vector<RosterParticipant> &, const std::vector<RosterParticipant> &, const std::vector<RosterParticipant> &) { Work(); }
+
+    std::atomic<bool> m_connected;
+    std::atomic<int> m_logins;
+    std::atomic<unsigned long long> m_asserts;
+    std::atomic<unsigned long long> m_callbacks;
+    int m_workNanoseconds;
+    // The session group and session handles of the channels joined, under m_mutex while joining
+    std::vector<std::pair<std::string, std::string> > m_sessions;
+
+private:
+    void Work()
+    {
+        if (m_workNanoseconds > 0) {
+            std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(m_workNanoseconds);
+            while (std::chrono::steady_clock::now() < until) {
+            }
+        }
+        ++m_callbacks;
+    }
+
+    std::mutex m_mutex;
+    std::deque<std::pair<void (*)(void *), void *> > m_calls;
+};
+
+static BenchmarkEventHandler s_app;
+
+//
+// Uri and AccountName
+//
+
+static const size_t kNames = 1024;
+
+static std::vector<std::string> MakeNames(const char *format)
+{
+    std::vector<std::string> names;
+    char buf[256];
+    for (size_t i = 0; i < kNames; ++i) {
+        snprintf(buf, sizeof(buf), format, (unsigned)i);
+        names.push_back(buf);
+    }
+    return names;
+}
+
+static const std::vector<std::string> &UriNames()
+{
+    static std::vector<std::string> names = MakeNames("sip:confctl-g-benchmark.channel%u@mt1s.vivox.com");
+    return names;
+}
+
+static const std::vector<std::string> &AccountNames()
+{
+    static std::vector<std::string> names = MakeNames(".benchmark.user%u.");
+    return names;
+}
+
+template <class T> static std::vector<T> MakeValues(const std::vector<std::string> &names)
+{
+    std::vector<T> values;
+    for (size_t i = 0; i < names.size(); ++i) {
+        values.push_back(T(names[i].c_str()));
+    }
+    return values;
+}
+
+template <class T> static bool Construct(Sample &sample, const std::vector<std::string> &names)
+{
+    const size_t rounds = 100;
+    size_t valid = 0;
+    Stopwatch stopwatch;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            T value(names[i].c_str());
+            valid += value.IsValid() ? 1 : 0;
+        }
+    }
+    sample.seconds = stopwatch.Seconds();
+    sample.operations = rounds * names.size();
+    s_sink = valid;
+    return true;
+}
+
+// operator== on neighbours, which share all but the last characters, and operator< as std::map does
+template <class T> static bool Compare(Sample &sample, const std::vector<std::string> &names)
+{
+    std::vector<T> values = MakeValues<T>(names);
+    const size_t rounds = 100;
+    size_t matches = 0;
+    Stopwatch stopwatch;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 1; i < values.size(); ++i) {
+            matches += values[i] == values[i - 1] ? 1 : 0;
+            matches += values[i] < values[i - 1] ? 1 : 0;
+        }
+    }
+    sample.seconds = stopwatch.Seconds();
+    sample.operations = rounds * (values.size() - 1) * 2;
+    s_sink = matches;
+    return true;
+}
+
+template <class T> static bool Copy(Sample &sample, const std::vector<std::string> &names)
+{
+    std::vector<T> values = MakeValues<T>(names);
+    const size_t rounds = 100;
+    size_t valid = 0;
+    Stopwatch stopwatch;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            T copy;
+            copy = values[i];
+            valid += copy.IsValid() ? 1 : 0;
+        }
+    }
+    sample.seconds = stopwatch.Seconds();
+    sample.operations = rounds * values.size();
+    s_sink = valid;
+    return true;
+}
+
+static bool UriConstruct(Sample &sample) { return Construct<Uri>(sample, UriNames()); }
+static bool UriCompare(Sample &sample) { return Compare<Uri>(sample, UriNames()); }
+static bool UriCopy(Sample &sample) { return Copy<Uri>(sample, UriNames()); }
+static bool AccountNameConstruct(Sample &sample) { return Construct<AccountName>(sample, AccountNames()); }
+static bool AccountNameCompare(Sample &sample) { return Compare<AccountName>(sample, AccountNames()); }
+static bool AccountNameCopy(Sample &sample) { return Copy<AccountName>(sample, AccountNames()); }
+
+//
+// split() and GetNextRequestId()
+//
+
+// A blocked user list as UserBlockPolicy keeps it, one URI a line
+static bool SplitBlockedUsers(Sample &sample)
+{
+    static std::string list;
+    const size_t users = 10000;
+    if (list.empty()) {
+        char buf[128];
+        for (size_t i = 0; i < users; ++i) {
+            snprintf(buf, sizeof(buf), "sip:.benchmark.blocked%u.@mt1s.vivox.com\n", (unsigned)i);
+            list += buf;
+        }
+    }
+    const size_t rounds = 10;
+    size_t count = 0;
+    Stopwatch stopwatch;
+    for (size_t r = 0; r < rounds; ++r) {
+        count += split(list.c_str()).size();
+    }
+    sample.seconds = stopwatch.Seconds();
+    sample.operations = rounds;
+    s_sink = count;
+    return count == rounds * users;
+}
+
+static bool NextRequestId(Sample &sample)
+{
+    const size_t count = 100000;
+    size_t length = 0;
+    Stopwatch stopwatch;
+    for (size_t i = 0; i < count; ++i) {
+        char *id = GetNextRequestId("c1.g0", "S");
+        length += strlen(id);
+        vx_free(id);
+    }
+    sample.seconds = stopwatch.Seconds();
+    sample.operations = count;
+    s_sink = length;
+    return true;
+}
+
+//
+// Channel and MultiChannelSessionGroup
+//
+
+// Participants joining a channel, each speaking on and off, and leaving again. Batched, each
+// pass over the participants is a batch of roster changes.
+static bool ChannelParticipantChurn(bool batching, Sample &sample)
+{
+    const size_t participants = 256;
+    const size_t updates = 8;
+    static std::vector<std::string> uris;
+    if (uris.empty()) {
+        char buf[128];
+        for (size_t i = 0; i < participants; ++i) {
+            snprintf(buf, sizeof(buf), "sip:.benchmark.participant%u.@mt1s.vivox.com", (unsigned)i);
+            uris.push_back(buf);
+        }
+    }
+    Channel channel(&s_app, Uri(UriNames()[0].c_str()), AccountName(AccountNames()[0].c_str()), "a0", "g0");
+    channel.SetRosterBatching(batching);
+
+    vx_evt_participant_added added;
+    vx_evt_participant_updated updated;
+    vx_evt_participant_removed removed;
+    memset(&added, 0, sizeof(added));
+    memset(&updated, 0, sizeof(updated));
+    memset(&removed, 0, sizeof(removed));
+    added.base.type = evt_participant_added;
+    updated.base.type = evt_participant_updated;
+    removed.base.type = evt_participant_removed;
+    removed.reason = participant_left;
+
+    unsigned long long callbacks = s_app.m_callbacks;
+    // The channel alone, without the application's -work
+    int work = s_app.m_workNanoseconds;
+    s_app.m_workNanoseconds = 0;
+    Stopwatch stopwatch;
+    for (size_t i = 0; i < participants; ++i) {
+        added.participant_uri = const_cast<char *>(uris[i].c_str());
+        channel.HandleEvent(&added);
+    }
+    channel.FlushRosterChanges();
+    for (size_t u = 0; u < updates; ++u) {
+        updated.is_speaking = (int)(u & 1);
+        updated.energy = updated.is_speaking ? 0.5 : 0;
+        for (size_t i = 0; i < participants; ++i) {
+            updated.participant_uri = const_cast<char *>(uris[i].c_str());
+            channel.HandleEvent(&updated);
+        }
+        channel.FlushRosterChanges();
+    }
+    for (size_t i = 0; i < participants; ++i) {
+        removed.participant_uri = const_cast<char *>(uris[i].c_str());
+        channel.HandleEvent(&removed);
+    }
+    channel.FlushRosterChanges();
+    sample.seconds = stopwatch.Seconds();
+    sample.operations = participants * (updates + 2);
+    s_app.m_workNanoseconds = work;
+    return s_app.m_callbacks - callbacks == (batching ? updates + 2 : sample.operations);
+}
+
+static bool ChannelParticipantChurnPerEvent(Sample &sample) { return ChannelParticipantChurn(false, sample); }
+static bool ChannelParticipantChurnBatched(Sample &sample) { return ChannelParticipantChurn(true, sample); }
+
+// NextState() runs on every event of a login. With the first channel connecting and the
+// others waiting their turn, each call scans them all and issues nothing.
+static bool SessionGroupNextState(Sample &sample)
+{
+    const size_t channels = 256;
+    const size_t count = 1000;
+    static MultiChannelSessionGroup *sg = NULL;
+    if (sg == NULL) {
+        sg = new MultiChannelSessionGroup(&s_app, AccountName(AccountNames()[0].c_str()));
+        for (size_t i = 0; i < channels; ++i) {
+            sg->JoinChannel(Uri(UriNames()[i].c_str()), NULL, true);
+        }
+        sg->NextState();
+    }
+    Stopwatch stopwatch;
+    for (size_t i = 0; i < count; ++i) {
+        sg->NextState();
+    }
+    sample.seconds = stopwatch.Seconds();
+    sample.operations = count;
+    return true;
+}
+
+//
+// Event routing through ClientConnection
+//
+
+static int s_logins = 32;
+static int s_threads = 0;
+static const char *kDispatchLog = "benchmark_dispatch.vxlog";
+static ClientConnection *s_connection = NULL;
+static int s_connectionThreads = 0;     // the login executor threads of s_connection
+static bool s_printMessages = false;
+
+static bool PumpUntil(bool (*done)(), double seconds)
+{
+    Stopwatch stopwatch;
+    while (!done()) {
+        if (stopwatch.Seconds() > seconds) {
+            return false;
+        }
+        s_app.Pump();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static int s_expected;
+static bool IsConnected() { return s_app.m_connected; }
+static bool IsLoggedIn() { return s_app.m_logins == s_expected; }
+static bool IsJoined() { return s_app.GetSessionCount() == (size_t)s_expected; }
+
+static void RecordEvent(MessageLogWriter &log, vx_evt_base_t &evt, vx_event_type type)
+{
+    evt.message.type = msg_event;
+    evt.type = type;
+    log.RecordMessage(&evt.message);
+}
+
+// Logs in the accounts, joins each to a channel of its own, and writes the log of events to
+// replay: a participant joining each channel, speaking on and off, and leaving, many times over.
+// The handles differ with login executors, so the log is written again for each connection.
+static bool SetUpDispatch(int threads, std::string &error)
+{
+    vx_sim_config_t config;
+    vx_sim_get_default_config(&config);
+    config.response_latency_min_ms = 1;
+    config.response_latency_max_ms = 2;
+    config.initial_remote_participants = 0;
+    config.participant_joins_per_second = 0;
+    config.speaking_changes_per_second = 0;
+    config.audio_frame_ms = 0;
+    vx_sim_configure(&config);
+
+    s_app.Reset();
+    s_connection = new ClientConnection();
+    s_connectionThreads = threads;
+    VCSStatus status = s_connection->SetLoginExecutorThreads(threads);
+    if (status == 0) {
+        status = s_connection->Initialize(&s_app, IClientApiEventHandler::LogLevelNone, true, true, false);
+    }
+    if (status == 0) {
+        status = s_connection->Connect(Uri("https://mt1s.www.vivox.com/api2"));
+    }
+    if (status != 0) {
+        error = "cannot connect";
+        return false;
+    }
+    if (!PumpUntil(&IsConnected, 10)) {
+        error = "timed out connecting";
+        return false;
+    }
+    // One at a time, as a game would, rather than with dozens of requests outstanding
+    for (s_expected = 1; s_expected <= s_logins; ++s_expected) {
+        AccountName accountName(AccountNames()[s_expected - 1].c_str());
+        s_connection->Login(accountName, "token");
+        if (!PumpUntil(&IsLoggedIn, 10)) {
+            error = "timed out logging in";
+            return false;
+        }
+        s_connection->JoinChannel(accountName, Uri(UriNames()[s_expected - 1].c_str()), "token");
+        if (!PumpUntil(&IsJoined, 10)) {
+            error = "timed out joining";
+            return false;
+        }
+    }
+
+    // Only the replayed events count in the dispatch stats
+    std::vector<MessageDispatchStats> stats;
+    s_connection->GetMessageDispatchStats(stats, true);
+
+    MessageLogWriter log;
+    if (!log.Open(kDispatchLog, error)) {
+        return false;
+    }
+    const int rounds = 50;
+    const int updates = 8;
+    char participant[] = "sip:.benchmark.remote.@mt1s.vivox.com";
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < s_app.m_sessions.size(); ++i) {
+            char *sessionGroupHandle = const_cast<char *>(s_app.m_sessions[i].first.c_str());
+            char *sessionHandle = const_cast<char *>(s_app.m_sessions[i].second.c_str());
+
+            vx_evt_participant_added added;
+            memset(&added, 0, sizeof(added));
+            added.sessiongroup_handle = sessionGroupHandle;
+            added.session_handle = sessionHandle;
+            added.participant_uri = participant;
+            RecordEvent(log, added.base, evt_participant_added);
+
+            vx_evt_participant_updated updated;
+            memset(&updated, 0, sizeof(updated));
+            updated.sessiongroup_handle = sessionGroupHandle;
+            updated.session_handle = sessionHandle;
+            updated.participant_uri = participant;
+            for (int u = 0; u < updates; ++u) {
+                updated.is_speaking = u & 1;
+                updated.energy = updated.is_speaking ? 0.5 : 0;
+                RecordEvent(log, updated.base, evt_participant_updated);
+            }
+
+            vx_evt_participant_removed removed;
+            memset(&removed, 0, sizeof(removed));
+            removed.sessiongroup_handle = sessionGroupHandle;
+            removed.session_handle = sessionHandle;
+            removed.participant_uri = participant;
+            removed.reason = participant_left;
+            RecordEvent(log, removed.base, evt_participant_removed);
+        }
+    }
+    log.Close();
+    return true;
+}
+
+static void PrintMessageDispatchStats()
+{
+    std::vector<MessageDispatchStats> stats;
+    s_connection->GetMessageDispatchStats(stats, false);
+    printf("\n%-36s %12s %12s %12s\n", s_connectionThreads != 0 ? "messages, login executors" : "messages, UI thread", "count", "seconds", "us/message");
+    for (size_t i = 0; i < stats.size(); ++i) {
+        printf("%-36s %12llu %12.3f %12.2f%s\n", stats[i].GetTypeName(), stats[i].GetMessages(), stats[i].GetHandlerSeconds(),
+               stats[i].GetMeanHandlerMicroseconds(), stats[i].IsHandled() ? "" : " unhandled");
+    }
+    printf("\n");
+}
+
+static void TearDownDispatch()
+{
+    if (s_connection != NULL) {
+        if (s_printMessages) {
+            PrintMessageDispatchStats();
+        }
+        s_connection->Uninitialize();
+        delete s_connection;
+        s_connection = NULL;
+        remove(kDispatchLog);
+    }
+}
+
+static bool DispatchEventRouting(int threads, Sample &sample)
+{
+    if (s_connection != NULL && s_connectionThreads != threads) {
+        TearDownDispatch();
+    }
+    if (s_connection == NULL) {
+        std::string error;
+        if (!SetUpDispatch(threads, error)) {
+            fprintf(stderr, "dispatch: %s\n", error.c_str());
+            TearDownDispatch();
+            return false;
+        }
+    }
+    s_app.Pump();
+    unsigned long long callbacks = s_app.m_callbacks;
+    MessageLogReplayStats stats;
+    if (s_connection->ReplayMessageLog(kDispatchLog, false, stats) != 0) {
+        return false;
+    }
+    sample.seconds = stats.GetDispatchSeconds();
+    sample.operations = stats.GetMessages();
+    return sample.operations > 0 && s_app.m_callbacks - callbacks == sample.operations;
+}
+
+static bool DispatchEventRoutingUiThread(Sample &sample) { return DispatchEventRouting(0, sample); }
+static bool DispatchEventRoutingExecutors(Sample &sample) { return DispatchEventRouting(s_threads, sample); }
+
+// What a game reads every frame for each of its logins and channels, from the snapshots published after dispatch
+static bool ConnectionGetters(Sample &sample)
+{
+    if (s_connection == NULL) {
+        std::string error;
+        if (!SetUpDispatch(0, error)) {
+            fprintf(stderr, "getters: %s\n", error.c_str());
+            TearDownDispatch();
+            return false;
+        }
+    }
+    std::vector<AccountName> accountNames;
+    std::vector<Uri> channels;
+    for (int i = 0; i < s_logins; ++i) {
+        accountNames.push_back(AccountName(AccountNames()[i].c_str()));
+        channels.push_back(Uri(UriNames()[i].c_str()));
+    }
+    Uri participant("sip:.benchmark.remote.@mt1s.vivox.com");
+    const int rounds = 1000;
+    size_t sum = 0;
+    Stopwatch stopwatch;
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < s_logins; ++i) {
+            sum += s_connection->GetChannelAudioOutputDeviceVolume(accountNames[i], channels[i]);
+            sum += s_connection->GetParticipantAudioOutputDeviceVolumeForMe(accountNames[i], participant, channels[i]);
+            sum += s_connection->GetParticipantMutedForAll(accountNames[i], participant, channels[i]) ? 1 : 0;
+            sum += (int)s_connection->GetChannelTransmissionPolicy(accountNames[i]).GetChannelTransmissionPolicy();
+        }
+    }
+    sample.seconds = stopwatch.Seconds();
+    sample.operations = (unsigned long long)rounds * s_logins * 4;
+    s_sink = sum;
+    return true;
+}
+
+//
+// Running, reporting and comparing
+//
+
+static bool RunBenchmark(const Benchmark &benchmark, double minSeconds, Result &result)
+{
+    const size_t minSamples = 5;
+    const size_t maxSamples = 10000;
+    Sample sample;
+    // The first sample warms up caches and static setup and is not counted
+    if (!benchmark.run(sample)) {
+        return false;
+    }
+    std::vector<double> nsPerOp;
+    result.operations = 0;
+    Stopwatch stopwatch;
+    while (nsPerOp.size() < minSamples || (stopwatch.Seconds() < minSeconds && nsPerOp.size() < maxSamples)) {
+        if (!benchmark.run(sample) || sample.operations == 0) {
+            return false;
+        }
+        nsPerOp.push_back(sample.seconds * 1e9 / sample.operations);
+        result.operations += sample.operations;
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    result.name = benchmark.name;
+    result.samples = nsPerOp.size();
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.minNsPerOp = nsPerOp.front();
+    result.maxNsPerOp = nsPerOp.back();
+    return true;
+}
+
+static bool WriteJson(const char *path, const std::vector<Result> &results)
+{
+    FILE *fp = NULL;
+    fopen_s(&fp, path, "w");
+    if (!fp) {
+        return false;
+    }
+    fprintf(fp, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f, \"ops_per_second\": %.1f, \"operations\": %llu, \"samples\": %u}%s\n",
+                r.name.c_str(), r.nsPerOp, r.minNsPerOp, r.maxNsPerOp, r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0, r.operations, (unsigned)r.samples, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+    return true;
+}
+
+// Reads the name and ns_per_op of each benchmark from a file WriteJson() wrote
+static bool ReadBaseline(const char *path, std::map<std::string, double> &baseline)
+{
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string text = ss.str();
+    const std::string nameKey = "\"name\": \"";
+    const std::string valueKey = "\"ns_per_op\": ";
+    for (size_t pos = text.find(nameKey); pos != std::string::npos; pos = text.find(nameKey, pos)) {
+        pos += nameKey.size();
+        size_t end = text.find('"', pos);
+        size_t value = text.find(valueKey, pos);
+        if (end == std::string::npos || value == std::string::npos) {
+            return false;
+        }
+        baseline[text.substr(pos, end - pos)] = strtod(text.c_str() + value + valueKey.size(), NULL);
+    }
+    return !baseline.empty();
+}
+
+// Returns the number of benchmarks slower than the baseline by more than threshold percent
+static int CompareWithBaseline(const std::vector<Result> &results, const std::map<std::string, double> &baseline, double threshold)
+{
+    int regressions = 0;
+    printf("\n%-36s %12s %12s %9s\n", "benchmark", "baseline ns", "ns/op", "change");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        std::map<std::string, double>::const_iterator b = baseline.find(r.name);
+        if (b == baseline.end() || b->second <= 0) {
+            printf("%-36s %12s %12.1f %9s\n", r.name.c_str(), "-", r.nsPerOp, "new");
+            continue;
+        }
+        double change = (r.nsPerOp - b->second) * 100 / b->second;
+        const char *verdict = "";
+        if (change > threshold) {
+            verdict = "  REGRESSION";
+            ++regressions;
+        } else if (change < -threshold) {
+            verdict = "  faster";
+        }
+        printf("%-36s %12.1f %12.1f %+8.1f%%%s\n", r.name.c_str(), b->second, r.nsPerOp, change, verdict);
+    }
+    return regressions;
+}
+
+static void PrintUsage()
+{
+    printf("usage: benchmark [-list] [-filter text] [-seconds s] [-logins n] [-threads n] [-work ns] [-messages]\n"
+           "                 [-json file] [-baseline file [-threshold percent]]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filter = NULL;
+    const char *jsonPath = NULL;
+    const char *baselinePath = NULL;
+    double minSeconds = 1;
+    double threshold = 10;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-list") {
+            list = true;
+        } else if (arg == "-filter" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "-seconds" && hasValue) {
+            minSeconds = atof(argv[++i]);
+        } else if (arg == "-logins" && hasValue) {
+            s_logins = atoi(argv[++i]);
+        } else if (arg == "-threads" && hasValue) {
+            s_threads = atoi(argv[++i]);
+        } else if (arg == "-work" && hasValue) {
+            s_app.m_workNanoseconds = atoi(argv[++i]);
+        } else if (arg == "-messages") {
+            s_printMessages = true;
+        } else if (arg == "-json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "-baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "-threshold" && hasValue) {
+            threshold = atof(argv[++i]);
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (s_threads == 0) {
+        s_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    if (s_logins < 1 || s_logins > (int)kNames || s_threads < 1 || s_app.m_workNanoseconds < 0 || minSeconds < 0 || threshold < 0) {
+        PrintUsage();
+        return 2;
+    }
+
+    std::vector<Benchmark> benchmarks;
+    benchmarks.push_back(Benchmark { "uri_construct", &UriConstruct });
+    benchmarks.push_back(Benchmark { "uri_compare", &UriCompare });
+    benchmarks.push_back(Benchmark { "uri_copy", &UriCopy });
+    benchmarks.push_back(Benchmark { "accountname_construct", &AccountNameConstruct });
+    benchmarks.push_back(Benchmark { "accountname_compare", &AccountNameCompare });
+    benchmarks.push_back(Benchmark { "accountname_copy", &AccountNameCopy });
+    benchmarks.push_back(Benchmark { "split_10000_blocked_users", &SplitBlockedUsers });
+    benchmarks.push_back(Benchmark { "get_next_request_id", &NextRequestId });
+    benchmarks.push_back(Benchmark { "channel_participant_churn", &ChannelParticipantChurnPerEvent });
+    benchmarks.push_back(Benchmark { "channel_participant_churn_batched", &ChannelParticipantChurnBatched });
+    benchmarks.push_back(Benchmark { "sessiongroup_next_state_256_channels", &SessionGroupNextState });
+    benchmarks.push_back(Benchmark { "dispatch_event_" + std::to_string(s_logins) + "_logins", &DispatchEventRoutingUiThread });
+    benchmarks.push_back(Benchmark { "connection_getters_" + std::to_string(s_logins) + "_logins", &ConnectionGetters });
+    benchmarks.push_back(Benchmark { "dispatch_event_" + std::to_string(s_logins) + "_logins_" + std::to_string(s_threads) + "_threads", &DispatchEventRoutingExecutors });
+
+    std::map<std::string, double> baseline;
+    if (baselinePath != NULL && !ReadBaseline(baselinePath, baseline)) {
+        fprintf(stderr, "cannot read baseline %s\n", baselinePath);
+        return 2;
+    }
+
+    std::vector<Result> results;
+    bool failed = false;
+    if (!list) {
+        printf("%-36s %12s %14s %8s\n", "benchmark", "ns/op", "ops/s", "samples");
+    }
+    for (size_t i = 0; i < benchmarks.size(); ++i) {
+        if (filter != NULL && benchmarks[i].name.find(filter) == std::string::npos) {
+            continue;
+        }
+        if (list) {
+            printf("%s\n", benchmarks[i].name.c_str());
+            continue;
+        }
+        Result result;
+        if (!RunBenchmark(benchmarks[i], minSeconds, result)) {
+            printf("%-36s %12s\n", benchmarks[i].name.c_str(), "FAILED");
+            failed = true;
+            continue;
+        }
+        printf("%-36s %12.1f %14.0f %8u\n", result.name.c_str(), result.nsPerOp, 1e9 / result.nsPerOp, (unsigned)result.samples);
+        results.push_back(result);
+    }
+    TearDownDispatch();
+    if (s_app.m_asserts != 0) {
+        fprintf(stderr, "%llu asserts\n", s_app.m_asserts.load());
+    }
+
+    if (jsonPath != NULL && !WriteJson(jsonPath, results)) {
+        fprintf(stderr, "cannot write %s\n", jsonPath);
+        failed = true;
+    }
+    if (!baseline.empty()) {
+        int regressions = CompareWithBaseline(results, baseline, threshold);
+        if (regressions != 0) {
+            printf("\n%d benchmark(s) more than %.0f%% slower than %s\n", regressions, threshold, baselinePath);
+            return 1;
+        }
+    }
+    return failed ? 2 : 0;
+}
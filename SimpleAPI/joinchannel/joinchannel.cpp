@@ -15,6 +15,7 @@
 
 #include "joinchannel.h"
 #include "joinchannelapp.h"
+#include "vivoxclientapi/memallocators.h"
 #include <sstream>
 
 #define MAX_LOADSTRING 100
@@ -34,6 +35,7 @@ JoinChannelApp *vivoxJoinChannelApp = NULL;
 BOOL InitInstance(HINSTANCE, int);
 INT_PTR CALLBACK MainDialog(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK AudioDialog(HWND, UINT, WPARAM, LPARAM);
+int RunAllocBench(const std::string &traceFile, int threads);
 
 int APIENTRY _tWinMain(
         _In_ HINSTANCE hInstance,
@@ -42,11 +44,30 @@ int APIENTRY _tWinMain(
         _In_ int nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
 
     MSG msg;
     HACCEL hAccelTable;
 
+    // /alloctrace <file> records the allocations made by the SDK while the application runs.
+    // /allocbench <file> [threads] replays such a recording and exits.
+    std::string allocTraceFile;
+    std::istringstream args(lpCmdLine);
+    std::string arg;
+    while (args >> arg) {
+        if (arg == "/alloctrace") {
+            args >> allocTraceFile;
+        } else if (arg == "/allocbench") {
+            std::string traceFile;
+            int threads = 4;
+            args >> traceFile >> threads;
+            return RunAllocBench(traceFile, threads);
+        }
+    }
+    if (!allocTraceFile.empty() && !VivoxClientApi::PoolAllocator::StartTrace(allocTraceFile.c_str())) {
+        MessageBox(NULL, allocTraceFile.c_str(), "Unable to create the allocation trace", MB_ICONERROR | MB_OK);
+        return -1;
+    }
+
     // Initialize global strings
     LoadString(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
     LoadString(hInstance, IDC_JOINCHANNEL, szWindowClass, MAX_LOADSTRING);
@@ -61,6 +82,10 @@ int APIENTRY _tWinMain(
     // BEGINVIVOX: Create your global app object
     vivoxJoinChannelApp = new JoinChannelApp(hInstance, hwndMainDialog, hwndAudioSetup);
     VCSStatus vcs;
+    if (!allocTraceFile.empty()) {
+        // The trace records the calls to the pool allocator
+        vivoxJoinChannelApp->GetClientConnection().SetPoolAllocator(true);
+    }
 #ifdef _DEBUG
     vcs = vivoxJoinChannelApp->Initialize(IClientApiEventHandler::LogLevelWarning);
 #else
@@ -92,9 +117,40 @@ int APIENTRY _tWinMain(
     delete vivoxJoinChannelApp;
     vivoxJoinChannelApp = NULL;
     // ENDVIVOX
+    if (!allocTraceFile.empty()) {
+        VivoxClientApi::PoolAllocator::StopTrace();
+    }
     return (int) msg.wParam;
 }
 
+//
+//   FUNCTION: RunAllocBench(const std::string &, int)
+//
+//   PURPOSE: Replays an allocation trace recorded with /alloctrace against the pool allocator
+//            and the system heap, on the given number of threads, and shows the throughputs
+//
+int RunAllocBench(const std::string &traceFile, int threads)
+{
+    if (threads < 1) {
+        threads = 1;
+    }
+    VivoxClientApi::PoolAllocator::ReplayResult pool;
+    VivoxClientApi::PoolAllocator::ReplayResult system;
+    if (!VivoxClientApi::PoolAllocator::ReplayTrace(traceFile.c_str(), threads, false, pool) ||
+        !VivoxClientApi::PoolAllocator::ReplayTrace(traceFile.c_str(), threads, true, system)) {
+        MessageBox(NULL, traceFile.c_str(), "Unable to read the allocation trace", MB_ICONERROR | MB_OK);
+        return -1;
+    }
+    std::stringstream ss;
+    ss.precision(3);
+    ss << std::fixed;
+    ss << threads << " thread(s), " << pool.operations / threads << " calls each\r\n";
+    ss << "PoolAllocator: " << pool.seconds << " s, " << pool.operations / 1e6 / pool.seconds << " M calls/s\r\n";
+    ss << "System heap: " << system.seconds << " s, " << system.operations / 1e6 / system.seconds << " M calls/s";
+    MessageBox(NULL, ss.str().c_str(), "Allocation benchmark", MB_ICONINFORMATION | MB_OK);
+    return 0;
+}
+
 //
 //   FUNCTION: InitInstance(HINSTANCE, int)
 //
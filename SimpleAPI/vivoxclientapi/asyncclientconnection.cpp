@@ -0,0 +1,644 @@
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+#include "vivoxclientapi/asyncclientconnection.h"
+#include "VxcErrors.h"
+
+namespace VivoxClientApi {
+AsyncCancellation::AsyncCancellation() :
+    m_shared(std::make_shared<Shared>())
+{
+    m_shared->cancelled = false;
+}
+
+void AsyncCancellation::Cancel()
+{
+    std::vector<Registration> registrations;
+    {
+        std::lock_guard<std::mutex> lock(m_shared->mutex);
+        if (m_shared->cancelled) {
+            return;
+        }
+        m_shared->cancelled = true;
+        registrations.swap(m_shared->registrations);
+    }
+    for (size_t i = 0; i < registrations.size(); ++i) {
+        if (!registrations[i].connection.expired()) {
+            registrations[i].app->InvokeOnUIThread(&AsyncClientConnection::CheckCallsOnUIThread, new std::weak_ptr<AsyncClientConnection *>(registrations[i].connection));
+        }
+    }
+}
+
+bool AsyncCancellation::IsCancelled() const
+{
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    return m_shared->cancelled;
+}
+
+bool AsyncCancellation::Register(IClientApiEventHandler *app, const std::shared_ptr<AsyncClientConnection *> &connection) const
+{
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    if (m_shared->cancelled) {
+        return false;
+    }
+    // Once per connection, however many of its calls it is given to
+    for (size_t i = 0; i < m_shared->registrations.size(); ++i) {
+        const std::weak_ptr<AsyncClientConnection *> &c = m_shared->registrations[i].connection;
+        if (!c.owner_before(connection) && !connection.owner_before(c)) {
+            return true;
+        }
+    }
+    Registration registration;
+    registration.app = app;
+    registration.connection = connection;
+    m_shared->registrations.push_back(registration);
+    return true;
+}
+
+AsyncClientConnection::AsyncClientConnection(ClientConnection *connection, IClientApiEventHandler *app) :
+    m_connection(connection),
+    m_app(app),
+    m_self(std::make_shared<AsyncClientConnection *>(this)),
+    m_nextCallId(1),
+    m_stopping(false)
+{
+}
+
+AsyncClientConnection::~AsyncClientConnection()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_timerWake.notify_all();
+    if (m_timerThread.joinable()) {
+        m_timerThread.join();
+    }
+    // What is still posted to the UI thread finds nothing
+    m_self.reset();
+}
+
+VCSStatus AsyncClientConnection::Connect(const Uri &server, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation, AsyncCompletionHandler handler)
+{
+    Call call;
+    call.type = CallConnect;
+    call.server = server;
+    call.handler = handler;
+    unsigned long long id;
+    if (!Add(call, timeoutMilliseconds, cancellation, id)) {
+        return 0;
+    }
+    VCSStatus status = m_connection->Connect(server);
+    if (status != 0) {
+        Remove(id);
+    }
+    return status;
+}
+
+VCSStatus AsyncClientConnection::Login(const AccountName &accountName, const char *accessToken, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation, AsyncCompletionHandler handler)
+{
+    Call call;
+    call.type = CallLogin;
+    call.accountName = accountName;
+    call.handler = handler;
+    unsigned long long id;
+    if (!Add(call, timeoutMilliseconds, cancellation, id)) {
+        return 0;
+    }
+    VCSStatus status = m_connection->Login(accountName, accessToken);
+    if (status != 0) {
+        Remove(id);
+    }
+    return status;
+}
+
+VCSStatus AsyncClientConnection::JoinChannel(const AccountName &accountName, const Uri &channelUri, const char *channelAccessToken, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation, AsyncCompletionHandler handler)
+{
+    Call call;
+    call.type = CallJoinChannel;
+    call.accountName = accountName;
+    call.channelUri = channelUri;
+    call.handler = handler;
+    unsigned long long id;
+    if (!Add(call, timeoutMilliseconds, cancellation, id)) {
+        return 0;
+    }
+    VCSStatus status = m_connection->JoinChannel(accountName, channelUri, channelAccessToken);
+    if (status != 0) {
+        Remove(id);
+    }
+    return status;
+}
+
+bool AsyncClientConnection::Add(Call &call, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation, unsigned long long &id)
+{
+    if (cancellation != NULL) {
+        if (!cancellation->Register(m_app, m_self)) {
+            call.handler(VX_E_REQUEST_CANCELED);
+            return false;
+        }
+        call.cancellation = *cancellation;
+    }
+    call.hasDeadline = timeoutMilliseconds > 0;
+    if (call.hasDeadline) {
+        call.deadline = Clock::now() + std::chrono::milliseconds(timeoutMilliseconds);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool done = false;
+    switch (call.type) {
+    case CallConnect:
+        done = m_connectedServer.IsValid() && m_connectedServer == call.server;
+        break;
+    case CallLogin:
+        done = m_loggedIn.count(call.accountName) != 0;
+        break;
+    case CallJoinChannel:
+        done = m_joined.count(std::make_pair(call.accountName, call.channelUri)) != 0;
+        break;
+    }
+    if (done) {
+        lock.unlock();
+        call.handler(0);
+        return false;
+    }
+
+    id = m_nextCallId++;
+    m_calls[id] = call;
+    if (call.hasDeadline) {
+        m_deadlines.insert(call.deadline);
+        if (!m_timerThread.joinable()) {
+            m_timerThread = std::thread(&AsyncClientConnection::TimerThread, this);
+        }
+        lock.unlock();
+        m_timerWake.notify_one();
+    }
+    return true;
+}
+
+void AsyncClientConnection::Remove(unsigned long long id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_calls.erase(id);
+}
+
+void AsyncClientConnection::Complete(CallType type, const Uri *server, const AccountName *accountName, const Uri *channelUri, VCSStatus status)
+{
+    std::vector<AsyncCompletionHandler> handlers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::map<unsigned long long, Call>::iterator i = m_calls.begin(); i != m_calls.end();) {
+            const Call &call = i->second;
+            if (call.type == type &&
+                (server == NULL || call.server == *server) &&
+                (accountName == NULL || call.accountName == *accountName) &&
+                (channelUri == NULL || call.channelUri == *channelUri)) {
+                handlers.push_back(call.handler);
+                m_calls.erase(i++);
+            } else {
+                ++i;
+            }
+        }
+    }
+    // Without the lock, since the handler of a coroutine runs it up to its next co_await
+    for (size_t i = 0; i < handlers.size(); ++i) {
+        handlers[i](status);
+    }
+}
+
+void AsyncClientConnection::CheckCalls()
+{
+    std::vector<AsyncCompletionHandler> handlers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Clock::time_point now = Clock::now();
+        for (std::map<unsigned long long, Call>::iterator i = m_calls.begin(); i != m_calls.end();) {
+            const Call &call = i->second;
+            if ((call.hasDeadline && call.deadline <= now) || call.cancellation.IsCancelled()) {
+                handlers.push_back(call.handler);
+                m_calls.erase(i++);
+            } else {
+                ++i;
+            }
+        }
+    }
+    for (size_t i = 0; i < handlers.size(); ++i) {
+        handlers[i](VX_E_REQUEST_CANCELED);
+    }
+}
+
+void AsyncClientConnection::CheckCallsOnUIThread(void *arg0)
+{
+    std::unique_ptr<std::weak_ptr<AsyncClientConnection *> > connection(static_cast<std::weak_ptr<AsyncClientConnection *> *>(arg0));
+    std::shared_ptr<AsyncClientConnection *> self = connection->lock();
+    if (self) {
+        (*self)->CheckCalls();
+    }
+}
+
+void AsyncClientConnection::TimerThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        if (m_deadlines.empty()) {
+            m_timerWake.wait(lock);
+            continue;
+        }
+        if (Clock::now() < *m_deadlines.begin()) {
+            m_timerWake.wait_until(lock, *m_deadlines.begin());
+            continue;
+        }
+        // The deadlines of calls that completed in time are still here, and only cost a check
+        Clock::time_point now = Clock::now();
+        while (!m_deadlines.empty() && *m_deadlines.begin() <= now) {
+            m_deadlines.erase(m_deadlines.begin());
+        }
+        std::weak_ptr<AsyncClientConnection *> *connection = new std::weak_ptr<AsyncClientConnection *>(m_self);
+        lock.unlock();
+        m_app->InvokeOnUIThread(&AsyncClientConnection::CheckCallsOnUIThread, connection);
+        lock.lock();
+    }
+}
+
+//
+// IClientApiEventHandler: forward, then complete
+//
+
+void AsyncClientConnection::InvokeOnUIThread(void(pf_func)(void *arg0), void *arg0)
+{
+    m_app->InvokeOnUIThread(pf_func, arg0);
+}
+
+void AsyncClientConnection::onLogStatementEmitted(LogLevel level, long long nativeMillisecondsSinceEpoch, long threadId, const char *logMessage)
+{
+    m_app->onLogStatementEmitted(level, nativeMillisecondsSinceEpoch, threadId, logMessage);
+}
+
+void AsyncClientConnection::onAssert(const char *filename, int line, const char *message)
+{
+    m_app->onAssert(filename, line, message);
+}
+
+void AsyncClientConnection::onConnectCompleted(const Uri &server)
+{
+    m_app->onConnectCompleted(server);
+}
+
+void AsyncClientConnection::onConnectCompletedEx(const Uri &server, vx_backend_type backendType, const char *connectorHandle)
+{
+    // Always right after onConnectCompleted(), so the application has both before the awaiting code goes on
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connectedServer = server;
+    }
+    m_app->onConnectCompletedEx(server, backendType, connectorHandle);
+    Complete(CallConnect, &server, NULL, NULL, 0);
+}
+
+void AsyncClientConnection::onConnectFailed(const Uri &server, VCSStatus status)
+{
+    m_app->onConnectFailed(server, status);
+    Complete(CallConnect, &server, NULL, NULL, status);
+}
+
+void AsyncClientConnection::onDisconnected(const Uri &server, VCSStatus status)
+{
+    // The logins and channels go with the connection
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connectedServer.Clear();
+        m_loggedIn.clear();
+        m_joined.clear();
+    }
+    m_app->onDisconnected(server, status);
+    VCSStatus result = status != 0 ? status : VX_E_REQUEST_CANCELED;
+    Complete(CallConnect, NULL, NULL, NULL, result);
+    Complete(CallLogin, NULL, NULL, NULL, result);
+    Complete(CallJoinChannel, NULL, NULL, NULL, result);
+}
+
+void AsyncClientConnection::onLoginCompleted(const AccountName &accountName)
+{
+    m_app->onLoginCompleted(accountName);
+}
+
+void AsyncClientConnection::onLoginCompletedEx(const AccountName &accountName, const char *accountHandle)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loggedIn.insert(accountName);
+    }
+    m_app->onLoginCompletedEx(accountName, accountHandle);
+    Complete(CallLogin, NULL, &accountName, NULL, 0);
+}
+
+void AsyncClientConnection::onInvalidLoginCredentials(const AccountName &accountName)
+{
+    m_app->onInvalidLoginCredentials(accountName);
+    Complete(CallLogin, NULL, &accountName, NULL, VX_E_INVALID_USERNAME_OR_PASSWORD);
+}
+
+void AsyncClientConnection::onLoginFailed(const AccountName &accountName, VCSStatus status)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loggedIn.erase(accountName);
+    }
+    m_app->onLoginFailed(accountName, status);
+    // The channels of the login are not joined without it
+    Complete(CallLogin, NULL, &accountName, NULL, status);
+    Complete(CallJoinChannel, NULL, &accountName, NULL, status);
+}
+
+void AsyncClientConnection::onLogoutCompleted(const AccountName &accountName)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loggedIn.erase(accountName);
+        for (std::set<std::pair<AccountName, Uri> >::iterator i = m_joined.begin(); i != m_joined.end();) {
+            if (i->first == accountName) {
+                m_joined.erase(i++);
+            } else {
+                ++i;
+            }
+        }
+    }
+    m_app->onLogoutCompleted(accountName);
+    Complete(CallLogin, NULL, &accountName, NULL, VX_E_REQUEST_CANCELED);
+    Complete(CallJoinChannel, NULL, &accountName, NULL, VX_E_REQUEST_CANCELED);
+}
+
+void AsyncClientConnection::onLogoutFailed(const AccountName &accountName, VCSStatus status)
+{
+    m_app->onLogoutFailed(accountName, status);
+}
+
+void AsyncClientConnection::onChannelJoined(const AccountName &accountName, const Uri &channelUri)
+{
+    m_app->onChannelJoined(accountName, channelUri);
+}
+
+void AsyncClientConnection::onChannelJoinedEx(const AccountName &accountName, const Uri &channelUri, const char *sessionGroupHandle, const char *sessionHandle)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_joined.insert(std::make_pair(accountName, channelUri));
+    }
+    m_app->onChannelJoinedEx(accountName, channelUri, sessionGroupHandle, sessionHandle);
+    Complete(CallJoinChannel, NULL, &accountName, &channelUri, 0);
+}
+
+void AsyncClientConnection::onInvalidChannelCredentials(const AccountName &accountName, const Uri &channelUri)
+{
+    m_app->onInvalidChannelCredentials(accountName, channelUri);
+    Complete(CallJoinChannel, NULL, &accountName, &channelUri, VX_E_INVALID_AUTH_TOKEN);
+}
+
+void AsyncClientConnection::onChannelJoinFailed(const AccountName &accountName, const Uri &channelUri, VCSStatus status)
+{
+    m_app->onChannelJoinFailed(accountName, channelUri, status);
+    Complete(CallJoinChannel, NULL, &accountName, &channelUri, status);
+}
+
+void AsyncClientConnection::onChannelExited(const AccountName &accountName, const Uri &channelUri, VCSStatus reasonCode)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_joined.erase(std::make_pair(accountName, channelUri));
+    }
+    m_app->onChannelExited(accountName, channelUri, reasonCode);
+    // Left before it was joined, by LeaveChannel() or the service
+    Complete(CallJoinChannel, NULL, &accountName, &channelUri, reasonCode != 0 ? reasonCode : VX_E_REQUEST_CANCELED);
+}
+
+void AsyncClientConnection::onCallStatsUpdated(const AccountName &accountName, vx_call_stats_t &stats, bool isFinal)
+{
+    m_app->onCallStatsUpdated(accountName, stats, isFinal);
+}
+
+void AsyncClientConnection::onParticipantAdded(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser)
+{
+    m_app->onParticipantAdded(accountName, channelUri, participantUri, isLoggedInUser);
+}
+
+void AsyncClientConnection::onParticipantLeft(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser, ParticipantLeftReason reason)
+{
+    m_app->onParticipantLeft(accountName, channelUri, participantUri, isLoggedInUser, reason);
+}
+
+void AsyncClientConnection::onParticipantUpdated(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser, bool speaking, double vuMeterEnergy, bool isMutedForAll)
+{
+    m_app->onParticipantUpdated(accountName, channelUri, participantUri, isLoggedInUser, speaking, vuMeterEnergy, isMutedForAll);
+}
+
+void AsyncClientConnection::onRosterChanged(const AccountName &accountName, const Uri &channelUri, const std::vector<RosterParticipant> &added, const std::vector<RosterParticipant> &removed, const std::vector<RosterParticipant> &updated)
+{
+    m_app->onRosterChanged(accountName, channelUri, added, removed, updated);
+}
+
+void AsyncClientConnection::onParticipantKickedCompleted(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri)
+{
+    m_app->onParticipantKickedCompleted(accountName, channelUri, participantUri);
+}
+
+void AsyncClientConnection::onParticipantKickFailed(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, VCSStatus status)
+{
+    m_app->onParticipantKickFailed(accountName, channelUri, participantUri, status);
+}
+
+void AsyncClientConnection::onStartPlayFileIntoChannels(const AccountName &accountName, const char *filename)
+{
+    m_app->onStartPlayFileIntoChannels(accountName, filename);
+}
+
+void AsyncClientConnection::onStartPlayFileIntoChannelsFailed(const AccountName &accountName, const char *filename, VCSStatus status)
+{
+    m_app->onStartPlayFileIntoChannelsFailed(accountName, filename, status);
+}
+
+void AsyncClientConnection::onPlayFileIntoChannelsStopped(const AccountName &accountName, const char *filename)
+{
+    m_app->onPlayFileIntoChannelsStopped(accountName, filename);
+}
+
+void AsyncClientConnection::onAvailableAudioDevicesChanged()
+{
+    m_app->onAvailableAudioDevicesChanged();
+}
+
+void AsyncClientConnection::onDefaultSystemAudioInputDeviceChanged(const AudioDeviceId &deviceId)
+{
+    m_app->onDefaultSystemAudioInputDeviceChanged(deviceId);
+}
+
+void AsyncClientConnection::onDefaultCommunicationAudioInputDeviceChanged(const AudioDeviceId &deviceId)
+{
+    m_app->onDefaultCommunicationAudioInputDeviceChanged(deviceId);
+}
+
+void AsyncClientConnection::onSetAudioInputDeviceCompleted(const AudioDeviceId &deviceId)
+{
+    m_app->onSetAudioInputDeviceCompleted(deviceId);
+}
+
+void AsyncClientConnection::onSetAudioInputDeviceFailed(const AudioDeviceId &deviceId, VCSStatus status)
+{
+    m_app->onSetAudioInputDeviceFailed(deviceId, status);
+}
+
+void AsyncClientConnection::onDefaultSystemAudioOutputDeviceChanged(const AudioDeviceId &deviceId)
+{
+    m_app->onDefaultSystemAudioOutputDeviceChanged(deviceId);
+}
+
+void AsyncClientConnection::onDefaultCommunicationAudioOutputDeviceChanged(const AudioDeviceId &deviceId)
+{
+    m_app->onDefaultCommunicationAudioOutputDeviceChanged(deviceId);
+}
+
+void AsyncClientConnection::onSetAudioOutputDeviceCompleted(const AudioDeviceId &deviceId)
+{
+    m_app->onSetAudioOutputDeviceCompleted(deviceId);
+}
+
+void AsyncClientConnection::onSetAudioOutputDeviceFailed(const AudioDeviceId &deviceId, VCSStatus status)
+{
+    m_app->onSetAudioOutputDeviceFailed(deviceId, status);
+}
+
+void AsyncClientConnection::onSetChannelAudioOutputDeviceVolumeCompleted(const AccountName &accountName, const Uri &channelUri, int volume)
+{
+    m_app->onSetChannelAudioOutputDeviceVolumeCompleted(accountName, channelUri, volume);
+}
+
+void AsyncClientConnection::onSetChannelAudioOutputDeviceVolumeFailed(const AccountName &accountName, const Uri &channelUri, int volume, VCSStatus status)
+{
+    m_app->onSetChannelAudioOutputDeviceVolumeFailed(accountName, channelUri, volume, status);
+}
+
+void AsyncClientConnection::onSetParticipantAudioOutputDeviceVolumeForMeCompleted(const AccountName &accountName, const Uri &targetUser, const Uri &channelUri, int volume)
+{
+    m_app->onSetParticipantAudioOutputDeviceVolumeForMeCompleted(accountName, targetUser, channelUri, volume);
+}
+
+void AsyncClientConnection::onSetParticipantAudioOutputDeviceVolumeForMeFailed(const AccountName &accountName, const Uri &targetUser, const Uri &channelUri, int volume, VCSStatus status)
+{
+    m_app->onSetParticipantAudioOutputDeviceVolumeForMeFailed(accountName, targetUser, channelUri, volume, status);
+}
+
+void AsyncClientConnection::onSetParticipantMutedForAllCompleted(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted)
+{
+    m_app->onSetParticipantMutedForAllCompleted(accountName, target, channelUri, muted);
+}
+
+void AsyncClientConnection::onSetParticipantMutedForAllFailed(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted, VCSStatus status)
+{
+    m_app->onSetParticipantMutedForAllFailed(accountName, target, channelUri, muted, status);
+}
+
+void AsyncClientConnection::onSetParticipantMutedForMeCompleted(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted)
+{
+    m_app->onSetParticipantMutedForMeCompleted(accountName, target, channelUri, muted);
+}
+
+void AsyncClientConnection::onSetParticipantMutedForMeFailed(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted, VCSStatus status)
+{
+    m_app->onSetParticipantMutedForMeFailed(accountName, target, channelUri, muted, status);
+}
+
+void AsyncClientConnection::onSetChannelTransmissionToSpecificChannelCompleted(const AccountName &accountName, const Uri &channelUri)
+{
+    m_app->onSetChannelTransmissionToSpecificChannelCompleted(accountName, channelUri);
+}
+
+void AsyncClientConnection::onSetChannelTransmissionToSpecificChannelFailed(const AccountName &accountName, const Uri &channelUri, VCSStatus status)
+{
+    m_app->onSetChannelTransmissionToSpecificChannelFailed(accountName, channelUri, status);
+}
+
+void AsyncClientConnection::onSetChannelTransmissionToAllCompleted(const AccountName &accountName)
+{
+    m_app->onSetChannelTransmissionToAllCompleted(accountName);
+}
+
+void AsyncClientConnection::onSetChannelTransmissionToAllFailed(const AccountName &accountName, VCSStatus status)
+{
+    m_app->onSetChannelTransmissionToAllFailed(accountName, status);
+}
+
+void AsyncClientConnection::onSetChannelTransmissionToNoneCompleted(const AccountName &accountName)
+{
+    m_app->onSetChannelTransmissionToNoneCompleted(accountName);
+}
+
+void AsyncClientConnection::onSetChannelTransmissionToNoneFailed(const AccountName &accountName, VCSStatus status)
+{
+    m_app->onSetChannelTransmissionToNoneFailed(accountName, status);
+}
+
+void AsyncClientConnection::onSttTranscriptionReceived(const AccountName &accountName, const Uri &from, const Uri &channelUri, const char *text, const char *language, const char *displayName)
+{
+    m_app->onSttTranscriptionReceived(accountName, from, channelUri, text, language, displayName);
+}
+
+void AsyncClientConnection::onAudioInputDeviceTestPlaybackCompleted()
+{
+    m_app->onAudioInputDeviceTestPlaybackCompleted();
+}
+
+void AsyncClientConnection::onMuteAllFailed(const AccountName &accountName, const Uri &channelUri, bool muted, VCSStatus status)
+{
+    m_app->onMuteAllFailed(accountName, channelUri, muted, status);
+}
+
+void AsyncClientConnection::onMuteAllCompleted(const AccountName &accountName, const Uri &channelUri, bool muted)
+{
+    m_app->onMuteAllCompleted(accountName, channelUri, muted);
+}
+
+void AsyncClientConnection::onSessionGroupRemoved(const AccountName &accountName, const char *sessionGroupHandle)
+{
+    m_app->onSessionGroupRemoved(accountName, sessionGroupHandle);
+}
+
+void AsyncClientConnection::onGetStats(vx_resp_sessiongroup_get_stats *resp)
+{
+    m_app->onGetStats(resp);
+}
+
+void AsyncClientConnection::onAudioUnitStarted(const AccountName &accountName, const Uri &initial_target_uri)
+{
+    m_app->onAudioUnitStarted(accountName, initial_target_uri);
+}
+
+void AsyncClientConnection::onAudioUnitStopped(const AccountName &accountName, const Uri &initial_target_uri)
+{
+    m_app->onAudioUnitStopped(accountName, initial_target_uri);
+}
+
+void AsyncClientConnection::onAudioUnitAfterCaptureAudioRead(const AccountName &accountName, const Uri &initial_target_uri, short *pcm_frames, int pcm_frame_count, int audio_frame_rate, int channels_per_frame)
+{
+    m_app->onAudioUnitAfterCaptureAudioRead(accountName, initial_target_uri, pcm_frames, pcm_frame_count, audio_frame_rate, channels_per_frame);
+}
+
+void AsyncClientConnection::onAudioUnitBeforeCaptureAudioSent(const AccountName &accountName, const Uri &initial_target_uri, short *pcm_frames, int pcm_frame_count, int audio_frame_rate, int channels_per_frame, int is_speaking)
+{
+    m_app->onAudioUnitBeforeCaptureAudioSent(accountName, initial_target_uri, pcm_frames, pcm_frame_count, audio_frame_rate, channels_per_frame, is_speaking);
+}
+
+void AsyncClientConnection::onAudioUnitBeforeRecvAudioRendered(const AccountName &accountName, const Uri &initial_target_uri, short *pcm_frames, int pcm_frame_count, int audio_frame_rate, int channels_per_frame, int is_silence)
+{
+    m_app->onAudioUnitBeforeRecvAudioRendered(accountName, initial_target_uri, pcm_frames, pcm_frame_count, audio_frame_rate, channels_per_frame, is_silence);
+}
+}
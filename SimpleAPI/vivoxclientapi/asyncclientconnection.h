@@ -0,0 +1,372 @@
+#pragma once
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+
+#include "vivoxclientsdk.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The awaitables need C++20 in the translation unit that uses them; the rest of this header does not
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define VIVOXCLIENTAPI_COROUTINES 1
+#endif
+#endif
+
+namespace VivoxClientApi {
+class AsyncCall;
+class AsyncClientConnection;
+
+///
+/// Called once with the outcome of an asynchronous call: 0 when it completed, or the status it failed with
+///
+typedef std::function<void(VCSStatus status)> AsyncCompletionHandler;
+
+///
+/// Cancels the waits of the asynchronous calls it is given to. Copies share the same cancellation, and Cancel() may
+/// be called from any thread. A call given an AsyncCancellation that was already cancelled completes at once.
+///
+class AsyncCancellation
+{
+public:
+    AsyncCancellation();
+
+    void Cancel();
+    bool IsCancelled() const;
+
+private:
+    friend class AsyncClientConnection;
+
+    struct Registration {
+        IClientApiEventHandler *app;
+        std::weak_ptr<AsyncClientConnection *> connection;
+    };
+    struct Shared {
+        std::mutex mutex;
+        bool cancelled;
+        std::vector<Registration> registrations;
+    };
+
+    // Returns false if already cancelled
+    bool Register(IClientApiEventHandler *app, const std::shared_ptr<AsyncClientConnection *> &connection) const;
+
+    std::shared_ptr<Shared> m_shared;
+};
+
+///
+/// Completes Connect(), Login() and JoinChannel() calls of a ClientConnection with a handler, or with co_await in C++20,
+/// rather than the application following their progress through the callbacks.
+///
+/// Pass this object to ClientConnection::Initialize() in place of the application's IClientApiEventHandler: it forwards
+/// every callback to the application's handler, then completes the calls the callback finishes, on the same thread.
+/// That is the UI thread, which drains the message queue, or with login executors (see
+/// ClientConnection::SetLoginExecutorThreads()) the executor of the login, for Login() and JoinChannel(). A call that
+/// times out or is cancelled completes on the UI thread, through IClientApiEventHandler::InvokeOnUIThread().
+///
+/// A call that is already done, such as connecting to the server the connection is connected to, completes at once.
+/// A timeout or a cancellation only ends the wait: the call itself goes on, and Disconnect(), Logout() or
+/// LeaveChannel() take it back. The calls still waiting when this object is destroyed are not completed.
+///
+/// Like ClientConnection, this is to be created and called on the UI thread.
+///
+class AsyncClientConnection :
+    public IClientApiEventHandler
+{
+public:
+    AsyncClientConnection(ClientConnection *connection, IClientApiEventHandler *app);
+    virtual ~AsyncClientConnection();
+
+    ///
+    /// Each starts the ClientConnection call of the same name. When it returns 0, handler is called once with the outcome:
+    /// VX_E_REQUEST_CANCELED if the call was cancelled, did not complete in timeoutMilliseconds, or was taken back by
+    /// Disconnect(), Logout() or LeaveChannel() first. When it returns an error, the call did not start and handler is
+    /// not called.
+    ///
+    /// @param timeoutMilliseconds - 0 to wait as long as it takes
+    /// @param cancellation - NULL for none
+    ///
+    VCSStatus Connect(const Uri &server, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation, AsyncCompletionHandler handler);
+    VCSStatus Login(const AccountName &accountName, const char *accessToken, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation, AsyncCompletionHandler handler);
+    VCSStatus JoinChannel(const AccountName &accountName, const Uri &channelUri, const char *channelAccessToken, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation, AsyncCompletionHandler handler);
+
+#ifdef VIVOXCLIENTAPI_COROUTINES
+    ///
+    /// The same calls, to co_await for their status: VCSStatus status = co_await async.LoginAsync(accountName, token);
+    /// The call starts when it is awaited. The coroutine resumes on the thread the handler would be called on.
+    ///
+    AsyncCall ConnectAsync(const Uri &server, unsigned int timeoutMilliseconds = 0, const AsyncCancellation *cancellation = NULL);
+    AsyncCall LoginAsync(const AccountName &accountName, const char *accessToken, unsigned int timeoutMilliseconds = 0, const AsyncCancellation *cancellation = NULL);
+    AsyncCall JoinChannelAsync(const AccountName &accountName, const Uri &channelUri, const char *channelAccessToken, unsigned int timeoutMilliseconds = 0, const AsyncCancellation *cancellation = NULL);
+#endif
+
+    /// IClientApiEventHandler overrides, forwarded to the application
+
+    /// Basic System Services
+    virtual void InvokeOnUIThread(void(pf_func)(void *arg0), void *arg0);
+    virtual void onLogStatementEmitted(LogLevel level, long long nativeMillisecondsSinceEpoch, long threadId, const char *logMessage);
+    virtual void onAssert(const char *filename, int line, const char *message);
+
+    /// Service Connection
+    virtual void onConnectCompleted(const Uri &server);
+    virtual void onConnectCompletedEx(const Uri &server, vx_backend_type backendType, const char *connectorHandle);
+    virtual void onConnectFailed(const Uri &server, VCSStatus status);
+    virtual void onDisconnected(const Uri &server, VCSStatus status);
+
+    /// Logging/Logging out
+    virtual void onLoginCompleted(const AccountName &accountName);
+    virtual void onLoginCompletedEx(const AccountName &accountName, const char *accountHandle);
+    virtual void onInvalidLoginCredentials(const AccountName &accountName);
+    virtual void onLoginFailed(const AccountName &accountName, VCSStatus status);
+    virtual void onLogoutCompleted(const AccountName &accountName);
+    virtual void onLogoutFailed(const AccountName &accountName, VCSStatus status);
+
+    /// Getting into/out of channel
+    virtual void onChannelJoined(const AccountName &accountName, const Uri &channelUri);
+    virtual void onChannelJoinedEx(const AccountName &accountName, const Uri &channelUri, const char *sessionGroupHandle, const char *sessionHandle);
+    virtual void onInvalidChannelCredentials(const AccountName &accountName, const Uri &channelUri);
+    virtual void onChannelJoinFailed(const AccountName &accountName, const Uri &channelUri, VCSStatus status);
+    virtual void onChannelExited(const AccountName &accountName, const Uri &channelUri, VCSStatus reasonCode);
+    virtual void onCallStatsUpdated(const AccountName &accountName, vx_call_stats_t &stats, bool isFinal);
+
+    /// Roster list maintenance
+    virtual void onParticipantAdded(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser);
+    virtual void onParticipantLeft(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser, ParticipantLeftReason reason);
+    virtual void onParticipantUpdated(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser, bool speaking, double vuMeterEnergy, bool isMutedForAll);
+    virtual void onRosterChanged(const AccountName &accountName, const Uri &channelUri, const std::vector<RosterParticipant> &added, const std::vector<RosterParticipant> &removed, const std::vector<RosterParticipant> &updated);
+
+    /// Moderation and Audio Injection
+    virtual void onParticipantKickedCompleted(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri);
+    virtual void onParticipantKickFailed(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, VCSStatus status);
+    virtual void onStartPlayFileIntoChannels(const AccountName &accountName, const char *filename);
+    virtual void onStartPlayFileIntoChannelsFailed(const AccountName &accountName, const char *filename, VCSStatus status);
+    virtual void onPlayFileIntoChannelsStopped(const AccountName &accountName, const char *filename);
+
+    /// Audio Devices
+    virtual void onAvailableAudioDevicesChanged();
+    virtual void onDefaultSystemAudioInputDeviceChanged(const AudioDeviceId &deviceId);
+    virtual void onDefaultCommunicationAudioInputDeviceChanged(const AudioDeviceId &deviceId);
+    virtual void onSetAudioInputDeviceCompleted(const AudioDeviceId &deviceId);
+    virtual void onSetAudioInputDeviceFailed(const AudioDeviceId &deviceId, VCSStatus status);
+    virtual void onDefaultSystemAudioOutputDeviceChanged(const AudioDeviceId &deviceId);
+    virtual void onDefaultCommunicationAudioOutputDeviceChanged(const AudioDeviceId &deviceId);
+    virtual void onSetAudioOutputDeviceCompleted(const AudioDeviceId &deviceId);
+    virtual void onSetAudioOutputDeviceFailed(const AudioDeviceId &deviceId, VCSStatus status);
+
+    /// Volume and Muting
+    virtual void onSetChannelAudioOutputDeviceVolumeCompleted(const AccountName &accountName, const Uri &channelUri, int volume);
+    virtual void onSetChannelAudioOutputDeviceVolumeFailed(const AccountName &accountName, const Uri &channelUri, int volume, VCSStatus status);
+    virtual void onSetParticipantAudioOutputDeviceVolumeForMeCompleted(const AccountName &accountName, const Uri &targetUser, const Uri &channelUri, int volume);
+    virtual void onSetParticipantAudioOutputDeviceVolumeForMeFailed(const AccountName &accountName, const Uri &targetUser, const Uri &channelUri, int volume, VCSStatus status);
+    virtual void onSetParticipantMutedForAllCompleted(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted);
+    virtual void onSetParticipantMutedForAllFailed(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted, VCSStatus status);
+    virtual void onSetParticipantMutedForMeCompleted(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted);
+    virtual void onSetParticipantMutedForMeFailed(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted, VCSStatus status);
+
+    /// Transmission
+    virtual void onSetChannelTransmissionToSpecificChannelCompleted(const AccountName &accountName, const Uri &channelUri);
+    virtual void onSetChannelTransmissionToSpecificChannelFailed(const AccountName &accountName, const Uri &channelUri, VCSStatus status);
+    virtual void onSetChannelTransmissionToAllCompleted(const AccountName &accountName);
+    virtual void onSetChannelTransmissionToAllFailed(const AccountName &accountName, VCSStatus status);
+    virtual void onSetChannelTransmissionToNoneCompleted(const AccountName &accountName);
+    virtual void onSetChannelTransmissionToNoneFailed(const AccountName &accountName, VCSStatus status);
+
+    virtual void onSttTranscriptionReceived(const AccountName &accountName, const Uri &from, const Uri &channelUri, const char *text, const char *language, const char *displayName);
+    virtual void onAudioInputDeviceTestPlaybackCompleted();
+    virtual void onMuteAllFailed(const AccountName &accountName, const Uri &channelUri, bool muted, VCSStatus status);
+    virtual void onMuteAllCompleted(const AccountName &accountName, const Uri &channelUri, bool muted);
+    virtual void onSessionGroupRemoved(const AccountName &accountName, const char *sessionGroupHandle);
+    virtual void onGetStats(vx_resp_sessiongroup_get_stats *resp);
+
+    /// Audio Units
+    virtual void onAudioUnitStarted(const AccountName &accountName, const Uri &initial_target_uri);
+    virtual void onAudioUnitStopped(const AccountName &accountName, const Uri &initial_target_uri);
+    virtual void onAudioUnitAfterCaptureAudioRead(const AccountName &accountName, const Uri &initial_target_uri, short *pcm_frames, int pcm_frame_count, int audio_frame_rate, int channels_per_frame);
+    virtual void onAudioUnitBeforeCaptureAudioSent(const AccountName &accountName, const Uri &initial_target_uri, short *pcm_frames, int pcm_frame_count, int audio_frame_rate, int channels_per_frame, int is_speaking);
+    virtual void onAudioUnitBeforeRecvAudioRendered(const AccountName &accountName, const Uri &initial_target_uri, short *pcm_frames, int pcm_frame_count, int audio_frame_rate, int channels_per_frame, int is_silence);
+
+private:
+    friend class AsyncCancellation;
+
+    AsyncClientConnection(const AsyncClientConnection &); // disabled
+
+    typedef std::chrono::steady_clock Clock;
+
+    enum CallType {
+        CallConnect,
+        CallLogin,
+        CallJoinChannel
+    };
+
+    struct Call {
+        CallType type;
+        Uri server;
+        AccountName accountName;
+        Uri channelUri;
+        bool hasDeadline;
+        Clock::time_point deadline;
+        AsyncCancellation cancellation;
+        AsyncCompletionHandler handler;
+    };
+
+    // Registers the call before it is issued, so that a completion on another thread finds it. Returns false when the
+    // call has nothing to wait for, after completing it.
+    bool Add(Call &call, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation, unsigned long long &id);
+    void Remove(unsigned long long id);
+    // Completes the calls of a type that match the server, account name and channel given, any of them for NULL
+    void Complete(CallType type, const Uri *server, const AccountName *accountName, const Uri *channelUri, VCSStatus status);
+    // Completes the calls cancelled or past their deadline, on the UI thread
+    void CheckCalls();
+    static void CheckCallsOnUIThread(void *arg0);
+    void TimerThread();
+
+    ClientConnection *m_connection;
+    IClientApiEventHandler *m_app;
+    // For what is posted to the UI thread and the cancellations, which can outlive this object
+    std::shared_ptr<AsyncClientConnection *> m_self;
+
+    std::mutex m_mutex;
+    std::map<unsigned long long, Call> m_calls;
+    unsigned long long m_nextCallId;
+    // What the callbacks have reported done, for the calls that have nothing more to wait for
+    Uri m_connectedServer;
+    std::set<AccountName> m_loggedIn;
+    std::set<std::pair<AccountName, Uri> > m_joined;
+
+    // The deadlines the timer thread posts a CheckCalls() for, under m_mutex
+    std::multiset<Clock::time_point> m_deadlines;
+    std::condition_variable m_timerWake;
+    std::thread m_timerThread;
+    bool m_stopping;
+};
+
+#ifdef VIVOXCLIENTAPI_COROUTINES
+///
+/// An awaitable asynchronous call of AsyncClientConnection: co_await it once for its status.
+///
+class AsyncCall
+{
+public:
+    typedef std::function<VCSStatus(AsyncCompletionHandler handler)> Start;
+
+    explicit AsyncCall(Start start) :
+        m_start(std::move(start)),
+        m_state(std::make_shared<State>())
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> coroutine)
+    {
+        // The handler may run before the call returns, on this thread or the one it completes on
+        std::shared_ptr<State> state = m_state;
+        state->coroutine = coroutine;
+        VCSStatus status = m_start([state](VCSStatus result) {
+            state->status = result;
+            if (state->phase.exchange(PhaseCompleted) == PhaseSuspended) {
+                state->coroutine.resume();
+            }
+        });
+        if (status != 0) {
+            state->status = status;
+            return false;
+        }
+        return state->phase.exchange(PhaseSuspended) != PhaseCompleted;
+    }
+
+    VCSStatus await_resume() const noexcept { return m_state->status; }
+
+private:
+    enum Phase {
+        PhaseStarting,
+        PhaseSuspended,
+        PhaseCompleted
+    };
+
+    struct State {
+        State() : status(0), phase(PhaseStarting) {}
+        VCSStatus status;
+        std::atomic<int> phase;
+        std::coroutine_handle<> coroutine;
+    };
+
+    Start m_start;
+    std::shared_ptr<State> m_state;
+};
+
+///
+/// A coroutine that runs at once up to its first co_await, and frees itself when it ends. The simplest coroutine to
+/// write the steps of a session in:
+///
+///     AsyncTask JoinLobby(AsyncClientConnection &async, AccountName accountName, Uri channelUri)
+///     {
+///         VCSStatus status = co_await async.ConnectAsync(Uri(server), 10000);
+///         if (status == 0) status = co_await async.LoginAsync(accountName, token, 10000);
+///         if (status == 0) status = co_await async.JoinChannelAsync(accountName, channelUri, channelToken, 10000);
+///         ...
+///     }
+///
+/// Its arguments are copied into it, so take them by value. An exception that leaves it terminates the application.
+///
+struct AsyncTask {
+    struct promise_type {
+        AsyncTask get_return_object() noexcept { return AsyncTask(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+inline AsyncCall AsyncClientConnection::ConnectAsync(const Uri &server, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation)
+{
+    AsyncCancellation c = cancellation ? *cancellation : AsyncCancellation();
+    return AsyncCall([this, server, timeoutMilliseconds, c](AsyncCompletionHandler handler) {
+        return Connect(server, timeoutMilliseconds, &c, handler);
+    });
+}
+
+inline AsyncCall AsyncClientConnection::LoginAsync(const AccountName &accountName, const char *accessToken, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation)
+{
+    AsyncCancellation c = cancellation ? *cancellation : AsyncCancellation();
+    bool hasToken = accessToken != NULL;
+    std::string token(hasToken ? accessToken : "");
+    return AsyncCall([this, accountName, hasToken, token, timeoutMilliseconds, c](AsyncCompletionHandler handler) {
+        return Login(accountName, hasToken ? token.c_str() : NULL, timeoutMilliseconds, &c, handler);
+    });
+}
+
+inline AsyncCall AsyncClientConnection::JoinChannelAsync(const AccountName &accountName, const Uri &channelUri, const char *channelAccessToken, unsigned int timeoutMilliseconds, const AsyncCancellation *cancellation)
+{
+    AsyncCancellation c = cancellation ? *cancellation : AsyncCancellation();
+    bool hasToken = channelAccessToken != NULL;
+    std::string token(hasToken ? channelAccessToken : "");
+    return AsyncCall([this, accountName, channelUri, hasToken, token, timeoutMilliseconds, c](AsyncCompletionHandler handler) {
+        return JoinChannel(accountName, channelUri, hasToken ? token.c_str() : NULL, timeoutMilliseconds, &c, handler);
+    });
+}
+#endif
+}
@@ -18,6 +18,9 @@
 #include "uri.h"
 #include "accountname.h"
 #include "iclientapieventhandler.h"
+#include "positionupdatepolicy.h"
+#include "messagelogreplaystats.h"
+#include "messagedispatchstats.h"
 #include <set>
 #include <vector>
 
@@ -69,6 +72,8 @@ public:
     /// a channel will not affect existing joined channels. Depending on game play, the game might want to set this to either true or false.
     /// @param multiLogin - if this is true, a request to login one user will force any other users that are logged in by this game application instance to be logged out.
     /// It would be highly unusual for a game application to set this to true - it is used mostly for internal testing.
+    /// @param overrideAllocators - in VX_TEST_MEM_ALLOCATORS builds, if this is true, the SDK allocates its memory through the test hooks of
+    /// memallocators.h. See SetPoolAllocator() for VivoxClientApi::PoolAllocator.
     ///
     /// @return - 0 on success, non-zero on error. Error Codes can be translated to string by the function VivoxClientApi::GetErrorString(), which is located in util.h
     ///
@@ -76,6 +81,88 @@ public:
     VCSStatus Initialize(IClientApiEventHandler *app, IClientApiEventHandler::LogLevel logLevel, bool multiChannel = false, bool multiLogin = false, bool overrideAllocators = true, bool forceCaptureSilence = false);
     VCSStatus Initialize(IClientApiEventHandler *app, IClientApiEventHandler::LogLevel logLevel, bool multiChannel, bool multiLogin, bool overrideAllocators, unsigned int codecMask, int &inputBuffers, int &outputBuffers, bool forceCaptureSilence = false);
 
+    ///
+    /// Starts recording every request issued and every response and event received to a binary message log, replacing the file.
+    ///
+    /// The log is several times smaller and cheaper to write than the XML of the messages, and can be replayed with ReplayMessageLog().
+    /// See SDK/MessageLog/MessageLog.h for its format and what it leaves out.
+    ///
+    /// @param path - the file to write
+    /// @return 0 on success non zero on failure
+    ///
+    VCSStatus StartMessageLog(const char *path);
+
+    ///
+    /// Stops recording the message log started by StartMessageLog()
+    ///
+    void StopMessageLog();
+
+    ///
+    /// Dispatches the responses and events of a message log as if the SDK had just sent them, to the handlers and to the
+    /// IClientApiEventHandler of this connection. The requests of the log are not issued again.
+    ///
+    /// This blocks until the whole log is replayed, and must be called on the UI thread, like the rest of this class.
+    ///
+    /// @param path - the file written by StartMessageLog()
+    /// @param recordedSpeed - true to dispatch each message at the time it was received, relative to the first, false for as fast as possible
+    /// @param stats - receives the number of messages and the time spent dispatching them
+    /// @return 0 on success non zero on failure
+    ///
+    VCSStatus ReplayMessageLog(const char *path, bool recordedSpeed, MessageLogReplayStats &stats);
+
+    ///
+    /// The responses and events dispatched since Initialize(), or since the last reset, by type, with the time their
+    /// handlers took. Only the types received are listed, the most expensive first. Replayed messages count too.
+    ///
+    /// With login executors the messages of the logins are counted on the executors, as they are handled. Messages of
+    /// a type this connection does not handle are logged the first time, then at most once a minute for each type.
+    ///
+    /// @param stats - receives one entry for each type
+    /// @param reset - true to start counting again from zero
+    ///
+    void GetMessageDispatchStats(std::vector<MessageDispatchStats> &stats, bool reset);
+
+    ///
+    /// Handles the responses and events of each login on an executor of its own, on a pool of worker threads shared
+    /// by all logins, rather than all of them on the UI thread. For applications with many logins, which can then use
+    /// more than one core. Only with multiLogin, and to be called before Initialize().
+    ///
+    /// The UI thread then only hands each message to the executor of its login, and handles those of the connection
+    /// itself. The messages of a login are handled one at a time and in order, but those of different logins at the same
+    /// time: the IClientApiEventHandler callbacks for a login come from the pool, so they must be thread safe. They may
+    /// call the methods of this class that take an account name; the others, such as Connect() or the audio devices,
+    /// stay on the UI thread. A callback should not call for another login that may be calling back for its own.
+    ///
+    /// ReplayMessageLog() counts the time the executors take in the dispatch time. The messages of a log recorded without
+    /// executors do not reach the logins when it is replayed with them.
+    ///
+    /// @param threadCount - the number of worker threads, 0 (the default) for no executors
+    /// @return 0 on success non zero on failure
+    ///
+    VCSStatus SetLoginExecutorThreads(int threadCount);
+
+    ///
+    /// Has the SDK allocate its memory through VivoxClientApi::PoolAllocator (memallocators.h) instead of the system
+    /// heap. The pool keeps the memory it took from the system heap until the process exits, so its footprint is the
+    /// peak use of the SDK. To be called before Initialize().
+    ///
+    /// @param usePool - true for the pool allocator, false (the default) for the system heap
+    /// @return 0 on success non zero on failure
+    ///
+    VCSStatus SetPoolAllocator(bool usePool);
+
+    ///
+    /// Reports the changes to the roster of each channel through IClientApiEventHandler::onRosterChanged(), once per
+    /// channel and batch of responses and events, instead of calling onParticipantAdded(), onParticipantLeft() and
+    /// onParticipantUpdated() for every event. For applications that rebuild their roster UI on each change. A batch is
+    /// the responses and events the connection takes from the SDK at once, or all of ReplayMessageLog() unless it
+    /// replays at the recorded speed. To be called before Initialize().
+    ///
+    /// @param batching - true for onRosterChanged(), false (the default) for the per event callbacks
+    /// @return 0 on success non zero on failure
+    ///
+    VCSStatus SetRosterBatching(bool batching);
+
     ///
     /// Before exiting, the game application must call Uninitialize(). This will gracefully cleanup any resources that have been allocated by Vivox client software.
     ///
@@ -601,6 +688,17 @@ public:
     ///
     ChannelTransmissionPolicy GetChannelTransmissionPolicy(const AccountName &accountName) const;
 
+    ///
+    /// A number that changes whenever what GetChannelAudioOutputDeviceVolume(), GetParticipantAudioOutputDeviceVolumeForMe(),
+    /// GetParticipantMutedForAll() or GetChannelTransmissionPolicy() return may have changed, so that an application
+    /// reading them every frame can skip the work when it has not.
+    ///
+    /// Outside of the IClientApiEventHandler callbacks, these getters read a snapshot of the logins published after
+    /// each batch of responses and events rather than the logins themselves: they never wait for the handling of the
+    /// SDK messages, and may be called from any thread. From a callback, they read the logins as before.
+    ///
+    unsigned long long GetStateGeneration() const;
+
     ///
     /// Sets a participant's transmitting channel to channelUri
     ///
@@ -627,6 +725,36 @@ public:
     ///
     VCSStatus Set3DPosition(const AccountName &accountName, const Uri &channel, double x, double y, double z, double at_x, double at_y, double at_z);
 
+    ///
+    /// Gets the policy limiting how often Set3DPosition() sends a position to the server
+    ///
+    /// @param accountName - the account of the currently logged in user
+    /// @return the position update policy for the specific user
+    ///
+    PositionUpdatePolicy Get3DPositionUpdatePolicy(const AccountName &accountName) const;
+
+    ///
+    /// Sets the policy limiting how often Set3DPosition() sends a position to the server, for all the positional channels of the user.
+    ///
+    /// There is no rate limit by default. Games calling Set3DPosition() every frame should set one; see PositionUpdatePolicy.
+    ///
+    /// @param accountName - the account of the currently logged in user
+    /// @param policy - the rate, thresholds and extrapolation to apply
+    /// @return 0 on success non zero on failure
+    ///
+    VCSStatus Set3DPositionUpdatePolicy(const AccountName &accountName, const PositionUpdatePolicy &policy);
+
+    ///
+    /// Gets the number of positions sent and suppressed for a channel since it was joined or since the last reset
+    ///
+    /// @param accountName - the account of the currently logged in user
+    /// @param channel - the URI of the channel
+    /// @param stats - receives the counters
+    /// @param reset - true to reset the counters after reading them
+    /// @return 0 on success non zero on failure
+    ///
+    VCSStatus Get3DPositionUpdateStats(const AccountName &accountName, const Uri &channel, PositionUpdateStats &stats, bool reset);
+
     ///
     /// Sets a participant's transmitting channel to all channels
     ///
@@ -241,6 +241,13 @@ void DebugClientApiEventHandler::onParticipantUpdated(const AccountName &account
         "," << (mutedForAll ? "muted for all" : "not muted for all") << ")\r\n";
     WriteStatus(ss.str().c_str());
 }
+void DebugClientApiEventHandler::onRosterChanged(const AccountName &accountName, const Uri &channelUri, const std::vector<RosterParticipant> &added, const std::vector<RosterParticipant> &removed, const std::vector<RosterParticipant> &updated)
+{
+    stringstream ss;
+    ss << PREFIX << __FUNCTION__ << "(" << accountName.ToString() << "," << channelUri.ToString() << "," << added.size() << " added," <<
+        removed.size() << " removed," << updated.size() << " updated)\r\n";
+    WriteStatus(ss.str().c_str());
+}
 
 // Moderation
 void DebugClientApiEventHandler::onParticipantKickedCompleted(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri)
@@ -77,6 +77,7 @@ public:
     virtual void onParticipantAdded(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser);
     virtual void onParticipantLeft(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser, ParticipantLeftReason reason);
     virtual void onParticipantUpdated(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser, bool speaking, double vuMeterEnergy, bool mutedForAll);
+    virtual void onRosterChanged(const AccountName &accountName, const Uri &channelUri, const std::vector<RosterParticipant> &added, const std::vector<RosterParticipant> &removed, const std::vector<RosterParticipant> &updated);
 
     /// Moderation
     virtual void onParticipantKickedCompleted(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri);
@@ -15,6 +15,7 @@
 */
 
 #include <stdlib.h>
+#include <vector>
 
 #include "accountname.h"
 #include "util.h"
@@ -22,6 +23,7 @@
 #include "audiodeviceid.h"
 #include "audiodevicepolicy.h"
 #include "channeltransmissionpolicy.h"
+#include "rosterparticipant.h"
 #include "VxcEvents.h"
 #include "VxcResponses.h"
 
@@ -305,6 +307,28 @@ public:
     ///
     virtual void onParticipantUpdated(const AccountName &accountName, const Uri &channelUri, const Uri &participantUri, bool isLoggedInUser, bool speaking, double vuMeterEnergy, bool isMutedForAll) = 0;
 
+    ///
+    /// With ClientConnection::SetRosterBatching(), this function is called instead of onParticipantAdded(),
+    /// onParticipantLeft() and onParticipantUpdated(), once for each channel whose roster changed in a batch of
+    /// responses and events. Each participant appears at most once, in the list of its net change over the batch: one
+    /// that joined and left again appears in none, one that left and joined again is updated, and one updated several
+    /// times appears once with its latest state.
+    ///
+    /// @param accountName - the account name of the logged in user
+    /// @param channelUri - the channel whose roster changed
+    /// @param added - the participants that joined the channel
+    /// @param removed - the participants that left the channel, with their last state and the reason they left
+    /// @param updated - the participants that were in the channel before and still are, with their latest state
+    ///
+    virtual void onRosterChanged(const AccountName &accountName, const Uri &channelUri, const std::vector<RosterParticipant> &added, const std::vector<RosterParticipant> &removed, const std::vector<RosterParticipant> &updated)
+    {
+        (void)accountName;
+        (void)channelUri;
+        (void)added;
+        (void)removed;
+        (void)updated;
+    }
+
     /// Moderation
 
     ///
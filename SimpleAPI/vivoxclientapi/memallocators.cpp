@@ -16,6 +16,18 @@
 # include "vivoxclientapi/memallocators.h"
 #   include <malloc.h>
 # include <memory.h>
+# include <stdio.h>
+# include <string.h>
+# include <assert.h>
+# include <atomic>
+# include <chrono>
+# include <mutex>
+# include <thread>
+# include <unordered_map>
+# include <vector>
+# ifdef _MSC_VER
+#   include <intrin.h>
+# endif
 
 #   define update_allocated_by_allocators(x)
 
@@ -99,3 +111,707 @@ void pf_free_aligned_func(void *memory)
 }
 }
 # endif // VX_TEST_MEM_ALLOCATORS
+
+namespace VivoxClientApi {
+namespace {
+// Precedes every block handed out, including the large ones.
+struct BlockHeader {
+    uint32_t tag;       // c_uiTagMagic | size class
+    uint32_t offset;    // from the start of the raw block to the user pointer
+    uint64_t size;      // requested size
+};
+
+const uint32_t c_uiTagMagic = 0x5ea10000;
+const uint32_t c_uiTagMask = 0xffff0000;
+const size_t c_nHeaderBytes = sizeof(BlockHeader);
+const size_t c_nNaturalAlignment = 8;   // what the system heap guarantees on every platform we build for
+const size_t c_nSmallClasses = 8;       // 16 to 128 bytes in 16 byte steps
+const size_t c_nClasses = c_nSmallClasses + 4 * 8;  // then 4 classes per power of two up to 32 KB
+const size_t c_nMaxPooledBytes = 32 * 1024;
+const uint32_t c_uiLargeClass = 0xffff;
+const size_t c_nSlabBytes = 64 * 1024;
+const size_t c_nMaxBatch = 32;
+
+inline size_t ClassCapacity(size_t sizeClass)
+{
+    if (sizeClass < c_nSmallClasses) {
+        return (sizeClass + 1) * 16;
+    }
+    size_t k = sizeClass - c_nSmallClasses;
+    return (k % 4 + 5) << (k / 4 + 5);
+}
+
+// need is at least one and at most c_nMaxPooledBytes
+inline size_t ClassOf(size_t need)
+{
+    if (need <= c_nSmallClasses * 16) {
+        return (need + 15) / 16 - 1;
+    }
+    uint32_t b = (uint32_t)(need - 1);
+# ifdef _MSC_VER
+    unsigned long msb;
+    _BitScanReverse(&msb, b);
+# else
+    unsigned int msb = 31 - __builtin_clz(b);
+# endif
+    return c_nSmallClasses + (msb - 7) * 4 + ((b >> (msb - 2)) - 4);
+}
+
+inline size_t BatchSize(size_t sizeClass)
+{
+    size_t perSlab = c_nSlabBytes / ClassCapacity(sizeClass);
+    return perSlab < c_nMaxBatch ? perSlab : c_nMaxBatch;
+}
+
+inline void *&NextFree(void *block)
+{
+    return *(void **)block;
+}
+
+struct CentralList {
+    std::mutex m_mutex;
+    void *m_head;
+};
+CentralList s_central[c_nClasses];
+
+std::atomic<long long> s_liveBytes(0);
+std::atomic<long long> s_peakBytes(0);
+std::atomic<long long> s_liveBlocks(0);
+std::atomic<long long> s_allocs(0);
+std::atomic<long long> s_frees(0);
+std::atomic<long long> s_largeAllocs(0);
+std::atomic<long long> s_slabBytes(0);
+
+enum {
+    cacheUnused = 0,
+    cacheActive,
+    cacheReleased
+};
+
+// Plain data so that it is usable before and after the thread's destructors run.
+struct ThreadCache {
+    void *m_heads[c_nClasses];
+    uint32_t m_counts[c_nClasses];
+    int m_state;
+};
+thread_local ThreadCache t_cache;
+
+void ReturnToCentral(size_t sizeClass, void *head, void *tail)
+{
+    CentralList &central = s_central[sizeClass];
+    std::lock_guard<std::mutex> lock(central.m_mutex);
+    NextFree(tail) = central.m_head;
+    central.m_head = head;
+}
+
+// Gives the cached blocks back when the thread exits, so they are not lost with it.
+class ThreadCacheReleaser
+{
+public:
+    void Arm() {}
+    ~ThreadCacheReleaser()
+    {
+        for (size_t i = 0; i < c_nClasses; ++i) {
+            void *head = t_cache.m_heads[i];
+            if (head != NULL) {
+                void *tail = head;
+                while (NextFree(tail) != NULL) {
+                    tail = NextFree(tail);
+                }
+                ReturnToCentral(i, head, tail);
+            }
+            t_cache.m_heads[i] = NULL;
+            t_cache.m_counts[i] = 0;
+        }
+        t_cache.m_state = cacheReleased;
+    }
+};
+thread_local ThreadCacheReleaser t_cacheReleaser;
+
+// Returns NULL once the thread has started exiting; the caller then uses the central lists.
+inline ThreadCache *GetThreadCache()
+{
+    ThreadCache *cache = &t_cache;
+    if (cache->m_state == cacheActive) {
+        return cache;
+    }
+    if (cache->m_state == cacheReleased) {
+        return NULL;
+    }
+    cache->m_state = cacheActive;
+    t_cacheReleaser.Arm();
+    return cache;
+}
+
+// Takes up to count blocks off the central list, carving a new slab if it is empty.
+// Returns the number of blocks linked from head.
+size_t TakeFromCentral(size_t sizeClass, size_t count, void *&head)
+{
+    CentralList &central = s_central[sizeClass];
+    size_t taken = 0;
+    head = NULL;
+    {
+        std::lock_guard<std::mutex> lock(central.m_mutex);
+        void *tail = NULL;
+        while (taken < count && central.m_head != NULL) {
+            void *block = central.m_head;
+            central.m_head = NextFree(block);
+            if (tail == NULL) {
+                head = block;
+            } else {
+                NextFree(tail) = block;
+            }
+            tail = block;
+            ++taken;
+        }
+        if (tail != NULL) {
+            NextFree(tail) = NULL;
+            return taken;
+        }
+    }
+
+    char *slab = (char *)malloc(c_nSlabBytes);
+    if (slab == NULL) {
+        return 0;
+    }
+    s_slabBytes.fetch_add(c_nSlabBytes, std::memory_order_relaxed);
+    size_t capacity = ClassCapacity(sizeClass);
+    size_t blocks = c_nSlabBytes / capacity;
+    for (size_t i = 0; i < blocks; ++i) {
+        NextFree(slab + i * capacity) = i + 1 < blocks ? slab + (i + 1) * capacity : NULL;
+    }
+    head = slab;
+    if (blocks > count) {
+        NextFree(slab + (count - 1) * capacity) = NULL;
+        ReturnToCentral(sizeClass, slab + count * capacity, slab + (blocks - 1) * capacity);
+        blocks = count;
+    }
+    return blocks;
+}
+
+void *PopBlock(size_t sizeClass)
+{
+    ThreadCache *cache = GetThreadCache();
+    void *block;
+    if (cache == NULL) {
+        TakeFromCentral(sizeClass, 1, block);
+        return block;
+    }
+    block = cache->m_heads[sizeClass];
+    if (block == NULL) {
+        size_t taken = TakeFromCentral(sizeClass, BatchSize(sizeClass), block);
+        if (taken == 0) {
+            return NULL;
+        }
+        cache->m_counts[sizeClass] = (uint32_t)taken;
+    }
+    cache->m_heads[sizeClass] = NextFree(block);
+    cache->m_counts[sizeClass]--;
+    return block;
+}
+
+void PushBlock(size_t sizeClass, void *block)
+{
+    ThreadCache *cache = GetThreadCache();
+    if (cache == NULL) {
+        ReturnToCentral(sizeClass, block, block);
+        return;
+    }
+    NextFree(block) = cache->m_heads[sizeClass];
+    cache->m_heads[sizeClass] = block;
+    size_t batch = BatchSize(sizeClass);
+    if (++cache->m_counts[sizeClass] > 2 * batch) {
+        // keep the most recently freed half, it is the most likely to be in the cache
+        void *keepTail = block;
+        for (size_t i = 1; i < batch; ++i) {
+            keepTail = NextFree(keepTail);
+        }
+        void *head = NextFree(keepTail);
+        void *tail = head;
+        while (NextFree(tail) != NULL) {
+            tail = NextFree(tail);
+        }
+        NextFree(keepTail) = NULL;
+        cache->m_counts[sizeClass] = (uint32_t)batch;
+        ReturnToCentral(sizeClass, head, tail);
+    }
+}
+
+void CountAllocation(size_t bytes)
+{
+    long long live = s_liveBytes.fetch_add((long long)bytes, std::memory_order_relaxed) + (long long)bytes;
+    long long peak = s_peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !s_peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    s_liveBlocks.fetch_add(1, std::memory_order_relaxed);
+    s_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CountFree(size_t bytes)
+{
+    s_liveBytes.fetch_sub((long long)bytes, std::memory_order_relaxed);
+    s_liveBlocks.fetch_sub(1, std::memory_order_relaxed);
+    s_frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline BlockHeader *HeaderOf(void *memory)
+{
+    BlockHeader *header = (BlockHeader *)((char *)memory - c_nHeaderBytes);
+    assert((header->tag & c_uiTagMask) == c_uiTagMagic);
+    return header;
+}
+
+// alignment is zero or a power of two
+void *Allocate(size_t bytes, size_t alignment)
+{
+    if (alignment <= c_nNaturalAlignment) {
+        alignment = 0;
+    }
+    if (bytes > (size_t)-1 / 2 - alignment) {
+        return NULL;
+    }
+    size_t need = c_nHeaderBytes + bytes + (alignment != 0 ? alignment - 1 : 0);
+    uint32_t sizeClass;
+    char *raw;
+    if (need <= c_nMaxPooledBytes) {
+        sizeClass = (uint32_t)ClassOf(need);
+        raw = (char *)PopBlock(sizeClass);
+    } else {
+        sizeClass = c_uiLargeClass;
+        raw = (char *)malloc(need);
+        s_largeAllocs.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (raw == NULL) {
+        return NULL;
+    }
+    char *user = raw + c_nHeaderBytes;
+    if (alignment != 0) {
+        user = (char *)(((uintptr_t)user + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+    BlockHeader *header = (BlockHeader *)(user - c_nHeaderBytes);
+    header->tag = c_uiTagMagic | sizeClass;
+    header->offset = (uint32_t)(user - raw);
+    header->size = bytes;
+    CountAllocation(bytes);
+    return user;
+}
+
+void Release(void *memory)
+{
+    if (memory == NULL) {
+        return;
+    }
+    BlockHeader *header = HeaderOf(memory);
+    uint32_t sizeClass = header->tag & ~c_uiTagMask;
+    char *raw = (char *)memory - header->offset;
+    CountFree((size_t)header->size);
+    header->tag = 0;
+    if (sizeClass == c_uiLargeClass) {
+        free(raw);
+    } else {
+        PushBlock(sizeClass, raw);
+    }
+}
+
+void *Reallocate(void *memory, size_t bytes)
+{
+    if (memory == NULL) {
+        return Allocate(bytes, 0);
+    }
+    if (bytes == 0) {
+        Release(memory);
+        return NULL;
+    }
+    BlockHeader *header = HeaderOf(memory);
+    uint32_t sizeClass = header->tag & ~c_uiTagMask;
+    size_t oldBytes = (size_t)header->size;
+    if (header->offset == c_nHeaderBytes && bytes <= (size_t)-1 / 2) {
+        size_t need = c_nHeaderBytes + bytes;
+        if (sizeClass == c_uiLargeClass && need > c_nMaxPooledBytes) {
+            char *raw = (char *)realloc(header, need);
+            if (raw == NULL) {
+                return NULL;
+            }
+            header = (BlockHeader *)raw;
+            header->size = bytes;
+            CountFree(oldBytes);
+            CountAllocation(bytes);
+            return raw + c_nHeaderBytes;
+        }
+        // stay in place unless the block would be less than half used
+        if (sizeClass != c_uiLargeClass && need <= ClassCapacity(sizeClass) && 2 * need > ClassCapacity(sizeClass)) {
+            header->size = bytes;
+            CountFree(oldBytes);
+            CountAllocation(bytes);
+            return memory;
+        }
+    }
+    void *p = Allocate(bytes, 0);
+    if (p == NULL) {
+        return NULL;
+    }
+    memcpy(p, memory, oldBytes < bytes ? oldBytes : bytes);
+    Release(memory);
+    return p;
+}
+
+//
+// Tracing
+//
+enum TraceOp {
+    traceMalloc = 1,
+    traceCalloc,
+    traceRealloc,
+    traceFree,
+    traceMallocAligned,
+    traceFreeAligned
+};
+
+struct TraceRecord {
+    uint8_t op;
+    uint8_t reserved[3];
+    uint32_t thread;
+    uint64_t size;
+    uint64_t alignment;
+    uint64_t memory;    // argument of realloc and free
+    uint64_t result;    // returned by malloc, calloc and realloc
+};
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordBytes;
+    uint64_t records;
+};
+
+const char c_traceMagic[8] = { 'V', 'X', 'A', 'T', 'R', 'A', 'C', 'E' };
+const uint32_t c_uiTraceVersion = 1;
+
+std::atomic<bool> s_tracing(false);
+std::mutex s_traceMutex;
+std::vector<TraceRecord> *s_trace = NULL;
+size_t s_traceMaxRecords = 0;
+FILE *s_traceFile = NULL;
+std::atomic<uint32_t> s_nextTraceThread(0);
+thread_local uint32_t t_traceThread = 0;
+
+// Runs op and records it. Both happen under s_traceMutex, so that the order of the records
+// is the order in which blocks were really handed out and returned.
+template<class Op>
+void *Traced(TraceOp traceOp, size_t size, size_t alignment, void *memory, Op op)
+{
+    if (!s_tracing.load(std::memory_order_relaxed)) {
+        return op();
+    }
+    if (t_traceThread == 0) {
+        t_traceThread = ++s_nextTraceThread;
+    }
+    std::lock_guard<std::mutex> lock(s_traceMutex);
+    void *result = op();
+    if (s_trace != NULL && s_trace->size() < s_traceMaxRecords) {
+        TraceRecord record;
+        memset(&record, 0, sizeof(record));
+        record.op = (uint8_t)traceOp;
+        record.thread = t_traceThread;
+        record.size = size;
+        record.alignment = alignment;
+        record.memory = (uint64_t)(uintptr_t)memory;
+        record.result = (uint64_t)(uintptr_t)result;
+        s_trace->push_back(record);
+    }
+    return result;
+}
+
+//
+// Replay
+//
+struct ReplayOp {
+    uint8_t op;
+    uint32_t slot;
+    size_t size;
+    size_t alignment;
+};
+
+// Turns the recorded pointers into indexes of live blocks, so the trace can be replayed by any
+// number of threads at once. Calls on blocks allocated before the trace started are dropped.
+void PrepareReplay(const std::vector<TraceRecord> &records, std::vector<ReplayOp> &ops, size_t &slots)
+{
+    std::unordered_map<uint64_t, uint32_t> live;
+    std::vector<uint32_t> freeSlots;
+    slots = 0;
+    ops.clear();
+    ops.reserve(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        const TraceRecord &r = records[i];
+        ReplayOp op;
+        op.op = r.op;
+        op.size = (size_t)r.size;
+        op.alignment = (size_t)r.alignment;
+        bool releases = r.op == traceFree || r.op == traceFreeAligned || r.op == traceRealloc;
+        if (r.op == traceRealloc && r.result == 0 && r.size != 0) {
+            continue;   // failed, the block is still there
+        }
+        std::unordered_map<uint64_t, uint32_t>::iterator it = releases ? live.find(r.memory) : live.end();
+        if (it != live.end()) {
+            op.slot = it->second;
+            live.erase(it);
+            if (r.result != 0) {
+                live[r.result] = op.slot;
+            } else {
+                freeSlots.push_back(op.slot);
+            }
+            ops.push_back(op);
+            continue;
+        }
+        if (r.op == traceFree || r.op == traceFreeAligned) {
+            continue;
+        }
+        if (r.op == traceRealloc) {
+            op.op = traceMalloc;
+        }
+        if (r.result == 0) {
+            continue;
+        }
+        if (freeSlots.empty()) {
+            op.slot = (uint32_t)slots++;
+        } else {
+            op.slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        // a second allocation at the same address means the free that came between was not traced
+        live[r.result] = op.slot;
+        ops.push_back(op);
+    }
+}
+
+void *SystemMallocAligned(size_t alignment, size_t bytes)
+{
+# ifdef _WIN32
+    return _aligned_malloc(bytes, alignment);
+# else
+    void *p = NULL;
+    return posix_memalign(&p, alignment < sizeof(void *) ? sizeof(void *) : alignment, bytes) == 0 ? p : NULL;
+# endif
+}
+
+void SystemFreeAligned(void *memory)
+{
+# ifdef _WIN32
+    _aligned_free(memory);
+# else
+    free(memory);
+# endif
+}
+
+void ReplayThread(const std::vector<ReplayOp> &ops, size_t slotCount, bool useSystemHeap)
+{
+    std::vector<void *> slots(slotCount, (void *)NULL);
+    std::vector<bool> aligned(slotCount, false);
+    for (size_t i = 0; i < ops.size(); ++i) {
+        const ReplayOp &op = ops[i];
+        void *&slot = slots[op.slot];
+        switch (op.op) {
+            case traceMalloc:
+                slot = useSystemHeap ? malloc(op.size) : PoolAllocator::Malloc(op.size);
+                aligned[op.slot] = false;
+                break;
+            case traceCalloc:
+                slot = useSystemHeap ? calloc(1, op.size) : PoolAllocator::Calloc(1, op.size);
+                aligned[op.slot] = false;
+                break;
+            case traceMallocAligned:
+                slot = useSystemHeap ? SystemMallocAligned(op.alignment, op.size) : PoolAllocator::MallocAligned(op.alignment, op.size);
+                aligned[op.slot] = true;
+                break;
+            case traceRealloc:
+                slot = useSystemHeap ? realloc(slot, op.size) : PoolAllocator::Realloc(slot, op.size);
+                break;
+            case traceFree:
+            case traceFreeAligned:
+                if (useSystemHeap) {
+                    if (aligned[op.slot]) {
+                        SystemFreeAligned(slot);
+                    } else {
+                        free(slot);
+                    }
+                } else {
+                    PoolAllocator::Free(slot);
+                }
+                slot = NULL;
+                continue;
+        }
+        if (slot != NULL && op.size != 0) {
+            // touch the block the way a caller would
+            *(volatile char *)slot = 0;
+        }
+    }
+    for (size_t i = 0; i < slotCount; ++i) {
+        if (slots[i] != NULL) {
+            if (!useSystemHeap) {
+                PoolAllocator::Free(slots[i]);
+            } else if (aligned[i]) {
+                SystemFreeAligned(slots[i]);
+            } else {
+                free(slots[i]);
+            }
+        }
+    }
+}
+}
+
+void *PoolAllocator::Malloc(size_t bytes)
+{
+    return Traced(traceMalloc, bytes, 0, NULL, [&]() {
+        return Allocate(bytes, 0);
+    });
+}
+
+void *PoolAllocator::Calloc(size_t num, size_t bytes)
+{
+    if (bytes != 0 && num > (size_t)-1 / bytes) {
+        return NULL;
+    }
+    return Traced(traceCalloc, num * bytes, 0, NULL, [&]() {
+        void *p = Allocate(num * bytes, 0);
+        if (p != NULL) {
+            memset(p, 0, num * bytes);
+        }
+        return p;
+    });
+}
+
+void *PoolAllocator::Realloc(void *memory, size_t bytes)
+{
+    return Traced(traceRealloc, bytes, 0, memory, [&]() {
+        return Reallocate(memory, bytes);
+    });
+}
+
+void PoolAllocator::Free(void *memory)
+{
+    Traced(traceFree, 0, 0, memory, [&]() {
+        Release(memory);
+        return (void *)NULL;
+    });
+}
+
+void *PoolAllocator::MallocAligned(size_t alignment, size_t bytes)
+{
+    if (alignment & (alignment - 1)) {
+        return NULL;
+    }
+    return Traced(traceMallocAligned, bytes, alignment, NULL, [&]() {
+        return Allocate(bytes, alignment);
+    });
+}
+
+void PoolAllocator::FreeAligned(void *memory)
+{
+    Traced(traceFreeAligned, 0, 0, memory, [&]() {
+        Release(memory);
+        return (void *)NULL;
+    });
+}
+
+void PoolAllocator::GetStats(Stats &stats)
+{
+    stats.liveBytes = s_liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = s_peakBytes.load(std::memory_order_relaxed);
+    stats.liveBlocks = s_liveBlocks.load(std::memory_order_relaxed);
+    stats.allocs = s_allocs.load(std::memory_order_relaxed);
+    stats.frees = s_frees.load(std::memory_order_relaxed);
+    stats.largeAllocs = s_largeAllocs.load(std::memory_order_relaxed);
+    stats.slabBytes = s_slabBytes.load(std::memory_order_relaxed);
+}
+
+bool PoolAllocator::StartTrace(const char *fileName, size_t maxRecords)
+{
+    std::lock_guard<std::mutex> lock(s_traceMutex);
+    if (s_trace != NULL) {
+        return false;
+    }
+    FILE *fp = NULL;
+    fopen_s(&fp, fileName, "wb");
+    if (fp == NULL) {
+        return false;
+    }
+    s_traceFile = fp;
+    s_traceMaxRecords = maxRecords;
+    s_trace = new std::vector<TraceRecord>();
+    s_tracing = true;
+    return true;
+}
+
+bool PoolAllocator::StopTrace()
+{
+    std::vector<TraceRecord> *trace;
+    FILE *fp;
+    {
+        std::lock_guard<std::mutex> lock(s_traceMutex);
+        if (s_trace == NULL) {
+            return false;
+        }
+        s_tracing = false;
+        trace = s_trace;
+        fp = s_traceFile;
+        s_trace = NULL;
+        s_traceFile = NULL;
+    }
+    TraceFileHeader header;
+    memcpy(header.magic, c_traceMagic, sizeof(header.magic));
+    header.version = c_uiTraceVersion;
+    header.recordBytes = sizeof(TraceRecord);
+    header.records = trace->size();
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (ok && !trace->empty()) {
+        ok = fwrite(&(*trace)[0], sizeof(TraceRecord), trace->size(), fp) == trace->size();
+    }
+    ok = fclose(fp) == 0 && ok;
+    delete trace;
+    return ok;
+}
+
+bool PoolAllocator::ReplayTrace(const char *fileName, int threads, bool useSystemHeap, ReplayResult &result)
+{
+    result.seconds = 0;
+    result.operations = 0;
+    if (threads < 1) {
+        return false;
+    }
+    FILE *fp = NULL;
+    fopen_s(&fp, fileName, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    TraceFileHeader header;
+    std::vector<TraceRecord> records;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1
+        && memcmp(header.magic, c_traceMagic, sizeof(header.magic)) == 0
+        && header.version == c_uiTraceVersion
+        && header.recordBytes == sizeof(TraceRecord);
+    if (ok && header.records != 0) {
+        records.resize((size_t)header.records);
+        ok = fread(&records[0], sizeof(TraceRecord), records.size(), fp) == records.size();
+    }
+    fclose(fp);
+    if (!ok) {
+        return false;
+    }
+
+    std::vector<ReplayOp> ops;
+    size_t slots;
+    PrepareReplay(records, ops, slots);
+
+    std::vector<std::thread> workers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; ++i) {
+        workers.push_back(std::thread(ReplayThread, std::cref(ops), slots, useSystemHeap));
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.operations = (long long)ops.size() * threads;
+    return true;
+}
+}
@@ -17,6 +17,7 @@
 
 
 # include <stdlib.h>
+# include <stdint.h>
 
 # ifdef VX_TEST_MEM_ALLOCATORS
 extern "C" {
@@ -28,3 +29,57 @@ void  pf_free_func(void *memory);
 void  pf_free_aligned_func(void *memory);
 };
 # endif
+
+namespace VivoxClientApi {
+///
+/// Size class pool allocator for the vx_sdk_config_t memory hooks, installed by ClientConnection::Initialize()
+/// after ClientConnection::SetPoolAllocator(true) (unless VX_TEST_MEM_ALLOCATORS selects the test hooks above).
+///
+/// Blocks up to 32 KB come from slabs of one size class each, with 4 classes per power of two. Every thread
+/// keeps a small cache of free blocks per class and only takes the class lock to move a batch of blocks
+/// between its cache and the shared free list. Slabs are kept until the process exits. Larger blocks go to
+/// the system heap. Aligned allocations honor any power of two alignment.
+///
+class PoolAllocator
+{
+public:
+    static void *Malloc(size_t bytes);
+    static void *Calloc(size_t num, size_t bytes);
+    static void *Realloc(void *memory, size_t bytes);
+    static void  Free(void *memory);
+    static void *MallocAligned(size_t alignment, size_t bytes);
+    static void  FreeAligned(void *memory);
+
+    ///
+    /// Counters maintained with atomic operations, so a snapshot can be taken from any thread.
+    /// Byte counts are the sizes requested by the callers.
+    ///
+    struct Stats {
+        long long liveBytes;
+        long long peakBytes;
+        long long liveBlocks;
+        long long allocs;
+        long long frees;
+        long long largeAllocs;
+        long long slabBytes;    ///< memory taken from the system for slabs
+    };
+    static void GetStats(Stats &stats);
+
+    ///
+    /// Records every call to the hooks, from StartTrace() to StopTrace(), into a file that ReplayTrace() can read.
+    /// At most maxRecords calls are kept.
+    ///
+    static bool StartTrace(const char *fileName, size_t maxRecords = 4 * 1024 * 1024);
+    static bool StopTrace();
+
+    struct ReplayResult {
+        double seconds;
+        long long operations;
+    };
+    ///
+    /// Replays a recorded trace on the given number of threads at once, each thread replaying the whole trace
+    /// against either this allocator or the system heap. Returns false if the trace can't be read.
+    ///
+    static bool ReplayTrace(const char *fileName, int threads, bool useSystemHeap, ReplayResult &result);
+};
+}
@@ -0,0 +1,101 @@
+#pragma once
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+
+
+namespace VivoxClientApi {
+///
+/// The responses or events of one type dispatched by a ClientConnection, see ClientConnection::GetMessageDispatchStats().
+///
+/// Handler seconds is the time spent in the handlers of the connection for that type, including the
+/// IClientApiEventHandler callbacks made from them. Messages of a type the connection has no handler for are counted
+/// too, with IsHandled() false.
+///
+class MessageDispatchStats
+{
+public:
+    MessageDispatchStats()
+    {
+        m_event = false;
+        m_type = 0;
+        m_typeName = "";
+        m_handled = false;
+        m_messages = 0;
+        m_handlerSeconds = 0;
+    }
+
+    ///
+    /// True for an event, false for a response
+    ///
+    bool IsEvent() const
+    {
+        return m_event;
+    }
+    ///
+    /// The vx_event_type or vx_response_type of the messages
+    ///
+    int GetType() const
+    {
+        return m_type;
+    }
+    const char *GetTypeName() const
+    {
+        return m_typeName;
+    }
+    bool IsHandled() const
+    {
+        return m_handled;
+    }
+    unsigned long long GetMessages() const
+    {
+        return m_messages;
+    }
+    double GetHandlerSeconds() const
+    {
+        return m_handlerSeconds;
+    }
+    double GetMeanHandlerMicroseconds() const
+    {
+        return m_messages > 0 ? m_handlerSeconds * 1e6 / m_messages : 0;
+    }
+
+    void SetType(bool event, int type, const char *typeName)
+    {
+        m_event = event;
+        m_type = type;
+        m_typeName = typeName != 0 ? typeName : "";
+    }
+    void SetHandled(bool value)
+    {
+        m_handled = value;
+    }
+    void SetMessages(unsigned long long value)
+    {
+        m_messages = value;
+    }
+    void SetHandlerSeconds(double value)
+    {
+        m_handlerSeconds = value;
+    }
+
+private:
+    bool m_event;
+    int m_type;
+    const char *m_typeName;
+    bool m_handled;
+    unsigned long long m_messages;
+    double m_handlerSeconds;
+};
+}
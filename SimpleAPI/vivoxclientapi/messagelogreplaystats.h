@@ -0,0 +1,83 @@
+#pragma once
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+
+namespace VivoxClientApi {
+///
+/// The outcome of ClientConnection::ReplayMessageLog().
+///
+/// Messages counts the responses and events dispatched. Dispatch seconds is the time spent handling them, without
+/// reading the log or waiting for their recorded time, so that messages over dispatch seconds is the throughput
+/// of the dispatch layer.
+///
+class MessageLogReplayStats
+{
+public:
+    MessageLogReplayStats()
+    {
+        m_messages = 0;
+        m_skipped = 0;
+        m_dispatchSeconds = 0;
+        m_elapsedSeconds = 0;
+    }
+
+    unsigned long long GetMessages() const
+    {
+        return m_messages;
+    }
+    ///
+    /// Records of the log that are not in this version of the SDK headers
+    ///
+    unsigned long long GetSkipped() const
+    {
+        return m_skipped;
+    }
+    double GetDispatchSeconds() const
+    {
+        return m_dispatchSeconds;
+    }
+    double GetElapsedSeconds() const
+    {
+        return m_elapsedSeconds;
+    }
+    double GetMessagesPerSecond() const
+    {
+        return m_dispatchSeconds > 0 ? m_messages / m_dispatchSeconds : 0;
+    }
+
+    void IncrementMessages()
+    {
+        ++m_messages;
+    }
+    void SetSkipped(unsigned long long value)
+    {
+        m_skipped = value;
+    }
+    void AddDispatchSeconds(double value)
+    {
+        m_dispatchSeconds += value;
+    }
+    void SetElapsedSeconds(double value)
+    {
+        m_elapsedSeconds = value;
+    }
+
+private:
+    unsigned long long m_messages;
+    unsigned long long m_skipped;
+    double m_dispatchSeconds;
+    double m_elapsedSeconds;
+};
+}
@@ -0,0 +1,141 @@
+#pragma once
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+
+namespace VivoxClientApi {
+///
+/// This class controls how often ClientConnection::Set3DPosition() actually sends a position to the server.
+///
+/// Only the latest position passed to Set3DPosition() is kept. It is sent no more often than
+/// GetMaxUpdatesPerSecond() times a second, and not at all if it differs from the last position sent by less
+/// than the position and orientation thresholds. A position held back by the rate limit is sent on the UI thread,
+/// through IClientApiEventHandler::InvokeOnUIThread(), as soon as the interval since the last one sent is over.
+///
+/// The default policy has no rate limit and zero thresholds: every call is sent, as in earlier versions. Games
+/// calling Set3DPosition() every frame opt in by setting a rate, e.g. PositionUpdatePolicy(10, 0.01, 0.01, false).
+///
+class PositionUpdatePolicy
+{
+public:
+    PositionUpdatePolicy()
+    {
+        m_maxUpdatesPerSecond = 0;
+        m_positionThreshold = 0;
+        m_orientationThresholdRadians = 0;
+        m_extrapolate = false;
+    }
+    PositionUpdatePolicy(double maxUpdatesPerSecond, double positionThreshold, double orientationThresholdRadians, bool extrapolate)
+    {
+        m_maxUpdatesPerSecond = maxUpdatesPerSecond;
+        m_positionThreshold = positionThreshold;
+        m_orientationThresholdRadians = orientationThresholdRadians;
+        m_extrapolate = extrapolate;
+    }
+
+    ///
+    /// The maximum number of position requests per second and channel. Zero means no limit.
+    ///
+    double GetMaxUpdatesPerSecond() const
+    {
+        return m_maxUpdatesPerSecond;
+    }
+    void SetMaxUpdatesPerSecond(double value)
+    {
+        m_maxUpdatesPerSecond = value;
+    }
+
+    ///
+    /// The distance, in the game's units, a position has to move from the last one sent to be sent again.
+    ///
+    double GetPositionThreshold() const
+    {
+        return m_positionThreshold;
+    }
+    void SetPositionThreshold(double value)
+    {
+        m_positionThreshold = value;
+    }
+
+    ///
+    /// The angle, in radians, the 'at' orientation has to turn from the last one sent to be sent again.
+    ///
+    double GetOrientationThresholdRadians() const
+    {
+        return m_orientationThresholdRadians;
+    }
+    void SetOrientationThresholdRadians(double value)
+    {
+        m_orientationThresholdRadians = value;
+    }
+
+    ///
+    /// When set, the position sent is extrapolated along the velocity estimated from the previous calls, half an
+    /// update interval ahead, so that a moving listener is on average as close to the sent position as it would be
+    /// at a higher update rate.
+    ///
+    bool GetExtrapolate() const
+    {
+        return m_extrapolate;
+    }
+    void SetExtrapolate(bool value)
+    {
+        m_extrapolate = value;
+    }
+
+private:
+    double m_maxUpdatesPerSecond;
+    double m_positionThreshold;
+    double m_orientationThresholdRadians;
+    bool m_extrapolate;
+};
+
+///
+/// Counters of the positions passed to ClientConnection::Set3DPosition() for a channel.
+///
+/// Sent counts the position requests issued to the SDK. Suppressed counts the calls that did not result in a request,
+/// either because a newer position replaced them before they could be sent, or because they were too close to the
+/// last position sent.
+///
+class PositionUpdateStats
+{
+public:
+    PositionUpdateStats()
+    {
+        m_sent = 0;
+        m_suppressed = 0;
+    }
+
+    unsigned long long GetSent() const
+    {
+        return m_sent;
+    }
+    unsigned long long GetSuppressed() const
+    {
+        return m_suppressed;
+    }
+    void IncrementSent()
+    {
+        ++m_sent;
+    }
+    void IncrementSuppressed()
+    {
+        ++m_suppressed;
+    }
+
+private:
+    unsigned long long m_sent;
+    unsigned long long m_suppressed;
+};
+}
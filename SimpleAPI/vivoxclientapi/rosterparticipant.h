@@ -0,0 +1,107 @@
+#pragma once
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+
+#include "uri.h"
+
+namespace VivoxClientApi {
+///
+/// A participant as IClientApiEventHandler::onRosterChanged() reports it: its state at the end of the batch, or
+/// when it left for a participant that left.
+///
+class RosterParticipant
+{
+public:
+    RosterParticipant()
+    {
+        m_isLoggedInUser = false;
+        m_isSpeaking = false;
+        m_energy = 0;
+        m_isMutedForAll = false;
+        m_leftReason = 0;
+    }
+
+    const Uri &GetUri() const
+    {
+        return m_uri;
+    }
+    void SetUri(const Uri &value)
+    {
+        m_uri = value;
+    }
+
+    ///
+    /// Whether or not the participant is the logged in user
+    ///
+    bool IsLoggedInUser() const
+    {
+        return m_isLoggedInUser;
+    }
+    void SetIsLoggedInUser(bool value)
+    {
+        m_isLoggedInUser = value;
+    }
+
+    bool GetIsSpeaking() const
+    {
+        return m_isSpeaking;
+    }
+    void SetIsSpeaking(bool value)
+    {
+        m_isSpeaking = value;
+    }
+
+    ///
+    /// A value from 0-1 indicating the relative energy in the speech
+    ///
+    double GetEnergy() const
+    {
+        return m_energy;
+    }
+    void SetEnergy(double value)
+    {
+        m_energy = value;
+    }
+
+    bool GetIsMutedForAll() const
+    {
+        return m_isMutedForAll;
+    }
+    void SetIsMutedForAll(bool value)
+    {
+        m_isMutedForAll = value;
+    }
+
+    ///
+    /// For a participant that left, why: an IClientApiEventHandler::ParticipantLeftReason
+    ///
+    int GetLeftReason() const
+    {
+        return m_leftReason;
+    }
+    void SetLeftReason(int value)
+    {
+        m_leftReason = value;
+    }
+
+private:
+    Uri m_uri;
+    bool m_isLoggedInUser;
+    bool m_isSpeaking;
+    double m_energy;
+    bool m_isMutedForAll;
+    int m_leftReason;
+};
+}
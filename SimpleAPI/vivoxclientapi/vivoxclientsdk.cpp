@@ -23,16 +23,24 @@
 #include <string>
 #include <string.h>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <memory>
+#include <chrono>
+#include <thread>
+#include <math.h>
 
 #include <Windows.h>
 
 #include <assert.h>
+#include <algorithm>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include "vivoxclientapi/types.h"
 #include "vivoxclientapi/memallocators.h"
+#include "vivoxclientapi/workstealingpool.h"
+#include "MessageLog.h"
 
 
 
@@ -83,9 +91,13 @@ static std::string AudioDeviceIdString(const AudioDeviceId &id)
     return id.GetAudioDeviceId().c_str();
 }
 
+// Every request issued and message received goes through it, see ClientConnection::StartMessageLog()
+static MessageLogWriter s_messageLog;
+
 static VCSStatus issueRequest(vx_req_base_t *request)
 {
     int outstandingRequestCount = 0;
+    s_messageLog.RecordRequest(request);
 #ifdef _DEBUG
     char *xml = NULL;
     vx_request_to_xml(request, &xml);
@@ -150,7 +162,8 @@ static const char *safe_str(const char *s)
 
 static char *GetNextRequestId(const char *parent, const char *prefix)
 {
-    static int lastRequestId = 0;
+    // Logins with executors of their own issue requests from several threads
+    static std::atomic<int> lastRequestId(0);
     std::stringstream ss;
     if (parent && parent[0]) {
         ss << parent << "." << prefix << lastRequestId++;
@@ -161,6 +174,17 @@ static char *GetNextRequestId(const char *parent, const char *prefix)
     }
 }
 
+// With login executors the account, session group and session handles of a login are made children of its key, see
+// ClientConnectionImpl::RouteToLogin(). Empty for handles made without one.
+static std::string GetLoginKey(const char *handle)
+{
+    const char *dot = handle != NULL ? strchr(handle, '.') : NULL;
+    if (dot == NULL) {
+        return std::string();
+    }
+    return std::string(handle, dot - handle);
+}
+
 class Participant
 {
 public:
@@ -264,6 +288,23 @@ private:
     int m_mutedForAll;
 };
 
+///
+/// What the getters of ClientConnection read of a participant, see ChannelSnapshot
+///
+struct ParticipantSnapshot {
+    int volume;
+    bool mutedForAll;
+};
+
+///
+/// The state of a channel as of the last batch of responses and events, published for the getters of
+/// ClientConnection to read without locking. Never changed once published: a channel that changes makes a new one.
+///
+struct ChannelSnapshot {
+    int volume;
+    std::map<Uri, ParticipantSnapshot> participants;
+};
+
 class Channel
 {
 public:
@@ -289,6 +330,18 @@ public:
         m_currentVolume = 50;
         m_desiredVolume = 50;
         m_volumeRequestInProgress = false;
+        m_snapshotStale = true;
+        m_rosterBatching = false;
+        m_hasDesiredPosition = false;
+        m_hasSentPosition = false;
+        m_positionUpdatePending = false;
+        for (int i = 0; i < 3; ++i) {
+            m_desiredPosition[i] = 0;
+            m_desiredAtOrientation[i] = 0;
+            m_sentPosition[i] = 0;
+            m_sentAtOrientation[i] = 0;
+            m_velocity[i] = 0;
+        }
     }
 
     virtual ~Channel()
@@ -336,7 +389,7 @@ public:
                 req->connect_text = 0;
                 req->uri = vx_strdup(m_channelUri.ToString());
                 req->sessiongroup_handle = vx_strdup(m_sessionGroupHandle.c_str());
-                req->base.cookie = GetNextRequestId(NULL, "S");
+                req->base.cookie = GetNextRequestId(GetLoginKey(m_accountHandle.c_str()).c_str(), "S");
                 req->session_handle = vx_strdup(req->base.cookie);
                 req->account_handle = vx_strdup(m_accountHandle.c_str());
                 if (!m_accessToken.empty()) {
@@ -382,6 +435,9 @@ public:
             m_currentState = value;
             if (m_currentState == ChannelStateDisconnected) {
                 ClearParticipants();
+                // a new session starts without a position: send the latest one again once reconnected
+                m_hasSentPosition = false;
+                m_positionUpdatePending = m_hasDesiredPosition;
             }
         }
     }
@@ -390,13 +446,63 @@ public:
     int GetCurrentVolume() const { return m_currentVolume; }
     int GetDesiredVolume() const { return m_desiredVolume; }
     bool GetVolumeRequestInProgress() const { return m_volumeRequestInProgress; }
-    void SetCurrentVolume(int value) { m_currentVolume = value; }
+    void SetCurrentVolume(int value) { m_currentVolume = value; m_snapshotStale = true; }
     void SetDesiredVolume(int value) { m_desiredVolume = value; }
     void SetVolumeRequestInProgress(bool value) { m_volumeRequestInProgress = value; }
 
     const Uri &GetUri() const { return m_channelUri; }
     const std::string &GetSessionHandle() const { return m_sessionHandle; }
 
+    ///
+    /// The snapshot of the current state of the channel, the same one for as long as that does not change
+    ///
+    std::shared_ptr<const ChannelSnapshot> GetSnapshot()
+    {
+        if (m_snapshotStale || !m_snapshot) {
+            std::shared_ptr<ChannelSnapshot> snapshot = std::make_shared<ChannelSnapshot>();
+            snapshot->volume = m_currentVolume;
+            for (std::map<Uri, Participant *>::const_iterator i = m_participants.begin(); i != m_participants.end(); ++i) {
+                ParticipantSnapshot participant = { i->second->GetCurrentVolume(), i->second->GetMutedForAll() };
+                snapshot->participants.emplace_hint(snapshot->participants.end(), i->first, participant);
+            }
+            m_snapshot = snapshot;
+            m_snapshotStale = false;
+        }
+        return m_snapshot;
+    }
+
+    ///
+    /// With batching, the roster changes are kept until FlushRosterChanges() rather than reported as they come
+    ///
+    void SetRosterBatching(bool batching)
+    {
+        m_rosterBatching = batching;
+    }
+
+    ///
+    /// Reports the roster changes kept since the last time in one IClientApiEventHandler::onRosterChanged()
+    ///
+    void FlushRosterChanges()
+    {
+        if (m_rosterChanges.empty()) {
+            return;
+        }
+        std::vector<RosterParticipant> added;
+        std::vector<RosterParticipant> removed;
+        std::vector<RosterParticipant> updated;
+        for (std::map<Uri, RosterChange>::const_iterator i = m_rosterChanges.begin(); i != m_rosterChanges.end(); ++i) {
+            if (i->second.present) {
+                (i->second.wasPresent ? updated : added).push_back(i->second.participant);
+            } else if (i->second.wasPresent) {
+                removed.push_back(i->second.participant);
+            }
+        }
+        m_rosterChanges.clear();
+        if (!added.empty() || !removed.empty() || !updated.empty()) {
+            m_app->onRosterChanged(m_accountName, m_channelUri, added, removed, updated);
+        }
+    }
+
     int GetParticipantAudioOutputDeviceVolumeForMe(const Uri &target)
     {
         Participant *p = FindParticipantByUri(target, false);
@@ -489,7 +595,94 @@ public:
         return issueRequest(&req->base);
     }
 
-    VCSStatus Set3DPosition(double x, double y, double z, double at_x, double at_y, double at_z)
+    VCSStatus Set3DPosition(const PositionUpdatePolicy &policy, double x, double y, double z, double at_x, double at_y, double at_z)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (m_positionUpdatePending) {
+            // the previous position never made it to the server
+            m_positionUpdateStats.IncrementSuppressed();
+        }
+        if (m_hasDesiredPosition) {
+            double dt = std::chrono::duration<double>(now - m_desiredPositionTime).count();
+            if (dt > c_velocityMaxSampleInterval) {
+                // stale sample, e.g. the game was paused: don't extrapolate from it
+                m_velocity[0] = m_velocity[1] = m_velocity[2] = 0;
+            } else if (dt > 0) {
+                m_velocity[0] += c_velocitySmoothing * ((x - m_desiredPosition[0]) / dt - m_velocity[0]);
+                m_velocity[1] += c_velocitySmoothing * ((y - m_desiredPosition[1]) / dt - m_velocity[1]);
+                m_velocity[2] += c_velocitySmoothing * ((z - m_desiredPosition[2]) / dt - m_velocity[2]);
+            }
+        }
+        m_desiredPosition[0] = x;
+        m_desiredPosition[1] = y;
+        m_desiredPosition[2] = z;
+        m_desiredAtOrientation[0] = at_x;
+        m_desiredAtOrientation[1] = at_y;
+        m_desiredAtOrientation[2] = at_z;
+        m_desiredPositionTime = now;
+        m_hasDesiredPosition = true;
+        m_positionUpdatePending = true;
+        return Flush3DPosition(policy, now);
+    }
+
+    // Sends the pending position if the policy allows it now. Positions are only sent once the channel is connected.
+    VCSStatus Flush3DPosition(const PositionUpdatePolicy &policy, std::chrono::steady_clock::time_point now)
+    {
+        if (!m_positionUpdatePending || m_currentState != ChannelStateConnected) {
+            return 0;
+        }
+        double interval = policy.GetMaxUpdatesPerSecond() > 0 ? 1.0 / policy.GetMaxUpdatesPerSecond() : 0;
+        if (m_hasSentPosition && std::chrono::duration<double>(now - m_sentPositionTime).count() < interval) {
+            return 0;
+        }
+
+        double position[3] = { m_desiredPosition[0], m_desiredPosition[1], m_desiredPosition[2] };
+        if (policy.GetExtrapolate()) {
+            double lead = std::chrono::duration<double>(now - m_desiredPositionTime).count() + interval / 2;
+            if (lead > c_velocityMaxSampleInterval) {
+                lead = c_velocityMaxSampleInterval;
+            }
+            for (int i = 0; i < 3; ++i) {
+                position[i] += m_velocity[i] * lead;
+            }
+        }
+
+        if (m_hasSentPosition &&
+            Distance(position, m_sentPosition) < policy.GetPositionThreshold() &&
+            Angle(m_desiredAtOrientation, m_sentAtOrientation) < policy.GetOrientationThresholdRadians())
+        {
+            m_positionUpdateStats.IncrementSuppressed();
+            m_positionUpdatePending = false;
+            return 0;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            m_sentPosition[i] = position[i];
+            m_sentAtOrientation[i] = m_desiredAtOrientation[i];
+        }
+        m_sentPositionTime = now;
+        m_hasSentPosition = true;
+        m_positionUpdatePending = false;
+        m_positionUpdateStats.IncrementSent();
+        return Issue3DPosition(position[0], position[1], position[2], m_desiredAtOrientation[0], m_desiredAtOrientation[1], m_desiredAtOrientation[2]);
+    }
+
+    // When the position held back by the rate limit, if any, is due
+    bool GetNext3DPositionFlush(const PositionUpdatePolicy &policy, std::chrono::steady_clock::time_point &due) const
+    {
+        if (!m_positionUpdatePending || m_currentState != ChannelStateConnected || !m_hasSentPosition || policy.GetMaxUpdatesPerSecond() <= 0) {
+            return false;
+        }
+        // One tick more than the truncated interval, so that Flush3DPosition() finds it over
+        due = m_sentPositionTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / policy.GetMaxUpdatesPerSecond())) +
+              std::chrono::steady_clock::duration(1);
+        return true;
+    }
+
+    const PositionUpdateStats &Get3DPositionUpdateStats() const { return m_positionUpdateStats; }
+    void Reset3DPositionUpdateStats() { m_positionUpdateStats = PositionUpdateStats(); }
+
+    VCSStatus Issue3DPosition(double x, double y, double z, double at_x, double at_y, double at_z)
     {
         vx_req_session_set_3d_position_t *req;
         vx_req_session_set_3d_position_create(&req);
@@ -538,6 +731,7 @@ public:
             m_app->onSetChannelAudioOutputDeviceVolumeFailed(m_accountName, m_channelUri, req->volume, resp->base.status_code);
         } else {
             m_currentVolume = req->volume;
+            m_snapshotStale = true;
             m_app->onSetChannelAudioOutputDeviceVolumeCompleted(m_accountName, m_channelUri, req->volume);
         }
         m_volumeRequestInProgress = false;
@@ -553,6 +747,7 @@ public:
             m_app->onSetChannelAudioOutputDeviceVolumeFailed(m_accountName, m_channelUri, req->volume, resp->base.status_code);
         } else {
             m_currentVolume = req->volume;
+            m_snapshotStale = true;
             m_app->onSetChannelAudioOutputDeviceVolumeCompleted(m_accountName, m_channelUri, req->volume);
         }
         m_volumeRequestInProgress = false;
@@ -571,6 +766,7 @@ public:
             m_app->onSetParticipantAudioOutputDeviceVolumeForMeFailed(m_accountName, Uri(req->participant_uri), m_channelUri, req->volume, resp->base.status_code);
         } else {
             p->SetCurrentVolume(req->volume);
+            m_snapshotStale = true;
             m_app->onSetParticipantAudioOutputDeviceVolumeForMeCompleted(m_accountName, Uri(req->participant_uri), m_channelUri, req->volume);
         }
         p->SetVolumeRequestInProgress(false);
@@ -627,6 +823,7 @@ public:
         CHECK_RET(p == NULL);
         p = FindParticipantByUri(Uri(evt->participant_uri), true);
         CHECK_RET(p != NULL);
+        m_snapshotStale = true;
         if (evt->is_current_user) {
             CHECK(GetCurrentState() == Channel::ChannelStateConnecting);
             if (GetCurrentState() == Channel::ChannelStateConnecting) {
@@ -636,7 +833,11 @@ public:
             }
         }
 
-        m_app->onParticipantAdded(m_accountName, m_channelUri, p->GetUri(), evt->is_current_user != 0 ? true : false);
+        if (m_rosterBatching) {
+            RecordRosterChange(p->GetUri(), false, true, evt->is_current_user != 0, p, IClientApiEventHandler::ReasonLeft);
+        } else {
+            m_app->onParticipantAdded(m_accountName, m_channelUri, p->GetUri(), evt->is_current_user != 0 ? true : false);
+        }
     }
 
     void HandleEvent(vx_evt_participant_updated *evt)
@@ -646,15 +847,24 @@ public:
         if (p != NULL) {
             bool changed = p->SetIsSpeaking(evt->is_speaking ? true : false);
             changed |= p->SetEnergy(evt->energy);
-            changed |= p->SetMutedForAll(evt->is_moderator_muted ? true : false);
-            if (changed) {
+            if (p->SetMutedForAll(evt->is_moderator_muted ? true : false)) {
+                changed = true;
+                m_snapshotStale = true;
+            }
+            if (changed && m_rosterBatching) {
+                RecordRosterChange(p->GetUri(), true, true, evt->is_current_user != 0, p, IClientApiEventHandler::ReasonLeft);
+            } else if (changed) {
                 m_app->onParticipantUpdated(m_accountName, m_channelUri, p->GetUri(), evt->is_current_user != 0 ? true : false, p->GetIsSpeaking(), p->GetEnergy(), p->GetMutedForAll());
             }
         } else {
             // a rarely seen case where a participant_updated event is see without a participant_added event arriving first
             Uri uri;
             uri = (const Uri)evt->participant_uri;
-            m_app->onParticipantAdded(m_accountName, m_channelUri, uri, evt->is_current_user != 0 ? true : false);
+            if (m_rosterBatching) {
+                RecordRosterChange(uri, false, true, evt->is_current_user != 0, NULL, IClientApiEventHandler::ReasonLeft);
+            } else {
+                m_app->onParticipantAdded(m_accountName, m_channelUri, uri, evt->is_current_user != 0 ? true : false);
+            }
         }
     }
 
@@ -663,9 +873,14 @@ public:
         Participant *p = FindParticipantByUri(Uri(evt->participant_uri), false);
         // CHECK_RET(p != NULL);
         if (p != NULL) {
-            m_app->onParticipantLeft(m_accountName, m_channelUri, p->GetUri(), evt->is_current_user != 0 ? true : false, (IClientApiEventHandler::ParticipantLeftReason)evt->reason);
+            if (m_rosterBatching) {
+                RecordRosterChange(p->GetUri(), true, false, evt->is_current_user != 0, p, evt->reason);
+            } else {
+                m_app->onParticipantLeft(m_accountName, m_channelUri, p->GetUri(), evt->is_current_user != 0 ? true : false, (IClientApiEventHandler::ParticipantLeftReason)evt->reason);
+            }
             m_participants.erase(p->GetUri());
             delete p;
+            m_snapshotStale = true;
         }
     }
 
@@ -681,6 +896,30 @@ private:
             delete i->second;
         }
         m_participants.clear();
+        m_rosterChanges.clear();
+        m_snapshotStale = true;
+    }
+
+    ///
+    /// Keeps a roster change for FlushRosterChanges(). wasPresent only counts the first time the participant changes
+    /// in the batch, present the last, so what is reported is the net change. p is NULL for a participant updated
+    /// before it was added.
+    ///
+    void RecordRosterChange(const Uri &uri, bool wasPresent, bool present, bool isLoggedInUser, const Participant *p, int leftReason)
+    {
+        std::map<Uri, RosterChange>::iterator i = m_rosterChanges.lower_bound(uri);
+        if (i == m_rosterChanges.end() || i->first != uri) {
+            i = m_rosterChanges.emplace_hint(i, uri, RosterChange());
+            i->second.wasPresent = wasPresent;
+            i->second.participant.SetUri(uri);
+        }
+        i->second.present = present;
+        RosterParticipant &participant = i->second.participant;
+        participant.SetIsLoggedInUser(isLoggedInUser);
+        participant.SetIsSpeaking(p != NULL && p->GetIsSpeaking());
+        participant.SetEnergy(p != NULL && p->GetEnergy() > 0 ? p->GetEnergy() : 0);
+        participant.SetIsMutedForAll(p != NULL && p->GetMutedForAll());
+        participant.SetLeftReason(leftReason);
     }
 
     Participant *FindParticipantByUri(const Uri &uri, bool create = false)
@@ -699,7 +938,51 @@ private:
         }
     }
 
+    static double Distance(const double a[3], const double b[3])
+    {
+        double dx = a[0] - b[0];
+        double dy = a[1] - b[1];
+        double dz = a[2] - b[2];
+        return sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    static double Angle(const double a[3], const double b[3])
+    {
+        double na = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+        double nb = sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+        if (na == 0 || nb == 0) {
+            return na == nb ? 0 : 3.14159265358979323846;
+        }
+        double c = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / (na * nb);
+        return acos(c > 1 ? 1 : (c < -1 ? -1 : c));
+    }
+
     std::map<Uri, Participant *> m_participants;
+    std::shared_ptr<const ChannelSnapshot> m_snapshot;
+    bool m_snapshotStale;     // m_snapshot no longer shows the channel
+
+    struct RosterChange {
+        bool wasPresent;     // in the roster before the batch
+        bool present;        // in the roster now
+        RosterParticipant participant;
+    };
+    bool m_rosterBatching;
+    std::map<Uri, RosterChange> m_rosterChanges;     // since the last FlushRosterChanges(), with batching
+
+    // 3D position governor state, see PositionUpdatePolicy
+    static const double c_velocitySmoothing;
+    static const double c_velocityMaxSampleInterval;
+    bool m_hasDesiredPosition;
+    bool m_hasSentPosition;
+    bool m_positionUpdatePending;
+    double m_desiredPosition[3];
+    double m_desiredAtOrientation[3];
+    std::chrono::steady_clock::time_point m_desiredPositionTime;
+    double m_sentPosition[3];
+    double m_sentAtOrientation[3];
+    std::chrono::steady_clock::time_point m_sentPositionTime;
+    double m_velocity[3];
+    PositionUpdateStats m_positionUpdateStats;
 
     ChannelState m_desiredState;
     ChannelState m_currentState;
@@ -716,12 +999,33 @@ private:
     std::string m_sessionGroupHandle;
 };
 
+const double Channel::c_velocitySmoothing = 0.5;
+const double Channel::c_velocityMaxSampleInterval = 0.5;     /// seconds
+
+///
+/// The state of a login as of the last batch of responses and events, see ChannelSnapshot. The snapshots of the
+/// channels that did not change are shared with the previous one.
+///
+struct LoginSnapshot {
+    ChannelTransmissionPolicy transmissionPolicy;
+    std::map<Uri, std::shared_ptr<const ChannelSnapshot> > channels;
+};
+
+///
+/// Where a login publishes its LoginSnapshot. The getters keep the slot rather than the login, which only the
+/// thread dispatching to it may use.
+///
+struct LoginSnapshotSlot {
+    std::shared_ptr<const LoginSnapshot> snapshot;     // through std::atomic_load() and std::atomic_store() only
+};
+
 class MultiChannelSessionGroup
 {
 public:
     MultiChannelSessionGroup(IClientApiEventHandler *app, const AccountName &accountName) :
         m_accountName(accountName),
         m_channelTransmissionPolicyRequestInProgress(false),
+        m_rosterBatching(false),
         m_app(app)
     {
     }
@@ -749,6 +1053,7 @@ public:
         Channel *c = FindChannel(channelUri);
         if (c == NULL) {
             c = new Channel(m_app, channelUri, m_accountName, m_accountHandle, m_sessionGroupHandle);
+            c->SetRosterBatching(m_rosterBatching);
             m_channels[channelUri] = c;
         }
         if (!multiChannel) {
@@ -940,7 +1245,79 @@ public:
             return VX_E_NO_EXIST;
         }
 
-        return s->Set3DPosition(x, y, z, at_x, at_y, at_z);
+        return s->Set3DPosition(m_positionUpdatePolicy, x, y, z, at_x, at_y, at_z);
+    }
+
+    const PositionUpdatePolicy &Get3DPositionUpdatePolicy() const { return m_positionUpdatePolicy; }
+
+    VCSStatus Set3DPositionUpdatePolicy(const PositionUpdatePolicy &policy)
+    {
+        if (policy.GetMaxUpdatesPerSecond() < 0 || policy.GetPositionThreshold() < 0 || policy.GetOrientationThresholdRadians() < 0) {
+            return VX_E_INVALID_ARGUMENT;
+        }
+        m_positionUpdatePolicy = policy;
+        return 0;
+    }
+
+    ///
+    /// See Channel::SetRosterBatching(), for the channels joined after it
+    ///
+    void SetRosterBatching(bool batching)
+    {
+        m_rosterBatching = batching;
+    }
+
+    void FlushRosterChanges()
+    {
+        for (std::map<Uri, Channel *>::const_iterator i = m_channels.begin(); i != m_channels.end(); ++i) {
+            i->second->FlushRosterChanges();
+        }
+    }
+
+    ///
+    /// The snapshot of the channels and the current transmission policy, previous itself if none of them changed
+    ///
+    std::shared_ptr<const LoginSnapshot> MakeSnapshot(const std::shared_ptr<const LoginSnapshot> &previous)
+    {
+        std::shared_ptr<LoginSnapshot> snapshot = std::make_shared<LoginSnapshot>();
+        snapshot->transmissionPolicy = m_currentChannelTransmissionPolicy;
+        for (std::map<Uri, Channel *>::const_iterator i = m_channels.begin(); i != m_channels.end(); ++i) {
+            snapshot->channels.emplace_hint(snapshot->channels.end(), i->first, i->second->GetSnapshot());
+        }
+        if (previous &&
+            previous->channels == snapshot->channels &&
+            previous->transmissionPolicy.GetChannelTransmissionPolicy() == snapshot->transmissionPolicy.GetChannelTransmissionPolicy() &&
+            previous->transmissionPolicy.GetSpecificTransmissionChannel() == snapshot->transmissionPolicy.GetSpecificTransmissionChannel())
+        {
+            return previous;
+        }
+        return snapshot;
+    }
+
+    bool GetNext3DPositionFlush(std::chrono::steady_clock::time_point &due) const
+    {
+        bool found = false;
+        for (std::map<Uri, Channel *>::const_iterator i = m_channels.begin(); i != m_channels.end(); ++i) {
+            std::chrono::steady_clock::time_point channelDue;
+            if (i->second->GetNext3DPositionFlush(m_positionUpdatePolicy, channelDue) && (!found || channelDue < due)) {
+                due = channelDue;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    VCSStatus Get3DPositionUpdateStats(const Uri &channel, PositionUpdateStats &stats, bool reset)
+    {
+        Channel *s = FindChannel(channel);
+        if (s == NULL) {
+            return VX_E_NO_EXIST;
+        }
+        stats = s->Get3DPositionUpdateStats();
+        if (reset) {
+            s->Reset3DPositionUpdateStats();
+        }
+        return 0;
     }
 
     VCSStatus SetTransmissionToSpecificChannel(const Uri &channel)
@@ -989,6 +1366,12 @@ public:
 
     void NextState()
     {
+        // Pending 3D positions that are due go out here, see ClientConnectionImpl::Schedule3DPositionFlush()
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (std::map<Uri, Channel *>::const_iterator i = m_channels.begin(); i != m_channels.end(); ++i) {
+            i->second->Flush3DPosition(m_positionUpdatePolicy, now);
+        }
+
         std::set<Channel *> channelsToDisconnect;
         std::set<Channel *> channelsToConnect;
         std::set<Channel *> connectedChannels;
@@ -1327,7 +1710,7 @@ public:
 
         // Create new m_sessionGroupHandle at this moment too
         if (m_sessionGroupHandle.empty()) {
-            char *cookie = GetNextRequestId(NULL, "G");
+            char *cookie = GetNextRequestId(GetLoginKey(m_accountHandle.c_str()).c_str(), "G");
             m_sessionGroupHandle = cookie;
             vx_free(cookie);
 
@@ -1376,6 +1759,8 @@ private:
     ChannelTransmissionPolicy m_currentChannelTransmissionPolicy;
     ChannelTransmissionPolicy m_desiredChannelTransmissionPolicy;
     bool m_channelTransmissionPolicyRequestInProgress;
+    PositionUpdatePolicy m_positionUpdatePolicy;
+    bool m_rosterBatching;
 
     std::map<Uri, Channel *> m_channels;
     IClientApiEventHandler *m_app;
@@ -1436,7 +1821,8 @@ public:
             int participantUpdateFrequency = -1
             ) :
         m_app(app),
-        m_sg(app, name)
+        m_sg(app, name),
+        m_snapshotSlot(std::make_shared<LoginSnapshotSlot>())
     {
         CHECK(!connectorHandle.empty());
         // CHECK(name.IsValid());
@@ -1657,6 +2043,26 @@ public:
         return NextState(m_sg.Set3DPosition(channel, x, y, z, at_x, at_y, at_z));
     }
 
+    PositionUpdatePolicy Get3DPositionUpdatePolicy() const
+    {
+        return m_sg.Get3DPositionUpdatePolicy();
+    }
+
+    VCSStatus Set3DPositionUpdatePolicy(const PositionUpdatePolicy &policy)
+    {
+        return NextState(m_sg.Set3DPositionUpdatePolicy(policy));
+    }
+
+    VCSStatus Get3DPositionUpdateStats(const Uri &channel, PositionUpdateStats &stats, bool reset)
+    {
+        return m_sg.Get3DPositionUpdateStats(channel, stats, reset);
+    }
+
+    bool GetNext3DPositionFlush(std::chrono::steady_clock::time_point &due) const
+    {
+        return m_sg.GetNext3DPositionFlush(due);
+    }
+
     VCSStatus SetTransmissionToSpecificChannel(const Uri &channel)
     {
         return NextState(m_sg.SetTransmissionToSpecificChannel(channel));
@@ -1876,11 +2282,189 @@ public:
     const std::string &GetSessionGroupHandle() const { return m_sg.GetSessionGroupHandle(); }
     bool IsUsingSessionHandle(const char *handle) const { return m_sg.IsUsingSessionHandle(handle); }
 
+    ///
+    /// Gives this login an executor of its own. Its handles become children of loginKey, and ClientConnectionImpl hands
+    /// its messages to Dispatch() on the executor. To be called before it logs in.
+    ///
+    void SetExecutor(const std::shared_ptr<SerialExecutor> &executor, const std::string &loginKey)
+    {
+        m_executor = executor;
+        m_loginKey = loginKey;
+    }
+    const std::shared_ptr<SerialExecutor> &GetExecutor() const { return m_executor; }
+    ///
+    /// With an executor, held by whoever uses the state of this login: its executor, or the application calling
+    /// ClientConnection
+    ///
+    std::recursive_mutex &GetMutex() { return m_mutex; }
+
+    const std::shared_ptr<LoginSnapshotSlot> &GetSnapshotSlot() const { return m_snapshotSlot; }
+
+    ///
+    /// See ClientConnection::SetRosterBatching(). To be called before it joins a channel.
+    ///
+    void SetRosterBatching(bool batching)
+    {
+        m_sg.SetRosterBatching(batching);
+    }
+
+    ///
+    /// Reports the roster changes of the batch, by whoever uses the state of this login
+    ///
+    void FlushRosterChanges()
+    {
+        m_sg.FlushRosterChanges();
+    }
+
+    ///
+    /// Publishes the state of the login for the getters of ClientConnection, by whoever uses the state of this login.
+    /// Returns true if it changed since the last time.
+    ///
+    bool PublishSnapshot()
+    {
+        std::shared_ptr<const LoginSnapshot> previous = std::atomic_load(&m_snapshotSlot->snapshot);
+        std::shared_ptr<const LoginSnapshot> snapshot = m_sg.MakeSnapshot(previous);
+        if (snapshot == previous) {
+            return false;
+        }
+        std::atomic_store(&m_snapshotSlot->snapshot, snapshot);
+        return true;
+    }
+
+    ///
+    /// Handles a response or event of this login, one GetLoginHandle() returns a handle for
+    ///
+    void Dispatch(vx_message_base_t *m)
+    {
+        const DispatchEntry *entry = GetDispatchEntry(m);
+        CHECK_RET(entry != NULL && entry->handler != NULL);
+        (this->*entry->handler)(m);
+        if (entry->nextState) {
+            // Where ClientConnectionImpl would have run its NextState() for this login
+            NextState();
+        }
+    }
+
+    ///
+    /// The handle by which the handlers of the connection find the login of a response or event, or NULL for those
+    /// of the connection itself
+    ///
+    static const char *GetLoginHandle(vx_message_base_t *m)
+    {
+        const DispatchEntry *entry = GetDispatchEntry(m);
+        return entry != NULL && entry->handle != NULL ? entry->handle(m) : NULL;
+    }
+
+private:
+    typedef void (SingleLoginMultiChannelManager::*MessageHandler)(vx_message_base_t *m);
+    typedef const char *(*HandleGetter)(vx_message_base_t *m);
+
+    template <typename T, void (SingleLoginMultiChannelManager::*Handler)(T *)>
+    void DispatchAs(vx_message_base_t *m)
+    {
+        (this->*Handler)(reinterpret_cast<T *>(m));
+    }
+
+    template <typename Req, char *Req::*Handle>
+    static const char *GetRequestHandle(vx_message_base_t *m)
+    {
+        return safe_str(reinterpret_cast<Req *>(reinterpret_cast<vx_resp_base_t *>(m)->request)->*Handle);
+    }
+
+    template <typename T, char *T::*Handle>
+    static const char *GetEventHandle(vx_message_base_t *m)
+    {
+        return safe_str(reinterpret_cast<T *>(m)->*Handle);
+    }
+
+    static const char *GetMediaCompletionHandle(vx_message_base_t *m)
+    {
+        // aux* requests will have no sessiongroup handle, those are of the connection
+        vx_evt_media_completion *evt = reinterpret_cast<vx_evt_media_completion *>(m);
+        if (evt->sessiongroup_handle && evt->sessiongroup_handle[0]) {
+            return evt->sessiongroup_handle;
+        }
+        return NULL;
+    }
+
+    void HandleRemoveSession(vx_resp_sessiongroup_remove_session *resp)
+    {
+        if (resp->base.return_code != 0) {
+            LOG_ERR("Cannot Process vx_resp_sessiongroup_remove_session due to error: (%d) %s", resp->base.status_code, vx_get_error_string(resp->base.status_code));
+        } else {
+            HandleResponse(resp);
+        }
+    }
+
+    ///
+    /// How a login handles a response or event type and how it is found, all NULL for the types of the connection
+    ///
+    struct DispatchEntry {
+        MessageHandler handler;
+        HandleGetter handle;
+        bool nextState;         // followed by NextState(), as ClientConnectionImpl does for it
+    };
+
+    struct DispatchTable {
+        DispatchEntry responses[resp_max];
+        DispatchEntry events[evt_max];
+    };
+
+#define LOGIN_RESPONSE(type, T, handler, Req, handle, nextState) \
+    table.responses[type] = DispatchEntry { &SingleLoginMultiChannelManager::DispatchAs<T, &SingleLoginMultiChannelManager::handler>, &SingleLoginMultiChannelManager::GetRequestHandle<Req, &Req::handle>, nextState }
+#define LOGIN_EVENT(type, T, handle) \
+    table.events[type] = DispatchEntry { &SingleLoginMultiChannelManager::DispatchAs<T, &SingleLoginMultiChannelManager::HandleEvent>, &SingleLoginMultiChannelManager::GetEventHandle<T, &T::handle>, false }
+
+    static constexpr DispatchTable MakeDispatchTable()
+    {
+        DispatchTable table = {};
+        LOGIN_RESPONSE(resp_account_anonymous_login, vx_resp_account_anonymous_login, HandleResponse, vx_req_account_anonymous_login, account_handle, false);
+        LOGIN_RESPONSE(resp_account_logout, vx_resp_account_logout, HandleResponse, vx_req_account_logout, account_handle, false);
+        LOGIN_RESPONSE(resp_account_control_communications, vx_resp_account_control_communications, HandleResponse, vx_req_account_control_communications, account_handle, false);
+        LOGIN_RESPONSE(resp_channel_kick_user, vx_resp_channel_kick_user, HandleResponse, vx_req_channel_kick_user, account_handle, true);
+        LOGIN_RESPONSE(resp_channel_mute_user, vx_resp_channel_mute_user, HandleResponse, vx_req_channel_mute_user, account_handle, true);
+        LOGIN_RESPONSE(resp_channel_mute_all_users, vx_resp_channel_mute_all_users, HandleResponse, vx_req_channel_mute_all_users, account_handle, true);
+        LOGIN_RESPONSE(resp_sessiongroup_add_session, vx_resp_sessiongroup_add_session, HandleResponse, vx_req_sessiongroup_add_session, sessiongroup_handle, true);
+        LOGIN_RESPONSE(resp_sessiongroup_remove_session, vx_resp_sessiongroup_remove_session, HandleRemoveSession, vx_req_sessiongroup_remove_session, sessiongroup_handle, true);
+        LOGIN_RESPONSE(resp_sessiongroup_control_audio_injection, vx_resp_sessiongroup_control_audio_injection, HandleResponse, vx_req_sessiongroup_control_audio_injection, sessiongroup_handle, true);
+        LOGIN_RESPONSE(resp_sessiongroup_set_tx_all_sessions, vx_resp_sessiongroup_set_tx_all_sessions, HandleResponse, vx_req_sessiongroup_set_tx_all_sessions, sessiongroup_handle, true);
+        LOGIN_RESPONSE(resp_sessiongroup_set_tx_no_session, vx_resp_sessiongroup_set_tx_no_session, HandleResponse, vx_req_sessiongroup_set_tx_no_session, sessiongroup_handle, true);
+        LOGIN_RESPONSE(resp_session_set_local_speaker_volume, vx_resp_session_set_local_speaker_volume, HandleResponse, vx_req_session_set_local_speaker_volume, session_handle, true);
+        LOGIN_RESPONSE(resp_session_set_local_render_volume, vx_resp_session_set_local_render_volume, HandleResponse, vx_req_session_set_local_render_volume, session_handle, true);
+        LOGIN_RESPONSE(resp_session_set_participant_volume_for_me, vx_resp_session_set_participant_volume_for_me, HandleResponse, vx_req_session_set_participant_volume_for_me, session_handle, true);
+        LOGIN_RESPONSE(resp_session_set_participant_mute_for_me, vx_resp_session_set_participant_mute_for_me, HandleResponse, vx_req_session_set_participant_mute_for_me, session_handle, true);
+        LOGIN_RESPONSE(resp_sessiongroup_set_tx_session, vx_resp_sessiongroup_set_tx_session, HandleResponse, vx_req_sessiongroup_set_tx_session, session_handle, true);
+
+        LOGIN_EVENT(evt_account_login_state_change, vx_evt_account_login_state_change, account_handle);
+        LOGIN_EVENT(evt_media_stream_updated, vx_evt_media_stream_updated, sessiongroup_handle);
+        LOGIN_EVENT(evt_participant_added, vx_evt_participant_added, sessiongroup_handle);
+        LOGIN_EVENT(evt_participant_updated, vx_evt_participant_updated, sessiongroup_handle);
+        LOGIN_EVENT(evt_participant_removed, vx_evt_participant_removed, sessiongroup_handle);
+        LOGIN_EVENT(evt_sessiongroup_removed, vx_evt_sessiongroup_removed, sessiongroup_handle);
+        LOGIN_EVENT(evt_transcribed_message, vx_evt_transcribed_message, sessiongroup_handle);
+        table.events[evt_media_completion] = DispatchEntry { &SingleLoginMultiChannelManager::DispatchAs<vx_evt_media_completion, &SingleLoginMultiChannelManager::HandleEvent>, &SingleLoginMultiChannelManager::GetMediaCompletionHandle, false };
+        return table;
+    }
+
+#undef LOGIN_RESPONSE
+#undef LOGIN_EVENT
+
+    static const DispatchEntry *GetDispatchEntry(vx_message_base_t *m)
+    {
+        static constexpr DispatchTable table = MakeDispatchTable();
+        if (m->type == msg_response) {
+            int type = reinterpret_cast<vx_resp_base_t *>(m)->type;
+            return type > resp_none && type < resp_max ? &table.responses[type] : NULL;
+        }
+        int type = reinterpret_cast<vx_evt_base_t *>(m)->type;
+        return type > evt_none && type < evt_max ? &table.events[type] : NULL;
+    }
+
 private:
     void SetAccountHandle()
     {
         // create new m_accountHandle and propagate it to underlying objects
-        char *cookie = GetNextRequestId(NULL, "A");
+        char *cookie = GetNextRequestId(m_loginKey.c_str(), "A");
         m_accountHandle = cookie;
         vx_free(cookie);
         m_sg.SetAccountHandle(m_accountHandle);
@@ -1907,6 +2491,35 @@ private:
     int m_participantUpdateFrequency;
 
     bool m_multichannel;
+
+    std::shared_ptr<SerialExecutor> m_executor;
+    std::string m_loginKey;
+    std::recursive_mutex m_mutex;
+    std::shared_ptr<LoginSnapshotSlot> m_snapshotSlot;
+};
+
+class ClientConnectionImpl;
+
+// The connection whose responses and events this thread is handling, if any
+static thread_local const ClientConnectionImpl *s_dispatchingConnection = NULL;
+
+class DispatchingScope
+{
+public:
+    explicit DispatchingScope(const ClientConnectionImpl *connection) :
+        m_previous(s_dispatchingConnection)
+    {
+        s_dispatchingConnection = connection;
+    }
+    ~DispatchingScope()
+    {
+        s_dispatchingConnection = m_previous;
+    }
+
+private:
+    DispatchingScope(const DispatchingScope &); // disabled
+
+    const ClientConnectionImpl *m_previous;
 };
 
 class ClientConnectionImpl
@@ -1919,9 +2532,50 @@ public:
         ConnectorStateUninitializing
     } ConnectorState;
 
+private:
+    ///
+    /// The login of an account, locked for a method of the connection: by m_loginsMutex with the rest of the
+    /// connection, or with login executors by its own mutex alone, so that the other logins carry on meanwhile.
+    ///
+    class LockedLogin
+    {
+    public:
+        LockedLogin(ClientConnectionImpl *connection, const AccountName &accountName) :
+            m_connectionLock(connection->m_loginsMutex)
+        {
+            m_login = connection->FindLogin(accountName);
+            if (connection->m_loginPool) {
+                // Never the other way around, see RouteToLogin()
+                m_connectionLock.unlock();
+                if (m_login) {
+                    m_loginLock = std::unique_lock<std::recursive_mutex>(m_login->GetMutex());
+                }
+            }
+        }
+
+        explicit operator bool() const { return m_login != nullptr; }
+        SingleLoginMultiChannelManager *operator->() const { return m_login.get(); }
+        SingleLoginMultiChannelManager *get() const { return m_login.get(); }
+
+    private:
+        LockedLogin(const LockedLogin &); // disabled
+
+        std::unique_lock<std::recursive_mutex> m_connectionLock;
+        std::shared_ptr<SingleLoginMultiChannelManager> m_login;
+        std::unique_lock<std::recursive_mutex> m_loginLock;
+    };
+
+public:
     ClientConnectionImpl()
     {
+        m_positionFlushScheduled = false;
+        m_positionFlushStop = false;
+        m_loginExecutorThreads = 0;
+        m_rosterBatching = false;
+        m_usePoolAllocator = false;
+        m_snapshotGeneration = 0;
         ResetVariables();
+        ResetMessageDispatchStats();
     }
 
     virtual ~ClientConnectionImpl()
@@ -1952,6 +2606,9 @@ public:
 
         m_multiChannel = multiChannel;
         m_multiLogin = multiLogin;
+        if (m_multiLogin && m_loginExecutorThreads > 0) {
+            m_loginPool.reset(new WorkStealingPool((size_t)m_loginExecutorThreads));
+        }
 
         vx_sdk_config_t config;
         int retval = vx_get_default_config3(&config, sizeof(config));
@@ -1975,6 +2632,14 @@ public:
 
         config.allow_shared_capture_devices = 1;
 
+        if (m_usePoolAllocator) {
+            config.pf_calloc_func = &PoolAllocator::Calloc;
+            config.pf_free_aligned_func = &PoolAllocator::FreeAligned;
+            config.pf_free_func = &PoolAllocator::Free;
+            config.pf_malloc_aligned_func = &PoolAllocator::MallocAligned;
+            config.pf_malloc_func = &PoolAllocator::Malloc;
+            config.pf_realloc_func = &PoolAllocator::Realloc;
+        }
 #ifdef VX_TEST_MEM_ALLOCATORS
         if (overrideAllocators) {
             config.pf_calloc_func = pf_calloc_func;
@@ -2020,9 +2685,11 @@ public:
 #endif
 
         m_app = app;
+        ResetMessageDispatchStats();
         retval = vx_initialize3(&config, sizeof(config));
         if (retval != 0) {
             m_app = NULL;
+            m_loginPool.reset();
             return retval;
         }
 
@@ -2051,6 +2718,17 @@ public:
                 WaitForShutdownResponse();
                 sleepMicroseconds(30000);
             }
+            Stop3DPositionFlushThread();
+            // The messages still queued to the logins go back to the SDK before it goes away. The audio
+            // callbacks look at the pool under m_loginsMutex.
+            if (m_loginPool) {
+                m_loginPool->WaitIdle();
+                std::unique_ptr<WorkStealingPool> loginPool;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
+                    loginPool.swap(m_loginPool);
+                }
+            }
             vx_uninitialize();
             m_app = NULL;
         }
@@ -2145,25 +2823,51 @@ public:
     {
         return m_audioInputDeviceTestHasAudioToPlayback;
     }
-    VCSStatus Connect(const Uri &server)
+    VCSStatus SetLoginExecutorThreads(int threadCount)
     {
-        CHECK_RET1(server.IsValid(), VX_E_INVALID_ARGUMENT);
-
-        m_desiredServer = server;
-        m_desiredState = ConnectorStateInitialized;
-        NextState();
+        CHECK_RET1(threadCount >= 0, VX_E_INVALID_ARGUMENT);
+        if (m_app != NULL) {
+            return VX_E_ALREADY_INITIALIZED;
+        }
+        m_loginExecutorThreads = threadCount;
         return 0;
     }
-
-    void Disconnect(const Uri &server)
+    VCSStatus SetRosterBatching(bool batching)
     {
-        if (m_desiredState != ConnectorStateUninitialized) {
-            std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-            CHECK_RET(m_desiredServer == server);
-            // the act of disconnecting should clear all login information
-            ClearLoginsMap();
-            m_desiredServer.Clear();
-            m_desiredState = ConnectorStateUninitialized;
+        if (m_app != NULL) {
+            return VX_E_ALREADY_INITIALIZED;
+        }
+        m_rosterBatching = batching;
+        return 0;
+    }
+    VCSStatus SetPoolAllocator(bool usePool)
+    {
+        if (m_app != NULL) {
+            return VX_E_ALREADY_INITIALIZED;
+        }
+        m_usePoolAllocator = usePool;
+        return 0;
+    }
+
+    VCSStatus Connect(const Uri &server)
+    {
+        CHECK_RET1(server.IsValid(), VX_E_INVALID_ARGUMENT);
+
+        m_desiredServer = server;
+        m_desiredState = ConnectorStateInitialized;
+        NextState();
+        return 0;
+    }
+
+    void Disconnect(const Uri &server)
+    {
+        if (m_desiredState != ConnectorStateUninitialized) {
+            std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
+            CHECK_RET(m_desiredServer == server);
+            // the act of disconnecting should clear all login information
+            ClearLoginsMap();
+            m_desiredServer.Clear();
+            m_desiredState = ConnectorStateUninitialized;
             NextState();
         }
     }
@@ -2175,7 +2879,7 @@ public:
         CHECK_RET1(accountName.IsValid(), VX_E_INVALID_ARGUMENT);
         CHECK_RET1(m_desiredServer.IsValid(), VX_E_FAILED);
 
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
+        std::unique_lock<std::recursive_mutex> lock(m_loginsMutex);
         std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
         if (!s) {
             m_logins[accountName] = s = std::make_shared<SingleLoginMultiChannelManager>(
@@ -2184,6 +2888,24 @@ public:
                     accountName,
                     m_multiChannel,
                     participantUpdateFrequency);
+            s->SetRosterBatching(m_rosterBatching);
+            if (m_loginPool) {
+                std::string loginKey = "L" + std::to_string(m_nextLoginKey++);
+                s->SetExecutor(std::make_shared<SerialExecutor>(m_loginPool.get()), loginKey);
+                m_loginsByKey[loginKey] = s;
+            }
+            PublishLoginSnapshotSlots();
+        }
+
+        if (m_loginPool) {
+            lock.unlock();
+            std::lock_guard<std::recursive_mutex> loginLock(s->GetMutex());
+            VCSStatus status = s->Login(accessToken);
+            CHECK_RET1(status == 0, status);
+            if (m_connected) {
+                s->NextState();
+            }
+            return 0;
         }
 
         if (m_multiLogin == false) {
@@ -2203,70 +2925,62 @@ public:
 
     VCSStatus Logout(const AccountName &accountName)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
-        if (s == NULL) {
+        LockedLogin s(this, accountName);
+        if (!s) {
             return 0;
         }
         s->Logout();
-        NextState();
-        return 0;
+        return NextState(s, 0);
     }
 
     VCSStatus JoinChannel(const AccountName &accountName, const Uri &channelUri, const char *channelAccessToken)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->JoinChannel(channelUri, channelAccessToken));
+            return NextState(s, s->JoinChannel(channelUri, channelAccessToken));
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus LeaveChannel(const AccountName &accountName, const Uri &channelUri)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->LeaveChannel(channelUri));
+            return NextState(s, s->LeaveChannel(channelUri));
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus LeaveAll(const AccountName &accountName)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->LeaveAll());
+            return NextState(s, s->LeaveAll());
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus BlockUsers(const AccountName &accountName, const std::set<Uri> &usersToBlock)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->BlockUsers(usersToBlock));
+            return NextState(s, s->BlockUsers(usersToBlock));
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus UnblockUsers(const AccountName &accountName, const std::set<Uri> &usersToUnblock)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->UnblockUsers(usersToUnblock));
+            return NextState(s, s->UnblockUsers(usersToUnblock));
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus CheckBlockedUser(const AccountName &accountName, const Uri &user)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
             return s->CheckBlockedUser(user);
         }
@@ -2290,8 +3004,7 @@ public:
 
     VCSStatus IssueGetStats(const AccountName &accountName, bool reset)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
             return s->IssueGetStats(reset);
         }
@@ -2300,42 +3013,37 @@ public:
 
     VCSStatus StartPlayFileIntoChannels(const AccountName &accountName, const char *filename)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->StartPlayFileIntoChannels(filename));
+            return NextState(s, s->StartPlayFileIntoChannels(filename));
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus StopPlayFileIntoChannels(const AccountName &accountName)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
             s->StopPlayFileIntoChannels();
-            NextState();
-            return 0;
+            return NextState(s, 0);
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus KickUser(const AccountName &accountName, const Uri &channelUri, const Uri &userUri, const char *accessToken)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->KickUser(channelUri, userUri, accessToken));
+            return NextState(s, s->KickUser(channelUri, userUri, accessToken));
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus MuteAll(const AccountName &accountName, const Uri &channelUri, bool set_muted,  const char *accessToken)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->MuteAll(channelUri, set_muted, accessToken));
+            return NextState(s, s->MuteAll(channelUri, set_muted, accessToken));
         }
         return VX_E_NO_EXIST;
     }
@@ -2544,10 +3252,16 @@ public:
 
     int GetChannelAudioOutputDeviceVolume(const AccountName &accountName, const Uri &channelUri)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
-        if (s) {
-            return NextState(s->GetChannelAudioOutputDeviceVolume(channelUri));
+        if (s_dispatchingConnection == this) {
+            LockedLogin s(this, accountName);
+            if (s) {
+                return NextState(s, s->GetChannelAudioOutputDeviceVolume(channelUri));
+            }
+            return 50;     /// default value
+        }
+        std::shared_ptr<const ChannelSnapshot> c = GetChannelSnapshot(accountName, channelUri);
+        if (c) {
+            return c->volume;
         }
         return 50;     /// default value
     }
@@ -2555,20 +3269,28 @@ public:
     VCSStatus SetChannelAudioOutputDeviceVolume(const AccountName &accountName, const Uri &channelUri, int volume)
     {
         CHECK_RET1(volume >= VIVOX_MIN_VOL && volume <= VIVOX_MAX_VOL, VX_E_INVALID_ARGUMENT);
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->SetChannelAudioOutputDeviceVolume(channelUri, volume));
+            return NextState(s, s->SetChannelAudioOutputDeviceVolume(channelUri, volume));
         }
         return VX_E_NO_EXIST;
     }
 
     int GetParticipantAudioOutputDeviceVolumeForMe(const AccountName &accountName, const Uri &target, const Uri &channelUri)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
-        if (s) {
-            return NextState(s->GetParticipantAudioOutputDeviceVolumeForMe(target, channelUri));
+        if (s_dispatchingConnection == this) {
+            LockedLogin s(this, accountName);
+            if (s) {
+                return NextState(s, s->GetParticipantAudioOutputDeviceVolumeForMe(target, channelUri));
+            }
+            return 50;     /// default value
+        }
+        std::shared_ptr<const ChannelSnapshot> c = GetChannelSnapshot(accountName, channelUri);
+        if (c) {
+            std::map<Uri, ParticipantSnapshot>::const_iterator i = c->participants.find(target);
+            if (i != c->participants.end()) {
+                return i->second.volume;
+            }
         }
         return 50;     /// default value
     }
@@ -2576,30 +3298,38 @@ public:
     VCSStatus SetParticipantAudioOutputDeviceVolumeForMe(const AccountName &accountName, const Uri &target, const Uri &channelUri, int volume)
     {
         CHECK_RET1(volume >= VIVOX_MIN_VOL && volume <= VIVOX_MAX_VOL, VX_E_INVALID_ARGUMENT);
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->SetParticipantAudioOutputDeviceVolumeForMe(target, channelUri, volume));
+            return NextState(s, s->SetParticipantAudioOutputDeviceVolumeForMe(target, channelUri, volume));
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus SetParticipantMutedForAll(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted, const char *accessToken)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->SetParticipantMutedForAll(target, channelUri, muted, accessToken));
+            return NextState(s, s->SetParticipantMutedForAll(target, channelUri, muted, accessToken));
         }
         return VX_E_NO_EXIST;
     }
 
     bool GetParticipantMutedForAll(const AccountName &accountName, const Uri &targetUser, const Uri &channelUri)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
-        if (s) {
-            return s->GetParticipantMutedForAll(targetUser, channelUri);
+        if (s_dispatchingConnection == this) {
+            LockedLogin s(this, accountName);
+            if (s) {
+                return s->GetParticipantMutedForAll(targetUser, channelUri);
+            }
+            return false;
+        }
+        CHECK_RET1(channelUri.IsValid(), false);
+        std::shared_ptr<const ChannelSnapshot> c = GetChannelSnapshot(accountName, channelUri);
+        if (c) {
+            std::map<Uri, ParticipantSnapshot>::const_iterator i = c->participants.find(targetUser);
+            if (i != c->participants.end()) {
+                return i->second.mutedForAll;
+            }
         }
         return false;
     }
@@ -2607,70 +3337,102 @@ public:
 
     VCSStatus SetParticipantMutedForMe(const AccountName &accountName, const Uri &target, const Uri &channelUri, bool muted)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->SetParticipantMutedForMe(target, channelUri, muted));
+            return NextState(s, s->SetParticipantMutedForMe(target, channelUri, muted));
         }
         return VX_E_NO_EXIST;
     }
 
     ChannelTransmissionPolicy GetChannelTransmissionPolicy(const AccountName &accountName)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        if (s_dispatchingConnection == this) {
+            LockedLogin s(this, accountName);
+            if (s) {
+                return s->GetChannelTransmissionPolicy();
+            }
+            return ChannelTransmissionPolicy();     /// default value
+        }
+        std::shared_ptr<const LoginSnapshot> s = GetLoginSnapshot(accountName);
         if (s) {
-            return s->GetChannelTransmissionPolicy();
+            return s->transmissionPolicy;
         }
         return ChannelTransmissionPolicy();     /// default value
     }
 
+    unsigned long long GetStateGeneration() const
+    {
+        return m_snapshotGeneration.load(std::memory_order_acquire);
+    }
+
     VCSStatus SetTransmissionToSpecificChannel(const AccountName &accountName, const Uri &channelUri)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->SetTransmissionToSpecificChannel(channelUri));
+            return NextState(s, s->SetTransmissionToSpecificChannel(channelUri));
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus Set3DPosition(const AccountName &accountName, const Uri &channelUri, double x, double y, double z, double at_x, double at_y, double at_z)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
+        if (s) {
+            return NextState(s, s->Set3DPosition(channelUri, x, y, z, at_x, at_y, at_z));
+        }
+        return VX_E_NO_EXIST;
+    }
+
+    PositionUpdatePolicy Get3DPositionUpdatePolicy(const AccountName &accountName)
+    {
+        LockedLogin s(this, accountName);
+        if (s) {
+            return s->Get3DPositionUpdatePolicy();
+        }
+        return PositionUpdatePolicy();     /// default value
+    }
+
+    VCSStatus Set3DPositionUpdatePolicy(const AccountName &accountName, const PositionUpdatePolicy &policy)
+    {
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->Set3DPosition(channelUri, x, y, z, at_x, at_y, at_z));
+            return NextState(s, s->Set3DPositionUpdatePolicy(policy));
+        }
+        return VX_E_NO_EXIST;
+    }
+
+    VCSStatus Get3DPositionUpdateStats(const AccountName &accountName, const Uri &channelUri, PositionUpdateStats &stats, bool reset)
+    {
+        LockedLogin s(this, accountName);
+        if (s) {
+            return s->Get3DPositionUpdateStats(channelUri, stats, reset);
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus SetTransmissionToAll(const AccountName &accountName)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->SetTransmissionToAll());
+            return NextState(s, s->SetTransmissionToAll());
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus SetTransmissionToNone(const AccountName &accountName)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->SetTransmissionToNone());
+            return NextState(s, s->SetTransmissionToNone());
         }
         return VX_E_NO_EXIST;
     }
 
     VCSStatus SetSttTranscriptionOn(const AccountName &accountName, const Uri &channel, bool on, const char *accessToken)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> s = FindLogin(accountName);
+        LockedLogin s(this, accountName);
         if (s) {
-            return NextState(s->SetSttTranscriptionOn(channel, on, accessToken));
+            return NextState(s, s->SetSttTranscriptionOn(channel, on, accessToken));
         }
         return VX_E_NO_EXIST;
     }
@@ -2682,6 +3444,21 @@ private:
         return status;
     }
 
+    // After a call for one login. With login executors it only moves that login on: the rest of the connection
+    // belongs to the UI thread, and the call may come from the executor of any login.
+    VCSStatus NextState(LockedLogin &login, VCSStatus status)
+    {
+        if (m_loginPool) {
+            if (m_connected) {
+                login->NextState();
+                Schedule3DPositionFlush(login.get());
+            }
+        } else {
+            NextState();
+        }
+        return status;
+    }
+
     void NextState()
     {
         // if we are where we want to be don't do anything
@@ -2718,10 +3495,25 @@ private:
             }
         }
         // if we are connected to the right backend...
-        if (m_desiredState == ConnectorStateInitialized && m_currentState == ConnectorStateInitialized && m_desiredServer == m_currentServer) {
+        bool connected = m_desiredState == ConnectorStateInitialized && m_currentState == ConnectorStateInitialized && m_desiredServer == m_currentServer;
+        bool wasConnected = m_connected.exchange(connected);
+        if (connected && m_loginPool) {
+            // The logins move themselves on from there, on their executors
+            if (!wasConnected) {
+                std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
+                for (std::map<AccountName, std::shared_ptr<SingleLoginMultiChannelManager> >::const_iterator i = m_logins.begin(); i != m_logins.end(); ++i) {
+                    std::shared_ptr<SingleLoginMultiChannelManager> login = i->second;
+                    login->GetExecutor()->Post([login] {
+                        std::lock_guard<std::recursive_mutex> lock(login->GetMutex());
+                        login->NextState();
+                    });
+                }
+            }
+        } else if (connected) {
             std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
             for (std::map<AccountName, std::shared_ptr<SingleLoginMultiChannelManager> >::const_iterator i = m_logins.begin(); i != m_logins.end(); ++i) {
                 i->second->NextState();
+                Schedule3DPositionFlush(i->second.get());
             }
         }
         // audio device and master volume states
@@ -2788,7 +3580,9 @@ private:
                         m_connectorHandle,
                         name,
                         m_multiChannel);
+                s->SetRosterBatching(m_rosterBatching);
                 m_logins[name] = s;
+                PublishLoginSnapshotSlots();
                 return s;
             } else {
                 return nullptr;
@@ -2800,6 +3594,82 @@ private:
     void ClearLoginsMap()
     {
         m_logins.clear();
+        m_loginsByKey.clear();
+        PublishLoginSnapshotSlots();
+    }
+
+    typedef std::map<AccountName, std::shared_ptr<LoginSnapshotSlot> > LoginSnapshotSlots;
+
+    ///
+    /// Publishes the slots of the logins for the getters, after a login is added or removed. Under m_loginsMutex.
+    ///
+    void PublishLoginSnapshotSlots()
+    {
+        std::shared_ptr<LoginSnapshotSlots> slots = std::make_shared<LoginSnapshotSlots>();
+        for (std::map<AccountName, std::shared_ptr<SingleLoginMultiChannelManager> >::const_iterator i = m_logins.begin(); i != m_logins.end(); ++i) {
+            slots->emplace_hint(slots->end(), i->first, i->second->GetSnapshotSlot());
+        }
+        std::atomic_store(&m_loginSnapshotSlots, std::shared_ptr<const LoginSnapshotSlots>(slots));
+        m_snapshotGeneration.fetch_add(1, std::memory_order_release);
+    }
+
+    ///
+    /// After a batch of responses and events: publishes what changed in the logins for the getters, then reports the
+    /// roster changes of the batch. With login executors, each login the batch was routed to does so on its executor,
+    /// after the messages.
+    ///
+    void EndDispatchBatch()
+    {
+        if (m_loginPool) {
+            for (size_t i = 0; i < m_routedLogins.size(); ++i) {
+                std::shared_ptr<SingleLoginMultiChannelManager> login = m_routedLogins[i];
+                login->GetExecutor()->Post([this, login] {
+                    std::lock_guard<std::recursive_mutex> lock(login->GetMutex());
+                    EndDispatchBatch(*login);
+                });
+            }
+            m_routedLogins.clear();
+            return;
+        }
+        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
+        for (std::map<AccountName, std::shared_ptr<SingleLoginMultiChannelManager> >::const_iterator i = m_logins.begin(); i != m_logins.end(); ++i) {
+            EndDispatchBatch(*i->second);
+        }
+    }
+
+    void EndDispatchBatch(SingleLoginMultiChannelManager &login)
+    {
+        if (login.PublishSnapshot()) {
+            m_snapshotGeneration.fetch_add(1, std::memory_order_release);
+        }
+        if (m_rosterBatching) {
+            DispatchingScope dispatching(this);
+            login.FlushRosterChanges();
+        }
+    }
+
+    std::shared_ptr<const LoginSnapshot> GetLoginSnapshot(const AccountName &accountName) const
+    {
+        std::shared_ptr<const LoginSnapshotSlots> slots = std::atomic_load(&m_loginSnapshotSlots);
+        if (slots) {
+            LoginSnapshotSlots::const_iterator i = slots->find(accountName);
+            if (i != slots->end()) {
+                return std::atomic_load(&i->second->snapshot);
+            }
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<const ChannelSnapshot> GetChannelSnapshot(const AccountName &accountName, const Uri &channelUri) const
+    {
+        std::shared_ptr<const LoginSnapshot> login = GetLoginSnapshot(accountName);
+        if (login) {
+            std::map<Uri, std::shared_ptr<const ChannelSnapshot> >::const_iterator i = login->channels.find(channelUri);
+            if (i != login->channels.end()) {
+                return i->second;
+            }
+        }
+        return nullptr;
     }
 
     std::shared_ptr<SingleLoginMultiChannelManager> FindLoginBySessionHandle(const char *sessionHandle) const
@@ -2879,7 +3749,16 @@ private:
     AccountName GetAccountName(const char *session_group_handle)
     {
         std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
-        std::shared_ptr<SingleLoginMultiChannelManager> l = FindLoginBySessionGroupHandle(session_group_handle);
+        std::shared_ptr<SingleLoginMultiChannelManager> l;
+        if (m_loginPool) {
+            // The session group handles are the logins' to change, on their executors
+            std::unordered_map<std::string, std::shared_ptr<SingleLoginMultiChannelManager> >::const_iterator i = m_loginsByKey.find(GetLoginKey(session_group_handle));
+            if (i != m_loginsByKey.end()) {
+                l = i->second;
+            }
+        } else {
+            l = FindLoginBySessionGroupHandle(session_group_handle);
+        }
         if (l == NULL) {
             return AccountName();
         }
@@ -2948,6 +3827,90 @@ private:
         pThis->OnResponseOrEventFromSdkUiThread();
     }
 
+    ///
+    /// Makes sure a 3D position of the login held back by the rate limit is sent once it is due, even if no call
+    /// or SDK event comes meanwhile. Called with the login locked, after it moved on.
+    ///
+    void Schedule3DPositionFlush(SingleLoginMultiChannelManager *login)
+    {
+        std::chrono::steady_clock::time_point due;
+        if (login == NULL || !login->GetNext3DPositionFlush(due)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_positionFlushMutex);
+        if (m_positionFlushStop || (m_positionFlushScheduled && m_positionFlushDue <= due)) {
+            return;
+        }
+        m_positionFlushDue = due;
+        m_positionFlushScheduled = true;
+        if (!m_positionFlushThread.joinable()) {
+            m_positionFlushThread = std::thread(&ClientConnectionImpl::PositionFlushThread, this);
+        } else {
+            m_positionFlushCondition.notify_one();
+        }
+    }
+
+    void PositionFlushThread()
+    {
+        std::unique_lock<std::mutex> lock(m_positionFlushMutex);
+        while (!m_positionFlushStop) {
+            if (!m_positionFlushScheduled) {
+                m_positionFlushCondition.wait(lock);
+            } else if (std::chrono::steady_clock::now() < m_positionFlushDue) {
+                m_positionFlushCondition.wait_until(lock, m_positionFlushDue);
+            } else {
+                m_positionFlushScheduled = false;
+                lock.unlock();
+                m_app->InvokeOnUIThread(&sOn3DPositionFlushDueUiThread, this);
+                lock.lock();
+            }
+        }
+    }
+
+    void Stop3DPositionFlushThread()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_positionFlushMutex);
+            m_positionFlushStop = true;
+            m_positionFlushCondition.notify_one();
+        }
+        if (m_positionFlushThread.joinable()) {
+            m_positionFlushThread.join();
+        }
+        m_positionFlushScheduled = false;
+        m_positionFlushStop = false;
+    }
+
+    static void sOn3DPositionFlushDueUiThread(void *callbackHandle)
+    {
+        ClientConnectionImpl *pThis = reinterpret_cast<ClientConnectionImpl *>(callbackHandle);
+        pThis->On3DPositionFlushDueUiThread();
+    }
+
+    void On3DPositionFlushDueUiThread()
+    {
+        if (m_app == NULL) {
+            return;
+        }
+        if (!m_loginPool) {
+            // Flushes the due positions and schedules the next ones
+            NextState();
+            return;
+        }
+        std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
+        if (!m_connected) {
+            return;
+        }
+        for (std::map<AccountName, std::shared_ptr<SingleLoginMultiChannelManager> >::const_iterator i = m_logins.begin(); i != m_logins.end(); ++i) {
+            std::shared_ptr<SingleLoginMultiChannelManager> login = i->second;
+            login->GetExecutor()->Post([this, login] {
+                std::lock_guard<std::recursive_mutex> lock(login->GetMutex());
+                login->NextState();
+                Schedule3DPositionFlush(login.get());
+            });
+        }
+    }
+
     void HandleResponse(vx_resp_connector_create *resp)
     {
         vx_req_connector_create_t *req = reinterpret_cast<vx_req_connector_create_t *>(resp->base.request);
@@ -3356,80 +4319,192 @@ private:
         CHECK_RET(resp->base.return_code != 1);
     }
 
+    ///
+    /// The messages of one type dispatched, and the time their handlers took. Counted on the UI thread, and on the
+    /// login executors for the messages routed to them.
+    ///
+    struct DispatchCounter {
+        std::atomic<unsigned long long> messages;
+        std::atomic<unsigned long long> nanoseconds;
+    };
+
+    ///
+    /// When a message type without a handler was last logged, and how many have not been since. UI thread only.
+    ///
+    struct UnhandledLog {
+        std::chrono::steady_clock::time_point logged;
+        unsigned long long suppressed;
+    };
+
+    typedef void (ClientConnectionImpl::*ResponseHandler)(vx_resp_base_t *resp);
+    typedef void (ClientConnectionImpl::*EventHandler)(vx_evt_base_t *evt);
+
+    template <typename T, void (ClientConnectionImpl::*Handler)(T *)>
+    void DispatchResponseAs(vx_resp_base_t *resp)
+    {
+        (this->*Handler)(reinterpret_cast<T *>(resp));
+    }
+
+    template <typename T, void (ClientConnectionImpl::*Handler)(T *)>
+    void DispatchEventAs(vx_evt_base_t *evt)
+    {
+        (this->*Handler)(reinterpret_cast<T *>(evt));
+    }
+
+    void IgnoreResponse(vx_resp_base_t *)
+    {
+    }
+
+    void IgnoreEvent(vx_evt_base_t *)
+    {
+    }
+
+    ///
+    /// The handler of each response and event type, NULL for the types this connection does not handle
+    ///
+    struct DispatchTable {
+        ResponseHandler responses[resp_max];
+        EventHandler events[evt_max];
+    };
+
+#define DISPATCH_RESPONSE(type, T) table.responses[type] = &ClientConnectionImpl::DispatchResponseAs<T, &ClientConnectionImpl::HandleResponse>
+#define IGNORE_RESPONSE(type) table.responses[type] = &ClientConnectionImpl::IgnoreResponse
+#define DISPATCH_EVENT(type, T) table.events[type] = &ClientConnectionImpl::DispatchEventAs<T, &ClientConnectionImpl::DispatchEvent>
+#define IGNORE_EVENT(type) table.events[type] = &ClientConnectionImpl::IgnoreEvent
+
+    static constexpr DispatchTable MakeDispatchTable()
+    {
+        DispatchTable table = {};
+        DISPATCH_RESPONSE(resp_connector_create, vx_resp_connector_create);
+        DISPATCH_RESPONSE(resp_connector_initiate_shutdown, vx_resp_connector_initiate_shutdown);
+        DISPATCH_RESPONSE(resp_account_anonymous_login, vx_resp_account_anonymous_login);
+        DISPATCH_RESPONSE(resp_account_logout, vx_resp_account_logout);
+        DISPATCH_RESPONSE(resp_channel_kick_user, vx_resp_channel_kick_user);
+        DISPATCH_RESPONSE(resp_sessiongroup_get_stats, vx_resp_sessiongroup_get_stats);
+        DISPATCH_RESPONSE(resp_sessiongroup_add_session, vx_resp_sessiongroup_add_session);
+        DISPATCH_RESPONSE(resp_sessiongroup_remove_session, vx_resp_sessiongroup_remove_session);
+        DISPATCH_RESPONSE(resp_sessiongroup_control_audio_injection, vx_resp_sessiongroup_control_audio_injection);
+        DISPATCH_RESPONSE(resp_account_control_communications, vx_resp_account_control_communications);
+        DISPATCH_RESPONSE(resp_aux_get_capture_devices, vx_resp_aux_get_capture_devices);
+        DISPATCH_RESPONSE(resp_aux_get_render_devices, vx_resp_aux_get_render_devices);
+        DISPATCH_RESPONSE(resp_aux_set_capture_device, vx_resp_aux_set_capture_device);
+        DISPATCH_RESPONSE(resp_aux_set_render_device, vx_resp_aux_set_render_device);
+        DISPATCH_RESPONSE(resp_aux_set_mic_level, vx_resp_aux_set_mic_level);
+        DISPATCH_RESPONSE(resp_aux_set_speaker_level, vx_resp_aux_set_speaker_level);
+        DISPATCH_RESPONSE(resp_session_set_local_speaker_volume, vx_resp_session_set_local_speaker_volume);
+        DISPATCH_RESPONSE(resp_session_set_local_render_volume, vx_resp_session_set_local_render_volume);
+        DISPATCH_RESPONSE(resp_session_set_participant_volume_for_me, vx_resp_session_set_participant_volume_for_me);
+        DISPATCH_RESPONSE(resp_channel_mute_user, vx_resp_channel_mute_user);
+        DISPATCH_RESPONSE(resp_channel_mute_all_users, vx_resp_channel_mute_all_users);
+        DISPATCH_RESPONSE(resp_session_set_participant_mute_for_me, vx_resp_session_set_participant_mute_for_me);
+        DISPATCH_RESPONSE(resp_sessiongroup_set_tx_session, vx_resp_sessiongroup_set_tx_session);
+        DISPATCH_RESPONSE(resp_sessiongroup_set_tx_all_sessions, vx_resp_sessiongroup_set_tx_all_sessions);
+        DISPATCH_RESPONSE(resp_sessiongroup_set_tx_no_session, vx_resp_sessiongroup_set_tx_no_session);
+        DISPATCH_RESPONSE(resp_aux_render_audio_start, vx_resp_aux_render_audio_start_t);
+        DISPATCH_RESPONSE(resp_aux_render_audio_stop, vx_resp_aux_render_audio_stop_t);
+        IGNORE_RESPONSE(resp_aux_start_buffer_capture);
+        IGNORE_RESPONSE(resp_aux_capture_audio_stop);
+        IGNORE_RESPONSE(resp_aux_play_audio_buffer);
+        IGNORE_RESPONSE(resp_connector_mute_local_mic);
+        IGNORE_RESPONSE(resp_connector_mute_local_speaker);
+        IGNORE_RESPONSE(resp_aux_notify_application_state_change);
+        IGNORE_RESPONSE(resp_session_transcription_control);
+
+        DISPATCH_EVENT(evt_account_login_state_change, vx_evt_account_login_state_change);
+        DISPATCH_EVENT(evt_media_stream_updated, vx_evt_media_stream_updated);
+        DISPATCH_EVENT(evt_participant_added, vx_evt_participant_added);
+        DISPATCH_EVENT(evt_participant_updated, vx_evt_participant_updated);
+        DISPATCH_EVENT(evt_participant_removed, vx_evt_participant_removed);
+        DISPATCH_EVENT(evt_media_completion, vx_evt_media_completion);
+        DISPATCH_EVENT(evt_audio_device_hot_swap, vx_evt_audio_device_hot_swap);
+        DISPATCH_EVENT(evt_sessiongroup_removed, vx_evt_sessiongroup_removed);
+        DISPATCH_EVENT(evt_transcribed_message, vx_evt_transcribed_message);
+        IGNORE_EVENT(evt_sessiongroup_added);
+        IGNORE_EVENT(evt_session_added);
+        IGNORE_EVENT(evt_session_removed);
+        return table;
+    }
+
+#undef DISPATCH_RESPONSE
+#undef IGNORE_RESPONSE
+#undef DISPATCH_EVENT
+#undef IGNORE_EVENT
+
+    static const DispatchTable &GetDispatchTable()
+    {
+        static constexpr DispatchTable table = MakeDispatchTable();
+        return table;
+    }
+
+    ///
+    /// The index of the counters of a message: its type, or resp_none / evt_none for types this build does not know
+    ///
+    static int GetDispatchIndex(vx_message_base_t *m)
+    {
+        if (m->type == msg_response) {
+            int type = reinterpret_cast<vx_resp_base_t *>(m)->type;
+            return type > resp_none && type < resp_max ? type : resp_none;
+        }
+        int type = reinterpret_cast<vx_evt_base_t *>(m)->type;
+        return type > evt_none && type < evt_max ? type : evt_none;
+    }
+
+    DispatchCounter &GetDispatchCounter(vx_message_base_t *m)
+    {
+        int index = GetDispatchIndex(m);
+        return m->type == msg_response ? m_responseCounters[index] : m_eventCounters[index];
+    }
+
+    static void CountDispatch(DispatchCounter &counter, std::chrono::steady_clock::time_point start)
+    {
+        counter.messages.fetch_add(1, std::memory_order_relaxed);
+        counter.nanoseconds.fetch_add((unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    }
+
+    ///
+    /// Logs a message this connection does not handle, the first one of its type and then at most once a minute,
+    /// with the number left out since. Returns false when it is left out.
+    ///
+    bool LogUnhandled(vx_message_base_t *m, UnhandledLog &log)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (log.logged != std::chrono::steady_clock::time_point() && now - log.logged < std::chrono::minutes(1)) {
+            ++log.suppressed;
+            return false;
+        }
+        char *xml = NULL;
+        if (m->type == msg_response) {
+            vx_response_to_xml(m, &xml);
+        } else {
+            vx_event_to_xml(m, &xml);
+        }
+        if (log.suppressed > 0) {
+            LOG_INFO("Unhandled %s (%llu more since last logged): %s\n", m->type == msg_response ? "response" : "event", log.suppressed, safe_str(xml));
+        } else {
+            LOG_INFO("Unhandled %s: %s\n", m->type == msg_response ? "response" : "event", safe_str(xml));
+        }
+        if (xml != NULL) {
+            vx_free(xml);
+        }
+        log.logged = now;
+        log.suppressed = 0;
+        return true;
+    }
+
     void DispatchResponse(vx_resp_base_t *resp)
     {
-        switch (resp->type) {
-            case resp_connector_create:
-                return HandleResponse(reinterpret_cast<vx_resp_connector_create *>(resp));
-            case resp_connector_initiate_shutdown:
-                return HandleResponse(reinterpret_cast<vx_resp_connector_initiate_shutdown *>(resp));
-            case resp_account_anonymous_login:
-                return HandleResponse(reinterpret_cast<vx_resp_account_anonymous_login *>(resp));
-            case resp_account_logout:
-                return HandleResponse(reinterpret_cast<vx_resp_account_logout *>(resp));
-            case resp_channel_kick_user:
-                return HandleResponse(reinterpret_cast<vx_resp_channel_kick_user *>(resp));
-            case resp_sessiongroup_get_stats:
-                return HandleResponse(reinterpret_cast<vx_resp_sessiongroup_get_stats *>(resp));
-            case resp_sessiongroup_add_session:
-                return HandleResponse(reinterpret_cast<vx_resp_sessiongroup_add_session *>(resp));
-            case resp_sessiongroup_remove_session:
-                return HandleResponse(reinterpret_cast<vx_resp_sessiongroup_remove_session *>(resp));
-            case resp_sessiongroup_control_audio_injection:
-                return HandleResponse(reinterpret_cast<vx_resp_sessiongroup_control_audio_injection *>(resp));
-            case resp_account_control_communications:
-                return HandleResponse(reinterpret_cast<vx_resp_account_control_communications *>(resp));
-            case resp_aux_get_capture_devices:
-                return HandleResponse(reinterpret_cast<vx_resp_aux_get_capture_devices *>(resp));
-            case resp_aux_get_render_devices:
-                return HandleResponse(reinterpret_cast<vx_resp_aux_get_render_devices *>(resp));
-            case resp_aux_set_capture_device:
-                return HandleResponse(reinterpret_cast<vx_resp_aux_set_capture_device *>(resp));
-            case resp_aux_set_render_device:
-                return HandleResponse(reinterpret_cast<vx_resp_aux_set_render_device *>(resp));
-            case resp_aux_set_mic_level:
-                return HandleResponse(reinterpret_cast<vx_resp_aux_set_mic_level *>(resp));
-            case resp_aux_set_speaker_level:
-                return HandleResponse(reinterpret_cast<vx_resp_aux_set_speaker_level *>(resp));
-            case resp_session_set_local_speaker_volume:
-                return HandleResponse(reinterpret_cast<vx_resp_session_set_local_speaker_volume *>(resp));
-            case resp_session_set_local_render_volume:
-                return HandleResponse(reinterpret_cast<vx_resp_session_set_local_render_volume *>(resp));
-            case resp_session_set_participant_volume_for_me:
-                return HandleResponse(reinterpret_cast<vx_resp_session_set_participant_volume_for_me *>(resp));
-            case resp_channel_mute_user:
-                return HandleResponse(reinterpret_cast<vx_resp_channel_mute_user *>(resp));
-            case resp_channel_mute_all_users:
-                return HandleResponse(reinterpret_cast<vx_resp_channel_mute_all_users *>(resp));
-            case resp_session_set_participant_mute_for_me:
-                return HandleResponse(reinterpret_cast<vx_resp_session_set_participant_mute_for_me *>(resp));
-            case resp_sessiongroup_set_tx_session:
-                return HandleResponse(reinterpret_cast<vx_resp_sessiongroup_set_tx_session *>(resp));
-            case resp_sessiongroup_set_tx_all_sessions:
-                return HandleResponse(reinterpret_cast<vx_resp_sessiongroup_set_tx_all_sessions *>(resp));
-            case resp_sessiongroup_set_tx_no_session:
-                return HandleResponse(reinterpret_cast<vx_resp_sessiongroup_set_tx_no_session *>(resp));
-            case resp_aux_render_audio_start:
-                return HandleResponse(reinterpret_cast<vx_resp_aux_render_audio_start_t *>(resp));
-            case resp_aux_render_audio_stop:
-                return HandleResponse(reinterpret_cast<vx_resp_aux_render_audio_stop_t *>(resp));
-            case resp_aux_start_buffer_capture:
-                return;
-            case resp_aux_capture_audio_stop:
-                return;
-            case resp_aux_play_audio_buffer:
-                return;
-            case resp_connector_mute_local_mic:
-                return;
-            case resp_connector_mute_local_speaker:
-                return;
-            case resp_aux_notify_application_state_change:
-                return;
-            case resp_session_transcription_control:
-                return;
-            default:
+        int index = GetDispatchIndex(&resp->message);
+        ResponseHandler handler = GetDispatchTable().responses[index];
+        if (handler == NULL) {
+            m_responseCounters[index].messages.fetch_add(1, std::memory_order_relaxed);
+            if (LogUnhandled(&resp->message, m_unhandledResponses[index])) {
                 CHECK_RET(resp == NULL);
+            }
+            return;
         }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        (this->*handler)(resp);
+        CountDispatch(m_responseCounters[index], start);
     }
 
     void DispatchEvent(vx_evt_account_login_state_change *evt)
@@ -3534,56 +4609,208 @@ private:
 
     void DispatchEvent(vx_evt_base_t *evt)
     {
-        switch (evt->type) {
-            case evt_account_login_state_change:
-                return DispatchEvent(reinterpret_cast<vx_evt_account_login_state_change *>(evt));
-            case evt_media_stream_updated:
-                return DispatchEvent(reinterpret_cast<vx_evt_media_stream_updated *>(evt));
-            case evt_participant_added:
-                return DispatchEvent(reinterpret_cast<vx_evt_participant_added *>(evt));
-            case evt_participant_updated:
-                return DispatchEvent(reinterpret_cast<vx_evt_participant_updated *>(evt));
-            case evt_participant_removed:
-                return DispatchEvent(reinterpret_cast<vx_evt_participant_removed *>(evt));
-            case evt_media_completion:
-                return DispatchEvent(reinterpret_cast<vx_evt_media_completion *>(evt));
-            case evt_audio_device_hot_swap:
-                return DispatchEvent(reinterpret_cast<vx_evt_audio_device_hot_swap *>(evt));
-            case evt_sessiongroup_added:
-                return;
-            case evt_sessiongroup_removed:
-                return DispatchEvent(reinterpret_cast<vx_evt_sessiongroup_removed *>(evt));
-            case evt_session_added:
-                return;
-            case evt_session_removed:
-                return;
-            case evt_transcribed_message:
-                return DispatchEvent(reinterpret_cast<vx_evt_transcribed_message *>(evt));
-            default:
-            {
-                CHECK_RET(evt != NULL);
-                char *xml = NULL;
-                vx_event_to_xml(evt, &xml);
-                LOG_INFO("Unhandled event: %s\n", xml);
-            }
+        int index = GetDispatchIndex(&evt->message);
+        EventHandler handler = GetDispatchTable().events[index];
+        if (handler == NULL) {
+            m_eventCounters[index].messages.fetch_add(1, std::memory_order_relaxed);
+            LogUnhandled(&evt->message, m_unhandledEvents[index]);
+            return;
         }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        (this->*handler)(evt);
+        CountDispatch(m_eventCounters[index], start);
     }
 
     void OnResponseOrEventFromSdkUiThread()
     {
+        bool dispatched = false;
         for (;;) {
             vx_message_base_t *m = NULL;
             vx_get_message(&m);
             if (m == 0) {
                 break;
             }
-            if (m->type == msg_response) {
-                DispatchResponse(reinterpret_cast<vx_resp_base_t *>(m));
-            } else {
-                DispatchEvent(reinterpret_cast<vx_evt_base_t *>(m));
+            s_messageLog.RecordMessage(m);
+            dispatched = true;
+            if (m_loginPool && RouteToLogin(m, &DestroySdkMessage)) {
+                continue;
             }
+            DispatchResponseOrEvent(m);
             vx_destroy_message(m);
         }
+        if (dispatched) {
+            EndDispatchBatch();
+        }
+    }
+
+    static void DestroySdkMessage(vx_message_base_t *m)
+    {
+        vx_destroy_message(m);
+    }
+
+    ///
+    /// With login executors, hands a response or event of a login to the executor of that login, which destroys it
+    /// with destroy once handled. The login is found by the key its handles start with, without looking at the state
+    /// of any login. Returns false, leaving the message to the caller, for the messages of the connection itself.
+    ///
+    bool RouteToLogin(vx_message_base_t *m, void (*destroy)(vx_message_base_t *))
+    {
+        const char *handle = SingleLoginMultiChannelManager::GetLoginHandle(m);
+        if (handle == NULL) {
+            return false;
+        }
+        if (m->type == msg_response && reinterpret_cast<vx_resp_base_t *>(m)->type == resp_account_control_communications) {
+            m_clock = clock();
+        }
+        std::shared_ptr<SingleLoginMultiChannelManager> login;
+        {
+            // Only for the lookup: a login is never locked with m_loginsMutex held
+            std::lock_guard<std::recursive_mutex> lock(m_loginsMutex);
+            std::unordered_map<std::string, std::shared_ptr<SingleLoginMultiChannelManager> >::const_iterator i = m_loginsByKey.find(GetLoginKey(handle));
+            if (i != m_loginsByKey.end()) {
+                login = i->second;
+            }
+        }
+        if (!login) {
+            // Of a login cleared by Disconnect(), or of a log recorded without login executors
+            destroy(m);
+            return true;
+        }
+        login->GetExecutor()->Post([this, login, m, destroy] {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            {
+                DispatchingScope dispatching(this);
+                std::lock_guard<std::recursive_mutex> lock(login->GetMutex());
+                login->Dispatch(m);
+            }
+            CountDispatch(GetDispatchCounter(m), start);
+            destroy(m);
+        });
+        if (std::find(m_routedLogins.begin(), m_routedLogins.end(), login) == m_routedLogins.end()) {
+            m_routedLogins.push_back(login);
+        }
+        return true;
+    }
+
+    void DispatchResponseOrEvent(vx_message_base_t *m)
+    {
+        DispatchingScope dispatching(this);
+        if (m->type == msg_response) {
+            DispatchResponse(reinterpret_cast<vx_resp_base_t *>(m));
+        } else {
+            DispatchEvent(reinterpret_cast<vx_evt_base_t *>(m));
+        }
+    }
+
+public:
+    VCSStatus StartMessageLog(const char *path)
+    {
+        CHECK_RET1(path != NULL, VX_E_INVALID_ARGUMENT);
+        std::string error;
+        if (!s_messageLog.Open(path, error)) {
+            LOG_ERR("%s\n", error.c_str());
+            return VX_E_FILE_OPEN_FAILED;
+        }
+        return 0;
+    }
+
+    void StopMessageLog()
+    {
+        s_messageLog.Close();
+    }
+
+    VCSStatus ReplayMessageLog(const char *path, bool recordedSpeed, MessageLogReplayStats &stats)
+    {
+        CHECK_RET1(path != NULL, VX_E_INVALID_ARGUMENT);
+        stats = MessageLogReplayStats();
+        MessageLogReader reader;
+        std::string error;
+        if (!reader.Open(path, error)) {
+            LOG_ERR("%s\n", error.c_str());
+            return VX_E_FILE_OPEN_FAILED;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        MessageLogReader::Record record;
+        while (reader.Next(record)) {
+            if (record.kind == MessageLogReader::Record::kindMessage) {
+                if (recordedSpeed) {
+                    std::this_thread::sleep_until(start + std::chrono::microseconds((long long)(record.milliseconds * 1000)));
+                }
+                std::chrono::steady_clock::time_point dispatched = std::chrono::steady_clock::now();
+                bool routed = m_loginPool && RouteToLogin(record.message, &MessageLogDestroyMessage);
+                if (!routed) {
+                    DispatchResponseOrEvent(record.message);
+                }
+                if (recordedSpeed) {
+                    EndDispatchBatch();
+                }
+                stats.AddDispatchSeconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - dispatched).count());
+                stats.IncrementMessages();
+                if (routed) {
+                    continue;
+                }
+            }
+            MessageLogDestroyMessage(record.message);
+        }
+        EndDispatchBatch();
+        if (m_loginPool) {
+            // What the executors had left to handle counts as dispatching
+            std::chrono::steady_clock::time_point waited = std::chrono::steady_clock::now();
+            m_loginPool->WaitIdle();
+            stats.AddDispatchSeconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - waited).count());
+        }
+        stats.SetSkipped(reader.GetSkippedCount());
+        stats.SetElapsedSeconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if (!reader.GetError().empty()) {
+            LOG_ERR("%s: %s\n", path, reader.GetError().c_str());
+            return VX_E_FILE_CORRUPT;
+        }
+        return 0;
+    }
+
+    void GetMessageDispatchStats(std::vector<MessageDispatchStats> &stats, bool reset)
+    {
+        stats.clear();
+        const DispatchTable &table = GetDispatchTable();
+        for (int type = resp_none; type < resp_max; ++type) {
+            AddMessageDispatchStats(stats, m_responseCounters[type], reset, false, type, vx_get_response_type_string((vx_response_type)type), table.responses[type] != NULL);
+        }
+        for (int type = evt_none; type < evt_max; ++type) {
+            AddMessageDispatchStats(stats, m_eventCounters[type], reset, true, type, vx_get_event_type_string((vx_event_type)type), table.events[type] != NULL);
+        }
+        std::stable_sort(stats.begin(), stats.end(), [](const MessageDispatchStats &a, const MessageDispatchStats &b) {
+            return a.GetHandlerSeconds() > b.GetHandlerSeconds();
+        });
+    }
+
+private:
+    static void AddMessageDispatchStats(std::vector<MessageDispatchStats> &stats, DispatchCounter &counter, bool reset, bool event, int type, const char *typeName, bool handled)
+    {
+        unsigned long long messages = reset ? counter.messages.exchange(0, std::memory_order_relaxed) : counter.messages.load(std::memory_order_relaxed);
+        unsigned long long nanoseconds = reset ? counter.nanoseconds.exchange(0, std::memory_order_relaxed) : counter.nanoseconds.load(std::memory_order_relaxed);
+        if (messages == 0) {
+            return;
+        }
+        MessageDispatchStats entry;
+        entry.SetType(event, type, typeName);
+        entry.SetHandled(handled);
+        entry.SetMessages(messages);
+        entry.SetHandlerSeconds(nanoseconds / 1e9);
+        stats.push_back(entry);
+    }
+
+    void ResetMessageDispatchStats()
+    {
+        for (int type = resp_none; type < resp_max; ++type) {
+            m_responseCounters[type].messages = 0;
+            m_responseCounters[type].nanoseconds = 0;
+            m_unhandledResponses[type] = UnhandledLog();
+        }
+        for (int type = evt_none; type < evt_max; ++type) {
+            m_eventCounters[type].messages = 0;
+            m_eventCounters[type].nanoseconds = 0;
+            m_unhandledEvents[type] = UnhandledLog();
+        }
     }
 
 public:
@@ -3594,7 +4821,7 @@ public:
             vx_req_connector_mute_local_speaker_t *req;
             vx_req_connector_mute_local_speaker_create(&req);
             req->mute_level = value ? 1 : 0;
-            vx_issue_request2(&req->base);
+            issueRequest(&req->base);
         }
     }
 
@@ -3610,7 +4837,7 @@ public:
             vx_req_connector_mute_local_mic_t *req;
             vx_req_connector_mute_local_mic_create(&req);
             req->mute_level = value ? 1 : 0;
-            vx_issue_request2(&req->base);
+            issueRequest(&req->base);
         }
     }
 
@@ -3667,6 +4894,7 @@ private:
             if (m == 0) {
                 break;
             }
+            s_messageLog.RecordMessage(m);
             if (m->type == msg_response) {
                 vx_resp_base_t *r = reinterpret_cast<vx_resp_base_t *>(m);
                 if (r->type == resp_connector_initiate_shutdown) {
@@ -3692,6 +4920,26 @@ private:
     std::recursive_mutex m_loginsMutex;
     std::map<AccountName, std::shared_ptr<SingleLoginMultiChannelManager> > m_logins;
 
+    // Wakes up when the earliest 3D position held back by the rate limit is due, see Schedule3DPositionFlush()
+    std::mutex m_positionFlushMutex;
+    std::condition_variable m_positionFlushCondition;
+    std::thread m_positionFlushThread;
+    std::chrono::steady_clock::time_point m_positionFlushDue;
+    bool m_positionFlushScheduled;
+    bool m_positionFlushStop;
+    std::vector<std::shared_ptr<SingleLoginMultiChannelManager> > m_routedLogins;     // since the last EndDispatchBatch(), UI thread only
+    std::shared_ptr<const LoginSnapshotSlots> m_loginSnapshotSlots;     // through std::atomic_load() and std::atomic_store() only
+    std::atomic<unsigned long long> m_snapshotGeneration;
+
+    // Login executors, see SetLoginExecutorThreads(). The keys are those their handles start with.
+    int m_loginExecutorThreads;
+    std::unique_ptr<WorkStealingPool> m_loginPool;
+    bool m_rosterBatching;     // see SetRosterBatching()
+    bool m_usePoolAllocator;   // see SetPoolAllocator()
+    std::unordered_map<std::string, std::shared_ptr<SingleLoginMultiChannelManager> > m_loginsByKey;
+    unsigned int m_nextLoginKey;
+    std::atomic<bool> m_connected;
+
     bool m_multiChannel;
     bool m_multiLogin;
     IClientApiEventHandler::LogLevel m_loglevel;
@@ -3731,16 +4979,24 @@ private:
     std::atomic<clock_t> m_clock;
     std::atomic<unsigned int> m_codecMask;
 
+    DispatchCounter m_responseCounters[resp_max];
+    DispatchCounter m_eventCounters[evt_max];
+    UnhandledLog m_unhandledResponses[resp_max];
+    UnhandledLog m_unhandledEvents[evt_max];
+
 private:
     void ResetVariables()
     {
         // TODO: Clean up more variables.
 
         m_app = NULL;
+        m_routedLogins.clear();
         m_desiredState = ConnectorStateUninitialized;
         m_currentState = ConnectorStateUninitialized;
         m_multiChannel = false;
         m_multiLogin = false;
+        m_nextLoginKey = 0;
+        m_connected = false;
         m_audioInputDeviceListPopulated = false;
         m_audioOutputDeviceListPopulated = false;
         m_masterAudioInputDeviceVolume = 50;
@@ -4048,6 +5304,11 @@ ChannelTransmissionPolicy ClientConnection::GetChannelTransmissionPolicy(const A
     return m_pImpl->GetChannelTransmissionPolicy(accountName);
 }
 
+unsigned long long ClientConnection::GetStateGeneration() const
+{
+    return m_pImpl->GetStateGeneration();
+}
+
 VCSStatus ClientConnection::SetTransmissionToSpecificChannel(const AccountName &accountName, const Uri &channelUri)
 {
     return m_pImpl->SetTransmissionToSpecificChannel(accountName, channelUri);
@@ -4058,6 +5319,21 @@ VCSStatus ClientConnection::Set3DPosition(const AccountName &accountName, const
     return m_pImpl->Set3DPosition(accountName, channel, x, y, z, at_x, at_y, at_z);
 }
 
+PositionUpdatePolicy ClientConnection::Get3DPositionUpdatePolicy(const AccountName &accountName) const
+{
+    return m_pImpl->Get3DPositionUpdatePolicy(accountName);
+}
+
+VCSStatus ClientConnection::Set3DPositionUpdatePolicy(const AccountName &accountName, const PositionUpdatePolicy &policy)
+{
+    return m_pImpl->Set3DPositionUpdatePolicy(accountName, policy);
+}
+
+VCSStatus ClientConnection::Get3DPositionUpdateStats(const AccountName &accountName, const Uri &channel, PositionUpdateStats &stats, bool reset)
+{
+    return m_pImpl->Get3DPositionUpdateStats(accountName, channel, stats, reset);
+}
+
 VCSStatus ClientConnection::SetTransmissionToAll(const AccountName &accountName)
 {
     return m_pImpl->SetTransmissionToAll(accountName);
@@ -4157,4 +5433,39 @@ VCSStatus ClientConnection::SetSttTranscriptionOn(const AccountName &accountName
 {
     return m_pImpl->SetSttTranscriptionOn(accountName, channel, on, accessToken);
 }
+
+VCSStatus ClientConnection::StartMessageLog(const char *path)
+{
+    return m_pImpl->StartMessageLog(path);
+}
+
+void ClientConnection::StopMessageLog()
+{
+    m_pImpl->StopMessageLog();
+}
+
+VCSStatus ClientConnection::ReplayMessageLog(const char *path, bool recordedSpeed, MessageLogReplayStats &stats)
+{
+    return m_pImpl->ReplayMessageLog(path, recordedSpeed, stats);
+}
+
+void ClientConnection::GetMessageDispatchStats(std::vector<MessageDispatchStats> &stats, bool reset)
+{
+    m_pImpl->GetMessageDispatchStats(stats, reset);
+}
+
+VCSStatus ClientConnection::SetLoginExecutorThreads(int threadCount)
+{
+    return m_pImpl->SetLoginExecutorThreads(threadCount);
+}
+
+VCSStatus ClientConnection::SetRosterBatching(bool batching)
+{
+    return m_pImpl->SetRosterBatching(batching);
+}
+
+VCSStatus ClientConnection::SetPoolAllocator(bool usePool)
+{
+    return m_pImpl->SetPoolAllocator(usePool);
+}
 }
@@ -0,0 +1,191 @@
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+#include "vivoxclientapi/workstealingpool.h"
+
+namespace VivoxClientApi {
+// The pool and worker of the current thread, if it is a worker
+static thread_local const WorkStealingPool *s_currentPool = NULL;
+static thread_local size_t s_currentWorker = 0;
+
+// The executor whose task runs on the current thread
+static thread_local const SerialExecutor *s_currentExecutor = NULL;
+
+WorkStealingPool::WorkStealingPool(size_t threadCount) :
+    m_nextWorker(0),
+    m_queued(0),
+    m_unfinished(0),
+    m_sleepers(0),
+    m_stopping(false)
+{
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_workers.push_back(std::unique_ptr<Worker>(new Worker));
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_workers[i]->thread = std::thread(&WorkStealingPool::Run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i]->thread.join();
+    }
+}
+
+void WorkStealingPool::Post(Task task)
+{
+    size_t target;
+    if (s_currentPool == this) {
+        target = s_currentWorker;
+    } else {
+        target = m_nextWorker++ % m_workers.size();
+    }
+    m_unfinished++;
+    // A worker going to sleep counts itself before it looks at m_queued for the last time, so one of the two sees
+    // the other
+    m_queued++;
+    {
+        std::lock_guard<std::mutex> lock(m_workers[target]->mutex);
+        m_workers[target]->tasks.push_back(std::move(task));
+    }
+    if (m_sleepers.load() != 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wake.notify_one();
+    }
+}
+
+void WorkStealingPool::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_idle.wait(lock, [this] { return m_unfinished.load() == 0; });
+}
+
+bool WorkStealingPool::TryTake(size_t self, Task &task)
+{
+    {
+        Worker &worker = *m_workers[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < m_workers.size(); ++i) {
+        Worker &victim = *m_workers[(self + i) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::Finished()
+{
+    if (--m_unfinished == 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_idle.notify_all();
+    }
+}
+
+void WorkStealingPool::Run(size_t self)
+{
+    s_currentPool = this;
+    s_currentWorker = self;
+    for (;;) {
+        Task task;
+        if (TryTake(self, task)) {
+            task();
+            task = nullptr;
+            Finished();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepers++;
+        while (m_queued.load() == 0 && !m_stopping) {
+            m_wake.wait(lock);
+        }
+        m_sleepers--;
+        if (m_stopping && m_queued.load() == 0) {
+            break;
+        }
+    }
+    s_currentPool = NULL;
+}
+
+SerialExecutor::SerialExecutor(WorkStealingPool *pool) :
+    m_pool(pool),
+    m_scheduled(false)
+{
+}
+
+void SerialExecutor::Post(WorkStealingPool::Task task)
+{
+    bool schedule;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+        schedule = !m_scheduled;
+        m_scheduled = true;
+    }
+    if (schedule) {
+        std::shared_ptr<SerialExecutor> self = shared_from_this();
+        m_pool->Post([self] { self->Drain(); });
+    }
+}
+
+bool SerialExecutor::IsCurrent() const
+{
+    return s_currentExecutor == this;
+}
+
+void SerialExecutor::Drain()
+{
+    const int batch = 16;
+    const SerialExecutor *previous = s_currentExecutor;
+    s_currentExecutor = this;
+    for (int i = 0; i < batch; ++i) {
+        WorkStealingPool::Task task;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_tasks.empty()) {
+                m_scheduled = false;
+                s_currentExecutor = previous;
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+    s_currentExecutor = previous;
+    // Still more to do: back of the line, behind the executors that were waiting
+    std::shared_ptr<SerialExecutor> self = shared_from_this();
+    m_pool->Post([self] { self->Drain(); });
+}
+}
@@ -0,0 +1,104 @@
+#pragma once
+/* Copyright (c) 2014-2018 by Mercer Road Corp
+*
+* Permission to use, copy, modify or distribute this software in binary or source form
+* for any purpose is allowed only under explicit prior consent in writing from Mercer Road Corp
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND MERCER ROAD CORP DISCLAIMS
+* ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL MERCER ROAD CORP
+* BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+* DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+* PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+* ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+* SOFTWARE.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VivoxClientApi {
+///
+/// A fixed set of worker threads, each with a deque of tasks of its own.
+///
+/// A task posted from a worker goes to the deque of that worker, and one posted from any other thread to the deques in
+/// turn. A worker runs the tasks of its deque oldest first, and when it has none steals the newest task of another,
+/// so that a busy worker does not hold up work that an idle one could run.
+///
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    explicit WorkStealingPool(size_t threadCount);
+    ///
+    /// Runs the tasks already posted, then joins the threads
+    ///
+    ~WorkStealingPool();
+
+    void Post(Task task);
+    ///
+    /// Blocks until no task is queued or running. Not to be called from a task.
+    ///
+    void WaitIdle();
+    size_t GetThreadCount() const { return m_workers.size(); }
+
+private:
+    WorkStealingPool(const WorkStealingPool &); // disabled
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void Run(size_t self);
+    bool TryTake(size_t self, Task &task);
+    void Finished();
+
+    std::vector<std::unique_ptr<Worker> > m_workers;
+    std::atomic<size_t> m_nextWorker;
+    std::atomic<size_t> m_queued;       // posted and not taken
+    std::atomic<size_t> m_unfinished;   // posted and not run to the end
+    std::atomic<size_t> m_sleepers;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    bool m_stopping;
+};
+
+///
+/// Runs the tasks posted to it one at a time, in the order they were posted, on the threads of a WorkStealingPool.
+///
+/// It is on the pool only while it has tasks, and gives its thread up after a few of them, so a pool of a few threads
+/// serves any number of executors fairly.
+///
+class SerialExecutor :
+    public std::enable_shared_from_this<SerialExecutor>
+{
+public:
+    explicit SerialExecutor(WorkStealingPool *pool);
+
+    void Post(WorkStealingPool::Task task);
+    ///
+    /// True on the thread running a task of this executor
+    ///
+    bool IsCurrent() const;
+
+private:
+    SerialExecutor(const SerialExecutor &); // disabled
+
+    void Drain();
+
+    WorkStealingPool *m_pool;
+    std::mutex m_mutex;
+    std::deque<WorkStealingPool::Task> m_tasks;
+    bool m_scheduled;   // a Drain() is on the pool
+};
+}